@@ -52,10 +52,18 @@ float3 vEye : EYELOCATION;
 
 TextureCube ConvolutionSrc : CONVOLUTIONSRC;
 TextureCube LastResult : LASTRESULT;
+
+// Luminance distribution of ConvolutionSrc for environment importance sampling.
+Texture2D<float2> EnvironmentConditional;
+Texture2D<float2> EnvironmentMarginal;
+float EnvironmentSampling = 0;
 float4x4 ConvolutionViews[6] : CUBEVIEWS;
 float MaxLod : IBLSOURCEMIPCOUNT;
 float4 IBLCorrection : IBLCORRECTION;
 float ConvolutionSamplesOffset = 0;
+// Running average accumulation, the weight of this pass. The target blends
+// src * weight + dst * (1 - weight), so LastResult is not read. 0 for ping-pong.
+float ConvolutionBlendWeight = 0;
 float ConvolutionSampleCount = 0;
 float ConvolutionMaxSamples = 0;
 float ConvolutionRoughness = 0;
@@ -189,6 +197,84 @@ float3 rescaleHDR(float3 hdrPixel)
    return hdrPixel; 
 }
 
+//
+// Environment importance sampling.
+// The distribution is a lat-long luminance map of the source environment
+// built on the cpu (EnvironmentDistribution). u = phi / 2PI, v = theta / PI.
+//   EnvironmentConditional (width x height): joint pdf over [0,1]^2, cdf of u within the row.
+//   EnvironmentMarginal (height x 1): pdf of the row, cdf of v.
+// Samples from the brdf and the environment are combined with the balance heuristic.
+//
+float2 directionToLatLong(float3 L)
+{
+    float u = atan2(L.z, L.x) * (0.5 * INV_PI);
+    return float2(u < 0 ? u + 1 : u, acos(clamp(L.y, -1, 1)) * INV_PI);
+}
+
+float3 latLongToDirection(float2 uv)
+{
+    float phi = uv.x * 2 * PI;
+    float theta = uv.y * PI;
+    float sinTheta = sin(theta);
+    return float3(sinTheta * cos(phi), cos(theta), sinTheta * sin(phi));
+}
+
+// Solid angle pdf of sampling L from the environment.
+float environmentPdf(float3 L)
+{
+    uint width, height;
+    EnvironmentConditional.GetDimensions(width, height);
+
+    float2 uv = directionToLatLong(L);
+    uint2 texel = min(uint2(uv * float2(width, height)), uint2(width - 1, height - 1));
+    float sinTheta = sqrt(max(1 - L.y * L.y, 0));
+    return sinTheta > 1e-4 ? EnvironmentConditional.Load(int3(texel, 0)).x / (2 * PI * PI * sinTheta) : 0;
+}
+
+float3 sampleEnvironment(float2 Xi, out float pdf)
+{
+    uint width, height;
+    EnvironmentConditional.GetDimensions(width, height);
+
+    // Row, first marginal cdf entry above Xi.y.
+    uint lo = 0;
+    uint hi = height - 1;
+    [loop]
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) >> 1;
+        if (EnvironmentMarginal.Load(int3(mid, 0, 0)).y <= Xi.y)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    uint row = lo;
+    float rowEnd = EnvironmentMarginal.Load(int3(row, 0, 0)).y;
+    float rowStart = row > 0 ? EnvironmentMarginal.Load(int3(row - 1, 0, 0)).y : 0;
+    float v = (row + saturate((Xi.y - rowStart) / max(rowEnd - rowStart, 1e-8))) / height;
+
+    // Column, first conditional cdf entry of the row above Xi.x.
+    lo = 0;
+    hi = width - 1;
+    [loop]
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) >> 1;
+        if (EnvironmentConditional.Load(int3(mid, row, 0)).y <= Xi.x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    uint column = lo;
+    float2 conditional = EnvironmentConditional.Load(int3(column, row, 0));
+    float columnStart = column > 0 ? EnvironmentConditional.Load(int3(column - 1, row, 0)).y : 0;
+    float u = (column + saturate((Xi.x - columnStart) / max(conditional.y - columnStart, 1e-8))) / width;
+
+    float sinTheta = sin(v * PI);
+    pdf = sinTheta > 1e-4 ? conditional.x / (2 * PI * PI * sinTheta) : 0;
+    return latLongToDirection(float2(u, v));
+}
+
 float3 ImportanceSample (float3 N)
 {
     float3 V = N;
@@ -197,6 +283,11 @@ float3 ImportanceSample (float3 N)
     uint sampleId = ConvolutionSamplesOffset;
     uint cubeWidth, cubeHeight;
     ConvolutionSrc.GetDimensions(cubeWidth, cubeHeight);
+    float solidAngleTexel = 4 * PI / (6 * cubeWidth * cubeWidth);
+
+    // importanceSampleDiffuse is uniform over the hemisphere.
+    const float brdfPdf = 0.5 * INV_PI;
+    bool useEnvironment = EnvironmentSampling > 0;
 
     for(uint i = 0; i < ConvolutionSampleCount; i++ )
     {
@@ -212,12 +303,37 @@ float3 ImportanceSample (float3 N)
             // http://http.developer.nvidia.com/GPUGems3/gpugems3_ch20.html
             float pdf = max(0.0, dot(N, L) * INV_PI);
             
-            float solidAngleTexel = 4 * PI / (6 * cubeWidth * cubeWidth);
             float solidAngleSample = 1.0 / (ConvolutionSampleCount * pdf);
             float lod = 0.5 * log2((float)(solidAngleSample / solidAngleTexel));
 
             float3 diffuseSample = rescaleHDR(ConvolutionSrc.SampleLevel(EnvMapSampler, H, lod).rgb );
-            result = sumDiffuse(diffuseSample, NoL, result);
+            if (useEnvironment)
+            {
+                float weight = brdfPdf / (brdfPdf + environmentPdf(H));
+                result += float4(diffuseSample, 1) * weight;
+            }
+            else
+            {
+                result = sumDiffuse(diffuseSample, NoL, result);
+            }
+        }
+
+        if (useEnvironment)
+        {
+            // One environment sample per brdf sample over the same domain,
+            // the sample direction is accepted where H would have been.
+            float envPdf;
+            H = sampleEnvironment(Xi, envPdf);
+            L = 2 * dot( V, H ) * H - V;
+            if (dot(N, H) > 0 && dot(N, L) > 0 && envPdf > 0)
+            {
+                float solidAngleSample = 1.0 / (ConvolutionSampleCount * envPdf);
+                float lod = 0.5 * log2((float)(solidAngleSample / solidAngleTexel));
+
+                float3 diffuseSample = rescaleHDR(ConvolutionSrc.SampleLevel(EnvMapSampler, H, lod).rgb );
+                float weight = brdfPdf / (brdfPdf + envPdf);
+                result += float4(diffuseSample, 1) * weight;
+            }
         }
         sampleId += SampleStep;
    }
@@ -235,7 +351,11 @@ float4 PS_CubeMap( PS_CUBEMAP_IN input) : SV_Target
     // Sample source cubemap at specified mip.
     float3 importanceSampled = ImportanceSample(R);
 
-    if (ConvolutionSamplesOffset > 1e-6)
+    if (ConvolutionBlendWeight > 0)
+    {
+        sampledColor = float4(importanceSampled.xyz, ConvolutionBlendWeight);
+    }
+    else if (ConvolutionSamplesOffset > 1e-6)
     {
         float3 lastResult = LastResult.SampleLevel(EnvMapSampler, R, 0).rgb;
         sampledColor.rgb = lerp(lastResult.xyz, importanceSampled.xyz, 1.0 / (ConvolutionSamplesOffset+1));
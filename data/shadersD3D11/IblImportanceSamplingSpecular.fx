@@ -54,9 +54,17 @@ float4 IBLCorrection : IBLCORRECTION;
 TextureCube ConvolutionSrc : CONVOLUTIONSRC;
 TextureCube LastResult : LASTRESULT;
 
+// Luminance distribution of ConvolutionSrc for environment importance sampling.
+Texture2D<float2> EnvironmentConditional;
+Texture2D<float2> EnvironmentMarginal;
+float EnvironmentSampling = 0;
+
 float4x4 ConvolutionViews[6] : CUBEVIEWS; 
 
 float ConvolutionSamplesOffset = 0;
+// Running average accumulation, the weight of this pass. The target blends
+// src * weight + dst * (1 - weight), so LastResult is not read. 0 for ping-pong.
+float ConvolutionBlendWeight = 0;
 float ConvolutionSampleCount = 0;
 float ConvolutionMaxSamples = 0;
 float ConvolutionRoughness = 0;
@@ -194,6 +202,93 @@ float3 rescaleHDR(float3 hdrPixel)
 }
 
 
+//
+// Environment importance sampling.
+// The distribution is a lat-long luminance map of the source environment
+// built on the cpu (EnvironmentDistribution). u = phi / 2PI, v = theta / PI.
+//   EnvironmentConditional (width x height): joint pdf over [0,1]^2, cdf of u within the row.
+//   EnvironmentMarginal (height x 1): pdf of the row, cdf of v.
+// Samples from the brdf and the environment are combined with the balance heuristic.
+//
+float2 directionToLatLong(float3 L)
+{
+    float u = atan2(L.z, L.x) * (0.5 * INV_PI);
+    return float2(u < 0 ? u + 1 : u, acos(clamp(L.y, -1, 1)) * INV_PI);
+}
+
+float3 latLongToDirection(float2 uv)
+{
+    float phi = uv.x * 2 * PI;
+    float theta = uv.y * PI;
+    float sinTheta = sin(theta);
+    return float3(sinTheta * cos(phi), cos(theta), sinTheta * sin(phi));
+}
+
+// Solid angle pdf of sampling L from the environment.
+float environmentPdf(float3 L)
+{
+    uint width, height;
+    EnvironmentConditional.GetDimensions(width, height);
+
+    float2 uv = directionToLatLong(L);
+    uint2 texel = min(uint2(uv * float2(width, height)), uint2(width - 1, height - 1));
+    float sinTheta = sqrt(max(1 - L.y * L.y, 0));
+    return sinTheta > 1e-4 ? EnvironmentConditional.Load(int3(texel, 0)).x / (2 * PI * PI * sinTheta) : 0;
+}
+
+float3 sampleEnvironment(float2 Xi, out float pdf)
+{
+    uint width, height;
+    EnvironmentConditional.GetDimensions(width, height);
+
+    // Row, first marginal cdf entry above Xi.y.
+    uint lo = 0;
+    uint hi = height - 1;
+    [loop]
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) >> 1;
+        if (EnvironmentMarginal.Load(int3(mid, 0, 0)).y <= Xi.y)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    uint row = lo;
+    float rowEnd = EnvironmentMarginal.Load(int3(row, 0, 0)).y;
+    float rowStart = row > 0 ? EnvironmentMarginal.Load(int3(row - 1, 0, 0)).y : 0;
+    float v = (row + saturate((Xi.y - rowStart) / max(rowEnd - rowStart, 1e-8))) / height;
+
+    // Column, first conditional cdf entry of the row above Xi.x.
+    lo = 0;
+    hi = width - 1;
+    [loop]
+    while (lo < hi)
+    {
+        uint mid = (lo + hi) >> 1;
+        if (EnvironmentConditional.Load(int3(mid, row, 0)).y <= Xi.x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    uint column = lo;
+    float2 conditional = EnvironmentConditional.Load(int3(column, row, 0));
+    float columnStart = column > 0 ? EnvironmentConditional.Load(int3(column - 1, row, 0)).y : 0;
+    float u = (column + saturate((Xi.x - columnStart) / max(conditional.y - columnStart, 1e-8))) / width;
+
+    float sinTheta = sin(v * PI);
+    pdf = sinTheta > 1e-4 ? conditional.x / (2 * PI * PI * sinTheta) : 0;
+    return latLongToDirection(float2(u, v));
+}
+
+// Pdf of a light direction for importanceSampleGGX with V = N.
+float ggxSamplePdf(float roughness, float NoH, float VoH)
+{
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float d = NoH * NoH * (a2 - 1) + 1;
+    return (a2 / (PI * d * d)) * NoH / (4 * VoH);
+}
+
 float3 ImportanceSample (float3 R )
 {
     float3 N = R;
@@ -205,6 +300,10 @@ float3 ImportanceSample (float3 R )
 
     uint cubeWidth, cubeHeight;
     ConvolutionSrc.GetDimensions(cubeWidth, cubeHeight);
+    float solidAngleTexel = 4 * PI / (6 * cubeWidth * cubeWidth);
+
+    // A mirror has a delta lobe, only the brdf can sample it.
+    bool useEnvironment = EnvironmentSampling > 0 && ConvolutionRoughness > 0;
 
     for(uint i = 0; i < ConvolutionSampleCount; i++ )
     {
@@ -225,13 +324,37 @@ float3 ImportanceSample (float3 R )
             //
             float Dh = specularD(ConvolutionRoughness, NoH);
             float pdf = Dh * NoH / (4*VoH);
-            float solidAngleTexel = 4 * PI / (6 * cubeWidth * cubeWidth);
             float solidAngleSample = 1.0 / (ConvolutionSampleCount * pdf);
             float lod = ConvolutionRoughness == 0 ? 0 : 0.5 * log2((float)(solidAngleSample/solidAngleTexel));
 
             float3 hdrPixel = rescaleHDR(ConvolutionSrc.SampleLevel(EnvMapSampler, L, lod).rgb);
+            if (useEnvironment)
+            {
+                float brdfPdf = ggxSamplePdf(ConvolutionRoughness, NoH, VoH);
+                NoL *= brdfPdf / (brdfPdf + environmentPdf(L));
+            }
             result = sumSpecular(hdrPixel, NoL, result);
         }
+
+        if (useEnvironment)
+        {
+            // One environment sample per brdf sample, weighted the same way.
+            float envPdf;
+            L = sampleEnvironment(Xi, envPdf);
+            H = normalize(V + L);
+            NoL = dot(N, L);
+            NoH = saturate(dot(N, H));
+            VoH = saturate(dot(V, H));
+            if (NoL > 0 && envPdf > 0 && VoH > 0)
+            {
+                float brdfPdf = ggxSamplePdf(ConvolutionRoughness, NoH, VoH);
+                float solidAngleSample = 1.0 / (ConvolutionSampleCount * envPdf);
+                float lod = 0.5 * log2((float)(solidAngleSample/solidAngleTexel));
+
+                float3 hdrPixel = rescaleHDR(ConvolutionSrc.SampleLevel(EnvMapSampler, L, lod).rgb);
+                result = sumSpecular(hdrPixel, NoL * brdfPdf / (brdfPdf + envPdf), result);
+            }
+        }
         sampleId += SampleStep;
    }
 
@@ -249,7 +372,11 @@ float4 PS_CubeMap( PS_CUBEMAP_IN input ) : SV_Target
     // Sample source cubemap at specified mip.
     float3 importanceSampled = ImportanceSample(R);
 
-    if (ConvolutionSamplesOffset >= 1)
+    if (ConvolutionBlendWeight > 0)
+    {
+        sampledColor = float4(importanceSampled.xyz, ConvolutionBlendWeight);
+    }
+    else if (ConvolutionSamplesOffset >= 1)
     {
         float3 lastResult = LastResult.SampleLevel(EnvMapSampler, R, ConvolutionMip).rgb;
         sampledColor.rgb = lerp(lastResult.xyz, importanceSampled.xyz, 1.0 / (ConvolutionSamplesOffset));
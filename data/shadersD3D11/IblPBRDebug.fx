@@ -59,6 +59,11 @@ float3x3 invert_3x3( float3x3 M )
 
 float4x4 worldMatrix : WORLD;
 float4x4 worldViewProjection : WORLDVIEWPROJECTION;
+
+// Quantized vertices (identity for float meshes).
+float4 vertexPositionScale : VERTEXPOSITIONSCALE = float4(1,1,1,1);
+float4 vertexPositionOffset : VERTEXPOSITIONOFFSET = float4(0,0,0,0);
+float vertexNormalEncoding : VERTEXNORMALENCODING = 0;
 float4x4 viewProjection : VIEWPROJECTION;
 float4 eyeLocation : EYELOCATION;
 float4 materialDiffuse : MATERIALDIFFUSE;
@@ -140,14 +145,25 @@ struct PixelShaderOut
     float4 output0: SV_TARGET0;
 };
 
+float3 decodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded.xy, 1.0 - abs(encoded.x) - abs(encoded.y));
+    if (direction.z < 0)
+    {
+        direction.xy = (1.0 - abs(direction.yx)) * (direction.xy >= 0 ? 1.0 : -1.0);
+    }
+    return normalize(direction);
+}
+
 VertexShaderOut vs (VertexShaderIn vertexShaderIn)
 {
     VertexShaderOut output;
-    output.position = mul(vertexShaderIn.position, worldViewProjection);
-    float3 position = vertexShaderIn.position.xyz;
+    float3 position = vertexShaderIn.position.xyz * vertexPositionScale.xyz + vertexPositionOffset.xyz;
+    output.position = mul(float4(position, 1), worldViewProjection);
     float2 texCoord = vertexShaderIn.uv;
 
-    float3 normal = normalize(mul(vertexShaderIn.normal, (float3x3)worldMatrix));    
+    float3 objectNormal = vertexNormalEncoding > 0 ? decodeOctahedral(vertexShaderIn.normal.xy) : vertexShaderIn.normal;
+    float3 normal = normalize(mul(objectNormal, (float3x3)worldMatrix));    
     float3 worldPos = mul(float4(position.xyz, 1), worldMatrix).xyz;    
     output.positionInWorld = worldPos;
     output.positionInWorldViewProj = mul( float4(worldPos,1), viewProjection);
@@ -56,9 +56,13 @@
 #include <CtrIBLRenderPass.h>
 #include <CtrPostEffectsMgr.h>
 #include <CtrIBLProbe.h>
+#include <CtrIrradianceVolume.h>
+#include <CtrProbePackage.h>
+#include <CtrCubemapSeamFixup.h>
 #include <CtrTitles.h>
 #include <CtrBrdf.h>
 #include <CtrImageWidget.h>
+#include <CtrProfiler.h>
 #include <Ctrimgui.h>
 #include <strstream>
 #include <Ctrimgui.h>
@@ -109,6 +113,12 @@ ImguiEnumVal DebugAOVEnum[] =
 };
 static const EnumTweakType DebugAOVType(&DebugAOVEnum[0], 9, "debugAOV");
 
+// Frames rendered after the last change so that follow on work
+// (gui hover state, camera damping handoff) reaches the screen.
+static const uint32_t RenderOnDemandSettleFrames = 3;
+// Upper bound on idle sleeps, DirectInput is polled at this rate.
+static const DWORD RenderOnDemandIdleWaitMs = 100;
+
 }
 
 IBLApplication::IBLApplication(ApplicationHandle instance) : 
@@ -123,6 +133,7 @@ IBLApplication::IBLApplication(ApplicationHandle instance) :
     _iblSphereEntity(nullptr),
     _scene(nullptr),
     _headless(false),
+    _compareAccumulation(false),
     _windowWidth (1280),
     _windowHeight(720),
     _windowed (true),
@@ -138,6 +149,10 @@ IBLApplication::IBLApplication(ApplicationHandle instance) :
     _specularIntensityProperty(new FloatProperty(this, "Specular Intensity")),
     _roughnessScaleProperty(new FloatProperty(this, "Roughness Scale")),
     _debugTermProperty(new IntProperty(this, "Debug Visualization", new TweakFlags(&DebugAOVType, "Material"))),
+    _renderOnDemandProperty(new BoolProperty(this, "Render On Demand")),
+    _propertyChangeCount(0),
+    _settleFrames(RenderOnDemandSettleFrames),
+    _environmentResidentMip(0),
     _defaultAsset("data\\meshes\\pistol\\pistol.obj"),
     _runTitles(false),
     _inputMode(EquirectangularInput)
@@ -147,7 +162,7 @@ IBLApplication::IBLApplication(ApplicationHandle instance) :
     _currentVisualizationSpaceProperty->set(-1);
     _specularIntensityProperty->set(1.0f);
     _roughnessScaleProperty->set(1.0f);
-
+    _renderOnDemandProperty->set(true);
 
 #ifdef _DEBUG
     assert (_instance);
@@ -173,9 +188,14 @@ IBLApplication::parseOptions(int argc, char* argv[])
         if (std::string("--help") == argv[argId])
         {
             LOG ("IBLBaker: Specular and Irradiance cubemap baking tool")
+            LOG ("  --compare-accumulation  Compare ping pong and running average probe accumulation")
 
             return false;
         }
+        else if (std::string("--compare-accumulation") == argv[argId])
+        {
+            _compareAccumulation = true;
+        }
     }
 
     return true;
@@ -229,6 +249,12 @@ IBLApplication::debugTermProperty()
     return _debugTermProperty;
 }
 
+BoolProperty*
+IBLApplication::renderOnDemandProperty()
+{
+    return _renderOnDemandProperty;
+}
+
 FloatProperty*
 IBLApplication::specularIntensityProperty()
 {
@@ -344,31 +370,96 @@ IBLApplication::run()
 {
     _timer.startTimer();
 
+    if (_compareAccumulation)
+    {
+        _scene->update();
+        bool matched = _iblRenderPass->compareAccumulationModes(_scene, _scene->probes()[0]);
+        LOG("Accumulation mode comparison " << (matched ? "passed" : "failed"));
+        return;
+    }
+
     // [MattD][Thermal] Turn on to save your gpu some needless processing.
     #define DO_NOT_FRY_GPU 1
     #if DO_NOT_FRY_GPU
         _timer.setLockFrameCounter(60);
     #endif
 
+    bool pumpedMessages = true;
     do
     {
         _timer.update();
         _inputMgr->update();
-        updateApplication();
+        if (frameRequired(pumpedMessages))
+        {
+            {
+                CTR_PROFILE_ZONE("Frame");
+                updateApplication();
+            }
+            Ctr::Profiler::endFrame();
+            _propertyChangeCount = Property::changeCount();
+        }
+        else
+        {
+            // Nothing changed, the swap chain still holds the last frame.
+            waitForEvents();
+        }
+    }
+    while (!purgeMessages(&pumpedMessages));
+}
 
+bool
+IBLApplication::frameRequired(bool pumpedMessages)
+{
+    if (!_renderOnDemandProperty->get())
+        return true;
+
+    bool dirty = pumpedMessages ||
+                 _inputMgr->input().inputState()->hasActivity() ||
+                 Property::changeCount() != _propertyChangeCount ||
+                 _device->shaderMgr()->hasPendingChanges() ||
+                 _device->textureMgr()->streaming() ||
+                 Ctr::Profiler::capturingTrace();
+
+    const std::vector<IBLProbe*>& probes = _scene->probes();
+    for (auto it = probes.begin(); !dirty && it != probes.end(); it++)
+    {
+        dirty = !(*it)->computed();
+    }
+
+    if (dirty)
+    {
+        _settleFrames = RenderOnDemandSettleFrames;
+        return true;
+    }
+    else if (_settleFrames > 0)
+    {
+        _settleFrames--;
+        return true;
     }
-    while (!purgeMessages());
+    return false;
+}
+
+void
+IBLApplication::waitForEvents() const
+{
+    MsgWaitForMultipleObjects(0, nullptr, FALSE, RenderOnDemandIdleWaitMs, QS_ALLINPUT);
 }
 
 bool 
-IBLApplication::purgeMessages() const
+IBLApplication::purgeMessages(bool* pumpedMessages) const
 {
+    if (pumpedMessages)
+        *pumpedMessages = false;
+
     MSG msg;
     while(PeekMessage (&msg, 0, 0, 0, PM_REMOVE))
     {
         if(msg.message == WM_QUIT)
             return true;
 
+        if (pumpedMessages)
+            *pumpedMessages = true;
+
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
@@ -409,6 +500,11 @@ IBLApplication::loadParameters()
             }
             
 
+            if (pugi::xml_attribute attribute = configNode.node().attribute("RenderOnDemand"))
+            {
+                _renderOnDemandProperty->set(atoi(attribute.value()) == 1);
+            }
+
             if (const char* xpathValue = configNode.node().attribute("IBLFormat").value())
             {
                 _hdrFormatProperty->set(atoi(xpathValue) == 16 ? PF_FLOAT16_RGBA : PF_FLOAT32_RGBA);
@@ -504,6 +600,10 @@ IBLApplication::saveParameters() const
         _itoa(_runTitles ? 1 : 0, buffer, 10);
         configNode.append_attribute("Titles").set_value(buffer);
 
+        memset(buffer, 0, sizeof(char) * 512);
+        _itoa(_renderOnDemandProperty->get() ? 1 : 0, buffer, 10);
+        configNode.append_attribute("RenderOnDemand").set_value(buffer);
+
         int format = _scene->probes()[0]->hdrPixelFormat() == PF_FLOAT16_RGBA ? 16 : 32;
         memset(buffer, 0, sizeof(char) * 512);
         _itoa(format, buffer, 10);
@@ -545,6 +645,16 @@ IBLApplication::updateApplication()
     float elapsedTime = (float)(_timer.elapsedTime());
     _cameraManager->update(elapsedTime, true, true);
     _device->update();
+
+    // Bake again as finer levels of a streamed environment arrive.
+    if (const ITexture* environment = _sphereEntity->mesh(0)->material()->albedoMap())
+    {
+        if (environment->residentMip() != _environmentResidentMip)
+        {
+            _environmentResidentMip = environment->residentMip();
+            _scene->probes()[0]->uncache();
+        }
+    }
     _scene->update();
     _renderHUD->update(elapsedTime);
 
@@ -595,10 +705,16 @@ IBLApplication::updateApplication()
     _device->postEffectsMgr()->render(camera);
 
     _device->bindFrameBuffer(_device->deviceFrameBuffer());
-    _renderHUD->render(camera);
+    {
+        CTR_PROFILE_ZONE("HUD::render");
+        _renderHUD->render(camera);
+    }
 
 	// Present to back buffre
-    _device->present();
+    {
+        CTR_PROFILE_ZONE("Present");
+        _device->present();
+    }
 }
 
 bool
@@ -607,8 +723,8 @@ IBLApplication::loadEnvironment(const std::string& filePathName)
     bool result = false; 
     if (AssetManager::fileExists(filePathName))
     {
-        // TODO: Reference counting.
-        _device->textureMgr()->recycle(_sphereEntity->mesh(0)->material()->albedoMap());
+        // The materials release the previous environment, the texture manager
+        // evicts it once it is unreferenced and over budget.
         _sphereEntity->mesh(0)->material()->setAlbedoMap(filePathName);
         _iblSphereEntity->mesh(0)->material()->setAlbedoMap(filePathName);
 
@@ -738,13 +854,99 @@ IBLApplication::saveImages(const std::string& filePathName, bool gameOnly)
             LOG ("Saving HDR specular to " << specularHDRPath);
             probe->specularCubeMap()->save(specularHDRPath, true, false);
 
-            return true;
+            std::string packagePath = pathName + fileNameBase + ".iblprobe";
+            LOG ("Saving probe package to " << packagePath);
+            return savePackage(packagePath, fileNameBase + "Brdf.dds");
         }
     }
 
     return false;
 }
 
+bool
+IBLApplication::savePackage(const std::string& filePathName,
+                            const std::string& brdfLutName) const
+{
+    Ctr::IBLProbe* probe = _scene->probes()[0];
+    if (!probe)
+        return false;
+
+    Ctr::ProbePackageMetadata metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.center[0] = probe->center().x;
+    metadata.center[1] = probe->center().y;
+    metadata.center[2] = probe->center().z;
+    metadata.mipDrop = probe->mipDrop();
+    memcpy(metadata.basis, &probe->basis()[0][0], sizeof(metadata.basis));
+    metadata.maxPixel[0] = probe->maxPixelR();
+    metadata.maxPixel[1] = probe->maxPixelG();
+    metadata.maxPixel[2] = probe->maxPixelB();
+    metadata.environmentScale = probe->environmentScale();
+    metadata.sourceResolution = probe->sourceResolutionProperty()->get();
+    metadata.sampleCount = probe->sampleCount();
+    strncpy(metadata.brdfLut, brdfLutName.c_str(), sizeof(metadata.brdfLut) - 1);
+
+    // L2 needs little resolution, project a level of about 32 texels a face.
+    const Ctr::ITexture* environment = probe->environmentCubeMap();
+    uint32_t shLevel = 0;
+    while ((environment->width() >> shLevel) > 32 && shLevel + 1 < environment->resource()->mipLevels())
+    {
+        shLevel++;
+    }
+    Ctr::TextureImagePtr shSource = environment->readImage(environment->format(), int32_t(shLevel));
+    if (!shSource || shSource->getWidth() == 0)
+    {
+        LOG ("Failed to read back the environment for SH projection");
+        return false;
+    }
+
+    Ctr::Vector3f sh[9];
+    Ctr::IrradianceVolume::projectCubemap(*shSource, 0, sh);
+    for (uint32_t coefficient = 0; coefficient < 9; coefficient++)
+    {
+        metadata.sh[coefficient][0] = sh[coefficient].x;
+        metadata.sh[coefficient][1] = sh[coefficient].y;
+        metadata.sh[coefficient][2] = sh[coefficient].z;
+    }
+
+    struct PackageMap
+    {
+        Ctr::ProbeMapType      type;
+        Ctr::ProbeMapRange     range;
+        const Ctr::ITexture*   texture;
+    };
+
+    const PackageMap maps[] = 
+    {
+        { Ctr::ProbeMapSpecular, Ctr::ProbeMapHDR, probe->specularCubeMap() },
+        { Ctr::ProbeMapDiffuse, Ctr::ProbeMapHDR, probe->diffuseCubeMap() },
+// As with the DDS export, the full float environment chain does not fit on 32bit.
+#if _64BIT
+        { Ctr::ProbeMapEnvironment, Ctr::ProbeMapHDR, probe->environmentCubeMap() },
+#endif
+        { Ctr::ProbeMapSpecular, Ctr::ProbeMapMDR, probe->specularCubeMapMDR() },
+        { Ctr::ProbeMapDiffuse, Ctr::ProbeMapMDR, probe->diffuseCubeMapMDR() },
+        { Ctr::ProbeMapEnvironment, Ctr::ProbeMapMDR, probe->environmentCubeMapMDR() }
+    };
+
+    Ctr::ProbePackageWriter writer;
+    writer.setMetadata(metadata);
+    for (size_t mapId = 0; mapId < sizeof(maps) / sizeof(maps[0]); mapId++)
+    {
+        Ctr::TextureImagePtr image = maps[mapId].texture->readImage(maps[mapId].texture->format());
+        if (!image || image->getWidth() == 0)
+        {
+            LOG ("Failed to read back map " << mapId << " for " << filePathName);
+            return false;
+        }
+        // Same seams as the DDS exports.
+        Ctr::CubemapSeamFixup::fixupForExport(image);
+        writer.addMap(maps[mapId].type, maps[mapId].range, image);
+    }
+
+    return writer.write(filePathName, true /* deflate levels that shrink */);
+}
+
 void
 IBLApplication::compute()
 {
@@ -833,7 +1035,8 @@ IBLApplication::loadAsset(Entity*& targetEntity,
         _scene->destroy(targetEntity);
     }
 
-    targetEntity = _scene->load(assetPathName, materialPathName);
+    // Assets are shaded by PBRDebug, which decodes quantized vertices.
+    targetEntity = _scene->load(assetPathName, materialPathName, true);
     //if (userAsset)
     { 
         const std::vector<Mesh*>& meshes = targetEntity->meshes();
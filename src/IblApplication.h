@@ -93,6 +93,9 @@ class IBLApplication : public Ctr::Application
 
     bool                       loadEnvironment(const std::string& filePathName);
     bool                       saveImages(const std::string& filePathName, bool gameOnly = false);
+    // Every map of the probe with its SH and metadata in one mappable file.
+    bool                       savePackage(const std::string& filePathName,
+                                           const std::string& brdfLutName) const;
 
     void                       loadAsset(Entity*& targetEntity,
                                          const std::string& assetPathName,
@@ -104,6 +107,7 @@ class IBLApplication : public Ctr::Application
     FloatProperty*             constantMetalnessProperty();
     IntProperty*               specularWorkflowProperty();
     IntProperty*               debugTermProperty();
+    BoolProperty*              renderOnDemandProperty();
     FloatProperty*             specularIntensityProperty();
     FloatProperty*             roughnessScaleProperty();
 
@@ -148,7 +152,12 @@ class IBLApplication : public Ctr::Application
 
   protected:
     void                       updateApplication();
-    bool                       purgeMessages() const;
+    bool                       purgeMessages(bool* pumpedMessages = nullptr) const;
+
+    // Render on demand: a frame is needed when input arrived, a
+    // property changed, a probe is refining or shaders are pending.
+    bool                       frameRequired(bool pumpedMessages);
+    void                       waitForEvents() const;
     void                       updateVisualizationType();
 
   private:
@@ -181,6 +190,9 @@ class IBLApplication : public Ctr::Application
     Entity*                    _iblSphereEntity;
 
     bool                       _headless;
+    // Set by --compare-accumulation, run checks the probe accumulation
+    // modes against each other and exits.
+    bool                       _compareAccumulation;
     uint32_t                   _windowWidth;
     uint32_t                   _windowHeight;
     bool                       _windowed;
@@ -197,6 +209,11 @@ class IBLApplication : public Ctr::Application
     FloatProperty*              _specularIntensityProperty;
     FloatProperty*              _roughnessScaleProperty;
     IntProperty*                _debugTermProperty;
+    BoolProperty*               _renderOnDemandProperty;
+
+    uint64_t                    _propertyChangeCount;
+    uint32_t                    _settleFrames;
+    uint32_t                    _environmentResidentMip;
 
     SourceInputMode             _inputMode;
 };
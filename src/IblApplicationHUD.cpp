@@ -54,6 +54,8 @@
 #include <CtrBrdf.h>
 #include <CtrTextureMgr.h>
 #include <Ctrimgui.h>
+#include <CtrProfiler.h>
+#include <CtrImageAllocator.h>
 #include <CommDlg.h>
 
 namespace Ctr
@@ -130,6 +132,8 @@ _showBrdf(true),
 _brdfEnabled(true),
 _showFiltering(true),
 _filteringEnabled(true),
+_showProfiling(false),
+_profilingEnabled(true),
 _scrollArea(0),
 _iblApplication(application)
 {
@@ -571,6 +575,16 @@ IBLApplicationHUD::render(const Ctr::Camera* camera)
             };
 
             imguiPropertiesSlider("Sample Count", &inputSamples[0], 2, 0.0f, 2048.0f, 1);
+            BoolProperty* environmentSampling = _scene->probes()[0]->environmentSamplingProperty();
+            if (imguiCheck("Environment Sampling", environmentSampling->get()))
+            {
+                environmentSampling->set(!environmentSampling->get());
+            }
+            BoolProperty* cpuCapture = _scene->probes()[0]->cpuCaptureProperty();
+            if (imguiCheck("CPU Capture", cpuCapture->get()))
+            {
+                cpuCapture->set(!cpuCapture->get());
+            }
             imguiPropertySlider("Mip Drop", _scene->probes()[0]->mipDropProperty(), 0.0f, _scene->probes()[0]->specularCubeMap()->resource()->mipLevels() - 1.0f, 1);
             imguiPropertySlider("Saturation", _scene->probes()[0]->iblSaturationProperty(), 0.0f, 1.0f, 0.05f);
             //imguiPropertySlider("Contrast", _scene->probes()[0]->iblContrastProperty(), 0.0f, 1.0f, 0.05f);
@@ -580,6 +594,7 @@ IBLApplicationHUD::render(const Ctr::Camera* camera)
             imguiPropertySlider("Max Pixel B", _scene->probes()[0]->maxPixelBProperty(), 0.0f, 1000.0f, 1.0f, false);
 
             imguiSelectionSliderForPixelFormatProperty("Environment Format", _scene->probes()[0]->hdrPixelFormatProperty());
+            imguiSelectionSliderForEnumProperty("Accumulation", _scene->probes()[0]->accumulationModeProperty());
             imguiSelectionSliderForEnumProperty("Source Resolution", _scene->probes()[0]->sourceResolutionProperty());
             imguiSelectionSliderForEnumProperty("Specular Resolution", _scene->probes()[0]->specularResolutionProperty());
             imguiSelectionSliderForEnumProperty("Diffuse Resolution", _scene->probes()[0]->diffuseResolutionProperty());
@@ -632,6 +647,66 @@ IBLApplicationHUD::render(const Ctr::Camera* camera)
             }
             imguiUnindent();
         }
+
+        imguiRegionBorder("Profiling:", NULL, _showProfiling, _profilingEnabled);
+        if (_showProfiling)
+        {
+            imguiIndent();
+            if (imguiCheck("Enable Zones", Ctr::Profiler::enabled()))
+            {
+                Ctr::Profiler::setEnabled(!Ctr::Profiler::enabled());
+            }
+            BoolProperty* renderOnDemand = _iblApplication->renderOnDemandProperty();
+            if (imguiCheck("Render On Demand", renderOnDemand->get()))
+            {
+                renderOnDemand->set(!renderOnDemand->get());
+            }
+            if (imguiButton("Capture Trace (60 frames)", !Ctr::Profiler::capturingTrace()))
+            {
+                Ctr::Profiler::captureTrace(60, "iblBakerTrace.json");
+            }
+
+            imguiLabel("Frame: %.2f ms", Ctr::Profiler::frameMilliseconds());
+            uint32_t hudDraws = 0;
+            uint32_t hudBatches = 0;
+            imguiBatchStatistics(hudDraws, hudBatches);
+            imguiLabel("HUD: %u draws in %u batches", hudDraws, hudBatches);
+            if (Ctr::Profiler::enabled())
+            {
+                const std::vector<Ctr::ProfileZoneStats>& zones = Ctr::Profiler::frameZones();
+                for (auto it = zones.begin(); it != zones.end(); it++)
+                {
+                    imguiLabel("%*s%s [%u] %.3f ms (%u)", it->depth * 2, "", it->name, it->threadId, it->milliseconds, it->calls);
+                }
+                if (uint32_t dropped = Ctr::Profiler::droppedEvents())
+                {
+                    imguiLabel("Dropped events: %u", dropped);
+                }
+            }
+
+            std::vector<Ctr::ImageAllocatorStats> allocatorStats;
+            Ctr::ImageAllocator::allStats(allocatorStats);
+            for (auto it = allocatorStats.begin(); it != allocatorStats.end(); it++)
+            {
+                imguiLabel("%s images: %.1f MB (peak %.1f, pooled %.1f)", it->name.c_str(),
+                           it->bytesInUse / (1024.0 * 1024.0),
+                           it->peakBytesInUse / (1024.0 * 1024.0),
+                           it->bytesPooled / (1024.0 * 1024.0));
+            }
+
+            const Ctr::ResidencyStatistics& residency = _deviceInterface->textureMgr()->statistics();
+            for (uint32_t categoryId = 0; categoryId < Ctr::ResidencyCategoryCount; categoryId++)
+            {
+                imguiLabel("%s: %u, %.1f MB (hits %u, misses %u, evicted %u)", 
+                           Ctr::TextureMgr::categoryName((Ctr::ResidencyCategory)categoryId),
+                           residency.count[categoryId],
+                           residency.bytes[categoryId] / (1024.0 * 1024.0),
+                           residency.hits[categoryId],
+                           residency.misses[categoryId],
+                           residency.evictions[categoryId]);
+            }
+            imguiUnindent();
+        }
         imguiEndScrollArea();
         imguiEndFrame();
     }
@@ -101,6 +101,8 @@ class IBLApplicationHUD : public RenderHUD
     bool                       _brdfEnabled;
     bool                       _showFiltering;
     bool                       _filteringEnabled;
+    bool                       _showProfiling;
+    bool                       _profilingEnabled;
 
     int32_t                    _scrollArea;
 };
@@ -40,6 +40,7 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrHash.h>
+#include <CtrHasher.h>
 #include <MurmurHash.h>
 
 namespace Ctr
@@ -53,6 +54,12 @@ Hash::Hash()
 {
     memset(&_hash[0], 0, Hash::HashSize);
 }
+Hash::Hash(uint64_t low, uint64_t high)
+{
+    _hash[0] = low;
+    _hash[1] = high;
+}
+
 Hash::Hash(const Hash& other)
 {
     memcpy(&_hash[0], &other._hash[0], Hash::HashSize);
@@ -116,9 +123,7 @@ Hash::build(const std::wstring& string)
 void
 Hash::append(const Hash& other)
 {
-    std::ostringstream stream;
-    stream << _hash[0] << "_" << _hash[1] << other._hash[0] << "_" << other._hash[1];
-    MurmurHash3_x64_128(stream.str().c_str(), (int32_t)(stream.str().length() * sizeof(uint8_t)), 0, &_hash[0]);
+    *this = Hasher().update(*this).update(other).hash();
 }
 
 }
\ No newline at end of file
@@ -51,6 +51,7 @@ class Hash
   public:
     Hash();
     Hash(const std::string&);
+    Hash(uint64_t low, uint64_t high);
     Hash(const Hash& other);
     ~Hash();
 
@@ -66,6 +67,8 @@ class Hash
     void                       append(const Hash& hash);
 
   private:
+    friend class Hasher;
+
     static const size_t HashSize = sizeof(uint64_t)* 2;
     uint64_t                   _hash[2];
 };
@@ -0,0 +1,287 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrHasher.h>
+#include <CtrMath.h>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace Ctr
+{
+namespace
+{
+const uint64_t Prime32_1 = 0x9e3779b1ULL;
+const uint64_t Prime32_2 = 0x85ebca77ULL;
+const uint64_t Prime32_3 = 0xc2b2ae3dULL;
+const uint64_t Prime64_1 = 0x9e3779b185ebca87ULL;
+const uint64_t Prime64_2 = 0xc2b2ae3d27d4eb4fULL;
+const uint64_t Prime64_3 = 0x165667b19e3779f9ULL;
+const uint64_t Prime64_4 = 0x85ebca77c2b2ae63ULL;
+const uint64_t Prime64_5 = 0x27d4eb2f165667c5ULL;
+
+// Key material (splitmix64 sequence). Stripe n of a block reads
+// words [n, n + 8), the last eight words drive the scramble.
+const uint64_t Secret[24] =
+{
+    0x2cb0f69f4abea221ULL, 0x9417034723148989ULL, 0xdd555950609dfe03ULL,
+    0xdbafb150deb12800ULL, 0x7e789b2e6c442cb6ULL, 0xf41e5636c7e4f8c4ULL,
+    0x0959d150f8fba7e4ULL, 0xa97316f13cdb9eeaULL, 0x74cd8258f9520068ULL,
+    0x55c74a62e116868bULL, 0xd2f4c799a2023cbdULL, 0xdf98cb79a37b51b9ULL,
+    0x396f5885524f3905ULL, 0xaf1d56386ca3b276ULL, 0xa9ffbe6b5104e85aULL,
+    0x6bd0c51b9fd533b3ULL, 0x980ce91c50ab4b56ULL, 0x28ac395780fe62c5ULL,
+    0x768912e3a6bcedc7ULL, 0x50b3e8c9332c7c88ULL, 0xce3bbfe520bd47daULL,
+    0xcba6c8e8e0bb7c4fULL, 0xbf194db8434a346dULL, 0x7d8f2a7b60416d7fULL
+};
+
+// Stripes per block before the accumulators are scrambled.
+const size_t StripesPerBlock = 16;
+
+inline uint64_t
+read64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(uint64_t));
+    return value;
+}
+
+inline uint64_t
+multiplyFold64(uint64_t a, uint64_t b)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high;
+    uint64_t low = _umul128(a, b, &high);
+    return low ^ high;
+#else
+    uint64_t aLow = a & 0xffffffff, aHigh = a >> 32;
+    uint64_t bLow = b & 0xffffffff, bHigh = b >> 32;
+    uint64_t lowLow = aLow * bLow;
+    uint64_t highLow = aHigh * bLow;
+    uint64_t lowHigh = aLow * bHigh;
+    uint64_t highHigh = aHigh * bHigh;
+    uint64_t cross = (lowLow >> 32) + (highLow & 0xffffffff) + lowHigh;
+    uint64_t high = (highLow >> 32) + (cross >> 32) + highHigh;
+    uint64_t low = (cross << 32) | (lowLow & 0xffffffff);
+    return low ^ high;
+#endif
+}
+
+inline uint64_t
+avalanche(uint64_t h)
+{
+    h ^= h >> 37;
+    h *= 0x165667919e3779f9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+inline uint64_t
+mergeLanes(const uint64_t* acc, const uint64_t* secret, uint64_t start)
+{
+    uint64_t result = start;
+    for (size_t lane = 0; lane < 8; lane += 2)
+    {
+        result += multiplyFold64(acc[lane] ^ secret[lane], acc[lane + 1] ^ secret[lane + 1]);
+    }
+    return avalanche(result);
+}
+}
+
+Hasher::Hasher()
+{
+    reset();
+}
+
+Hasher::~Hasher()
+{
+}
+
+void
+Hasher::reset()
+{
+    _acc[0] = Prime32_3;
+    _acc[1] = Prime64_1;
+    _acc[2] = Prime64_2;
+    _acc[3] = Prime64_3;
+    _acc[4] = Prime64_4;
+    _acc[5] = Prime32_2;
+    _acc[6] = Prime64_5;
+    _acc[7] = Prime32_1;
+    _buffered = 0;
+    _stripeId = 0;
+    _length = 0;
+}
+
+void
+Hasher::accumulate(uint64_t* acc, const uint8_t* stripe, size_t stripeId)
+{
+    const uint64_t* secret = &Secret[stripeId];
+#if CTR_SSE
+    for (size_t lane = 0; lane < 8; lane += 2)
+    {
+        __m128i data = _mm_loadu_si128((const __m128i*)(stripe + lane * sizeof(uint64_t)));
+        __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)(secret + lane)));
+        __m128i product = _mm_mul_epu32(key, _mm_shuffle_epi32(key, _MM_SHUFFLE(0, 3, 0, 1)));
+        __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        __m128i sum = _mm_add_epi64(_mm_loadu_si128((const __m128i*)(acc + lane)), swapped);
+        _mm_storeu_si128((__m128i*)(acc + lane), _mm_add_epi64(sum, product));
+    }
+#else
+    for (size_t lane = 0; lane < 8; lane++)
+    {
+        uint64_t data = read64(stripe + lane * sizeof(uint64_t));
+        uint64_t key = data ^ secret[lane];
+        acc[lane ^ 1] += data;
+        acc[lane] += (key & 0xffffffff) * (key >> 32);
+    }
+#endif
+}
+
+void
+Hasher::scramble(uint64_t* acc)
+{
+    const uint64_t* secret = &Secret[StripesPerBlock];
+#if CTR_SSE
+    const __m128i prime = _mm_set1_epi32((int32_t)Prime32_1);
+    for (size_t lane = 0; lane < 8; lane += 2)
+    {
+        __m128i value = _mm_loadu_si128((const __m128i*)(acc + lane));
+        value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+        value = _mm_xor_si128(value, _mm_loadu_si128((const __m128i*)(secret + lane)));
+        __m128i productLow = _mm_mul_epu32(value, prime);
+        __m128i productHigh = _mm_mul_epu32(_mm_shuffle_epi32(value, _MM_SHUFFLE(0, 3, 0, 1)), prime);
+        _mm_storeu_si128((__m128i*)(acc + lane), _mm_add_epi64(productLow, _mm_slli_epi64(productHigh, 32)));
+    }
+#else
+    for (size_t lane = 0; lane < 8; lane++)
+    {
+        uint64_t value = acc[lane];
+        value ^= value >> 47;
+        value ^= secret[lane];
+        acc[lane] = value * Prime32_1;
+    }
+#endif
+}
+
+Hasher&
+Hasher::update(const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)(data);
+    _length += size;
+
+    // Top up a partial stripe first.
+    if (_buffered > 0)
+    {
+        size_t count = minValue(size, StripeSize - _buffered);
+        memcpy(&_buffer[_buffered], bytes, count);
+        _buffered += count;
+        bytes += count;
+        size -= count;
+        if (_buffered < StripeSize)
+            return *this;
+        accumulate(_acc, _buffer, _stripeId);
+        _buffered = 0;
+        if (++_stripeId == StripesPerBlock)
+        {
+            scramble(_acc);
+            _stripeId = 0;
+        }
+    }
+
+    // Whole stripes straight from the source.
+    for (; size >= StripeSize; bytes += StripeSize, size -= StripeSize)
+    {
+        accumulate(_acc, bytes, _stripeId);
+        if (++_stripeId == StripesPerBlock)
+        {
+            scramble(_acc);
+            _stripeId = 0;
+        }
+    }
+
+    if (size > 0)
+    {
+        memcpy(_buffer, bytes, size);
+        _buffered = size;
+    }
+    return *this;
+}
+
+Hasher&
+Hasher::update(const std::string& string)
+{
+    return update(string.c_str(), string.length());
+}
+
+Hasher&
+Hasher::update(const std::wstring& string)
+{
+    return update(string.c_str(), string.length() * sizeof(wchar_t));
+}
+
+Hasher&
+Hasher::update(const Hash& hash)
+{
+    return update(&hash._hash[0], Hash::HashSize);
+}
+
+Hash
+Hasher::hash() const
+{
+    uint64_t acc[8];
+    memcpy(acc, _acc, sizeof(acc));
+
+    // Zero padded tail, the length folded in below keeps
+    // "a" and "a\0" apart.
+    if (_buffered > 0)
+    {
+        uint8_t stripe[StripeSize];
+        memcpy(stripe, _buffer, _buffered);
+        memset(&stripe[_buffered], 0, StripeSize - _buffered);
+        accumulate(acc, stripe, _stripeId);
+    }
+
+    uint64_t low = mergeLanes(acc, &Secret[1], _length * Prime64_1);
+    uint64_t high = mergeLanes(acc, &Secret[12], ~(_length * Prime64_2));
+    return Hash(low, high);
+}
+
+}
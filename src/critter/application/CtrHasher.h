@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_HASHER
+#define INCLUDED_CRT_HASHER
+
+#include <CtrPlatform.h>
+#include <CtrHash.h>
+#include <type_traits>
+
+namespace Ctr
+{
+//------------------------------------------------------------------
+// Incremental 128 bit hasher. Input is consumed in 64 byte stripes
+// over eight independent 64 bit lanes (32x32->64 multiply and add),
+// so the inner loop maps directly onto SSE2. Feeding the same bytes
+// in any split produces the same Hash.
+//------------------------------------------------------------------
+class Hasher
+{
+  public:
+    Hasher();
+    ~Hasher();
+
+    void                       reset();
+
+    Hasher&                    update(const void* data, size_t size);
+    Hasher&                    update(const std::string& string);
+    Hasher&                    update(const std::wstring& string);
+    Hasher&                    update(const Hash& hash);
+
+    // Plain values (scalars, vectors, matrices) hash their bytes.
+    template <typename T>
+    Hasher&                    update(const T& value);
+
+    // Does not consume state, more data may follow.
+    Hash                       hash() const;
+
+    static const size_t        StripeSize = 64;
+
+  protected:
+    static void                accumulate(uint64_t* acc, const uint8_t* stripe, size_t stripeId);
+    static void                scramble(uint64_t* acc);
+
+  private:
+    uint64_t                   _acc[8];
+    uint8_t                    _buffer[StripeSize];
+    size_t                     _buffered;
+    size_t                     _stripeId;
+    uint64_t                   _length;
+};
+
+template <typename T>
+Hasher&
+Hasher::update(const T& value)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Hasher::update requires plain values");
+    return update(&value, sizeof(T));
+}
+
+}
+
+#endif
@@ -40,6 +40,7 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrLog.h>
+#include <mutex>
 
 namespace Ctr
 {
@@ -50,6 +51,8 @@ LoggingLevel   Log::_logLevel = LogCritical;
 namespace
 {
 Log applicationLog;
+// Shader reloads and file watching log from worker threads.
+std::mutex logMutex;
 }
 
 void Log::initialize(const std::string& filePathName)
@@ -68,6 +71,7 @@ Log::write (const std::string& buffer, LogEntryLevel level)
     if (level < _logLevel)
         return;
 
+    std::lock_guard<std::mutex> lock(logMutex);
     if (!_initialized)
     {
         Log::initialize(Log::_filePathName);
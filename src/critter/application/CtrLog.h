@@ -49,7 +49,7 @@ namespace Ctr
 //-----------------------------------------------------------
 // class Log
 // Very, very simple and dumb logging to file wrapper.
-// Not threadsafe. Prints to std out along with file io.
+// Writes are serialized. Prints to std out along with file io.
 //-----------------------------------------------------------
 enum LogEntryLevel
 {
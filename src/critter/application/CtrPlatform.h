@@ -74,6 +74,23 @@
 #include <string.h>
 #include <stdint.h>
 
+// SIMD. SSE2 is the baseline on every x64 target, AVX is opt in (/arch:AVX).
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CTR_SSE 1
+#include <emmintrin.h>
+#else
+#define CTR_SSE 0
+#endif
+
+#if defined(__AVX__)
+#define CTR_AVX 1
+#include <immintrin.h>
+#else
+#define CTR_AVX 0
+#endif
+
+#define CTR_SIMD_ALIGNMENT 16
+
 
 // Typedef Win32 stuff out of the way
 #if _WIN32 || _WIN64
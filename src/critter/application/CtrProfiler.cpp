@@ -0,0 +1,442 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrProfiler.h>
+#include <CtrTimer.h>
+#include <CtrLog.h>
+#include <mutex>
+
+namespace Ctr
+{
+namespace
+{
+const uint32_t EventCapacity = 1 << 14;
+
+struct ProfileEvent
+{
+    const char*                name;
+    uint64_t                   begin;
+    uint64_t                   end;
+    uint32_t                   depth;
+};
+
+struct TraceEvent
+{
+    ProfileEvent               event;
+    uint32_t                   threadId;
+};
+
+//-----------------------------------------------------------
+// Single producer (owning thread), single consumer (endFrame).
+//-----------------------------------------------------------
+struct ThreadEventBuffer
+{
+    ThreadEventBuffer(uint32_t id) :
+        threadId(id),
+        depth(0),
+        write(0),
+        read(0),
+        retired(false)
+    {
+        events.resize(EventCapacity);
+    }
+
+    uint32_t                   threadId;
+    uint32_t                   depth;
+    std::atomic<uint32_t>      write;
+    std::atomic<uint32_t>      read;
+    std::atomic<bool>          retired;
+    std::vector<ProfileEvent>  events;
+};
+
+//-----------------------------------------------------------
+// Retires the calling thread's buffer when the thread exits,
+// endFrame frees it once the remaining events are drained.
+//-----------------------------------------------------------
+struct ThreadBufferOwner
+{
+    ThreadBufferOwner() : buffer(nullptr) {}
+    ~ThreadBufferOwner()
+    {
+        if (buffer)
+            buffer->retired.store(true, std::memory_order_release);
+    }
+
+    ThreadEventBuffer*         buffer;
+};
+
+//-----------------------------------------------------------
+// Frees the buffers still registered at exit.
+//-----------------------------------------------------------
+struct ThreadBufferList
+{
+    ~ThreadBufferList()
+    {
+        for (auto it = buffers.begin(); it != buffers.end(); it++)
+            delete *it;
+        buffers.clear();
+    }
+
+    std::vector<ThreadEventBuffer*> buffers;
+};
+
+std::mutex                     buffersMutex;
+ThreadBufferList               threadBuffers;
+std::vector<ThreadEventBuffer*>& buffers = threadBuffers.buffers;
+uint32_t                       nextThreadId = 0;
+thread_local ThreadBufferOwner threadBuffer;
+std::atomic<uint32_t>          dropped(0);
+
+std::vector<ProfileZoneStats>  frameZoneStats;
+std::vector<ProfileEvent>      drainedEvents;
+double                         frameTime = 0.0;
+uint64_t                       lastFrameTick = 0;
+
+std::vector<TraceEvent>        traceEvents;
+uint32_t                       traceFramesRemaining = 0;
+std::string                    traceFilePathName;
+
+ThreadEventBuffer*
+currentThreadBuffer()
+{
+    if (!threadBuffer.buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        threadBuffer.buffer = new ThreadEventBuffer(nextThreadId++);
+        buffers.push_back(threadBuffer.buffer);
+    }
+    return threadBuffer.buffer;
+}
+
+// Drop every pending event. Caller holds buffersMutex.
+void
+discardEvents()
+{
+    for (auto it = buffers.begin(); it != buffers.end(); it++)
+    {
+        ThreadEventBuffer* buffer = *it;
+        buffer->read.store(buffer->write.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
+
+// Free the buffers of exited threads once drained. Caller holds buffersMutex.
+void
+releaseRetiredBuffers()
+{
+    for (auto it = buffers.begin(); it != buffers.end();)
+    {
+        ThreadEventBuffer* buffer = *it;
+        if (buffer->retired.load(std::memory_order_acquire) &&
+            buffer->read.load(std::memory_order_relaxed) == buffer->write.load(std::memory_order_acquire))
+        {
+            delete buffer;
+            it = buffers.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+bool
+eventBefore(const ProfileEvent& a, const ProfileEvent& b)
+{
+    if (a.begin != b.begin)
+        return a.begin < b.begin;
+    return a.depth < b.depth;
+}
+
+struct ZoneNode
+{
+    const char*                name;
+    uint32_t                   calls;
+    double                     milliseconds;
+    std::vector<size_t>        children;
+};
+
+void
+flatten(const std::vector<ZoneNode>& nodes, size_t nodeId, uint32_t threadId, uint32_t depth)
+{
+    const ZoneNode& node = nodes[nodeId];
+    for (auto it = node.children.begin(); it != node.children.end(); it++)
+    {
+        const ZoneNode& child = nodes[*it];
+        ProfileZoneStats stats;
+        stats.name = child.name;
+        stats.threadId = threadId;
+        stats.depth = depth;
+        stats.calls = child.calls;
+        stats.milliseconds = child.milliseconds;
+        frameZoneStats.push_back(stats);
+        flatten(nodes, *it, threadId, depth + 1);
+    }
+}
+
+// Merge one thread's events into a tree, siblings of the same name are combined.
+void
+aggregate(std::vector<ProfileEvent>& events, uint32_t threadId, double tickToMs)
+{
+    std::sort(events.begin(), events.end(), eventBefore);
+
+    std::vector<ZoneNode> nodes(1);
+    nodes[0].name = nullptr;
+    // Open zones, end tick and node.
+    std::vector<std::pair<uint64_t, size_t> > stack;
+    for (auto it = events.begin(); it != events.end(); it++)
+    {
+        // Zones opened before this frame leave no parent, attach to the closest level.
+        while (!stack.empty() && (stack.size() > it->depth || stack.back().first < it->begin))
+            stack.pop_back();
+        size_t parentId = stack.empty() ? 0 : stack.back().second;
+
+        size_t nodeId = 0;
+        const std::vector<size_t>& siblings = nodes[parentId].children;
+        for (auto siblingIt = siblings.begin(); siblingIt != siblings.end(); siblingIt++)
+        {
+            if (nodes[*siblingIt].name == it->name)
+            {
+                nodeId = *siblingIt;
+                break;
+            }
+        }
+
+        if (nodeId == 0)
+        {
+            nodeId = nodes.size();
+            ZoneNode node;
+            node.name = it->name;
+            node.calls = 0;
+            node.milliseconds = 0.0;
+            nodes.push_back(node);
+            nodes[parentId].children.push_back(nodeId);
+        }
+
+        nodes[nodeId].calls++;
+        nodes[nodeId].milliseconds += double(it->end - it->begin) * tickToMs;
+        stack.push_back(std::make_pair(it->end, nodeId));
+    }
+
+    flatten(nodes, 0, threadId, 0);
+}
+
+void
+writeEscaped(std::ostream& stream, const char* text)
+{
+    for (const char* c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            stream << '\\';
+        stream << *c;
+    }
+}
+
+}
+
+std::atomic<bool> Profiler::_enabled(false);
+
+void
+Profiler::setEnabled(bool enabled)
+{
+    if (_enabled.exchange(enabled, std::memory_order_relaxed) == enabled)
+        return;
+
+    // Zones that straddle the toggle would otherwise show up in the
+    // first frame after the next enable.
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    discardEvents();
+    releaseRetiredBuffers();
+    frameZoneStats.clear();
+}
+
+uint64_t
+Profiler::beginZone()
+{
+    currentThreadBuffer()->depth++;
+    return Timer::ticks();
+}
+
+void
+Profiler::endZone(const char* name, uint64_t begin)
+{
+    uint64_t end = Timer::ticks();
+    ThreadEventBuffer* buffer = currentThreadBuffer();
+    buffer->depth--;
+
+    uint32_t write = buffer->write.load(std::memory_order_relaxed);
+    if (write - buffer->read.load(std::memory_order_acquire) >= EventCapacity)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ProfileEvent& event = buffer->events[write % EventCapacity];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    event.depth = buffer->depth;
+    buffer->write.store(write + 1, std::memory_order_release);
+}
+
+void
+Profiler::endFrame()
+{
+    uint64_t now = Timer::ticks();
+    double tickToMs = 1000.0 / double(Timer::ticksPerSecond());
+    frameTime = lastFrameTick ? double(now - lastFrameTick) * tickToMs : 0.0;
+    lastFrameTick = now;
+
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    if (!enabled() && traceFramesRemaining == 0)
+    {
+        discardEvents();
+        releaseRetiredBuffers();
+        return;
+    }
+
+    frameZoneStats.clear();
+
+    for (auto it = buffers.begin(); it != buffers.end(); it++)
+    {
+        ThreadEventBuffer* buffer = *it;
+        uint32_t read = buffer->read.load(std::memory_order_relaxed);
+        uint32_t write = buffer->write.load(std::memory_order_acquire);
+        if (read == write)
+            continue;
+
+        drainedEvents.clear();
+        for (; read != write; read++)
+        {
+            drainedEvents.push_back(buffer->events[read % EventCapacity]);
+        }
+        buffer->read.store(read, std::memory_order_release);
+
+        if (traceFramesRemaining > 0)
+        {
+            for (auto eventIt = drainedEvents.begin(); eventIt != drainedEvents.end(); eventIt++)
+            {
+                TraceEvent traceEvent;
+                traceEvent.event = *eventIt;
+                traceEvent.threadId = buffer->threadId;
+                traceEvents.push_back(traceEvent);
+            }
+        }
+
+        aggregate(drainedEvents, buffer->threadId, tickToMs);
+    }
+
+    releaseRetiredBuffers();
+
+    if (traceFramesRemaining > 0 && --traceFramesRemaining == 0)
+    {
+        writeTrace();
+    }
+}
+
+const std::vector<ProfileZoneStats>&
+Profiler::frameZones()
+{
+    return frameZoneStats;
+}
+
+double
+Profiler::frameMilliseconds()
+{
+    return frameTime;
+}
+
+uint32_t
+Profiler::droppedEvents()
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+void
+Profiler::captureTrace(uint32_t frameCount, const std::string& filePathName)
+{
+    if (frameCount == 0)
+        return;
+
+    traceEvents.clear();
+    traceFilePathName = filePathName;
+    traceFramesRemaining = frameCount;
+    setEnabled(true);
+}
+
+bool
+Profiler::capturingTrace()
+{
+    return traceFramesRemaining > 0;
+}
+
+void
+Profiler::writeTrace()
+{
+    std::ofstream stream(traceFilePathName.c_str());
+    if (!stream.is_open())
+    {
+        LOG_WARNING("Failed to open trace file " << traceFilePathName);
+        traceEvents.clear();
+        return;
+    }
+
+    uint64_t origin = UINT64_MAX;
+    for (auto it = traceEvents.begin(); it != traceEvents.end(); it++)
+        origin = std::min(origin, it->event.begin);
+
+    double tickToUs = 1000000.0 / double(Timer::ticksPerSecond());
+    stream << "{\"traceEvents\":[\n";
+    for (auto it = traceEvents.begin(); it != traceEvents.end(); it++)
+    {
+        if (it != traceEvents.begin())
+            stream << ",\n";
+        stream << "{\"name\":\"";
+        writeEscaped(stream, it->event.name);
+        stream << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << it->threadId
+               << ",\"ts\":" << double(it->event.begin - origin) * tickToUs
+               << ",\"dur\":" << double(it->event.end - it->event.begin) * tickToUs << "}";
+    }
+    stream << "\n]}\n";
+
+    LOG("Wrote " << traceEvents.size() << " profile events to " << traceFilePathName);
+    traceEvents.clear();
+}
+
+}
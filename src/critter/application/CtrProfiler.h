@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_PROFILER
+#define INCLUDED_CRT_PROFILER
+
+#include <CtrPlatform.h>
+#include <atomic>
+
+// Set to 0 to compile every zone out.
+#ifndef CTR_PROFILING
+#define CTR_PROFILING 1
+#endif
+
+namespace Ctr
+{
+//-----------------------------------------------------------
+// Aggregated zone of the last profiled frame.
+// Zones are flattened in depth first order, children of the
+// same name under the same parent are merged.
+//-----------------------------------------------------------
+struct ProfileZoneStats
+{
+    const char*                name;
+    uint32_t                   threadId;
+    uint32_t                   depth;
+    uint32_t                   calls;
+    double                     milliseconds;
+};
+
+//-----------------------------------------------------------
+// class Profiler
+// Hierarchical CPU zones. Each thread records into its own
+// single producer ring, the main thread drains the rings in
+// endFrame. Zone names must be string literals (only the
+// pointer is stored). When disabled a zone costs one relaxed
+// load. A thread's buffer is freed by endFrame once the thread
+// has exited and its events are drained. Toggling profiling
+// discards pending events.
+//-----------------------------------------------------------
+class Profiler
+{
+  public:
+    static bool                enabled() { return _enabled.load(std::memory_order_relaxed); }
+    static void                setEnabled(bool enabled);
+
+    // Called once per frame by the main thread.
+    static void                endFrame();
+
+    static const std::vector<ProfileZoneStats>& frameZones();
+    static double              frameMilliseconds();
+    static uint32_t            droppedEvents();
+
+    // Record the next frameCount frames and write them as
+    // Chrome trace JSON (chrome://tracing) to filePathName.
+    static void                captureTrace(uint32_t frameCount,
+                                            const std::string& filePathName);
+    static bool                capturingTrace();
+
+    static uint64_t            beginZone();
+    static void                endZone(const char* name, uint64_t begin);
+
+  private:
+    static void                writeTrace();
+
+    static std::atomic<bool>   _enabled;
+};
+
+class ProfileZone
+{
+  public:
+    explicit ProfileZone(const char* name) :
+        _name(name),
+        _begin(0),
+        _active(Profiler::enabled())
+    {
+        if (_active)
+            _begin = Profiler::beginZone();
+    }
+
+    ~ProfileZone()
+    {
+        if (_active)
+            Profiler::endZone(_name, _begin);
+    }
+
+  private:
+    ProfileZone(const ProfileZone&);
+    ProfileZone& operator=(const ProfileZone&);
+
+    const char*                _name;
+    uint64_t                   _begin;
+    bool                       _active;
+};
+
+}
+
+#define CTR_PROFILE_CONCAT_IMPL(a, b) a##b
+#define CTR_PROFILE_CONCAT(a, b) CTR_PROFILE_CONCAT_IMPL(a, b)
+
+#if CTR_PROFILING
+#define CTR_PROFILE_ZONE(name) Ctr::ProfileZone CTR_PROFILE_CONCAT(_profileZone, __LINE__)(name)
+#else
+#define CTR_PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrSymbol.h>
+#include <mutex>
+#include <unordered_map>
+#include <deque>
+#include <cctype>
+
+namespace Ctr
+{
+namespace
+{
+struct SymbolTable
+{
+    SymbolTable()
+    {
+        // Reserve id 0 for Symbol::Invalid.
+        names.push_back(std::string());
+    }
+
+    std::mutex                                  mutex;
+    std::unordered_map<std::string, SymbolId>   ids;
+    // Deque keeps name references stable as the table grows.
+    std::deque<std::string>                     names;
+};
+
+SymbolTable&
+symbolTable()
+{
+    static SymbolTable* table = new SymbolTable();
+    return *table;
+}
+}
+
+SymbolId
+Symbol::intern(const std::string& name)
+{
+    SymbolTable& table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.ids.find(name);
+    if (it != table.ids.end())
+        return it->second;
+
+    SymbolId id = SymbolId(table.names.size());
+    table.names.push_back(name);
+    table.ids.insert(std::make_pair(name, id));
+    return id;
+}
+
+SymbolId
+Symbol::internNoCase(const std::string& name)
+{
+    std::string upper(name);
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    return intern(upper);
+}
+
+SymbolId
+Symbol::find(const std::string& name)
+{
+    SymbolTable& table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto it = table.ids.find(name);
+    if (it != table.ids.end())
+        return it->second;
+    return Symbol::Invalid;
+}
+
+const std::string&
+Symbol::name(SymbolId id)
+{
+    SymbolTable& table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    if (id < table.names.size())
+        return table.names[id];
+    return table.names[Symbol::Invalid];
+}
+
+size_t
+Symbol::count()
+{
+    SymbolTable& table = symbolTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names.size() - 1;
+}
+
+}
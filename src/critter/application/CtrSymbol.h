@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_SYMBOL
+#define INCLUDED_CRT_SYMBOL
+
+#include <CtrPlatform.h>
+
+namespace Ctr
+{
+typedef uint32_t SymbolId;
+
+//------------------------------------------------------------
+// Symbol
+//
+// Process wide string interning. Each distinct string gets
+// a small, stable id the first time it is interned, so hot
+// lookups compare integers rather than strings.
+// Ids are never recycled and 0 is never a valid id.
+//------------------------------------------------------------
+class Symbol
+{
+  public:
+    enum
+    {
+        Invalid = 0
+    };
+
+    // Returns the id for name, creating it if necessary.
+    static SymbolId            intern(const std::string& name);
+
+    // Case insensitive variant (used for shader semantics).
+    static SymbolId            internNoCase(const std::string& name);
+
+    // Returns the id for name, or Invalid if it was never interned.
+    static SymbolId            find(const std::string& name);
+
+    static const std::string&  name(SymbolId id);
+    static size_t              count();
+};
+
+//------------------------------------------------------------
+// SymbolMap
+//
+// Flat map from SymbolId to value. Built once (usually when
+// a shader is created) and then searched with a binary search
+// over a contiguous array.
+//------------------------------------------------------------
+template <typename T>
+class SymbolMap
+{
+  public:
+    typedef std::pair<SymbolId, T>                          Entry;
+    typedef typename std::vector<Entry>::const_iterator     const_iterator;
+
+    // Inserts or replaces the value for id. Returns false if id already existed.
+    bool                       insert(SymbolId id, const T& value)
+    {
+        auto it = lowerBound(id);
+        if (it != _entries.end() && it->first == id)
+        {
+            it->second = value;
+            return false;
+        }
+        _entries.insert(it, Entry(id, value));
+        return true;
+    }
+
+    bool                       find(SymbolId id, T& value) const
+    {
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), id, 
+                                   [](const Entry& entry, SymbolId key) { return entry.first < key; });
+        if (it != _entries.end() && it->first == id)
+        {
+            value = it->second;
+            return true;
+        }
+        return false;
+    }
+
+    void                       clear() { _entries.clear(); }
+    size_t                     size() const { return _entries.size(); }
+    bool                       empty() const { return _entries.empty(); }
+
+    const_iterator             begin() const { return _entries.begin(); }
+    const_iterator             end() const { return _entries.end(); }
+
+  private:
+    typename std::vector<Entry>::iterator lowerBound(SymbolId id)
+    {
+        return std::lower_bound(_entries.begin(), _entries.end(), id, 
+                                [](const Entry& entry, SymbolId key) { return entry.first < key; });
+    }
+
+    std::vector<Entry>         _entries;
+};
+}
+
+#endif
@@ -105,6 +105,27 @@ Timer::time (size_t frame, double rate)
     return double(frame) * (1.0f / rate);
 }
 
+uint64_t
+Timer::ticks()
+{
+    LARGE_INTEGER time;
+    QueryPerformanceCounter(&time);
+    return (uint64_t)time.QuadPart;
+}
+
+uint64_t
+Timer::ticksPerSecond()
+{
+    static uint64_t frequency = 0;
+    if (frequency == 0)
+    {
+        LARGE_INTEGER qwTicksPerSec;
+        QueryPerformanceFrequency(&qwTicksPerSec);
+        frequency = (uint64_t)qwTicksPerSec.QuadPart;
+    }
+    return frequency;
+}
+
 bool 
 Timer::initialize()
 {
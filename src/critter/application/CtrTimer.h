@@ -65,6 +65,10 @@ class Timer
     static size_t              frame (double time, double rate = 24.0);
     static double              time (size_t frame, double rate = 24.0);
 
+    // Raw high resolution counter, used by the profiler.
+    static uint64_t            ticks();
+    static uint64_t            ticksPerSecond();
+
     //------------------
     // Updates the timer
     //------------------
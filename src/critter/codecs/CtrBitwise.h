@@ -350,6 +350,71 @@ namespace Ctr
         
             return (s << 31) | (e << 23) | m;
         }
+
+#if CTR_SSE
+        /** Converts the four halves in the low 64 bits of halves to floats.
+            Bit exact with halfToFloat. The half is placed in the float
+            exponent and rescaled by 2^112, which also renormalizes denormals.
+        */
+        static inline __m128 halfToFloat4(__m128i halves)
+        {
+            const __m128i exponentMantissaMask = _mm_set1_epi32(0x7fff);
+            const __m128i largestFinite = _mm_set1_epi32(0x7bff);
+            const __m128i infNanExponent = _mm_set1_epi32(0xff << 23);
+            const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+
+            __m128i h = _mm_unpacklo_epi16(halves, _mm_setzero_si128());
+            __m128i exponentMantissa = _mm_and_si128(h, exponentMantissaMask);
+            __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, exponentMantissa), 16);
+            __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), rebias);
+            __m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(exponentMantissa, largestFinite), infNanExponent);
+            return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan)));
+        }
+
+        /** Converts four floats to halves, returned in the low 64 bits.
+            Bit exact with floatToHalf (truncating, overflow to infinity).
+        */
+        static inline __m128i floatToHalf4(__m128 values)
+        {
+            const __m128i absMask = _mm_set1_epi32(0x7fffffff);
+            const __m128i signMask = _mm_set1_epi32(0x8000);
+            const __m128i infinity = _mm_set1_epi32(0x7c00);
+            const __m128i one = _mm_set1_epi32(1);
+
+            __m128i i = _mm_castps_si128(values);
+            __m128i absolute = _mm_and_si128(i, absMask);
+            __m128i sign = _mm_and_si128(_mm_srli_epi32(i, 16), signMask);
+
+            // Exponent in range, rebias from 127 to 15 and drop 13 mantissa bits.
+            __m128i result = _mm_or_si128(sign, _mm_srli_epi32(_mm_sub_epi32(absolute, _mm_set1_epi32(112 << 23)), 13));
+
+            // Denormal halves are the value in units of 2^-24, truncated.
+            __m128i denormal = _mm_or_si128(sign, _mm_cvttps_epi32(_mm_mul_ps(_mm_castsi128_ps(absolute),
+                                                                               _mm_set1_ps(16777216.0f))));
+            __m128i isDenormal = _mm_cmplt_epi32(absolute, _mm_set1_epi32(113 << 23));
+            result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, result));
+
+            // Below the smallest denormal, unsigned zero.
+            __m128i isZero = _mm_cmplt_epi32(absolute, _mm_set1_epi32(102 << 23));
+            result = _mm_andnot_si128(isZero, result);
+
+            // Overflow and infinity.
+            __m128i isOverflow = _mm_cmpgt_epi32(absolute, _mm_set1_epi32((143 << 23) - 1));
+            result = _mm_or_si128(_mm_and_si128(isOverflow, _mm_or_si128(sign, infinity)), 
+                                  _mm_andnot_si128(isOverflow, result));
+
+            // NaN keeps the top of the mantissa and at least one bit of it.
+            __m128i nanMantissa = _mm_srli_epi32(_mm_and_si128(absolute, _mm_set1_epi32(0x007fffff)), 13);
+            nanMantissa = _mm_or_si128(nanMantissa, _mm_and_si128(_mm_cmpeq_epi32(nanMantissa, _mm_setzero_si128()), one));
+            __m128i isNan = _mm_cmpgt_epi32(absolute, _mm_set1_epi32(0x7f800000));
+            result = _mm_or_si128(_mm_and_si128(isNan, _mm_or_si128(_mm_or_si128(sign, infinity), nanMantissa)), 
+                                  _mm_andnot_si128(isNan, result));
+
+            // Sign extend so the saturating pack keeps the bits.
+            result = _mm_srai_epi32(_mm_slli_epi32(result, 16), 16);
+            return _mm_packs_epi32(result, result);
+        }
+#endif
          
 
     };
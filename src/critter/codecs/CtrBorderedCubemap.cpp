@@ -0,0 +1,536 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrBorderedCubemap.h>
+#include <CtrTextureImage.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <algorithm>
+#include <cmath>
+
+namespace Ctr
+{
+namespace
+{
+struct EdgeNeighbor
+{
+    uint8_t face;
+    uint8_t edge;
+};
+
+// Face and edge of the neighbour across each edge of a face (D3D layout).
+const EdgeNeighbor CubeEdgeNeighbor[6][4] =
+{
+    // +X
+    {{BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_RIGHT},
+     {BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_LEFT},
+     {BorderedCubemap::FACE_Y_POS, BorderedCubemap::EDGE_RIGHT},
+     {BorderedCubemap::FACE_Y_NEG, BorderedCubemap::EDGE_RIGHT}},
+    // -X
+    {{BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_RIGHT},
+     {BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_LEFT},
+     {BorderedCubemap::FACE_Y_POS, BorderedCubemap::EDGE_LEFT},
+     {BorderedCubemap::FACE_Y_NEG, BorderedCubemap::EDGE_LEFT}},
+    // +Y
+    {{BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_TOP},
+     {BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_TOP},
+     {BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_TOP},
+     {BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_TOP}},
+    // -Y
+    {{BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_BOTTOM},
+     {BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_BOTTOM},
+     {BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_BOTTOM},
+     {BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_BOTTOM}},
+    // +Z
+    {{BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_RIGHT},
+     {BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_LEFT},
+     {BorderedCubemap::FACE_Y_POS, BorderedCubemap::EDGE_BOTTOM},
+     {BorderedCubemap::FACE_Y_NEG, BorderedCubemap::EDGE_TOP}},
+    // -Z
+    {{BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_RIGHT},
+     {BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_LEFT},
+     {BorderedCubemap::FACE_Y_POS, BorderedCubemap::EDGE_TOP},
+     {BorderedCubemap::FACE_Y_NEG, BorderedCubemap::EDGE_BOTTOM}}
+};
+
+const size_t CHANNELS = 4;
+
+//---------------------------------------------------------------------
+// Texel at depth (negative is outside the face) and position along an
+// edge. Positions run left to right or top to bottom.
+//---------------------------------------------------------------------
+inline void
+edgeTexel(uint8_t edge, ptrdiff_t size, ptrdiff_t depth, ptrdiff_t position,
+          ptrdiff_t& x, ptrdiff_t& y)
+{
+    switch (edge)
+    {
+        case BorderedCubemap::EDGE_LEFT:   x = depth;            y = position;         break;
+        case BorderedCubemap::EDGE_RIGHT:  x = size - 1 - depth; y = position;         break;
+        case BorderedCubemap::EDGE_TOP:    x = position;         y = depth;            break;
+        default:                           x = position;         y = size - 1 - depth; break;
+    }
+}
+
+inline ptrdiff_t
+clampIndex(ptrdiff_t value, ptrdiff_t minValue, ptrdiff_t maxValue)
+{
+    return std::min(std::max(value, minValue), maxValue);
+}
+
+inline void
+catmullRomWeights(float t, float* weights)
+{
+    float t2 = t * t;
+    float t3 = t2 * t;
+    weights[0] = 0.5f * (-t3 + 2.0f * t2 - t);
+    weights[1] = 0.5f * (3.0f * t3 - 5.0f * t2 + 2.0f);
+    weights[2] = 0.5f * (-3.0f * t3 + 4.0f * t2 + t);
+    weights[3] = 0.5f * (t3 - t2);
+}
+}
+
+BorderedCubemap::BorderedCubemap(size_t faceSize, size_t numMipmaps, size_t border)
+{
+    allocate(faceSize, numMipmaps, border);
+}
+
+BorderedCubemap::BorderedCubemap(const TextureImage& cubemap, size_t border)
+{
+    if (!cubemap.hasFlag(IF_CUBEMAP) || cubemap.getNumFaces() != FACE_COUNT ||
+        cubemap.getWidth() != cubemap.getHeight())
+    {
+        throw(std::exception("Image is not a square cubemap BorderedCubemap::BorderedCubemap"));
+    }
+    if (PixelUtil::isCompressed(cubemap.getFormat()))
+    {
+        throw(std::exception("Compressed cubemaps are not supported BorderedCubemap::BorderedCubemap"));
+    }
+
+    allocate(cubemap.getWidth(), cubemap.getNumLevels(), border);
+
+    concurrency::parallel_for(size_t(0), size_t(FACE_COUNT) * mLevels.size(), [&](size_t surface)
+    {
+        size_t faceId = surface % FACE_COUNT;
+        size_t mipmap = surface / FACE_COUNT;
+        PixelUtil::bulkPixelConversion(cubemap.getPixelBox(faceId, mipmap), face(faceId, mipmap));
+    });
+
+    fillBorders();
+}
+
+BorderedCubemap::~BorderedCubemap()
+{
+}
+
+void
+BorderedCubemap::allocate(size_t faceSize, size_t numMipmaps, size_t border)
+{
+    if (faceSize == 0)
+    {
+        throw(std::exception("Face size must not be 0 BorderedCubemap::allocate"));
+    }
+
+    mBorder = std::max(border, size_t(1));
+
+    size_t maxLevels = 1;
+    while ((faceSize >> maxLevels) > 0)
+        maxLevels++;
+    numMipmaps = std::min(std::max(numMipmaps, size_t(1)), maxLevels);
+
+    mLevels.resize(numMipmaps);
+    size_t offset = 0;
+    for (size_t mipmap = 0; mipmap < numMipmaps; mipmap++)
+    {
+        Level& level = mLevels[mipmap];
+        level.size = std::max(faceSize >> mipmap, size_t(1));
+        level.stride = level.size + 2 * mBorder;
+        level.offset = offset;
+        offset += FACE_COUNT * level.stride * level.stride * CHANNELS;
+    }
+    mData.assign(offset, 0.0f);
+}
+
+size_t
+BorderedCubemap::getFaceSize(size_t mipmap) const
+{
+    return mLevels[mipmap].size;
+}
+
+size_t
+BorderedCubemap::getNumMipmaps() const
+{
+    return mLevels.size();
+}
+
+size_t
+BorderedCubemap::getBorder() const
+{
+    return mBorder;
+}
+
+size_t
+BorderedCubemap::getStride(size_t mipmap) const
+{
+    return mLevels[mipmap].stride;
+}
+
+float*
+BorderedCubemap::texel(size_t face, size_t mipmap, ptrdiff_t x, ptrdiff_t y)
+{
+    const Level& level = mLevels[mipmap];
+    size_t index = (face * level.stride + size_t(y + ptrdiff_t(mBorder))) * level.stride + 
+                   size_t(x + ptrdiff_t(mBorder));
+    return &mData[level.offset + index * CHANNELS];
+}
+
+const float*
+BorderedCubemap::texel(size_t face, size_t mipmap, ptrdiff_t x, ptrdiff_t y) const
+{
+    return const_cast<BorderedCubemap*>(this)->texel(face, mipmap, x, y);
+}
+
+PixelBox
+BorderedCubemap::face(size_t face, size_t mipmap) const
+{
+    const Level& level = mLevels[mipmap];
+    PixelBox box(level.size, level.size, 1, PF_FLOAT32_RGBA, 
+                 const_cast<float*>(texel(face, mipmap, 0, 0)));
+    box.rowPitch = ptrdiff_t(level.stride);
+    box.slicePitch = ptrdiff_t(level.stride * level.size);
+    return box;
+}
+
+PixelBox
+BorderedCubemap::borderedFace(size_t face, size_t mipmap) const
+{
+    const Level& level = mLevels[mipmap];
+    ptrdiff_t border = ptrdiff_t(mBorder);
+    return PixelBox(level.stride, level.stride, 1, PF_FLOAT32_RGBA,
+                    const_cast<float*>(texel(face, mipmap, -border, -border)));
+}
+
+void
+BorderedCubemap::fillBorders()
+{
+    for (size_t mipmap = 0; mipmap < mLevels.size(); mipmap++)
+        fillBorders(mipmap);
+}
+
+//---------------------------------------------------------------------
+// Every apron texel at depth d past an edge is the texel at depth d-1
+// inside the neighbouring face. Faces only write their own apron and
+// only read the interior of their neighbours, so they fill in parallel.
+// Corners have no texel on the cube, they average the two apron texels
+// mirrored across the diagonal (the corners of the neighbouring faces).
+//---------------------------------------------------------------------
+void
+BorderedCubemap::fillBorders(size_t mipmap)
+{
+    const ptrdiff_t size = ptrdiff_t(mLevels[mipmap].size);
+    const ptrdiff_t border = ptrdiff_t(mBorder);
+
+    concurrency::parallel_for(size_t(0), size_t(FACE_COUNT), [&](size_t faceId)
+    {
+        for (uint8_t edge = EDGE_LEFT; edge < EDGE_COUNT; edge++)
+        {
+            size_t neighborFace, neighborEdge;
+            const bool flipped = edgeNeighbor(faceId, edge, neighborFace, neighborEdge);
+
+            for (ptrdiff_t depth = 1; depth <= border; depth++)
+            {
+                ptrdiff_t neighborDepth = std::min(depth - 1, size - 1);
+                for (ptrdiff_t position = 0; position < size; position++)
+                {
+                    ptrdiff_t x, y, nx, ny;
+                    edgeTexel(edge, size, -depth, position, x, y);
+                    edgeTexel(uint8_t(neighborEdge), size, neighborDepth, 
+                              flipped ? size - 1 - position : position, nx, ny);
+                    memcpy(texel(faceId, mipmap, x, y), texel(neighborFace, mipmap, nx, ny), 
+                           sizeof(float) * CHANNELS);
+                }
+            }
+        }
+
+        for (ptrdiff_t dy = 1; dy <= border; dy++)
+        {
+            for (ptrdiff_t dx = 1; dx <= border; dx++)
+            {
+                ptrdiff_t innerX = std::min(dx - 1, size - 1);
+                ptrdiff_t innerY = std::min(dy - 1, size - 1);
+                const ptrdiff_t corners[4][4] =
+                {
+                    // apron x, apron y, inner x, inner y
+                    { -dx,          -dy,          innerX,            innerY },
+                    { size - 1 + dx, -dy,          size - 1 - innerX, innerY },
+                    { -dx,          size - 1 + dy, innerX,            size - 1 - innerY },
+                    { size - 1 + dx, size - 1 + dy, size - 1 - innerX, size - 1 - innerY }
+                };
+
+                for (size_t corner = 0; corner < 4; corner++)
+                {
+                    const ptrdiff_t* c = corners[corner];
+                    const float* a = texel(faceId, mipmap, c[0], c[3]);
+                    const float* b = texel(faceId, mipmap, c[2], c[1]);
+                    float* out = texel(faceId, mipmap, c[0], c[1]);
+                    for (size_t channel = 0; channel < CHANNELS; channel++)
+                        out[channel] = 0.5f * (a[channel] + b[channel]);
+                }
+            }
+        }
+    });
+}
+
+Vector4f
+BorderedCubemap::sampleBilinear(size_t face, size_t mipmap, float u, float v) const
+{
+    const ptrdiff_t size = ptrdiff_t(mLevels[mipmap].size);
+    const ptrdiff_t border = ptrdiff_t(mBorder);
+
+    float x = u * float(size) - 0.5f;
+    float y = v * float(size) - 0.5f;
+    ptrdiff_t x0 = clampIndex(ptrdiff_t(std::floor(x)), -border, size + border - 2);
+    ptrdiff_t y0 = clampIndex(ptrdiff_t(std::floor(y)), -border, size + border - 2);
+    float fx = clamped(x - float(x0), 0.0f, 1.0f);
+    float fy = clamped(y - float(y0), 0.0f, 1.0f);
+
+    const float* t00 = texel(face, mipmap, x0, y0);
+    const float* t01 = t00 + mLevels[mipmap].stride * CHANNELS;
+
+    float result[CHANNELS];
+    for (size_t channel = 0; channel < CHANNELS; channel++)
+    {
+        float top = t00[channel] + (t00[channel + CHANNELS] - t00[channel]) * fx;
+        float bottom = t01[channel] + (t01[channel + CHANNELS] - t01[channel]) * fx;
+        result[channel] = top + (bottom - top) * fy;
+    }
+    return Vector4f(result[0], result[1], result[2], result[3]);
+}
+
+Vector4f
+BorderedCubemap::sampleBicubic(size_t face, size_t mipmap, float u, float v) const
+{
+    const ptrdiff_t size = ptrdiff_t(mLevels[mipmap].size);
+    const ptrdiff_t border = ptrdiff_t(mBorder);
+
+    float x = u * float(size) - 0.5f;
+    float y = v * float(size) - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+
+    float wx[4];
+    float wy[4];
+    catmullRomWeights(x - fx, wx);
+    catmullRomWeights(y - fy, wy);
+
+    ptrdiff_t xs[4];
+    ptrdiff_t ys[4];
+    for (ptrdiff_t tap = 0; tap < 4; tap++)
+    {
+        xs[tap] = clampIndex(ptrdiff_t(fx) + tap - 1, -border, size + border - 1);
+        ys[tap] = clampIndex(ptrdiff_t(fy) + tap - 1, -border, size + border - 1);
+    }
+
+    float result[CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (size_t j = 0; j < 4; j++)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            const float* t = texel(face, mipmap, xs[i], ys[j]);
+            float weight = wx[i] * wy[j];
+            for (size_t channel = 0; channel < CHANNELS; channel++)
+                result[channel] += t[channel] * weight;
+        }
+    }
+    return Vector4f(result[0], result[1], result[2], result[3]);
+}
+
+size_t
+BorderedCubemap::faceFromDirection(const Vector3f& direction, float& u, float& v)
+{
+    float ax = std::fabs(direction.x);
+    float ay = std::fabs(direction.y);
+    float az = std::fabs(direction.z);
+
+    size_t faceId;
+    float sc, tc, ma;
+    if (ax >= ay && ax >= az)
+    {
+        faceId = direction.x >= 0.0f ? FACE_X_POS : FACE_X_NEG;
+        sc = direction.x >= 0.0f ? -direction.z : direction.z;
+        tc = -direction.y;
+        ma = ax;
+    }
+    else if (ay >= az)
+    {
+        faceId = direction.y >= 0.0f ? FACE_Y_POS : FACE_Y_NEG;
+        sc = direction.x;
+        tc = direction.y >= 0.0f ? direction.z : -direction.z;
+        ma = ay;
+    }
+    else
+    {
+        faceId = direction.z >= 0.0f ? FACE_Z_POS : FACE_Z_NEG;
+        sc = direction.z >= 0.0f ? direction.x : -direction.x;
+        tc = -direction.y;
+        ma = az;
+    }
+
+    float invMa = ma > 0.0f ? 1.0f / ma : 0.0f;
+    u = 0.5f * (sc * invMa + 1.0f);
+    v = 0.5f * (tc * invMa + 1.0f);
+    return faceId;
+}
+
+Vector3f
+BorderedCubemap::directionFromFace(size_t face, float u, float v)
+{
+    float sc = 2.0f * u - 1.0f;
+    float tc = 2.0f * v - 1.0f;
+    switch (face)
+    {
+        case FACE_X_POS: return Vector3f(1.0f, -tc, -sc);
+        case FACE_X_NEG: return Vector3f(-1.0f, -tc, sc);
+        case FACE_Y_POS: return Vector3f(sc, 1.0f, tc);
+        case FACE_Y_NEG: return Vector3f(sc, -1.0f, -tc);
+        case FACE_Z_POS: return Vector3f(sc, -tc, 1.0f);
+        default:         return Vector3f(-sc, -tc, -1.0f);
+    }
+}
+
+//---------------------------------------------------------------------
+// Edges meeting in the same orientation (or opposite ones) run in
+// opposite directions, same as the walk in fixupCubeEdges.
+//---------------------------------------------------------------------
+bool
+BorderedCubemap::edgeNeighbor(size_t face, size_t edge, size_t& neighborFace, size_t& neighborEdge)
+{
+    const EdgeNeighbor& neighbor = CubeEdgeNeighbor[face][edge];
+    neighborFace = neighbor.face;
+    neighborEdge = neighbor.edge;
+    return edge == neighborEdge || edge + neighborEdge == 3;
+}
+
+Vector4f
+BorderedCubemap::sample(const Vector3f& direction, float lod) const
+{
+    float u, v;
+    size_t faceId = faceFromDirection(direction, u, v);
+
+    lod = clamped(lod, 0.0f, float(mLevels.size() - 1));
+    size_t mip0 = size_t(lod);
+    size_t mip1 = std::min(mip0 + 1, mLevels.size() - 1);
+    float blend = lod - float(mip0);
+
+    Vector4f a = sampleBilinear(faceId, mip0, u, v);
+    if (blend <= 0.0f || mip0 == mip1)
+        return a;
+    Vector4f b = sampleBilinear(faceId, mip1, u, v);
+    return a + (b - a) * blend;
+}
+
+//---------------------------------------------------------------------
+// 2x downsample with the separable [1 3 3 1] / 8 tent. Each texel reads
+// one texel past its 2x2 footprint on every side, across the face
+// edges at the border of the face.
+//---------------------------------------------------------------------
+void
+BorderedCubemap::generateMipmaps()
+{
+    static const float weights[4] = { 0.125f, 0.375f, 0.375f, 0.125f };
+
+    fillBorders(0);
+    for (size_t mipmap = 1; mipmap < mLevels.size(); mipmap++)
+    {
+        const size_t source = mipmap - 1;
+        const ptrdiff_t sourceSize = ptrdiff_t(mLevels[source].size);
+        const ptrdiff_t size = ptrdiff_t(mLevels[mipmap].size);
+        const ptrdiff_t border = ptrdiff_t(mBorder);
+
+        concurrency::parallel_for(size_t(0), size_t(FACE_COUNT * size), [&](size_t row)
+        {
+            size_t faceId = row / size_t(size);
+            ptrdiff_t y = ptrdiff_t(row % size_t(size));
+
+            ptrdiff_t ys[4];
+            for (ptrdiff_t tap = 0; tap < 4; tap++)
+                ys[tap] = clampIndex(2 * y + tap - 1, -border, sourceSize + border - 1);
+
+            for (ptrdiff_t x = 0; x < size; x++)
+            {
+                float result[CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                for (ptrdiff_t i = 0; i < 4; i++)
+                {
+                    ptrdiff_t sx = clampIndex(2 * x + i - 1, -border, sourceSize + border - 1);
+                    for (size_t j = 0; j < 4; j++)
+                    {
+                        const float* t = texel(faceId, source, sx, ys[j]);
+                        float weight = weights[i] * weights[j];
+                        for (size_t channel = 0; channel < CHANNELS; channel++)
+                            result[channel] += t[channel] * weight;
+                    }
+                }
+                memcpy(texel(faceId, mipmap, x, y), result, sizeof(result));
+            }
+        });
+
+        fillBorders(mipmap);
+    }
+}
+
+void
+BorderedCubemap::copyTo(TextureImage& cubemap) const
+{
+    if (!cubemap.hasFlag(IF_CUBEMAP) || cubemap.getNumFaces() != FACE_COUNT ||
+        cubemap.getWidth() != mLevels[0].size || cubemap.getHeight() != mLevels[0].size)
+    {
+        throw(std::exception("Image is not a cubemap of the same size BorderedCubemap::copyTo"));
+    }
+
+    size_t numMipmaps = std::min(cubemap.getNumLevels(), mLevels.size());
+    concurrency::parallel_for(size_t(0), size_t(FACE_COUNT) * numMipmaps, [&](size_t surface)
+    {
+        size_t faceId = surface % FACE_COUNT;
+        size_t mipmap = surface / FACE_COUNT;
+        PixelUtil::bulkPixelConversion(face(faceId, mipmap), cubemap.getPixelBox(faceId, mipmap));
+    });
+}
+}
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_BORDERED_CUBEMAP
+#define INCLUDED_CRT_BORDERED_CUBEMAP
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrVector3.h>
+#include <CtrVector4.h>
+#include <vector>
+
+namespace Ctr
+{
+class TextureImage;
+
+/** Float RGBA cubemap where every face carries an apron of border texels.
+@remarks
+    The apron around each face is a copy of the texels of the neighbouring
+    faces (fillBorders), so filters that read a few texels past the edge of a
+    face get the texels from across the seam without any face or edge logic.
+    Face and edge orientation follow D3D (the same convention as
+    fixupCubeEdges). Sampling is bilinear or bicubic per face, and mips built
+    with generateMipmaps filter across the seams, so they need no fixup.
+    The bicubic sampler reads two texels past the edge, it needs a border
+    of 2 to be seamless.
+*/
+class BorderedCubemap
+{
+  public:
+    enum Face
+    {
+        FACE_X_POS,
+        FACE_X_NEG,
+        FACE_Y_POS,
+        FACE_Y_NEG,
+        FACE_Z_POS,
+        FACE_Z_NEG,
+        FACE_COUNT
+    };
+
+    enum Edge
+    {
+        EDGE_LEFT,
+        EDGE_RIGHT,
+        EDGE_TOP,
+        EDGE_BOTTOM,
+        EDGE_COUNT
+    };
+
+    BorderedCubemap(size_t faceSize, size_t numMipmaps = 1, size_t border = 1);
+    /// Copies every face and mip of a cubemap image and fills the borders.
+    BorderedCubemap(const TextureImage& cubemap, size_t border = 1);
+    ~BorderedCubemap();
+
+    size_t                   getFaceSize(size_t mipmap = 0) const;
+    size_t                   getNumMipmaps() const;
+    size_t                   getBorder() const;
+
+    /// Interior texels of a face, rows are getStride texels apart.
+    PixelBox                 face(size_t face, size_t mipmap = 0) const;
+    /// Face including the apron.
+    PixelBox                 borderedFace(size_t face, size_t mipmap = 0) const;
+    /// Texels per row (and rows per face) including the apron.
+    size_t                   getStride(size_t mipmap = 0) const;
+
+    /// Texel at x, y in [-border, faceSize + border).
+    float*                   texel(size_t face, size_t mipmap, ptrdiff_t x, ptrdiff_t y);
+    const float*             texel(size_t face, size_t mipmap, ptrdiff_t x, ptrdiff_t y) const;
+
+    /// Copies the edges of the neighbouring faces into the apron.
+    /// Call after the interior of a mip has been written.
+    void                     fillBorders(size_t mipmap);
+    void                     fillBorders();
+
+    /// u, v in [0, 1] across the face, texel centers at (i + 0.5) / faceSize.
+    Vector4f                 sampleBilinear(size_t face, size_t mipmap, float u, float v) const;
+    Vector4f                 sampleBicubic(size_t face, size_t mipmap, float u, float v) const;
+    /// Trilinear lookup in direction.
+    Vector4f                 sample(const Vector3f& direction, float lod = 0.0f) const;
+
+    /// Rebuilds mips 1..n from mip 0 with a 4x4 tent filter that reads
+    /// across the face edges through the apron.
+    void                     generateMipmaps();
+
+    /// Writes the interior of every face and mip into a cubemap image of the
+    /// same face size (any uncompressed format).
+    void                     copyTo(TextureImage& cubemap) const;
+
+    /// Face and face coordinates ([0, 1]) for a direction.
+    static size_t            faceFromDirection(const Vector3f& direction, float& u, float& v);
+    /// Unnormalized direction through face coordinates u, v ([0, 1]).
+    static Vector3f          directionFromFace(size_t face, float u, float v);
+    /// Face and edge across an edge of a face. Returns true if the neighbouring
+    /// edge runs in the opposite direction (positions are left to right or top
+    /// to bottom on each face).
+    static bool              edgeNeighbor(size_t face, size_t edge,
+                                          size_t& neighborFace, size_t& neighborEdge);
+
+  private:
+    struct Level
+    {
+        size_t               size;
+        size_t               stride;
+        size_t               offset;
+    };
+
+    void                     allocate(size_t faceSize, size_t numMipmaps, size_t border);
+
+    size_t                   mBorder;
+    std::vector<Level>       mLevels;
+    std::vector<float>       mData;
+};
+}
+
+#endif
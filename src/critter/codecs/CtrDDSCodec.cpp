@@ -711,8 +711,9 @@ typedef struct
 
     }
     //---------------------------------------------------------------------
-    Codec::DecodeResult 
-    DDSCodec::decode(DataStreamPtr& stream) const
+    void
+    DDSCodec::readHeader(DataStreamPtr& stream, DDSHeader& header, ImageData& imgData,
+                         size_t& numFaces, PixelFormat& sourceFormat, bool& decompressDXT) const
     {
         // Read 4 character code
         uint32_t fileType;
@@ -726,7 +727,6 @@ typedef struct
 
         
         // Read header in full
-        DDSHeader header;
         stream->read(&header, sizeof(DDSHeader));
 
         // Endian flip if required, all 32-bit values
@@ -770,38 +770,35 @@ typedef struct
             */
         }
 
-        ImageData* imgData = new ImageData();
-        MemoryDataStreamPtr output;
-
-        imgData->depth = 1; // (deal with volume later)
-        imgData->width = header.width;
-        imgData->height = header.height;
-        size_t numFaces = 1; // assume one face until we know otherwise
+        imgData.depth = 1; // (deal with volume later)
+        imgData.width = header.width;
+        imgData.height = header.height;
+        numFaces = 1; // assume one face until we know otherwise
 
         if (header.caps.caps1 & DDSCAPS_MIPMAP)
         {
-            imgData->num_mipmaps = static_cast<uint16_t>(header.mipMapCount - 1);
+            imgData.num_mipmaps = static_cast<uint16_t>(header.mipMapCount - 1);
         }
         else
         {
-            imgData->num_mipmaps = 0;
+            imgData.num_mipmaps = 0;
         }
-        imgData->flags = 0;
+        imgData.flags = 0;
 
-        bool decompressDXT = false;
+        decompressDXT = false;
         // Figure out basic image type
         if (header.caps.caps2 & DDSCAPS2_CUBEMAP)
         {
-            imgData->flags |= IF_CUBEMAP;
+            imgData.flags |= IF_CUBEMAP;
             numFaces = 6;
         }
         else if (header.caps.caps2 & DDSCAPS2_VOLUME)
         {
-            imgData->flags |= IF_3D_TEXTURE;
-            imgData->depth = header.depth;
+            imgData.flags |= IF_3D_TEXTURE;
+            imgData.depth = header.depth;
         }
         // Pixel format
-        PixelFormat sourceFormat = PF_UNKNOWN;
+        sourceFormat = PF_UNKNOWN;
 
         if (header.pixelFormat.flags & DDPF_FOURCC)
         {
@@ -848,11 +845,11 @@ typedef struct
                     // colour_0 <= colour_1 means transparency in DXT1
                     if (block.colour_0 <= block.colour_1)
                     {
-                        imgData->format = PF_BYTE_RGBA;
+                        imgData.format = PF_BYTE_RGBA;
                     }
                     else
                     {
-                        imgData->format = PF_BYTE_RGB;
+                        imgData.format = PF_BYTE_RGB;
                     }
                     break;
                 case PF_DXT2:
@@ -860,7 +857,7 @@ typedef struct
                 case PF_DXT4:
                 case PF_DXT5:
                     // full alpha present, formats vary only in encoding 
-                    imgData->format = PF_BYTE_RGBA;
+                    imgData.format = PF_BYTE_RGBA;
                     break;
                 default:
                     // all other cases need no special format handling
@@ -870,159 +867,194 @@ typedef struct
             else
             {
                 // Use original format
-                imgData->format = sourceFormat;
+                imgData.format = sourceFormat;
                 // Keep DXT data compressed
-                imgData->flags |= IF_COMPRESSED;
+                imgData.flags |= IF_COMPRESSED;
             }
         }
         else // not compressed
         {
             // Don't test against DDPF_RGB since greyscale DDS doesn't set this
             // just derive any other kind of format
-            imgData->format = sourceFormat;
+            imgData.format = sourceFormat;
         }
 
         // Calculate total size from number of mipmaps, faces and size
-        imgData->size = TextureImage::calculateSize(imgData->num_mipmaps, numFaces, 
-            imgData->width, imgData->height, imgData->depth, imgData->format);
-
-        // Bind output buffer
-        output.reset(new MemoryDataStream(imgData->size));
-        
-        // Now deal with the data
-        void* destPtr = output->getPtr();
-
-        // all mips for a face, then each face
-        for(size_t i = 0; i < numFaces; ++i)
-        {   
-            size_t width = imgData->width;
-            size_t height = imgData->height;
-            size_t depth = imgData->depth;
+        imgData.size = TextureImage::calculateSize(imgData.num_mipmaps, numFaces, 
+            imgData.width, imgData.height, imgData.depth, imgData.format);
+    }
+    //---------------------------------------------------------------------
+    size_t
+    DDSCodec::sourcePitch(const DDSHeader& header, const ImageData& imgData,
+                          size_t width, size_t mip) const
+    {
+        size_t dstPitch = width * PixelUtil::getNumElemBytes(imgData.format);
+        if (header.flags & DDSD_PITCH)
+        {
+            return header.sizeOrPitch >> mip;
+        }
+        // assume same as final pitch
+        return dstPitch;
+    }
+    //---------------------------------------------------------------------
+    size_t
+    DDSCodec::sourceSize(const DDSHeader& header, const ImageData& imgData, PixelFormat sourceFormat,
+                         size_t width, size_t height, size_t depth, size_t mip) const
+    {
+        if (PixelUtil::isCompressed(sourceFormat))
+        {
+            // Decompressed or not, the file holds whole blocks.
+            return PixelUtil::getMemorySize(width, height, depth, sourceFormat);
+        }
+        return sourcePitch(header, imgData, width, mip) * height * depth;
+    }
+    //---------------------------------------------------------------------
+    void
+    DDSCodec::readSurface(DataStreamPtr& stream, const DDSHeader& header, const ImageData& imgData,
+                          PixelFormat sourceFormat, bool decompressDXT,
+                          size_t width, size_t height, size_t depth, size_t mip,
+                          void*& destPtr) const
+    {
+        size_t dstPitch = width * PixelUtil::getNumElemBytes(imgData.format);
 
-            for(size_t mip = 0; mip <= imgData->num_mipmaps; ++mip)
+        if (PixelUtil::isCompressed(sourceFormat))
+        {
+            // Compressed data
+            if (decompressDXT )
             {
-                size_t dstPitch = width * PixelUtil::getNumElemBytes(imgData->format);
-
-                if (PixelUtil::isCompressed(sourceFormat))
+                DXTColorBlock col;
+                DXTInterpolatedAlphaBlock iAlpha;
+                DXTExplicitAlphaBlock eAlpha;
+                // 4x4 block of decompressed colour
+                ColorValue tempColors[16];
+                size_t destBpp = PixelUtil::getNumElemBytes(imgData.format);
+                size_t sx = std::min(width, (size_t)4);
+                size_t sy = std::min(height, (size_t)4);
+                size_t destPitchMinus4 = dstPitch - destBpp * sx;
+                // slices are done individually
+                for(size_t z = 0; z < depth; ++z)
                 {
-                    // Compressed data
-                    if (decompressDXT )
+                    // 4x4 blocks in x/y
+                    for (size_t y = 0; y < height; y += 4)
                     {
-                        DXTColorBlock col;
-                        DXTInterpolatedAlphaBlock iAlpha;
-                        DXTExplicitAlphaBlock eAlpha;
-                        // 4x4 block of decompressed colour
-                        ColorValue tempColors[16];
-                        size_t destBpp = PixelUtil::getNumElemBytes(imgData->format);
-                        size_t sx = std::min(width, (size_t)4);
-                        size_t sy = std::min(height, (size_t)4);
-                        size_t destPitchMinus4 = dstPitch - destBpp * sx;
-                        // slices are done individually
-                        for(size_t z = 0; z < depth; ++z)
+                        for (size_t x = 0; x < width; x += 4)
                         {
-                            // 4x4 blocks in x/y
-                            for (size_t y = 0; y < height; y += 4)
+                            if (sourceFormat == PF_DXT2 || 
+                                sourceFormat == PF_DXT3)
+                            {
+                                // explicit alpha
+                                stream->read(&eAlpha, sizeof(DXTExplicitAlphaBlock));
+                                flipEndian(eAlpha.alphaRow, sizeof(uint16_t), 4);
+                                unpackDXTAlpha(eAlpha, tempColors) ;
+                            }
+                            else if (sourceFormat == PF_DXT4 || 
+                                sourceFormat == PF_DXT5)
+                            {
+                                // interpolated alpha
+                                stream->read(&iAlpha, sizeof(DXTInterpolatedAlphaBlock));
+                                flipEndian(&(iAlpha.alpha_0), sizeof(uint16_t), 1);
+                                flipEndian(&(iAlpha.alpha_1), sizeof(uint16_t), 1);
+                                unpackDXTAlpha(iAlpha, tempColors) ;
+                            }
+                            // always read colour
+                            stream->read(&col, sizeof(DXTColorBlock));
+                            flipEndian(&(col.colour_0), sizeof(uint16_t), 1);
+                            flipEndian(&(col.colour_1), sizeof(uint16_t), 1);
+                            unpackDXTColor(sourceFormat, col, tempColors);
+
+                            // write 4x4 block to uncompressed version
+                            for (size_t by = 0; by < sy; ++by)
                             {
-                                for (size_t x = 0; x < width; x += 4)
+                                for (size_t bx = 0; bx < sx; ++bx)
                                 {
-                                    if (sourceFormat == PF_DXT2 || 
-                                        sourceFormat == PF_DXT3)
-                                    {
-                                        // explicit alpha
-                                        stream->read(&eAlpha, sizeof(DXTExplicitAlphaBlock));
-                                        flipEndian(eAlpha.alphaRow, sizeof(uint16_t), 4);
-                                        unpackDXTAlpha(eAlpha, tempColors) ;
-                                    }
-                                    else if (sourceFormat == PF_DXT4 || 
-                                        sourceFormat == PF_DXT5)
-                                    {
-                                        // interpolated alpha
-                                        stream->read(&iAlpha, sizeof(DXTInterpolatedAlphaBlock));
-                                        flipEndian(&(iAlpha.alpha_0), sizeof(uint16_t), 1);
-                                        flipEndian(&(iAlpha.alpha_1), sizeof(uint16_t), 1);
-                                        unpackDXTAlpha(iAlpha, tempColors) ;
-                                    }
-                                    // always read colour
-                                    stream->read(&col, sizeof(DXTColorBlock));
-                                    flipEndian(&(col.colour_0), sizeof(uint16_t), 1);
-                                    flipEndian(&(col.colour_1), sizeof(uint16_t), 1);
-                                    unpackDXTColor(sourceFormat, col, tempColors);
-
-                                    // write 4x4 block to uncompressed version
-                                    for (size_t by = 0; by < sy; ++by)
-                                    {
-                                        for (size_t bx = 0; bx < sx; ++bx)
-                                        {
-                                            PixelUtil::packColor(tempColors[by*4+bx],
-                                                imgData->format, destPtr);
-                                            destPtr = static_cast<void*>(
-                                                static_cast<uint8_t*>(destPtr) + destBpp);
-                                        }
-                                        // advance to next row
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) + destPitchMinus4);
-                                    }
-                                    // next block. Our dest pointer is 4 lines down
-                                    // from where it started
-                                    if (x + 4 >= width)
-                                    {
-                                        // Jump back to the start of the line
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) - destPitchMinus4);
-                                    }
-                                    else
-                                    {
-                                        // Jump back up 4 rows and 4 pixels to the
-                                        // right to be at the next block to the right
-                                        destPtr = static_cast<void*>(
-                                            static_cast<uint8_t*>(destPtr) - dstPitch * sy + destBpp * sx);
-
-                                    }
+                                    PixelUtil::packColor(tempColors[by*4+bx],
+                                        imgData.format, destPtr);
+                                    destPtr = static_cast<void*>(
+                                        static_cast<uint8_t*>(destPtr) + destBpp);
                                 }
+                                // advance to next row
+                                destPtr = static_cast<void*>(
+                                    static_cast<uint8_t*>(destPtr) + destPitchMinus4);
+                            }
+                            // next block. Our dest pointer is 4 lines down
+                            // from where it started
+                            if (x + 4 >= width)
+                            {
+                                // Jump back to the start of the line
+                                destPtr = static_cast<void*>(
+                                    static_cast<uint8_t*>(destPtr) - destPitchMinus4);
+                            }
+                            else
+                            {
+                                // Jump back up 4 rows and 4 pixels to the
+                                // right to be at the next block to the right
+                                destPtr = static_cast<void*>(
+                                    static_cast<uint8_t*>(destPtr) - dstPitch * sy + destBpp * sx);
+
                             }
                         }
                     }
-                    else
-                    {
-                        // load directly
-                        // DDS format lies! sizeOrPitch is not always set for DXT!!
-                        size_t dxtSize = PixelUtil::getMemorySize(width, height, depth, imgData->format);
-                        stream->read(destPtr, dxtSize);
-                        destPtr = static_cast<void*>(static_cast<uint8_t*>(destPtr) + dxtSize);
-                    }
-
                 }
-                else
-                {
-                    // Final data - trim incoming pitch
-                    size_t srcPitch;
-                    if (header.flags & DDSD_PITCH)
-                    {
-                        srcPitch = header.sizeOrPitch >> mip;
-                            // std::max((size_t)1, mip * 2);
-                    }
-                    else
-                    {
-                        // assume same as final pitch
-                        //srcPitch = header.sizeOrPitch >> mip;
-                        srcPitch = dstPitch;
-                    }
-                    assert (dstPitch <= srcPitch);
-                    long srcAdvance = static_cast<long>(srcPitch) - static_cast<long>(dstPitch);
+            }
+            else
+            {
+                // load directly
+                // DDS format lies! sizeOrPitch is not always set for DXT!!
+                size_t dxtSize = PixelUtil::getMemorySize(width, height, depth, imgData.format);
+                stream->read(destPtr, dxtSize);
+                destPtr = static_cast<void*>(static_cast<uint8_t*>(destPtr) + dxtSize);
+            }
 
-                    for (size_t z = 0; z < depth; ++z)
-                    {
-                        for (size_t y = 0; y < height; ++y)
-                        {
-                            stream->read(destPtr, dstPitch);
-                            if (srcAdvance > 0)
-                                stream->skip(srcAdvance);
+        }
+        else
+        {
+            // Final data - trim incoming pitch
+            size_t srcPitch = sourcePitch(header, imgData, width, mip);
+            assert (dstPitch <= srcPitch);
+            long srcAdvance = static_cast<long>(srcPitch) - static_cast<long>(dstPitch);
 
-                            destPtr = static_cast<void*>(static_cast<uint8_t*>(destPtr) + dstPitch);
-                        }
-                    }
+            for (size_t z = 0; z < depth; ++z)
+            {
+                for (size_t y = 0; y < height; ++y)
+                {
+                    stream->read(destPtr, dstPitch);
+                    if (srcAdvance > 0)
+                        stream->skip(srcAdvance);
+
+                    destPtr = static_cast<void*>(static_cast<uint8_t*>(destPtr) + dstPitch);
                 }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    Codec::DecodeResult 
+    DDSCodec::decode(DataStreamPtr& stream) const
+    {
+        DDSHeader header;
+        ImageData* imgData = new ImageData();
+        size_t numFaces = 1;
+        PixelFormat sourceFormat = PF_UNKNOWN;
+        bool decompressDXT = false;
+        readHeader(stream, header, *imgData, numFaces, sourceFormat, decompressDXT);
+
+        // Bind output buffer
+        MemoryDataStreamPtr output;
+        output.reset(new MemoryDataStream(imgData->size));
+        
+        // Now deal with the data
+        void* destPtr = output->getPtr();
 
+        // all mips for a face, then each face
+        for(size_t i = 0; i < numFaces; ++i)
+        {   
+            size_t width = imgData->width;
+            size_t height = imgData->height;
+            size_t depth = imgData->depth;
+
+            for(size_t mip = 0; mip <= imgData->num_mipmaps; ++mip)
+            {
+                readSurface(stream, header, *imgData, sourceFormat, decompressDXT,
+                            width, height, depth, mip, destPtr);
                 
                 /// Next mip
                 if(width!=1) width /= 2;
@@ -1036,9 +1068,90 @@ typedef struct
         ret.first = output;
         ret.second = CodecDataPtr(imgData);
         return ret;
-        
+    }
+    //---------------------------------------------------------------------
+    bool
+    DDSCodec::decodeHeader(DataStreamPtr& stream, ImageData& imageData) const
+    {
+        DDSHeader header;
+        size_t numFaces = 1;
+        PixelFormat sourceFormat = PF_UNKNOWN;
+        bool decompressDXT = false;
+        try
+        {
+            readHeader(stream, header, imageData, numFaces, sourceFormat, decompressDXT);
+        }
+        catch (const std::exception& e)
+        {
+            LOG("Failed to read DDS header " << e.what());
+            return false;
+        }
+        return true;
+    }
+    //---------------------------------------------------------------------
+    bool
+    DDSCodec::decodeLevels(DataStreamPtr& stream, size_t finestMip, size_t coarsestMip,
+                           const LevelCallback& callback) const
+    {
+        DDSHeader header;
+        ImageData imgData;
+        size_t numFaces = 1;
+        PixelFormat sourceFormat = PF_UNKNOWN;
+        bool decompressDXT = false;
+        try
+        {
+            readHeader(stream, header, imgData, numFaces, sourceFormat, decompressDXT);
+        }
+        catch (const std::exception& e)
+        {
+            LOG("Failed to read DDS header " << e.what());
+            return false;
+        }
+
+        if (imgData.flags & IF_3D_TEXTURE)
+        {
+            LOG("Volume textures cannot be decoded level by level");
+            return false;
+        }
+
+        // Surfaces are stored all mips of a face, then each face, so the
+        // offset of every level is known before anything is read.
+        size_t levelCount = size_t(imgData.num_mipmaps) + 1;
+        std::vector<size_t> levelOffsets(levelCount);
+        size_t faceStride = 0;
+        for (size_t mip = 0; mip < levelCount; mip++)
+        {
+            levelOffsets[mip] = faceStride;
+            faceStride += sourceSize(header, imgData, sourceFormat, 
+                                     std::max(imgData.width >> mip, size_t(1)), 
+                                     std::max(imgData.height >> mip, size_t(1)), 
+                                     1, mip);
+        }
 
+        size_t dataOffset = stream->tell();
+        coarsestMip = std::min(coarsestMip, levelCount - 1);
+        for (size_t mip = coarsestMip + 1; mip-- > finestMip; )
+        {
+            size_t width = std::max(imgData.width >> mip, size_t(1));
+            size_t height = std::max(imgData.height >> mip, size_t(1));
+
+            TextureImagePtr level(new TextureImage());
+            level->create(Ctr::Vector2i(int32_t(width), int32_t(height)), imgData.format, 1, 
+                          imgData.flags & (IF_CUBEMAP | IF_COMPRESSED), false);
+            for (size_t face = 0; face < numFaces; face++)
+            {
+                stream->seek(dataOffset + face * faceStride + levelOffsets[mip]);
+                void* destPtr = level->getPixelBox(face, 0).data;
+                readSurface(stream, header, imgData, sourceFormat, decompressDXT,
+                            width, height, 1, mip, destPtr);
+            }
 
+            if (!callback(imgData, mip, level))
+            {
+                break;
+            }
+        }
+        return true;
     }
     //---------------------------------------------------------------------    
     std::string DDSCodec::getType() const 
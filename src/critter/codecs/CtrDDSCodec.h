@@ -70,10 +70,13 @@ THE SOFTWARE.
 #define BB_DDS_CODEC
 
 #include <CtrImageCodec.h>
+#include <CtrTextureImage.h>
+#include <functional>
 
 namespace Ctr
 {
 // Forward declarations
+struct DDSHeader;
 struct DXTColorBlock;
 struct DXTExplicitAlphaBlock;
 struct DXTInterpolatedAlphaBlock;
@@ -102,9 +105,30 @@ class DDSCodec : public ImageCodec
     /// Unpack DXT alphas into array of 16 colour values
     void unpackDXTAlpha(const DXTInterpolatedAlphaBlock& block, ColorValue* pCol) const;
 
+    /// Read and validate the headers, leaving the stream at the first surface
+    void readHeader(DataStreamPtr& stream, DDSHeader& header, ImageData& imgData,
+                    size_t& numFaces, PixelFormat& sourceFormat, bool& decompressDXT) const;
+    /// Row pitch of a surface as stored in the file
+    size_t sourcePitch(const DDSHeader& header, const ImageData& imgData,
+                       size_t width, size_t mip) const;
+    /// Size of a surface as stored in the file
+    size_t sourceSize(const DDSHeader& header, const ImageData& imgData, PixelFormat sourceFormat,
+                      size_t width, size_t height, size_t depth, size_t mip) const;
+    /// Read one surface into destPtr and advance it past the decoded data
+    void readSurface(DataStreamPtr& stream, const DDSHeader& header, const ImageData& imgData,
+                     PixelFormat sourceFormat, bool decompressDXT,
+                     size_t width, size_t height, size_t depth, size_t mip,
+                     void*& destPtr) const;
+
     /// Single registered codec instance
     static DDSCodec* msInstance;
   public:
+    /** Receives every face of a single mip level, as a one level image.
+        Returning false stops the decode.
+    */
+    typedef std::function<bool (const ImageData& header, size_t mip, 
+                                const TextureImagePtr& level)> LevelCallback;
+
     DDSCodec();
     virtual ~DDSCodec() { }
 
@@ -114,6 +138,15 @@ class DDSCodec : public ImageCodec
     void codeToFile(MemoryDataStreamPtr& input, const std::string& outFileName, CodecDataPtr& pData) const;
     /// @copydoc Codec::decode
     DecodeResult decode(DataStreamPtr& input) const;
+    /// Read only the headers, describing the whole chain without any surfaces
+    bool decodeHeader(DataStreamPtr& input, ImageData& imageData) const;
+    /** Decode levels coarsestMip to finestMip one at a time, smallest first.
+    @remarks
+        The mip tail can be shown before the large levels have been read,
+        the stream must be seekable. Volume textures are not supported.
+    */
+    bool decodeLevels(DataStreamPtr& input, size_t finestMip, size_t coarsestMip,
+                      const LevelCallback& callback) const;
     /// @copydoc Codec::magicNumberToFileExt
     std::string magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const;
     
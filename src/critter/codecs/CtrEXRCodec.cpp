@@ -0,0 +1,1049 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrEXRCodec.h>
+#include <CtrBitwise.h>
+#include <CtrLog.h>
+#include <zlib.h>
+#include <ppl.h>
+#include <atomic>
+
+namespace Ctr
+{
+namespace
+{
+const uint32_t EXR_MAGIC = 20000630;
+const uint32_t EXR_TILED_FLAG = 0x200;
+const uint32_t EXR_DEEP_FLAG = 0x800;
+const uint32_t EXR_MULTIPART_FLAG = 0x1000;
+
+enum ExrCompression
+{
+    EXR_NO_COMPRESSION = 0,
+    EXR_RLE_COMPRESSION = 1,
+    EXR_ZIPS_COMPRESSION = 2,
+    EXR_ZIP_COMPRESSION = 3,
+    EXR_PIZ_COMPRESSION = 4
+};
+
+enum ExrPixelType
+{
+    EXR_UINT = 0,
+    EXR_HALF = 1,
+    EXR_FLOAT = 2
+};
+
+struct ExrChannel
+{
+    std::string                name;
+    int32_t                    pixelType;
+    size_t                     byteSize;
+    // Output component, -1 to skip. Y is written to RGB.
+    int32_t                    component;
+    bool                       luminance;
+};
+
+// Uncompressed chunk rectangle, relative to the data window.
+struct ExrChunk
+{
+    const uint8_t*             data;
+    size_t                     dataSize;
+    size_t                     x;
+    size_t                     y;
+    size_t                     width;
+    size_t                     height;
+};
+
+inline uint32_t
+readU32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline int32_t
+readI32(const uint8_t* data)
+{
+    int32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint64_t
+readU64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint16_t
+readU16(const uint8_t* data)
+{
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+const uint8_t*
+encodedData(DataStreamPtr& input, std::vector<uint8_t>& storage, size_t& size)
+{
+    if (MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(input.get()))
+    {
+        size = memStream->size() - memStream->tell();
+        return memStream->getPtr() + memStream->tell();
+    }
+
+    storage.resize(input->size() - input->tell());
+    size = input->read(storage.data(), storage.size());
+    return storage.data();
+}
+
+size_t
+linesPerChunk(int32_t compression)
+{
+    switch (compression)
+    {
+        case EXR_ZIP_COMPRESSION:
+            return 16;
+        case EXR_PIZ_COMPRESSION:
+            return 32;
+        default:
+            return 1;
+    }
+}
+
+//---------------------------------------------------------------------
+// ZIP and RLE store bytes split into two halves and delta encoded.
+//---------------------------------------------------------------------
+void
+reconstructBytes(uint8_t* tmp, size_t size, uint8_t* dst)
+{
+    for (size_t i = 1; i < size; i++)
+    {
+        tmp[i] = uint8_t(tmp[i-1] + tmp[i] - 128);
+    }
+
+    const uint8_t* t1 = tmp;
+    const uint8_t* t2 = tmp + (size + 1) / 2;
+    uint8_t* dstEnd = dst + size;
+    while (dst < dstEnd)
+    {
+        *dst++ = *t1++;
+        if (dst < dstEnd)
+            *dst++ = *t2++;
+    }
+}
+
+bool
+zipUncompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, std::vector<uint8_t>& tmp)
+{
+    tmp.resize(dstSize);
+    uLongf outSize = uLongf(dstSize);
+    if (uncompress(tmp.data(), &outSize, src, uLong(srcSize)) != Z_OK || outSize != dstSize)
+        return false;
+    reconstructBytes(tmp.data(), dstSize, dst);
+    return true;
+}
+
+bool
+rleUncompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, std::vector<uint8_t>& tmp)
+{
+    tmp.resize(dstSize);
+    const uint8_t* srcEnd = src + srcSize;
+    uint8_t* out = tmp.data();
+    uint8_t* outEnd = out + dstSize;
+    while (src < srcEnd)
+    {
+        int count = int(int8_t(*src++));
+        if (count < 0)
+        {
+            count = -count;
+            if (out + count > outEnd || src + count > srcEnd)
+                return false;
+            memcpy(out, src, count);
+            out += count;
+            src += count;
+        }
+        else
+        {
+            if (out + count + 1 > outEnd || src >= srcEnd)
+                return false;
+            memset(out, *src++, count + 1);
+            out += count + 1;
+        }
+    }
+    if (out != outEnd)
+        return false;
+    reconstructBytes(tmp.data(), dstSize, dst);
+    return true;
+}
+
+//---------------------------------------------------------------------
+// PIZ: a bitmap of used 16 bit values, a Huffman coded stream of
+// wavelet coefficients, and a per channel Haar wavelet.
+// Follows the reference implementation (ImfPizCompressor, ImfHuf, ImfWav).
+//---------------------------------------------------------------------
+const int HUF_ENCBITS = 16;
+const int HUF_DECBITS = 14;
+const int HUF_ENCSIZE = (1 << HUF_ENCBITS) + 1;
+const int HUF_DECSIZE = 1 << HUF_DECBITS;
+const int HUF_DECMASK = HUF_DECSIZE - 1;
+const int SHORT_ZEROCODE_RUN = 59;
+const int LONG_ZEROCODE_RUN = 63;
+const int SHORTEST_LONG_RUN = 2 + LONG_ZEROCODE_RUN - SHORT_ZEROCODE_RUN;
+const int USHORT_RANGE = 1 << 16;
+const int BITMAP_SIZE = USHORT_RANGE >> 3;
+
+struct HufDec
+{
+    int32_t                    len;
+    int32_t                    lit;
+    // Index into the long code lists, -1 if none.
+    int32_t                    longCodes;
+};
+
+inline int
+hufLength(uint64_t code)
+{
+    return int(code & 63);
+}
+
+inline uint64_t
+hufCode(uint64_t code)
+{
+    return code >> 6;
+}
+
+inline uint64_t
+getBits(int bitCount, uint64_t& c, int& lc, const uint8_t*& in)
+{
+    while (lc < bitCount)
+    {
+        c = (c << 8) | *in++;
+        lc += 8;
+    }
+    lc -= bitCount;
+    return (c >> lc) & ((uint64_t(1) << bitCount) - 1);
+}
+
+void
+hufCanonicalCodeTable(uint64_t* hcode)
+{
+    uint64_t n[59];
+    memset(n, 0, sizeof(n));
+    for (int i = 0; i < HUF_ENCSIZE; i++)
+        n[hcode[i]] += 1;
+
+    uint64_t c = 0;
+    for (int i = 58; i > 0; --i)
+    {
+        uint64_t nc = (c + n[i]) >> 1;
+        n[i] = c;
+        c = nc;
+    }
+
+    for (int i = 0; i < HUF_ENCSIZE; i++)
+    {
+        int l = int(hcode[i]);
+        if (l > 0)
+            hcode[i] = l | (n[l]++ << 6);
+    }
+}
+
+bool
+hufUnpackEncTable(const uint8_t*& in, size_t size, int im, int iM, uint64_t* hcode)
+{
+    const uint8_t* p = in;
+    uint64_t c = 0;
+    int lc = 0;
+    for (; im <= iM; im++)
+    {
+        if (size_t(p - in) > size)
+            return false;
+
+        uint64_t l = hcode[im] = getBits(6, c, lc, p);
+        if (l >= SHORT_ZEROCODE_RUN)
+        {
+            int zerun = l == LONG_ZEROCODE_RUN ?
+                int(getBits(8, c, lc, p)) + SHORTEST_LONG_RUN :
+                int(l) - SHORT_ZEROCODE_RUN + 2;
+            if (im + zerun > iM + 1)
+                return false;
+            while (zerun--)
+                hcode[im++] = 0;
+            im--;
+        }
+    }
+    in = p;
+    hufCanonicalCodeTable(hcode);
+    return true;
+}
+
+bool
+hufBuildDecTable(const uint64_t* hcode, int im, int iM, HufDec* hdecod,
+                 std::vector<std::vector<int32_t> >& longCodes)
+{
+    for (; im <= iM; im++)
+    {
+        uint64_t c = hufCode(hcode[im]);
+        int l = hufLength(hcode[im]);
+        if (c >> l)
+            return false;
+
+        if (l > HUF_DECBITS)
+        {
+            HufDec* pl = hdecod + (c >> (l - HUF_DECBITS));
+            if (pl->len)
+                return false;
+            if (pl->longCodes < 0)
+            {
+                pl->longCodes = int32_t(longCodes.size());
+                longCodes.push_back(std::vector<int32_t>());
+            }
+            longCodes[pl->longCodes].push_back(im);
+            pl->lit++;
+        }
+        else if (l)
+        {
+            HufDec* pl = hdecod + (c << (HUF_DECBITS - l));
+            for (uint64_t i = uint64_t(1) << (HUF_DECBITS - l); i > 0; i--, pl++)
+            {
+                if (pl->len || pl->longCodes >= 0)
+                    return false;
+                pl->len = l;
+                pl->lit = im;
+            }
+        }
+    }
+    return true;
+}
+
+inline bool
+hufGetCode(int po, int rlc, uint64_t& c, int& lc, const uint8_t*& in,
+           uint16_t*& out, uint16_t* outBegin, uint16_t* outEnd)
+{
+    if (po == rlc)
+    {
+        if (lc < 8)
+        {
+            c = (c << 8) | *in++;
+            lc += 8;
+        }
+        lc -= 8;
+        uint8_t cs = uint8_t(c >> lc);
+        if (out + cs > outEnd || out == outBegin)
+            return false;
+        uint16_t s = out[-1];
+        while (cs-- > 0)
+            *out++ = s;
+    }
+    else if (out < outEnd)
+    {
+        *out++ = uint16_t(po);
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool
+hufDecode(const uint64_t* hcode, const HufDec* hdecod,
+          const std::vector<std::vector<int32_t> >& longCodes,
+          const uint8_t* in, int ni, int rlc, int no, uint16_t* out)
+{
+    uint64_t c = 0;
+    int lc = 0;
+    uint16_t* outBegin = out;
+    uint16_t* outEnd = out + no;
+    const uint8_t* ie = in + (ni + 7) / 8;
+
+    while (in < ie)
+    {
+        c = (c << 8) | *in++;
+        lc += 8;
+
+        while (lc >= HUF_DECBITS)
+        {
+            const HufDec& pl = hdecod[(c >> (lc - HUF_DECBITS)) & HUF_DECMASK];
+            if (pl.len)
+            {
+                lc -= pl.len;
+                if (!hufGetCode(pl.lit, rlc, c, lc, in, out, outBegin, outEnd))
+                    return false;
+            }
+            else
+            {
+                if (pl.longCodes < 0)
+                    return false;
+
+                const std::vector<int32_t>& codes = longCodes[pl.longCodes];
+                size_t j = 0;
+                for (; j < codes.size(); j++)
+                {
+                    int l = hufLength(hcode[codes[j]]);
+                    while (lc < l && in < ie)
+                    {
+                        c = (c << 8) | *in++;
+                        lc += 8;
+                    }
+                    if (lc >= l && hufCode(hcode[codes[j]]) == ((c >> (lc - l)) & ((uint64_t(1) << l) - 1)))
+                    {
+                        lc -= l;
+                        if (!hufGetCode(codes[j], rlc, c, lc, in, out, outBegin, outEnd))
+                            return false;
+                        break;
+                    }
+                }
+                if (j == codes.size())
+                    return false;
+            }
+        }
+    }
+
+    int i = (8 - ni) & 7;
+    c >>= i;
+    lc -= i;
+    while (lc > 0)
+    {
+        const HufDec& pl = hdecod[(c << (HUF_DECBITS - lc)) & HUF_DECMASK];
+        if (!pl.len)
+            return false;
+        lc -= pl.len;
+        if (!hufGetCode(pl.lit, rlc, c, lc, in, out, outBegin, outEnd))
+            return false;
+    }
+    return out - outBegin == no;
+}
+
+bool
+hufUncompress(const uint8_t* compressed, size_t compressedSize, uint16_t* raw, size_t rawSize)
+{
+    if (compressedSize == 0)
+        return rawSize == 0;
+    if (compressedSize < 20)
+        return false;
+
+    int im = int(readU32(compressed));
+    int iM = int(readU32(compressed + 4));
+    int bitCount = int(readU32(compressed + 12));
+    if (im < 0 || im >= HUF_ENCSIZE || iM < 0 || iM >= HUF_ENCSIZE)
+        return false;
+
+    const uint8_t* ptr = compressed + 20;
+    std::vector<uint64_t> freq(HUF_ENCSIZE, 0);
+    if (!hufUnpackEncTable(ptr, compressedSize - (ptr - compressed), im, iM, freq.data()))
+        return false;
+    if (bitCount < 0 || size_t(bitCount) > 8 * (compressedSize - (ptr - compressed)))
+        return false;
+
+    HufDec empty = { 0, 0, -1 };
+    std::vector<HufDec> hdec(HUF_DECSIZE, empty);
+    std::vector<std::vector<int32_t> > longCodes;
+    if (!hufBuildDecTable(freq.data(), im, iM, hdec.data(), longCodes))
+        return false;
+
+    return hufDecode(freq.data(), hdec.data(), longCodes, ptr, bitCount, iM, int(rawSize), raw);
+}
+
+inline void
+wdec14(uint16_t l, uint16_t h, uint16_t& a, uint16_t& b)
+{
+    int16_t ls = int16_t(l);
+    int16_t hs = int16_t(h);
+    int hi = hs;
+    int ai = ls + (hi & 1) + (hi >> 1);
+    a = uint16_t(int16_t(ai));
+    b = uint16_t(int16_t(ai - hi));
+}
+
+inline void
+wdec16(uint16_t l, uint16_t h, uint16_t& a, uint16_t& b)
+{
+    const int A_OFFSET = 1 << 15;
+    const int MOD_MASK = (1 << 16) - 1;
+    int m = l;
+    int d = h;
+    int bb = (m - (d >> 1)) & MOD_MASK;
+    int aa = (d + bb - A_OFFSET) & MOD_MASK;
+    b = uint16_t(bb);
+    a = uint16_t(aa);
+}
+
+inline void
+wdec(bool w14, uint16_t l, uint16_t h, uint16_t& a, uint16_t& b)
+{
+    if (w14)
+        wdec14(l, h, a, b);
+    else
+        wdec16(l, h, a, b);
+}
+
+void
+wav2Decode(uint16_t* in, int nx, int ox, int ny, int oy, uint16_t mx)
+{
+    bool w14 = mx < (1 << 14);
+    int n = nx > ny ? ny : nx;
+    int p = 1;
+    while (p <= n)
+        p <<= 1;
+    p >>= 1;
+    int p2 = p;
+    p >>= 1;
+
+    while (p >= 1)
+    {
+        uint16_t* py = in;
+        uint16_t* ey = in + oy * (ny - p2);
+        int oy1 = oy * p;
+        int oy2 = oy * p2;
+        int ox1 = ox * p;
+        int ox2 = ox * p2;
+        uint16_t i00, i01, i10, i11;
+
+        for (; py <= ey; py += oy2)
+        {
+            uint16_t* px = py;
+            uint16_t* ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2)
+            {
+                uint16_t* p01 = px + ox1;
+                uint16_t* p10 = px + oy1;
+                uint16_t* p11 = p10 + ox1;
+                wdec(w14, *px, *p10, i00, i10);
+                wdec(w14, *p01, *p11, i01, i11);
+                wdec(w14, i00, i01, *px, *p01);
+                wdec(w14, i10, i11, *p10, *p11);
+            }
+
+            if (nx & p)
+            {
+                uint16_t* p10 = px + oy1;
+                wdec(w14, *px, *p10, i00, *p10);
+                *px = i00;
+            }
+        }
+
+        if (ny & p)
+        {
+            uint16_t* px = py;
+            uint16_t* ex = py + ox * (nx - p2);
+            for (; px <= ex; px += ox2)
+            {
+                uint16_t* p01 = px + ox1;
+                wdec(w14, *px, *p01, i00, *p01);
+                *px = i00;
+            }
+        }
+
+        p2 = p;
+        p >>= 1;
+    }
+}
+
+bool
+pizUncompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize,
+              const std::vector<ExrChannel>& channels, size_t width, size_t height)
+{
+    if (srcSize < 4)
+        return false;
+
+    std::vector<uint8_t> bitmap(BITMAP_SIZE, 0);
+    const uint8_t* srcEnd = src + srcSize;
+    uint16_t minNonZero = readU16(src);
+    uint16_t maxNonZero = readU16(src + 2);
+    src += 4;
+    if (maxNonZero >= BITMAP_SIZE)
+        return false;
+    if (minNonZero <= maxNonZero)
+    {
+        size_t count = maxNonZero - minNonZero + 1;
+        if (src + count > srcEnd)
+            return false;
+        memcpy(&bitmap[minNonZero], src, count);
+        src += count;
+    }
+
+    // Reverse lookup, compact code -> original 16 bit value.
+    std::vector<uint16_t> lut(USHORT_RANGE, 0);
+    size_t k = 0;
+    for (int i = 0; i < USHORT_RANGE; i++)
+    {
+        if (i == 0 || (bitmap[i >> 3] & (1 << (i & 7))))
+            lut[k++] = uint16_t(i);
+    }
+    uint16_t maxValue = uint16_t(k - 1);
+
+    if (src + 4 > srcEnd)
+        return false;
+    size_t length = size_t(readI32(src));
+    src += 4;
+    if (src + length > srcEnd)
+        return false;
+
+    std::vector<uint16_t> tmp(dstSize / 2);
+    if (!hufUncompress(src, length, tmp.data(), tmp.size()))
+        return false;
+
+    // Channels are stored as planes, one wavelet per 16 bit word of a pixel.
+    uint16_t* plane = tmp.data();
+    std::vector<uint16_t*> planes;
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        int words = int(channels[c].byteSize / 2);
+        for (int j = 0; j < words; j++)
+        {
+            wav2Decode(plane + j, int(width), words, int(height), int(width) * words, maxValue);
+        }
+        planes.push_back(plane);
+        plane += width * height * words;
+    }
+
+    for (size_t i = 0; i < tmp.size(); i++)
+        tmp[i] = lut[tmp[i]];
+
+    // Back to line interleaved.
+    uint8_t* out = dst;
+    for (size_t y = 0; y < height; y++)
+    {
+        for (size_t c = 0; c < channels.size(); c++)
+        {
+            size_t words = width * (channels[c].byteSize / 2);
+            memcpy(out, planes[c], words * 2);
+            planes[c] += words;
+            out += words * 2;
+        }
+    }
+    return true;
+}
+
+inline float
+channelValue(const uint8_t* src, int32_t pixelType)
+{
+    switch (pixelType)
+    {
+        case EXR_HALF:
+            return Bitwise::halfToFloat(readU16(src));
+        case EXR_FLOAT:
+        {
+            float value;
+            memcpy(&value, src, sizeof(value));
+            return value;
+        }
+        default:
+            return float(readU32(src));
+    }
+}
+}
+
+//---------------------------------------------------------------------
+EXRCodec* EXRCodec::msInstance = 0;
+Codec* EXRCodec::msEncoder = 0;
+bool EXRCodec::_halfFloat = false;
+//---------------------------------------------------------------------
+void EXRCodec::startup(void)
+{
+    if (!msInstance)
+    {
+        LOG("EXR codec registering");
+
+        msInstance = new EXRCodec();
+        if (Codec::isCodecRegistered(msInstance->getType()))
+        {
+            msEncoder = Codec::getCodec(msInstance->getType());
+            Codec::unRegisterCodec(msEncoder);
+        }
+        Codec::registerCodec(msInstance);
+    }
+}
+//---------------------------------------------------------------------
+void EXRCodec::shutdown(void)
+{
+    if(msInstance)
+    {
+        Codec::unRegisterCodec(msInstance);
+        if (msEncoder)
+        {
+            Codec::registerCodec(msEncoder);
+            msEncoder = 0;
+        }
+        delete msInstance;
+        msInstance = 0;
+    }
+}
+//---------------------------------------------------------------------
+EXRCodec::EXRCodec():
+    mType("exr")
+{ 
+}
+//---------------------------------------------------------------------
+DataStreamPtr EXRCodec::code(MemoryDataStreamPtr& input, Codec::CodecDataPtr& pData) const
+{        
+    if (!msEncoder)
+        throw (std::exception("EXR encoding not supported EXRCodec::code" ));
+    return msEncoder->code(input, pData);
+}
+//---------------------------------------------------------------------
+void EXRCodec::codeToFile(MemoryDataStreamPtr& input, 
+                          const std::string& outFileName, 
+                          Codec::CodecDataPtr& pData) const
+{
+    if (!msEncoder)
+        throw (std::exception("EXR encoding not supported EXRCodec::codeToFile" ));
+    msEncoder->codeToFile(input, outFileName, pData);
+}
+//---------------------------------------------------------------------
+Codec::DecodeResult EXRCodec::decode(DataStreamPtr& input) const
+{
+    std::vector<uint8_t> storage;
+    size_t size = 0;
+    const uint8_t* data = encodedData(input, storage, size);
+    const uint8_t* end = data + size;
+
+    if (size < 8 || readU32(data) != EXR_MAGIC)
+    {
+        throw(std::exception("Not an OpenEXR file EXRCodec::decode"));
+    }
+
+    uint32_t version = readU32(data + 4);
+    if (version & (EXR_DEEP_FLAG | EXR_MULTIPART_FLAG))
+    {
+        throw(std::exception("Deep and multi part OpenEXR files are not supported EXRCodec::decode"));
+    }
+    bool tiled = (version & EXR_TILED_FLAG) != 0;
+
+    // Header attributes, terminated by an empty name.
+    std::vector<ExrChannel> channels;
+    int32_t compression = -1;
+    int32_t dataWindow[4] = { 0, 0, -1, -1 };
+    uint32_t tileWidth = 0;
+    uint32_t tileHeight = 0;
+    const uint8_t* p = data + 8;
+    for (;;)
+    {
+        const uint8_t* nameEnd = (const uint8_t*)memchr(p, 0, end - p);
+        if (!nameEnd)
+            throw(std::exception("Truncated OpenEXR header EXRCodec::decode"));
+        std::string name((const char*)p, nameEnd - p);
+        p = nameEnd + 1;
+        if (name.empty())
+            break;
+
+        const uint8_t* typeEnd = (const uint8_t*)memchr(p, 0, end - p);
+        if (!typeEnd || typeEnd + 5 > end)
+            throw(std::exception("Truncated OpenEXR header EXRCodec::decode"));
+        std::string type((const char*)p, typeEnd - p);
+        p = typeEnd + 1;
+        size_t attributeSize = readU32(p);
+        p += 4;
+        if (p + attributeSize > end)
+            throw(std::exception("Truncated OpenEXR header EXRCodec::decode"));
+        const uint8_t* value = p;
+        p += attributeSize;
+
+        if (name == "channels" && type == "chlist")
+        {
+            const uint8_t* c = value;
+            while (c < p && *c)
+            {
+                const uint8_t* channelEnd = (const uint8_t*)memchr(c, 0, p - c);
+                if (!channelEnd || channelEnd + 17 > p)
+                    throw(std::exception("Corrupt OpenEXR channel list EXRCodec::decode"));
+
+                ExrChannel channel;
+                channel.name.assign((const char*)c, channelEnd - c);
+                c = channelEnd + 1;
+                channel.pixelType = readI32(c);
+                channel.byteSize = channel.pixelType == EXR_HALF ? 2 : 4;
+                if (readI32(c + 8) != 1 || readI32(c + 12) != 1)
+                    throw(std::exception("Subsampled OpenEXR channels are not supported EXRCodec::decode"));
+                c += 16;
+
+                channel.luminance = channel.name == "Y";
+                channel.component = channel.name == "R" ? 0 :
+                                    channel.name == "G" ? 1 :
+                                    channel.name == "B" ? 2 :
+                                    channel.name == "A" ? 3 : -1;
+                channels.push_back(channel);
+            }
+        }
+        else if (name == "compression" && attributeSize >= 1)
+        {
+            compression = value[0];
+        }
+        else if (name == "dataWindow" && attributeSize >= 16)
+        {
+            for (int i = 0; i < 4; i++)
+                dataWindow[i] = readI32(value + i * 4);
+        }
+        else if (name == "tiles" && attributeSize >= 9)
+        {
+            tileWidth = readU32(value);
+            tileHeight = readU32(value + 4);
+        }
+    }
+
+    if (compression < EXR_NO_COMPRESSION || compression > EXR_PIZ_COMPRESSION)
+    {
+        throw(std::exception("Unsupported OpenEXR compression EXRCodec::decode"));
+    }
+    if (channels.empty() || dataWindow[2] < dataWindow[0] || dataWindow[3] < dataWindow[1] ||
+        (tiled && (tileWidth == 0 || tileHeight == 0)))
+    {
+        throw(std::exception("Corrupt OpenEXR header EXRCodec::decode"));
+    }
+
+    ImageData* imgData = new ImageData();
+    imgData->depth = 1;
+    imgData->width = size_t(dataWindow[2] - dataWindow[0]) + 1;
+    imgData->height = size_t(dataWindow[3] - dataWindow[1]) + 1;
+    imgData->num_mipmaps = 0;
+    imgData->flags = 0;
+    imgData->format = _halfFloat ? PF_FLOAT16_RGBA : PF_FLOAT32_RGBA;
+
+    size_t pixelSize = PixelUtil::getNumElemBytes(imgData->format);
+    size_t dstPitch = imgData->width * pixelSize;
+    imgData->size = dstPitch * imgData->height;
+
+    // Offset table. Tiled images only read level 0, which comes first.
+    size_t chunkCount = 0;
+    if (tiled)
+    {
+        chunkCount = ((imgData->width + tileWidth - 1) / tileWidth) *
+                     ((imgData->height + tileHeight - 1) / tileHeight);
+    }
+    else
+    {
+        chunkCount = (imgData->height + linesPerChunk(compression) - 1) / linesPerChunk(compression);
+    }
+    if (p + chunkCount * 8 > end)
+    {
+        delete imgData;
+        throw(std::exception("Truncated OpenEXR offset table EXRCodec::decode"));
+    }
+    const uint8_t* offsets = p;
+
+    MemoryDataStreamPtr output(new MemoryDataStream(imgData->size));
+    uint8_t* dstData = output->getPtr();
+
+    // Missing channels default to black, opaque.
+    bool halfFloat = _halfFloat;
+    bool hasAlpha = false;
+    for (size_t c = 0; c < channels.size(); c++)
+        hasAlpha |= channels[c].component == 3;
+    if (halfFloat)
+    {
+        uint16_t defaultPixel[4] = { 0, 0, 0, uint16_t(hasAlpha ? 0 : 0x3c00) };
+        for (size_t i = 0; i < imgData->width * imgData->height; i++)
+            memcpy(dstData + i * pixelSize, defaultPixel, pixelSize);
+    }
+    else
+    {
+        float defaultPixel[4] = { 0.0f, 0.0f, 0.0f, hasAlpha ? 0.0f : 1.0f };
+        for (size_t i = 0; i < imgData->width * imgData->height; i++)
+            memcpy(dstData + i * pixelSize, defaultPixel, pixelSize);
+    }
+
+    size_t pixelBytes = 0;
+    for (size_t c = 0; c < channels.size(); c++)
+        pixelBytes += channels[c].byteSize;
+
+    std::atomic<bool> corrupt(false);
+    concurrency::parallel_for(size_t(0), chunkCount, [&](size_t chunkId)
+    {
+        uint64_t chunkOffset = readU64(offsets + chunkId * 8);
+        const uint8_t* chunkData = data + chunkOffset;
+
+        ExrChunk chunk;
+        if (tiled)
+        {
+            if (chunkOffset + 20 > size)
+            {
+                corrupt = true;
+                return;
+            }
+            int32_t tileX = readI32(chunkData);
+            int32_t tileY = readI32(chunkData + 4);
+            if (tileX < 0 || tileY < 0 || readI32(chunkData + 8) != 0 || readI32(chunkData + 12) != 0)
+            {
+                corrupt = true;
+                return;
+            }
+            chunk.x = size_t(tileX) * tileWidth;
+            chunk.y = size_t(tileY) * tileHeight;
+            chunk.dataSize = readU32(chunkData + 16);
+            chunk.data = chunkData + 20;
+            if (chunk.x >= imgData->width || chunk.y >= imgData->height)
+            {
+                corrupt = true;
+                return;
+            }
+            chunk.width = std::min(size_t(tileWidth), imgData->width - chunk.x);
+            chunk.height = std::min(size_t(tileHeight), imgData->height - chunk.y);
+        }
+        else
+        {
+            if (chunkOffset + 8 > size)
+            {
+                corrupt = true;
+                return;
+            }
+            int32_t y = readI32(chunkData) - dataWindow[1];
+            if (y < 0 || size_t(y) >= imgData->height)
+            {
+                corrupt = true;
+                return;
+            }
+            chunk.x = 0;
+            chunk.y = size_t(y);
+            chunk.dataSize = readU32(chunkData + 4);
+            chunk.data = chunkData + 8;
+            chunk.width = imgData->width;
+            chunk.height = std::min(linesPerChunk(compression), imgData->height - chunk.y);
+        }
+        if (chunk.data + chunk.dataSize > end)
+        {
+            corrupt = true;
+            return;
+        }
+
+        // Chunks that do not compress are stored as is.
+        size_t rawSize = chunk.width * chunk.height * pixelBytes;
+        const uint8_t* raw = chunk.data;
+        std::vector<uint8_t> rawStorage;
+        if (chunk.dataSize < rawSize)
+        {
+            std::vector<uint8_t> tmp;
+            rawStorage.resize(rawSize);
+            bool decoded = false;
+            switch (compression)
+            {
+                case EXR_RLE_COMPRESSION:
+                    decoded = rleUncompress(chunk.data, chunk.dataSize, rawStorage.data(), rawSize, tmp);
+                    break;
+                case EXR_ZIPS_COMPRESSION:
+                case EXR_ZIP_COMPRESSION:
+                    decoded = zipUncompress(chunk.data, chunk.dataSize, rawStorage.data(), rawSize, tmp);
+                    break;
+                case EXR_PIZ_COMPRESSION:
+                    decoded = pizUncompress(chunk.data, chunk.dataSize, rawStorage.data(), rawSize,
+                                            channels, chunk.width, chunk.height);
+                    break;
+            }
+            if (!decoded)
+            {
+                corrupt = true;
+                return;
+            }
+            raw = rawStorage.data();
+        }
+        else if (chunk.dataSize != rawSize)
+        {
+            corrupt = true;
+            return;
+        }
+
+        // Each line holds every channel in turn, channels sorted by name.
+        for (size_t y = 0; y < chunk.height; y++)
+        {
+            uint8_t* dstRow = dstData + (chunk.y + y) * dstPitch + chunk.x * pixelSize;
+            for (size_t c = 0; c < channels.size(); c++)
+            {
+                const ExrChannel& channel = channels[c];
+                const uint8_t* src = raw;
+                raw += chunk.width * channel.byteSize;
+                if (channel.component < 0 && !channel.luminance)
+                    continue;
+
+                int32_t firstComponent = channel.luminance ? 0 : channel.component;
+                int32_t lastComponent = channel.luminance ? 2 : channel.component;
+                for (size_t x = 0; x < chunk.width; x++, src += channel.byteSize)
+                {
+                    if (halfFloat)
+                    {
+                        uint16_t value = channel.pixelType == EXR_HALF ?
+                            readU16(src) : Bitwise::floatToHalf(channelValue(src, channel.pixelType));
+                        uint16_t* dst = (uint16_t*)(dstRow + x * pixelSize);
+                        for (int32_t component = firstComponent; component <= lastComponent; component++)
+                            dst[component] = value;
+                    }
+                    else
+                    {
+                        float value = channelValue(src, channel.pixelType);
+                        float* dst = (float*)(dstRow + x * pixelSize);
+                        for (int32_t component = firstComponent; component <= lastComponent; component++)
+                            dst[component] = value;
+                    }
+                }
+            }
+        }
+    });
+
+    if (corrupt)
+    {
+        delete imgData;
+        throw(std::exception("Corrupt OpenEXR chunk EXRCodec::decode"));
+    }
+
+    DecodeResult ret;
+    ret.first = output;
+    ret.second = CodecDataPtr(imgData);
+    return ret;
+}
+//---------------------------------------------------------------------    
+std::string EXRCodec::getType() const 
+{
+    return mType;
+}
+//---------------------------------------------------------------------
+std::string EXRCodec::magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const
+{
+    if (maxbytes >= 4 && readU32((const uint8_t*)magicNumberPtr) == EXR_MAGIC)
+    {
+        return mType;
+    }
+    return std::string();
+}
+
+}
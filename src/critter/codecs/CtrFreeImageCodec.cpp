@@ -114,6 +114,41 @@ namespace Ctr
         throw(std::exception(message));
     }
     //---------------------------------------------------------------------
+    /* FreeImage stores scanlines bottom-up with a 4 byte aligned pitch. Copy
+       between a consecutive top-down box and a bitmap through a flipped view,
+       so the flip and any format conversion happen in a single pass. */
+    void copyBitmapRows(const PixelBox& image, FIBITMAP* bitmap, PixelFormat bitmapFormat, bool toBitmap)
+    {
+        const size_t width = image.size().x;
+        const size_t height = image.size().y;
+        const size_t pitch = FreeImage_GetPitch(bitmap);
+        const size_t elemBytes = PixelUtil::getNumElemBytes(bitmapFormat);
+
+        PixelBox view(width, height, 1, bitmapFormat, FreeImage_GetBits(bitmap));
+        if (pitch % elemBytes == 0)
+        {
+            view.rowPitch = ptrdiff_t(pitch / elemBytes);
+            view.slicePitch = view.rowPitch * ptrdiff_t(height);
+            view = view.flippedAroundX();
+            if (toBitmap)
+                PixelUtil::bulkPixelConversion(image, view);
+            else
+                PixelUtil::bulkPixelConversion(view, image);
+            return;
+        }
+
+        // Pitch is not a whole number of pixels (eg 24 bit rows), go row by row.
+        for (size_t y = 0; y < height; y++)
+        {
+            PixelBox imageRow(width, 1, 1, image.format, image.rowData(y));
+            PixelBox bitmapRow(width, 1, 1, bitmapFormat, FreeImage_GetBits(bitmap) + (height - y - 1) * pitch);
+            if (toBitmap)
+                PixelUtil::bulkPixelConversion(imageRow, bitmapRow);
+            else
+                PixelUtil::bulkPixelConversion(bitmapRow, imageRow);
+        }
+    }
+    //---------------------------------------------------------------------
     void FreeImageCodec::startup(void)
     {
         FreeImage_Initialise(false);
@@ -300,9 +335,6 @@ namespace Ctr
 
         }
 
-        bool conversionRequired = false;
-        unsigned char* srcData = input->getPtr();
-
         // Check BPP
         unsigned bpp = static_cast<unsigned>(PixelUtil::getNumElemBits(requiredFormat));
         if (!FreeImage_FIFSupportsExportBPP((FREE_IMAGE_FORMAT)mFreeImageType, (int)bpp))
@@ -324,19 +356,6 @@ namespace Ctr
             }
         }
 
-        PixelBox convBox(pImgData->width, pImgData->height, 1, requiredFormat);
-        if (requiredFormat != pImgData->format)
-        {
-            conversionRequired = true;
-            // Allocate memory
-            convBox.data = (uint8_t*)malloc(sizeof(uint8_t)*convBox.getConsecutiveSize());
-            // perform conversion and reassign source
-            PixelBox newSrc(pImgData->width, pImgData->height, 1, pImgData->format, input->getPtr());
-            PixelUtil::bulkPixelConversion(newSrc, convBox);
-            srcData = static_cast<unsigned char*>(convBox.data);
-        }
-
-
         ret = FreeImage_AllocateT(
             imageType,
             static_cast<int>(pImgData->width),
@@ -345,9 +364,6 @@ namespace Ctr
 
         if (!ret)
         {
-            if (conversionRequired)
-                free(convBox.data);
-
             throw(std::exception("FreeImage_AllocateT failed - possibly out of memory. "));
         }
 
@@ -367,25 +383,9 @@ namespace Ctr
             ret = tmp;
         }
 
-        size_t dstPitch = FreeImage_GetPitch(ret);
-        size_t srcPitch = pImgData->width * PixelUtil::getNumElemBytes(requiredFormat);
-
-
-        // Copy data, invert scanlines and respect FreeImage pitch
-        uint8_t* pSrc;
-        uint8_t* pDst = FreeImage_GetBits(ret);
-        for (size_t y = 0; y < pImgData->height; ++y)
-        {
-            pSrc = srcData + (pImgData->height - y - 1) * srcPitch;
-            memcpy(pDst, pSrc, srcPitch);
-            pDst += dstPitch;
-        }
-
-        if (conversionRequired)
-        {
-            // delete temporary conversion area
-            free(convBox.data);
-        }
+        // Convert, invert scanlines and respect FreeImage pitch in one pass
+        PixelBox image(pImgData->width, pImgData->height, 1, pImgData->format, input->getPtr());
+        copyBitmapRows(image, ret, requiredFormat, true);
 
         return ret;
     }
@@ -435,10 +435,17 @@ namespace Ctr
     //---------------------------------------------------------------------
     Codec::DecodeResult FreeImageCodec::decode(DataStreamPtr& input) const
     {
-        MemoryDataStream memStream(input, true);
+        // Archive views and file buffers are already in memory, decode them in place.
+        MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(input.get());
+        std::unique_ptr<MemoryDataStream> memCopy;
+        if (!memStream || memStream->tell() != 0)
+        {
+            memCopy.reset(new MemoryDataStream(input, true));
+            memStream = memCopy.get();
+        }
 
         FIMEMORY* fiMem = 
-            FreeImage_OpenMemory(memStream.getPtr(), static_cast<uint32_t>(memStream.size()));
+            FreeImage_OpenMemory(memStream->getPtr(), static_cast<uint32_t>(memStream->size()));
         // TIFF - 18.
         FIBITMAP* fiBitmap = FreeImage_LoadFromMemory(
             (FREE_IMAGE_FORMAT)mFreeImageType, fiMem);
@@ -552,25 +559,14 @@ namespace Ctr
             
         };
 
-        unsigned char* srcData = FreeImage_GetBits(fiBitmap);
-        unsigned srcPitch = FreeImage_GetPitch(fiBitmap);
-
         // Final data - invert image and trim pitch at the same time
-        size_t dstPitch = imgData->width * PixelUtil::getNumElemBytes(imgData->format);
-        imgData->size = dstPitch * imgData->height;
+        PixelBox image(imgData->width, imgData->height, 1, imgData->format);
+        imgData->size = image.getConsecutiveSize();
         // Bind output buffer
         output.reset(new MemoryDataStream(imgData->size));
+        image.data = output->getPtr();
+        copyBitmapRows(image, fiBitmap, imgData->format, false);
 
-        uint8_t* pSrc;
-        uint8_t* pDst = output->getPtr();
-        for (size_t y = 0; y < imgData->height; ++y)
-        {
-            pSrc = srcData + (imgData->height - y - 1) * srcPitch;
-            memcpy(pDst, pSrc, dstPitch);
-            pDst += dstPitch;
-        }
-
-        
         FreeImage_Unload(fiBitmap);
         FreeImage_CloseMemory(fiMem);
 
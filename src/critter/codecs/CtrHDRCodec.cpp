@@ -0,0 +1,415 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrHDRCodec.h>
+#include <CtrBitwise.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <atomic>
+
+namespace Ctr
+{
+namespace
+{
+// Radiance RLE scanlines are only used for widths in this range.
+const size_t HDR_MIN_RLE_WIDTH = 8;
+const size_t HDR_MAX_RLE_WIDTH = 0x7fff;
+// Scanlines per parallel task.
+const size_t HDR_ROWS_PER_TASK = 16;
+
+//---------------------------------------------------------------------
+// The whole file has to be in memory for the scanline index.
+// Memory streams are used in place.
+//---------------------------------------------------------------------
+const uint8_t*
+encodedData(DataStreamPtr& input, std::vector<uint8_t>& storage, size_t& size)
+{
+    if (MemoryDataStream* memStream = dynamic_cast<MemoryDataStream*>(input.get()))
+    {
+        size = memStream->size() - memStream->tell();
+        return memStream->getPtr() + memStream->tell();
+    }
+
+    storage.resize(input->size() - input->tell());
+    size = input->read(storage.data(), storage.size());
+    return storage.data();
+}
+
+bool
+readLine(const uint8_t* data, size_t size, size_t& offset, std::string& line)
+{
+    line.clear();
+    while (offset < size)
+    {
+        char c = (char)data[offset++];
+        if (c == '\n')
+            return true;
+        line += c;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------
+// Returns the offset after the scanline that starts at offset,
+// or 0 if it runs past the end of the data.
+//---------------------------------------------------------------------
+size_t
+skipScanline(const uint8_t* data, size_t size, size_t offset, size_t width)
+{
+    const uint8_t* p = data + offset;
+    if (width >= HDR_MIN_RLE_WIDTH && width <= HDR_MAX_RLE_WIDTH && offset + 4 <= size &&
+        p[0] == 2 && p[1] == 2 && ((size_t(p[2]) << 8) | p[3]) == width)
+    {
+        // New RLE, 4 component planes of runs.
+        offset += 4;
+        for (size_t component = 0; component < 4; component++)
+        {
+            size_t x = 0;
+            while (x < width)
+            {
+                if (offset >= size)
+                    return 0;
+                size_t count = data[offset++];
+                if (count > 128)
+                {
+                    count -= 128;
+                    offset++;
+                }
+                else
+                {
+                    offset += count;
+                }
+                if (count == 0)
+                    return 0;
+                x += count;
+            }
+        }
+        return offset <= size ? offset : 0;
+    }
+
+    // Flat or old style RLE, pixel by pixel.
+    size_t x = 0;
+    int shift = 0;
+    while (x < width)
+    {
+        if (offset + 4 > size)
+            return 0;
+        p = data + offset;
+        offset += 4;
+        if (p[0] == 1 && p[1] == 1 && p[2] == 1)
+        {
+            x += size_t(p[3]) << shift;
+            shift += 8;
+        }
+        else
+        {
+            x++;
+            shift = 0;
+        }
+    }
+    return offset;
+}
+
+//---------------------------------------------------------------------
+// Decodes one scanline into width interleaved RGBE pixels.
+//---------------------------------------------------------------------
+bool
+decodeScanline(const uint8_t* data, size_t begin, size_t end, size_t width, uint8_t* rgbe)
+{
+    const uint8_t* p = data + begin;
+    const uint8_t* e = data + end;
+    if (width >= HDR_MIN_RLE_WIDTH && width <= HDR_MAX_RLE_WIDTH && e - p >= 4 &&
+        p[0] == 2 && p[1] == 2 && ((size_t(p[2]) << 8) | p[3]) == width)
+    {
+        p += 4;
+        for (size_t component = 0; component < 4; component++)
+        {
+            uint8_t* dst = rgbe + component;
+            uint8_t* dstEnd = rgbe + width * 4;
+            while (dst < dstEnd)
+            {
+                if (p >= e)
+                    return false;
+                size_t count = *p++;
+                if (count > 128)
+                {
+                    count -= 128;
+                    if (p >= e || dst + (count - 1) * 4 >= dstEnd)
+                        return false;
+                    uint8_t value = *p++;
+                    for (size_t i = 0; i < count; i++, dst += 4)
+                        *dst = value;
+                }
+                else
+                {
+                    if (count == 0 || p + count > e || dst + (count - 1) * 4 >= dstEnd)
+                        return false;
+                    for (size_t i = 0; i < count; i++, dst += 4)
+                        *dst = *p++;
+                }
+            }
+        }
+        return true;
+    }
+
+    uint8_t* dst = rgbe;
+    uint8_t* dstEnd = rgbe + width * 4;
+    int shift = 0;
+    while (dst < dstEnd)
+    {
+        if (p + 4 > e)
+            return false;
+        if (p[0] == 1 && p[1] == 1 && p[2] == 1)
+        {
+            // Repeat the previous pixel. A leading repeat has nothing to copy.
+            size_t count = size_t(p[3]) << shift;
+            if (dst == rgbe || dst + count * 4 > dstEnd)
+                return false;
+            for (size_t i = 0; i < count; i++, dst += 4)
+                memcpy(dst, dst - 4, 4);
+            shift += 8;
+        }
+        else
+        {
+            memcpy(dst, p, 4);
+            dst += 4;
+            shift = 0;
+        }
+        p += 4;
+    }
+    return true;
+}
+}
+
+//---------------------------------------------------------------------
+HDRCodec* HDRCodec::msInstance = 0;
+Codec* HDRCodec::msEncoder = 0;
+bool HDRCodec::_halfFloat = false;
+//---------------------------------------------------------------------
+void HDRCodec::startup(void)
+{
+    if (!msInstance)
+    {
+        LOG("HDR codec registering");
+
+        msInstance = new HDRCodec();
+        if (Codec::isCodecRegistered(msInstance->getType()))
+        {
+            msEncoder = Codec::getCodec(msInstance->getType());
+            Codec::unRegisterCodec(msEncoder);
+        }
+        Codec::registerCodec(msInstance);
+    }
+}
+//---------------------------------------------------------------------
+void HDRCodec::shutdown(void)
+{
+    if(msInstance)
+    {
+        Codec::unRegisterCodec(msInstance);
+        if (msEncoder)
+        {
+            Codec::registerCodec(msEncoder);
+            msEncoder = 0;
+        }
+        delete msInstance;
+        msInstance = 0;
+    }
+}
+//---------------------------------------------------------------------
+HDRCodec::HDRCodec():
+    mType("hdr")
+{ 
+}
+//---------------------------------------------------------------------
+DataStreamPtr HDRCodec::code(MemoryDataStreamPtr& input, Codec::CodecDataPtr& pData) const
+{        
+    if (!msEncoder)
+        throw (std::exception("HDR encoding not supported HDRCodec::code" ));
+    return msEncoder->code(input, pData);
+}
+//---------------------------------------------------------------------
+void HDRCodec::codeToFile(MemoryDataStreamPtr& input, 
+                          const std::string& outFileName, 
+                          Codec::CodecDataPtr& pData) const
+{
+    if (!msEncoder)
+        throw (std::exception("HDR encoding not supported HDRCodec::codeToFile" ));
+    msEncoder->codeToFile(input, outFileName, pData);
+}
+//---------------------------------------------------------------------
+Codec::DecodeResult HDRCodec::decode(DataStreamPtr& input) const
+{
+    std::vector<uint8_t> storage;
+    size_t size = 0;
+    const uint8_t* data = encodedData(input, storage, size);
+
+    // Header, terminated by an empty line.
+    size_t offset = 0;
+    std::string line;
+    if (!readLine(data, size, offset, line) || line.compare(0, 2, "#?") != 0)
+    {
+        throw(std::exception("Not a Radiance HDR file HDRCodec::decode"));
+    }
+    while (readLine(data, size, offset, line) && !line.empty())
+    {
+        if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe")
+        {
+            throw(std::exception("Unsupported Radiance pixel format HDRCodec::decode"));
+        }
+    }
+
+    // Resolution string. Only row major orientations are supported,
+    // -Y is top down, +Y bottom up.
+    char ySign = 0;
+    char xSign = 0;
+    int height = 0;
+    int width = 0;
+    if (!readLine(data, size, offset, line) ||
+        sscanf(line.c_str(), "%cY %d %cX %d", &ySign, &height, &xSign, &width) != 4 ||
+        xSign != '+' || (ySign != '-' && ySign != '+') || width <= 0 || height <= 0)
+    {
+        throw(std::exception("Unsupported Radiance resolution string HDRCodec::decode"));
+    }
+    bool flipY = ySign == '+';
+
+    // Index scanline offsets, then every scanline can be decoded independently.
+    std::vector<size_t> scanlines(size_t(height) + 1);
+    scanlines[0] = offset;
+    for (size_t y = 0; y < size_t(height); y++)
+    {
+        scanlines[y+1] = skipScanline(data, size, scanlines[y], size_t(width));
+        if (scanlines[y+1] == 0)
+        {
+            throw(std::exception("Truncated Radiance HDR file HDRCodec::decode"));
+        }
+    }
+
+    ImageData* imgData = new ImageData();
+    imgData->depth = 1;
+    imgData->width = size_t(width);
+    imgData->height = size_t(height);
+    imgData->num_mipmaps = 0;
+    imgData->flags = 0;
+    imgData->format = _halfFloat ? PF_FLOAT16_RGBA : PF_FLOAT32_RGB;
+    
+    size_t dstPitch = imgData->width * PixelUtil::getNumElemBytes(imgData->format);
+    imgData->size = dstPitch * imgData->height;
+
+    MemoryDataStreamPtr output(new MemoryDataStream(imgData->size));
+    uint8_t* dstData = output->getPtr();
+
+    // Shared exponent scale, matches FreeImage (no half bias).
+    float exponents[256];
+    exponents[0] = 0.0f;
+    for (int e = 1; e < 256; e++)
+        exponents[e] = ldexpf(1.0f, e - (128 + 8));
+
+    bool halfFloat = _halfFloat;
+    std::atomic<bool> corrupt(false);
+    size_t taskCount = (imgData->height + HDR_ROWS_PER_TASK - 1) / HDR_ROWS_PER_TASK;
+    concurrency::parallel_for(size_t(0), taskCount, [&](size_t taskId)
+    {
+        std::vector<uint8_t> rgbe(imgData->width * 4);
+        size_t rowEnd = std::min((taskId + 1) * HDR_ROWS_PER_TASK, imgData->height);
+        for (size_t y = taskId * HDR_ROWS_PER_TASK; y < rowEnd; y++)
+        {
+            if (!decodeScanline(data, scanlines[y], scanlines[y+1], imgData->width, rgbe.data()))
+            {
+                corrupt = true;
+                return;
+            }
+
+            size_t dstRow = flipY ? imgData->height - y - 1 : y;
+            const uint8_t* src = rgbe.data();
+            if (halfFloat)
+            {
+                uint16_t* dst = (uint16_t*)(dstData + dstRow * dstPitch);
+                for (size_t x = 0; x < imgData->width; x++, src += 4, dst += 4)
+                {
+                    float scale = exponents[src[3]];
+                    dst[0] = Bitwise::floatToHalf(src[0] * scale);
+                    dst[1] = Bitwise::floatToHalf(src[1] * scale);
+                    dst[2] = Bitwise::floatToHalf(src[2] * scale);
+                    dst[3] = 0x3c00; // 1.0
+                }
+            }
+            else
+            {
+                float* dst = (float*)(dstData + dstRow * dstPitch);
+                for (size_t x = 0; x < imgData->width; x++, src += 4, dst += 3)
+                {
+                    float scale = exponents[src[3]];
+                    dst[0] = src[0] * scale;
+                    dst[1] = src[1] * scale;
+                    dst[2] = src[2] * scale;
+                }
+            }
+        }
+    });
+
+    if (corrupt)
+    {
+        delete imgData;
+        throw(std::exception("Corrupt Radiance HDR scanline HDRCodec::decode"));
+    }
+
+    DecodeResult ret;
+    ret.first = output;
+    ret.second = CodecDataPtr(imgData);
+    return ret;
+}
+//---------------------------------------------------------------------    
+std::string HDRCodec::getType() const 
+{
+    return mType;
+}
+//---------------------------------------------------------------------
+std::string HDRCodec::magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const
+{
+    if (maxbytes >= 2 && magicNumberPtr[0] == '#' && magicNumberPtr[1] == '?')
+    {
+        return mType;
+    }
+    return std::string();
+}
+
+}
@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_HDR_CODEC
+#define INCLUDED_CRT_HDR_CODEC
+
+#include <CtrImageCodec.h>
+
+namespace Ctr
+{
+/** Codec for Radiance RGBE (.hdr) images.
+@remarks
+    Decodes straight into the image buffer without going through
+    FreeImage. Scanline offsets are indexed in one pass over the
+    file, then the RLE scanlines are decoded in parallel.
+    Output is PF_FLOAT32_RGB, or PF_FLOAT16_RGBA if _halfFloat is set.
+    Encoding is forwarded to the codec previously registered for
+    the extension (FreeImage), if any.
+*/
+class HDRCodec : public ImageCodec
+{
+  public:
+    HDRCodec();
+    virtual ~HDRCodec() { }
+
+    /// @copydoc Codec::code
+    DataStreamPtr code(MemoryDataStreamPtr& input, CodecDataPtr& pData) const;
+    /// @copydoc Codec::codeToFile
+    void codeToFile(MemoryDataStreamPtr& input, const std::string& outFileName, CodecDataPtr& pData) const;
+    /// @copydoc Codec::decode
+    DecodeResult decode(DataStreamPtr& input) const;
+    /// @copydoc Codec::magicNumberToFileExt
+    std::string magicNumberToFileExt(const char *magicNumberPtr, size_t maxbytes) const;
+    
+    virtual std::string getType() const;        
+
+    /// Static method to startup and register the HDR codec
+    static void startup(void);
+    /// Static method to shutdown and unregister the HDR codec
+    static void shutdown(void);
+
+    static bool _halfFloat;
+
+  private:
+    std::string mType;
+
+    /// Single registered codec instance
+    static HDRCodec* msInstance;
+    /// Codec replaced at startup, used for encoding
+    static Codec* msEncoder;
+};
+}
+
+#endif
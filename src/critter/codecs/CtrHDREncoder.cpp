@@ -0,0 +1,1235 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrHDREncoder.h>
+#include <CtrTextureImage.h>
+#include <CtrVector2.h>
+#include <CtrMath.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <cmath>
+
+namespace Ctr
+{
+namespace
+{
+// Rows per parallel task.
+const size_t HDR_ROWS_PER_TASK = 16;
+// log2 histogram used for the clip percentile.
+const size_t HDR_HISTOGRAM_BINS = 256;
+const float  HDR_HISTOGRAM_MIN = -32.0f;
+const float  HDR_HISTOGRAM_MAX = 32.0f;
+// Below this LogLuv treats a texel as black.
+const float  HDR_MIN_LUMINANCE = 1e-6f;
+const float  RGB9E5_MAX = 65408.0f;
+
+struct RowRef
+{
+    const PixelBox* box;
+    size_t          y;
+    size_t          z;
+};
+
+//---------------------------------------------------------------------
+// Rows of all boxes, so statistics of the faces of a mip are gathered
+// in one parallel pass.
+//---------------------------------------------------------------------
+std::vector<RowRef>
+gatherRows(const PixelBox* boxes, size_t count)
+{
+    std::vector<RowRef> rows;
+    for (size_t i = 0; i < count; i++)
+    {
+        for (size_t z = 0; z < boxes[i].size().z; z++)
+        {
+            for (size_t y = 0; y < boxes[i].size().y; y++)
+            {
+                RowRef row = { &boxes[i], y, z };
+                rows.push_back(row);
+            }
+        }
+    }
+    return rows;
+}
+
+PixelBox
+rowBox(const PixelBox& box, size_t y, size_t z)
+{
+    PixelBox row(box.size().x, 1, 1, box.format, box.rowData(y, z));
+    row.swizzle = box.swizzle;
+    return row;
+}
+
+void
+readRow(const PixelBox& box, size_t y, size_t z, float* rgba)
+{
+    PixelUtil::bulkPixelConversion(rowBox(box, y, z), PixelBox(box.size().x, 1, 1, PF_FLOAT32_RGBA, rgba));
+}
+
+void
+writeRow(const PixelBox& box, size_t y, size_t z, float* rgba)
+{
+    PixelUtil::bulkPixelConversion(PixelBox(box.size().x, 1, 1, PF_FLOAT32_RGBA, rgba), rowBox(box, y, z));
+}
+
+template <typename Function>
+void
+parallelRows(size_t numRows, size_t width, Function function)
+{
+    size_t numTasks = (numRows + HDR_ROWS_PER_TASK - 1) / HDR_ROWS_PER_TASK;
+    concurrency::parallel_for(size_t(0), numTasks, [&](size_t task)
+    {
+        std::vector<float> buffer(width * 4);
+        size_t end = minValue(numRows, (task + 1) * HDR_ROWS_PER_TASK);
+        for (size_t row = task * HDR_ROWS_PER_TASK; row < end; row++)
+            function(task, row, &buffer[0]);
+    });
+}
+
+inline float
+maxChannel(const float* c)
+{
+    return maxValue(maxValue(c[0], c[1]), c[2]);
+}
+
+// LogLuv (Greg Ward) basis, RGB to Xp, Y, XYZp and back.
+inline float logLuvY(const float* c) { return 0.3390f * c[0] + 0.6780f * c[1] + 0.1130f * c[2]; }
+
+//---------------------------------------------------------------------
+// Negative and NaN channels clamp to 0. RGBM and RGBD work on gamma
+// corrected color.
+//---------------------------------------------------------------------
+inline void
+prepare(float* c, float invGamma)
+{
+#if CTR_SSE
+    __m128 v = _mm_max_ps(_mm_loadu_ps(c), _mm_setzero_ps());
+    _mm_storeu_ps(c, v);
+#else
+    for (size_t i = 0; i < 3; i++)
+        c[i] = c[i] > 0.0f ? c[i] : 0.0f;
+#endif
+    if (invGamma != 1.0f)
+    {
+        for (size_t i = 0; i < 3; i++)
+            c[i] = std::pow(c[i], invGamma);
+    }
+}
+
+inline void
+restore(float* c, float gamma)
+{
+    if (gamma != 1.0f)
+    {
+        for (size_t i = 0; i < 3; i++)
+            c[i] = std::pow(c[i], gamma);
+    }
+}
+
+// Bytes in [0, 255], stored in R, G, B, A memory order.
+inline uint32_t
+packBytes(float r, float g, float b, float a)
+{
+#if CTR_SSE
+    __m128i dwords = _mm_cvtps_epi32(_mm_setr_ps(r, g, b, a));
+    __m128i words = _mm_packs_epi32(dwords, dwords);
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+#else
+    uint32_t result = 0;
+    const float values[4] = { r, g, b, a };
+    for (size_t i = 0; i < 4; i++)
+        result |= uint32_t(clamped(values[i] + 0.5f, 0.0f, 255.0f)) << (i * 8);
+    return result;
+#endif
+}
+
+// Bytes of a packed texel scaled by scale, rgb only.
+inline void
+unpackBytes(uint32_t texel, float scale, float* c)
+{
+#if CTR_SSE
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int32_t)texel), zero);
+    __m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+    _mm_storeu_ps(c, _mm_mul_ps(v, _mm_set1_ps(scale)));
+#else
+    for (size_t i = 0; i < 4; i++)
+        c[i] = float((texel >> (i * 8)) & 0xff) * scale;
+#endif
+    c[3] = 1.0f;
+}
+
+inline uint32_t
+encodeRGBM(const float* c, float invScale)
+{
+    float r = c[0] * invScale;
+    float g = c[1] * invScale;
+    float b = c[2] * invScale;
+    float m = clamped(maxValue(maxValue(r, g), maxValue(b, 1e-6f)), 0.0f, 1.0f);
+    m = std::ceil(m * 255.0f) / 255.0f;
+    float k = 255.0f / m;
+    return packBytes(r * k, g * k, b * k, m * 255.0f);
+}
+
+inline void
+decodeRGBM(uint32_t texel, float scale, float* c)
+{
+    float m = float(texel >> 24);
+    unpackBytes(texel, m * scale / (255.0f * 255.0f), c);
+}
+
+inline uint32_t
+encodeRGBD(const float* c, float invScale)
+{
+    float r = c[0] * invScale;
+    float g = c[1] * invScale;
+    float b = c[2] * invScale;
+    // Largest divisor that keeps every channel in range.
+    float m = maxValue(maxValue(r, g), maxValue(b, 1e-6f));
+    float d = clamped(std::floor(255.0f / m), 1.0f, 255.0f);
+    return packBytes(minValue(r * d, 255.0f), minValue(g * d, 255.0f), minValue(b * d, 255.0f), d);
+}
+
+inline void
+decodeRGBD(uint32_t texel, float scale, float* c)
+{
+    float d = maxValue(float(texel >> 24), 1.0f);
+    unpackBytes(texel, scale / d, c);
+}
+
+inline uint32_t
+encodeLogLuv(const float* c, float logMinimum, float invLogRange)
+{
+    float xp = 0.2209f * c[0] + 0.1138f * c[1] + 0.0102f * c[2];
+    float y = logLuvY(c);
+    float xyzp = maxValue(0.4184f * c[0] + 0.7319f * c[1] + 0.2969f * c[2], HDR_MIN_LUMINANCE);
+    if (y < HDR_MIN_LUMINANCE)
+    {
+        // 0 is reserved for black.
+        return 0;
+    }
+
+    float u = xp / xyzp;
+    float v = y / xyzp;
+    float le = clamped((std::log2(y) - logMinimum) * invLogRange, 0.0f, 1.0f);
+    uint32_t logLuminance = uint32_t(le * 65534.0f + 0.5f) + 1;
+    return packBytes(u * 255.0f, v * 255.0f, 0.0f, 0.0f) | 
+           ((logLuminance >> 8) << 16) | ((logLuminance & 0xff) << 24);
+}
+
+inline void
+decodeLogLuv(uint32_t texel, float logMinimum, float logRange, float* c)
+{
+    uint32_t logLuminance = ((texel >> 16) & 0xff) << 8 | (texel >> 24);
+    c[3] = 1.0f;
+    if (logLuminance == 0)
+    {
+        c[0] = c[1] = c[2] = 0.0f;
+        return;
+    }
+
+    float u = float(texel & 0xff) / 255.0f;
+    float v = maxValue(float((texel >> 8) & 0xff) / 255.0f, 1.0f / 512.0f);
+    float y = std::exp2(logMinimum + float(logLuminance - 1) / 65534.0f * logRange);
+    float xyzp = y / v;
+    float xp = u * xyzp;
+    c[0] = maxValue( 6.0014f * xp - 1.3320f * y + 0.3008f * xyzp, 0.0f);
+    c[1] = maxValue(-2.7008f * xp + 3.1029f * y - 1.0882f * xyzp, 0.0f);
+    c[2] = maxValue(-1.7996f * xp - 5.7721f * y + 5.6268f * xyzp, 0.0f);
+}
+
+//---------------------------------------------------------------------
+// DXGI_FORMAT_R9G9B9E5_SHAREDEXP: 9 bit mantissas, 5 bit exponent
+// with a bias of 15.
+//---------------------------------------------------------------------
+inline uint32_t
+encodeRGB9E5(const float* c, float invScale)
+{
+    float r = clamped(c[0] * invScale, 0.0f, RGB9E5_MAX);
+    float g = clamped(c[1] * invScale, 0.0f, RGB9E5_MAX);
+    float b = clamped(c[2] * invScale, 0.0f, RGB9E5_MAX);
+    float m = maxValue(maxValue(r, g), b);
+
+    int exponent = 0;
+    std::frexp(m, &exponent);
+    int sharedExponent = maxValue(-16, exponent - 1) + 16;
+    float denominator = std::ldexp(1.0f, sharedExponent - 24);
+    if (uint32_t(std::floor(m / denominator + 0.5f)) == 512)
+    {
+        denominator *= 2.0f;
+        sharedExponent++;
+    }
+
+    float invDenominator = 1.0f / denominator;
+    uint32_t rm = uint32_t(std::floor(r * invDenominator + 0.5f));
+    uint32_t gm = uint32_t(std::floor(g * invDenominator + 0.5f));
+    uint32_t bm = uint32_t(std::floor(b * invDenominator + 0.5f));
+    return rm | (gm << 9) | (bm << 18) | (uint32_t(sharedExponent) << 27);
+}
+
+inline void
+decodeRGB9E5(uint32_t texel, float scale, float* c)
+{
+    float multiplier = std::ldexp(scale, int(texel >> 27) - 24);
+    c[0] = float(texel & 0x1ff) * multiplier;
+    c[1] = float((texel >> 9) & 0x1ff) * multiplier;
+    c[2] = float((texel >> 18) & 0x1ff) * multiplier;
+    c[3] = 1.0f;
+}
+
+#if CTR_SSE
+//---------------------------------------------------------------------
+// Four texel kernels. A block is transposed to one register per
+// channel, so every encoding runs four lanes at a time. pow, log2 and
+// exp2 are polynomial approximations with a relative error around
+// 1e-6, far below the 8 and 9 bit quantization of the encodings.
+//---------------------------------------------------------------------
+struct Texels4
+{
+    __m128 r;
+    __m128 g;
+    __m128 b;
+    __m128 a;
+};
+
+inline void
+loadTexels(const float* rgba, Texels4& texels)
+{
+    texels.r = _mm_loadu_ps(rgba);
+    texels.g = _mm_loadu_ps(rgba + 4);
+    texels.b = _mm_loadu_ps(rgba + 8);
+    texels.a = _mm_loadu_ps(rgba + 12);
+    _MM_TRANSPOSE4_PS(texels.r, texels.g, texels.b, texels.a);
+}
+
+inline void
+storeTexels(const Texels4& texels, float* rgba)
+{
+    __m128 r = texels.r;
+    __m128 g = texels.g;
+    __m128 b = texels.b;
+    __m128 a = texels.a;
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    _mm_storeu_ps(rgba, r);
+    _mm_storeu_ps(rgba + 4, g);
+    _mm_storeu_ps(rgba + 8, b);
+    _mm_storeu_ps(rgba + 12, a);
+}
+
+inline __m128
+selectLanes(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Positive normal x only. The mantissa is reduced to [sqrt(0.5), sqrt(2))
+// and log2 expanded as an odd series in t = (m - 1) / (m + 1).
+inline __m128
+log2Approximation(__m128 x)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i bits = _mm_castps_si128(x);
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), 
+                                             _mm_castps_si128(one)));
+    __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = selectLanes(large, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+    exponent = _mm_add_ps(exponent, _mm_and_ps(large, one));
+
+    __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 series = _mm_set1_ps(1.0f / 9.0f);
+    series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 7.0f));
+    series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 5.0f));
+    series = _mm_add_ps(_mm_mul_ps(series, t2), _mm_set1_ps(1.0f / 3.0f));
+    series = _mm_add_ps(_mm_mul_ps(series, t2), one);
+    return _mm_add_ps(exponent, _mm_mul_ps(_mm_mul_ps(t, series), _mm_set1_ps(2.88539008f)));
+}
+
+// Splits x into a rounded integer and f in [-0.5, 0.5], 2^f is a
+// degree 6 Taylor polynomial of e^(f ln2).
+inline __m128
+exp2Approximation(__m128 x)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+    __m128i integer = _mm_cvtps_epi32(x);
+    __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(integer));
+
+    __m128 p = _mm_set1_ps(1.54035304e-4f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.33335581e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.61812911e-3f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.55041087e-2f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.40226507e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.93147181e-1f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(integer, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+
+// x^power, 0 for x below the smallest normal.
+inline __m128
+powApproximation(__m128 x, float power)
+{
+    __m128 positive = _mm_cmpge_ps(x, _mm_set1_ps(FLT_MIN));
+    return _mm_and_ps(positive, exp2Approximation(_mm_mul_ps(log2Approximation(x), _mm_set1_ps(power))));
+}
+
+// 2^exponent for integer exponents in the normal range.
+inline __m128
+exp2Integer(__m128i exponent)
+{
+    return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23));
+}
+
+// Non negative x.
+inline __m128
+ceilPositive(__m128 x)
+{
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_add_ps(truncated, _mm_and_ps(_mm_cmplt_ps(truncated, x), _mm_set1_ps(1.0f)));
+}
+
+inline void
+prepare(Texels4& texels, float invGamma)
+{
+    const __m128 zero = _mm_setzero_ps();
+    texels.r = _mm_max_ps(texels.r, zero);
+    texels.g = _mm_max_ps(texels.g, zero);
+    texels.b = _mm_max_ps(texels.b, zero);
+    if (invGamma != 1.0f)
+    {
+        texels.r = powApproximation(texels.r, invGamma);
+        texels.g = powApproximation(texels.g, invGamma);
+        texels.b = powApproximation(texels.b, invGamma);
+    }
+}
+
+inline void
+restore(Texels4& texels, float gamma)
+{
+    if (gamma != 1.0f)
+    {
+        texels.r = powApproximation(texels.r, gamma);
+        texels.g = powApproximation(texels.g, gamma);
+        texels.b = powApproximation(texels.b, gamma);
+    }
+}
+
+// Bytes in [0, 255], stored in R, G, B, A memory order.
+inline __m128i
+packBytes(const Texels4& texels)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps(255.0f);
+    __m128i r = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(texels.r, zero), top));
+    __m128i g = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(texels.g, zero), top));
+    __m128i b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(texels.b, zero), top));
+    __m128i a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(texels.a, zero), top));
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), 
+                        _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+}
+
+// Bytes of packed texels scaled by scale, rgb only.
+inline void
+unpackBytes(__m128i packed, __m128 scale, Texels4& texels)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    texels.r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mask)), scale);
+    texels.g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 8), mask)), scale);
+    texels.b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 16), mask)), scale);
+    texels.a = _mm_set1_ps(1.0f);
+}
+
+inline __m128i
+encodeRGBM(const Texels4& texels, float invScale)
+{
+    __m128 scale = _mm_set1_ps(invScale);
+    Texels4 scaled;
+    scaled.r = _mm_mul_ps(texels.r, scale);
+    scaled.g = _mm_mul_ps(texels.g, scale);
+    scaled.b = _mm_mul_ps(texels.b, scale);
+    __m128 m = _mm_max_ps(_mm_max_ps(scaled.r, scaled.g), _mm_max_ps(scaled.b, _mm_set1_ps(1e-6f)));
+    m = ceilPositive(_mm_mul_ps(_mm_min_ps(m, _mm_set1_ps(1.0f)), _mm_set1_ps(255.0f)));
+    __m128 k = _mm_div_ps(_mm_set1_ps(255.0f * 255.0f), m);
+    scaled.r = _mm_mul_ps(scaled.r, k);
+    scaled.g = _mm_mul_ps(scaled.g, k);
+    scaled.b = _mm_mul_ps(scaled.b, k);
+    scaled.a = m;
+    return packBytes(scaled);
+}
+
+inline void
+decodeRGBM(__m128i packed, float scale, Texels4& texels)
+{
+    __m128 m = _mm_cvtepi32_ps(_mm_srli_epi32(packed, 24));
+    unpackBytes(packed, _mm_mul_ps(m, _mm_set1_ps(scale / (255.0f * 255.0f))), texels);
+}
+
+inline __m128i
+encodeRGBD(const Texels4& texels, float invScale)
+{
+    __m128 scale = _mm_set1_ps(invScale);
+    Texels4 scaled;
+    scaled.r = _mm_mul_ps(texels.r, scale);
+    scaled.g = _mm_mul_ps(texels.g, scale);
+    scaled.b = _mm_mul_ps(texels.b, scale);
+    // Largest divisor that keeps every channel in range.
+    __m128 m = _mm_max_ps(_mm_max_ps(scaled.r, scaled.g), _mm_max_ps(scaled.b, _mm_set1_ps(1e-6f)));
+    __m128 d = _mm_min_ps(_mm_div_ps(_mm_set1_ps(255.0f), m), _mm_set1_ps(255.0f));
+    d = _mm_max_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(d)), _mm_set1_ps(1.0f));
+    scaled.r = _mm_mul_ps(scaled.r, d);
+    scaled.g = _mm_mul_ps(scaled.g, d);
+    scaled.b = _mm_mul_ps(scaled.b, d);
+    scaled.a = d;
+    return packBytes(scaled);
+}
+
+inline void
+decodeRGBD(__m128i packed, float scale, Texels4& texels)
+{
+    __m128 d = _mm_max_ps(_mm_cvtepi32_ps(_mm_srli_epi32(packed, 24)), _mm_set1_ps(1.0f));
+    unpackBytes(packed, _mm_div_ps(_mm_set1_ps(scale), d), texels);
+}
+
+inline __m128
+dot3(const Texels4& texels, float x, float y, float z)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(texels.r, _mm_set1_ps(x)), _mm_mul_ps(texels.g, _mm_set1_ps(y))), 
+                      _mm_mul_ps(texels.b, _mm_set1_ps(z)));
+}
+
+inline __m128i
+encodeLogLuv(const Texels4& texels, float logMinimum, float invLogRange)
+{
+    const __m128 minLuminance = _mm_set1_ps(HDR_MIN_LUMINANCE);
+    __m128 xp = dot3(texels, 0.2209f, 0.1138f, 0.0102f);
+    __m128 y = dot3(texels, 0.3390f, 0.6780f, 0.1130f);
+    __m128 xyzp = _mm_max_ps(dot3(texels, 0.4184f, 0.7319f, 0.2969f), minLuminance);
+    // 0 is reserved for black.
+    __m128 lit = _mm_cmpge_ps(y, minLuminance);
+
+    Texels4 chroma;
+    chroma.r = _mm_mul_ps(_mm_div_ps(xp, xyzp), _mm_set1_ps(255.0f));
+    chroma.g = _mm_mul_ps(_mm_div_ps(y, xyzp), _mm_set1_ps(255.0f));
+    chroma.b = _mm_setzero_ps();
+    chroma.a = _mm_setzero_ps();
+
+    __m128 le = _mm_mul_ps(_mm_sub_ps(log2Approximation(_mm_max_ps(y, minLuminance)), _mm_set1_ps(logMinimum)), 
+                           _mm_set1_ps(invLogRange));
+    le = _mm_min_ps(_mm_max_ps(le, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    __m128i logLuminance = _mm_add_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(le, _mm_set1_ps(65534.0f)), 
+                                                                     _mm_set1_ps(0.5f))), 
+                                         _mm_set1_epi32(1));
+    __m128i packed = _mm_or_si128(packBytes(chroma), 
+                                  _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(logLuminance, 8), 16), 
+                                               _mm_slli_epi32(_mm_and_si128(logLuminance, _mm_set1_epi32(0xff)), 24)));
+    return _mm_and_si128(_mm_castps_si128(lit), packed);
+}
+
+inline void
+decodeLogLuv(__m128i packed, float logMinimum, float logRange, Texels4& texels)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i logLuminance = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(packed, 16), mask), 8), 
+                                        _mm_srli_epi32(packed, 24));
+    __m128 lit = _mm_castsi128_ps(_mm_cmpgt_epi32(logLuminance, _mm_setzero_si128()));
+
+    __m128 u = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mask)), _mm_set1_ps(1.0f / 255.0f));
+    __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 8), mask)), _mm_set1_ps(1.0f / 255.0f));
+    v = _mm_max_ps(v, _mm_set1_ps(1.0f / 512.0f));
+    __m128 le = _mm_cvtepi32_ps(_mm_sub_epi32(logLuminance, _mm_set1_epi32(1)));
+    __m128 y = exp2Approximation(_mm_add_ps(_mm_set1_ps(logMinimum), _mm_mul_ps(le, _mm_set1_ps(logRange / 65534.0f))));
+    __m128 xyzp = _mm_div_ps(y, v);
+
+    Texels4 xyz;
+    xyz.r = _mm_mul_ps(u, xyzp);
+    xyz.g = y;
+    xyz.b = xyzp;
+    __m128 zero = _mm_setzero_ps();
+    texels.r = _mm_and_ps(lit, _mm_max_ps(dot3(xyz,  6.0014f, -1.3320f,  0.3008f), zero));
+    texels.g = _mm_and_ps(lit, _mm_max_ps(dot3(xyz, -2.7008f,  3.1029f, -1.0882f), zero));
+    texels.b = _mm_and_ps(lit, _mm_max_ps(dot3(xyz, -1.7996f, -5.7721f,  5.6268f), zero));
+    texels.a = _mm_set1_ps(1.0f);
+}
+
+inline __m128i
+roundMantissa(__m128 channel, __m128 invDenominator)
+{
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(channel, invDenominator), _mm_set1_ps(0.5f)));
+}
+
+inline __m128i
+encodeRGB9E5(const Texels4& texels, float invScale)
+{
+    const __m128 scale = _mm_set1_ps(invScale);
+    const __m128 top = _mm_set1_ps(RGB9E5_MAX);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 r = _mm_min_ps(_mm_max_ps(_mm_mul_ps(texels.r, scale), zero), top);
+    __m128 g = _mm_min_ps(_mm_max_ps(_mm_mul_ps(texels.g, scale), zero), top);
+    __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(texels.b, scale), zero), top);
+    __m128 m = _mm_max_ps(_mm_max_ps(r, g), b);
+
+    // floor(log2(m)) from the float exponent, -1 for black as frexp gives.
+    __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(m), 23), _mm_set1_epi32(127));
+    __m128i black = _mm_castps_si128(_mm_cmpeq_ps(m, zero));
+    exponent = _mm_or_si128(_mm_andnot_si128(black, exponent), _mm_and_si128(black, _mm_set1_epi32(-1)));
+    __m128i inRange = _mm_cmpgt_epi32(exponent, _mm_set1_epi32(-16));
+    exponent = _mm_or_si128(_mm_and_si128(inRange, exponent), _mm_andnot_si128(inRange, _mm_set1_epi32(-16)));
+    __m128i sharedExponent = _mm_add_epi32(exponent, _mm_set1_epi32(16));
+
+    __m128 invDenominator = exp2Integer(_mm_sub_epi32(_mm_set1_epi32(24), sharedExponent));
+    __m128i overflow = _mm_cmpeq_epi32(roundMantissa(m, invDenominator), _mm_set1_epi32(512));
+    sharedExponent = _mm_sub_epi32(sharedExponent, overflow);
+    invDenominator = _mm_mul_ps(invDenominator, selectLanes(_mm_castsi128_ps(overflow), _mm_set1_ps(0.5f), _mm_set1_ps(1.0f)));
+
+    __m128i rm = roundMantissa(r, invDenominator);
+    __m128i gm = roundMantissa(g, invDenominator);
+    __m128i bm = roundMantissa(b, invDenominator);
+    return _mm_or_si128(_mm_or_si128(rm, _mm_slli_epi32(gm, 9)), 
+                        _mm_or_si128(_mm_slli_epi32(bm, 18), _mm_slli_epi32(sharedExponent, 27)));
+}
+
+inline void
+decodeRGB9E5(__m128i packed, float scale, Texels4& texels)
+{
+    const __m128i mask = _mm_set1_epi32(0x1ff);
+    __m128 multiplier = _mm_mul_ps(exp2Integer(_mm_sub_epi32(_mm_srli_epi32(packed, 27), _mm_set1_epi32(24))), 
+                                   _mm_set1_ps(scale));
+    texels.r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(packed, mask)), multiplier);
+    texels.g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 9), mask)), multiplier);
+    texels.b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(packed, 18), mask)), multiplier);
+    texels.a = _mm_set1_ps(1.0f);
+}
+
+//---------------------------------------------------------------------
+// Run a four texel kernel over a row of width texels, the last
+// partial block goes through a padded copy.
+//---------------------------------------------------------------------
+template <typename Kernel>
+void
+encodeRow(const float* rgba, uint32_t* out, size_t width, const Kernel& kernel)
+{
+    Texels4 texels;
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        loadTexels(&rgba[x * 4], texels);
+        _mm_storeu_si128((__m128i*)&out[x], kernel(texels));
+    }
+    if (x < width)
+    {
+        float block[16] = { 0 };
+        uint32_t packed[4];
+        memcpy(block, &rgba[x * 4], (width - x) * 4 * sizeof(float));
+        loadTexels(block, texels);
+        _mm_storeu_si128((__m128i*)packed, kernel(texels));
+        memcpy(&out[x], packed, (width - x) * sizeof(uint32_t));
+    }
+}
+
+template <typename Kernel>
+void
+decodeRow(const uint32_t* in, float* rgba, size_t width, const Kernel& kernel)
+{
+    Texels4 texels;
+    size_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+        kernel(_mm_loadu_si128((const __m128i*)&in[x]), texels);
+        storeTexels(texels, &rgba[x * 4]);
+    }
+    if (x < width)
+    {
+        uint32_t packed[4] = { 0 };
+        float block[16];
+        memcpy(packed, &in[x], (width - x) * sizeof(uint32_t));
+        kernel(_mm_loadu_si128((const __m128i*)packed), texels);
+        storeTexels(texels, block);
+        memcpy(&rgba[x * 4], block, (width - x) * 4 * sizeof(float));
+    }
+}
+#endif
+
+struct PartialStatistics
+{
+    PartialStatistics() : maxChannel(0.0f), logSum(0.0), minLuminance(FLT_MAX), 
+                          maxLuminance(0.0f), count(0), litCount(0), histogram(HDR_HISTOGRAM_BINS, 0) {}
+
+    float                 maxChannel;
+    double                logSum;
+    float                 minLuminance;
+    float                 maxLuminance;
+    size_t                count;
+    size_t                litCount;
+    std::vector<uint32_t> histogram;
+};
+
+struct PartialError
+{
+    PartialError() : sumSquared(0.0), maxRelative(0.0), clipped(0), count(0) {}
+
+    double sumSquared;
+    double maxRelative;
+    size_t clipped;
+    size_t count;
+};
+
+void
+accumulate(HDREncodingError& total, const HDREncodingError& part)
+{
+    size_t count = total.texelCount + part.texelCount;
+    if (count == 0)
+        return;
+    total.rmsRelative = std::sqrt((total.rmsRelative * total.rmsRelative * total.texelCount + 
+                                   part.rmsRelative * part.rmsRelative * part.texelCount) / count);
+    total.clippedFraction = (total.clippedFraction * total.texelCount + 
+                             part.clippedFraction * part.texelCount) / count;
+    total.maxRelative = maxValue(total.maxRelative, part.maxRelative);
+    total.texelCount = count;
+}
+}
+
+HDRStatistics::HDRStatistics() :
+    maxChannel(0.0f),
+    percentileChannel(0.0f),
+    logAverage(0.0f),
+    minLuminance(0.0f),
+    maxLuminance(0.0f),
+    texelCount(0),
+    histogram(HDR_HISTOGRAM_BINS, 0)
+{
+}
+
+float
+HDRStatistics::histogramBinCenter(size_t bin)
+{
+    return HDR_HISTOGRAM_MIN + (float(bin) + 0.5f) * (HDR_HISTOGRAM_MAX - HDR_HISTOGRAM_MIN) / float(HDR_HISTOGRAM_BINS);
+}
+
+HDREncodingError::HDREncodingError() :
+    rmsRelative(0.0),
+    maxRelative(0.0),
+    clippedFraction(0.0),
+    texelCount(0)
+{
+}
+
+HDREncoder::HDREncoder(HDREncoding encoding, float gamma, float clipPercentile) :
+    mEncoding(encoding),
+    mGamma(encoding == HDR_ENCODING_RGBM || encoding == HDR_ENCODING_RGBD ? gamma : 1.0f),
+    mClipPercentile(clamped(clipPercentile, 0.5f, 1.0f))
+{
+    if (mGamma <= 0.0f)
+    {
+        throw(std::exception("Gamma must be positive HDREncoder::HDREncoder"));
+    }
+}
+
+HDREncoder::~HDREncoder()
+{
+}
+
+HDREncoding
+HDREncoder::encoding() const
+{
+    return mEncoding;
+}
+
+const char*
+HDREncoder::encodingName(HDREncoding encoding)
+{
+    switch (encoding)
+    {
+        case HDR_ENCODING_RGBM:   return "RGBM";
+        case HDR_ENCODING_RGBD:   return "RGBD";
+        case HDR_ENCODING_LOGLUV: return "LogLuv";
+        case HDR_ENCODING_RGB9E5: return "RGB9E5";
+    }
+    return "Unknown";
+}
+
+HDRStatistics
+HDREncoder::analyze(const PixelBox* boxes, size_t count) const
+{
+    HDRStatistics statistics;
+    if (count == 0)
+        return statistics;
+
+    std::vector<RowRef> rows = gatherRows(boxes, count);
+    size_t width = 0;
+    for (size_t i = 0; i < count; i++)
+        width = maxValue(width, boxes[i].size().x);
+
+    std::vector<PartialStatistics> partials((rows.size() + HDR_ROWS_PER_TASK - 1) / HDR_ROWS_PER_TASK);
+    const float invGamma = 1.0f / mGamma;
+    const float binScale = float(HDR_HISTOGRAM_BINS) / (HDR_HISTOGRAM_MAX - HDR_HISTOGRAM_MIN);
+
+    parallelRows(rows.size(), width, [&](size_t task, size_t row, float* rgba)
+    {
+        const RowRef& ref = rows[row];
+        PartialStatistics& partial = partials[task];
+        readRow(*ref.box, ref.y, ref.z, rgba);
+
+        for (size_t x = 0; x < ref.box->size().x; x++)
+        {
+            float* c = &rgba[x * 4];
+            prepare(c, invGamma);
+            float m = maxChannel(c);
+            partial.maxChannel = maxValue(partial.maxChannel, m);
+            partial.count++;
+            if (m > 0.0f)
+            {
+                float logM = std::log2(m);
+                partial.logSum += logM;
+                partial.litCount++;
+                size_t bin = size_t(clamped((logM - HDR_HISTOGRAM_MIN) * binScale, 0.0f, float(HDR_HISTOGRAM_BINS - 1)));
+                partial.histogram[bin]++;
+            }
+
+            float y = logLuvY(c);
+            if (y >= HDR_MIN_LUMINANCE)
+            {
+                partial.minLuminance = minValue(partial.minLuminance, y);
+                partial.maxLuminance = maxValue(partial.maxLuminance, y);
+            }
+        }
+    });
+
+    PartialStatistics total;
+    for (const PartialStatistics& partial : partials)
+    {
+        total.maxChannel = maxValue(total.maxChannel, partial.maxChannel);
+        total.logSum += partial.logSum;
+        total.minLuminance = minValue(total.minLuminance, partial.minLuminance);
+        total.maxLuminance = maxValue(total.maxLuminance, partial.maxLuminance);
+        total.count += partial.count;
+        total.litCount += partial.litCount;
+        for (size_t bin = 0; bin < HDR_HISTOGRAM_BINS; bin++)
+            total.histogram[bin] += partial.histogram[bin];
+    }
+
+    statistics.maxChannel = total.maxChannel;
+    statistics.texelCount = total.count;
+    statistics.histogram.swap(total.histogram);
+    statistics.percentileChannel = total.maxChannel;
+    if (total.litCount > 0)
+    {
+        statistics.logAverage = float(total.logSum / double(total.litCount));
+        statistics.minLuminance = total.minLuminance <= total.maxLuminance ? total.minLuminance : 0.0f;
+        statistics.maxLuminance = total.maxLuminance;
+
+        if (mClipPercentile < 1.0f)
+        {
+            // Top of the first bin that reaches the percentile.
+            size_t target = size_t(std::ceil(double(total.litCount) * mClipPercentile));
+            size_t sum = 0;
+            for (size_t bin = 0; bin < HDR_HISTOGRAM_BINS; bin++)
+            {
+                sum += statistics.histogram[bin];
+                if (sum >= target)
+                {
+                    float top = std::exp2(HDR_HISTOGRAM_MIN + float(bin + 1) / binScale);
+                    statistics.percentileChannel = minValue(top, total.maxChannel);
+                    break;
+                }
+            }
+        }
+    }
+    return statistics;
+}
+
+//---------------------------------------------------------------------
+// RGBM: the (percentile) maximum maps to M = 1.
+// RGBD: the error of a texel is half a step of its largest channel,
+//       which shrinks as the divisor grows (texels below 1 get none).
+//       The scale with the smallest expected error over the histogram
+//       is picked, without clipping.
+// LogLuv: the 16 bit log luminance spans the luminance range.
+// RGB9E5: power of two scale that puts the maximum at the top of the
+//         exponent range, so dark texels keep their precision.
+//---------------------------------------------------------------------
+HDREncodingRange
+HDREncoder::fitRange(const HDRStatistics& statistics) const
+{
+    HDREncodingRange range;
+    if (statistics.maxChannel <= 0.0f)
+        return range;
+
+    switch (mEncoding)
+    {
+        case HDR_ENCODING_RGBM:
+            range.scale = maxValue(statistics.percentileChannel, 1e-6f);
+            break;
+        case HDR_ENCODING_RGBD:
+        {
+            float logMaximum = std::log2(statistics.maxChannel);
+            float bestLogScale = logMaximum;
+            double bestError = DBL_MAX;
+            // The divisor bottoms out at 1, so the maximum may sit at most 255 above the scale.
+            for (float logScale = logMaximum - std::log2(255.0f); logScale <= logMaximum; logScale += 0.125f)
+            {
+                double error = 0.0;
+                for (size_t bin = 0; bin < statistics.histogram.size(); bin++)
+                {
+                    if (statistics.histogram[bin] == 0)
+                        continue;
+                    double x = std::exp2(HDRStatistics::histogramBinCenter(bin) - logScale);
+                    double divisor = clamped(std::floor(255.0 / x), 1.0, 255.0);
+                    double relative = 0.5 / (x * divisor);
+                    error += relative * relative * statistics.histogram[bin];
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    bestLogScale = logScale;
+                }
+            }
+            range.scale = std::exp2(bestLogScale);
+            break;
+        }
+        case HDR_ENCODING_LOGLUV:
+            if (statistics.maxLuminance >= HDR_MIN_LUMINANCE)
+            {
+                range.logMaximum = std::log2(statistics.maxLuminance);
+                range.logMinimum = maxValue(std::log2(maxValue(statistics.minLuminance, HDR_MIN_LUMINANCE)), 
+                                            range.logMaximum - 64.0f);
+                range.logMinimum = minValue(range.logMinimum, range.logMaximum - 1.0f);
+            }
+            break;
+        case HDR_ENCODING_RGB9E5:
+            range.scale = std::exp2(std::ceil(std::log2(statistics.maxChannel)) - 15.0f);
+            break;
+    }
+    return range;
+}
+
+float
+HDREncoder::maxEncodable(const HDREncodingRange& range) const
+{
+    switch (mEncoding)
+    {
+        case HDR_ENCODING_RGBM:   return std::pow(range.scale, mGamma);
+        case HDR_ENCODING_RGBD:   return std::pow(range.scale * 255.0f, mGamma);
+        case HDR_ENCODING_LOGLUV: return std::exp2(range.logMaximum);
+        case HDR_ENCODING_RGB9E5: return range.scale * RGB9E5_MAX;
+    }
+    return FLT_MAX;
+}
+
+void
+HDREncoder::encode(const PixelBox& src, const PixelBox& dst, const HDREncodingRange& range) const
+{
+    if (PixelUtil::getNumElemBytes(dst.format) != 4 || PixelUtil::isCompressed(src.format))
+    {
+        throw(std::exception("Destination must have 4 byte texels HDREncoder::encode"));
+    }
+    if (src.size() != dst.size())
+    {
+        throw(std::exception("Source and destination sizes differ HDREncoder::encode"));
+    }
+
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const float invGamma = 1.0f / mGamma;
+    const float invScale = 1.0f / range.scale;
+    const float invLogRange = 1.0f / (range.logMaximum - range.logMinimum);
+
+    parallelRows(height * src.size().z, width, [&](size_t, size_t row, float* rgba)
+    {
+        size_t y = row % height;
+        size_t z = row / height;
+        readRow(src, y, z, rgba);
+        uint32_t* out = (uint32_t*)dst.rowData(y, z);
+
+#if CTR_SSE
+        switch (mEncoding)
+        {
+            case HDR_ENCODING_RGBM:
+                encodeRow(rgba, out, width, [&](Texels4& texels)
+                {
+                    prepare(texels, invGamma);
+                    return encodeRGBM(texels, invScale);
+                });
+                break;
+            case HDR_ENCODING_RGBD:
+                encodeRow(rgba, out, width, [&](Texels4& texels)
+                {
+                    prepare(texels, invGamma);
+                    return encodeRGBD(texels, invScale);
+                });
+                break;
+            case HDR_ENCODING_LOGLUV:
+                encodeRow(rgba, out, width, [&](Texels4& texels)
+                {
+                    prepare(texels, 1.0f);
+                    return encodeLogLuv(texels, range.logMinimum, invLogRange);
+                });
+                break;
+            case HDR_ENCODING_RGB9E5:
+                encodeRow(rgba, out, width, [&](Texels4& texels)
+                {
+                    prepare(texels, 1.0f);
+                    return encodeRGB9E5(texels, invScale);
+                });
+                break;
+        }
+#else
+        switch (mEncoding)
+        {
+            case HDR_ENCODING_RGBM:
+                for (size_t x = 0; x < width; x++)
+                {
+                    prepare(&rgba[x * 4], invGamma);
+                    out[x] = encodeRGBM(&rgba[x * 4], invScale);
+                }
+                break;
+            case HDR_ENCODING_RGBD:
+                for (size_t x = 0; x < width; x++)
+                {
+                    prepare(&rgba[x * 4], invGamma);
+                    out[x] = encodeRGBD(&rgba[x * 4], invScale);
+                }
+                break;
+            case HDR_ENCODING_LOGLUV:
+                for (size_t x = 0; x < width; x++)
+                {
+                    prepare(&rgba[x * 4], 1.0f);
+                    out[x] = encodeLogLuv(&rgba[x * 4], range.logMinimum, invLogRange);
+                }
+                break;
+            case HDR_ENCODING_RGB9E5:
+                for (size_t x = 0; x < width; x++)
+                {
+                    prepare(&rgba[x * 4], 1.0f);
+                    out[x] = encodeRGB9E5(&rgba[x * 4], invScale);
+                }
+                break;
+        }
+#endif
+    });
+}
+
+void
+HDREncoder::decode(const PixelBox& src, const PixelBox& dst, const HDREncodingRange& range) const
+{
+    if (PixelUtil::getNumElemBytes(src.format) != 4 || PixelUtil::isCompressed(dst.format))
+    {
+        throw(std::exception("Source must have 4 byte texels HDREncoder::decode"));
+    }
+    if (src.size() != dst.size())
+    {
+        throw(std::exception("Source and destination sizes differ HDREncoder::decode"));
+    }
+
+    const size_t width = src.size().x;
+    const size_t height = src.size().y;
+    const float logRange = range.logMaximum - range.logMinimum;
+
+    parallelRows(height * src.size().z, width, [&](size_t, size_t row, float* rgba)
+    {
+        size_t y = row % height;
+        size_t z = row / height;
+        const uint32_t* in = (const uint32_t*)src.rowData(y, z);
+
+#if CTR_SSE
+        switch (mEncoding)
+        {
+            case HDR_ENCODING_RGBM:
+                decodeRow(in, rgba, width, [&](__m128i packed, Texels4& texels)
+                {
+                    decodeRGBM(packed, range.scale, texels);
+                    restore(texels, mGamma);
+                });
+                break;
+            case HDR_ENCODING_RGBD:
+                decodeRow(in, rgba, width, [&](__m128i packed, Texels4& texels)
+                {
+                    decodeRGBD(packed, range.scale, texels);
+                    restore(texels, mGamma);
+                });
+                break;
+            case HDR_ENCODING_LOGLUV:
+                decodeRow(in, rgba, width, [&](__m128i packed, Texels4& texels)
+                {
+                    decodeLogLuv(packed, range.logMinimum, logRange, texels);
+                });
+                break;
+            case HDR_ENCODING_RGB9E5:
+                decodeRow(in, rgba, width, [&](__m128i packed, Texels4& texels)
+                {
+                    decodeRGB9E5(packed, range.scale, texels);
+                });
+                break;
+        }
+#else
+        for (size_t x = 0; x < width; x++)
+        {
+            float* c = &rgba[x * 4];
+            switch (mEncoding)
+            {
+                case HDR_ENCODING_RGBM:   decodeRGBM(in[x], range.scale, c); break;
+                case HDR_ENCODING_RGBD:   decodeRGBD(in[x], range.scale, c); break;
+                case HDR_ENCODING_LOGLUV: decodeLogLuv(in[x], range.logMinimum, logRange, c); break;
+                case HDR_ENCODING_RGB9E5: decodeRGB9E5(in[x], range.scale, c); break;
+            }
+            restore(c, mGamma);
+        }
+#endif
+        writeRow(dst, y, z, rgba);
+    });
+}
+
+HDREncodingError
+HDREncoder::measure(const PixelBox& original, const PixelBox& encoded, const HDREncodingRange& range) const
+{
+    if (original.size() != encoded.size())
+    {
+        throw(std::exception("Source and encoded sizes differ HDREncoder::measure"));
+    }
+
+    const size_t width = original.size().x;
+    const size_t height = original.size().y;
+    const size_t numRows = height * original.size().z;
+    const float encodable = maxEncodable(range);
+
+    // Decode into a float copy of the encoded surface, row by row.
+    std::vector<float> decoded(width * numRows * 4);
+    PixelBox decodedBox(width, height, original.size().z, PF_FLOAT32_RGBA, &decoded[0]);
+    decode(encoded, decodedBox, range);
+
+    std::vector<PartialError> partials((numRows + HDR_ROWS_PER_TASK - 1) / HDR_ROWS_PER_TASK);
+    parallelRows(numRows, width, [&](size_t task, size_t row, float* rgba)
+    {
+        PartialError& partial = partials[task];
+        readRow(original, row % height, row / height, rgba);
+        const float* result = &decoded[row * width * 4];
+
+        for (size_t x = 0; x < width; x++)
+        {
+            float* c = &rgba[x * 4];
+            prepare(c, 1.0f);
+            const float* d = &result[x * 4];
+            float m = maxChannel(c);
+            float difference = maxValue(maxValue(std::fabs(d[0] - c[0]), std::fabs(d[1] - c[1])), 
+                                        std::fabs(d[2] - c[2]));
+            double relative = difference / maxValue(m, 1e-4f);
+            partial.sumSquared += relative * relative;
+            partial.maxRelative = maxValue(partial.maxRelative, relative);
+            float brightness = mEncoding == HDR_ENCODING_LOGLUV ? logLuvY(c) : m;
+            partial.clipped += brightness > encodable * 1.001f ? 1 : 0;
+            partial.count++;
+        }
+    });
+
+    PartialError total;
+    for (const PartialError& partial : partials)
+    {
+        total.sumSquared += partial.sumSquared;
+        total.maxRelative = maxValue(total.maxRelative, partial.maxRelative);
+        total.clipped += partial.clipped;
+        total.count += partial.count;
+    }
+
+    HDREncodingError error;
+    if (total.count > 0)
+    {
+        error.rmsRelative = std::sqrt(total.sumSquared / double(total.count));
+        error.maxRelative = total.maxRelative;
+        error.clippedFraction = double(total.clipped) / double(total.count);
+        error.texelCount = total.count;
+    }
+    return error;
+}
+
+std::vector<HDREncodingRange>
+HDREncoder::encode(const TextureImage& src, TextureImage& dst, bool perMip, HDREncodingError* error) const
+{
+    if (PixelUtil::isCompressed(src.getFormat()) || src.getDepth() > 1)
+    {
+        throw(std::exception("Only uncompressed 2D and cube images can be encoded HDREncoder::encode"));
+    }
+
+    const size_t numFaces = src.getNumFaces();
+    const size_t numLevels = src.getNumLevels();
+    dst.create(Vector2i((int32_t)src.getWidth(), (int32_t)src.getHeight()), PF_BYTE_RGBA,
+               (uint32_t)numLevels, src.hasFlag(IF_CUBEMAP) ? IF_CUBEMAP : 0, false);
+
+    std::vector<HDREncodingRange> ranges(numLevels);
+    std::vector<PixelBox> boxes;
+    if (perMip)
+    {
+        for (size_t mipmap = 0; mipmap < numLevels; mipmap++)
+        {
+            boxes.clear();
+            for (size_t face = 0; face < numFaces; face++)
+                boxes.push_back(src.getPixelBox(face, mipmap));
+            ranges[mipmap] = fitRange(analyze(&boxes[0], boxes.size()));
+        }
+    }
+    else
+    {
+        src.forEachPixelBox([&](size_t, size_t, const PixelBox& box) { boxes.push_back(box); });
+        HDREncodingRange range = fitRange(analyze(&boxes[0], boxes.size()));
+        std::fill(ranges.begin(), ranges.end(), range);
+    }
+
+    if (error)
+    {
+        *error = HDREncodingError();
+    }
+
+    for (size_t mipmap = 0; mipmap < numLevels; mipmap++)
+    {
+        for (size_t face = 0; face < numFaces; face++)
+        {
+            PixelBox source = src.getPixelBox(face, mipmap);
+            PixelBox encoded = dst.getPixelBox(face, mipmap);
+            encode(source, encoded, ranges[mipmap]);
+            if (error)
+            {
+                accumulate(*error, measure(source, encoded, ranges[mipmap]));
+            }
+        }
+    }
+
+    return ranges;
+}
+}
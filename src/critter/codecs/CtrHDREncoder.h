@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_HDR_ENCODER
+#define INCLUDED_CRT_HDR_ENCODER
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+
+namespace Ctr
+{
+class TextureImage;
+
+/// 32 bit per texel encodings of HDR color.
+enum HDREncoding
+{
+    HDR_ENCODING_RGBM,
+    HDR_ENCODING_RGBD,
+    HDR_ENCODING_LOGLUV,
+    HDR_ENCODING_RGB9E5
+};
+
+/// Range an encoded surface was fitted to, needed to decode it.
+struct HDREncodingRange
+{
+    HDREncodingRange() : scale(1.0f), logMinimum(-63.5f), logMaximum(64.5f) {}
+
+    /// RGBM, RGBD and RGB9E5: multiplier applied after decoding.
+    float                      scale;
+    /// LogLuv: log2 luminance at the bottom and top of the 16 bit range.
+    float                      logMinimum;
+    float                      logMaximum;
+};
+
+/// Statistics pass over the surfaces that share a range.
+struct HDRStatistics
+{
+    HDRStatistics();
+
+    /// Largest channel (gamma corrected for RGBM and RGBD).
+    float                      maxChannel;
+    /// Largest channel of the texels below the clip percentile.
+    float                      percentileChannel;
+    /// Mean of log2(largest channel) over texels that are not black.
+    float                      logAverage;
+    /// LogLuv luminance range over texels that are not black.
+    float                      minLuminance;
+    float                      maxLuminance;
+    size_t                     texelCount;
+    /// Texel count per log2(largest channel) bin, centered on histogramBinCenter.
+    std::vector<uint32_t>      histogram;
+
+    static float               histogramBinCenter(size_t bin);
+};
+
+/// Encoded against source, measured in linear color.
+struct HDREncodingError
+{
+    HDREncodingError();
+
+    /// Relative error of the largest channel of each texel.
+    double                     rmsRelative;
+    double                     maxRelative;
+    /// Fraction of texels brighter than the range can represent.
+    double                     clippedFraction;
+    size_t                     texelCount;
+};
+
+/** Encodes float color to 32 bits per texel on the CPU.
+@remarks
+    Encoded surfaces have 4 byte texels. RGBM, RGBD and LogLuv are stored as
+    bytes in R, G, B, A memory order (PF_BYTE_RGBA), RGB9E5 as the packed
+    32 bit DXGI_FORMAT_R9G9B9E5_SHAREDEXP word. RGBM and RGBD encode the
+    gamma corrected color (like IblColorConvertEnvironment.fx does), LogLuv
+    and RGB9E5 encode linear color. Each surface is encoded against a range
+    fitted from its statistics instead of a fixed scale.
+*/
+class HDREncoder
+{
+  public:
+    /// clipPercentile below 1 lets RGBM ignore the brightest texels.
+    HDREncoder(HDREncoding encoding, float gamma = 2.2f, float clipPercentile = 1.0f);
+    ~HDREncoder();
+
+    HDREncoding                encoding() const;
+
+    HDRStatistics              analyze(const PixelBox* boxes, size_t count) const;
+    HDREncodingRange           fitRange(const HDRStatistics& statistics) const;
+
+    /// src is any uncompressed color format, dst has 4 byte texels.
+    void                       encode(const PixelBox& src, const PixelBox& dst, 
+                                      const HDREncodingRange& range) const;
+    /// dst is any uncompressed color format.
+    void                       decode(const PixelBox& src, const PixelBox& dst, 
+                                      const HDREncodingRange& range) const;
+    HDREncodingError           measure(const PixelBox& original, const PixelBox& encoded, 
+                                       const HDREncodingRange& range) const;
+
+    /// Encodes every face and mip of src into dst (recreated as PF_BYTE_RGBA).
+    /// Faces of a mip share a range so seams stay consistent, perMip = false
+    /// fits a single range to the whole image. Returns the range of each mip.
+    std::vector<HDREncodingRange> encode(const TextureImage& src, TextureImage& dst, 
+                                         bool perMip = true, 
+                                         HDREncodingError* error = nullptr) const;
+
+    static const char*         encodingName(HDREncoding encoding);
+
+  private:
+    // Brightest linear channel value the range can represent.
+    float                      maxEncodable(const HDREncodingRange& range) const;
+
+    HDREncoding                mEncoding;
+    float                      mGamma;
+    float                      mClipPercentile;
+};
+}
+
+#endif
@@ -0,0 +1,266 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrImageAllocator.h>
+#include <CtrLog.h>
+
+namespace Ctr
+{
+namespace
+{
+const size_t MinimumClassSize = 256;
+const size_t DefaultPoolLimit = 256 * 1024 * 1024;
+
+// Each block is prefixed by a header of one alignment unit.
+struct BlockHeader
+{
+    uint32_t                   sizeClass;
+};
+
+uint8_t*
+alignedAlloc(size_t size)
+{
+#if _WIN32 || _WIN64
+    return static_cast<uint8_t*>(_aligned_malloc(size, ImageAllocator::Alignment));
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, ImageAllocator::Alignment, size) != 0)
+        return nullptr;
+    return static_cast<uint8_t*>(memory);
+#endif
+}
+
+void
+alignedFree(uint8_t* memory)
+{
+#if _WIN32 || _WIN64
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+// Subsystem allocators live for the life of the process, images
+// held by statics may release into them during shutdown.
+std::mutex                     registryMutex;
+std::map<std::string, ImageAllocator*> registry;
+}
+
+ImageAllocator::ImageAllocator(const std::string& name) :
+    _name(name),
+    _poolLimit(DefaultPoolLimit),
+    _bytesInUse(0),
+    _peakBytesInUse(0),
+    _bytesPooled(0),
+    _allocations(0),
+    _poolHits(0)
+{
+}
+
+ImageAllocator::~ImageAllocator()
+{
+    if (_bytesInUse > 0)
+    {
+        LOG_WARNING("ImageAllocator " << _name << " destroyed with " << _bytesInUse << " bytes in use");
+    }
+    trim();
+}
+
+uint32_t
+ImageAllocator::sizeClass(size_t size)
+{
+    if (size <= MinimumClassSize)
+        return 0;
+
+    // Four classes per power of two above the minimum.
+    uint32_t sizeClass = 0;
+    size_t classBytes = MinimumClassSize;
+    while (classBytes < size)
+    {
+        sizeClass++;
+        classBytes = classSize(sizeClass);
+    }
+    return sizeClass;
+}
+
+size_t
+ImageAllocator::classSize(uint32_t sizeClass)
+{
+    size_t octave = sizeClass / 4;
+    size_t step = sizeClass % 4;
+    size_t base = MinimumClassSize << octave;
+    return base + (base / 4) * step;
+}
+
+uint8_t*
+ImageAllocator::allocate(size_t size, bool zeroMemory)
+{
+    uint32_t blockClass = sizeClass(size);
+    size_t blockSize = classSize(blockClass);
+
+    uint8_t* block = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (blockClass < _freeLists.size() && !_freeLists[blockClass].empty())
+        {
+            block = _freeLists[blockClass].back();
+            _freeLists[blockClass].pop_back();
+            _bytesPooled -= blockSize;
+            _poolHits++;
+        }
+        _allocations++;
+        _bytesInUse += blockSize;
+        _peakBytesInUse = std::max(_peakBytesInUse, _bytesInUse);
+    }
+
+    if (!block)
+    {
+        block = alignedAlloc(blockSize + Alignment);
+        if (!block)
+        {
+            THROW("ImageAllocator " << _name << " failed to allocate " << blockSize << " bytes");
+        }
+        reinterpret_cast<BlockHeader*>(block)->sizeClass = blockClass;
+    }
+
+    uint8_t* buffer = block + Alignment;
+    if (zeroMemory)
+        memset(buffer, 0, size);
+    return buffer;
+}
+
+void
+ImageAllocator::deallocate(uint8_t* buffer)
+{
+    if (!buffer)
+        return;
+
+    uint8_t* block = buffer - Alignment;
+    uint32_t blockClass = reinterpret_cast<BlockHeader*>(block)->sizeClass;
+    size_t blockSize = classSize(blockClass);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _bytesInUse -= blockSize;
+        if (_bytesPooled + blockSize <= _poolLimit)
+        {
+            if (blockClass >= _freeLists.size())
+                _freeLists.resize(blockClass + 1);
+            _freeLists[blockClass].push_back(block);
+            _bytesPooled += blockSize;
+            return;
+        }
+    }
+    alignedFree(block);
+}
+
+void
+ImageAllocator::trim()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto listIt = _freeLists.begin(); listIt != _freeLists.end(); listIt++)
+    {
+        for (auto it = listIt->begin(); it != listIt->end(); it++)
+            alignedFree(*it);
+        listIt->clear();
+    }
+    _bytesPooled = 0;
+}
+
+void
+ImageAllocator::setPoolLimit(size_t bytes)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _poolLimit = bytes;
+        if (_bytesPooled <= _poolLimit)
+            return;
+    }
+    trim();
+}
+
+size_t
+ImageAllocator::poolLimit() const
+{
+    return _poolLimit;
+}
+
+ImageAllocatorStats
+ImageAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    ImageAllocatorStats result;
+    result.name = _name;
+    result.bytesInUse = _bytesInUse;
+    result.peakBytesInUse = _peakBytesInUse;
+    result.bytesPooled = _bytesPooled;
+    result.allocations = _allocations;
+    result.poolHits = _poolHits;
+    return result;
+}
+
+const std::string&
+ImageAllocator::name() const
+{
+    return _name;
+}
+
+ImageAllocator*
+ImageAllocator::allocator(const std::string& subsystem)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = registry.find(subsystem);
+    if (it == registry.end())
+    {
+        it = registry.insert(std::make_pair(subsystem, new ImageAllocator(subsystem))).first;
+    }
+    return it->second;
+}
+
+void
+ImageAllocator::allStats(std::vector<ImageAllocatorStats>& stats)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    stats.clear();
+    for (auto it = registry.begin(); it != registry.end(); it++)
+        stats.push_back(it->second->stats());
+}
+
+}
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_IMAGE_ALLOCATOR
+#define INCLUDED_CRT_IMAGE_ALLOCATOR
+
+#include <CtrPlatform.h>
+#include <mutex>
+
+namespace Ctr
+{
+//-----------------------------------------------------------
+// Usage counters for one allocator.
+//-----------------------------------------------------------
+struct ImageAllocatorStats
+{
+    std::string                name;
+    size_t                     bytesInUse;
+    size_t                     peakBytesInUse;
+    size_t                     bytesPooled;
+    size_t                     allocations;
+    size_t                     poolHits;
+};
+
+//-----------------------------------------------------------
+// class ImageAllocator
+// Size class pooled allocator for image buffers.
+// Blocks are 64 byte aligned (cache line / SIMD) and are
+// kept on per class free lists when released, so transient
+// images of the same size are recycled. Size classes are
+// four per power of two, at most 25% slack.
+// One allocator per subsystem, see allocator().
+//-----------------------------------------------------------
+class ImageAllocator
+{
+  public:
+    enum
+    {
+        Alignment = 64
+    };
+
+    ImageAllocator(const std::string& name);
+    ~ImageAllocator();
+
+    // Returned memory is zeroed unless zeroMemory is false,
+    // for callers that overwrite every byte.
+    uint8_t*                   allocate(size_t size, bool zeroMemory = true);
+    void                       deallocate(uint8_t* buffer);
+
+    // Release every pooled block back to the heap.
+    void                       trim();
+
+    void                       setPoolLimit(size_t bytes);
+    size_t                     poolLimit() const;
+
+    ImageAllocatorStats        stats() const;
+    const std::string&         name() const;
+
+    // Shared allocator for a subsystem, created on first use.
+    static ImageAllocator*     allocator(const std::string& subsystem);
+    static void                allStats(std::vector<ImageAllocatorStats>& stats);
+
+  private:
+    ImageAllocator(const ImageAllocator&);
+    ImageAllocator& operator=(const ImageAllocator&);
+
+    static uint32_t            sizeClass(size_t size);
+    static size_t              classSize(uint32_t sizeClass);
+
+    mutable std::mutex         _mutex;
+    std::string                _name;
+    std::vector<std::vector<uint8_t*> > _freeLists;
+    size_t                     _poolLimit;
+    size_t                     _bytesInUse;
+    size_t                     _peakBytesInUse;
+    size_t                     _bytesPooled;
+    size_t                     _allocations;
+    size_t                     _poolHits;
+};
+
+}
+
+#endif
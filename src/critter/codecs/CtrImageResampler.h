@@ -105,16 +105,16 @@ namespace Ctr
             // for the center of the destination pixel, not the top-left corner
             uint64_t sz_48 = (stepz >> 1) - 1;
             for (size_t z = dst.minExtent.z; z < dst.maxExtent.z; z++, sz_48 += stepz) {
-                size_t srczoff = (size_t)(sz_48 >> 48) * src.slicePitch;
+                ptrdiff_t srczoff = ptrdiff_t(sz_48 >> 48) * src.slicePitch;
 
                 uint64_t sy_48 = (stepy >> 1) - 1;
                 for (size_t y = dst.minExtent.y; y < dst.maxExtent.y; y++, sy_48 += stepy) {
-                    size_t srcyoff = (size_t)(sy_48 >> 48) * src.rowPitch;
+                    ptrdiff_t srcyoff = ptrdiff_t(sy_48 >> 48) * src.rowPitch;
 
                     uint64_t sx_48 = (stepx >> 1) - 1;
                     for (size_t x = dst.minExtent.x; x < dst.maxExtent.x; x++, sx_48 += stepx) {
                         uint8_t* psrc = srcdata +
-                            elemsize*((size_t)(sx_48 >> 48) + srcyoff + srczoff);
+                            ptrdiff_t(elemsize)*(ptrdiff_t(sx_48 >> 48) + srcyoff + srczoff);
                         memcpy(pdst, psrc, elemsize);
                         pdst += elemsize;
                     }
@@ -178,7 +178,7 @@ namespace Ctr
                         ColorValue x1y1z2, x2y1z2, x1y2z2, x2y2z2;
 
 #define UNPACK(dst,x,y,z) PixelUtil::unpackColor(&dst, src.format, \
-    srcdata + srcelemsize*((x)+(y)*src.rowPitch+(z)*src.slicePitch))
+    srcdata + ptrdiff_t(srcelemsize)*(ptrdiff_t(x)+ptrdiff_t(y)*src.rowPitch+ptrdiff_t(z)*src.slicePitch))
 
                         UNPACK(x1y1z1, sx1, sy1, sz1); UNPACK(x2y1z1, sx2, sy1, sz1);
                         UNPACK(x1y2z1, sx1, sy2, sz1); UNPACK(x2y2z1, sx2, sy2, sz1);
@@ -264,13 +264,13 @@ namespace Ctr
 
 #define ACCUM3(x,y,z,factor) \
                             { float f = factor; \
-    size_t off = (x+y*src.rowPitch+z*src.slicePitch)*srcchannels; \
+    ptrdiff_t off = (ptrdiff_t(x)+ptrdiff_t(y)*src.rowPitch+ptrdiff_t(z)*src.slicePitch)*ptrdiff_t(srcchannels); \
     accum[0]+=srcdata[off+0]*f; accum[1]+=srcdata[off+1]*f; \
     accum[2]+=srcdata[off+2]*f; }
 
 #define ACCUM4(x,y,z,factor) \
                             { float f = factor; \
-    size_t off = (x+y*src.rowPitch+z*src.slicePitch)*srcchannels; \
+    ptrdiff_t off = (ptrdiff_t(x)+ptrdiff_t(y)*src.rowPitch+ptrdiff_t(z)*src.slicePitch)*ptrdiff_t(srcchannels); \
     accum[0]+=srcdata[off+0]*f; accum[1]+=srcdata[off+1]*f; \
     accum[2]+=srcdata[off+2]*f; accum[3]+=srcdata[off+3]*f; }
 
@@ -354,8 +354,8 @@ namespace Ctr
                 unsigned int syf = temp & 0xFFF;
                 size_t sy1 = temp >> 12;
                 size_t sy2 = std::min(sy1 + 1, src.maxExtent.y - src.minExtent.y - 1);
-                size_t syoff1 = sy1 * src.rowPitch;
-                size_t syoff2 = sy2 * src.rowPitch;
+                ptrdiff_t syoff1 = ptrdiff_t(sy1) * src.rowPitch;
+                ptrdiff_t syoff2 = ptrdiff_t(sy2) * src.rowPitch;
 
                 uint64_t sx_48 = (stepx >> 1) - 1;
                 uint32_t width = uint32_t(dst.maxExtent.x - dst.minExtent.x);
@@ -363,8 +363,8 @@ namespace Ctr
                     temp = static_cast<unsigned int>(sx_48 >> 36);
                     temp = (temp > 0x800) ? temp - 0x800 : 0;
                     unsigned int sxf = temp & 0xFFF;
-                    size_t sx1 = temp >> 12;
-                    size_t sx2 = std::min(sx1 + 1, src.maxExtent.x - src.minExtent.x - 1);
+                    ptrdiff_t sx1 = temp >> 12;
+                    ptrdiff_t sx2 = std::min(sx1 + 1, ptrdiff_t(src.maxExtent.x - src.minExtent.x) - 1);
 
                     unsigned int sxfsyf = sxf*syf;
                     for (unsigned int k = 0; k < channels; k++) {
@@ -375,7 +375,7 @@ namespace Ctr
                             srcdata[(sx2 + syoff2)*channels + k] * sxfsyf;
                         // accum is computed using 8/24-bit fixed-point math
                         // (maximum is 0xFF000000; rounding will not cause overflow)
-                        pdst[(((y * dst.maxExtent.x)+x)*channels) + k] = static_cast<uint8_t>((accum + 0x800000) >> 24);
+                        pdst[((ptrdiff_t(y) * dst.rowPitch + ptrdiff_t(x))*channels) + k] = static_cast<uint8_t>((accum + 0x800000) >> 24);
                     }
                 }
             //}
@@ -72,12 +72,10 @@ template <class U> struct PixelBoxConverter
     static const int ID = U::ID;
     static void conversion(const Ctr::PixelBox &src, const Ctr::PixelBox &dst)
     {
-        typename U::SrcType *srcptr = static_cast<typename U::SrcType*>(src.data)
-            + (src.minExtent.x + src.minExtent.y * src.rowPitch + src.minExtent.z * src.slicePitch);
-        typename U::DstType *dstptr = static_cast<typename U::DstType*>(dst.data)
-            + (dst.minExtent.x + dst.minExtent.y * dst.rowPitch + dst.minExtent.z * dst.slicePitch);
-        const size_t srcSliceSkip = src.getSliceSkip();
-        const size_t dstSliceSkip = dst.getSliceSkip();
+        typename U::SrcType *srcptr = reinterpret_cast<typename U::SrcType*>(src.rowData(0));
+        typename U::DstType *dstptr = reinterpret_cast<typename U::DstType*>(dst.rowData(0));
+        const ptrdiff_t srcSliceSkip = src.getSliceSkip();
+        const ptrdiff_t dstSliceSkip = dst.getSliceSkip();
         const size_t k = src.maxExtent.x - src.minExtent.x;
         for (size_t z = src.minExtent.z; z<src.maxExtent.z; z++)
         {
@@ -754,23 +754,82 @@ namespace Ctr
         //if(!intersects(def))
         //    throw(std::exception("Bounds out of range"));
 
-        const size_t elemSize = PixelUtil::getNumElemBytes(format);
+        const ptrdiff_t elemSize = ptrdiff_t(PixelUtil::getNumElemBytes(format));
         // Calculate new data origin
         // Notice how we do not propagate left/top/front from the incoming box, since
         // the returned pointer is already offset
         PixelBox rval(def.size().x, def.size().y, def.size().z, format, 
-            ((uint8_t*)data) + ((def.minExtent.x-minExtent.x)*elemSize)
-            + ((def.minExtent.y - minExtent.y)*rowPitch*elemSize)
-            + ((def.minExtent.z - minExtent.z)*slicePitch*elemSize)
+            ((uint8_t*)data) + (ptrdiff_t(def.minExtent.x - minExtent.x)*elemSize)
+            + (ptrdiff_t(def.minExtent.y - minExtent.y)*rowPitch*elemSize)
+            + (ptrdiff_t(def.minExtent.z - minExtent.z)*slicePitch*elemSize)
         );
 
         rval.rowPitch = rowPitch;
         rval.slicePitch = slicePitch;
         rval.format = format;
+        rval.swizzle = swizzle;
 
         return rval;
     }
     //-----------------------------------------------------------------------
+    uint8_t* PixelBox::rowData(size_t y, size_t z) const
+    {
+        return static_cast<uint8_t*>(data) + 
+               (ptrdiff_t(minExtent.x) + 
+                ptrdiff_t(minExtent.y + y) * rowPitch + 
+                ptrdiff_t(minExtent.z + z) * slicePitch) * 
+               ptrdiff_t(PixelUtil::getNumElemBytes(format));
+    }
+    //-----------------------------------------------------------------------
+    PixelBox PixelBox::flippedAroundX() const
+    {
+        if (PixelUtil::isCompressed(format))
+            throw(std::exception("Cannot flip a view of a compressed PixelBuffer, PixelBox::flippedAroundX"));
+
+        // Row (size().y - 1 - y) of this box becomes row y of the view.
+        PixelBox rval = *this;
+        rval.data = static_cast<uint8_t*>(data) + 
+                    ptrdiff_t(minExtent.y + maxExtent.y - 1) * rowPitch * 
+                    ptrdiff_t(PixelUtil::getNumElemBytes(format));
+        rval.rowPitch = -rowPitch;
+        return rval;
+    }
+    //-----------------------------------------------------------------------
+    PixelBox PixelBox::swizzled(const PixelSwizzle& order) const
+    {
+        if (!supportsSwizzle(format))
+            throw(std::exception("Pixel format does not support swizzled views, PixelBox::swizzled"));
+
+        // Logical component i of the result is logical component order[i] of
+        // this view, which is stored at physical component swizzle[order[i]].
+        PixelBox rval = *this;
+        for (uint8_t i = 0; i < 4; i++)
+            rval.swizzle.channel[i] = swizzle.channel[order.channel[i]];
+#ifdef _DEBUG
+        for (size_t i = 0; i < PixelUtil::getComponentCount(format); i++)
+            assert(rval.swizzle.channel[i] < PixelUtil::getComponentCount(format));
+#endif
+        return rval;
+    }
+    //-----------------------------------------------------------------------
+    bool PixelBox::supportsSwizzle(PixelFormat format)
+    {
+        if (PixelUtil::isCompressed(format) || PixelUtil::isDepth(format))
+            return false;
+        size_t componentCount = PixelUtil::getComponentCount(format);
+        size_t componentBytes = 0;
+        switch (PixelUtil::getComponentType(format))
+        {
+            case PCT_BYTE:    componentBytes = 1; break;
+            case PCT_SHORT:   componentBytes = 2; break;
+            case PCT_FLOAT16: componentBytes = 2; break;
+            case PCT_FLOAT32: componentBytes = 4; break;
+            default: break;
+        }
+        return componentCount > 1 && 
+               componentCount * componentBytes == PixelUtil::getNumElemBytes(format);
+    }
+    //-----------------------------------------------------------------------
     /**
     * Directly get the description record for provided pixel format. For debug builds,
     * this checks the bounds of fmt with an assertion.
@@ -1312,6 +1371,30 @@ namespace Ctr
 
         bulkPixelConversion(src, dst);
     }
+    //-----------------------------------------------------------------------
+    /* Reorder the components of count pixels between a swizzled view and
+       format order. Gathering reads src through the swizzle, scattering writes
+       dst through it. */
+    static void
+    swizzleComponents(const uint8_t* src, uint8_t* dst, size_t count,
+                      PixelFormat format, const PixelSwizzle& swizzle, bool gather)
+    {
+        const size_t elemBytes = PixelUtil::getNumElemBytes(format);
+        const size_t componentCount = PixelUtil::getComponentCount(format);
+        const size_t componentBytes = elemBytes / componentCount;
+        for (size_t i = 0; i < count; i++, src += elemBytes, dst += elemBytes)
+        {
+            for (size_t c = 0; c < componentCount; c++)
+            {
+                const size_t physical = swizzle.channel[c] * componentBytes;
+                const size_t logical = c * componentBytes;
+                if (gather)
+                    memcpy(dst + logical, src + physical, componentBytes);
+                else
+                    memcpy(dst + physical, src + logical, componentBytes);
+            }
+        }
+    }
 
     void PixelUtil::bulkPixelConversion(const PixelBox &src, const PixelBox &dst)
     {
@@ -1333,6 +1416,41 @@ namespace Ctr
             }
         }
 
+        // Swizzled views are resolved one row at a time: gather the source row
+        // into format order, convert, then scatter into the destination order.
+        if (!src.swizzle.isIdentity() || !dst.swizzle.isIdentity())
+        {
+            const size_t width = src.size().x;
+            const bool srcSwizzled = !src.swizzle.isIdentity();
+            const bool dstSwizzled = !dst.swizzle.isIdentity();
+            std::vector<uint8_t> srcRow(srcSwizzled ? width * getNumElemBytes(src.format) : 0);
+            std::vector<uint8_t> dstRow(dstSwizzled ? width * getNumElemBytes(dst.format) : 0);
+
+            for (size_t z = 0; z < src.size().z; z++)
+            {
+                for (size_t y = 0; y < src.size().y; y++)
+                {
+                    PixelBox srcLine(width, 1, 1, src.format, src.rowData(y, z));
+                    PixelBox dstLine(width, 1, 1, dst.format, dst.rowData(y, z));
+                    if (srcSwizzled)
+                    {
+                        swizzleComponents(srcLine.rowData(0), &srcRow[0], width, src.format, src.swizzle, true);
+                        srcLine.data = &srcRow[0];
+                    }
+                    if (dstSwizzled)
+                    {
+                        dstLine.data = &dstRow[0];
+                    }
+                    bulkPixelConversion(srcLine, dstLine);
+                    if (dstSwizzled)
+                    {
+                        swizzleComponents(&dstRow[0], dst.rowData(y, z), width, dst.format, dst.swizzle, false);
+                    }
+                }
+            }
+            return;
+        }
+
         // The easy case
         if(src.format == dst.format) {
             // Everything consecutive?
@@ -1342,34 +1460,14 @@ namespace Ctr
                 return;
             }
 
-            const size_t srcPixelSize = PixelUtil::getNumElemBytes(src.format);
-            const size_t dstPixelSize = PixelUtil::getNumElemBytes(dst.format);
-            uint8_t *srcptr = static_cast<uint8_t*>(src.data)
-                + (src.minExtent.x + src.minExtent.y * src.rowPitch + src.minExtent.z * src.slicePitch) * srcPixelSize;
-            uint8_t *dstptr = static_cast<uint8_t*>(dst.data)
-                + (dst.minExtent.x + dst.minExtent.y * dst.rowPitch + dst.minExtent.z * dst.slicePitch) * dstPixelSize;
-
-            // Calculate pitches+skips in bytes
-            const size_t srcRowPitchBytes = src.rowPitch*srcPixelSize;
-            //const size_t srcRowSkipBytes = src.getRowSkip()*srcPixelSize;
-            const size_t srcSliceSkipBytes = src.getSliceSkip()*srcPixelSize;
-
-            const size_t dstRowPitchBytes = dst.rowPitch*dstPixelSize;
-            //const size_t dstRowSkipBytes = dst.getRowSkip()*dstPixelSize;
-            const size_t dstSliceSkipBytes = dst.getSliceSkip()*dstPixelSize;
-
-            // Otherwise, copy per row
-            const size_t rowSize = src.size().x*srcPixelSize;
-            for(size_t z=src.minExtent.z; z<src.maxExtent.z; z++)
+            // Otherwise, copy per row. Pitches may be negative (flipped views).
+            const size_t rowSize = src.size().x*PixelUtil::getNumElemBytes(src.format);
+            for(size_t z=0; z<src.size().z; z++)
             {
-                for(size_t y=src.minExtent.y; y<src.maxExtent.y; y++)
+                for(size_t y=0; y<src.size().y; y++)
                 {
-                    memcpy(dstptr, srcptr, rowSize);
-                    srcptr += srcRowPitchBytes;
-                    dstptr += dstRowPitchBytes;
+                    memcpy(dst.rowData(y, z), src.rowData(y, z), rowSize);
                 }
-                srcptr += srcSliceSkipBytes;
-                dstptr += dstSliceSkipBytes;
             }
             return;
         }
@@ -1408,38 +1506,23 @@ namespace Ctr
 
         const size_t srcPixelSize = PixelUtil::getNumElemBytes(src.format);
         const size_t dstPixelSize = PixelUtil::getNumElemBytes(dst.format);
-        uint8_t *srcptr = static_cast<uint8_t*>(src.data)
-            + (src.minExtent.x + src.minExtent.y * src.rowPitch + src.minExtent.z * src.slicePitch) * srcPixelSize;
-        uint8_t *dstptr = static_cast<uint8_t*>(dst.data)
-            + (dst.minExtent.x + dst.minExtent.y * dst.rowPitch + dst.minExtent.z * dst.slicePitch) * dstPixelSize;
-        
-        // Old way, not taking into account box dimensions
-        //uint8_t *srcptr = static_cast<uint8_t*>(src.data), *dstptr = static_cast<uint8_t*>(dst.data);
-
-        // Calculate pitches+skips in bytes
-        const size_t srcRowSkipBytes = src.getRowSkip()*srcPixelSize;
-        const size_t srcSliceSkipBytes = src.getSliceSkip()*srcPixelSize;
-        const size_t dstRowSkipBytes = dst.getRowSkip()*dstPixelSize;
-        const size_t dstSliceSkipBytes = dst.getSliceSkip()*dstPixelSize;
 
         // The brute force fallback
         float r = 0, g = 0, b = 0, a = 1;
-        for(size_t z=src.minExtent.z; z<src.maxExtent.z; z++)
+        for(size_t z=0; z<src.size().z; z++)
         {
-            for(size_t y=src.minExtent.y; y<src.maxExtent.y; y++)
+            for(size_t y=0; y<src.size().y; y++)
             {
-                for(size_t x=src.minExtent.x; x<src.maxExtent.x; x++)
+                uint8_t *srcptr = src.rowData(y, z);
+                uint8_t *dstptr = dst.rowData(y, z);
+                for(size_t x=0; x<src.size().x; x++)
                 {
                     unpackColor(&r, &g, &b, &a, src.format, srcptr);
                     packColor(r, g, b, a, dst.format, dstptr);
                     srcptr += srcPixelSize;
                     dstptr += dstPixelSize;
                 }
-                srcptr += srcRowSkipBytes;
-                dstptr += dstRowSkipBytes;
             }
-            srcptr += srcSliceSkipBytes;
-            dstptr += dstSliceSkipBytes;
         }
     }
 
@@ -1447,17 +1530,35 @@ namespace Ctr
     {
         ColorValue cv;
 
-        size_t pixelSize = PixelUtil::getNumElemBytes(format);
-        size_t pixelOffset = pixelSize * (z * slicePitch + y * rowPitch + x);
-        PixelUtil::unpackColor(&cv, format, (unsigned char *)data + pixelOffset);
+        ptrdiff_t pixelSize = ptrdiff_t(PixelUtil::getNumElemBytes(format));
+        ptrdiff_t pixelOffset = pixelSize * (ptrdiff_t(z) * slicePitch + ptrdiff_t(y) * rowPitch + ptrdiff_t(x));
+        if (swizzle.isIdentity())
+        {
+            PixelUtil::unpackColor(&cv, format, (unsigned char *)data + pixelOffset);
+        }
+        else
+        {
+            uint8_t pixel[16];
+            swizzleComponents((unsigned char *)data + pixelOffset, pixel, 1, format, swizzle, true);
+            PixelUtil::unpackColor(&cv, format, pixel);
+        }
 
         return cv;
     }
 
     void PixelBox::setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z)
     {
-        size_t pixelSize = PixelUtil::getNumElemBytes(format);
-        size_t pixelOffset = pixelSize * (z * slicePitch + y * rowPitch + x);
-        PixelUtil::packColor(cv, format, (unsigned char *)data + pixelOffset);
+        ptrdiff_t pixelSize = ptrdiff_t(PixelUtil::getNumElemBytes(format));
+        ptrdiff_t pixelOffset = pixelSize * (ptrdiff_t(z) * slicePitch + ptrdiff_t(y) * rowPitch + ptrdiff_t(x));
+        if (swizzle.isIdentity())
+        {
+            PixelUtil::packColor(cv, format, (unsigned char *)data + pixelOffset);
+        }
+        else
+        {
+            uint8_t pixel[16];
+            PixelUtil::packColor(cv, format, pixel);
+            swizzleComponents(pixel, (unsigned char *)data + pixelOffset, 1, format, swizzle, false);
+        }
     }
 }
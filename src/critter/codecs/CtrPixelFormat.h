@@ -218,6 +218,41 @@ namespace Ctr
         PCT_COUNT = 4    /// Number of pixel types
     };
     
+    /** Channel order of a PixelBox view relative to its pixel format.
+        Logical component i (r, g, b, a) is stored at physical component channel[i].
+        Only meaningful for formats made of whole byte, short, half or float
+        components (see PixelBox::supportsSwizzle).
+    */
+    struct PixelSwizzle
+    {
+        PixelSwizzle()
+        {
+            channel[0] = 0; channel[1] = 1; channel[2] = 2; channel[3] = 3;
+        }
+        PixelSwizzle(uint8_t c0, uint8_t c1, uint8_t c2, uint8_t c3)
+        {
+            channel[0] = c0; channel[1] = c1; channel[2] = c2; channel[3] = c3;
+        }
+
+        bool isIdentity() const
+        {
+            return channel[0] == 0 && channel[1] == 1 && channel[2] == 2 && channel[3] == 3;
+        }
+
+        PixelSwizzle inverse() const
+        {
+            PixelSwizzle result;
+            for (uint8_t i = 0; i < 4; i++)
+                result.channel[channel[i]] = i;
+            return result;
+        }
+
+        /// Swaps red and blue, the usual RGBA <-> BGRA reinterpretation.
+        static PixelSwizzle redBlueSwap() { return PixelSwizzle(2, 1, 0, 3); }
+
+        uint8_t channel[4];
+    };
+
     typedef Ctr::Vector3<size_t> Vector3ui;
     typedef Ctr::Region <Vector3ui > Region3ui;
     class PixelBox: public Region3ui {
@@ -233,7 +268,7 @@ namespace Ctr
             @param pixelData    Pointer to the actual data
         */
         PixelBox(const Region3ui &extents, PixelFormat pixelFormat, void *pixelData=0):
-            Region3ui(extents), data(pixelData), format(pixelFormat)
+            Region3ui(extents), data(pixelData), format(pixelFormat), swizzle()
         {
             setConsecutive();
         }
@@ -248,7 +283,7 @@ namespace Ctr
         */
         PixelBox(size_t width, size_t height, size_t depth, PixelFormat pixelFormat, void *pixelData=0):
             Region3ui(Ctr::Vector3ui(0, 0, 0), Ctr::Vector3ui(width, height, depth)),
-            data(pixelData), format(pixelFormat)
+            data(pixelData), format(pixelFormat), swizzle()
         {
             setConsecutive();
         }
@@ -313,43 +348,69 @@ namespace Ctr
         /// The pixel format 
         PixelFormat format;
         /** Number of elements between the leftmost pixel of one row and the left
-             pixel of the next. This value must always be equal to size().x (consecutive) 
+             pixel of the next. This can be a negative value (bottom-up view, see
+             flippedAroundX). This value must always be equal to size().x (consecutive) 
             for compressed formats.
         */
-        size_t rowPitch;
+        ptrdiff_t rowPitch;
         /** Number of elements between the top left pixel of one (depth) slice and 
              the top left pixel of the next. This can be a negative value. Must be a multiple of
              rowPitch. This value must always be equal to size().x*size().y (consecutive) 
             for compressed formats.
         */
-        size_t slicePitch;
+        ptrdiff_t slicePitch;
+        /** Order in which the components of format are stored in memory. Lets a
+            BGRA buffer be read as RGBA (and vice versa) without touching it.
+        */
+        PixelSwizzle swizzle;
         
         /** Set the rowPitch and slicePitch so that the buffer is laid out consecutive 
              in memory.
         */        
         void setConsecutive()
         {
-            rowPitch = size().x;
-            slicePitch = size().x*size().y;
+            rowPitch = ptrdiff_t(size().x);
+            slicePitch = ptrdiff_t(size().x*size().y);
         }
         /**    Get the number of elements between one past the rightmost pixel of 
              one row and the leftmost pixel of the next row. (IE this is zero if rows
              are consecutive).
         */
-        size_t getRowSkip() const { return rowPitch - size().x; }
+        ptrdiff_t getRowSkip() const { return rowPitch - ptrdiff_t(size().x); }
         /** Get the number of elements between one past the right bottom pixel of
              one slice and the left top pixel of the next slice. (IE this is zero if slices
              are consecutive).
         */
-        size_t getSliceSkip() const { return slicePitch - (size().y * rowPitch); }
+        ptrdiff_t getSliceSkip() const { return slicePitch - (ptrdiff_t(size().y) * rowPitch); }
 
         /** Return whether this buffer is laid out consecutive in memory (ie the pitches
-             are equal to the dimensions)
+             are equal to the dimensions and the channels are in format order)
         */        
         bool isConsecutive() const 
         { 
-            return rowPitch == size().x && slicePitch == size().x*size().y; 
+            return rowPitch == ptrdiff_t(size().x) && 
+                   slicePitch == ptrdiff_t(size().x*size().y) &&
+                   swizzle.isIdentity();
         }
+
+        /** Address of the first pixel of row y in slice z, both relative to minExtent.
+        */
+        uint8_t* rowData(size_t y, size_t z = 0) const;
+
+        /** Return a view of the same memory with the rows in reverse order.
+            No pixels are moved, the data pointer is moved to the last row and the
+            row pitch is negated.
+        */
+        PixelBox flippedAroundX() const;
+
+        /** Return a view of the same memory with the channels reordered.
+            The swizzle is composed with the current one.
+        */
+        PixelBox swizzled(const PixelSwizzle& order) const;
+
+        /** Return whether a format can be addressed through a non identity swizzle.
+        */
+        static bool supportsSwizzle(PixelFormat format);
         /** Return the size (in bytes) this image would take if it was
             laid out consecutive in memory
           */
@@ -73,6 +73,7 @@ THE SOFTWARE.
 #include <CtrAssetManager.h>
 #include <CtrLog.h>
 #include <CtrImageResampler.h>
+#include <CtrImageAllocator.h>
 
 namespace Ctr
 {
@@ -111,13 +112,35 @@ TextureImage::TextureImage()
     mFlags(0),
     mFormat(PF_UNKNOWN),
     mBuffer( nullptr ),
-    mAutoDelete( true )
+    mAutoDelete( true ),
+    mAllocator( nullptr ),
+    mBufferAllocator( nullptr ),
+    mNumLevels( 0 )
+{
+}
+
+TextureImage::TextureImage(ImageAllocator* allocator)
+    : mWidth(0),
+    mHeight(0),
+    mDepth(0),
+    mBufSize(0),
+    mNumMipmaps(0),
+    mFlags(0),
+    mFormat(PF_UNKNOWN),
+    mBuffer( nullptr ),
+    mAutoDelete( true ),
+    mAllocator( allocator ),
+    mBufferAllocator( nullptr ),
+    mNumLevels( 0 )
 {
 }
 
 TextureImage::TextureImage( const TextureImage &img )
     : mBuffer( nullptr ),
-    mAutoDelete( true )
+    mAutoDelete( true ),
+    mAllocator( img.mAllocator ),
+    mBufferAllocator( nullptr ),
+    mNumLevels( 0 )
 {
     // call assignment operator
     *this = img;
@@ -133,10 +156,43 @@ void TextureImage::freeMemory()
     //Only delete if this was not a dynamic image (meaning app holds & destroys buffer)
     if( mBuffer && mAutoDelete )
     {
-        free(mBuffer);
+        releaseBuffer(mBuffer, mBufferAllocator);
         mBuffer = nullptr;
     }
+    mBufferAllocator = nullptr;
+}
 
+uint8_t* TextureImage::allocateBuffer(size_t size, bool zeroMemory)
+{
+    mBufferAllocator = mAllocator;
+    if (mAllocator)
+    {
+        return mAllocator->allocate(size, zeroMemory);
+    }
+
+    uint8_t* buffer = static_cast<uint8_t*>(malloc(size * sizeof(uint8_t)));
+    if (zeroMemory)
+        memset (buffer, 0, sizeof(uint8_t) * size);
+    return buffer;
+}
+
+void TextureImage::releaseBuffer(uint8_t* buffer, ImageAllocator* allocator)
+{
+    if (allocator)
+        allocator->deallocate(buffer);
+    else
+        free(buffer);
+}
+
+void TextureImage::setAllocator(ImageAllocator* allocator)
+{
+    // The current buffer stays with its owner until released.
+    mAllocator = allocator;
+}
+
+ImageAllocator* TextureImage::allocator() const
+{
+    return mAllocator;
 }
 
 TextureImage & TextureImage::operator = ( const TextureImage &img )
@@ -154,13 +210,15 @@ TextureImage & TextureImage::operator = ( const TextureImage &img )
     //Only create/copy when previous data was not dynamic data
     if( mAutoDelete )
     {
-        mBuffer = (uint8_t*)malloc(mBufSize * sizeof(uint8_t));
+        mBuffer = allocateBuffer(mBufSize, false);
         memcpy( mBuffer, img.mBuffer, mBufSize );
     }
     else
     {
         mBuffer = img.mBuffer;
     }
+    mNumLevels = img.mNumLevels;
+    mLayout = img.mLayout;
 
     return *this;
 }
@@ -173,81 +231,64 @@ TextureImage & TextureImage::flipAroundY()
     }
     
      mNumMipmaps = 0; // TextureImage operations lose precomputed mipmaps
+     updateLayout();
 
-    uint8_t    *pTempBuffer1 = nullptr;
-    uint16_t    *pTempBuffer2 = nullptr;
-    uint8_t    *pTempBuffer3 = nullptr;
-    uint32_t    *pTempBuffer4 = nullptr;
-
-    uint8_t    *src1 = mBuffer, *dst1 = nullptr;
-    uint16_t    *src2 = (uint16_t *)mBuffer, *dst2 = nullptr;
-    uint8_t    *src3 = mBuffer, *dst3 = nullptr;
-    uint32_t *src4 = (uint32_t *)mBuffer, *dst4 = nullptr;
-
-    uint16_t y;
-    switch (mPixelSize)
+    const size_t pixelSize = mPixelSize;
+    const size_t width = mWidth;
+    if (pixelSize == 0 || pixelSize > 16)
     {
-    case 1:
-        pTempBuffer1 = (uint8_t*)malloc(mWidth * mHeight * sizeof(uint8_t));
-        for (y = 0; y < mHeight; y++)
-        {
-            dst1 = (pTempBuffer1 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst1--, src1++, sizeof(uint8_t));
-        }
+        throw( std::exception("Unknown pixel depth TextureImage::flipAroundY" ));
+    }
 
-        memcpy(mBuffer, pTempBuffer1, mWidth * mHeight * sizeof(uint8_t));
-        free(pTempBuffer1);
-        break;
+    // Mirror every row in place, swapping texels from both ends towards the middle.
+    concurrency::parallel_for(size_t(0), size_t(mHeight), [&](size_t y)
+    {
+        uint8_t* row = mBuffer + y * width * pixelSize;
+        size_t left = 0;
+        size_t right = width;
 
-    case 2:
-        pTempBuffer2 = (uint16_t*)malloc(sizeof(uint16_t) * mWidth * mHeight);
-        for (y = 0; y < mHeight; y++)
+#if CTR_SSE
+        if (pixelSize == 4)
         {
-            dst2 = (pTempBuffer2 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst2--, src2++, sizeof(uint16_t));
+            // Four texels from each end per iteration, reversed in register.
+            while (right - left >= 8)
+            {
+                __m128i* leftPtr = (__m128i*)(row + left * 4);
+                __m128i* rightPtr = (__m128i*)(row + (right - 4) * 4);
+                __m128i l = _mm_loadu_si128(leftPtr);
+                __m128i r = _mm_loadu_si128(rightPtr);
+                _mm_storeu_si128(leftPtr, _mm_shuffle_epi32(r, _MM_SHUFFLE(0, 1, 2, 3)));
+                _mm_storeu_si128(rightPtr, _mm_shuffle_epi32(l, _MM_SHUFFLE(0, 1, 2, 3)));
+                left += 4;
+                right -= 4;
+            }
         }
-
-        memcpy(mBuffer, pTempBuffer2, mWidth * mHeight * sizeof(uint16_t));
-        free(pTempBuffer2);
-        break;
-
-    case 3:
-        pTempBuffer3 = (uint8_t*)malloc(mWidth * mHeight * 3 * sizeof(uint8_t));
-        for (y = 0; y < mHeight; y++)
+        else if (pixelSize == 16)
         {
-            size_t offset = ((y * mWidth) + (mWidth - 1)) * 3;
-            dst3 = pTempBuffer3;
-            dst3 += offset;
-            for (size_t x = 0; x < mWidth; x++)
+            while (right - left >= 2)
             {
-                memcpy(dst3, src3, sizeof(uint8_t) * 3);
-                dst3 -= 3; src3 += 3;
+                __m128i* leftPtr = (__m128i*)(row + left * 16);
+                __m128i* rightPtr = (__m128i*)(row + (right - 1) * 16);
+                __m128i l = _mm_loadu_si128(leftPtr);
+                _mm_storeu_si128(leftPtr, _mm_loadu_si128(rightPtr));
+                _mm_storeu_si128(rightPtr, l);
+                left++;
+                right--;
             }
         }
-
-        memcpy(mBuffer, pTempBuffer3, mWidth * mHeight * sizeof(uint8_t) * 3);
-        free(pTempBuffer3);
-        break;
-
-    case 4:
-        pTempBuffer4 = (uint32_t*)malloc(sizeof(uint32_t) *  mWidth * mHeight);
-        for (y = 0; y < mHeight; y++)
+#endif
+        uint8_t texel[16];
+        while (right - left >= 2)
         {
-            dst4 = (pTempBuffer4 + ((y * mWidth) + mWidth - 1));
-            for (uint16_t x = 0; x < mWidth; x++)
-                memcpy(dst4--, src4++, sizeof(uint32_t));
+            uint8_t* leftPtr = row + left * pixelSize;
+            uint8_t* rightPtr = row + (right - 1) * pixelSize;
+            memcpy(texel, leftPtr, pixelSize);
+            memcpy(leftPtr, rightPtr, pixelSize);
+            memcpy(rightPtr, texel, pixelSize);
+            left++;
+            right--;
         }
-
-        memcpy(mBuffer, pTempBuffer4, mWidth * mHeight * sizeof(uint32_t));
-        free(pTempBuffer4);
-        break;
-
-    default:
-        throw( std::exception("Unknown pixel depth TextureImage::flipAroundY" ));
-        break;
-    }
+    });
 
     return *this;
 
@@ -261,21 +302,26 @@ TextureImage & TextureImage::flipAroundX()
     }
     
     mNumMipmaps = 0; // TextureImage operations lose precomputed mipmaps
+    updateLayout();
 
-    size_t rowSpan = mWidth * mPixelSize;
-
-    uint8_t *pTempBuffer = (uint8_t*)malloc(rowSpan * mHeight * sizeof(uint8_t));
-    uint8_t *ptr1 = mBuffer, *ptr2 = pTempBuffer + ( ( mHeight - 1 ) * rowSpan );
+    const size_t rowSpan = mWidth * mPixelSize;
+    const size_t height = mHeight;
 
-    for( uint16_t i = 0; i < mHeight; i++ )
+    // Swap row pairs in place. Rows are exchanged through a small stack
+    // buffer so no task needs a heap allocation.
+    concurrency::parallel_for(size_t(0), height / 2, [&](size_t y)
     {
-        memcpy( ptr2, ptr1, rowSpan );
-        ptr1 += rowSpan; ptr2 -= rowSpan;
-    }
-
-    memcpy( mBuffer, pTempBuffer, rowSpan * mHeight);
-
-    free(pTempBuffer);
+        uint8_t* top = mBuffer + y * rowSpan;
+        uint8_t* bottom = mBuffer + (height - 1 - y) * rowSpan;
+        uint8_t chunk[1024];
+        for (size_t offset = 0; offset < rowSpan; offset += sizeof(chunk))
+        {
+            size_t count = minValue(sizeof(chunk), rowSpan - offset);
+            memcpy(chunk, top + offset, count);
+            memcpy(top + offset, bottom + offset, count);
+            memcpy(bottom + offset, chunk, count);
+        }
+    });
 
     return *this;
 }
@@ -309,6 +355,7 @@ TextureImage& TextureImage::loadDynamicTextureImage(uint8_t* pData, size_t uWidt
     mBufSize = calculateSize(numMipMaps, numFaces, uWidth, uHeight, depth, eFormat);
     mBuffer = pData;
     mAutoDelete = autoDelete;
+    updateLayout();
 
     return *this;
 
@@ -412,8 +459,7 @@ void TextureImage::save(const std::string& filename)
 
     // Wrap in CodecDataPtr, this will delete
     Codec::CodecDataPtr codeDataPtr(imgData);
-    // Wrap memory, be sure not to delete when stream destroyed
-    MemoryDataStreamPtr wrapper(new MemoryDataStream(mBuffer, mBufSize, false));
+    MemoryDataStreamPtr wrapper = faceMajorStream();
 
     pCodec->codeToFile(wrapper, filename, codeDataPtr);
 }
@@ -436,8 +482,7 @@ DataStreamPtr TextureImage::encode(const std::string& formatextension)
     imgData->depth = mDepth;
     // Wrap in CodecDataPtr, this will delete
     Codec::CodecDataPtr codeDataPtr(imgData);
-    // Wrap memory, be sure not to delete when stream destroyed
-    MemoryDataStreamPtr wrapper(new MemoryDataStream(mBuffer, mBufSize, false));
+    MemoryDataStreamPtr wrapper = faceMajorStream();
 
     return pCodec->code(wrapper, codeDataPtr);
 }
@@ -488,6 +533,7 @@ TextureImage & TextureImage::load(DataStreamPtr& stream, const std::string& type
     res.first->setFreeOnClose(false);
     // make sure we delete
     mAutoDelete = true;
+    updateLayout();
 
     return *this;
 }
@@ -621,20 +667,22 @@ void TextureImage::resize(size_t width, size_t height, Filter filter)
     assert(mAutoDelete);
     assert(mDepth == 1);
 
-    // reassign buffer to temp image, make sure auto-delete is true
-    TextureImage temp;
-    temp.loadDynamicTextureImage(mBuffer, mWidth, mHeight, 1, mFormat, true);
-    // do not delete[] mBuffer!  temp will destroy it
+    // keep the old buffer (and its owner) alive until it has been scaled
+    PixelBox source = getPixelBox();
+    uint8_t* sourceBuffer = mBuffer;
+    ImageAllocator* sourceAllocator = mBufferAllocator;
 
-    // set new dimensions, allocate new buffer
+    // set new dimensions, allocate new buffer, every pixel is written by scale
     mWidth = width;
     mHeight = height;
     mBufSize = PixelUtil::getMemorySize(mWidth, mHeight, 1, mFormat);
-    mBuffer = (uint8_t*)malloc(sizeof(uint8_t) * mBufSize);
+    mBuffer = allocateBuffer(mBufSize, false);
     mNumMipmaps = 0; // Loses precomputed mipmaps
+    updateLayout();
 
-    // scale the image from temp into our resized buffer
-    TextureImage::scale(temp.getPixelBox(), getPixelBox(), filter);
+    // scale the image from the old buffer into our resized buffer
+    TextureImage::scale(source, getPixelBox(), filter);
+    releaseBuffer(sourceBuffer, sourceAllocator);
 }
 
 void
@@ -642,26 +690,15 @@ TextureImage::copyFrom(intptr_t dstPtr, bool reverse)
 {   
     const PixelBox& src = getPixelBox();
 
-    if (!reverse)
-    {
-        memcpy(reinterpret_cast<void*>(dstPtr), (void*)src.data, src.getConsecutiveSize());
-    }
-    else
+    // The destination is described as a view, reverse swaps red and blue
+    // while copying instead of in a second pass.
+    PixelBox dst = src;
+    dst.data = reinterpret_cast<void*>(dstPtr);
+    if (reverse && PixelBox::supportsSwizzle(src.format))
     {
-        unsigned char* dst = (unsigned char*)(dstPtr); // Should be based on Template Type
-
-        for (unsigned int i = 0;i < src.size().y; i++)
-        {
-            for (unsigned int j = 0; j < src.size().x; j++)
-            {
-                    size_t x = ((i * src.size().x) + j) * 4;
-                    dst[x  ]   = ((unsigned char*)(src.data))[x];
-                    dst[x+1]   = ((unsigned char*)(src.data))[x+1];
-                    dst[x+2]   = ((unsigned char*)(src.data))[x+2];
-                    dst[x+3]   = ((unsigned char*)(src.data))[x+3];
-            }
-        }
+        dst = dst.swizzled(PixelSwizzle::redBlueSwap());
     }
+    PixelUtil::bulkPixelConversion(src, dst);
 }
 
 void TextureImage::scale(const PixelBox &src, const PixelBox &scaled, Filter filter) 
@@ -670,6 +707,25 @@ void TextureImage::scale(const PixelBox &src, const PixelBox &scaled, Filter fil
     assert(PixelUtil::isAccessible(scaled.format));
     MemoryDataStreamPtr buf;
 
+    // The resamplers address components directly, so swizzled views are
+    // resolved through a buffer in format order first.
+    if (!src.swizzle.isIdentity())
+    {
+        buf.reset(new MemoryDataStream(src.getConsecutiveSize()));
+        PixelBox resolved(src.size().x, src.size().y, src.size().z, src.format, buf->getPtr());
+        PixelUtil::bulkPixelConversion(src, resolved);
+        scale(resolved, scaled, filter);
+        return;
+    }
+    if (!scaled.swizzle.isIdentity())
+    {
+        buf.reset(new MemoryDataStream(scaled.getConsecutiveSize()));
+        PixelBox resolved(scaled.size().x, scaled.size().y, scaled.size().z, scaled.format, buf->getPtr());
+        scale(src, resolved, filter);
+        PixelUtil::bulkPixelConversion(resolved, scaled);
+        return;
+    }
+
     PixelBox temp;
     switch (filter) 
     {
@@ -779,7 +835,7 @@ void TextureImage::setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z
 
 PixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
 {
-    // TextureImage data is arranged as:
+    // TextureImage data is arranged as (face major):
     // face 0, top level (mip 0)
     // face 0, mip 1
     // face 0, mip 2
@@ -787,45 +843,134 @@ PixelBox TextureImage::getPixelBox(size_t face, size_t mipmap) const
     // face 1, mip 1
     // face 1, mip 2
     // etc
-    if(mipmap > getNumMipmaps())
+    // or with IF_MIP_MAJOR:
+    // mip 0, face 0 .. face 5
+    // mip 1, face 0 .. face 5
+    // etc
+    if(mipmap >= mNumLevels)
         throw(std::exception("Mipmap index out of range TextureImage::getPixelBox" )) ;
     if(face >= getNumFaces())
         throw(std::exception("Face index out of range TextureImage::getPixelBox"));
-    // Calculate mipmap offset and size
-    // Not mine. [MattD].
-    uint8_t *offset = const_cast<uint8_t*>(getData());
-    // Base offset is number of full faces
-    size_t width = getWidth(), height=getHeight(), depth=getDepth();
-    size_t numMips = getNumMipmaps();
-
-    // Figure out the offsets 
-    size_t fullFaceSize = 0;
-    size_t finalFaceSize = 0;
-    size_t finalWidth = 0, finalHeight = 0, finalDepth = 0;
-
-    size_t mipRange = Ctr::Limits<int32_t>::maxVal(int32_t(0), int32_t(numMips - 1));
-    for(size_t mip = 0; mip <= mipRange; ++mip)
-    {
-        if (mip == mipmap)
-        {
-            finalFaceSize = fullFaceSize;
-            finalWidth = width;
-            finalHeight = height;
-            finalDepth = depth;
-        }
-        fullFaceSize += PixelUtil::getMemorySize(width, height, depth, getFormat());
+
+    return pixelBox(mLayout[face * mNumLevels + mipmap]);
+}
+
+PixelBox TextureImage::pixelBox(const SurfaceLayout& surface) const
+{
+    return PixelBox(surface.width, surface.height, surface.depth, mFormat, mBuffer + surface.offset);
+}
+
+size_t TextureImage::getNumLevels() const
+{
+    return mNumLevels;
+}
+
+size_t TextureImage::getMipSize(size_t mipmap) const
+{
+    if(mipmap >= mNumLevels)
+        throw(std::exception("Mipmap index out of range TextureImage::getMipSize" )) ;
+
+    const SurfaceLayout& surface = mLayout[mipmap];
+    return PixelUtil::getMemorySize(surface.width, surface.height, surface.depth, mFormat) * getNumFaces();
+}
+
+void TextureImage::updateLayout()
+{
+    mNumLevels = Ctr::maxValue(size_t(1), mNumMipmaps);
+    computeLayout(mLayout, mNumLevels, getNumFaces(), 
+                  mWidth, mHeight, mDepth, mFormat, 
+                  hasFlag(IF_MIP_MAJOR));
+}
+
+void TextureImage::computeLayout(std::vector<SurfaceLayout>& layout,
+                                 size_t levels, size_t faces,
+                                 size_t width, size_t height, size_t depth,
+                                 PixelFormat format, bool mipMajor)
+{
+    layout.resize(levels * faces);
+
+    // Dimensions and sizes of each level, shared by every face.
+    std::vector<size_t> levelSize(levels);
+    size_t faceStride = 0;
+    for (size_t mip = 0; mip < levels; mip++)
+    {
+        SurfaceLayout& surface = layout[mip];
+        surface.width = width;
+        surface.height = height;
+        surface.depth = depth;
+        levelSize[mip] = PixelUtil::getMemorySize(width, height, depth, format);
+        faceStride += levelSize[mip];
 
         /// Half size in each dimension
         if(width!=1) width /= 2;
         if(height!=1) height /= 2;
         if(depth!=1) depth /= 2;
     }
-    // Advance pointer by number of full faces, plus mip offset into
-    offset += face * fullFaceSize;
-    offset += finalFaceSize;
-    // Return subface as pixelbox
-    PixelBox src(finalWidth, finalHeight, finalDepth, getFormat(), offset);
-    return src;
+
+    size_t mipOffset = 0;
+    size_t levelOffset = 0;
+    for (size_t mip = 0; mip < levels; mip++)
+    {
+        for (size_t face = 0; face < faces; face++)
+        {
+            SurfaceLayout& surface = layout[face * levels + mip];
+            surface = layout[mip];
+            surface.offset = mipMajor ? mipOffset + face * levelSize[mip] 
+                                      : face * faceStride + levelOffset;
+        }
+        mipOffset += levelSize[mip] * faces;
+        levelOffset += levelSize[mip];
+    }
+}
+
+TextureImage & TextureImage::setMipMajor(bool mipMajor)
+{
+    if (hasFlag(IF_MIP_MAJOR) == mipMajor)
+        return *this;
+
+    std::vector<SurfaceLayout> source = mLayout;
+    mFlags = mipMajor ? (mFlags | IF_MIP_MAJOR) : (mFlags & ~IF_MIP_MAJOR);
+    updateLayout();
+
+    if (!mBuffer)
+        return *this;
+
+    // Surfaces move through a copy of the old buffer, so buffers owned by the
+    // application (loadDynamicTextureImage) can be reordered as well.
+    uint8_t* copy = (uint8_t*)malloc(mBufSize);
+    memcpy(copy, mBuffer, mBufSize);
+    concurrency::parallel_for(size_t(0), mLayout.size(), [&](size_t surfaceId)
+    {
+        const SurfaceLayout& surface = mLayout[surfaceId];
+        memcpy(mBuffer + surface.offset, copy + source[surfaceId].offset,
+               PixelUtil::getMemorySize(surface.width, surface.height, surface.depth, mFormat));
+    });
+    free(copy);
+
+    return *this;
+}
+
+MemoryDataStreamPtr TextureImage::faceMajorStream() const
+{
+    if (!hasFlag(IF_MIP_MAJOR))
+    {
+        // Wrap memory, be sure not to delete when stream destroyed
+        return MemoryDataStreamPtr(new MemoryDataStream(mBuffer, mBufSize, false));
+    }
+
+    // Codecs write face major surfaces.
+    std::vector<SurfaceLayout> faceMajor;
+    computeLayout(faceMajor, mNumLevels, getNumFaces(), mWidth, mHeight, mDepth, mFormat, false);
+
+    MemoryDataStreamPtr stream(new MemoryDataStream(mBufSize));
+    uint8_t* dst = stream->getPtr();
+    for (size_t surfaceId = 0; surfaceId < mLayout.size(); surfaceId++)
+    {
+        const SurfaceLayout& surface = mLayout[surfaceId];
+        memcpy(dst + faceMajor[surfaceId].offset, mBuffer + surface.offset,
+               PixelUtil::getMemorySize(surface.width, surface.height, surface.depth, mFormat));
+    }
+    return stream;
 }
 
 size_t TextureImage::calculateSize(size_t mipmaps, size_t faces, size_t width, size_t height, size_t depth, 
@@ -867,7 +1012,8 @@ TextureImage & TextureImage::loadTwoTextureImagesAsRGBA(DataStreamPtr& rgbStream
 }
 
 TextureImage & 
-TextureImage::create(const Ctr::Vector2i& size, PixelFormat format, uint32_t numMipMaps, uint32_t flags)
+TextureImage::create(const Ctr::Vector2i& size, PixelFormat format, uint32_t numMipMaps, uint32_t flags,
+                     bool zeroMemory)
 {
     freeMemory();
 
@@ -889,11 +1035,11 @@ TextureImage::create(const Ctr::Vector2i& size, PixelFormat format, uint32_t num
     // error check here.
     // PF_UNKNOWN, mBufSize etc
 
-    mBuffer = static_cast<uint8_t*>(malloc(mBufSize * sizeof(uint8_t)));
-    memset (mBuffer, 0, sizeof(uint8_t) * mBufSize);
+    mBuffer = allocateBuffer(mBufSize, zeroMemory);
 
     // make sure we delete
     mAutoDelete = true;
+    updateLayout();
 
     return *this;
 }
@@ -943,15 +1089,16 @@ TextureImage & TextureImage::combineTwoTextureImagesAsRGBA(const TextureImage& r
 
     mPixelSize = static_cast<uint8_t>(PixelUtil::getNumElemBytes( mFormat ));
 
-    mBuffer = static_cast<uint8_t*>(malloc(mBufSize * sizeof(uint8_t)));
+    // Every surface is written by the conversions below.
+    mBuffer = allocateBuffer(mBufSize, false);
 
     // make sure we delete
     mAutoDelete = true;
-
+    updateLayout();
 
     for (size_t face = 0; face < numFaces; ++face)
     {
-        for (size_t mip = 0; mip <= mNumMipmaps; ++mip)
+        for (size_t mip = 0; mip < getNumLevels(); ++mip)
         {
             // convert the RGB first
             PixelBox srcRGB = rgb.getPixelBox(face, mip);
@@ -962,11 +1109,11 @@ TextureImage & TextureImage::combineTwoTextureImagesAsRGBA(const TextureImage& r
             PixelBox srcAlpha = alpha.getPixelBox(face, mip);
             uint8_t* psrcAlpha = static_cast<uint8_t*>(srcAlpha.data);
             uint8_t* pdst = static_cast<uint8_t*>(dst.data);
-            for (size_t d = 0; d < mDepth; ++d)
+            for (size_t d = 0; d < dst.size().z; ++d)
             {
-                for (size_t y = 0; y < mHeight; ++y)
+                for (size_t y = 0; y < dst.size().y; ++y)
                 {
-                    for (size_t x = 0; x < mWidth; ++x)
+                    for (size_t x = 0; x < dst.size().x; ++x)
                     {
                         ColorValue colRGBA, colA;
                         // read RGB back from dest to save having another pointer
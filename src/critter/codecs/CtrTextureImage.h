@@ -73,15 +73,21 @@ THE SOFTWARE.
 #include <CtrPixelFormat.h>
 #include <CtrDataStream.h>
 #include <CtrHash.h>
+#include <ppl.h>
 
 namespace Ctr
 {
+class ImageAllocator;
+
 enum TextureImageFlags
 {
     IF_DEFAULT    = 0x00000000,
     IF_COMPRESSED = 0x00000001,
     IF_CUBEMAP    = 0x00000002,
-    IF_3D_TEXTURE = 0x00000004
+    IF_3D_TEXTURE = 0x00000004,
+    // Buffer holds every face of mip 0, then every face of mip 1 and so on.
+    // Without it the buffer holds every mip of face 0, then face 1 (DDS order).
+    IF_MIP_MAJOR  = 0x00000008
 };
 
 class TextureImage
@@ -91,6 +97,8 @@ class TextureImage
 
   public:
     TextureImage();
+    // Buffers created by this image come from the allocator (heap if null).
+    TextureImage(ImageAllocator* allocator);
     TextureImage( const TextureImage &img );
     virtual ~TextureImage();
 
@@ -125,7 +133,12 @@ class TextureImage
     }
 
 
-    TextureImage &  create(const Ctr::Vector2i& size, PixelFormat format, uint32_t numMipMaps = 1, uint32_t flags = 0);
+    // Pass zeroMemory = false when every pixel is written after creation.
+    TextureImage &  create(const Ctr::Vector2i& size, PixelFormat format, uint32_t numMipMaps = 1, uint32_t flags = 0,
+                           bool zeroMemory = true);
+
+    void            setAllocator(ImageAllocator* allocator);
+    ImageAllocator* allocator() const;
 
     TextureImage & load(const std::string& filename, 
                         const std::string& groupName,
@@ -181,8 +194,62 @@ class TextureImage
     
     void setColorAt(ColorValue const &cv, size_t x, size_t y, size_t z);
 
+    // Constant time, offsets are tabled when the layout changes.
     PixelBox getPixelBox(size_t face = 0, size_t mipmap = 0) const;
 
+    // Number of mip levels stored per face (at least 1).
+    size_t getNumLevels() const;
+
+    // Size in bytes of one mip level across all faces. With IF_MIP_MAJOR this
+    // is a single contiguous span starting at getPixelBox(0, mipmap).data.
+    size_t getMipSize(size_t mipmap) const;
+
+    // Reorders the buffer between face major (default) and mip major storage.
+    TextureImage & setMipMajor(bool mipMajor);
+
+    // Calls function(face, mipmap, box) for every surface in memory order.
+    template <typename Function>
+    void forEachPixelBox(Function function) const
+    {
+        const size_t numFaces = getNumFaces();
+        if (hasFlag(IF_MIP_MAJOR))
+        {
+            for (size_t mipmap = 0; mipmap < mNumLevels; mipmap++)
+                for (size_t face = 0; face < numFaces; face++)
+                    function(face, mipmap, pixelBox(mLayout[face * mNumLevels + mipmap]));
+        }
+        else
+        {
+            for (size_t face = 0; face < numFaces; face++)
+                for (size_t mipmap = 0; mipmap < mNumLevels; mipmap++)
+                    function(face, mipmap, pixelBox(mLayout[face * mNumLevels + mipmap]));
+        }
+    }
+
+    // Calls function(mipmap, faceBoxes, numFaces) with every face of a mip.
+    // Mips are independent, so they are dispatched in parallel when requested.
+    template <typename Function>
+    void forEachMip(Function function, bool parallel = false) const
+    {
+        auto visit = [&](size_t mipmap)
+        {
+            PixelBox faces[6];
+            for (size_t face = 0; face < getNumFaces(); face++)
+                faces[face] = getPixelBox(face, mipmap);
+            function(mipmap, faces, getNumFaces());
+        };
+
+        if (parallel)
+        {
+            concurrency::parallel_for(size_t(0), mNumLevels, visit);
+        }
+        else
+        {
+            for (size_t mipmap = 0; mipmap < mNumLevels; mipmap++)
+                visit(mipmap);
+        }
+    }
+
     void freeMemory();
 
     enum Filter
@@ -206,6 +273,27 @@ class TextureImage
     bool   valid() const;
 
   protected:
+    struct SurfaceLayout
+    {
+        size_t offset;
+        size_t width;
+        size_t height;
+        size_t depth;
+    };
+
+    uint8_t* allocateBuffer(size_t size, bool zeroMemory);
+    static void releaseBuffer(uint8_t* buffer, ImageAllocator* allocator);
+
+    // Rebuilds mLayout from the dimensions, mip count, faces and layout flag.
+    void     updateLayout();
+    static void computeLayout(std::vector<SurfaceLayout>& layout,
+                              size_t levels, size_t faces,
+                              size_t width, size_t height, size_t depth,
+                              PixelFormat format, bool mipMajor);
+    PixelBox pixelBox(const SurfaceLayout& surface) const;
+    // The buffer in face major order, wrapped without a copy when possible.
+    MemoryDataStreamPtr faceMajorStream() const;
+
     size_t mWidth;
     size_t mHeight;
     size_t mDepth;
@@ -219,6 +307,14 @@ class TextureImage
     uint8_t* mBuffer;
 
     bool mAutoDelete;
+
+    // Allocator for new buffers, and the owner of mBuffer (null for heap).
+    ImageAllocator* mAllocator;
+    ImageAllocator* mBufferAllocator;
+
+    // Surfaces indexed by face * mNumLevels + mip.
+    size_t                     mNumLevels;
+    std::vector<SurfaceLayout> mLayout;
 };
 
 uint32_t numberOfMipsInChain(uint32_t levelZero);
@@ -168,6 +168,13 @@ bool InputState::buttonOrKeyPressed()
     return false;
 }
 
+// Any buffered event or held button since the last poll.
+bool InputState::hasActivity() throw()
+{
+    return _keyboardElements > 0 || _mouseElements > 0 ||
+           _leftMouseDown || _rightMouseDown || _middleMouseDown;
+}
+
 bool InputState::middleMouseDown()
 {
     return _middleMouseDown;
@@ -129,6 +129,7 @@ class InputState
                                              DWORD state)throw();
     bool                        getKeyState(DWORD key)throw();
     bool                        buttonOrKeyPressed() throw();
+    bool                        hasActivity() throw();
     bool                        getRepeat(int index) throw()
         {    return _repeated[index].isRepeated (_repeatMargin); }; 
 
@@ -0,0 +1,298 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_FRUSTUM
+#define INCLUDED_CRT_FRUSTUM
+
+#include <CtrPlatform.h>
+#include <CtrMath.h>
+#include <CtrVector3.h>
+#include <CtrMatrix44.h>
+#include <CtrRegion.h>
+
+namespace Ctr
+{
+enum FrustumTest
+{
+    FrustumOutside = 0,
+    FrustumIntersects = 1,
+    FrustumInside = 2
+};
+
+//------------------------------------------------------------
+// Empty bounds, grows on the first expand.
+//------------------------------------------------------------
+inline Region3f
+emptyBounds()
+{
+    return Region3f(Vector3f(FLT_MAX, FLT_MAX, FLT_MAX),
+                    Vector3f(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+}
+
+//------------------------------------------------------------
+// Bounds that contain everything, never culled.
+//------------------------------------------------------------
+inline Region3f
+infiniteBounds()
+{
+    return Region3f(Vector3f(-FLT_MAX, -FLT_MAX, -FLT_MAX),
+                    Vector3f(FLT_MAX, FLT_MAX, FLT_MAX));
+}
+
+inline bool
+boundsValid(const Region3f& bounds)
+{
+    return bounds.minExtent.x <= bounds.maxExtent.x &&
+           bounds.minExtent.y <= bounds.maxExtent.y &&
+           bounds.minExtent.z <= bounds.maxExtent.z;
+}
+
+inline void
+expandBounds(Region3f& bounds, const Vector3f& p)
+{
+    bounds.minExtent.x = minValue(bounds.minExtent.x, p.x);
+    bounds.minExtent.y = minValue(bounds.minExtent.y, p.y);
+    bounds.minExtent.z = minValue(bounds.minExtent.z, p.z);
+    bounds.maxExtent.x = maxValue(bounds.maxExtent.x, p.x);
+    bounds.maxExtent.y = maxValue(bounds.maxExtent.y, p.y);
+    bounds.maxExtent.z = maxValue(bounds.maxExtent.z, p.z);
+}
+
+inline void
+expandBounds(Region3f& bounds, const Region3f& other)
+{
+    expandBounds(bounds, other.minExtent);
+    expandBounds(bounds, other.maxExtent);
+}
+
+inline Vector3f
+boundsCenter(const Region3f& bounds)
+{
+    return Vector3f((bounds.minExtent.x + bounds.maxExtent.x) * 0.5f,
+                    (bounds.minExtent.y + bounds.maxExtent.y) * 0.5f,
+                    (bounds.minExtent.z + bounds.maxExtent.z) * 0.5f);
+}
+
+inline float
+boundsSurfaceArea(const Region3f& bounds)
+{
+    if (!boundsValid(bounds))
+        return 0.0f;
+    Vector3f d = bounds.maxExtent - bounds.minExtent;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// Bounds of float3 positions in a strided stream (stride in floats).
+inline Region3f
+computeBounds(const float* positions, uint32_t stride, size_t count)
+{
+    Region3f bounds = emptyBounds();
+    for (size_t i = 0; i < count; i++, positions += stride)
+    {
+        expandBounds(bounds, Vector3f(positions[0], positions[1], positions[2]));
+    }
+    return bounds;
+}
+
+// Transformed axis aligned bounds (Arvo).
+inline Region3f
+transformBounds(const Region3f& bounds, const Matrix44f& m)
+{
+    if (!boundsValid(bounds))
+        return bounds;
+
+    Region3f result (m.translation());
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            float a = m._m[j][i] * bounds.minExtent[j];
+            float b = m._m[j][i] * bounds.maxExtent[j];
+            result.minExtent[i] += minValue(a, b);
+            result.maxExtent[i] += maxValue(a, b);
+        }
+    }
+    return result;
+}
+
+inline bool
+boundsIntersectSphere(const Region3f& bounds, const Vector3f& center, float radius)
+{
+    float distanceSq = 0.0f;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        float v = center[i];
+        if (v < bounds.minExtent[i])
+            distanceSq += (bounds.minExtent[i] - v) * (bounds.minExtent[i] - v);
+        else if (v > bounds.maxExtent[i])
+            distanceSq += (v - bounds.maxExtent[i]) * (v - bounds.maxExtent[i]);
+    }
+    return distanceSq <= radius * radius;
+}
+
+//------------------------------------------------------------
+// Frustum
+//
+// Six planes extracted from a (row vector) view projection
+// matrix with D3D clip space (0 <= z <= w).
+// Planes are stored as structure of arrays and padded to 8
+// so that the box test runs as two 4 wide SSE batches.
+//------------------------------------------------------------
+class Frustum
+{
+  public:
+    Frustum()
+    {
+        Matrix44f identity;
+        set (identity);
+    }
+
+    Frustum(const Matrix44f& viewProj)
+    {
+        set (viewProj);
+    }
+
+    void                       set(const Matrix44f& viewProj)
+    {
+        const Matrix44f& m = viewProj;
+        // Columns of the row vector matrix give clip x, y, z, w.
+        float planes[6][4];
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            float cx = m._m[i][0];
+            float cy = m._m[i][1];
+            float cz = m._m[i][2];
+            float cw = m._m[i][3];
+            planes[0][i] = cw + cx; // left
+            planes[1][i] = cw - cx; // right
+            planes[2][i] = cw + cy; // bottom
+            planes[3][i] = cw - cy; // top
+            planes[4][i] = cz;      // near
+            planes[5][i] = cw - cz; // far
+        }
+
+        for (uint32_t p = 0; p < 8; p++)
+        {
+            if (p < 6)
+            {
+                float length = sqrtf(planes[p][0] * planes[p][0] +
+                                     planes[p][1] * planes[p][1] +
+                                     planes[p][2] * planes[p][2]);
+                float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+                _nx[p] = planes[p][0] * invLength;
+                _ny[p] = planes[p][1] * invLength;
+                _nz[p] = planes[p][2] * invLength;
+                _d[p] = planes[p][3] * invLength;
+            }
+            else
+            {
+                // Padding planes that accept everything.
+                _nx[p] = _ny[p] = _nz[p] = 0.0f;
+                _d[p] = FLT_MAX;
+            }
+        }
+    }
+
+    FrustumTest                classify(const Region3f& bounds) const
+    {
+        float cx = (bounds.minExtent.x + bounds.maxExtent.x) * 0.5f;
+        float cy = (bounds.minExtent.y + bounds.maxExtent.y) * 0.5f;
+        float cz = (bounds.minExtent.z + bounds.maxExtent.z) * 0.5f;
+        float ex = (bounds.maxExtent.x - bounds.minExtent.x) * 0.5f;
+        float ey = (bounds.maxExtent.y - bounds.minExtent.y) * 0.5f;
+        float ez = (bounds.maxExtent.z - bounds.minExtent.z) * 0.5f;
+
+#if CTR_SSE
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), vcz = _mm_set1_ps(cz);
+        __m128 vex = _mm_set1_ps(ex), vey = _mm_set1_ps(ey), vez = _mm_set1_ps(ez);
+
+        int outside = 0;
+        int intersects = 0;
+        for (uint32_t p = 0; p < 8; p += 4)
+        {
+            __m128 nx = _mm_loadu_ps(&_nx[p]);
+            __m128 ny = _mm_loadu_ps(&_ny[p]);
+            __m128 nz = _mm_loadu_ps(&_nz[p]);
+            __m128 d = _mm_loadu_ps(&_d[p]);
+
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vcx), _mm_mul_ps(ny, vcy)),
+                                         _mm_add_ps(_mm_mul_ps(nz, vcz), d));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, signMask), vex),
+                                                  _mm_mul_ps(_mm_and_ps(ny, signMask), vey)),
+                                       _mm_mul_ps(_mm_and_ps(nz, signMask), vez));
+
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            intersects |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+        }
+        if (outside)
+            return FrustumOutside;
+        return intersects ? FrustumIntersects : FrustumInside;
+#else
+        FrustumTest result = FrustumInside;
+        for (uint32_t p = 0; p < 6; p++)
+        {
+            float distance = _nx[p] * cx + _ny[p] * cy + _nz[p] * cz + _d[p];
+            float radius = fabsf(_nx[p]) * ex + fabsf(_ny[p]) * ey + fabsf(_nz[p]) * ez;
+            if (distance + radius < 0.0f)
+                return FrustumOutside;
+            if (distance - radius < 0.0f)
+                result = FrustumIntersects;
+        }
+        return result;
+#endif
+    }
+
+    bool                       intersects(const Region3f& bounds) const
+    {
+        return classify(bounds) != FrustumOutside;
+    }
+
+  private:
+    alignas(CTR_SIMD_ALIGNMENT) float _nx[8];
+    alignas(CTR_SIMD_ALIGNMENT) float _ny[8];
+    alignas(CTR_SIMD_ALIGNMENT) float _nz[8];
+    alignas(CTR_SIMD_ALIGNMENT) float _d[8];
+};
+
+}
+
+#endif
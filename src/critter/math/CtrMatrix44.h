@@ -114,6 +114,53 @@ public:
         return *this;
     }
 
+    Matrix44<T>                transposed() const
+    {
+        Matrix44<T> result (*this);
+        return result.transpose();
+    }
+
+    // General inverse by cofactor expansion.
+    // Returns false and leaves the matrix untouched if it is singular.
+    bool                       invert()
+    {
+        const T* m = _mat;
+        T inv[16];
+
+        inv[0]  =  m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+        inv[4]  = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+        inv[8]  =  m[4]*m[9]*m[15]  - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+        inv[12] = -m[4]*m[9]*m[14]  + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+        inv[1]  = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+        inv[5]  =  m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+        inv[9]  = -m[0]*m[9]*m[15]  + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+        inv[13] =  m[0]*m[9]*m[14]  - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+        inv[2]  =  m[1]*m[6]*m[15]  - m[1]*m[7]*m[14]  - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7]  - m[13]*m[3]*m[6];
+        inv[6]  = -m[0]*m[6]*m[15]  + m[0]*m[7]*m[14]  + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7]  + m[12]*m[3]*m[6];
+        inv[10] =  m[0]*m[5]*m[15]  - m[0]*m[7]*m[13]  - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7]  - m[12]*m[3]*m[5];
+        inv[14] = -m[0]*m[5]*m[14]  + m[0]*m[6]*m[13]  + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6]  + m[12]*m[2]*m[5];
+        inv[3]  = -m[1]*m[6]*m[11]  + m[1]*m[7]*m[10]  + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7]   + m[9]*m[3]*m[6];
+        inv[7]  =  m[0]*m[6]*m[11]  - m[0]*m[7]*m[10]  - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7]   - m[8]*m[3]*m[6];
+        inv[11] = -m[0]*m[5]*m[11]  + m[0]*m[7]*m[9]   + m[4]*m[1]*m[11] - m[4]*m[3]*m[9]  - m[8]*m[1]*m[7]   + m[8]*m[3]*m[5];
+        inv[15] =  m[0]*m[5]*m[10]  - m[0]*m[6]*m[9]   - m[4]*m[1]*m[10] + m[4]*m[2]*m[9]  + m[8]*m[1]*m[6]   - m[8]*m[2]*m[5];
+
+        T det = m[0]*inv[0] + m[1]*inv[4] + m[2]*inv[8] + m[3]*inv[12];
+        if (det == T(0))
+            return false;
+
+        T invDet = T(1) / det;
+        for (uint32_t i = 0; i < 16; i++)
+            _mat[i] = inv[i] * invDet;
+        return true;
+    }
+
+    Matrix44<T>                inverse() const
+    {
+        Matrix44<T> result (*this);
+        result.invert();
+        return result;
+    }
+
     Matrix44<T>&               setTranslation (const Vector3<T>& xlate)
     {
         setIdentity();
@@ -299,6 +346,145 @@ public:
 };
 
 typedef Matrix44<float> Matrix44f;
+
+#if CTR_SSE
+//------------------------------------------------------------
+// SSE specializations for Matrix44f.
+// Every row is a single __m128. Loads and stores are unaligned and the
+// type has no alignment requirement, heap allocated owners are not
+// guaranteed 16 byte alignment before C++17 (C4316 on 32 bit builds).
+//------------------------------------------------------------
+#define CTR_SHUFFLE_MASK(x,y,z,w) ((x) | ((y)<<2) | ((z)<<4) | ((w)<<6))
+#define CTR_SWIZZLE(v, x,y,z,w)   _mm_shuffle_ps(v, v, CTR_SHUFFLE_MASK(x,y,z,w))
+#define CTR_SHUFFLE(a, b, x,y,z,w) _mm_shuffle_ps(a, b, CTR_SHUFFLE_MASK(x,y,z,w))
+
+inline __m128
+matrix44fRowTransform(__m128 row, const Matrix44f& m)
+{
+    __m128 r = _mm_mul_ps(CTR_SWIZZLE(row, 0,0,0,0), _mm_loadu_ps(&m._mat[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(CTR_SWIZZLE(row, 1,1,1,1), _mm_loadu_ps(&m._mat[4])));
+    r = _mm_add_ps(r, _mm_mul_ps(CTR_SWIZZLE(row, 2,2,2,2), _mm_loadu_ps(&m._mat[8])));
+    r = _mm_add_ps(r, _mm_mul_ps(CTR_SWIZZLE(row, 3,3,3,3), _mm_loadu_ps(&m._mat[12])));
+    return r;
+}
+
+template <>
+inline Matrix44f
+Matrix44f::operator*(const Matrix44f& other) const
+{
+    Matrix44f result;
+    _mm_storeu_ps(&result._mat[0],  matrix44fRowTransform(_mm_loadu_ps(&_mat[0]), other));
+    _mm_storeu_ps(&result._mat[4],  matrix44fRowTransform(_mm_loadu_ps(&_mat[4]), other));
+    _mm_storeu_ps(&result._mat[8],  matrix44fRowTransform(_mm_loadu_ps(&_mat[8]), other));
+    _mm_storeu_ps(&result._mat[12], matrix44fRowTransform(_mm_loadu_ps(&_mat[12]), other));
+    return result;
+}
+
+template <>
+inline Matrix44f&
+Matrix44f::transpose()
+{
+    __m128 r0 = _mm_loadu_ps(&_mat[0]);
+    __m128 r1 = _mm_loadu_ps(&_mat[4]);
+    __m128 r2 = _mm_loadu_ps(&_mat[8]);
+    __m128 r3 = _mm_loadu_ps(&_mat[12]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(&_mat[0], r0);
+    _mm_storeu_ps(&_mat[4], r1);
+    _mm_storeu_ps(&_mat[8], r2);
+    _mm_storeu_ps(&_mat[12], r3);
+    return *this;
+}
+
+template <>
+inline Vector4f
+Matrix44f::transform(const Vector4f& other) const
+{
+    Vector4f result;
+    _mm_storeu_ps(&result.x, matrix44fRowTransform(_mm_loadu_ps(&other.x), *this));
+    return result;
+}
+
+// 2x2 block helpers for the inverse, each __m128 holds a row major 2x2 matrix.
+inline __m128 matrix22Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, CTR_SWIZZLE(b, 0,3,0,3)),
+                      _mm_mul_ps(CTR_SWIZZLE(a, 1,0,3,2), CTR_SWIZZLE(b, 2,1,2,1)));
+}
+
+// adj(a) * b
+inline __m128 matrix22AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(CTR_SWIZZLE(a, 3,3,0,0), b),
+                      _mm_mul_ps(CTR_SWIZZLE(a, 1,1,2,2), CTR_SWIZZLE(b, 2,3,0,1)));
+}
+
+// a * adj(b)
+inline __m128 matrix22MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, CTR_SWIZZLE(b, 3,0,3,0)),
+                      _mm_mul_ps(CTR_SWIZZLE(a, 1,0,3,2), CTR_SWIZZLE(b, 2,1,2,1)));
+}
+
+// Block wise inverse. Splits the matrix into four 2x2 blocks
+// and builds the result from their adjugates and determinants.
+template <>
+inline bool
+Matrix44f::invert()
+{
+    __m128 r0 = _mm_loadu_ps(&_mat[0]);
+    __m128 r1 = _mm_loadu_ps(&_mat[4]);
+    __m128 r2 = _mm_loadu_ps(&_mat[8]);
+    __m128 r3 = _mm_loadu_ps(&_mat[12]);
+
+    __m128 a = _mm_movelh_ps(r0, r1);
+    __m128 b = _mm_movehl_ps(r1, r0);
+    __m128 c = _mm_movelh_ps(r2, r3);
+    __m128 d = _mm_movehl_ps(r3, r2);
+
+    // (|A| |B| |C| |D|)
+    __m128 detSub = _mm_sub_ps(_mm_mul_ps(CTR_SHUFFLE(r0, r2, 0,2,0,2), CTR_SHUFFLE(r1, r3, 1,3,1,3)),
+                               _mm_mul_ps(CTR_SHUFFLE(r0, r2, 1,3,1,3), CTR_SHUFFLE(r1, r3, 0,2,0,2)));
+    __m128 detA = CTR_SWIZZLE(detSub, 0,0,0,0);
+    __m128 detB = CTR_SWIZZLE(detSub, 1,1,1,1);
+    __m128 detC = CTR_SWIZZLE(detSub, 2,2,2,2);
+    __m128 detD = CTR_SWIZZLE(detSub, 3,3,3,3);
+
+    __m128 dc = matrix22AdjMul(d, c);
+    __m128 ab = matrix22AdjMul(a, b);
+
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), matrix22Mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), matrix22Mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), matrix22MulAdj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), matrix22MulAdj(a, dc));
+
+    // |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    __m128 tr = _mm_mul_ps(ab, CTR_SWIZZLE(dc, 0,2,1,3));
+    tr = _mm_add_ps(tr, CTR_SWIZZLE(tr, 2,3,0,1));
+    tr = _mm_add_ps(tr, CTR_SWIZZLE(tr, 1,0,3,2));
+    detM = _mm_sub_ps(detM, tr);
+
+    if (_mm_cvtss_f32(detM) == 0.0f)
+        return false;
+
+    __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    x = _mm_mul_ps(x, rDetM);
+    y = _mm_mul_ps(y, rDetM);
+    z = _mm_mul_ps(z, rDetM);
+    w = _mm_mul_ps(w, rDetM);
+
+    _mm_storeu_ps(&_mat[0],  CTR_SHUFFLE(x, y, 3,1,3,1));
+    _mm_storeu_ps(&_mat[4],  CTR_SHUFFLE(x, y, 2,0,2,0));
+    _mm_storeu_ps(&_mat[8],  CTR_SHUFFLE(z, w, 3,1,3,1));
+    _mm_storeu_ps(&_mat[12], CTR_SHUFFLE(z, w, 2,0,2,0));
+    return true;
+}
+
+#undef CTR_SHUFFLE
+#undef CTR_SWIZZLE
+#undef CTR_SHUFFLE_MASK
+#endif
 }
 
 #endif
\ No newline at end of file
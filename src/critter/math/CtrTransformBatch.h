@@ -0,0 +1,255 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_TRANSFORM_BATCH
+#define INCLUDED_CRT_TRANSFORM_BATCH
+
+#include <CtrPlatform.h>
+#include <CtrMatrix44.h>
+
+namespace Ctr
+{
+//------------------------------------------------------------------
+// Batched transform kernels.
+//
+// Positions and normals are processed in structure of arrays form
+// (separate x, y and z arrays) so that 4 (SSE) or 8 (AVX) vertices
+// are transformed per iteration with no shuffling.
+// Use deinterleave / interleave to move between the interleaved
+// layout held by VertexStream and the SoA layout.
+//------------------------------------------------------------------
+
+// Split a strided float stream (stride in floats) into x, y, z arrays.
+inline void
+deinterleave3(const float* src, uint32_t stride, size_t count,
+              float* x, float* y, float* z)
+{
+    for (size_t i = 0; i < count; i++, src += stride)
+    {
+        x[i] = src[0];
+        y[i] = src[1];
+        z[i] = src[2];
+    }
+}
+
+// Write x, y, z arrays back into a strided float stream.
+inline void
+interleave3(const float* x, const float* y, const float* z, size_t count,
+            float* dst, uint32_t stride)
+{
+    for (size_t i = 0; i < count; i++, dst += stride)
+    {
+        dst[0] = x[i];
+        dst[1] = y[i];
+        dst[2] = z[i];
+    }
+}
+
+// out = (x, y, z, 1) * m. Input and output arrays may alias.
+inline void
+transformPositionsSoA(const Matrix44f& m,
+                      const float* x, const float* y, const float* z,
+                      float* outX, float* outY, float* outZ,
+                      size_t count)
+{
+    size_t i = 0;
+#if CTR_AVX
+    {
+        const __m256 m00 = _mm256_set1_ps(m._m[0][0]), m01 = _mm256_set1_ps(m._m[0][1]), m02 = _mm256_set1_ps(m._m[0][2]);
+        const __m256 m10 = _mm256_set1_ps(m._m[1][0]), m11 = _mm256_set1_ps(m._m[1][1]), m12 = _mm256_set1_ps(m._m[1][2]);
+        const __m256 m20 = _mm256_set1_ps(m._m[2][0]), m21 = _mm256_set1_ps(m._m[2][1]), m22 = _mm256_set1_ps(m._m[2][2]);
+        const __m256 m30 = _mm256_set1_ps(m._m[3][0]), m31 = _mm256_set1_ps(m._m[3][1]), m32 = _mm256_set1_ps(m._m[3][2]);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 vx = _mm256_loadu_ps(x + i);
+            __m256 vy = _mm256_loadu_ps(y + i);
+            __m256 vz = _mm256_loadu_ps(z + i);
+            __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m00), _mm256_mul_ps(vy, m10)), _mm256_add_ps(_mm256_mul_ps(vz, m20), m30));
+            __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m01), _mm256_mul_ps(vy, m11)), _mm256_add_ps(_mm256_mul_ps(vz, m21), m31));
+            __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, m02), _mm256_mul_ps(vy, m12)), _mm256_add_ps(_mm256_mul_ps(vz, m22), m32));
+            _mm256_storeu_ps(outX + i, rx);
+            _mm256_storeu_ps(outY + i, ry);
+            _mm256_storeu_ps(outZ + i, rz);
+        }
+    }
+#endif
+#if CTR_SSE
+    {
+        const __m128 m00 = _mm_set1_ps(m._m[0][0]), m01 = _mm_set1_ps(m._m[0][1]), m02 = _mm_set1_ps(m._m[0][2]);
+        const __m128 m10 = _mm_set1_ps(m._m[1][0]), m11 = _mm_set1_ps(m._m[1][1]), m12 = _mm_set1_ps(m._m[1][2]);
+        const __m128 m20 = _mm_set1_ps(m._m[2][0]), m21 = _mm_set1_ps(m._m[2][1]), m22 = _mm_set1_ps(m._m[2][2]);
+        const __m128 m30 = _mm_set1_ps(m._m[3][0]), m31 = _mm_set1_ps(m._m[3][1]), m32 = _mm_set1_ps(m._m[3][2]);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 vx = _mm_loadu_ps(x + i);
+            __m128 vy = _mm_loadu_ps(y + i);
+            __m128 vz = _mm_loadu_ps(z + i);
+            __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10)), _mm_add_ps(_mm_mul_ps(vz, m20), m30));
+            __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11)), _mm_add_ps(_mm_mul_ps(vz, m21), m31));
+            __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12)), _mm_add_ps(_mm_mul_ps(vz, m22), m32));
+            _mm_storeu_ps(outX + i, rx);
+            _mm_storeu_ps(outY + i, ry);
+            _mm_storeu_ps(outZ + i, rz);
+        }
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = vx * m._m[0][0] + vy * m._m[1][0] + vz * m._m[2][0] + m._m[3][0];
+        outY[i] = vx * m._m[0][1] + vy * m._m[1][1] + vz * m._m[2][1] + m._m[3][1];
+        outZ[i] = vx * m._m[0][2] + vy * m._m[1][2] + vz * m._m[2][2] + m._m[3][2];
+    }
+}
+
+// Projective variant, writes clip space x, y, z, w.
+inline void
+transformPositionsSoA(const Matrix44f& m,
+                      const float* x, const float* y, const float* z,
+                      float* outX, float* outY, float* outZ, float* outW,
+                      size_t count)
+{
+    size_t i = 0;
+#if CTR_SSE
+    const __m128 m00 = _mm_set1_ps(m._m[0][0]), m01 = _mm_set1_ps(m._m[0][1]), m02 = _mm_set1_ps(m._m[0][2]), m03 = _mm_set1_ps(m._m[0][3]);
+    const __m128 m10 = _mm_set1_ps(m._m[1][0]), m11 = _mm_set1_ps(m._m[1][1]), m12 = _mm_set1_ps(m._m[1][2]), m13 = _mm_set1_ps(m._m[1][3]);
+    const __m128 m20 = _mm_set1_ps(m._m[2][0]), m21 = _mm_set1_ps(m._m[2][1]), m22 = _mm_set1_ps(m._m[2][2]), m23 = _mm_set1_ps(m._m[2][3]);
+    const __m128 m30 = _mm_set1_ps(m._m[3][0]), m31 = _mm_set1_ps(m._m[3][1]), m32 = _mm_set1_ps(m._m[3][2]), m33 = _mm_set1_ps(m._m[3][3]);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        _mm_storeu_ps(outX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10)), _mm_add_ps(_mm_mul_ps(vz, m20), m30)));
+        _mm_storeu_ps(outY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11)), _mm_add_ps(_mm_mul_ps(vz, m21), m31)));
+        _mm_storeu_ps(outZ + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12)), _mm_add_ps(_mm_mul_ps(vz, m22), m32)));
+        _mm_storeu_ps(outW + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m03), _mm_mul_ps(vy, m13)), _mm_add_ps(_mm_mul_ps(vz, m23), m33)));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        outX[i] = vx * m._m[0][0] + vy * m._m[1][0] + vz * m._m[2][0] + m._m[3][0];
+        outY[i] = vx * m._m[0][1] + vy * m._m[1][1] + vz * m._m[2][1] + m._m[3][1];
+        outZ[i] = vx * m._m[0][2] + vy * m._m[1][2] + vz * m._m[2][2] + m._m[3][2];
+        outW[i] = vx * m._m[0][3] + vy * m._m[1][3] + vz * m._m[2][3] + m._m[3][3];
+    }
+}
+
+// out = (x, y, z, 0) * m, optionally renormalized.
+// For non uniform scale pass the inverse transpose of the world matrix.
+inline void
+transformNormalsSoA(const Matrix44f& m,
+                    const float* x, const float* y, const float* z,
+                    float* outX, float* outY, float* outZ,
+                    size_t count,
+                    bool renormalize = true)
+{
+    size_t i = 0;
+#if CTR_SSE
+    const __m128 m00 = _mm_set1_ps(m._m[0][0]), m01 = _mm_set1_ps(m._m[0][1]), m02 = _mm_set1_ps(m._m[0][2]);
+    const __m128 m10 = _mm_set1_ps(m._m[1][0]), m11 = _mm_set1_ps(m._m[1][1]), m12 = _mm_set1_ps(m._m[1][2]);
+    const __m128 m20 = _mm_set1_ps(m._m[2][0]), m21 = _mm_set1_ps(m._m[2][1]), m22 = _mm_set1_ps(m._m[2][2]);
+    const __m128 tiny = _mm_set1_ps(1e-20f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00), _mm_mul_ps(vy, m10)), _mm_mul_ps(vz, m20));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m01), _mm_mul_ps(vy, m11)), _mm_mul_ps(vz, m21));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m02), _mm_mul_ps(vy, m12)), _mm_mul_ps(vz, m22));
+        if (renormalize)
+        {
+            __m128 lenSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz));
+            __m128 invLen = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lenSq, tiny)));
+            rx = _mm_mul_ps(rx, invLen);
+            ry = _mm_mul_ps(ry, invLen);
+            rz = _mm_mul_ps(rz, invLen);
+        }
+        _mm_storeu_ps(outX + i, rx);
+        _mm_storeu_ps(outY + i, ry);
+        _mm_storeu_ps(outZ + i, rz);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        float vx = x[i], vy = y[i], vz = z[i];
+        float rx = vx * m._m[0][0] + vy * m._m[1][0] + vz * m._m[2][0];
+        float ry = vx * m._m[0][1] + vy * m._m[1][1] + vz * m._m[2][1];
+        float rz = vx * m._m[0][2] + vy * m._m[1][2] + vz * m._m[2][2];
+        if (renormalize)
+        {
+            float invLen = 1.0f / sqrtf(maxValue(rx*rx + ry*ry + rz*rz, 1e-20f));
+            rx *= invLen; ry *= invLen; rz *= invLen;
+        }
+        outX[i] = rx;
+        outY[i] = ry;
+        outZ[i] = rz;
+    }
+}
+
+// Transform a strided, interleaved float3 stream in place (e.g. VertexStream::stream()).
+// Works through a fixed size SoA scratch block so no allocation is needed.
+inline void
+transformPositionStream(const Matrix44f& m, float* stream, uint32_t stride, size_t count, bool isDirection = false)
+{
+    const size_t BlockSize = 256;
+    alignas(CTR_SIMD_ALIGNMENT) float x[BlockSize];
+    alignas(CTR_SIMD_ALIGNMENT) float y[BlockSize];
+    alignas(CTR_SIMD_ALIGNMENT) float z[BlockSize];
+
+    for (size_t first = 0; first < count; first += BlockSize)
+    {
+        size_t blockCount = minValue(BlockSize, count - first);
+        float* block = stream + first * stride;
+        deinterleave3(block, stride, blockCount, x, y, z);
+        if (isDirection)
+            transformNormalsSoA(m, x, y, z, x, y, z, blockCount);
+        else
+            transformPositionsSoA(m, x, y, z, x, y, z, blockCount);
+        interleave3(x, y, z, blockCount, block, stride);
+    }
+}
+
+}
+
+#endif
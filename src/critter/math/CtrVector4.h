@@ -178,6 +178,85 @@ class Vector4
 };
 
 typedef Ctr::Vector4<float> Vector4f;
+
+#if CTR_SSE
+//------------------------------------------------------------
+// SSE specializations for Vector4f.
+// Unaligned loads, see Matrix44f.
+//------------------------------------------------------------
+template <>
+inline Vector4f
+Vector4f::operator + (const Vector4f& other) const
+{
+    Vector4f result;
+    _mm_storeu_ps(&result.x, _mm_add_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&other.x)));
+    return result;
+}
+
+template <>
+inline Vector4f
+Vector4f::operator - (const Vector4f& other) const
+{
+    Vector4f result;
+    _mm_storeu_ps(&result.x, _mm_sub_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&other.x)));
+    return result;
+}
+
+template <>
+inline Vector4f
+Vector4f::operator * (float scalar)
+{
+    Vector4f result;
+    _mm_storeu_ps(&result.x, _mm_mul_ps(_mm_loadu_ps(&x), _mm_set1_ps(scalar)));
+    return result;
+}
+
+template <>
+inline Vector4f&
+Vector4f::operator *= (float scalar)
+{
+    _mm_storeu_ps(&x, _mm_mul_ps(_mm_loadu_ps(&x), _mm_set1_ps(scalar)));
+    return *this;
+}
+
+template <>
+inline Vector4f
+Vector4f::operator / (float scalar)
+{
+    Vector4f result;
+    _mm_storeu_ps(&result.x, _mm_div_ps(_mm_loadu_ps(&x), _mm_set1_ps(scalar)));
+    return result;
+}
+
+template <>
+inline Vector4f&
+Vector4f::operator /= (float scalar)
+{
+    _mm_storeu_ps(&x, _mm_div_ps(_mm_loadu_ps(&x), _mm_set1_ps(scalar)));
+    return *this;
+}
+
+template <>
+inline float
+Vector4f::dot (const Vector4f& b) const
+{
+    __m128 m = _mm_mul_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&b.x));
+    m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+    m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(m);
+}
+
+template <>
+inline float
+Vector4f::distanceSquared (const Vector4f& b) const
+{
+    __m128 d = _mm_sub_ps(_mm_loadu_ps(&x), _mm_loadu_ps(&b.x));
+    d = _mm_mul_ps(d, d);
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(d);
+}
+#endif
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrUIBatcher.h>
+
+namespace Ctr
+{
+UIDrawState::UIDrawState() :
+    declaration(nullptr),
+    shader(nullptr),
+    texture(nullptr),
+    scissorEnabled(false),
+    scissorX(0),
+    scissorY(0),
+    scissorWidth(0),
+    scissorHeight(0)
+{
+}
+
+UIDrawState::UIDrawState(IVertexDeclaration* declarationIn,
+                         const IShader* shaderIn,
+                         const ITexture* textureIn) :
+    declaration(declarationIn),
+    shader(shaderIn),
+    texture(textureIn),
+    scissorEnabled(false),
+    scissorX(0),
+    scissorY(0),
+    scissorWidth(0),
+    scissorHeight(0)
+{
+}
+
+bool
+UIDrawState::operator==(const UIDrawState& other) const
+{
+    return declaration == other.declaration &&
+           shader == other.shader &&
+           texture == other.texture &&
+           scissorEnabled == other.scissorEnabled &&
+           scissorX == other.scissorX &&
+           scissorY == other.scissorY &&
+           scissorWidth == other.scissorWidth &&
+           scissorHeight == other.scissorHeight;
+}
+
+bool
+UIDrawState::operator!=(const UIDrawState& other) const
+{
+    return !(*this == other);
+}
+
+void
+UIDrawState::setScissor(bool enabled, uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    scissorEnabled = enabled;
+    scissorX = x;
+    scissorY = y;
+    scissorWidth = width;
+    scissorHeight = height;
+}
+
+UIBatcher::UIBatcher(uint32_t streamCapacity) :
+    _streamCapacity(streamCapacity),
+    _draws(0)
+{
+}
+
+UIBatcher::~UIBatcher()
+{
+}
+
+void*
+UIBatcher::append(const UIDrawState& state, uint32_t stride, uint32_t vertexCount)
+{
+    // Few declarations are in flight, a linear search is fine.
+    uint32_t streamId = 0;
+    for (; streamId < _streams.size(); streamId++)
+    {
+        if (_streams[streamId].declaration == state.declaration)
+            break;
+    }
+    if (streamId == _streams.size())
+    {
+        UIVertexStream stream;
+        stream.declaration = state.declaration;
+        stream.stride = stride;
+        stream.vertexCount = 0;
+        _streams.push_back(stream);
+    }
+
+    UIVertexStream& stream = _streams[streamId];
+    assert(stream.stride == stride);
+    if (stream.vertexCount + vertexCount > _streamCapacity)
+        return nullptr;
+
+    // The previous batch always ends its stream, so matching state
+    // extends it in place.
+    if (!_batches.empty() && _batches.back().state == state)
+    {
+        _batches.back().vertexCount += vertexCount;
+    }
+    else
+    {
+        UIBatch batch;
+        batch.state = state;
+        batch.stream = streamId;
+        batch.firstVertex = stream.vertexCount;
+        batch.vertexCount = vertexCount;
+        _batches.push_back(batch);
+    }
+
+    size_t offset = size_t(stream.vertexCount) * stride;
+    stream.vertexCount += vertexCount;
+    if (stream.data.size() < size_t(stream.vertexCount) * stride)
+        stream.data.resize(size_t(stream.vertexCount) * stride);
+
+    _draws++;
+    return &stream.data[offset];
+}
+
+void
+UIBatcher::clear()
+{
+    for (auto it = _streams.begin(); it != _streams.end(); it++)
+    {
+        it->vertexCount = 0;
+    }
+    _batches.clear();
+    _draws = 0;
+}
+
+bool
+UIBatcher::empty() const
+{
+    return _batches.empty();
+}
+
+const std::vector<UIBatch>&
+UIBatcher::batches() const
+{
+    return _batches;
+}
+
+const std::vector<UIVertexStream>&
+UIBatcher::streams() const
+{
+    return _streams;
+}
+
+uint32_t
+UIBatcher::draws() const
+{
+    return _draws;
+}
+
+uint32_t
+UIBatcher::streamCapacity() const
+{
+    return _streamCapacity;
+}
+
+}
@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_UI_BATCHER
+#define INCLUDED_CRT_UI_BATCHER
+
+#include <CtrPlatform.h>
+#include <vector>
+
+namespace Ctr
+{
+class IShader;
+class ITexture;
+class IVertexDeclaration;
+
+//------------------------------------------------------------------
+// Pipeline state a ui draw depends on. Draws with equal state can
+// share one vertex range and one draw call.
+//------------------------------------------------------------------
+struct UIDrawState
+{
+    UIDrawState();
+    UIDrawState(IVertexDeclaration* declaration,
+                const IShader* shader,
+                const ITexture* texture);
+
+    bool                       operator==(const UIDrawState& other) const;
+    bool                       operator!=(const UIDrawState& other) const;
+
+    void                       setScissor(bool enabled,
+                                          uint16_t x, uint16_t y,
+                                          uint16_t width, uint16_t height);
+
+    IVertexDeclaration*        declaration;
+    const IShader*             shader;
+    const ITexture*            texture;
+    bool                       scissorEnabled;
+    uint16_t                   scissorX;
+    uint16_t                   scissorY;
+    uint16_t                   scissorWidth;
+    uint16_t                   scissorHeight;
+};
+
+// Vertices of one declaration, uploaded with a single lock.
+struct UIVertexStream
+{
+    IVertexDeclaration*        declaration;
+    uint32_t                   stride;
+    uint32_t                   vertexCount;
+    std::vector<uint8_t>       data;
+};
+
+// A run of triangle list vertices drawn with a single call.
+struct UIBatch
+{
+    UIDrawState                state;
+    uint32_t                   stream;
+    uint32_t                   firstVertex;
+    uint32_t                   vertexCount;
+};
+
+//------------------------------------------------------------------
+// Records ui triangle lists on the cpu and merges consecutive draws
+// that share state. Submission order is preserved, the owner
+// uploads each stream once and issues one draw per batch. Holds no
+// device resources so it can be exercised standalone.
+//------------------------------------------------------------------
+class UIBatcher
+{
+  public:
+    UIBatcher(uint32_t streamCapacity);
+    ~UIBatcher();
+
+    //------------------------------------------------------------
+    // Space for vertexCount vertices drawn with state. Returns
+    // nullptr when the stream would exceed its capacity, flush and
+    // retry. The pointer is valid until the next append.
+    //------------------------------------------------------------
+    void*                      append(const UIDrawState& state,
+                                      uint32_t stride,
+                                      uint32_t vertexCount);
+
+    // Keeps stream storage for the next frame.
+    void                       clear();
+    bool                       empty() const;
+
+    const std::vector<UIBatch>&        batches() const;
+    const std::vector<UIVertexStream>& streams() const;
+
+    // Appends since the last clear.
+    uint32_t                   draws() const;
+    uint32_t                   streamCapacity() const;
+
+  private:
+    std::vector<UIVertexStream> _streams;
+    std::vector<UIBatch>       _batches;
+    uint32_t                   _streamCapacity;
+    uint32_t                   _draws;
+};
+}
+
+#endif
@@ -0,0 +1,176 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_UI_GEOMETRY_CACHE
+#define INCLUDED_CRT_UI_GEOMETRY_CACHE
+
+#include <CtrPlatform.h>
+#include <CtrHash.h>
+#include <map>
+
+namespace Ctr
+{
+//------------------------------------------------------------------
+// Retained ui geometry (text runs, shape tessellations) keyed by
+// the hash of whatever produced it. Entries not touched for maxAge
+// frames are dropped so per frame strings do not accumulate.
+//------------------------------------------------------------------
+template <typename T>
+class UIGeometryCache
+{
+  public:
+    UIGeometryCache(uint32_t maxAge = 120);
+    ~UIGeometryCache();
+
+    // Marks the entry used, nullptr on a miss.
+    T*                         find(const Hash& key);
+    // Creates (or returns) the entry and marks it used.
+    T&                         insert(const Hash& key);
+
+    void                       endFrame();
+    void                       clear();
+
+    size_t                     size() const;
+    uint64_t                   hits() const;
+    uint64_t                   misses() const;
+
+  private:
+    struct Entry
+    {
+        T                      value;
+        uint64_t               lastUsed;
+    };
+
+    std::map<Hash, Entry>      _entries;
+    uint64_t                   _frame;
+    uint32_t                   _maxAge;
+    uint64_t                   _hits;
+    uint64_t                   _misses;
+};
+
+template <typename T>
+UIGeometryCache<T>::UIGeometryCache(uint32_t maxAge) :
+    _frame(0),
+    _maxAge(maxAge),
+    _hits(0),
+    _misses(0)
+{
+}
+
+template <typename T>
+UIGeometryCache<T>::~UIGeometryCache()
+{
+}
+
+template <typename T>
+T*
+UIGeometryCache<T>::find(const Hash& key)
+{
+    auto it = _entries.find(key);
+    if (it == _entries.end())
+    {
+        _misses++;
+        return nullptr;
+    }
+    _hits++;
+    it->second.lastUsed = _frame;
+    return &it->second.value;
+}
+
+template <typename T>
+T&
+UIGeometryCache<T>::insert(const Hash& key)
+{
+    Entry& entry = _entries[key];
+    entry.lastUsed = _frame;
+    return entry.value;
+}
+
+template <typename T>
+void
+UIGeometryCache<T>::endFrame()
+{
+    _frame++;
+
+    // Sweep occasionally, the map is small.
+    if (_frame % 32 != 0)
+        return;
+
+    for (auto it = _entries.begin(); it != _entries.end();)
+    {
+        if (_frame - it->second.lastUsed > _maxAge)
+            it = _entries.erase(it);
+        else
+            it++;
+    }
+}
+
+template <typename T>
+void
+UIGeometryCache<T>::clear()
+{
+    _entries.clear();
+}
+
+template <typename T>
+size_t
+UIGeometryCache<T>::size() const
+{
+    return _entries.size();
+}
+
+template <typename T>
+uint64_t
+UIGeometryCache<T>::hits() const
+{
+    return _hits;
+}
+
+template <typename T>
+uint64_t
+UIGeometryCache<T>::misses() const
+{
+    return _misses;
+}
+
+}
+
+#endif
@@ -80,6 +80,11 @@ class UIRenderer :
 
     void                       setViewProj(const Ctr::Matrix44f& ortho);
 
+    // Vertices per ring buffered vertex buffer.
+    static const uint32_t      VertexCapacity = 10000;
+    // Indices in the ring buffered index buffer.
+    static const uint32_t      IndexCapacity = 15000;
+
   protected:
     // Pipeline State.
     Ctr::IShader*              _currentShader;
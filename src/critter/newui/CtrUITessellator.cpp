@@ -0,0 +1,361 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrUITessellator.h>
+#include <CtrHasher.h>
+
+namespace Ctr
+{
+namespace
+{
+const float TabStops[4] = {150, 210, 270, 330};
+
+float
+nextTabStop(float x, float origin)
+{
+    for (uint32_t stopId = 0; stopId < 4; stopId++)
+    {
+        if (x < TabStops[stopId] + origin)
+            return TabStops[stopId] + origin;
+    }
+    return x;
+}
+}
+
+UIFont::UIFont() :
+    invTextureWidth(1.0f),
+    invTextureHeight(1.0f),
+    halfTexel(0.0f),
+    id(0),
+    size(0.0f)
+{
+    memset(glyphs, 0, sizeof(glyphs));
+}
+
+UITessellator::UITessellator(uint32_t maxAge) :
+    _shapes(maxAge),
+    _textRuns(maxAge)
+{
+    for (uint32_t vertexId = 0; vertexId < CircleVertexCount; vertexId++)
+    {
+        float a = (float)vertexId / (float)CircleVertexCount * (float)(3.141591 * 2.0);
+        _circle[vertexId * 2 + 0] = cosf(a);
+        _circle[vertexId * 2 + 1] = sinf(a);
+    }
+}
+
+UITessellator::~UITessellator()
+{
+}
+
+uint32_t
+UITessellator::polygonVertexCount(uint32_t coordCount)
+{
+    return coordCount * 6 + (coordCount - 2) * 3;
+}
+
+uint32_t
+UITessellator::tessellatePolygon(const float* coords, uint32_t coordCount, float fringe, float* out)
+{
+    assert(coordCount >= 3 && coordCount <= MaxPolygonCoords);
+
+    for (uint32_t ii = 0, jj = coordCount - 1; ii < coordCount; jj = ii++)
+    {
+        const float* v0 = &coords[jj * 2];
+        const float* v1 = &coords[ii * 2];
+        float dx = v1[0] - v0[0];
+        float dy = v1[1] - v0[1];
+        float d = sqrtf(dx * dx + dy * dy);
+        if (d > 0)
+        {
+            d = 1.0f / d;
+            dx *= d;
+            dy *= d;
+        }
+
+        _normals[jj * 2 + 0] = dy;
+        _normals[jj * 2 + 1] = -dx;
+    }
+
+    for (uint32_t ii = 0, jj = coordCount - 1; ii < coordCount; jj = ii++)
+    {
+        float dlx0 = _normals[jj * 2 + 0];
+        float dly0 = _normals[jj * 2 + 1];
+        float dlx1 = _normals[ii * 2 + 0];
+        float dly1 = _normals[ii * 2 + 1];
+        float dmx = (dlx0 + dlx1) * 0.5f;
+        float dmy = (dly0 + dly1) * 0.5f;
+        float dmr2 = dmx * dmx + dmy * dmy;
+        if (dmr2 > 0.000001f)
+        {
+            float scale = 1.0f / dmr2;
+            if (scale > 10.0f)
+            {
+                scale = 10.0f;
+            }
+
+            dmx *= scale;
+            dmy *= scale;
+        }
+
+        _offsets[ii * 2 + 0] = coords[ii * 2 + 0] + dmx * fringe;
+        _offsets[ii * 2 + 1] = coords[ii * 2 + 1] + dmy * fringe;
+    }
+
+    float* xy = out;
+    for (uint32_t ii = 0, jj = coordCount - 1; ii < coordCount; jj = ii++)
+    {
+        *xy++ = coords[ii * 2 + 0];
+        *xy++ = coords[ii * 2 + 1];
+
+        *xy++ = coords[jj * 2 + 0];
+        *xy++ = coords[jj * 2 + 1];
+
+        *xy++ = _offsets[jj * 2 + 0];
+        *xy++ = _offsets[jj * 2 + 1];
+
+        *xy++ = _offsets[jj * 2 + 0];
+        *xy++ = _offsets[jj * 2 + 1];
+
+        *xy++ = _offsets[ii * 2 + 0];
+        *xy++ = _offsets[ii * 2 + 1];
+
+        *xy++ = coords[ii * 2 + 0];
+        *xy++ = coords[ii * 2 + 1];
+    }
+
+    for (uint32_t ii = 2; ii < coordCount; ++ii)
+    {
+        *xy++ = coords[0];
+        *xy++ = coords[1];
+
+        *xy++ = coords[(ii - 1) * 2 + 0];
+        *xy++ = coords[(ii - 1) * 2 + 1];
+
+        *xy++ = coords[ii * 2 + 0];
+        *xy++ = coords[ii * 2 + 1];
+    }
+
+    return polygonVertexCount(coordCount);
+}
+
+const UIShape&
+UITessellator::rectShape(float width, float height, float radius, float fringe)
+{
+    const Hash key = Hasher().update(width).update(height).update(radius).update(fringe).hash();
+    if (const UIShape* cached = _shapes.find(key))
+    {
+        return *cached;
+    }
+
+    const uint32_t num = CircleVertexCount / 4;
+    float verts[(num + 1) * 4 * 2];
+    uint32_t coordCount = 0;
+
+    if (0.0f == radius)
+    {
+        const float rect[4 * 2] =
+        {
+            0.5f,          0.5f,
+            width - 0.5f,  0.5f,
+            width - 0.5f,  height - 0.5f,
+            0.5f,          height - 0.5f,
+        };
+        memcpy(verts, rect, sizeof(rect));
+        coordCount = 4;
+    }
+    else
+    {
+        const float* cverts = _circle;
+        float* vv = verts;
+
+        for (uint32_t ii = 0; ii <= num; ++ii)
+        {
+            *vv++ = width - radius + cverts[ii * 2] * radius;
+            *vv++ = height - radius + cverts[ii * 2 + 1] * radius;
+        }
+
+        for (uint32_t ii = num; ii <= num * 2; ++ii)
+        {
+            *vv++ = radius + cverts[ii * 2] * radius;
+            *vv++ = height - radius + cverts[ii * 2 + 1] * radius;
+        }
+
+        for (uint32_t ii = num * 2; ii <= num * 3; ++ii)
+        {
+            *vv++ = radius + cverts[ii * 2] * radius;
+            *vv++ = radius + cverts[ii * 2 + 1] * radius;
+        }
+
+        for (uint32_t ii = num * 3; ii < num * 4; ++ii)
+        {
+            *vv++ = width - radius + cverts[ii * 2] * radius;
+            *vv++ = radius + cverts[ii * 2 + 1] * radius;
+        }
+
+        *vv++ = width - radius + cverts[0] * radius;
+        *vv++ = radius + cverts[1] * radius;
+        coordCount = (num + 1) * 4;
+    }
+
+    UIShape& shape = _shapes.insert(key);
+    shape.coordCount = coordCount;
+    shape.xy.resize(polygonVertexCount(coordCount) * 2);
+    shape.vertexCount = tessellatePolygon(verts, coordCount, fringe, &shape.xy[0]);
+    return shape;
+}
+
+UITextRun&
+UITessellator::textRun(const UIFont& font, const char* text)
+{
+    const Hash key = Hasher().update(text, strlen(text)).update(font.id).update(font.size).hash();
+    if (UITextRun* cached = _textRuns.find(key))
+    {
+        return *cached;
+    }
+
+    UITextRun& run = _textRuns.insert(key);
+    run.width = textWidth(font, text, run.vertexCount);
+    run.layouts.clear();
+    return run;
+}
+
+const UITextRunLayout&
+UITessellator::textRunLayout(const UIFont& font, UITextRun& run, const char* text, float originX, float originY)
+{
+    for (auto it = run.layouts.begin(); it != run.layouts.end(); it++)
+    {
+        if (it->originX == originX && it->originY == originY)
+        {
+            return *it;
+        }
+    }
+
+    run.layouts.push_back(UITextRunLayout());
+    UITextRunLayout& layout = run.layouts.back();
+    layout.originX = originX;
+    layout.originY = originY;
+    layout.quads.reserve(run.vertexCount / 6);
+
+    float xx = originX;
+    const float yy = originY;
+    while (*text)
+    {
+        int32_t ch = (uint8_t)*text;
+        if (ch == '\t')
+        {
+            xx = nextTabStop(xx, originX);
+        }
+        else if (ch >= ' ' && ch < 128)
+        {
+            const UIGlyph& glyph = font.glyphs[ch - ' '];
+            const float roundX = floorf(xx + glyph.xoff);
+            const float roundY = floorf(yy + glyph.yoff);
+
+            UIGlyphQuad quad;
+            quad.x0 = roundX;
+            quad.y0 = roundY;
+            quad.x1 = roundX + glyph.x1 - glyph.x0;
+            quad.y1 = roundY + glyph.y1 - glyph.y0;
+            quad.s0 = (glyph.x0 + font.halfTexel) * font.invTextureWidth;
+            quad.t0 = (glyph.y0 + font.halfTexel) * font.invTextureHeight;
+            quad.s1 = (glyph.x1 + font.halfTexel) * font.invTextureWidth;
+            quad.t1 = (glyph.y1 + font.halfTexel) * font.invTextureHeight;
+            layout.quads.push_back(quad);
+
+            xx += glyph.xadvance;
+        }
+
+        ++text;
+    }
+
+    return layout;
+}
+
+void
+UITessellator::endFrame()
+{
+    _shapes.endFrame();
+    _textRuns.endFrame();
+}
+
+const UIGeometryCache<UIShape>&
+UITessellator::shapes() const
+{
+    return _shapes;
+}
+
+const UIGeometryCache<UITextRun>&
+UITessellator::textRuns() const
+{
+    return _textRuns;
+}
+
+float
+UITessellator::textWidth(const UIFont& font, const char* text, uint32_t& vertexCount)
+{
+    float xpos = 0;
+    float width = 0;
+    vertexCount = 0;
+
+    while (*text)
+    {
+        int32_t ch = (uint8_t)*text;
+        if (ch == '\t')
+        {
+            xpos = nextTabStop(xpos, 0.0f);
+        }
+        else if (ch >= ' ' && ch < 128)
+        {
+            const UIGlyph& glyph = font.glyphs[ch - ' '];
+            const float roundX = floorf(xpos + glyph.xoff + 0.5f);
+            width = roundX + glyph.x1 - glyph.x0 + 0.5f;
+            xpos += glyph.xadvance;
+            vertexCount += 6;
+        }
+
+        ++text;
+    }
+
+    return width;
+}
+
+}
@@ -0,0 +1,182 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_UI_TESSELLATOR
+#define INCLUDED_CRT_UI_TESSELLATOR
+
+#include <CtrPlatform.h>
+#include <CtrUIGeometryCache.h>
+#include <vector>
+
+namespace Ctr
+{
+// Metrics of one baked glyph, as stbtt_BakeFontBitmap writes them.
+struct UIGlyph
+{
+    uint16_t                   x0;
+    uint16_t                   y0;
+    uint16_t                   x1;
+    uint16_t                   y1;
+    float                      xoff;
+    float                      yoff;
+    float                      xadvance;
+};
+
+// A glyph rectangle in pixels and its texture coordinates.
+struct UIGlyphQuad
+{
+    float                      x0;
+    float                      y0;
+    float                      s0;
+    float                      t0;
+    float                      x1;
+    float                      y1;
+    float                      s1;
+    float                      t1;
+};
+
+// Glyphs of a baked font for the characters ' ' to 127.
+struct UIFont
+{
+    static const uint32_t      GlyphCount = 96;
+
+    UIFont();
+
+    UIGlyph                    glyphs[GlyphCount];
+    float                      invTextureWidth;
+    float                      invTextureHeight;
+    float                      halfTexel;
+    // Distinguishes fonts in the text run cache.
+    uint32_t                   id;
+    float                      size;
+};
+
+// Glyph quads of a run for one sub pixel origin.
+struct UITextRunLayout
+{
+    float                      originX;
+    float                      originY;
+    std::vector<UIGlyphQuad>   quads;
+};
+
+struct UITextRun
+{
+    float                      width;
+    uint32_t                   vertexCount;
+    std::vector<UITextRunLayout> layouts;
+};
+
+// Anti aliased polygon as xy pairs relative to its origin.
+struct UIShape
+{
+    uint32_t                   coordCount;
+    uint32_t                   vertexCount;
+    std::vector<float>         xy;
+};
+
+//------------------------------------------------------------------
+// Builds and retains the cpu side geometry of ui widgets: anti
+// aliased polygon tessellations, rect shapes and text run layouts.
+// Holds no device resources so it can be exercised standalone.
+//------------------------------------------------------------------
+class UITessellator
+{
+  public:
+    static const uint32_t      MaxPolygonCoords = 100;
+    static const uint32_t      CircleVertexCount = 8 * 4;
+
+    UITessellator(uint32_t maxAge = 120);
+    ~UITessellator();
+
+    //------------------------------------------------------------
+    // Outline plus fan of a convex polygon as xy pairs, returns
+    // the vertex count. The outline is coordCount runs of six
+    // vertices, 2, 3 and 4 of each run hold the transparent
+    // fringe. out holds polygonVertexCount(coordCount) vertices,
+    // coordCount is at most MaxPolygonCoords.
+    //------------------------------------------------------------
+    uint32_t                   tessellatePolygon(const float* coords,
+                                                 uint32_t coordCount,
+                                                 float fringe,
+                                                 float* out);
+    static uint32_t            polygonVertexCount(uint32_t coordCount);
+
+    // Rect (radius 0) and rounded rect tessellations relative to
+    // their origin, keyed by size, radius and fringe.
+    const UIShape&             rectShape(float width, float height,
+                                         float radius, float fringe);
+
+    // Width and vertex count of text in font.
+    UITextRun&                 textRun(const UIFont& font, const char* text);
+
+    //------------------------------------------------------------
+    // Glyph quads of run for an origin in [0, 1). Quads snap to
+    // whole pixels from the absolute pen position, so a run only
+    // differs by its sub pixel origin.
+    //------------------------------------------------------------
+    const UITextRunLayout&     textRunLayout(const UIFont& font,
+                                             UITextRun& run,
+                                             const char* text,
+                                             float originX,
+                                             float originY);
+
+    // Ages the shape and text caches.
+    void                       endFrame();
+
+    const UIGeometryCache<UIShape>&   shapes() const;
+    const UIGeometryCache<UITextRun>& textRuns() const;
+
+    // Width of text in font and the vertices it draws with.
+    static float               textWidth(const UIFont& font,
+                                         const char* text,
+                                         uint32_t& vertexCount);
+
+  private:
+    float                      _offsets[MaxPolygonCoords * 2];
+    float                      _normals[MaxPolygonCoords * 2];
+    float                      _circle[CircleVertexCount * 2];
+
+    UIGeometryCache<UIShape>   _shapes;
+    UIGeometryCache<UITextRun> _textRuns;
+};
+}
+
+#endif
@@ -41,6 +41,9 @@
 #include <CtrIVertexBuffer.h>
 #include <CtrIIndexBuffer.h>
 #include <CtrUIRenderer.h>
+#include <CtrUIBatcher.h>
+#include <CtrUITessellator.h>
+#include <CtrHasher.h>
 #include <CtrInputState.h>
 #include <CtrTextureImage.h>
 #include "Ctrimgui.h"
@@ -53,8 +56,7 @@
 
 #define USE_NANOVG_FONT 0
 #define IMGUI_CONFIG_MAX_FONTS 20
-#define MAX_TEMP_COORDS 100
-#define NUM_CIRCLE_VERTS (8 * 4)
+#define MAX_BATCH_STREAMS 4
 
 static const int32_t BUTTON_HEIGHT = 20;
 static const int32_t SLIDER_HEIGHT = 20;
@@ -64,7 +66,6 @@ static const int32_t DEFAULT_SPACING = 4;
 static const int32_t TEXT_HEIGHT = 8;
 static const int32_t SCROLL_AREA_PADDING = 6;
 static const int32_t AREA_HEADER = 20;
-static const float s_tabStops[4] = {150, 210, 270, 330};
 
 static void* imguiMalloc(size_t size, void* /*_userptr*/)
 {
@@ -360,44 +361,6 @@ namespace
 
 } // namespace
 
-static float getTextLength(stbtt_bakedchar* _chardata, const char* _text, uint32_t& _numVertices)
-{
-    float xpos = 0;
-    float len = 0;
-    uint32_t numVertices = 0;
-
-    while (*_text)
-    {
-        int32_t ch = (uint8_t)*_text;
-        if (ch == '\t')
-        {
-            for (int32_t ii = 0; ii < 4; ++ii)
-            {
-                if (xpos < s_tabStops[ii])
-                {
-                    xpos = s_tabStops[ii];
-                    break;
-                }
-            }
-        }
-        else if (ch >= ' '
-             &&  ch < 128)
-        {
-            stbtt_bakedchar* b = _chardata + ch - ' ';
-            int32_t round_x = STBTT_ifloor( (xpos + b->xoff) + 0.5);
-            len = round_x + b->x1 - b->x0 + 0.5f;
-            xpos += b->xadvance;
-            numVertices += 6;
-        }
-
-        ++_text;
-    }
-
-    _numVertices = numVertices;
-
-    return len;
-}
-
 struct Imgui
 {
     Imgui()
@@ -429,6 +392,11 @@ struct Imgui
         , m_viewHeight(0)
         , m_currentFontIdx(0)
         , m_Device(nullptr)
+        , m_batcher(Ctr::UIRenderer::VertexCapacity)
+        , m_frameDraws(0)
+        , m_frameBatches(0)
+        , m_lastFrameDraws(0)
+        , m_lastFrameBatches(0)
     {
 
         memset(m_KeyRepeatTimes, 0, sizeof(float)*512);
@@ -454,7 +422,25 @@ struct Imgui
     {
         static uint32_t id = 0;
         uint8_t* mem = (uint8_t*)malloc(m_textureWidth * m_textureHeight);
-        stbtt_BakeFontBitmap( (uint8_t*)_data, 0, _fontSize, mem, m_textureWidth, m_textureHeight, 32, 96, m_fonts[id].m_cdata);
+        stbtt_bakedchar cdata[Ctr::UIFont::GlyphCount]; // ASCII 32..126 is 95 glyphs
+        stbtt_BakeFontBitmap( (uint8_t*)_data, 0, _fontSize, mem, m_textureWidth, m_textureHeight, 32, 96, cdata);
+
+        Ctr::UIFont& metrics = m_fonts[id].m_metrics;
+        for (uint32_t ii = 0; ii < Ctr::UIFont::GlyphCount; ++ii)
+        {
+            Ctr::UIGlyph& glyph = metrics.glyphs[ii];
+            glyph.x0 = cdata[ii].x0;
+            glyph.y0 = cdata[ii].y0;
+            glyph.x1 = cdata[ii].x1;
+            glyph.y1 = cdata[ii].y1;
+            glyph.xoff = cdata[ii].xoff;
+            glyph.yoff = cdata[ii].yoff;
+            glyph.xadvance = cdata[ii].xadvance;
+        }
+        metrics.invTextureWidth = m_invTextureWidth;
+        metrics.invTextureHeight = m_invTextureHeight;
+        metrics.halfTexel = m_halfTexel;
+        metrics.size = _fontSize;
                 
         Ctr::TextureParameters textureData =
             Ctr::TextureParameters("Normal Offsets Texture",
@@ -467,9 +453,8 @@ struct Imgui
 
         m_fonts[id].m_texture->write(mem);
 
-        m_fonts[id].m_size = _fontSize;
-        m_fonts[id].m_id = ++id;
-        return m_fonts[id].m_id;
+        metrics.id = ++id;
+        return metrics.id;
     }
 
     void setFont(ImguiFontReference _handle)
@@ -533,13 +518,6 @@ struct Imgui
         nvgFontFace(m_nvg, "default");
 
 
-        for (int32_t ii = 0; ii < NUM_CIRCLE_VERTS; ++ii)
-        {
-            float a = (float)ii / (float)NUM_CIRCLE_VERTS * (float)(3.141591 * 2.0);
-            m_circleVerts[ii * 2 + 0] = cosf(a);
-            m_circleVerts[ii * 2 + 1] = sinf(a);
-        }
-
         PosColorVertex::init();
         PosColorUvVertex::init();
         PosUvVertex::init();
@@ -897,6 +875,13 @@ struct Imgui
 
         clearInput();
 
+        flushBatches();
+        m_lastFrameDraws = m_frameDraws;
+        m_lastFrameBatches = m_frameBatches;
+        m_frameDraws = 0;
+        m_frameBatches = 0;
+        m_tessellator.endFrame();
+
         IMGUI_endFrame();
         // Reset Scissor Enabled.
         m_Device->setScissorEnabled(false);
@@ -1187,6 +1172,8 @@ struct Imgui
 
     void endArea()
     {
+        // Area content goes down before the nanovg widgets on top of it.
+        flushBatches();
         nvgResetScissor(m_nvg);
         nvgEndFrame(m_nvg);
     }
@@ -1440,8 +1427,7 @@ struct Imgui
         const int32_t height = BUTTON_HEIGHT;
         if (drawLabel)
         {
-            uint32_t numVertices = 0; //unused
-            const int32_t labelWidth = int32_t(getTextLength(m_fonts[m_currentFontIdx-1].m_cdata, _label, numVertices));
+            const int32_t labelWidth = int32_t(m_tessellator.textRun(m_fonts[m_currentFontIdx-1].m_metrics, _label).width);
             xx    += (labelWidth + 6);
             width -= (labelWidth + 6);
         }
@@ -1530,7 +1516,7 @@ struct Imgui
         uint8_t selected = _selected;
         const int32_t tabWidth = width / tabCount;
         const int32_t tabWidthHalf = width / (tabCount * 2);
-        const int32_t textY = yy + _height / 2 + int32_t(m_fonts[m_currentFontIdx - 1].m_size) / 2 - 2;
+        const int32_t textY = yy + _height / 2 + int32_t(m_fonts[m_currentFontIdx - 1].m_metrics.size) / 2 - 2;
 
         drawRoundedRect((float)xx
             , (float)yy
@@ -1632,6 +1618,8 @@ struct Imgui
 
         const float lodEnabled[4] = { _lod, float(enabled), 0.0f, 0.0f };
 
+        requestTextureSize(_image, _width > _height ? _width : _height);
+
         screenQuad(xx, yy, _width, _height, _originBottomLeft);
 
         // TODO. Primitive type!
@@ -1747,11 +1735,21 @@ struct Imgui
         return imageChannel(_image, _channel, _lod, int32_t(width), int32_t(height), _align, _enabled);
     }
 
+    void requestTextureSize(const Ctr::ITexture* _texture, int32_t _pixels)
+    {
+        // Streamed textures only read the levels a preview needs.
+        if (_texture && _pixels > 0)
+        {
+            m_Device->textureMgr()->requestSize(_texture, uint32_t(_pixels));
+        }
+    }
+
     bool cubeMap(const Ctr::ITexture* _cubemap, float _lod, bool _cross, ImguiAlign::Enum _align, bool _enabled)
     {
         const uint32_t numVertices = 14;
         const uint32_t numIndices  = 36;
 
+        flushBatches();
         {
             Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
             Ctr::IVertexBuffer* vb = uiRenderer->vertexBuffer(PosNormalVertex::ms_decl);
@@ -1853,6 +1851,9 @@ struct Imgui
 
             const float scale = float(width/2)+0.25f;
 
+            // Each face is drawn a quarter of the widget wide.
+            requestTextureSize(_cubemap, width/4);
+
             Ctr::Matrix44f srt;
             Ctr::Matrix44f projection;
             Ctr::Matrix44f transform;
@@ -2270,176 +2271,44 @@ struct Imgui
                 );
     }
 
-    void drawPolygon(const float* _coords, uint32_t _numCoords, float _r, uint32_t _abgr)
+    void emitPolygon(const float* _xy, uint32_t _numVertices, uint32_t _numCoords, float _x, float _y, uint32_t _abgr)
     {
-        _numCoords = Ctr::minValue((uint32_t)_numCoords, (uint32_t)(MAX_TEMP_COORDS));
-
-        for (uint32_t ii = 0, jj = _numCoords - 1; ii < _numCoords; jj = ii++)
+        PosColorVertex* vertex = (PosColorVertex*)appendVertices(PosColorVertex::ms_decl, m_colorProgram, nullptr, 
+                                                                 sizeof(PosColorVertex), _numVertices);
+        if (!vertex)
         {
-            const float* v0 = &_coords[jj * 2];
-            const float* v1 = &_coords[ii * 2];
-            float dx = v1[0] - v0[0];
-            float dy = v1[1] - v0[1];
-            float d = sqrtf(dx * dx + dy * dy);
-            if (d > 0)
-            {
-                d = 1.0f / d;
-                dx *= d;
-                dy *= d;
-            }
-
-            m_tempNormals[jj * 2 + 0] = dy;
-            m_tempNormals[jj * 2 + 1] = -dx;
+            return;
         }
 
-        for (uint32_t ii = 0, jj = _numCoords - 1; ii < _numCoords; jj = ii++)
+        const uint32_t trans = _abgr&0xffffff;
+        const uint32_t numOutline = _numCoords*6;
+        for (uint32_t ii = 0; ii < _numVertices; ++ii, ++vertex)
         {
-            float dlx0 = m_tempNormals[jj * 2 + 0];
-            float dly0 = m_tempNormals[jj * 2 + 1];
-            float dlx1 = m_tempNormals[ii * 2 + 0];
-            float dly1 = m_tempNormals[ii * 2 + 1];
-            float dmx = (dlx0 + dlx1) * 0.5f;
-            float dmy = (dly0 + dly1) * 0.5f;
-            float dmr2 = dmx * dmx + dmy * dmy;
-            if (dmr2 > 0.000001f)
-            {
-                float scale = 1.0f / dmr2;
-                if (scale > 10.0f)
-                {
-                    scale = 10.0f;
-                }
-
-                dmx *= scale;
-                dmy *= scale;
-            }
-
-            m_tempCoords[ii * 2 + 0] = _coords[ii * 2 + 0] + dmx * _r;
-            m_tempCoords[ii * 2 + 1] = _coords[ii * 2 + 1] + dmy * _r;
+            const uint32_t corner = ii % 6;
+            vertex->m_x = _xy[ii*2+0] + _x;
+            vertex->m_y = _xy[ii*2+1] + _y;
+            vertex->m_abgr = (ii < numOutline && corner >= 2 && corner <= 4) ? trans : _abgr;
         }
+    }
 
-        uint32_t numVertices = _numCoords*6 + (_numCoords-2)*3;
-        {
-            Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
-            Ctr::IVertexBuffer* vb = uiRenderer->vertexBuffer(PosColorVertex::ms_decl);
-            PosColorVertex* vertex = (PosColorVertex*)vb->lock(numVertices * sizeof(PosColorVertex));
-            uint32_t trans = _abgr&0xffffff;
-
-            for (uint32_t ii = 0, jj = _numCoords-1; ii < _numCoords; jj = ii++)
-            {
-                vertex->m_x = _coords[ii*2+0];
-                vertex->m_y = _coords[ii*2+1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-
-                vertex->m_x = _coords[jj*2+0];
-                vertex->m_y = _coords[jj*2+1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-
-                vertex->m_x = m_tempCoords[jj*2+0];
-                vertex->m_y = m_tempCoords[jj*2+1];
-                vertex->m_abgr = trans;
-                ++vertex;
-
-                vertex->m_x = m_tempCoords[jj*2+0];
-                vertex->m_y = m_tempCoords[jj*2+1];
-                vertex->m_abgr = trans;
-                ++vertex;
-
-                vertex->m_x = m_tempCoords[ii*2+0];
-                vertex->m_y = m_tempCoords[ii*2+1];
-                vertex->m_abgr = trans;
-                ++vertex;
-
-                vertex->m_x = _coords[ii*2+0];
-                vertex->m_y = _coords[ii*2+1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-            }
-
-            for (uint32_t ii = 2; ii < _numCoords; ++ii)
-            {
-                vertex->m_x = _coords[0];
-                vertex->m_y = _coords[1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-
-                vertex->m_x = _coords[(ii-1)*2+0];
-                vertex->m_y = _coords[(ii-1)*2+1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-
-                vertex->m_x = _coords[ii*2+0];
-                vertex->m_y = _coords[ii*2+1];
-                vertex->m_abgr = _abgr;
-                ++vertex;
-            }
-            vb->unlock();
-
-            uiRenderer->setVertexBuffer(vb);
-            uiRenderer->device()->enableAlphaBlending();
-            uiRenderer->device()->setupBlendPipeline(Ctr::BlendAlpha);
+    void drawPolygon(const float* _coords, uint32_t _numCoords, float _r, uint32_t _abgr)
+    {
+        _numCoords = Ctr::minValue((uint32_t)_numCoords, (uint32_t)(Ctr::UITessellator::MaxPolygonCoords));
 
-            uiRenderer->setShader(m_colorProgram);
-            setCurrentScissor();
-            uiRenderer->render(numVertices, 0);
-            uiRenderer->device()->disableAlphaBlending();
-        }
+        const uint32_t numVertices = m_tessellator.tessellatePolygon(_coords, _numCoords, _r, m_tempTessellation);
+        emitPolygon(m_tempTessellation, numVertices, _numCoords, 0.0f, 0.0f, _abgr);
     }
 
     void drawRect(float _x, float _y, float _w, float _h, uint32_t _argb, float _fth = 1.0f)
     {
-        float verts[4 * 2] =
-        {
-            _x + 0.5f,      _y + 0.5f,
-            _x + _w - 0.5f, _y + 0.5f,
-            _x + _w - 0.5f, _y + _h - 0.5f,
-            _x + 0.5f,      _y + _h - 0.5f,
-        };
-
-        drawPolygon(verts, 4, _fth, _argb);
+        const Ctr::UIShape& shape = m_tessellator.rectShape(_w, _h, 0.0f, _fth);
+        emitPolygon(&shape.xy[0], shape.vertexCount, shape.coordCount, _x, _y, _argb);
     }
 
     void drawRoundedRect(float _x, float _y, float _w, float _h, float _r, uint32_t _argb, float _fth = 1.0f)
     {
-        if (0.0f == _r)
-        {
-            return drawRect(_x, _y, _w, _h, _argb, _fth);
-        }
-
-        const uint32_t num = NUM_CIRCLE_VERTS / 4;
-        const float* cverts = m_circleVerts;
-        float verts[(num + 1) * 4 * 2];
-        float* vv = verts;
-
-        for (uint32_t ii = 0; ii <= num; ++ii)
-        {
-            *vv++ = _x + _w - _r + cverts[ii * 2] * _r;
-            *vv++ = _y + _h - _r + cverts[ii * 2 + 1] * _r;
-        }
-
-        for (uint32_t ii = num; ii <= num * 2; ++ii)
-        {
-            *vv++ = _x + _r + cverts[ii * 2] * _r;
-            *vv++ = _y + _h - _r + cverts[ii * 2 + 1] * _r;
-        }
-
-        for (uint32_t ii = num * 2; ii <= num * 3; ++ii)
-        {
-            *vv++ = _x + _r + cverts[ii * 2] * _r;
-            *vv++ = _y + _r + cverts[ii * 2 + 1] * _r;
-        }
-
-        for (uint32_t ii = num * 3; ii < num * 4; ++ii)
-        {
-            *vv++ = _x + _w - _r + cverts[ii * 2] * _r;
-            *vv++ = _y + _r + cverts[ii * 2 + 1] * _r;
-        }
-
-        *vv++ = _x + _w - _r + cverts[0] * _r;
-        *vv++ = _y + _r + cverts[1] * _r;
-
-        drawPolygon(verts, (num + 1) * 4, _fth, _argb);
+        const Ctr::UIShape& shape = m_tessellator.rectShape(_w, _h, _r, _fth);
+        emitPolygon(&shape.xy[0], shape.vertexCount, shape.coordCount, _x, _y, _argb);
     }
 
     void drawLine(float _x0, float _y0, float _x1, float _y1, float _r, uint32_t _abgr, float _fth = 1.0f)
@@ -2544,25 +2413,6 @@ struct Imgui
     }
 
 
-    void getBakedQuad(stbtt_bakedchar* _chardata, int32_t char_index, float* _xpos, float* _ypos, stbtt_aligned_quad* _quad)
-    {
-        stbtt_bakedchar* b = _chardata + char_index;
-        int32_t round_x = STBTT_ifloor(*_xpos + b->xoff);
-        int32_t round_y = STBTT_ifloor(*_ypos + b->yoff);
-
-        _quad->x0 = (float)round_x;
-        _quad->y0 = (float)round_y;
-        _quad->x1 = (float)round_x + b->x1 - b->x0;
-        _quad->y1 = (float)round_y + b->y1 - b->y0;
-
-        _quad->s0 = (b->x0 + m_halfTexel) * m_invTextureWidth;
-        _quad->t0 = (b->y0 + m_halfTexel) * m_invTextureWidth;
-        _quad->s1 = (b->x1 + m_halfTexel) * m_invTextureHeight;
-        _quad->t1 = (b->y1 + m_halfTexel) * m_invTextureHeight;
-
-        *_xpos += b->xadvance;
-    }
-
     void drawText(int32_t _x, int32_t _y, ImguiTextAlign::Enum _align, const char* _text, uint32_t _abgr)
     {
         drawText( (float)_x, (float)_y, _text, _align, _abgr);
@@ -2576,113 +2426,90 @@ struct Imgui
             return;
         }
 
-
-        uint32_t numVertices = 0;
+        const Font& font = m_fonts[m_currentFontIdx-1];
+        Ctr::UITextRun& run = m_tessellator.textRun(font.m_metrics, _text);
         if (_align == ImguiTextAlign::Center)
         {
-            _x -= getTextLength(m_fonts[m_currentFontIdx-1].m_cdata, _text, numVertices) / 2;
+            _x -= run.width / 2;
         }
         else if (_align == ImguiTextAlign::Right)
         {
-            _x -= getTextLength(m_fonts[m_currentFontIdx - 1].m_cdata, _text, numVertices);
-        }
-        else // just count vertices
-        {
-            getTextLength(m_fonts[m_currentFontIdx - 1].m_cdata, _text, numVertices);
+            _x -= run.width;
         }
 
+        if (0 == run.vertexCount)
         {
-            Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
-            Ctr::IVertexBuffer* vb = uiRenderer->vertexBuffer(PosColorUvVertex::ms_decl);
-            PosColorUvVertex* vertex = (PosColorUvVertex*)vb->lock(numVertices * sizeof(PosColorUvVertex));
+            return;
+        }
 
-            const float ox = _x;
+        const float originX = floorf(_x);
+        const float originY = floorf(_y);
+        const Ctr::UITextRunLayout& layout = m_tessellator.textRunLayout(font.m_metrics, run, _text, 
+                                                                          _x - originX, _y - originY);
 
-            while (*_text)
-            {
-                int32_t ch = (uint8_t)*_text;
-                if (ch == '\t')
-                {
-                    for (int32_t i = 0; i < 4; ++i)
-                    {
-                        if (_x < s_tabStops[i] + ox)
-                        {
-                            _x = s_tabStops[i] + ox;
-                            break;
-                        }
-                    }
-                }
-                else if (ch >= ' '
-                     &&  ch < 128)
-                {
-                    stbtt_aligned_quad quad;
-                    getBakedQuad(m_fonts[m_currentFontIdx-1].m_cdata, ch - 32, &_x, &_y, &quad);
-
-                    vertex->m_x = quad.x0;
-                    vertex->m_y = quad.y0;
-                    vertex->m_u = quad.s0;
-                    vertex->m_v = quad.t0;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-
-                    vertex->m_x = quad.x1;
-                    vertex->m_y = quad.y1;
-                    vertex->m_u = quad.s1;
-                    vertex->m_v = quad.t1;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-
-                    vertex->m_x = quad.x1;
-                    vertex->m_y = quad.y0;
-                    vertex->m_u = quad.s1;
-                    vertex->m_v = quad.t0;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-
-                    vertex->m_x = quad.x0;
-                    vertex->m_y = quad.y0;
-                    vertex->m_u = quad.s0;
-                    vertex->m_v = quad.t0;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-
-                    vertex->m_x = quad.x0;
-                    vertex->m_y = quad.y1;
-                    vertex->m_u = quad.s0;
-                    vertex->m_v = quad.t1;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-
-                    vertex->m_x = quad.x1;
-                    vertex->m_y = quad.y1;
-                    vertex->m_u = quad.s1;
-                    vertex->m_v = quad.t1;
-                    vertex->m_abgr = _abgr;
-                    ++vertex;
-                }
-
-                ++_text;
-            }
-            vb->unlock();
-
-            const Ctr::GpuVariable* textureVariable = nullptr;
-            if (m_textureProgram->getParameterByName("s_tex", textureVariable))
-            {
-                textureVariable->setTexture(m_fonts[m_currentFontIdx-1].m_texture);
-            }
+        PosColorUvVertex* vertex = (PosColorUvVertex*)appendVertices(PosColorUvVertex::ms_decl, m_textureProgram, 
+                                                                     font.m_texture,
+                                                                     sizeof(PosColorUvVertex), run.vertexCount);
+        if (!vertex)
+        {
+            return;
+        }
 
-            uiRenderer->setVertexBuffer(vb);
-            uiRenderer->device()->enableAlphaBlending();
-            uiRenderer->device()->setupBlendPipeline(Ctr::BlendAlpha);
-            uiRenderer->setShader(m_textureProgram);
-            setCurrentScissor();
-            uiRenderer->render(numVertices, 0);
-            uiRenderer->device()->disableAlphaBlending();
+        for (auto it = layout.quads.begin(); it != layout.quads.end(); it++)
+        {
+            const float x0 = it->x0 + originX;
+            const float y0 = it->y0 + originY;
+            const float x1 = it->x1 + originX;
+            const float y1 = it->y1 + originY;
+
+            vertex->m_x = x0;
+            vertex->m_y = y0;
+            vertex->m_u = it->s0;
+            vertex->m_v = it->t0;
+            vertex->m_abgr = _abgr;
+            ++vertex;
+
+            vertex->m_x = x1;
+            vertex->m_y = y1;
+            vertex->m_u = it->s1;
+            vertex->m_v = it->t1;
+            vertex->m_abgr = _abgr;
+            ++vertex;
+
+            vertex->m_x = x1;
+            vertex->m_y = y0;
+            vertex->m_u = it->s1;
+            vertex->m_v = it->t0;
+            vertex->m_abgr = _abgr;
+            ++vertex;
+
+            vertex->m_x = x0;
+            vertex->m_y = y0;
+            vertex->m_u = it->s0;
+            vertex->m_v = it->t0;
+            vertex->m_abgr = _abgr;
+            ++vertex;
+
+            vertex->m_x = x0;
+            vertex->m_y = y1;
+            vertex->m_u = it->s0;
+            vertex->m_v = it->t1;
+            vertex->m_abgr = _abgr;
+            ++vertex;
+
+            vertex->m_x = x1;
+            vertex->m_y = y1;
+            vertex->m_u = it->s1;
+            vertex->m_v = it->t1;
+            vertex->m_abgr = _abgr;
+            ++vertex;
         }
     }
 
     void screenQuad(int32_t _x, int32_t _y, int32_t _width, uint32_t _height, bool _originBottomLeft = false)
     {
+        // Images draw immediately, everything recorded before must land first.
+        flushBatches();
         {
             Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
             Ctr::IVertexBuffer* vb = uiRenderer->vertexBuffer(PosUvVertex::ms_decl);            
@@ -3013,23 +2840,106 @@ struct Imgui
         return m_areas[m_areaId];
     }
 
-    inline void setCurrentScissor()
+    inline void currentScissor(Ctr::UIDrawState& _state) const
     {
-        const Area& area = getCurrentArea();
+        const Area& area = m_areas[m_areaId];
         if (area.m_scissorEnabled)
         {
-            m_Device->setScissorEnabled(true);
-            m_Device->setScissorRect(uint16_t(IMGUI_MAX(0, area.m_scissorX))
-                           , uint16_t(IMGUI_MAX(0, area.m_scissorY-1) )
-                           , area.m_scissorWidth
-                           , area.m_scissorHeight+1
-                           );
+            _state.setScissor(true
+                            , uint16_t(IMGUI_MAX(0, area.m_scissorX))
+                            , uint16_t(IMGUI_MAX(0, area.m_scissorY-1) )
+                            , area.m_scissorWidth
+                            , area.m_scissorHeight+1
+                            );
         }
         else
         {
-            m_Device->setScissorEnabled(false);
-            m_Device->setScissorRect(0, 0, m_Device->backbuffer()->width(), m_Device->backbuffer()->height());
+            _state.setScissor(false, 0, 0, m_Device->backbuffer()->width(), m_Device->backbuffer()->height());
+        }
+    }
+
+    inline void applyScissor(const Ctr::UIDrawState& _state)
+    {
+        m_Device->setScissorEnabled(_state.scissorEnabled);
+        m_Device->setScissorRect(_state.scissorX, _state.scissorY, _state.scissorWidth, _state.scissorHeight);
+    }
+
+    inline void setCurrentScissor()
+    {
+        Ctr::UIDrawState state;
+        currentScissor(state);
+        applyScissor(state);
+    }
+
+    // Records a triangle list under the current scissor. The returned
+    // vertices are drawn at the next flush.
+    void* appendVertices(Ctr::IVertexDeclaration* _declaration, const Ctr::IShader* _program, const Ctr::ITexture* _texture,
+                         uint32_t _stride, uint32_t _numVertices)
+    {
+        Ctr::UIDrawState state(_declaration, _program, _texture);
+        currentScissor(state);
+
+        void* vertices = m_batcher.append(state, _stride, _numVertices);
+        if (!vertices)
+        {
+            flushBatches();
+            vertices = m_batcher.append(state, _stride, _numVertices);
         }
+        assert(vertices);
+        return vertices;
+    }
+
+    // One upload per vertex stream, one draw per batch.
+    void flushBatches()
+    {
+        if (m_batcher.empty())
+        {
+            return;
+        }
+
+        Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
+        const std::vector<Ctr::UIVertexStream>& streams = m_batcher.streams();
+        Ctr::IVertexBuffer* vertexBuffers[MAX_BATCH_STREAMS] = {};
+        assert(streams.size() <= MAX_BATCH_STREAMS);
+
+        for (size_t ii = 0; ii < streams.size(); ++ii)
+        {
+            const Ctr::UIVertexStream& stream = streams[ii];
+            if (stream.vertexCount > 0)
+            {
+                const size_t size = size_t(stream.vertexCount) * stream.stride;
+                vertexBuffers[ii] = uiRenderer->vertexBuffer(stream.declaration);
+                memcpy(vertexBuffers[ii]->lock(size), &stream.data[0], size);
+                vertexBuffers[ii]->unlock();
+            }
+        }
+
+        uiRenderer->device()->enableAlphaBlending();
+        uiRenderer->device()->setupBlendPipeline(Ctr::BlendAlpha);
+
+        const std::vector<Ctr::UIBatch>& batches = m_batcher.batches();
+        for (auto it = batches.begin(); it != batches.end(); it++)
+        {
+            if (it->state.texture)
+            {
+                const Ctr::GpuVariable* textureVariable = nullptr;
+                if (it->state.shader->getParameterByName("s_tex", textureVariable))
+                {
+                    textureVariable->setTexture(it->state.texture);
+                }
+            }
+
+            uiRenderer->setVertexBuffer(vertexBuffers[it->stream]);
+            uiRenderer->setShader(it->state.shader);
+            applyScissor(it->state);
+            uiRenderer->render(it->vertexCount, it->firstVertex);
+        }
+
+        uiRenderer->device()->disableAlphaBlending();
+
+        m_frameDraws += m_batcher.draws();
+        m_frameBatches += uint32_t(batches.size());
+        m_batcher.clear();
     }
 
     template <typename Ty, uint16_t Max=64>
@@ -3100,11 +3010,6 @@ struct Imgui
     uint64_t m_enabledAreaIds;
     Area m_areas[64];
 
-    float m_tempCoords[MAX_TEMP_COORDS * 2];
-    float m_tempNormals[MAX_TEMP_COORDS * 2];
-
-    float m_circleVerts[NUM_CIRCLE_VERTS * 2];
-
     uint16_t m_textureWidth;
     uint16_t m_textureHeight;
     float m_invTextureWidth;
@@ -3118,10 +3023,8 @@ struct Imgui
 
     struct Font
     {
-        stbtt_bakedchar m_cdata[96]; // ASCII 32..126 is 95 glyphs
+        Ctr::UIFont     m_metrics;
         Ctr::ITexture*  m_texture;
-        float           m_size;
-        uint32_t        m_id;
     };
 
     ImguiFontReference m_currentFontIdx;
@@ -3139,6 +3042,15 @@ struct Imgui
     Ctr::ITexture*      m_missingTexture;
 
     Ctr::IDevice*       m_Device;
+
+    Ctr::UIBatcher m_batcher;
+    Ctr::UITessellator m_tessellator;
+    float m_tempTessellation[Ctr::UITessellator::MaxPolygonCoords * 9 * 2];
+
+    uint32_t m_frameDraws;
+    uint32_t m_frameBatches;
+    uint32_t m_lastFrameDraws;
+    uint32_t m_lastFrameBatches;
 };
 
 static Imgui s_imgui;
@@ -3277,6 +3189,8 @@ int32_t imguiGetWidgetW()
 
 void imguiSetCurrentScissor()
 {
+    // Custom widgets draw immediately, over what imgui recorded so far.
+    s_imgui.flushBatches();
     return s_imgui.setCurrentScissor();
 }
 
@@ -3440,7 +3354,13 @@ bool imguiCube(const Ctr::ITexture* _cubemap, float _lod, bool _cross, ImguiAlig
 float imguiGetTextLength(const char* _text, ImguiFontReference _handle)
 {
     uint32_t numVertices = 0; //unused
-    return getTextLength(s_imgui.m_fonts[_handle].m_cdata, _text, numVertices);
+    return Ctr::UITessellator::textWidth(s_imgui.m_fonts[_handle].m_metrics, _text, numVertices);
+}
+
+void imguiBatchStatistics(uint32_t& _draws, uint32_t& _batches)
+{
+    _draws = s_imgui.m_lastFrameDraws;
+    _batches = s_imgui.m_lastFrameBatches;
 }
 
 bool imguiMouseOverArea()
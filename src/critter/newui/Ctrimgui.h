@@ -206,6 +206,8 @@ bool imguiImageChannel(const Ctr::ITexture* _image, uint8_t _channel, float _lod
 bool imguiCube(const Ctr::ITexture* _cubemap, float _lod = 0.0f, bool _cross = true, ImguiAlign::Enum _align = ImguiAlign::LeftIndented, bool _enabled = true);
 
 float imguiGetTextLength(const char* _text, ImguiFontReference _handle);
+// Widget draws and the batched draw calls they became last frame.
+void imguiBatchStatistics(uint32_t& _draws, uint32_t& _batches);
 bool imguiMouseOverArea();
 
 #endif // IMGUI_H_HEADER_GUARD
@@ -547,18 +547,52 @@ namespace
     }
 
 
-    static void fan(uint32_t _start, uint32_t _count)
+    // Triangulates the fill of every path in one index buffer lock and draws
+    // them with a single indexed call, split only when the ring is full.
+    static void fans(const struct GLNVGpath* _paths, int _npaths)
     {
-        uint32_t numTris = _count-2;
         Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
-        uint32_t* data = (uint32_t*)uiRenderer->indexBuffer()->lock(numTris * 3 * sizeof(uint32_t));
-        for (uint32_t ii = 0; ii < numTris; ++ii)
+        int first = 0;
+        while (first < _npaths)
         {
-            data[ii*3+0] = _start;
-            data[ii*3+1] = _start + ii + 1;
-            data[ii*3+2] = _start + ii + 2;
+            uint32_t numIndices = 0;
+            int last = first;
+            for (; last < _npaths; ++last)
+            {
+                if (_paths[last].fillCount < 3)
+                    continue;
+                const uint32_t pathIndices = uint32_t(_paths[last].fillCount - 2) * 3;
+                if (numIndices > 0 && numIndices + pathIndices > Ctr::UIRenderer::IndexCapacity)
+                    break;
+                numIndices += pathIndices;
+            }
+
+            if (numIndices > 0)
+            {
+                uint32_t* data = (uint32_t*)uiRenderer->indexBuffer()->lock(numIndices * sizeof(uint32_t));
+                for (int i = first; i < last; ++i)
+                {
+                    if (_paths[i].fillCount < 3)
+                        continue;
+                    const uint32_t start = uint32_t(_paths[i].fillOffset);
+                    const uint32_t numTris = uint32_t(_paths[i].fillCount) - 2;
+                    for (uint32_t ii = 0; ii < numTris; ++ii)
+                    {
+                        data[ii*3+0] = start;
+                        data[ii*3+1] = start + ii + 1;
+                        data[ii*3+2] = start + ii + 2;
+                    }
+                    data += numTris * 3;
+                }
+                uiRenderer->indexBuffer()->unlock();
+
+                uiRenderer->setDrawIndexed(true);
+                // Index count. Offset is baked into the indices.
+                uiRenderer->render(numIndices, 0);
+                uiRenderer->setDrawIndexed(false);
+            }
+            first = last;
         }
-        uiRenderer->indexBuffer()->unlock();
     }
 
     void setupNanoVgBlending()
@@ -584,25 +618,13 @@ namespace
         s_Device->setColorWriteState(false, false, false, false);
         Ctr::UIRenderer* uiRenderer = Ctr::UIRenderer::renderer();
 
-        for (i = 0; i < npaths; i++)
-        {
-            if (2 < paths[i].fillCount)
-            {
-                uiRenderer->setDrawIndexed(true);
-                uiRenderer->setPrimitiveType(Ctr::TriangleList);
-                uiRenderer->setShader(gl->prog);
-                s_Device->setupStencil(0xff, 0xff, 
-                                       Ctr::Always, Ctr::StencilKeep, Ctr::StencilIncrement, Ctr::StencilKeep, 
-                                       Ctr::Always, Ctr::StencilKeep, Ctr::StencilDecrement, Ctr::StencilKeep);
-
-                uiRenderer->setVertexBuffer(gl->tvb);
-                //bgfx::setTexture(0, gl->s_tex, gl->th);
-                fan(paths[i].fillOffset, paths[i].fillCount);
-
-                uiRenderer->render((paths[i].fillCount-2)*3, 0);
-                uiRenderer->setDrawIndexed(false);
-            }
-        }
+        uiRenderer->setPrimitiveType(Ctr::TriangleList);
+        uiRenderer->setShader(gl->prog);
+        s_Device->setupStencil(0xff, 0xff, 
+                               Ctr::Always, Ctr::StencilKeep, Ctr::StencilIncrement, Ctr::StencilKeep, 
+                               Ctr::Always, Ctr::StencilKeep, Ctr::StencilDecrement, Ctr::StencilKeep);
+        uiRenderer->setVertexBuffer(gl->tvb);
+        fans(paths, npaths);
 
         // Draw aliased off-pixels
         nvgRenderSetUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
@@ -649,22 +671,9 @@ namespace
         nvgRenderSetUniforms(gl, call->uniformOffset, call->image);
         uiRenderer->setPrimitiveType(Ctr::TriangleList);
 
-        for (i = 0; i < npaths; i++)
-        {
-            if (paths[i].fillCount == 0) continue;
-            uiRenderer->setShader(gl->prog);
-            //bgfx::setState(gl->state);
-            uiRenderer->setVertexBuffer(gl->tvb);
-            //bgfx::setTexture(0, gl->s_tex, gl->th);
-            uiRenderer->setDrawIndexed(true);
-
-            fan(paths[i].fillOffset, paths[i].fillCount);
-
-            // Index count. Offset is baked into the indices.
-            uiRenderer->render((paths[i].fillCount - 2) * 3, 0);
-            uiRenderer->setDrawIndexed(false);
-
-        }
+        uiRenderer->setShader(gl->prog);
+        uiRenderer->setVertexBuffer(gl->tvb);
+        fans(paths, npaths);
 
         uiRenderer->setPrimitiveType(Ctr::TriangleStrip);
         if (gl->edgeAntiAlias)
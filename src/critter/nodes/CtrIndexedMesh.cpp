@@ -47,6 +47,8 @@
 #include <CtrVertexStream.h>
 #include <CtrLog.h>
 #include <CtrVertexDeclarationMgr.h>
+#include <CtrVertexQuantizer.h>
+#include <CtrFrustum.h>
 
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
 // Assimp includes
@@ -61,7 +63,9 @@ IndexedMesh::IndexedMesh(Ctr::IDevice* device) :
     StreamedMesh  (device),
     _indices (0),
     _indexBuffer (0),
-    _indexBufferLocked (false)
+    _indexBufferLocked (false),
+    _indexFormat (Ctr::INDEX32),
+    _quantizeVertices (false)
 {
     _indexCount = new IntProperty(this, std::string("intbuffer"));
     _indicesBufferAttr = new UIntPtrProperty(this, std::string ("indbuffer"));
@@ -121,6 +125,8 @@ IndexedMesh::load(const aiMesh* inputMesh)
         }
     }
 
+    setLocalBounds(computeBounds((const float*)verticesPtr, 3, inputVertexCount));
+
     // Copy the index buffer
     size_t triangleCount = inputMesh->mNumFaces;
     for (size_t triangleId = 0; triangleId < triangleCount; triangleId++)
@@ -143,34 +149,9 @@ IndexedMesh::load(const aiMesh* inputMesh)
 
     setPrimitiveType(Ctr::TriangleList);
 
-    uint32_t offset = 0;
-    // Setup Elements
-    std::vector<Ctr::VertexElement> vertexElements;
-    vertexElements.push_back(Ctr::VertexElement(0, 0, Ctr::FLOAT3, Ctr::METHOD_DEFAULT, Ctr::POSITION, 0));
-    vertexElements.push_back(Ctr::VertexElement(0, 12, Ctr::FLOAT3, Ctr::METHOD_DEFAULT, Ctr::NORMAL, 0));
-    vertexElements.push_back(Ctr::VertexElement(0, 24, Ctr::FLOAT2, Ctr::METHOD_DEFAULT, Ctr::TEXCOORD, 0));
-    vertexElements.push_back(Ctr::VertexElement(0xFF, 0, Ctr::UNUSED, 0, 0, 0));
-
-    Ctr::VertexDeclarationParameters resource = Ctr::VertexDeclarationParameters(vertexElements);
-
-    if (Ctr::IVertexDeclaration* vertexDeclaration =
-        Ctr::VertexDeclarationMgr::vertexDeclarationMgr()->createVertexDeclaration(&resource))
-    {
-        setVertexDeclaration(vertexDeclaration);
-
-        Ctr::VertexStream* vertexStream =
-            new Ctr::VertexStream(Ctr::POSITION, 0, 3,
-            vertexCount(), (float*)verticesPtr);
-        Ctr::VertexStream* normalStream =
-            new Ctr::VertexStream(Ctr::NORMAL, 0, 3,
-            vertexCount(), (float*)normalsPtr);
-        Ctr::VertexStream* texCoordStream =
-            new Ctr::VertexStream(Ctr::TEXCOORD, 0, 2,
-            vertexCount(), (float*)uvsPtr);
-        addStream(vertexStream);
-        addStream(normalStream);
-        addStream(texCoordStream);
-    }
+    createStreams((const float*)verticesPtr, 
+                  (const float*)normalsPtr,
+                  (const float*)uvsPtr);
 
     // Nuke pointers
     delete[] verticesPtr;
@@ -238,6 +219,8 @@ IndexedMesh::load(const tinyobj::shape_t* shape)
         }
     }
 
+    setLocalBounds(computeBounds(&inputMesh->positions[0], 3, inputMesh->positions.size() / 3));
+
     // Copy the index buffer
     size_t newPrimitiveCount = inputMesh->indices.size() * 3;
     for (size_t indexId = 0; indexId < inputMesh->indices.size(); indexId++)
@@ -254,34 +237,9 @@ IndexedMesh::load(const tinyobj::shape_t* shape)
 
     setPrimitiveType(Ctr::TriangleList);
 
-    uint32_t offset = 0;
-    // Setup Elements
-    std::vector<Ctr::VertexElement> vertexElements;
-    vertexElements.push_back(Ctr::VertexElement(0, 0, Ctr::FLOAT3, Ctr::METHOD_DEFAULT, Ctr::POSITION, 0));
-    vertexElements.push_back(Ctr::VertexElement(0, 12, Ctr::FLOAT3, Ctr::METHOD_DEFAULT, Ctr::NORMAL, 0));
-    vertexElements.push_back(Ctr::VertexElement(0, 24, Ctr::FLOAT2, Ctr::METHOD_DEFAULT, Ctr::TEXCOORD, 0));
-    vertexElements.push_back(Ctr::VertexElement(0xFF, 0, Ctr::UNUSED, 0, 0, 0));
-
-    Ctr::VertexDeclarationParameters resource = Ctr::VertexDeclarationParameters(vertexElements);
-
-    if (Ctr::IVertexDeclaration* vertexDeclaration =
-        Ctr::VertexDeclarationMgr::vertexDeclarationMgr()->createVertexDeclaration(&resource))
-    {
-        setVertexDeclaration(vertexDeclaration);
-
-        Ctr::VertexStream* vertexStream =
-            new Ctr::VertexStream(Ctr::POSITION, 0, 3,
-            vertexCount(), (float*)verticesPtr);
-        Ctr::VertexStream* normalStream =
-            new Ctr::VertexStream(Ctr::NORMAL, 0, 3,
-            vertexCount(), (float*)normalsPtr);
-        Ctr::VertexStream* texCoordStream =
-            new Ctr::VertexStream(Ctr::TEXCOORD, 0, 2,
-            vertexCount(), (float*)uvsPtr);
-        addStream(vertexStream);
-        addStream(normalStream);
-        addStream(texCoordStream);
-    }
+    createStreams((const float*)verticesPtr, 
+                  (const float*)normalsPtr,
+                  (const float*)uvsPtr);
 
     bool result = false;
     if (create())
@@ -302,12 +260,89 @@ IndexedMesh::load(const tinyobj::shape_t* shape)
 #endif
 
 
+bool
+IndexedMesh::createStreams(const float* positions,
+                           const float* normals,
+                           const float* texCoords)
+{
+    Ctr::VertexStream* vertexStream =
+        new Ctr::VertexStream(Ctr::POSITION, 0, 3, vertexCount(), positions);
+    Ctr::VertexStream* normalStream =
+        new Ctr::VertexStream(Ctr::NORMAL, 0, 3, vertexCount(), normals);
+    Ctr::VertexStream* texCoordStream =
+        new Ctr::VertexStream(Ctr::TEXCOORD, 0, 2, vertexCount(), texCoords);
+
+    if (_quantizeVertices)
+    {
+        VertexQuantizer quantizer(localBounds());
+        bool quantizedPositions = quantizer.quantize(vertexStream);
+        quantizer.quantize(normalStream);
+        quantizer.quantize(texCoordStream);
+
+        setVertexDequantization(quantizedPositions ? quantizer.positionScale() : Vector4f(1, 1, 1, 1),
+                                quantizedPositions ? quantizer.positionOffset() : Vector4f(0, 0, 0, 0),
+                                quantizer.octahedralNormals());
+
+        const VertexQuantizationError& error = quantizer.error();
+        LOG("Quantized " << name() << " position error " << error.position <<
+            " normal error " << error.normal << " texcoord error " << error.texCoord);
+    }
+
+    // Setup Elements, packed back to back in the encoding of each stream.
+    VertexStream* streams[] = { vertexStream, normalStream, texCoordStream };
+    std::vector<Ctr::VertexElement> vertexElements;
+    uint32_t offset = 0;
+    for (uint32_t streamId = 0; streamId < 3; streamId++)
+    {
+        const VertexStream* stream = streams[streamId];
+        vertexElements.push_back(Ctr::VertexElement(0, offset, stream->type(), Ctr::METHOD_DEFAULT, 
+                                                    stream->usage(), stream->usageIndex()));
+        offset += stream->elementSizeInBytes();
+    }
+    vertexElements.push_back(Ctr::VertexElement(0xFF, 0, Ctr::UNUSED, 0, 0, 0));
+
+    Ctr::VertexDeclarationParameters resource = Ctr::VertexDeclarationParameters(vertexElements);
+
+    if (Ctr::IVertexDeclaration* vertexDeclaration =
+        Ctr::VertexDeclarationMgr::vertexDeclarationMgr()->createVertexDeclaration(&resource))
+    {
+        setVertexDeclaration(vertexDeclaration);
+        addStream(vertexStream);
+        addStream(normalStream);
+        addStream(texCoordStream);
+        return true;
+    }
+
+    safedelete(vertexStream);
+    safedelete(normalStream);
+    safedelete(texCoordStream);
+    return false;
+}
+
 uint32_t
 IndexedMesh::indexCount() const
 {
     return _indexCount->get();
 }
 
+Ctr::IndexFormat
+IndexedMesh::indexFormat() const
+{
+    return _indexFormat;
+}
+
+void
+IndexedMesh::setQuantizeVertices(bool quantizeVertices)
+{
+    _quantizeVertices = quantizeVertices;
+}
+
+bool
+IndexedMesh::quantizeVertices() const
+{
+    return _quantizeVertices;
+}
+
 bool
 IndexedMesh::cache()
 {
@@ -355,7 +390,20 @@ IndexedMesh::setIndices (const uint32_t* indexBuffer, uint32_t indexCount, uint3
     setPrimitiveCount (faceCount);
     indexCount = _indexCount->get();
 
-    if (indexCount > lastIndexCount)
+    // Meshes of fewer than 65536 vertices upload 16-bit indices.
+    uint32_t maxIndex = 0;
+    for (uint32_t indexId = 0; indexId < indexCount; indexId++)
+    {
+        maxIndex = maxValue(maxIndex, indexBuffer[indexId]);
+    }
+    Ctr::IndexFormat indexFormat = maxIndex <= 0xffff ? Ctr::INDEX16 : Ctr::INDEX32;
+    if (indexFormat != _indexFormat)
+    {
+        _indexFormat = indexFormat;
+        safedelete (_indexBuffer);
+    }
+
+    if (indexCount > lastIndexCount || !_indexBuffer)
     {
         if (_indices)
             ::free(_indices);
@@ -386,9 +434,20 @@ bool
 IndexedMesh::fillIndexBuffer()
 { 
     
-    if (uint32_t* indices =  static_cast<uint32_t*>(lockIndexBuffer()))
+    if (void* indices = lockIndexBuffer())
     {
-        memcpy(indices, _indices, sizeof(uint32_t)*_indexCount->get());
+        if (_indexFormat == Ctr::INDEX16)
+        {
+            uint16_t* shortIndices = static_cast<uint16_t*>(indices);
+            for (int32_t indexId = 0; indexId < _indexCount->get(); indexId++)
+            {
+                shortIndices[indexId] = (uint16_t)(_indices[indexId]);
+            }
+        }
+        else
+        {
+            memcpy(indices, _indices, sizeof(uint32_t)*_indexCount->get());
+        }
         unlockIndexBuffer();
         return true;
     }
@@ -400,7 +459,9 @@ IndexedMesh::createIndexBuffer()
 {
     if (!_indexBuffer)
     {
-        IndexBufferParameters ibResource= IndexBufferParameters(sizeof(uint32_t)*_indexCount->get());
+        uint32_t indexSize = _indexFormat == Ctr::INDEX16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        IndexBufferParameters ibResource= IndexBufferParameters(indexSize*_indexCount->get(), 
+                                                                false, false, _indexFormat);
         if (_indexBuffer = _device->createIndexBuffer(&ibResource))
         {
             return true;
@@ -414,10 +475,10 @@ IndexedMesh::createIndexBuffer()
     return true;
 }
 
-uint32_t* 
+void* 
 IndexedMesh::lockIndexBuffer()
 { 
-    return static_cast<uint32_t*>(_indexBuffer->lock());
+    return _indexBuffer->lock();
 };
 
 void 
@@ -82,6 +82,14 @@ class IndexedMesh : public Ctr::StreamedMesh
 
     uint32_t*                  indices() const;
     uint32_t                   indexCount() const;
+    Ctr::IndexFormat           indexFormat() const;
+
+    // Packs positions, normals and texture coordinates into compact
+    // formats on load (see VertexQuantizer). The shader must decode
+    // them with the VERTEXPOSITIONSCALE, VERTEXPOSITIONOFFSET and
+    // VERTEXNORMALENCODING parameters. Set before load.
+    void                       setQuantizeVertices(bool quantizeVertices);
+    bool                       quantizeVertices() const;
 
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
     bool                       load(const aiMesh* mesh);
@@ -93,9 +101,13 @@ class IndexedMesh : public Ctr::StreamedMesh
     const IIndexBuffer*        indexBuffer() const;
     bool                       fillIndexBuffer();
     bool                       createIndexBuffer();
-    uint32_t*                  lockIndexBuffer();
+    void*                      lockIndexBuffer();
     void                       unlockIndexBuffer();
 
+    bool                       createStreams(const float* positions,
+                                             const float* normals,
+                                             const float* texCoords);
+
   protected:
     uint32_t*                  _indices;
 
@@ -103,6 +115,8 @@ class IndexedMesh : public Ctr::StreamedMesh
 
     Ctr::IIndexBuffer*          _indexBuffer;
     bool                       _indexBufferLocked;
+    Ctr::IndexFormat           _indexFormat;
+    bool                       _quantizeVertices;
     IntProperty *              _indexCount;
     UIntPtrProperty *          _indicesBufferAttr;
 };
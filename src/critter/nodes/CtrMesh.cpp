@@ -49,6 +49,7 @@
 #include <CtrIShader.h>
 #include <CtrTextureMgr.h>
 #include <CtrITexture.h>
+#include <CtrFrustum.h>
 
 namespace Ctr
 {
@@ -65,7 +66,13 @@ _locked (false),
 _entity (0),
 _material (0),
 _topologySubtype(Tri),
-_groupId(0)
+_groupId(0),
+_localBounds(emptyBounds()),
+_worldBounds(emptyBounds()),
+_worldBoundsValid(false),
+_positionScale(1, 1, 1, 1),
+_positionOffset(0, 0, 0, 0),
+_octahedralNormals(false)
 {
     _visible = new BoolProperty (this, std::string("visible"));
     setVisible (true);
@@ -90,6 +97,69 @@ Mesh::setGroupId(uint32_t group)
     _groupId = group;
 }
 
+void
+Mesh::setLocalBounds(const Ctr::Region3f& bounds)
+{
+    _localBounds = bounds;
+    _worldBoundsValid = false;
+}
+
+const Ctr::Region3f&
+Mesh::localBounds() const
+{
+    return _localBounds;
+}
+
+void
+Mesh::setVertexDequantization(const Ctr::Vector4f& positionScale,
+                              const Ctr::Vector4f& positionOffset,
+                              bool octahedralNormals)
+{
+    _positionScale = positionScale;
+    _positionOffset = positionOffset;
+    _octahedralNormals = octahedralNormals;
+}
+
+const Ctr::Vector4f&
+Mesh::positionScale() const
+{
+    return _positionScale;
+}
+
+const Ctr::Vector4f&
+Mesh::positionOffset() const
+{
+    return _positionOffset;
+}
+
+bool
+Mesh::octahedralNormals() const
+{
+    return _octahedralNormals;
+}
+
+const Ctr::Region3f&
+Mesh::worldBounds() const
+{
+    return _worldBounds;
+}
+
+bool
+Mesh::updateWorldBounds()
+{
+    const Ctr::Matrix44f& world = worldTransform();
+    if (_worldBoundsValid && world == _worldBoundsTransform)
+    {
+        return false;
+    }
+
+    _worldBoundsTransform = world;
+    // Meshes without load time bounds are never culled.
+    _worldBounds = boundsValid(_localBounds) ? transformBounds(_localBounds, world) : infiniteBounds();
+    _worldBoundsValid = true;
+    return true;
+}
+
 bool
 Mesh::dynamic() const 
 { 
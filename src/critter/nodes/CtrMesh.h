@@ -151,6 +151,24 @@ class Mesh : public Ctr::TransformNode
     void                            setShadowMask(uint32_t);
     uint32_t                        shadowMask() const;
 
+    // Object space bounds, computed at load.
+    void                            setLocalBounds(const Ctr::Region3f& bounds);
+    const Ctr::Region3f&            localBounds() const;
+
+    // World space bounds. Only valid after updateWorldBounds.
+    const Ctr::Region3f&            worldBounds() const;
+    // Returns true if the world bounds moved since the last call.
+    bool                            updateWorldBounds();
+
+    // Restores quantized vertices in the shader (see VertexQuantizer).
+    // Identity scale and offset, float normals unless set.
+    void                            setVertexDequantization(const Ctr::Vector4f& positionScale,
+                                                            const Ctr::Vector4f& positionOffset,
+                                                            bool octahedralNormals);
+    const Ctr::Vector4f&            positionScale() const;
+    const Ctr::Vector4f&            positionOffset() const;
+    bool                            octahedralNormals() const;
+
   protected:
     const IVertexBuffer*            vertexBuffer() const;
 
@@ -171,6 +189,15 @@ class Mesh : public Ctr::TransformNode
     Ctr::BoolProperty*               _visible;
     bool                            _dynamic;
     uint32_t                        _groupId;
+
+    Ctr::Region3f                   _localBounds;
+    Ctr::Region3f                   _worldBounds;
+    Ctr::Matrix44f                  _worldBoundsTransform;
+    bool                            _worldBoundsValid;
+
+    Ctr::Vector4f                   _positionScale;
+    Ctr::Vector4f                   _positionOffset;
+    bool                            _octahedralNormals;
 };
 }
 #endif
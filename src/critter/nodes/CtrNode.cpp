@@ -94,6 +94,12 @@ Node::uncache ()
     }
 }
 
+size_t
+Node::referenceCount() const
+{
+    return _referenceProperties.size();
+}
+
 const std::string&
 Node::name() const
 {
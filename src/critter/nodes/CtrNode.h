@@ -79,6 +79,9 @@ class Node
 
     void                        addTask(std::pair<const Property*, std::function<void(const Property*)> > task);
 
+    // Number of properties that depend on this node.
+    size_t                      referenceCount() const;
+
   protected:
     std::set <Property*>        _properties;
     std::set <Property*>        _referenceProperties;
@@ -111,6 +111,7 @@ TweakFlags::TweakFlags(const EnumTweakType* enumTypeIn, const std::string& categ
 {
 }
 
+uint64_t Property::_changeCount = 0;
 
 Property::Property(Node* node, 
                    const std::string& name, 
@@ -119,6 +120,7 @@ Property::Property(Node* node,
     _node (node), /* Container of property */
     _group (group), /* group for property */
     _cached (false),
+    _version (0),
     _tweakFlags(nullptr)
 {
     _node->addProperty (this);
@@ -131,6 +133,7 @@ Property::Property(Node* node,
     _node(node), /* Container of property */
     _group(nullptr), /* group for property */
     _cached(false),
+    _version(0),
     _tweakFlags(tweakFlags)
 {
     _node->addProperty(this);
@@ -153,6 +156,18 @@ Property::cached() const
     return _cached;
 }
 
+uint64_t
+Property::version() const
+{
+    return _version;
+}
+
+uint64_t
+Property::changeCount()
+{
+    return _changeCount;
+}
+
 const Node* 
 Property::group() const
 {
@@ -180,6 +195,8 @@ Property::node()
 void
 Property::uncache ()
 {
+    _changeCount++;
+    _version++;
     _cached = false;
     Node::uncache();
 }
@@ -229,6 +246,7 @@ Property::addDependency(Property* p, size_t dependencyId)
         p->addProperty(this, PropertyReference);
     }
 
+    _version++;
     _cached = false;
     Node::uncache();
 }
@@ -254,6 +272,7 @@ Property::addDependency(Property* p, const std::string& dependencyId)
         _dependencies.insert(std::make_pair(dependencyId, p));
         p->addProperty(this, PropertyReference);
     }
+    _version++;
     _cached = false;
     Node::uncache();
 }
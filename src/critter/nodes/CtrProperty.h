@@ -124,15 +124,25 @@ class Property : public Node
     void                       removeDependency(Property* p, const std::string& dependencyId);
     void                       addDependency(Property* p, const std::string& dependencyId);
 
-  protected:
     bool                       cached() const;
 
+    // Bumped on every invalidation of this property, consumers
+    // compare versions instead of hashing values.
+    uint64_t                   version() const;
+
+    // Incremented whenever any property is invalidated. Frame
+    // schedulers compare it across frames to detect edits.
+    static uint64_t            changeCount();
+
   protected:
     std::map<std::string, Property*>  _dependencies;
     Node*                      _node;
     Node*                      _group;
     TweakFlags*                _tweakFlags;
     mutable bool               _cached;
+    uint64_t                   _version;
+
+    static uint64_t            _changeCount;
 };
 }
 
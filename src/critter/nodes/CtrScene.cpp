@@ -46,8 +46,13 @@
 #include <CtrShaderMgr.h>
 #include <CtrMaterial.h>
 #include <CtrIBLProbe.h>
+#include <CtrIrradianceVolume.h>
+#include <CtrProbeCapture.h>
 #include <CtrCamera.h>
 #include <CtrBrdf.h>
+#include <CtrSceneBvh.h>
+#include <CtrFrustum.h>
+#include <CtrProfiler.h>
 #include <Ctrimgui.h>
 
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
@@ -64,6 +69,10 @@ namespace Ctr
 {
 namespace
 {
+// Probes rebaked per volume each frame, the rest of the dirty cells are
+// picked up over the following frames.
+const size_t IrradianceProbesPerFrame = 64;
+
 //
 // Windows only.
 // [TODO] Will need abstraction for linux / osx.
@@ -220,11 +229,42 @@ std::string GetFileNameWithoutExtension(const std::string& filePath)
 
 }
 
+//------------------------------------------------------------
+// Per pass hierarchy and the result of the last visibility
+// query. Render passes query the same view many times per
+// frame (and probes query the same sphere every frame), so
+// the result is reused until the query or the scene changes.
+//------------------------------------------------------------
+struct Scene::PassVisibility
+{
+    PassVisibility() :
+        bvhDirty(true),
+        queryValid(false),
+        frustumQuery(false),
+        radius(0.0f),
+        version(0)
+    {}
+
+    SceneBvh                   bvh;
+    bool                       bvhDirty;
+
+    bool                       queryValid;
+    bool                       frustumQuery;
+    Matrix44f                  viewProj;
+    Vector3f                   center;
+    float                      radius;
+    uint64_t                   version;
+    std::vector<Ctr::Mesh*>    visible;
+};
+
 Scene::Scene(Ctr::IDevice* device) : 
     Ctr::RenderNode(device),
     _camera(nullptr),
     _activeBrdfProperty(nullptr),
-    _brdfType(nullptr)
+    _brdfType(nullptr),
+    _irradianceCapture(nullptr),
+    _irradianceCaptureVersion(0),
+    _sceneVersion(0)
 {
     _camera = new Ctr::Camera(_device);
     loadBrdfs();
@@ -251,6 +291,14 @@ Scene::~Scene()
     }
     _probes.clear();
 
+    for (auto it = _irradianceVolumes.begin(); it != _irradianceVolumes.end(); it++)
+    {
+        Ctr::IrradianceVolume* volume = *it;
+        safedelete(volume);
+    }
+    _irradianceVolumes.clear();
+    safedelete(_irradianceCapture);
+
     for (auto it = _materials.begin(); it != _materials.end(); it++)
     {
         Ctr::Material* material = *it;
@@ -264,6 +312,12 @@ Scene::~Scene()
         safedelete(brdf);
     }
     _brdfCache.clear();
+
+    for (auto it = _visibilityByPass.begin(); it != _visibilityByPass.end(); it++)
+    {
+        safedelete(it->second);
+    }
+    _visibilityByPass.clear();
 }
 
 bool
@@ -322,7 +376,8 @@ Scene::activeBrdf() const
 
 Entity*
 Scene::load(const std::string& meshFilePathName,
-const std::string& userMaterialPathName)
+const std::string& userMaterialPathName,
+bool quantizeVertices)
 {
     Assimp::Importer importer;
     uint32_t flags = aiProcess_CalcTangentSpace |
@@ -356,6 +411,7 @@ const std::string& userMaterialPathName)
     {
         Ctr::IndexedMesh* mesh = new Ctr::IndexedMesh(_device);
         mesh->setName(scene->mMeshes[meshId]->mName.C_Str());
+        mesh->setQuantizeVertices(quantizeVertices);
         mesh->load(scene->mMeshes[meshId]);
         Material * material = new Material(_device);
 
@@ -452,7 +508,8 @@ const std::string& userMaterialPathName)
 #else
 Entity*
 Scene::load(const std::string& meshFilePathName, 
-            const std::string& userMaterialPathName)
+            const std::string& userMaterialPathName,
+            bool quantizeVertices)
 {
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
@@ -497,6 +554,7 @@ Scene::load(const std::string& meshFilePathName,
     {
         Ctr::IndexedMesh* mesh = new Ctr::IndexedMesh(_device);
         mesh->setName(shapes[meshId].name);
+        mesh->setQuantizeVertices(quantizeVertices);
         mesh->load(&shapes[meshId]);
         Material * material = new Material(_device);
     
@@ -584,6 +642,7 @@ Scene::destroy(Entity* entity)
                 }
             }
         }
+        invalidateVisibility();
  
         auto entityIt = _entities.find(entity);
         if (entityIt != _entities.end())
@@ -678,11 +737,20 @@ Scene::load(Ctr::IDevice* device,
 void
 Scene::update()
 {
+    CTR_PROFILE_ZONE("Scene::update");
+    updateVisibility();
+
     for (auto it = _probes.begin(); it != _probes.end(); it++)
     {
         (*it)->update();
     }
 
+    // Only the cells around meshes that moved are rebaked, spread over frames.
+    if (!_irradianceVolumes.empty())
+    {
+        bakeIrradianceVolumes("all", IrradianceProbesPerFrame);
+    }
+
     _brdfCache[_activeBrdfProperty->get()]->compute();
 
 }
@@ -701,6 +769,90 @@ Scene::addProbe()
     return probe;
 }
 
+const std::vector<IrradianceVolume*>&
+Scene::irradianceVolumes() const
+{
+    return _irradianceVolumes;
+}
+
+Ctr::IrradianceVolume*
+Scene::addIrradianceVolume(const Ctr::Region3f& bounds, const Ctr::Vector3i& resolution)
+{
+    IrradianceVolume* volume = new IrradianceVolume();
+    volume->create(bounds, resolution);
+    _irradianceVolumes.push_back(volume);
+    return volume;
+}
+
+Ctr::IrradianceVolume*
+Scene::addIrradianceVolume(const Ctr::Vector3i& resolution, const std::string& passName)
+{
+    return addIrradianceVolume(worldBounds(passName), resolution);
+}
+
+size_t
+Scene::bakeIrradianceVolumes(const std::string& passName, size_t maxProbes)
+{
+    CTR_PROFILE_ZONE("Scene::bakeIrradianceVolumes");
+    // Refresh the world bounds first so moves bump the scene version the
+    // capture is keyed on.
+    updateVisibility();
+    const std::vector<Ctr::Mesh*>& meshes = meshesForPass(passName);
+
+    bool dirty = false;
+    for (auto it = _irradianceVolumes.begin(); it != _irradianceVolumes.end(); it++)
+    {
+        (*it)->invalidateChanged(meshes);
+        dirty |= (*it)->dirtyCount() > 0;
+    }
+    if (!dirty)
+        return 0;
+
+    // All volumes bake from the same capture of the scene.
+    const ProbeCapture& capture = irradianceCapture(passName);
+
+    size_t baked = 0;
+    for (auto it = _irradianceVolumes.begin(); it != _irradianceVolumes.end(); it++)
+    {
+        baked += (*it)->bake(capture, maxProbes);
+    }
+    return baked;
+}
+
+const ProbeCapture&
+Scene::irradianceCapture(const std::string& passName)
+{
+    if (!_irradianceCapture ||
+        _irradianceCaptureVersion != _sceneVersion ||
+        _irradianceCapturePass != passName)
+    {
+        if (!_irradianceCapture)
+            _irradianceCapture = new ProbeCapture();
+        _irradianceCapture->build(meshesForPass(passName));
+        _irradianceCapturePass = passName;
+        _irradianceCaptureVersion = _sceneVersion;
+    }
+    return *_irradianceCapture;
+}
+
+Ctr::Region3f
+Scene::worldBounds(const std::string& passName) const
+{
+    Ctr::Region3f bounds = emptyBounds();
+    const std::vector<Ctr::Mesh*>& meshes = meshesForPass(passName);
+    for (auto it = meshes.begin(); it != meshes.end(); it++)
+    {
+        Ctr::Mesh* mesh = *it;
+        mesh->updateWorldBounds();
+        const Ctr::Region3f& meshBounds = mesh->worldBounds();
+        if (boundsValid(meshBounds) && meshBounds != infiniteBounds())
+        {
+            expandBounds(bounds, meshBounds);
+        }
+    }
+    return bounds;
+}
+
 const Camera *
 Scene::camera() const
 {
@@ -752,6 +904,113 @@ Scene::addToPass(const std::string& passName, Mesh* mesh)
         meshPassIt = _meshesByPass.find(passName);
     }
     meshPassIt->second.push_back(mesh);
+    invalidateVisibility();
+}
+
+void
+Scene::invalidateVisibility()
+{
+    for (auto it = _visibilityByPass.begin(); it != _visibilityByPass.end(); it++)
+    {
+        it->second->bvhDirty = true;
+    }
+    _sceneVersion++;
+}
+
+void
+Scene::updateVisibility()
+{
+    // Refresh world bounds, only touch the hierarchies if something moved.
+    bool moved = false;
+    const std::vector<Ctr::Mesh*>& meshes = meshesForPass("all");
+    for (auto it = meshes.begin(); it != meshes.end(); it++)
+    {
+        moved |= (*it)->updateWorldBounds();
+    }
+
+    if (!moved)
+        return;
+
+    for (auto it = _visibilityByPass.begin(); it != _visibilityByPass.end(); it++)
+    {
+        PassVisibility* visibility = it->second;
+        if (visibility->bvhDirty)
+            continue;
+
+        visibility->bvh.refit();
+        if (visibility->bvh.needsRebuild())
+            visibility->bvhDirty = true;
+    }
+    _sceneVersion++;
+}
+
+Scene::PassVisibility*
+Scene::passVisibility(const std::string& passName) const
+{
+    auto visibilityIt = _visibilityByPass.find(passName);
+    if (visibilityIt == _visibilityByPass.end())
+    {
+        visibilityIt = _visibilityByPass.insert(std::make_pair(passName, new PassVisibility())).first;
+    }
+
+    PassVisibility* visibility = visibilityIt->second;
+    if (visibility->bvhDirty)
+    {
+        visibility->bvh.build(meshesForPass(passName));
+        visibility->bvhDirty = false;
+        visibility->queryValid = false;
+    }
+    return visibility;
+}
+
+const std::vector<Ctr::Mesh*>&
+Scene::visibleMeshesForPass(const std::string& passName,
+                            const CameraTransformCache* transforms) const
+{
+    PassVisibility* visibility = passVisibility(passName);
+    const Matrix44f& viewProj = transforms->viewProjMatrix();
+    if (visibility->queryValid &&
+        visibility->frustumQuery &&
+        visibility->version == _sceneVersion &&
+        visibility->viewProj == viewProj)
+    {
+        return visibility->visible;
+    }
+
+    visibility->visible.clear();
+    visibility->bvh.cull(Frustum(viewProj), visibility->visible);
+
+    visibility->queryValid = true;
+    visibility->frustumQuery = true;
+    visibility->viewProj = viewProj;
+    visibility->version = _sceneVersion;
+    return visibility->visible;
+}
+
+const std::vector<Ctr::Mesh*>&
+Scene::visibleMeshesForPass(const std::string& passName,
+                            const Ctr::Vector3f& center,
+                            float radius) const
+{
+    PassVisibility* visibility = passVisibility(passName);
+    if (visibility->queryValid &&
+        !visibility->frustumQuery &&
+        visibility->version == _sceneVersion &&
+        visibility->center == center &&
+        visibility->radius == radius)
+    {
+        return visibility->visible;
+    }
+
+    visibility->visible.clear();
+    visibility->bvh.cull(center, radius, visibility->visible);
+
+    visibility->queryValid = true;
+    visibility->frustumQuery = false;
+    visibility->center = center;
+    visibility->radius = radius;
+    visibility->version = _sceneVersion;
+    return visibility->visible;
 }
 
 }
\ No newline at end of file
@@ -53,8 +53,11 @@ class Entity;
 class Mesh;
 class Material;
 class Camera;
+class CameraTransformCache;
 class Brdf;
 class IBLProbe;
+class IrradianceVolume;
+class ProbeCapture;
 
 class Scene : public Ctr::RenderNode
 {
@@ -62,9 +65,11 @@ class Scene : public Ctr::RenderNode
     Scene(Ctr::IDevice* device);
     virtual ~Scene();
 
-    // Load an entity from disk
+    // Load an entity from disk. quantizeVertices packs the meshes into
+    // compact vertex formats, the material shader must decode them.
     Entity *                   load(const std::string& fileName, 
-                                    const std::string& userMaterialPathName);
+                                    const std::string& userMaterialPathName,
+                                    bool quantizeVertices = false);
 
     // Load an entity from disk
     static Entity *            load(Ctr::IDevice* device,
@@ -77,9 +82,36 @@ class Scene : public Ctr::RenderNode
 
     const std::vector<Ctr::Mesh*>& meshesForPass(const std::string& passName) const;
 
+    // Meshes of the pass that intersect the view frustum of the transform cache.
+    // The result is cached until the view or the scene changes.
+    const std::vector<Ctr::Mesh*>& visibleMeshesForPass(const std::string& passName,
+                                                        const CameraTransformCache* transforms) const;
+
+    // Meshes of the pass that intersect the sphere.
+    const std::vector<Ctr::Mesh*>& visibleMeshesForPass(const std::string& passName,
+                                                        const Ctr::Vector3f& center,
+                                                        float radius) const;
+
     const std::vector<IBLProbe*>& probes() const;
     IBLProbe*                   addProbe();
 
+    // Grids of SH probes, far cheaper per probe than an IBLProbe.
+    const std::vector<IrradianceVolume*>& irradianceVolumes() const;
+    IrradianceVolume*           addIrradianceVolume(const Ctr::Region3f& bounds,
+                                                    const Ctr::Vector3i& resolution);
+    // Volume over the world bounds of the meshes in the pass.
+    IrradianceVolume*           addIrradianceVolume(const Ctr::Vector3i& resolution,
+                                                    const std::string& passName = "all");
+
+    // Rebakes the cells of the irradiance volumes around meshes of the pass
+    // that moved since the last bake, on the CPU, at most maxProbes per
+    // volume. Returns the probes baked.
+    size_t                     bakeIrradianceVolumes(const std::string& passName = "all",
+                                                     size_t maxProbes = SIZE_MAX);
+
+    // Union of the finite world bounds of the meshes in the pass.
+    Ctr::Region3f              worldBounds(const std::string& passName = "all") const;
+
     const Brdf*                activeBrdf() const;
     IntProperty*               activeBrdfProperty();
 
@@ -92,7 +124,15 @@ class Scene : public Ctr::RenderNode
     void                       addToPass(const std::string& passName,
                                          Mesh* mesh);
 
+    void                       updateVisibility();
+
   private:  
+    struct PassVisibility;
+    PassVisibility*            passVisibility(const std::string& passName) const;
+    void                       invalidateVisibility();
+    const ProbeCapture&        irradianceCapture(const std::string& passName);
+
+
     Camera*                    _camera;
     IntProperty*               _activeBrdfProperty;
     EnumTweakType *            _brdfType;
@@ -101,8 +141,17 @@ class Scene : public Ctr::RenderNode
 
     std::set<Entity*>          _entities;
     std::vector<IBLProbe*>     _probes;
+    std::vector<IrradianceVolume*> _irradianceVolumes;
+    // Scene capture the volumes bake from, kept until a mesh is added or
+    // moves (the scene version changes) or another pass is baked.
+    ProbeCapture*              _irradianceCapture;
+    std::string                _irradianceCapturePass;
+    uint64_t                   _irradianceCaptureVersion;
     std::set<Material*>        _materials;
     std::map<std::string, std::vector<Ctr::Mesh*> > _meshesByPass;
+
+    mutable std::map<std::string, PassVisibility*> _visibilityByPass;
+    uint64_t                   _sceneVersion;
 };
 
 }
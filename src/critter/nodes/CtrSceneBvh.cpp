@@ -0,0 +1,326 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrSceneBvh.h>
+#include <CtrMesh.h>
+
+namespace Ctr
+{
+namespace
+{
+const uint32_t MaxLeafSize = 4;
+const uint32_t BinCount = 12;
+// Rebuild once refitting has grown the root surface area by this factor.
+const float RebuildAreaRatio = 2.0f;
+
+struct Bin
+{
+    Bin() : bounds(emptyBounds()), count(0) {}
+    Region3f                   bounds;
+    uint32_t                   count;
+};
+}
+
+SceneBvh::SceneBvh() :
+    _builtArea(0.0f)
+{
+}
+
+SceneBvh::~SceneBvh()
+{
+}
+
+void
+SceneBvh::clear()
+{
+    _nodes.clear();
+    _meshes.clear();
+    _centroids.clear();
+    _meshBounds.clear();
+    _builtArea = 0.0f;
+}
+
+bool
+SceneBvh::empty() const
+{
+    return _nodes.empty();
+}
+
+const Region3f&
+SceneBvh::bounds() const
+{
+    static const Region3f noBounds = emptyBounds();
+    return _nodes.empty() ? noBounds : _nodes[0].bounds;
+}
+
+bool
+SceneBvh::needsRebuild() const
+{
+    if (_nodes.empty())
+        return false;
+    return boundsSurfaceArea(_nodes[0].bounds) > _builtArea * RebuildAreaRatio;
+}
+
+void
+SceneBvh::build(const std::vector<Mesh*>& meshes)
+{
+    clear();
+    if (meshes.empty())
+        return;
+
+    _meshes = meshes;
+    _meshBounds.reserve(_meshes.size());
+    _centroids.reserve(_meshes.size());
+    for (auto it = _meshes.begin(); it != _meshes.end(); it++)
+    {
+        (*it)->updateWorldBounds();
+        _meshBounds.push_back((*it)->worldBounds());
+        _centroids.push_back(boundsCenter((*it)->worldBounds()));
+    }
+
+    _nodes.reserve(_meshes.size() * 2);
+    _nodes.push_back(Node());
+    buildNode(0, 0, (uint32_t)_meshes.size());
+    _builtArea = boundsSurfaceArea(_nodes[0].bounds);
+
+    // Only the mesh order is needed after the build.
+    _centroids.clear();
+    _meshBounds.clear();
+}
+
+void
+SceneBvh::buildNode(uint32_t nodeId, uint32_t first, uint32_t count)
+{
+    Region3f bounds = emptyBounds();
+    Region3f centroidBounds = emptyBounds();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        expandBounds(bounds, _meshBounds[i]);
+        expandBounds(centroidBounds, _centroids[i]);
+    }
+
+    _nodes[nodeId].bounds = bounds;
+    _nodes[nodeId].first = first;
+    _nodes[nodeId].count = count;
+    if (count <= MaxLeafSize)
+        return;
+
+    // Split along the axis with the largest centroid extent.
+    Vector3f extent = centroidBounds.maxExtent - centroidBounds.minExtent;
+    uint32_t axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (extent[axis] <= 0.0f)
+        return;
+
+    // Binned SAH.
+    Bin bins[BinCount];
+    float binScale = (float)BinCount / extent[axis];
+    float axisMin = centroidBounds.minExtent[axis];
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        uint32_t binId = minValue((uint32_t)((_centroids[i][axis] - axisMin) * binScale), BinCount - 1);
+        bins[binId].count++;
+        expandBounds(bins[binId].bounds, _meshBounds[i]);
+    }
+
+    float rightArea[BinCount];
+    uint32_t rightCount[BinCount];
+    Region3f accumulated = emptyBounds();
+    uint32_t accumulatedCount = 0;
+    for (uint32_t i = BinCount - 1; i > 0; i--)
+    {
+        expandBounds(accumulated, bins[i].bounds);
+        accumulatedCount += bins[i].count;
+        rightArea[i] = boundsSurfaceArea(accumulated);
+        rightCount[i] = accumulatedCount;
+    }
+
+    float bestCost = FLT_MAX;
+    uint32_t bestSplit = 0;
+    accumulated = emptyBounds();
+    accumulatedCount = 0;
+    for (uint32_t i = 0; i < BinCount - 1; i++)
+    {
+        expandBounds(accumulated, bins[i].bounds);
+        accumulatedCount += bins[i].count;
+        if (accumulatedCount == 0 || rightCount[i + 1] == 0)
+            continue;
+        float cost = boundsSurfaceArea(accumulated) * accumulatedCount +
+                     rightArea[i + 1] * rightCount[i + 1];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = i + 1;
+        }
+    }
+
+    // Split only when it beats testing every mesh in the node.
+    float leafCost = boundsSurfaceArea(bounds) * count;
+    if (bestSplit == 0 || bestCost >= leafCost)
+        return;
+
+    uint32_t middle = first;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        uint32_t binId = minValue((uint32_t)((_centroids[i][axis] - axisMin) * binScale), BinCount - 1);
+        if (binId < bestSplit)
+        {
+            std::swap(_meshes[i], _meshes[middle]);
+            std::swap(_meshBounds[i], _meshBounds[middle]);
+            std::swap(_centroids[i], _centroids[middle]);
+            middle++;
+        }
+    }
+
+    uint32_t leftChild = (uint32_t)_nodes.size();
+    _nodes.push_back(Node());
+    _nodes.push_back(Node());
+    _nodes[nodeId].first = leftChild;
+    _nodes[nodeId].count = 0;
+
+    buildNode(leftChild, first, middle - first);
+    buildNode(leftChild + 1, middle, first + count - middle);
+}
+
+void
+SceneBvh::refit()
+{
+    // Children are always stored after their parent.
+    for (size_t nodeId = _nodes.size(); nodeId-- > 0; )
+    {
+        Node& node = _nodes[nodeId];
+        Region3f bounds = emptyBounds();
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                expandBounds(bounds, _meshes[i]->worldBounds());
+            }
+        }
+        else
+        {
+            expandBounds(bounds, _nodes[node.first].bounds);
+            expandBounds(bounds, _nodes[node.first + 1].bounds);
+        }
+        node.bounds = bounds;
+    }
+}
+
+void
+SceneBvh::appendAll(uint32_t nodeId, std::vector<Mesh*>& visible) const
+{
+    const Node& node = _nodes[nodeId];
+    if (node.count > 0)
+    {
+        visible.insert(visible.end(), _meshes.begin() + node.first, _meshes.begin() + node.first + node.count);
+    }
+    else
+    {
+        appendAll(node.first, visible);
+        appendAll(node.first + 1, visible);
+    }
+}
+
+void
+SceneBvh::cullNode(uint32_t nodeId, const Frustum& frustum, std::vector<Mesh*>& visible) const
+{
+    const Node& node = _nodes[nodeId];
+    FrustumTest test = frustum.classify(node.bounds);
+    if (test == FrustumOutside)
+        return;
+    if (test == FrustumInside)
+    {
+        appendAll(nodeId, visible);
+        return;
+    }
+
+    if (node.count > 0)
+    {
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            if (frustum.intersects(_meshes[i]->worldBounds()))
+                visible.push_back(_meshes[i]);
+        }
+    }
+    else
+    {
+        cullNode(node.first, frustum, visible);
+        cullNode(node.first + 1, frustum, visible);
+    }
+}
+
+void
+SceneBvh::cull(const Frustum& frustum, std::vector<Mesh*>& visible) const
+{
+    if (!_nodes.empty())
+        cullNode(0, frustum, visible);
+}
+
+void
+SceneBvh::cullNode(uint32_t nodeId, const Vector3f& center, float radius, std::vector<Mesh*>& visible) const
+{
+    const Node& node = _nodes[nodeId];
+    if (!boundsIntersectSphere(node.bounds, center, radius))
+        return;
+
+    if (node.count > 0)
+    {
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            if (boundsIntersectSphere(_meshes[i]->worldBounds(), center, radius))
+                visible.push_back(_meshes[i]);
+        }
+    }
+    else
+    {
+        cullNode(node.first, center, radius, visible);
+        cullNode(node.first + 1, center, radius, visible);
+    }
+}
+
+void
+SceneBvh::cull(const Vector3f& center, float radius, std::vector<Mesh*>& visible) const
+{
+    if (!_nodes.empty())
+        cullNode(0, center, radius, visible);
+}
+
+}
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_SCENE_BVH
+#define INCLUDED_CRT_SCENE_BVH
+
+#include <CtrPlatform.h>
+#include <CtrRegion.h>
+#include <CtrFrustum.h>
+
+namespace Ctr
+{
+class Mesh;
+
+//--------------------------------------------------------------------
+//
+// SceneBvh
+//
+// Bounding volume hierarchy over mesh world bounds.
+// Built with a binned SAH split on mesh centroids. When meshes move
+// the hierarchy is refit bottom up; rebuild when the refit tree has
+// degraded (see needsRebuild).
+//
+//--------------------------------------------------------------------
+class SceneBvh
+{
+  public:
+    SceneBvh();
+    ~SceneBvh();
+
+    void                       build(const std::vector<Mesh*>& meshes);
+    void                       refit();
+    void                       clear();
+
+    bool                       needsRebuild() const;
+    bool                       empty() const;
+    const Region3f&            bounds() const;
+
+    // Append every mesh whose bounds intersect the frustum.
+    void                       cull(const Frustum& frustum,
+                                    std::vector<Mesh*>& visible) const;
+
+    // Append every mesh whose bounds intersect the sphere.
+    void                       cull(const Vector3f& center,
+                                    float radius,
+                                    std::vector<Mesh*>& visible) const;
+
+  private:
+    struct Node
+    {
+        Region3f               bounds;
+        // Leaf: first mesh and count. Interior: first child, count == 0.
+        uint32_t               first;
+        uint32_t               count;
+    };
+
+    void                       buildNode(uint32_t nodeId,
+                                         uint32_t first,
+                                         uint32_t count);
+    void                       appendAll(uint32_t nodeId,
+                                         std::vector<Mesh*>& visible) const;
+    void                       cullNode(uint32_t nodeId,
+                                        const Frustum& frustum,
+                                        std::vector<Mesh*>& visible) const;
+    void                       cullNode(uint32_t nodeId,
+                                        const Vector3f& center,
+                                        float radius,
+                                        std::vector<Mesh*>& visible) const;
+
+    std::vector<Node>          _nodes;
+    std::vector<Mesh*>         _meshes;
+    std::vector<Vector3f>      _centroids;
+    std::vector<Region3f>      _meshBounds;
+    float                      _builtArea;
+};
+
+}
+
+#endif
@@ -92,21 +92,25 @@ StreamedMesh::internalStreamPtr()
 
     if (!_vertexBufferCpuMemory)
     {
-        _vertexBufferCpuMemory = (float*)malloc(sizeof(float)*vertexBufferSize());
+        _vertexBufferCpuMemory = malloc(vertexBufferSize());
     }
 
-    // stash the buffer and put it in an array
-    std::map <uint32_t, float*> streamMap;
+    // stash the buffer and put it in an array. Streams with a packed
+    // encoding are interleaved from that, the rest from the float copy.
+    std::map <uint32_t, const uint8_t*> streamMap;
 
     for (auto it = _vertexStreams.begin();
         it != _vertexStreams.end();
         it++)
     {
-        streamMap.insert (std::make_pair(it->first, it->second->stream()));
+        const VertexStream* stream = it->second;
+        const uint8_t* source = stream->packed() ? (const uint8_t*)stream->packed() :
+                                                   (const uint8_t*)stream->stream();
+        streamMap.insert (std::make_pair(it->first, source));
     }
 
     const std::vector <VertexElement>& declaration = _vertexDeclaration->getDeclaration();
-    float* vb = (float*)_vertexBufferCpuMemory;
+    uint8_t* vb = (uint8_t*)_vertexBufferCpuMemory;
 
     for (uint32_t i = 0; i < vertexCount(); i++)
     {    
@@ -122,30 +126,25 @@ StreamedMesh::internalStreamPtr()
                 if (streamIt != streamMap.end() &&
                     streamIt->second)
                 {
-                    for (uint32_t k = 0; k < stream->stride(); k++)
-                    {
-                        *vb++ = streamIt->second[k];
-                    }
-                    streamIt->second += stream->stride();
+                    uint32_t elementSize = stream->elementSizeInBytes();
+                    memcpy(vb, streamIt->second, elementSize);
+                    vb += elementSize;
+                    streamIt->second += elementSize;
                 }
                 else
                 {
-                    uint32_t stride = IVertexDeclaration::elementToSize(element.type());
-                    for (uint32_t k = 0; k < stride; stride++)
-                    {
-                        *vb++ = 0;
-                    }
+                    uint32_t elementSize = IVertexDeclaration::elementToSize(element.type());
+                    memset(vb, 0, elementSize);
+                    vb += elementSize;
                 }
             }
             else
             {
                 // can't find a stream for this element.
                 // warn user, and 0 the buffer for the stride size
-                uint32_t stride = IVertexDeclaration::elementToSize(element.type());
-                for (uint32_t k = 0; k < stride; stride++)
-                {
-                    *vb++ = 0;
-                }
+                uint32_t elementSize = IVertexDeclaration::elementToSize(element.type());
+                memset(vb, 0, elementSize);
+                vb += elementSize;
             }
         }
     }
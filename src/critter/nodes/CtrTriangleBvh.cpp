@@ -0,0 +1,503 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTriangleBvh.h>
+
+namespace Ctr
+{
+namespace
+{
+const uint32_t MaxLeafSize = 4;
+const uint32_t BinCount = 16;
+const uint32_t MaxStackDepth = 64;
+// Traversal keeps at most one pending sibling per level plus the two
+// children just pushed, so a tree this deep always fits the stack.
+// Deeper nodes become (larger) leaves.
+const uint32_t MaxBuildDepth = MaxStackDepth - 2;
+const float RayEpsilon = 1e-5f;
+
+struct Bin
+{
+    Bin() : bounds(emptyBounds()), count(0) {}
+    Region3f                   bounds;
+    uint32_t                   count;
+};
+
+inline Vector3f
+cross(const Vector3f& a, const Vector3f& b)
+{
+    return Vector3f(a.y * b.z - a.z * b.y,
+                    a.z * b.x - a.x * b.z,
+                    a.x * b.y - a.y * b.x);
+}
+
+inline float
+dot(const Vector3f& a, const Vector3f& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Slab reciprocal that keeps axis aligned rays finite.
+inline float
+safeReciprocal(float value)
+{
+    return 1.0f / (std::fabs(value) > 1e-20f ? value : (value < 0.0f ? -1e-20f : 1e-20f));
+}
+
+inline bool
+intersectBounds(const Region3f& bounds, const Vector3f& origin, const Vector3f& inverseDirection,
+                float tMax, float& tNear)
+{
+    float tx0 = (bounds.minExtent.x - origin.x) * inverseDirection.x;
+    float tx1 = (bounds.maxExtent.x - origin.x) * inverseDirection.x;
+    float ty0 = (bounds.minExtent.y - origin.y) * inverseDirection.y;
+    float ty1 = (bounds.maxExtent.y - origin.y) * inverseDirection.y;
+    float tz0 = (bounds.minExtent.z - origin.z) * inverseDirection.z;
+    float tz1 = (bounds.maxExtent.z - origin.z) * inverseDirection.z;
+
+    tNear = maxValue(maxValue(minValue(tx0, tx1), minValue(ty0, ty1)), minValue(tz0, tz1));
+    float tFar = minValue(minValue(maxValue(tx0, tx1), maxValue(ty0, ty1)), maxValue(tz0, tz1));
+    return tNear <= tFar && tFar >= 0.0f && tNear < tMax;
+}
+}
+
+TriangleBvh::TriangleBvh()
+{
+}
+
+TriangleBvh::~TriangleBvh()
+{
+}
+
+void
+TriangleBvh::clear()
+{
+    _nodes.clear();
+    _triangles.clear();
+    _vertices.clear();
+    _edges1.clear();
+    _edges2.clear();
+    _centroids.clear();
+    _triangleBounds.clear();
+}
+
+bool
+TriangleBvh::empty() const
+{
+    return _nodes.empty();
+}
+
+size_t
+TriangleBvh::triangleCount() const
+{
+    return _triangles.size();
+}
+
+const Region3f&
+TriangleBvh::bounds() const
+{
+    static const Region3f noBounds = emptyBounds();
+    return _nodes.empty() ? noBounds : _nodes[0].bounds;
+}
+
+void
+TriangleBvh::build(const std::vector<Vector3f>& positions)
+{
+    clear();
+    uint32_t triangleCount = (uint32_t)(positions.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    _triangles.resize(triangleCount);
+    _centroids.resize(triangleCount);
+    _triangleBounds.resize(triangleCount);
+    for (uint32_t triangleId = 0; triangleId < triangleCount; triangleId++)
+    {
+        const Vector3f* vertices = &positions[triangleId * 3];
+        Region3f bounds = emptyBounds();
+        expandBounds(bounds, vertices[0]);
+        expandBounds(bounds, vertices[1]);
+        expandBounds(bounds, vertices[2]);
+
+        _triangles[triangleId] = triangleId;
+        _triangleBounds[triangleId] = bounds;
+        _centroids[triangleId] = boundsCenter(bounds);
+    }
+
+    _nodes.reserve(triangleCount * 2 / MaxLeafSize + 1);
+    _nodes.push_back(Node());
+    buildNode(0, 0, triangleCount, 0);
+
+    // Store the triangles in leaf order for the intersection tests.
+    _vertices.resize(triangleCount);
+    _edges1.resize(triangleCount);
+    _edges2.resize(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        const Vector3f* vertices = &positions[_triangles[i] * 3];
+        _vertices[i] = vertices[0];
+        _edges1[i] = vertices[1] - vertices[0];
+        _edges2[i] = vertices[2] - vertices[0];
+    }
+
+    _centroids.clear();
+    _triangleBounds.clear();
+}
+
+void
+TriangleBvh::buildNode(uint32_t nodeId, uint32_t first, uint32_t count, uint32_t depth)
+{
+    Region3f bounds = emptyBounds();
+    Region3f centroidBounds = emptyBounds();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        expandBounds(bounds, _triangleBounds[i]);
+        expandBounds(centroidBounds, _centroids[i]);
+    }
+
+    _nodes[nodeId].bounds = bounds;
+    _nodes[nodeId].first = first;
+    _nodes[nodeId].count = count;
+    if (count <= MaxLeafSize || depth >= MaxBuildDepth)
+        return;
+
+    // Split along the axis with the largest centroid extent.
+    Vector3f extent = centroidBounds.maxExtent - centroidBounds.minExtent;
+    uint32_t axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+    if (extent[axis] <= 0.0f)
+        return;
+
+    // Binned SAH.
+    Bin bins[BinCount];
+    float binScale = (float)BinCount / extent[axis];
+    float axisMin = centroidBounds.minExtent[axis];
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        uint32_t binId = minValue((uint32_t)((_centroids[i][axis] - axisMin) * binScale), BinCount - 1);
+        bins[binId].count++;
+        expandBounds(bins[binId].bounds, _triangleBounds[i]);
+    }
+
+    float rightArea[BinCount];
+    uint32_t rightCount[BinCount];
+    Region3f accumulated = emptyBounds();
+    uint32_t accumulatedCount = 0;
+    for (uint32_t i = BinCount - 1; i > 0; i--)
+    {
+        expandBounds(accumulated, bins[i].bounds);
+        accumulatedCount += bins[i].count;
+        rightArea[i] = boundsSurfaceArea(accumulated);
+        rightCount[i] = accumulatedCount;
+    }
+
+    float bestCost = FLT_MAX;
+    uint32_t bestSplit = 0;
+    accumulated = emptyBounds();
+    accumulatedCount = 0;
+    for (uint32_t i = 0; i < BinCount - 1; i++)
+    {
+        expandBounds(accumulated, bins[i].bounds);
+        accumulatedCount += bins[i].count;
+        if (accumulatedCount == 0 || rightCount[i + 1] == 0)
+            continue;
+        float cost = boundsSurfaceArea(accumulated) * accumulatedCount +
+                     rightArea[i + 1] * rightCount[i + 1];
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            bestSplit = i + 1;
+        }
+    }
+
+    // Split only when it beats testing every triangle in the node.
+    float leafCost = boundsSurfaceArea(bounds) * count;
+    if (bestSplit == 0 || bestCost >= leafCost)
+        return;
+
+    uint32_t middle = first;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        uint32_t binId = minValue((uint32_t)((_centroids[i][axis] - axisMin) * binScale), BinCount - 1);
+        if (binId < bestSplit)
+        {
+            std::swap(_triangles[i], _triangles[middle]);
+            std::swap(_triangleBounds[i], _triangleBounds[middle]);
+            std::swap(_centroids[i], _centroids[middle]);
+            middle++;
+        }
+    }
+
+    uint32_t leftChild = (uint32_t)_nodes.size();
+    _nodes.push_back(Node());
+    _nodes.push_back(Node());
+    _nodes[nodeId].first = leftChild;
+    _nodes[nodeId].count = 0;
+
+    buildNode(leftChild, first, middle - first, depth + 1);
+    buildNode(leftChild + 1, middle, first + count - middle, depth + 1);
+}
+
+bool
+TriangleBvh::intersect(const Vector3f& origin,
+                       const Vector3f& direction,
+                       float tMax,
+                       RayHit& hit) const
+{
+    hit = RayHit();
+    hit.t = tMax;
+    if (_nodes.empty())
+        return false;
+
+    Vector3f inverseDirection(safeReciprocal(direction.x),
+                              safeReciprocal(direction.y),
+                              safeReciprocal(direction.z));
+
+    uint32_t stack[MaxStackDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = _nodes[stack[--stackSize]];
+        float tNear;
+        if (!intersectBounds(node.bounds, origin, inverseDirection, hit.t, tNear))
+            continue;
+
+        if (node.count > 0)
+        {
+            // Moller-Trumbore, both faces.
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                Vector3f p = cross(direction, _edges2[i]);
+                float determinant = dot(_edges1[i], p);
+                if (std::fabs(determinant) < 1e-12f)
+                    continue;
+
+                float inverseDeterminant = 1.0f / determinant;
+                Vector3f s = origin - _vertices[i];
+                float u = dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                    continue;
+
+                Vector3f q = cross(s, _edges1[i]);
+                float v = dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                    continue;
+
+                float t = dot(_edges2[i], q) * inverseDeterminant;
+                if (t > RayEpsilon && t < hit.t)
+                {
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.triangle = _triangles[i];
+                }
+            }
+        }
+        else
+        {
+            assert(stackSize + 2 <= MaxStackDepth);
+            // Visit the nearer child first.
+            float tLeft, tRight;
+            bool left = intersectBounds(_nodes[node.first].bounds, origin, inverseDirection, hit.t, tLeft);
+            bool right = intersectBounds(_nodes[node.first + 1].bounds, origin, inverseDirection, hit.t, tRight);
+            if (left && right)
+            {
+                bool leftFirst = tLeft <= tRight;
+                stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+                stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+            }
+            else if (left || right)
+            {
+                stack[stackSize++] = left ? node.first : node.first + 1;
+            }
+        }
+    }
+
+    return hit.valid();
+}
+
+void
+TriangleBvh::intersect4(const Vector3f& origin,
+                        const Vector3f* directions,
+                        float tMax,
+                        RayHit* hits) const
+{
+#if CTR_SSE
+    for (uint32_t lane = 0; lane < 4; lane++)
+    {
+        hits[lane] = RayHit();
+        hits[lane].t = tMax;
+    }
+    if (_nodes.empty())
+        return;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(RayEpsilon);
+    const __m128 minimumDeterminant = _mm_set1_ps(1e-12f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    __m128 dx = _mm_setr_ps(directions[0].x, directions[1].x, directions[2].x, directions[3].x);
+    __m128 dy = _mm_setr_ps(directions[0].y, directions[1].y, directions[2].y, directions[3].y);
+    __m128 dz = _mm_setr_ps(directions[0].z, directions[1].z, directions[2].z, directions[3].z);
+    __m128 idx = _mm_setr_ps(safeReciprocal(directions[0].x), safeReciprocal(directions[1].x),
+                             safeReciprocal(directions[2].x), safeReciprocal(directions[3].x));
+    __m128 idy = _mm_setr_ps(safeReciprocal(directions[0].y), safeReciprocal(directions[1].y),
+                             safeReciprocal(directions[2].y), safeReciprocal(directions[3].y));
+    __m128 idz = _mm_setr_ps(safeReciprocal(directions[0].z), safeReciprocal(directions[1].z),
+                             safeReciprocal(directions[2].z), safeReciprocal(directions[3].z));
+    __m128 ox = _mm_set1_ps(origin.x);
+    __m128 oy = _mm_set1_ps(origin.y);
+    __m128 oz = _mm_set1_ps(origin.z);
+
+    __m128 hitT = _mm_set1_ps(tMax);
+    __m128 hitU = zero;
+    __m128 hitV = zero;
+    __m128i hitTriangle = _mm_set1_epi32(-1);
+
+    uint32_t stack[MaxStackDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const Node& node = _nodes[stack[--stackSize]];
+
+        // Any lane entering the node before its closest hit keeps the packet going.
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.minExtent.x), ox), idx);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.maxExtent.x), ox), idx);
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.minExtent.y), oy), idy);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.maxExtent.y), oy), idy);
+        __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.minExtent.z), oz), idz);
+        __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(node.bounds.maxExtent.z), oz), idz);
+        __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1));
+        __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1));
+        __m128 active = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(tNear, tFar), _mm_cmpge_ps(tFar, zero)),
+                                   _mm_cmplt_ps(tNear, hitT));
+        if (_mm_movemask_ps(active) == 0)
+            continue;
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                // The rays share an origin, so s and q are the same for every lane.
+                const Vector3f& e1 = _edges1[i];
+                const Vector3f& e2 = _edges2[i];
+                Vector3f s = origin - _vertices[i];
+                Vector3f q = cross(s, e1);
+
+                // p = d x e2
+                __m128 px = _mm_sub_ps(_mm_mul_ps(dy, _mm_set1_ps(e2.z)), _mm_mul_ps(dz, _mm_set1_ps(e2.y)));
+                __m128 py = _mm_sub_ps(_mm_mul_ps(dz, _mm_set1_ps(e2.x)), _mm_mul_ps(dx, _mm_set1_ps(e2.z)));
+                __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, _mm_set1_ps(e2.y)), _mm_mul_ps(dy, _mm_set1_ps(e2.x)));
+
+                __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(e1.x)),
+                                                           _mm_mul_ps(py, _mm_set1_ps(e1.y))),
+                                                _mm_mul_ps(pz, _mm_set1_ps(e1.z)));
+                __m128 valid = _mm_cmpge_ps(_mm_and_ps(determinant, absMask), minimumDeterminant);
+                __m128 inverseDeterminant = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(valid, determinant),
+                                                                      _mm_andnot_ps(valid, one)));
+
+                __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(s.x)),
+                                                            _mm_mul_ps(py, _mm_set1_ps(s.y))),
+                                                 _mm_mul_ps(pz, _mm_set1_ps(s.z))),
+                                      inverseDeterminant);
+                __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(q.x)),
+                                                            _mm_mul_ps(dy, _mm_set1_ps(q.y))),
+                                                 _mm_mul_ps(dz, _mm_set1_ps(q.z))),
+                                      inverseDeterminant);
+                __m128 t = _mm_mul_ps(_mm_set1_ps(dot(e2, q)), inverseDeterminant);
+
+                valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+                valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+                valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+                valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, epsilon));
+                valid = _mm_and_ps(valid, _mm_cmplt_ps(t, hitT));
+                if (_mm_movemask_ps(valid) == 0)
+                    continue;
+
+                hitT = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, hitT));
+                hitU = _mm_or_ps(_mm_and_ps(valid, u), _mm_andnot_ps(valid, hitU));
+                hitV = _mm_or_ps(_mm_and_ps(valid, v), _mm_andnot_ps(valid, hitV));
+                __m128i validMask = _mm_castps_si128(valid);
+                hitTriangle = _mm_or_si128(_mm_and_si128(validMask, _mm_set1_epi32((int32_t)_triangles[i])),
+                                           _mm_andnot_si128(validMask, hitTriangle));
+            }
+        }
+        else
+        {
+            assert(stackSize + 2 <= MaxStackDepth);
+            // Order the children along the first ray, the packet is coherent.
+            const Node& left = _nodes[node.first];
+            const Node& right = _nodes[node.first + 1];
+            float leftDistance = dot(boundsCenter(left.bounds) - origin, directions[0]);
+            float rightDistance = dot(boundsCenter(right.bounds) - origin, directions[0]);
+            bool leftFirst = leftDistance <= rightDistance;
+            stack[stackSize++] = leftFirst ? node.first + 1 : node.first;
+            stack[stackSize++] = leftFirst ? node.first : node.first + 1;
+        }
+    }
+
+    float t[4], u[4], v[4];
+    int32_t triangle[4];
+    _mm_storeu_ps(t, hitT);
+    _mm_storeu_ps(u, hitU);
+    _mm_storeu_ps(v, hitV);
+    _mm_storeu_si128((__m128i*)triangle, hitTriangle);
+    for (uint32_t lane = 0; lane < 4; lane++)
+    {
+        hits[lane].t = t[lane];
+        hits[lane].u = u[lane];
+        hits[lane].v = v[lane];
+        hits[lane].triangle = (uint32_t)triangle[lane];
+    }
+#else
+    for (uint32_t lane = 0; lane < 4; lane++)
+    {
+        intersect(origin, directions[lane], tMax, hits[lane]);
+    }
+#endif
+}
+
+}
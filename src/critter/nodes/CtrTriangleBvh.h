@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_TRIANGLE_BVH
+#define INCLUDED_CRT_TRIANGLE_BVH
+
+#include <CtrPlatform.h>
+#include <CtrRegion.h>
+#include <CtrFrustum.h>
+
+namespace Ctr
+{
+struct RayHit
+{
+    RayHit() : t(FLT_MAX), triangle(0xffffffff), u(0.0f), v(0.0f) {}
+    bool                       valid() const { return triangle != 0xffffffff; }
+
+    float                      t;
+    // Index into the positions passed to build, divided by 3.
+    uint32_t                   triangle;
+    // Barycentrics of the second and third vertex.
+    float                      u;
+    float                      v;
+};
+
+//--------------------------------------------------------------------
+//
+// TriangleBvh
+//
+// Bounding volume hierarchy over world space triangles for CPU ray
+// casting. Built with the same binned SAH as SceneBvh, on triangle
+// centroids. Rays are traced singly or as packets of four rays sharing
+// an origin (neighbouring cube texels), which traverse the tree together
+// and test triangles four rays at a time.
+//
+//--------------------------------------------------------------------
+class TriangleBvh
+{
+  public:
+    TriangleBvh();
+    ~TriangleBvh();
+
+    // Three positions per triangle.
+    void                       build(const std::vector<Vector3f>& positions);
+    void                       clear();
+
+    bool                       empty() const;
+    size_t                     triangleCount() const;
+    const Region3f&            bounds() const;
+
+    // Closest hit closer than tMax.
+    bool                       intersect(const Vector3f& origin,
+                                         const Vector3f& direction,
+                                         float tMax,
+                                         RayHit& hit) const;
+
+    // Closest hits of four rays from a shared origin.
+    void                       intersect4(const Vector3f& origin,
+                                          const Vector3f* directions,
+                                          float tMax,
+                                          RayHit* hits) const;
+
+  private:
+    struct Node
+    {
+        Region3f               bounds;
+        // Leaf: first triangle and count. Interior: first child, count == 0.
+        uint32_t               first;
+        uint32_t               count;
+    };
+
+    void                       buildNode(uint32_t nodeId,
+                                         uint32_t first,
+                                         uint32_t count,
+                                         uint32_t depth);
+
+    std::vector<Node>          _nodes;
+    // Source triangle of each leaf slot.
+    std::vector<uint32_t>      _triangles;
+    // Leaf order, first vertex and the two edges from it.
+    std::vector<Vector3f>      _vertices;
+    std::vector<Vector3f>      _edges1;
+    std::vector<Vector3f>      _edges2;
+
+    // Build only.
+    std::vector<Vector3f>      _centroids;
+    std::vector<Region3f>      _triangleBounds;
+};
+
+}
+
+#endif
@@ -0,0 +1,618 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrArchive.h>
+#include <CtrDataStream.h>
+#include <CtrLog.h>
+#include <CtrMappedFile.h>
+#include <CtrMath.h>
+#include <zlib.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+enum
+{
+    LocalHeaderSignature = 0x04034b50,
+    CentralHeaderSignature = 0x02014b50,
+    EndOfCentralDirectorySignature = 0x06054b50,
+    Zip64EndOfCentralDirectorySignature = 0x06064b50,
+    Zip64LocatorSignature = 0x07064b50,
+    Zip64ExtraFieldId = 0x0001,
+    EncryptedFlag = 0x0001,
+    LocalHeaderSize = 30,
+    CentralHeaderSize = 46,
+    EndOfCentralDirectorySize = 22,
+    Zip64LocatorSize = 20,
+    Zip64EndOfCentralDirectorySize = 56
+};
+
+// Zip is little endian on disk.
+inline uint16_t
+readU16(const uint8_t* data)
+{
+    return uint16_t(data[0] | (data[1] << 8));
+}
+
+inline uint32_t
+readU32(const uint8_t* data)
+{
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+}
+
+inline uint64_t
+readU64(const uint8_t* data)
+{
+    return uint64_t(readU32(data)) | (uint64_t(readU32(data + 4)) << 32);
+}
+
+// crc32 takes a 32 bit length, checksum very large entries in pieces.
+uint32_t
+entryCrc(const uint8_t* data, size_t size)
+{
+    uLong crc = crc32(0L, Z_NULL, 0);
+    while (size > 0)
+    {
+        size_t chunk = minValue(size, size_t(UINT_MAX));
+        crc = crc32(crc, data, uInt(chunk));
+        data += chunk;
+        size -= chunk;
+    }
+    return uint32_t(crc);
+}
+
+// Inflates a whole raw deflate entry in one pass.
+bool
+inflateEntry(const uint8_t* compressed, size_t compressedSize, uint8_t* output, size_t size)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+
+    size_t consumed = 0;
+    size_t produced = 0;
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+        if (stream.avail_in == 0)
+        {
+            size_t chunk = minValue(compressedSize - consumed, size_t(UINT_MAX));
+            stream.next_in = (Bytef*)(compressed + consumed);
+            stream.avail_in = uInt(chunk);
+            consumed += chunk;
+        }
+
+        // One spare byte, so an entry longer than its recorded size is caught.
+        size_t chunk = minValue(size + 1 - produced, size_t(UINT_MAX));
+        stream.next_out = output + produced;
+        stream.avail_out = uInt(chunk);
+        result = inflate(&stream, Z_NO_FLUSH);
+        produced += chunk - stream.avail_out;
+
+        if (result == Z_BUF_ERROR && consumed < compressedSize && produced <= size)
+            result = Z_OK;
+    }
+    inflateEnd(&stream);
+    return result == Z_STREAM_END && produced == size;
+}
+
+//------------------------------------------------------------
+// Stored entries are a view into the mapping.
+//------------------------------------------------------------
+class ArchiveMappedStream : public MemoryDataStream
+{
+  public:
+    ArchiveMappedStream(const std::string& name,
+                        const std::shared_ptr<MappedFile>& file,
+                        const uint8_t* data,
+                        size_t size) :
+        MemoryDataStream(name, (void*)data, size, false, true),
+        _file(file)
+    {
+    }
+
+  private:
+    std::shared_ptr<MappedFile> _file;
+};
+
+//------------------------------------------------------------
+// Deflated entries are inflated as they are read, so a reader
+// that decodes incrementally never holds the whole entry.
+//------------------------------------------------------------
+class ArchiveInflateStream : public DataStream
+{
+  public:
+    ArchiveInflateStream(const std::string& name,
+                         const std::shared_ptr<MappedFile>& file,
+                         const uint8_t* compressed,
+                         size_t compressedSize,
+                         size_t size) :
+        DataStream(name, READ),
+        _file(file),
+        _compressed(compressed),
+        _compressedSize(compressedSize),
+        _compressedPosition(0),
+        _position(0),
+        _open(false),
+        _ok(true)
+    {
+        mSize = size;
+        reset();
+    }
+
+    virtual ~ArchiveInflateStream()
+    {
+        close();
+    }
+
+    virtual bool               ok() const
+    {
+        return _ok;
+    }
+
+    size_t                     read(void* buffer, size_t count)
+    {
+        count = minValue(count, mSize - _position);
+        if (!_open || count == 0)
+            return 0;
+
+        uint8_t* output = (uint8_t*)buffer;
+        size_t produced = 0;
+        while (produced < count)
+        {
+            if (_stream.avail_in == 0)
+                refill();
+
+            size_t chunk = minValue(count - produced, size_t(UINT_MAX));
+            _stream.next_out = output + produced;
+            _stream.avail_out = uInt(chunk);
+            int result = inflate(&_stream, Z_NO_FLUSH);
+            produced += chunk - _stream.avail_out;
+
+            if (result == Z_STREAM_END)
+                break;
+            if (result != Z_OK && result != Z_BUF_ERROR)
+            {
+                LOG("Failed to inflate " << mName);
+                _ok = false;
+                break;
+            }
+            if (result == Z_BUF_ERROR && _compressedPosition >= _compressedSize)
+            {
+                // Truncated entry.
+                _ok = false;
+                break;
+            }
+        }
+        _position += produced;
+        return produced;
+    }
+
+    void                       skip(long count)
+    {
+        seek(size_t(int64_t(_position) + count));
+    }
+
+    void                       seek(size_t position)
+    {
+        position = minValue(position, mSize);
+        if (position < _position)
+        {
+            // Deflate cannot run backwards, start again.
+            reset();
+        }
+
+        uint8_t discard[4096];
+        while (_position < position && _ok)
+        {
+            if (read(discard, minValue(position - _position, sizeof(discard))) == 0)
+                break;
+        }
+    }
+
+    size_t                     tell(void) const
+    {
+        return _position;
+    }
+
+    bool                       eof(void) const
+    {
+        return _position >= mSize;
+    }
+
+    void                       close(void)
+    {
+        if (_open)
+        {
+            inflateEnd(&_stream);
+            _open = false;
+        }
+    }
+
+  private:
+    void                       reset()
+    {
+        close();
+        memset(&_stream, 0, sizeof(_stream));
+        _compressedPosition = 0;
+        _position = 0;
+        // Negative window bits, zip entries are raw deflate without a zlib header.
+        _open = inflateInit2(&_stream, -MAX_WBITS) == Z_OK;
+        _ok = _open;
+    }
+
+    void                       refill()
+    {
+        // avail_in is 32 bit, feed very large entries in pieces.
+        size_t chunk = minValue(_compressedSize - _compressedPosition, size_t(UINT_MAX));
+        _stream.next_in = (Bytef*)(_compressed + _compressedPosition);
+        _stream.avail_in = uInt(chunk);
+        _compressedPosition += chunk;
+    }
+
+    std::shared_ptr<MappedFile> _file;
+    const uint8_t*             _compressed;
+    size_t                     _compressedSize;
+    size_t                     _compressedPosition;
+    size_t                     _position;
+    z_stream                   _stream;
+    bool                       _open;
+    bool                       _ok;
+};
+}
+
+Archive::Archive()
+{
+}
+
+Archive::~Archive()
+{
+    close();
+}
+
+bool
+Archive::open(const std::string& archivePathName)
+{
+    close();
+
+    _pathName = archivePathName;
+    _file.reset(new MappedFile());
+    if (!_file->open(archivePathName))
+    {
+        LOG("Failed to map archive " << archivePathName);
+        close();
+        return false;
+    }
+
+    if (!readCentralDirectory())
+    {
+        LOG("Failed to read the central directory of " << archivePathName);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void
+Archive::close()
+{
+    // Open streams hold their own reference to the mapping.
+    _file.reset();
+    _entries.clear();
+}
+
+const std::string&
+Archive::pathName() const
+{
+    return _pathName;
+}
+
+size_t
+Archive::entryCount() const
+{
+    return _entries.size();
+}
+
+std::string
+Archive::entryKey(const std::string& entryName)
+{
+    std::string key(entryName);
+    for (size_t i = 0; i < key.length(); i++)
+    {
+        key[i] = key[i] == '\\' ? '/' : (char)tolower(key[i]);
+    }
+    return key;
+}
+
+bool
+Archive::readCentralDirectory()
+{
+    const uint8_t* data = _file->data();
+    size_t size = _file->size();
+    if (size < EndOfCentralDirectorySize)
+        return false;
+
+    // The end record is followed by a comment of up to 64k.
+    size_t searchEnd = size > EndOfCentralDirectorySize + 0xffff ? size - EndOfCentralDirectorySize - 0xffff : 0;
+    size_t endOffset = size - EndOfCentralDirectorySize;
+    while (readU32(data + endOffset) != EndOfCentralDirectorySignature)
+    {
+        if (endOffset == searchEnd)
+            return false;
+        endOffset--;
+    }
+
+    const uint8_t* end = data + endOffset;
+    uint64_t entryCount = readU16(end + 10);
+    uint64_t directoryOffset = readU32(end + 16);
+
+    if ((entryCount == 0xffff || directoryOffset == 0xffffffff) && endOffset >= Zip64LocatorSize)
+    {
+        const uint8_t* locator = end - Zip64LocatorSize;
+        if (readU32(locator) == Zip64LocatorSignature)
+        {
+            uint64_t zip64EndOffset = readU64(locator + 8);
+            if (zip64EndOffset + Zip64EndOfCentralDirectorySize > size ||
+                readU32(data + zip64EndOffset) != Zip64EndOfCentralDirectorySignature)
+                return false;
+            entryCount = readU64(data + zip64EndOffset + 32);
+            directoryOffset = readU64(data + zip64EndOffset + 48);
+        }
+    }
+
+    _entries.reserve(size_t(entryCount));
+    uint64_t offset = directoryOffset;
+    for (uint64_t entryId = 0; entryId < entryCount; entryId++)
+    {
+        if (offset + CentralHeaderSize > size || readU32(data + offset) != CentralHeaderSignature)
+            return false;
+
+        const uint8_t* header = data + offset;
+        uint16_t nameLength = readU16(header + 28);
+        uint16_t extraLength = readU16(header + 30);
+        uint16_t commentLength = readU16(header + 32);
+        if (offset + CentralHeaderSize + nameLength + extraLength > size)
+            return false;
+
+        ArchiveEntry entry;
+        entry.flags = readU16(header + 8);
+        entry.method = readU16(header + 10);
+        entry.crc = readU32(header + 16);
+        entry.compressedSize = readU32(header + 20);
+        entry.size = readU32(header + 24);
+        entry.localHeaderOffset = readU32(header + 42);
+        entry.name.assign((const char*)header + CentralHeaderSize, nameLength);
+
+        // Saturated fields live in the zip64 extra field, in this order.
+        const uint8_t* extra = header + CentralHeaderSize + nameLength;
+        const uint8_t* extraEnd = extra + extraLength;
+        while (extra + 4 <= extraEnd)
+        {
+            uint16_t fieldId = readU16(extra);
+            uint16_t fieldSize = readU16(extra + 2);
+            const uint8_t* field = extra + 4;
+            if (fieldId == Zip64ExtraFieldId)
+            {
+                const uint8_t* fieldEnd = field + fieldSize;
+                if (entry.size == 0xffffffff && field + 8 <= fieldEnd)
+                {
+                    entry.size = readU64(field);
+                    field += 8;
+                }
+                if (entry.compressedSize == 0xffffffff && field + 8 <= fieldEnd)
+                {
+                    entry.compressedSize = readU64(field);
+                    field += 8;
+                }
+                if (entry.localHeaderOffset == 0xffffffff && field + 8 <= fieldEnd)
+                {
+                    entry.localHeaderOffset = readU64(field);
+                }
+                break;
+            }
+            extra = field + fieldSize;
+        }
+
+        offset += CentralHeaderSize + nameLength + extraLength + commentLength;
+
+        // Skip directories.
+        if (entry.name.length() > 0 && entry.name[entry.name.length() - 1] != '/')
+        {
+            _entries.insert(std::make_pair(entryKey(entry.name), entry));
+        }
+    }
+    return true;
+}
+
+const ArchiveEntry*
+Archive::find(const std::string& entryName) const
+{
+    auto it = _entries.find(entryKey(entryName));
+    return it != _entries.end() ? &it->second : nullptr;
+}
+
+const uint8_t*
+Archive::entryData(const ArchiveEntry& entry) const
+{
+    // The local header repeats the name and has its own extra field,
+    // so the data offset is only known once the header is read.
+    const uint8_t* data = _file->data();
+    size_t size = _file->size();
+    if (entry.localHeaderOffset + LocalHeaderSize > size ||
+        readU32(data + entry.localHeaderOffset) != LocalHeaderSignature)
+        return nullptr;
+
+    const uint8_t* header = data + entry.localHeaderOffset;
+    uint64_t dataOffset = entry.localHeaderOffset + LocalHeaderSize + readU16(header + 26) + readU16(header + 28);
+    if (dataOffset + entry.compressedSize > size)
+        return nullptr;
+
+    return data + dataOffset;
+}
+
+DataStream*
+Archive::openStream(const std::string& entryName) const
+{
+    const ArchiveEntry* entry = find(entryName);
+    if (!entry || !_file)
+        return nullptr;
+
+    if (entry->flags & EncryptedFlag)
+    {
+        LOG("Encrypted archive entries are not supported " << entryName);
+        return nullptr;
+    }
+
+    const uint8_t* data = entryData(*entry);
+    if (!data)
+    {
+        LOG("Corrupt archive entry " << entryName << " in " << _pathName);
+        return nullptr;
+    }
+
+    switch (entry->method)
+    {
+        case ArchiveEntry::Stored:
+            return new ArchiveMappedStream(entryName, _file, data, size_t(entry->size));
+        case ArchiveEntry::Deflated:
+            return new ArchiveInflateStream(entryName, _file, data, size_t(entry->compressedSize), size_t(entry->size));
+        default:
+            LOG("Unsupported compression method " << entry->method << " for " << entryName);
+    }
+    return nullptr;
+}
+
+bool
+Archive::locate(const std::vector<std::string>& entryNames,
+                std::vector<ArchiveBatchEntry>& batch) const
+{
+    batch.assign(entryNames.size(), ArchiveBatchEntry());
+
+    bool found = true;
+    for (size_t entryId = 0; entryId < entryNames.size(); entryId++)
+    {
+        ArchiveBatchEntry& batchEntry = batch[entryId];
+        batchEntry.name = entryNames[entryId];
+        batchEntry.data = nullptr;
+
+        const ArchiveEntry* entry = find(entryNames[entryId]);
+        if (!entry || !_file)
+        {
+            LOG("Could not find " << entryNames[entryId] << " in " << _pathName);
+            found = false;
+            continue;
+        }
+
+        batchEntry.entry = *entry;
+        batchEntry.file = _file;
+        batchEntry.data = entryData(*entry);
+        if (!batchEntry.data)
+        {
+            LOG("Corrupt archive entry " << entryNames[entryId] << " in " << _pathName);
+            found = false;
+        }
+    }
+    return found;
+}
+
+bool
+Archive::decompress(const std::vector<ArchiveBatchEntry>& batch,
+                    std::vector<DataStream*>& streams)
+{
+    streams.assign(batch.size(), nullptr);
+
+    // The mapping is read only, so entries inflate independently.
+    concurrency::parallel_for(size_t(0), batch.size(), [&](size_t entryId)
+    {
+        const ArchiveBatchEntry& batchEntry = batch[entryId];
+        const ArchiveEntry& entry = batchEntry.entry;
+        if (!batchEntry.data)
+            return;
+
+        if (entry.flags & EncryptedFlag)
+        {
+            LOG("Encrypted archive entries are not supported " << batchEntry.name);
+            return;
+        }
+
+        size_t size = size_t(entry.size);
+        switch (entry.method)
+        {
+            case ArchiveEntry::Stored:
+            {
+                if (entryCrc(batchEntry.data, size) != entry.crc)
+                {
+                    LOG("Crc mismatch for " << batchEntry.name);
+                    return;
+                }
+                streams[entryId] = new ArchiveMappedStream(batchEntry.name, batchEntry.file, batchEntry.data, size);
+                return;
+            }
+            case ArchiveEntry::Deflated:
+            {
+                uint8_t* buffer = (uint8_t*)malloc(size + 1);
+                if (!buffer || !inflateEntry(batchEntry.data, size_t(entry.compressedSize), buffer, size))
+                {
+                    LOG("Failed to decompress " << batchEntry.name);
+                    free(buffer);
+                    return;
+                }
+                if (entryCrc(buffer, size) != entry.crc)
+                {
+                    LOG("Crc mismatch for " << batchEntry.name);
+                    free(buffer);
+                    return;
+                }
+                streams[entryId] = new MemoryDataStream(batchEntry.name, buffer, size, true, true);
+                return;
+            }
+            default:
+                LOG("Unsupported compression method " << entry.method << " for " << batchEntry.name);
+        }
+    });
+
+    return std::find(streams.begin(), streams.end(), nullptr) == streams.end();
+}
+
+}
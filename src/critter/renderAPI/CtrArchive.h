@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_ARCHIVE
+#define INCLUDED_CRT_ARCHIVE
+
+#include <CtrPlatform.h>
+#include <unordered_map>
+
+namespace Ctr
+{
+class DataStream;
+class MappedFile;
+
+//------------------------------------------------------------
+// ArchiveEntry
+// One file in the central directory of a zip archive.
+//------------------------------------------------------------
+struct ArchiveEntry
+{
+    enum Method
+    {
+        Stored = 0,
+        Deflated = 8
+    };
+
+    std::string                name;
+    uint64_t                   localHeaderOffset;
+    uint64_t                   compressedSize;
+    uint64_t                   size;
+    uint32_t                   crc;
+    uint16_t                   method;
+    uint16_t                   flags;
+};
+
+//------------------------------------------------------------
+// ArchiveBatchEntry
+// An entry located for a batch decompress. Holds a reference
+// to the mapping, so it can be inflated after the archive lock
+// is released or the archive is closed.
+//------------------------------------------------------------
+struct ArchiveBatchEntry
+{
+    std::string                name;
+    std::shared_ptr<MappedFile> file;
+    const uint8_t*             data;
+    ArchiveEntry               entry;
+};
+
+//------------------------------------------------------------
+// Archive
+//
+// Read only zip archive. The file is memory mapped and the
+// central directory is parsed once into a hash map, so finding
+// an entry is a single lookup. Stored entries are returned as
+// views straight into the mapping, deflated entries as streams
+// that inflate on demand. Streams keep the mapping alive, so
+// they remain valid after the archive is closed.
+//------------------------------------------------------------
+class Archive
+{
+  public:
+    Archive();
+    ~Archive();
+
+    bool                       open(const std::string& archivePathName);
+    void                       close();
+
+    const std::string&         pathName() const;
+    size_t                     entryCount() const;
+
+    // Case insensitive, as zip_name_locate with ZIP_FL_NOCASE.
+    const ArchiveEntry*        find(const std::string& entryName) const;
+
+    // Streaming view of an entry, nullptr if missing or unsupported.
+    DataStream*                openStream(const std::string& entryName) const;
+
+    //--------------------------------------------------------
+    // Locates several entries for decompress. Cheap, so it can
+    // run under a lock. batch[i].data is nullptr if
+    // entryNames[i] could not be found.
+    //--------------------------------------------------------
+    bool                       locate(const std::vector<std::string>& entryNames,
+                                      std::vector<ArchiveBatchEntry>& batch) const;
+
+    //--------------------------------------------------------
+    // Fully decompresses located entries in parallel and checks
+    // each against its central directory crc. streams[i] is
+    // nullptr if batch[i] is missing, corrupt or unsupported.
+    //--------------------------------------------------------
+    static bool                decompress(const std::vector<ArchiveBatchEntry>& batch,
+                                          std::vector<DataStream*>& streams);
+
+  private:
+    bool                       readCentralDirectory();
+    const uint8_t*             entryData(const ArchiveEntry& entry) const;
+
+    static std::string         entryKey(const std::string& entryName);
+
+    std::string                _pathName;
+    std::shared_ptr<MappedFile> _file;
+    std::unordered_map<std::string, ArchiveEntry> _entries;
+};
+}
+
+#endif
@@ -40,12 +40,11 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrAssetManager.h>
+#include <CtrArchive.h>
 #include <CtrDataStream.h>
 #include <CtrLog.h>
 #include <sys/stat.h>
 
-#include <zip.h>
-
 namespace Ctr
 {
 
@@ -55,6 +54,11 @@ AssetManager::AssetManager()
 
 AssetManager::~AssetManager()
 {
+    for (auto it = _archives.begin(); it != _archives.end(); it++)
+    {
+        delete it->second.archive;
+    }
+    _archives.clear();
 }
 
 bool
@@ -113,72 +117,82 @@ bool
 AssetManager::openArchive(const std::string& archivePathName,
                           ArchiveHandle& resultHandle)
 {
-    bool result = false;
-    int error = 0;
-    zip *z = zip_open(archivePathName.c_str(), 0, &error);
-    if (z == nullptr)
+    resultHandle = ArchiveHandle();
+    resultHandle.build(archivePathName);
+
+    std::lock_guard<std::mutex> lock(_archiveLock);
+    auto it = _archives.find(resultHandle);
+    if (it != _archives.end())
     {
-        LOG("Failed to open archive " << archivePathName);
-        result = false;
+        it->second.referenceCount++;
+        return true;
     }
-    else
+
+    Archive* archive = new Archive();
+    if (!archive->open(archivePathName))
     {
-        resultHandle = ArchiveHandle();
-        resultHandle.build(archivePathName);
-        _archives.insert(std::make_pair(resultHandle, z));
-        result = true;
+        LOG("Failed to open archive " << archivePathName);
+        delete archive;
+        return false;
     }
-    return result;
+
+    ArchiveReference reference = { archive, 1 };
+    _archives.insert(std::make_pair(resultHandle, reference));
+    return true;
 }
 
 void
 AssetManager::closeArchive(const ArchiveHandle& archiveHandle)
 {
-    
+    std::lock_guard<std::mutex> lock(_archiveLock);
+    auto it = _archives.find(archiveHandle);
+    if (it != _archives.end() && --it->second.referenceCount == 0)
+    {
+        // Streams already opened keep the mapping alive.
+        delete it->second.archive;
+        _archives.erase(it);
+    }
 }
 
 DataStream* 
 AssetManager::openCompressedStream(const ArchiveHandle& handle,
                                    const std::string& streamPathName)
 {
-    DataStream* dataStream = nullptr;
-    int idx = -1;
+    std::lock_guard<std::mutex> lock(_archiveLock);
     auto it = _archives.find(handle);
-    zip* archive = nullptr;
+    if (it == _archives.end())
+    {
+        return nullptr;
+    }
 
-    if (it != _archives.end())
+    DataStream* dataStream = it->second.archive->openStream(streamPathName);
+    if (!dataStream)
     {
-        zip* archive = it->second;
-        zip_int64_t index = zip_name_locate(archive, streamPathName.c_str(), ZIP_FL_NOCASE);
-        if (index >= 0)
+        LOG("Could not open " << streamPathName << " in " << it->second.archive->pathName());
+    }
+    return dataStream;
+}
+
+bool
+AssetManager::openCompressedStreams(const ArchiveHandle& handle,
+                                    const std::vector<std::string>& streamPathNames,
+                                    std::vector<DataStream*>& streams)
+{
+    // Only the lookup is locked, the located entries hold the
+    // mapping so the inflate runs without blocking other opens.
+    std::vector<ArchiveBatchEntry> batch;
+    {
+        std::lock_guard<std::mutex> lock(_archiveLock);
+        auto it = _archives.find(handle);
+        if (it == _archives.end())
         {
-            zip_file* file = zip_fopen_index(archive, index, 0);
-            if (file)
-            {
-                struct zip_stat st;
-                zip_stat_init(&st);
-                zip_stat_index(archive, index, 0, &st);
-
-
-                // Now we unzip it to a membuffer.
-                uint8_t * buffer = (uint8_t *)malloc(st.size);
-                if (st.size > 0)
-                {
-                    if (zip_fread(file, buffer, st.size))
-                    {
-                        dataStream = new Ctr::MemoryDataStream(streamPathName, buffer, st.size, true);
-                        return dataStream;
-                    }
-                    else
-                    {
-                        free(buffer);
-                    }
-                }
-            }
+            streams.assign(streamPathNames.size(), nullptr);
+            return false;
         }
+        it->second.archive->locate(streamPathNames, batch);
     }
 
-    return dataStream;
+    return Archive::decompress(batch, streams);
 }
 
 DataStream *
@@ -44,12 +44,12 @@
 #include <CtrPlatform.h>
 #include <CtrHash.h>
 #include <pugixml.hpp>
-
-struct zip;
+#include <mutex>
 
 namespace Ctr
 {
 class DataStream;
+class Archive;
 
 typedef Hash ArchiveHandle;
 
@@ -64,15 +64,28 @@ AssetManager
     static bool                          fileExists(const std::string& filename);
     DataStream*                          openStream (const std::string& streamPathName);
 
+    // Archives are reference counted, every successful open
+    // must be matched by a close.
     bool                                 openArchive(const std::string& archivePathName,
                                                      ArchiveHandle& result);
     void                                 closeArchive(const ArchiveHandle& handle);
     DataStream*                          openCompressedStream(const ArchiveHandle& handle,
                                                               const std::string& streamPathName);
+    // Decompresses several entries of one archive in parallel.
+    bool                                 openCompressedStreams(const ArchiveHandle& handle,
+                                                               const std::vector<std::string>& streamPathNames,
+                                                               std::vector<DataStream*>& streams);
     pugi::xml_document*                  openXmlDocument(const std::string& resourcePathName);
 
   protected:
-    std::map<ArchiveHandle, zip*>        _archives;
+    struct ArchiveReference
+    {
+        Archive*                         archive;
+        uint32_t                         referenceCount;
+    };
+
+    std::map<ArchiveHandle, ArchiveReference> _archives;
+    std::mutex                           _archiveLock;
 };
 }
 
@@ -59,6 +59,7 @@
 #include <CtrRenderTargetQuad.h>
 #include <CtrViewport.h>
 #include <CtrPostEffectsMgr.h>
+#include <CtrProfiler.h>
 
 namespace Ctr
 {
@@ -75,6 +76,7 @@ ColorPass::~ColorPass()
 void
 ColorPass::render (Ctr::Scene* scene)
 {
+    CTR_PROFILE_ZONE("ColorPass::render");
     if (_enabled)
     {
         const Ctr::Camera* camera = scene->camera();
@@ -0,0 +1,625 @@
+//--------------------------------------------------------------------------------------
+//
+// Based on code from AMDCubeMapGen
+// https://code.google.com/p/cubemapgen/
+// under the New BSD License.
+// Copyright(c) 2005, ATI Research, Inc.
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met :
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and / or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,
+// BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+// OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//--------------------------------------------------------------------------------------
+// (C) 2005 ATI Research, Inc., All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#include <CtrCubemapSeamFixup.h>
+#include <CtrBorderedCubemap.h>
+#include <CtrBitwise.h>
+#include <CtrTimer.h>
+#include <CtrLog.h>
+#include <ppl.h>
+#include <random>
+#include <limits>
+
+namespace Ctr
+{
+namespace
+{
+#if CTR_SSE
+typedef __m128 Texel;
+
+inline Texel texelAdd(Texel a, Texel b) { return _mm_add_ps(a, b); }
+inline Texel texelSub(Texel a, Texel b) { return _mm_sub_ps(a, b); }
+inline Texel texelScale(Texel a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+inline Texel texelSet(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline float texelChannel(Texel a, size_t channel) 
+{ 
+    float values[4];
+    _mm_storeu_ps(values, a);
+    return values[channel];
+}
+#else
+struct Texel
+{
+    float v[4];
+};
+
+inline Texel texelSet(float x, float y, float z, float w) { Texel t = {{ x, y, z, w }}; return t; }
+inline Texel texelAdd(Texel a, Texel b) { return texelSet(a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]); }
+inline Texel texelSub(Texel a, Texel b) { return texelSet(a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]); }
+inline Texel texelScale(Texel a, float s) { return texelSet(a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s); }
+inline float texelChannel(Texel a, size_t channel) { return a.v[channel]; }
+#endif
+
+//--------------------------------------------------------------------------------------
+// Texel load / store for each supported layout. Channel order does not matter,
+// every channel is filtered the same way.
+//--------------------------------------------------------------------------------------
+struct UNorm8Texels
+{
+    typedef uint8_t Channel;
+
+    static Texel load(const uint8_t* texel)
+    {
+#if CTR_SSE
+        __m128i zero = _mm_setzero_si128();
+        __m128i bytes = _mm_cvtsi32_si128(*(const int32_t*)texel);
+        __m128i words = _mm_unpacklo_epi8(bytes, zero);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+#else
+        return texelSet(texel[0], texel[1], texel[2], texel[3]);
+#endif
+    }
+
+    static void store(uint8_t* texel, Texel value)
+    {
+#if CTR_SSE
+        __m128i dwords = _mm_cvtps_epi32(value);
+        __m128i words = _mm_packs_epi32(dwords, dwords);
+        *(int32_t*)texel = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+#else
+        for (size_t channel = 0; channel < 4; channel++)
+            texel[channel] = (uint8_t)clamped(value.v[channel] + 0.5f, 0.0f, 255.0f);
+#endif
+    }
+};
+
+struct Half4Texels
+{
+    typedef uint16_t Channel;
+
+    static Texel load(const uint8_t* texel)
+    {
+#if CTR_SSE
+        return Bitwise::halfToFloat4(_mm_loadl_epi64((const __m128i*)texel));
+#else
+        const uint16_t* half = (const uint16_t*)texel;
+        return texelSet(Bitwise::halfToFloat(half[0]), Bitwise::halfToFloat(half[1]),
+                        Bitwise::halfToFloat(half[2]), Bitwise::halfToFloat(half[3]));
+#endif
+    }
+
+    static void store(uint8_t* texel, Texel value)
+    {
+#if CTR_SSE
+        _mm_storel_epi64((__m128i*)texel, Bitwise::floatToHalf4(value));
+#else
+        uint16_t* half = (uint16_t*)texel;
+        for (size_t channel = 0; channel < 4; channel++)
+            half[channel] = Bitwise::floatToHalf(texelChannel(value, channel));
+#endif
+    }
+};
+
+struct Float4Texels
+{
+    typedef float Channel;
+
+    static Texel load(const uint8_t* texel)
+    {
+#if CTR_SSE
+        return _mm_loadu_ps((const float*)texel);
+#else
+        const float* f = (const float*)texel;
+        return texelSet(f[0], f[1], f[2], f[3]);
+#endif
+    }
+
+    static void store(uint8_t* texel, Texel value)
+    {
+#if CTR_SSE
+        _mm_storeu_ps((float*)texel, value);
+#else
+        memcpy(texel, value.v, sizeof(value.v));
+#endif
+    }
+};
+
+// The 12 seams of the cube, in the order fixupCubeEdges processes them.
+// Texels near a cube corner are touched by two seams, keeping the order keeps
+// the result the same as the reference.
+const uint8_t CubeSeams[12][2] =
+{
+    { BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_LEFT },
+    { BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_RIGHT },
+    { BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_TOP },
+    { BorderedCubemap::FACE_X_POS, BorderedCubemap::EDGE_BOTTOM },
+    { BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_LEFT },
+    { BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_RIGHT },
+    { BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_TOP },
+    { BorderedCubemap::FACE_X_NEG, BorderedCubemap::EDGE_BOTTOM },
+    { BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_TOP },
+    { BorderedCubemap::FACE_Z_POS, BorderedCubemap::EDGE_BOTTOM },
+    { BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_TOP },
+    { BorderedCubemap::FACE_Z_NEG, BorderedCubemap::EDGE_BOTTOM }
+};
+
+struct SeamSide
+{
+    size_t seam;
+    size_t side;
+    size_t edge;
+};
+
+struct CubeTopology
+{
+    // Seams touching each face, in seam order.
+    SeamSide faceSeams[6][4];
+    // Neighbour edge of each seam and whether it runs the other way.
+    size_t   neighborFace[12];
+    size_t   neighborEdge[12];
+    bool     flipped[12];
+    // Cube corner (0..7) of each face corner (top left, top right, bottom left, bottom right).
+    size_t   faceCorner[6][4];
+
+    CubeTopology()
+    {
+        size_t faceSeamCount[6] = { 0, 0, 0, 0, 0, 0 };
+        for (size_t seam = 0; seam < 12; seam++)
+        {
+            size_t face = CubeSeams[seam][0];
+            size_t edge = CubeSeams[seam][1];
+            flipped[seam] = BorderedCubemap::edgeNeighbor(face, edge, neighborFace[seam], neighborEdge[seam]);
+
+            SeamSide faceSide = { seam, 0, edge };
+            SeamSide neighborSide = { seam, 1, neighborEdge[seam] };
+            faceSeams[face][faceSeamCount[face]++] = faceSide;
+            faceSeams[neighborFace[seam]][faceSeamCount[neighborFace[seam]]++] = neighborSide;
+        }
+
+        for (size_t face = 0; face < 6; face++)
+        {
+            for (size_t corner = 0; corner < 4; corner++)
+            {
+                float u = (corner & 1) ? 1.0f : -1.0f;
+                float v = (corner & 2) ? 1.0f : -1.0f;
+                Vector3f direction;
+                switch (face)
+                {
+                    case BorderedCubemap::FACE_X_POS: direction = Vector3f( 1, -v, -u); break;
+                    case BorderedCubemap::FACE_X_NEG: direction = Vector3f(-1, -v,  u); break;
+                    case BorderedCubemap::FACE_Y_POS: direction = Vector3f( u,  1,  v); break;
+                    case BorderedCubemap::FACE_Y_NEG: direction = Vector3f( u, -1, -v); break;
+                    case BorderedCubemap::FACE_Z_POS: direction = Vector3f( u, -v,  1); break;
+                    default:                          direction = Vector3f(-u, -v, -1); break;
+                }
+                faceCorner[face][corner] = (direction.x > 0 ? 4 : 0) | 
+                                           (direction.y > 0 ? 2 : 0) | 
+                                           (direction.z > 0 ? 1 : 0);
+            }
+        }
+    }
+};
+
+const CubeTopology& 
+cubeTopology()
+{
+    static CubeTopology topology;
+    return topology;
+}
+
+struct EdgeWalk
+{
+    uint8_t*  start;
+    ptrdiff_t walk;
+    ptrdiff_t perp;
+};
+
+//--------------------------------------------------------------------------------------
+// Byte steps along an edge (left to right, top to bottom) and into the face.
+//--------------------------------------------------------------------------------------
+EdgeWalk
+edgeWalk(const PixelBox& face, size_t edge, ptrdiff_t texelSize)
+{
+    const ptrdiff_t size = ptrdiff_t(face.size().x);
+    const ptrdiff_t rowBytes = face.rowPitch * texelSize;
+
+    EdgeWalk result;
+    result.start = face.rowData(0);
+    switch (edge)
+    {
+        case BorderedCubemap::EDGE_LEFT:
+            result.walk = rowBytes;
+            result.perp = texelSize;
+            break;
+        case BorderedCubemap::EDGE_RIGHT:
+            result.start += (size - 1) * texelSize;
+            result.walk = rowBytes;
+            result.perp = -texelSize;
+            break;
+        case BorderedCubemap::EDGE_TOP:
+            result.walk = texelSize;
+            result.perp = rowBytes;
+            break;
+        default:
+            result.start += (size - 1) * rowBytes;
+            result.walk = texelSize;
+            result.perp = -rowBytes;
+            break;
+    }
+    return result;
+}
+
+template <typename Format>
+void
+fixupMip(const TextureImagePtr& cubemap, size_t mipmap, CubemapFixupType fixupType, float fixupWidth)
+{
+    const CubeTopology& topology = cubeTopology();
+    const ptrdiff_t texelSize = ptrdiff_t(4 * sizeof(typename Format::Channel));
+
+    PixelBox faces[6];
+    for (size_t face = 0; face < 6; face++)
+        faces[face] = cubemap->getPixelBox(face, mipmap);
+    const ptrdiff_t size = ptrdiff_t(faces[0].size().x);
+
+    if (size == 1)
+    {
+        Texel sum = Format::load(faces[0].rowData(0));
+        for (size_t face = 1; face < 6; face++)
+            sum = texelAdd(sum, Format::load(faces[face].rowData(0)));
+        sum = texelScale(sum, 1.0f / 6.0f);
+        for (size_t face = 0; face < 6; face++)
+            Format::store(faces[face].rowData(0), sum);
+        return;
+    }
+
+    // Each cube corner is shared by 3 face corners.
+    uint8_t* cornerTexels[8][3];
+    size_t   cornerCount[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (size_t face = 0; face < 6; face++)
+    {
+        for (size_t corner = 0; corner < 4; corner++)
+        {
+            uint8_t* texel = faces[face].rowData((corner & 2) ? size - 1 : 0) + 
+                             ((corner & 1) ? (size - 1) * texelSize : 0);
+            size_t cubeCorner = topology.faceCorner[face][corner];
+            cornerTexels[cubeCorner][cornerCount[cubeCorner]++] = texel;
+        }
+    }
+    for (size_t corner = 0; corner < 8; corner++)
+    {
+        Texel sum = texelAdd(texelAdd(Format::load(cornerTexels[corner][0]), 
+                                      Format::load(cornerTexels[corner][1])), 
+                             Format::load(cornerTexels[corner][2]));
+        sum = texelScale(sum, 1.0f / 3.0f);
+        for (size_t i = 0; i < 3; i++)
+            Format::store(cornerTexels[corner][i], sum);
+    }
+
+    // Average the seams. Edge texels are only written by their own seam, so the
+    // seams are independent. The average and the change on each side are kept
+    // (indexed by position along that side's edge) for the blend into the faces.
+    std::vector<Texel> average(12 * 2 * size);
+    std::vector<Texel> deviation(12 * 2 * size);
+    concurrency::parallel_for(size_t(0), size_t(12), [&](size_t seam)
+    {
+        size_t face = CubeSeams[seam][0];
+        EdgeWalk a = edgeWalk(faces[face], CubeSeams[seam][1], texelSize);
+        EdgeWalk b = edgeWalk(faces[topology.neighborFace[seam]], topology.neighborEdge[seam], texelSize);
+        bool flipped = topology.flipped[seam];
+
+        Texel* averageA = &average[(seam * 2) * size];
+        Texel* averageB = &average[(seam * 2 + 1) * size];
+        Texel* deviationA = &deviation[(seam * 2) * size];
+        Texel* deviationB = &deviation[(seam * 2 + 1) * size];
+
+        for (ptrdiff_t j = 1; j < size - 1; j++)
+        {
+            ptrdiff_t k = flipped ? size - 1 - j : j;
+            uint8_t* texelA = a.start + j * a.walk;
+            uint8_t* texelB = b.start + k * b.walk;
+            Texel tapA = Format::load(texelA);
+            Texel tapB = Format::load(texelB);
+            Texel mean = texelScale(texelAdd(tapA, tapB), 0.5f);
+            Format::store(texelA, mean);
+            Format::store(texelB, mean);
+
+            averageA[j] = mean;
+            averageB[k] = mean;
+            deviationA[j] = texelSub(tapA, mean);
+            deviationB[k] = texelSub(tapB, mean);
+        }
+    });
+
+    // Maximum width of the fixup region is one half of the face.
+    const ptrdiff_t fixupDist = (ptrdiff_t)Ctr::minValue(fixupWidth, (float)size / 2.0f);
+    if (fixupDist <= 1)
+        return;
+
+    std::vector<float> weights(fixupDist, 0.0f);
+    for (ptrdiff_t i = 1; i < fixupDist; i++)
+    {
+        float fraction = float(fixupDist - i) / float(fixupDist);
+        if (fixupType == CP_FIXUP_AVERAGE_HERMITE || fixupType == CP_FIXUP_PULL_HERMITE)
+            weights[i] = (-2.0f * fraction + 3.0f) * fraction * fraction;
+        else
+            weights[i] = fraction;
+    }
+    const bool pull = fixupType == CP_FIXUP_PULL_HERMITE || fixupType == CP_FIXUP_PULL_LINEAR;
+
+    // Blend the change into the faces. A face only reads and writes its own
+    // texels, so faces run in parallel, each applying its seams in seam order.
+    concurrency::parallel_for(size_t(0), size_t(6), [&](size_t face)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            const SeamSide& side = topology.faceSeams[face][i];
+            const Texel* sideAverage = &average[(side.seam * 2 + side.side) * size];
+            const Texel* sideDeviation = &deviation[(side.seam * 2 + side.side) * size];
+            EdgeWalk walk = edgeWalk(faces[face], side.edge, texelSize);
+
+            auto blend = [&](uint8_t* texel, ptrdiff_t j, float weight)
+            {
+                Texel tap = Format::load(texel);
+                Texel change = pull ? sideDeviation[j] : texelSub(tap, sideAverage[j]);
+                Format::store(texel, texelSub(tap, texelScale(change, weight)));
+            };
+
+            // Walk whichever direction is contiguous in memory innermost.
+            if (side.edge == BorderedCubemap::EDGE_TOP || side.edge == BorderedCubemap::EDGE_BOTTOM)
+            {
+                for (ptrdiff_t fixup = 1; fixup < fixupDist; fixup++)
+                {
+                    uint8_t* row = walk.start + fixup * walk.perp;
+                    for (ptrdiff_t j = 1; j < size - 1; j++)
+                        blend(row + j * walk.walk, j, weights[fixup]);
+                }
+            }
+            else
+            {
+                for (ptrdiff_t j = 1; j < size - 1; j++)
+                {
+                    uint8_t* column = walk.start + j * walk.walk;
+                    for (ptrdiff_t fixup = 1; fixup < fixupDist; fixup++)
+                        blend(column + fixup * walk.perp, j, weights[fixup]);
+                }
+            }
+        }
+    });
+}
+
+template <typename Format>
+void
+fixupMips(const TextureImagePtr& cubemap, size_t firstMip, size_t lastMip, 
+          CubemapFixupType fixupType, float fixupWidth)
+{
+    concurrency::parallel_for(firstMip, lastMip, [&](size_t mipmap)
+    {
+        fixupMip<Format>(cubemap, mipmap, fixupType, fixupWidth);
+    });
+}
+
+void
+fixupMips(const TextureImagePtr& cubemap, size_t firstMip, size_t lastMip, 
+          CubemapFixupType fixupType, float fixupWidth)
+{
+    if (!cubemap || !cubemap->hasFlag(IF_CUBEMAP) || cubemap->getNumFaces() != 6)
+    {
+        throw(std::exception("Image is not a cubemap CubemapSeamFixup::fixup"));
+    }
+    if (!CubemapSeamFixup::supportsFormat(cubemap->getFormat()))
+    {
+        throw(std::exception("Unsupported pixel format CubemapSeamFixup::fixup"));
+    }
+    if (fixupType == CP_FIXUP_NONE || fixupWidth == 0)
+    {
+        return;
+    }
+
+    switch (cubemap->getFormat())
+    {
+        case PF_FLOAT32_RGBA:
+            fixupMips<Float4Texels>(cubemap, firstMip, lastMip, fixupType, fixupWidth);
+            break;
+        case PF_FLOAT16_RGBA:
+            fixupMips<Half4Texels>(cubemap, firstMip, lastMip, fixupType, fixupWidth);
+            break;
+        default:
+            fixupMips<UNorm8Texels>(cubemap, firstMip, lastMip, fixupType, fixupWidth);
+            break;
+    }
+}
+
+template <typename T>
+double
+referenceFixup(const TextureImagePtr& cubemap, float fixupWidth)
+{
+    uint64_t start = Timer::ticks();
+    for (size_t mipmap = 0; mipmap < cubemap->getNumLevels(); mipmap++)
+    {
+        fixupCubeEdges<T>(cubemap, (int32_t)mipmap, CP_FIXUP_AVERAGE_HERMITE, fixupWidth);
+    }
+    return double(Timer::ticks() - start) / double(Timer::ticksPerSecond());
+}
+
+template <typename T>
+double
+maxDifference(const TextureImagePtr& a, const TextureImagePtr& b)
+{
+    const T* dataA = (const T*)a->getData();
+    const T* dataB = (const T*)b->getData();
+    double difference = 0.0;
+    for (size_t i = 0; i < a->getSize() / sizeof(T); i++)
+        difference = Ctr::maxValue(difference, std::fabs(double(dataA[i]) - double(dataB[i])));
+    return difference;
+}
+
+// PF_FLOAT32_RGBA copy of a cubemap, every face and mip.
+TextureImagePtr
+floatCopy(const TextureImagePtr& cubemap)
+{
+    TextureImagePtr copy(new TextureImage());
+    copy->create(Vector2i((int32_t)cubemap->getWidth(), (int32_t)cubemap->getHeight()), PF_FLOAT32_RGBA,
+                 (uint32_t)cubemap->getNumLevels(), IF_CUBEMAP, false);
+    for (size_t face = 0; face < cubemap->getNumFaces(); face++)
+    {
+        for (size_t mipmap = 0; mipmap < cubemap->getNumLevels(); mipmap++)
+        {
+            PixelUtil::bulkPixelConversion(cubemap->getPixelBox(face, mipmap), copy->getPixelBox(face, mipmap));
+        }
+    }
+    return copy;
+}
+}
+
+bool
+CubemapSeamFixup::supportsFormat(PixelFormat format)
+{
+    switch (format)
+    {
+        case PF_A8R8G8B8:
+        case PF_A8B8G8R8:
+        case PF_B8G8R8A8:
+        case PF_R8G8B8A8:
+        case PF_X8R8G8B8:
+        case PF_X8B8G8R8:
+        case PF_FLOAT16_RGBA:
+        case PF_FLOAT32_RGBA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void
+CubemapSeamFixup::fixup(const TextureImagePtr& cubemap, 
+                        CubemapFixupType fixupType, 
+                        float fixupWidth)
+{
+    fixupMips(cubemap, 0, cubemap ? cubemap->getNumLevels() : 0, fixupType, fixupWidth);
+}
+
+void
+CubemapSeamFixup::fixup(const TextureImagePtr& cubemap, 
+                        size_t mipmap,
+                        CubemapFixupType fixupType, 
+                        float fixupWidth)
+{
+    fixupMips(cubemap, mipmap, mipmap + 1, fixupType, fixupWidth);
+}
+
+bool
+CubemapSeamFixup::fixupForExport(const TextureImagePtr& cubemap)
+{
+    if (!cubemap || 
+        !cubemap->hasFlag(IF_CUBEMAP) || 
+        !supportsFormat(cubemap->getFormat()))
+    {
+        return false;
+    }
+
+    // Width is relative to the top mip for every mip.
+    fixup(cubemap, CP_FIXUP_AVERAGE_HERMITE, Ctr::maxValue(cubemap->getWidth() * 0.015f, 1.0f));
+    return true;
+}
+
+double
+CubemapSeamFixup::benchmark(size_t faceSize, PixelFormat format, size_t iterations, double* floatDifference)
+{
+    if (floatDifference)
+        *floatDifference = std::numeric_limits<double>::max();
+    if (!supportsFormat(format) || faceSize == 0 || iterations == 0)
+    {
+        LOG("Cubemap seam fixup benchmark: unsupported parameters");
+        return 0.0;
+    }
+
+    TextureImagePtr source(new TextureImage());
+    source->create(Vector2i((int32_t)faceSize, (int32_t)faceSize), format, 
+                   numberOfMipsInChain((uint32_t)faceSize), IF_CUBEMAP, false);
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> range(0.0f, 4.0f);
+    uint8_t* data = source->getData();
+    switch (format)
+    {
+        case PF_FLOAT32_RGBA:
+            for (size_t i = 0; i < source->getSize() / sizeof(float); i++)
+                ((float*)data)[i] = range(random);
+            break;
+        case PF_FLOAT16_RGBA:
+            for (size_t i = 0; i < source->getSize() / sizeof(uint16_t); i++)
+                ((uint16_t*)data)[i] = Bitwise::floatToHalf(range(random));
+            break;
+        default:
+            for (size_t i = 0; i < source->getSize(); i++)
+                data[i] = (uint8_t)(random() & 0xff);
+            break;
+    }
+
+    // Same width TextureD3D11::save uses.
+    const float fixupWidth = Ctr::maxValue(faceSize * 0.015f, 1.0f);
+
+    TextureImagePtr result(new TextureImage());
+    TextureImagePtr reference(new TextureImage());
+    double time = 0.0;
+    double referenceTime = 0.0;
+    double difference = 0.0;
+    for (size_t iteration = 0; iteration < iterations; iteration++)
+    {
+        *result = *source;
+        uint64_t start = Timer::ticks();
+        fixup(result, CP_FIXUP_AVERAGE_HERMITE, fixupWidth);
+        time += double(Timer::ticks() - start) / double(Timer::ticksPerSecond());
+
+        *reference = *source;
+        switch (format)
+        {
+            case PF_FLOAT32_RGBA:
+                referenceTime += referenceFixup<float>(reference, fixupWidth);
+                difference = maxDifference<float>(result, reference);
+                break;
+            case PF_FLOAT16_RGBA:
+                break;
+            default:
+                referenceTime += referenceFixup<uint8_t>(reference, fixupWidth);
+                difference = maxDifference<uint8_t>(result, reference);
+                break;
+        }
+    }
+
+    // Every format against fixupCubeEdges in float on the same input, so 8 bit
+    // and half results are checked too, to within their precision.
+    TextureImagePtr floatReference = floatCopy(source);
+    referenceFixup<float>(floatReference, fixupWidth);
+    double resultDifference = maxDifference<float>(floatCopy(result), floatReference);
+    if (floatDifference)
+        *floatDifference = resultDifference;
+
+    time /= double(iterations);
+    referenceTime /= double(iterations);
+    LOG("Cubemap seam fixup " << faceSize << "x" << faceSize << " " << PixelUtil::getFormatName(format) << 
+        ": fixupCubeEdges " << referenceTime * 1000.0 << " ms, CubemapSeamFixup " << time * 1000.0 << 
+        " ms, max difference " << difference << ", max difference from float " << resultDifference);
+
+    return time > 0.0 && referenceTime > 0.0 ? referenceTime / time : 0.0;
+}
+}
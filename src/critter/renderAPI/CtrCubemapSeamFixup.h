@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------------------
+//
+// Based on code from AMDCubeMapGen
+// https://code.google.com/p/cubemapgen/
+// under the New BSD License.
+// Copyright(c) 2005, ATI Research, Inc.
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met :
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and / or other materials provided with the distribution.
+// 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,
+// BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY,
+// OR CONSEQUENTIAL DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//--------------------------------------------------------------------------------------
+// (C) 2005 ATI Research, Inc., All rights reserved.
+//--------------------------------------------------------------------------------------
+
+#ifndef INCLUDED_CRT_CUBEMAP_SEAM_FIXUP
+#define INCLUDED_CRT_CUBEMAP_SEAM_FIXUP
+
+#include <CtrFilterCubemap.h>
+
+namespace Ctr
+{
+//--------------------------------------------------------------------------------------
+// Same result as fixupCubeEdges (corners averaged, edges averaged and the change
+// blended fixupWidth texels into each face), restructured so the cost is per edge
+// texel: weights are tabled once per mip, texels are processed as 4 channel SIMD
+// vectors, the 12 seams and the 6 faces of a mip run in parallel, and so do the mips.
+// Handles PF_A8R8G8B8 (and the other 8 bit RGBA orders), PF_FLOAT16_RGBA and
+// PF_FLOAT32_RGBA. Half texels convert 4 channels at a time with SSE2 (scalar
+// without SSE). tests/CtrCubemapSeamFixupBenchmark runs benchmark.
+//--------------------------------------------------------------------------------------
+class CubemapSeamFixup
+{
+  public:
+    static bool                supportsFormat(PixelFormat format);
+
+    // All mips of the cubemap. fixupWidth is clamped to half of each mip.
+    static void                fixup(const TextureImagePtr& cubemap,
+                                     CubemapFixupType fixupType,
+                                     float fixupWidth);
+    static void                fixup(const TextureImagePtr& cubemap,
+                                     size_t mipmap,
+                                     CubemapFixupType fixupType,
+                                     float fixupWidth);
+
+    // The fixup every exported cubemap gets: hermite over 1.5% of the top
+    // mip width. Images that are not cubemaps, or not a supported format,
+    // are left alone. Returns true if the image was fixed up.
+    static bool                fixupForExport(const TextureImagePtr& cubemap);
+
+    // Times fixup against fixupCubeEdges (mip by mip) on a noise cubemap and logs
+    // both times and the largest difference between the results. Half float has no
+    // reference implementation and is only timed. Every format is also compared,
+    // as float, with fixupCubeEdges run on a PF_FLOAT32_RGBA copy of the input;
+    // floatDifference receives the largest difference. Returns the speedup.
+    static double              benchmark(size_t faceSize,
+                                         PixelFormat format = PF_FLOAT32_RGBA,
+                                         size_t iterations = 4,
+                                         double* floatDifference = nullptr);
+};
+}
+
+#endif
@@ -0,0 +1,330 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrEnvironmentDistribution.h>
+#include <CtrBorderedCubemap.h>
+#include <CtrTextureImage.h>
+#include <CtrIDevice.h>
+#include <CtrITexture.h>
+#include <CtrMath.h>
+#include <CtrLog.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+// Matches the luminance weights of rescaleHDR in the importance sampling shaders.
+inline float
+luminance(const Ctr::Vector4f& color)
+{
+    return maxValue(0.0f, color.x * 0.299f + color.y * 0.587f + color.z * 0.114f);
+}
+
+// Index of the first entry whose cdf exceeds xi, cdf is increasing and ends at 1.
+inline uint32_t
+findInterval(const Ctr::Vector2f* entries, uint32_t count, float xi)
+{
+    uint32_t lo = 0;
+    uint32_t hi = count - 1;
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) >> 1;
+        if (entries[mid].y <= xi)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Builds (pdf, cdf) pairs for one row of weights. The pdf is scaled so it
+// integrates to 1 over [0,1]. A row with no energy is uniform.
+inline float
+buildRow(const float* weights, Ctr::Vector2f* entries, uint32_t count)
+{
+    double sum = 0;
+    for (uint32_t i = 0; i < count; i++)
+        sum += weights[i];
+
+    if (sum <= 0)
+    {
+        for (uint32_t i = 0; i < count; i++)
+            entries[i] = Ctr::Vector2f(1.0f, float(i + 1) / float(count));
+        return 0.0f;
+    }
+
+    double running = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        running += weights[i];
+        entries[i] = Ctr::Vector2f(float(weights[i] * count / sum), float(running / sum));
+    }
+    entries[count - 1].y = 1.0f;
+    return float(sum);
+}
+}
+
+EnvironmentDistribution::EnvironmentDistribution(Ctr::IDevice* device,
+                                                 uint32_t width,
+                                                 uint32_t height) :
+    _device(device),
+    _width(maxValue(width, 4u)),
+    _height(maxValue(height, 2u)),
+    _valid(false),
+    _conditionalTexture(nullptr),
+    _marginalTexture(nullptr)
+{
+}
+
+EnvironmentDistribution::~EnvironmentDistribution()
+{
+    safedelete(_conditionalTexture);
+    safedelete(_marginalTexture);
+}
+
+bool
+EnvironmentDistribution::isValid() const
+{
+    return _valid;
+}
+
+void
+EnvironmentDistribution::invalidate()
+{
+    _valid = false;
+}
+
+uint32_t
+EnvironmentDistribution::width() const
+{
+    return _width;
+}
+
+uint32_t
+EnvironmentDistribution::height() const
+{
+    return _height;
+}
+
+const Ctr::ITexture*
+EnvironmentDistribution::conditionalTexture() const
+{
+    return _conditionalTexture;
+}
+
+const Ctr::ITexture*
+EnvironmentDistribution::marginalTexture() const
+{
+    return _marginalTexture;
+}
+
+Ctr::Vector2f
+EnvironmentDistribution::directionToLatLong(const Ctr::Vector3f& direction)
+{
+    float u = std::atan2(direction.z, direction.x) * (0.5f / BB_PI);
+    float v = std::acos(clamped(direction.y, -1.0f, 1.0f)) / BB_PI;
+    return Ctr::Vector2f(u < 0.0f ? u + 1.0f : u, v);
+}
+
+Ctr::Vector3f
+EnvironmentDistribution::latLongToDirection(const Ctr::Vector2f& uv)
+{
+    float phi = uv.x * 2.0f * BB_PI;
+    float theta = uv.y * BB_PI;
+    float sinTheta = std::sin(theta);
+    return Ctr::Vector3f(sinTheta * std::cos(phi), std::cos(theta), sinTheta * std::sin(phi));
+}
+
+bool
+EnvironmentDistribution::update(const Ctr::ITexture* environment)
+{
+    _valid = false;
+    if (!environment || !environment->isCubeMap())
+        return false;
+
+    // Use the first level with at most a quarter of the map width per face,
+    // every bin then covers about one texel.
+    uint32_t mipLevels = (uint32_t)environment->resource()->mipLevels();
+    uint32_t mipId = 0;
+    while (mipId + 1 < mipLevels && (environment->width() >> mipId) > _width / 4)
+        mipId++;
+
+    Ctr::TextureImagePtr image = environment->readImage(environment->format(), (int32_t)mipId);
+    if (!image || image->getNumFaces() != 6)
+    {
+        LOG("Could not read back environment for importance sampling " << environment->width());
+        return false;
+    }
+
+    return build(*image);
+}
+
+bool
+EnvironmentDistribution::build(const Ctr::TextureImage& environment)
+{
+    _valid = false;
+
+    // Copy into a bordered cube so the bilinear lookups filter across the seams.
+    Ctr::TextureImage level;
+    level.create(Ctr::Vector2i(environment.getWidth(), environment.getHeight()),
+                 environment.getFormat(), 1, IF_CUBEMAP, false);
+    for (size_t faceId = 0; faceId < 6; faceId++)
+    {
+        PixelUtil::bulkPixelConversion(environment.getPixelBox(faceId, 0), level.getPixelBox(faceId, 0));
+    }
+    BorderedCubemap cubemap(level);
+
+    // sin(theta) weighted luminance, 2x2 samples per bin.
+    std::vector<float> weights(_width * _height);
+    concurrency::parallel_for(uint32_t(0), _height, [&](uint32_t y)
+    {
+        float sinTheta = std::sin(BB_PI * (y + 0.5f) / float(_height));
+        for (uint32_t x = 0; x < _width; x++)
+        {
+            float sum = 0.0f;
+            for (uint32_t s = 0; s < 4; s++)
+            {
+                Ctr::Vector2f uv((x + 0.25f + 0.5f * (s & 1)) / float(_width),
+                                 (y + 0.25f + 0.5f * (s >> 1)) / float(_height));
+                sum += luminance(cubemap.sample(latLongToDirection(uv)));
+            }
+            weights[y * _width + x] = sum * 0.25f * sinTheta;
+        }
+    });
+
+    _conditional.resize(_width * _height);
+    _marginal.resize(_height);
+
+    std::vector<float> rowWeights(_height);
+    concurrency::parallel_for(uint32_t(0), _height, [&](uint32_t y)
+    {
+        rowWeights[y] = buildRow(&weights[y * _width], &_conditional[y * _width], _width);
+    });
+
+    if (buildRow(&rowWeights[0], &_marginal[0], _height) <= 0.0f)
+    {
+        LOG("Environment has no energy to importance sample");
+        return false;
+    }
+
+    // The conditional tables hold pdf(u | v), the shaders need the joint pdf.
+    for (uint32_t y = 0; y < _height; y++)
+    {
+        for (uint32_t x = 0; x < _width; x++)
+        {
+            _conditional[y * _width + x].x *= _marginal[y].x;
+        }
+    }
+
+    _valid = upload();
+    return _valid;
+}
+
+bool
+EnvironmentDistribution::upload()
+{
+    if (!_device)
+        return true;
+
+    if (!_conditionalTexture)
+    {
+        _conditionalTexture = _device->createTexture(&TextureParameters("EnvironmentConditional",
+                                                                        TextureImagePtr(),
+                                                                        Ctr::TwoD,
+                                                                        Ctr::Procedural,
+                                                                        PF_FLOAT32_GR,
+                                                                        Ctr::Vector3i(_width, _height, 1)));
+        _marginalTexture = _device->createTexture(&TextureParameters("EnvironmentMarginal",
+                                                                     TextureImagePtr(),
+                                                                     Ctr::TwoD,
+                                                                     Ctr::Procedural,
+                                                                     PF_FLOAT32_GR,
+                                                                     Ctr::Vector3i(_height, 1, 1)));
+    }
+
+    if (!_conditionalTexture || !_marginalTexture)
+    {
+        LOG("Failed to create environment distribution textures");
+        return false;
+    }
+
+    return _conditionalTexture->write(Ctr::PixelBox(_width, _height, 1, PF_FLOAT32_GR, &_conditional[0]), 0) &&
+           _marginalTexture->write(Ctr::PixelBox(_height, 1, 1, PF_FLOAT32_GR, &_marginal[0]), 0);
+}
+
+float
+EnvironmentDistribution::pdf(const Ctr::Vector3f& direction) const
+{
+    if (!_valid)
+        return 0.0f;
+
+    Ctr::Vector2f uv = directionToLatLong(direction);
+    uint32_t x = minValue(uint32_t(uv.x * _width), _width - 1);
+    uint32_t y = minValue(uint32_t(uv.y * _height), _height - 1);
+    float sinTheta = std::sqrt(maxValue(0.0f, 1.0f - direction.y * direction.y));
+    return sinTheta > 1e-4f ? _conditional[y * _width + x].x / (2.0f * BB_PI * BB_PI * sinTheta) : 0.0f;
+}
+
+Ctr::Vector3f
+EnvironmentDistribution::sample(const Ctr::Vector2f& xi, float& pdf) const
+{
+    pdf = 0.0f;
+    if (!_valid)
+        return Ctr::Vector3f(0, 1, 0);
+
+    uint32_t y = findInterval(&_marginal[0], _height, xi.y);
+    float rowStart = y > 0 ? _marginal[y - 1].y : 0.0f;
+    float dv = (xi.y - rowStart) / maxValue(_marginal[y].y - rowStart, 1e-8f);
+
+    const Ctr::Vector2f* row = &_conditional[y * _width];
+    uint32_t x = findInterval(row, _width, xi.x);
+    float columnStart = x > 0 ? row[x - 1].y : 0.0f;
+    float du = (xi.x - columnStart) / maxValue(row[x].y - columnStart, 1e-8f);
+
+    Ctr::Vector2f uv((x + clamped(du, 0.0f, 1.0f)) / float(_width),
+                     (y + clamped(dv, 0.0f, 1.0f)) / float(_height));
+    float sinTheta = std::sin(uv.y * BB_PI);
+    pdf = sinTheta > 1e-4f ? row[x].x / (2.0f * BB_PI * BB_PI * sinTheta) : 0.0f;
+    return latLongToDirection(uv);
+}
+
+}
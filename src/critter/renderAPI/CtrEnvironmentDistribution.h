@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_ENVIRONMENT_DISTRIBUTION
+#define INCLUDED_CRT_ENVIRONMENT_DISTRIBUTION
+
+#include <CtrPlatform.h>
+#include <CtrVector2.h>
+#include <CtrVector3.h>
+#include <vector>
+
+namespace Ctr
+{
+class IDevice;
+class ITexture;
+class TextureImage;
+
+// Piecewise constant 2D distribution over a lat-long luminance map of an
+// environment cubemap, used to importance sample the environment when
+// filtering probes.
+//
+// The map is parameterised by u = phi / 2PI (phi = atan2(z, x)) and
+// v = theta / PI (theta = acos(y)). Each texel is weighted by sin(theta) so
+// the distribution is proportional to the energy arriving from it. Two float2
+// tables are uploaded for the importance sampling shaders:
+//   conditional (width x height): joint pdf over [0,1]^2, cdf of u within the row.
+//   marginal    (height x 1)    : pdf of the row, cdf of v.
+// The solid angle pdf of a direction is pdf(u, v) / (2 PI^2 sin(theta)).
+class EnvironmentDistribution
+{
+  public:
+    EnvironmentDistribution(Ctr::IDevice* device,
+                            uint32_t width = 256,
+                            uint32_t height = 128);
+    ~EnvironmentDistribution();
+
+    // Reads back a level of the environment close to the size of the
+    // distribution and rebuilds the tables. Returns false, leaving the
+    // distribution invalid, if the readback fails or the environment is black.
+    bool                       update(const Ctr::ITexture* environment);
+
+    // Builds the tables from the first level of a cubemap image and uploads them.
+    bool                       build(const Ctr::TextureImage& environment);
+
+    bool                       isValid() const;
+    void                       invalidate();
+
+    uint32_t                   width() const;
+    uint32_t                   height() const;
+
+    const Ctr::ITexture*       conditionalTexture() const;
+    const Ctr::ITexture*       marginalTexture() const;
+
+    // CPU versions of the shader sampling, solid angle pdf.
+    float                      pdf(const Ctr::Vector3f& direction) const;
+    Ctr::Vector3f              sample(const Ctr::Vector2f& xi, float& pdf) const;
+
+    static Ctr::Vector2f       directionToLatLong(const Ctr::Vector3f& direction);
+    static Ctr::Vector3f       latLongToDirection(const Ctr::Vector2f& uv);
+
+  private:
+    bool                       upload();
+
+    Ctr::IDevice*              _device;
+    uint32_t                   _width;
+    uint32_t                   _height;
+    bool                       _valid;
+
+    // (pdf, cdf) pairs, laid out as the textures.
+    std::vector<Ctr::Vector2f> _conditional;
+    std::vector<Ctr::Vector2f> _marginal;
+
+    Ctr::ITexture*             _conditionalTexture;
+    Ctr::ITexture*             _marginalTexture;
+};
+
+}
+
+#endif
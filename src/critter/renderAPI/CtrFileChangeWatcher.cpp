@@ -38,11 +38,24 @@
 //    THE SOFTWARE.                                                                   //
 //                                                                                    //
 //------------------------------------------------------------------------------------//
+
 #include <CtrFileChangeWatcher.h>
 #include <CtrLog.h>
 
+#if _WIN32 || _WIN64
+#include <direct.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <thread>
+#include <atomic>
+#endif
+
 namespace Ctr
 {
+#if _WIN32 || _WIN64
+
 #define MAX_BUFFER  4096
 typedef struct DIRECTORY_INFO {   
 HANDLE      hDir;   
@@ -50,28 +63,35 @@ TCHAR       lpszDirName[MAX_BUFFER];
 CHAR        lpBuffer[MAX_BUFFER];   
 DWORD       dwBufLength;   
 OVERLAPPED  Overlapped;   
+FileChangeWatcher* watcher;
 }*PDIRECTORY_INFO, *LPDIRECTORY_INFO;
 
-namespace
+struct FileChangeWatcherBackend
 {
-FileChangeWatcher*  fileChangeWatcher = nullptr;
+    FileChangeWatcherBackend() :
+        processHandle(nullptr),
+        processCompletionHandle(nullptr),
+        dirInfo(nullptr)
+    {
+    }
+
+    HANDLE                     processHandle;
+    HANDLE                     processCompletionHandle;
+    DIRECTORY_INFO*            dirInfo;
+};
 
+namespace
+{
 void WINAPI CheckChangedFile( LPDIRECTORY_INFO lpdi,   
                               PFILE_NOTIFY_INFORMATION lpfni)   
 {   
-    TCHAR      szFullPathName[MAX_PATH];   
-
-    lstrcpy( szFullPathName, lpdi->lpszDirName );   
-    lstrcat( szFullPathName, L"/" );   
+    // FileName is not null terminated.
+    std::wstring wFileName(lpfni->FileName, lpfni->FileNameLength / sizeof(WCHAR));
+    std::string fileName(wFileName.begin(), wFileName.end());
 
-    lstrcat( szFullPathName, lpfni->FileName );
-
-    std::wstring wPathName(szFullPathName);
-    std::string filePathName(wPathName.begin(), wPathName.end());
-
-    if (fileChangeWatcher)
+    if (lpdi->watcher)
     {
-        fileChangeWatcher->addChange(filePathName);
+        lpdi->watcher->addChange(lpdi->watcher->directory() + "/" + fileName);
     }
 }
 
@@ -123,15 +143,80 @@ void WINAPI handleDirectoryChange(ULONG_PTR dwCompletionPort)
 }
 }
 
-FileChangeWatcher::FileChangeWatcher() :
-    _processHandle(nullptr),
-    _processCompletionHandle(nullptr)
+#elif defined(__linux__)
+
+struct FileChangeWatcherBackend
 {
-    if (!fileChangeWatcher)
+    FileChangeWatcherBackend() :
+        notifyHandle(-1),
+        watchHandle(-1),
+        shutdown(false)
     {
-        fileChangeWatcher = this;
+        wakeHandles[0] = -1;
+        wakeHandles[1] = -1;
     }
 
+    int                        notifyHandle;
+    int                        watchHandle;
+    // Written to (or closed) on shutdown to wake the poll.
+    int                        wakeHandles[2];
+    std::atomic<bool>          shutdown;
+    std::thread                thread;
+};
+
+namespace
+{
+void
+handleDirectoryChange(FileChangeWatcher* watcher, FileChangeWatcherBackend* backend)
+{
+    // inotify_event is variable length, keep the buffer aligned for it.
+    alignas(struct inotify_event) char buffer[4096];
+
+    pollfd handles[2];
+    handles[0].fd = backend->notifyHandle;
+    handles[0].events = POLLIN;
+    handles[1].fd = backend->wakeHandles[0];
+    handles[1].events = POLLIN;
+
+    while (!backend->shutdown.load())
+    {
+        if (poll(handles, 2, -1) < 0)
+            continue;
+
+        if (handles[1].revents)
+            return;
+
+        if (handles[0].revents & POLLIN)
+        {
+            ssize_t length = read(backend->notifyHandle, buffer, sizeof(buffer));
+            for (ssize_t offset = 0; offset < length; )
+            {
+                const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+                if (event->len > 0 && !(event->mask & IN_ISDIR))
+                {
+                    watcher->addChange(watcher->directory() + "/" + std::string(event->name));
+                }
+                offset += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
+}
+
+#else
+
+struct FileChangeWatcherBackend
+{
+};
+
+#endif
+
+FileChangeWatcher::FileChangeWatcher(const std::string& directory,
+                                     double debounceSeconds) :
+    _directory(normalizePath(directory)),
+    _backend(nullptr)
+{
+    setDebounce(debounceSeconds);
     initialize();
 }
 
@@ -140,6 +225,42 @@ FileChangeWatcher::~FileChangeWatcher()
     destroy();
 }
 
+const std::string&
+FileChangeWatcher::directory() const
+{
+    return _directory;
+}
+
+void
+FileChangeWatcher::setDebounce(double seconds)
+{
+    _debounce = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+std::string
+FileChangeWatcher::normalizePath(const std::string& path)
+{
+    std::string normalized;
+    normalized.reserve(path.length());
+    for (size_t i = 0; i < path.length(); i++)
+    {
+        char c = path[i] == '\\' ? '/' : path[i];
+        if (c == '/' && normalized.length() > 0 && normalized.back() == '/')
+            continue;
+#if _WIN32 || _WIN64
+        c = (char)tolower(c);
+#endif
+        normalized.push_back(c);
+    }
+
+    while (normalized.compare(0, 2, "./") == 0)
+        normalized.erase(0, 2);
+
+    return normalized;
+}
+
+#if _WIN32 || _WIN64
+
 bool
 FileChangeWatcher::initialize()
 {
@@ -148,10 +269,12 @@ FileChangeWatcher::initialize()
     wchar_t currentPath[4096];
     memset(currentPath, 0, sizeof(wchar_t)* 4096);
     _wgetcwd(currentPath, 4096);
-    std::wstring pathName = currentPath + std::wstring(L"/data/shadersD3D11");
+    std::wstring pathName = currentPath + std::wstring(L"/") + std::wstring(_directory.begin(), _directory.end());
 
-    _dirInfo = new DIRECTORY_INFO ();
-    _dirInfo->hDir = CreateFile(pathName.c_str(),
+    _backend = new FileChangeWatcherBackend();
+    _backend->dirInfo = new DIRECTORY_INFO ();
+    _backend->dirInfo->watcher = this;
+    _backend->dirInfo->hDir = CreateFile(pathName.c_str(),
                                 FILE_LIST_DIRECTORY,   
                                 FILE_SHARE_READ |   
                                 FILE_SHARE_WRITE |   
@@ -162,31 +285,31 @@ FileChangeWatcher::initialize()
                                 FILE_FLAG_OVERLAPPED,   
                                 NULL);   
     
-    if( _dirInfo->hDir == INVALID_HANDLE_VALUE )   
+    if( _backend->dirInfo->hDir == INVALID_HANDLE_VALUE )   
     {   
         LOG( "Unable to open directory for file watching");
+        delete _backend->dirInfo;
+        safedelete(_backend);
         return false;
     }
     
-    memcpy(_dirInfo->lpszDirName, pathName.c_str(), sizeof(wchar_t) * pathName.length());
-    _processCompletionHandle= CreateIoCompletionPort( _dirInfo->hDir,   
-                                                     _processCompletionHandle,   
-                                                     (ULONG_PTR)_dirInfo,   
+    memcpy(_backend->dirInfo->lpszDirName, pathName.c_str(), sizeof(wchar_t) * pathName.length());
+    _backend->processCompletionHandle= CreateIoCompletionPort( _backend->dirInfo->hDir,   
+                                                     _backend->processCompletionHandle,   
+                                                     (ULONG_PTR)_backend->dirInfo,   
                                                      0);   
 
-    ReadDirectoryChangesW(_dirInfo->hDir,   
-                          _dirInfo->lpBuffer,   
+    ReadDirectoryChangesW(_backend->dirInfo->hDir,   
+                          _backend->dirInfo->lpBuffer,   
                           MAX_BUFFER,   
                           TRUE,   
                           FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_ATTRIBUTES,   
-                          &_dirInfo->dwBufLength,&_dirInfo->Overlapped,   
+                          &_backend->dirInfo->dwBufLength,&_backend->dirInfo->Overlapped,   
                           NULL);  
 
-
-
-    _processHandle = CreateThread(NULL, 0,   
+    _backend->processHandle = CreateThread(NULL, 0,   
                                   (LPTHREAD_START_ROUTINE) handleDirectoryChange,   
-                                  _processCompletionHandle,   
+                                  _backend->processCompletionHandle,   
                                   0,   
                                   &tid);
 
@@ -196,33 +319,106 @@ FileChangeWatcher::initialize()
 bool
 FileChangeWatcher::destroy()
 {
-    if(_processHandle!=nullptr)
+    if(_backend && _backend->processHandle!=nullptr)
     {
         // Post completion
-        PostQueuedCompletionStatus( _processCompletionHandle, 0, 0, NULL );   
+        PostQueuedCompletionStatus( _backend->processCompletionHandle, 0, 0, NULL );   
 
         // Wait for thread to stop
-        if(_processHandle!=nullptr)
+        WaitForSingleObject(_backend->processHandle,INFINITE);
+        CloseHandle(_backend->processHandle);
+        CloseHandle(_backend->processCompletionHandle);
+        // Close monitoring handle
+        CloseHandle(_backend->dirInfo->hDir);
+        delete _backend->dirInfo;
+        safedelete(_backend);
+        return true;
+    }
+    return false;
+}
+
+#elif defined(__linux__)
+
+bool
+FileChangeWatcher::initialize()
+{
+    _backend = new FileChangeWatcherBackend();
+    _backend->notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_backend->notifyHandle < 0)
+    {
+        LOG("Unable to initialize inotify for file watching");
+        safedelete(_backend);
+        return false;
+    }
+
+    // Close write covers in place saves, moved to covers editors that save via rename.
+    _backend->watchHandle = inotify_add_watch(_backend->notifyHandle, _directory.c_str(),
+                                              IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB);
+    if (_backend->watchHandle < 0 || pipe(_backend->wakeHandles) != 0)
+    {
+        LOG("Unable to open directory for file watching " << _directory);
+        close(_backend->notifyHandle);
+        safedelete(_backend);
+        return false;
+    }
+
+    _backend->thread = std::thread(handleDirectoryChange, this, _backend);
+    return true;
+}
+
+bool
+FileChangeWatcher::destroy()
+{
+    if (_backend)
+    {
+        // Closing the write end hangs up the pipe, which also wakes the poll.
+        _backend->shutdown.store(true);
+        char wake = 0;
+        if (write(_backend->wakeHandles[1], &wake, 1) != 1)
         {
-            WaitForSingleObject(_processHandle,INFINITE);
-            CloseHandle(_processHandle);
+            close(_backend->wakeHandles[1]);
+            _backend->wakeHandles[1] = -1;
         }
-        CloseHandle(_processCompletionHandle);
-        // Close monitoring handle
-        CloseHandle(_dirInfo->hDir);
-        delete _dirInfo;
+
+        // A joinable thread must never be destroyed.
+        if (_backend->thread.joinable())
+            _backend->thread.join();
+
+        inotify_rm_watch(_backend->notifyHandle, _backend->watchHandle);
+        close(_backend->notifyHandle);
+        close(_backend->wakeHandles[0]);
+        if (_backend->wakeHandles[1] >= 0)
+            close(_backend->wakeHandles[1]);
+        safedelete(_backend);
         return true;
     }
     return false;
 }
 
+#else
+
+bool
+FileChangeWatcher::initialize()
+{
+    LOG("File watching is not supported on this platform");
+    return false;
+}
+
+bool
+FileChangeWatcher::destroy()
+{
+    return false;
+}
+
+#endif
+
 void
 FileChangeWatcher::addChange(const std::string& filename)
 {
     {
         std::lock_guard<std::recursive_mutex> lock(_taskLock);
-        LOG ("Added change " << filename);
-        _changeList.insert (std::string(filename));
+        // Coalesce, a later event for the same file restarts its debounce.
+        _changeList[normalizePath(filename)] = Clock::now();
     }
 }
 
@@ -231,7 +427,13 @@ FileChangeWatcher::hasChanges() const
 {
     {
         std::lock_guard<std::recursive_mutex> lock(_taskLock);
-        return _changeList.size() > 0;
+        Clock::time_point settled = Clock::now() - _debounce;
+        for (auto it = _changeList.begin(); it != _changeList.end(); it++)
+        {
+            if (it->second <= settled)
+                return true;
+        }
+        return false;
     }
 }
 
@@ -240,8 +442,20 @@ FileChangeWatcher::changeList() const
 {
     {
         std::lock_guard<std::recursive_mutex> lock(_taskLock);
-        std::set<std::string> changes = _changeList;
-        _changeList.clear();
+        Clock::time_point settled = Clock::now() - _debounce;
+        std::set<std::string> changes;
+        for (auto it = _changeList.begin(); it != _changeList.end(); )
+        {
+            if (it->second <= settled)
+            {
+                changes.insert(it->first);
+                it = _changeList.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
         return changes;
     }
 }
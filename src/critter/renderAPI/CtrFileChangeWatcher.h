@@ -38,41 +38,68 @@
 //    THE SOFTWARE.                                                                   //
 //                                                                                    //
 //------------------------------------------------------------------------------------//
+
 #ifndef INCLUDED_FILE_CHANGE_WATCHER
 #define INCLUDED_FILE_CHANGE_WATCHER
 
 #include <CtrPlatform.h>
 #include <memory>
 #include <mutex>
+#include <chrono>
 
 namespace Ctr
 {
-struct DIRECTORY_INFO;
+struct FileChangeWatcherBackend;
+
+//------------------------------------------------------------
+// FileChangeWatcher
+//
+// Watches a directory for modified files on a background
+// thread (ReadDirectoryChangesW on Windows, inotify on Linux).
+// Repeated events for the same file are coalesced, and a
+// change is only reported once the file has been quiet for
+// the debounce interval, so editors that save in several
+// writes trigger a single reload.
+//------------------------------------------------------------
 class FileChangeWatcher
 {
   public:
-    FileChangeWatcher();
+    FileChangeWatcher(const std::string& directory = "data/shadersD3D11",
+                      double debounceSeconds = 0.1);
     virtual ~FileChangeWatcher();
 
     bool                          initialize();
+
+    // True if any change has settled past the debounce interval.
     bool                          hasChanges() const;
+
+    // Removes and returns the settled changes. Paths are
+    // normalized relative paths (see normalizePath).
     std::set<std::string>         changeList() const;
 
     void                          addChange(const std::string& filename);
 
-  protected:
-    bool                          destroy();
+    const std::string&            directory() const;
+    void                          setDebounce(double seconds);
+
+    // Forward slashes, no "./", lower case on case insensitive file systems.
+    static std::string            normalizePath(const std::string& path);
 
   protected:
-    HANDLE                        _processHandle;
-    HANDLE                        _processCompletionHandle;
+    bool                          destroy();
 
   private:
-    mutable std::set<std::string>  _changeList;
+    typedef std::chrono::steady_clock            Clock;
+
+    std::string                   _directory;
+    Clock::duration               _debounce;
+
+    // Last event time for each pending file.
+    mutable std::map<std::string, Clock::time_point> _changeList;
 
-    mutable std::recursive_mutex   _taskLock;
-    DIRECTORY_INFO  *              _dirInfo;
+    mutable std::recursive_mutex  _taskLock;
+    FileChangeWatcherBackend*     _backend;
 };
 }
 
-#endif
\ No newline at end of file
+#endif
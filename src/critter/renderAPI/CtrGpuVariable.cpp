@@ -45,6 +45,7 @@ namespace Ctr
 GpuVariable::GpuVariable (Ctr::IDevice* device) : IRenderResource (device)
 {
     _valueIndex = 0;
+    _semanticSymbol = Symbol::Invalid;
 }
 
 GpuVariable::~GpuVariable()
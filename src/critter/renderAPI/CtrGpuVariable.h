@@ -44,6 +44,7 @@
 #include <CtrIRenderResource.h>
 #include <CtrShaderParameterValue.h>
 #include <CtrLog.h>
+#include <CtrSymbol.h>
 
 namespace Ctr
 {
@@ -84,6 +85,11 @@ class GpuVariable : public IRenderResource
 
     uint32_t                      valueIndex() const { return _valueIndex;};
 
+    //-------------------------------------------------------
+    // Upper case interned semantic, Symbol::Invalid if none.
+    //-------------------------------------------------------
+    SymbolId                      semanticSymbol() const { return _semanticSymbol; }
+
     virtual void                  unbind() const = 0;
 
     virtual void                  set (const void*, uint32_t size) const = 0;
@@ -106,6 +112,7 @@ class GpuVariable : public IRenderResource
 
   protected:
     uint32_t                      _valueIndex;
+    SymbolId                      _semanticSymbol;
 };
 
 }
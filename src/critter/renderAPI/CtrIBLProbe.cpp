@@ -40,6 +40,7 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrIBLProbe.h>
+#include <CtrEnvironmentDistribution.h>
 #include <CtrIDevice.h>
 #include <CtrITexture.h>
 #include <CtrISurface.h>
@@ -47,7 +48,6 @@
 #include <CtrPostEffectsMgr.h>
 #include <CtrScene.h>
 #include <CtrMatrixAlgo.h>
-#include <MurmurHash.h>
 #include <Ctrimgui.h>
 
 
@@ -73,9 +73,18 @@ ImguiEnumVal IblSourceResolutionEnum[] =
 
 static const EnumTweakType IblSourceResolutionType(&IblSourceResolutionEnum[0], 6, "SourceResolution");
 
+ImguiEnumVal IblAccumulationEnum[] =
+{
+    { IBLProbe::AccumulatePingPong, "Ping Pong" },
+    { IBLProbe::AccumulateRunningAverage, "Running Average" }
+};
+
+static const EnumTweakType IblAccumulationType(&IblAccumulationEnum[0], 2, "Accumulation");
+
 IBLProbe::IBLProbe(Ctr::IDevice * device) : 
     Ctr::TransformNode(device),
     _environmentCubeMap(nullptr),
+    _environmentDistribution(new EnvironmentDistribution(device)),
     _device (device),
     _center (Vector3f(0,0,0)),
     _sampleOffset(0),
@@ -83,6 +92,7 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
     _cachedTranslation (Ctr::Vector3f (Ctr::Limits<float>::minimum(),Ctr::Limits<float>::minimum(),Ctr::Limits<float>::minimum())),
     _renderId(0),
     _samplesRemaining(1024),
+    _accumulatedSampleWeight(0),
     _sampleCountProperty(new Ctr::IntProperty(this, "Total Samples", new Ctr::TweakFlags(0, 16384, 1, "IBL"))),
     _samplesPerFrameProperty(new Ctr::IntProperty(this, "Samples Per Frame", new Ctr::TweakFlags(0, 16384, 1, "IBL"))),
     _markedComputedProperty(new Ctr::BoolProperty(this, "Computed")),
@@ -93,10 +103,14 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
     _iblSaturationProperty(new Ctr::FloatProperty(this, "IBL Saturation", new Ctr::TweakFlags(0, 2.0f, 1e-3f, "IBL"))),
     _iblContrastProperty(new Ctr::FloatProperty(this, "IBL Contrast", new Ctr::TweakFlags(0, 2.0f, 1e-3f, "IBL"))),
     _iblHueProperty(new Ctr::FloatProperty(this, "IBL Hue", new Ctr::TweakFlags(0, 360.0f, 0.25f, "IBL"))),
+    _environmentSamplingProperty(new Ctr::BoolProperty(this, "Environment Sampling", new Ctr::TweakFlags(0, 1, 1, "IBL"))),
+    _cpuCaptureProperty(new Ctr::BoolProperty(this, "CPU Capture", new Ctr::TweakFlags(0, 1, 1, "IBL"))),
+    _accumulationModeProperty(new Ctr::IntProperty(this, "Accumulation", new TweakFlags(&IblAccumulationType, "IBL"))),
     _maxPixelRProperty(new Ctr::FloatProperty(this, "Max R", new Ctr::TweakFlags(0, 360.0f, 0.25f, "IBL"))),
     _maxPixelGProperty(new Ctr::FloatProperty(this, "Max G", new Ctr::TweakFlags(0, 360.0f, 0.25f, "IBL"))),
     _maxPixelBProperty(new Ctr::FloatProperty(this, "Max B", new Ctr::TweakFlags(0, 360.0f, 0.25f, "IBL"))),
     _deviceProperty(new DeviceProperty(this, "device")),
+    _propertyVersion(~uint64_t(0)),
     _hdrPixelFormatProperty(new PixelFormatProperty(this, "HDRFormat", new TweakFlags(&IblFormatType, "IBL"))),
     _mdrPixelFormatProperty(new PixelFormatProperty(this, "MDRFormat", new TweakFlags(&IblFormatType, "IBL"))),
     _dimensionProperty(new IntProperty(this, "Dimension")),
@@ -113,6 +127,9 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
     _iblHueProperty->set(0.0f);
     _iblContrastProperty->set(0.0f);
     _iblSaturationProperty->set(1.0f);
+    _environmentSamplingProperty->set(true);
+    _cpuCaptureProperty->set(false);
+    _accumulationModeProperty->set(AccumulatePingPong);
 
     _maxPixelRProperty->set(0);
     _maxPixelGProperty->set(0);
@@ -152,6 +169,7 @@ IBLProbe::IBLProbe(Ctr::IDevice * device) :
 
 IBLProbe::~IBLProbe()
 {
+    safedelete(_environmentDistribution);
 }
 
 void
@@ -310,6 +328,27 @@ IBLProbe::markComputed(bool computed)
     _markedComputedProperty->set(computed);
 }
 
+IBLProbe::AccumulationMode
+IBLProbe::accumulationMode() const
+{
+    return (AccumulationMode)_accumulationModeProperty->get();
+}
+
+IntProperty*
+IBLProbe::accumulationModeProperty()
+{
+    return _accumulationModeProperty;
+}
+
+float
+IBLProbe::accumulationBlendWeight() const
+{
+    const float passWeight = float(_samplesPerFrameProperty->get());
+    if (passWeight <= 0)
+        return 1.0f;
+    return passWeight / (_accumulatedSampleWeight + passWeight);
+}
+
 ITexture*
 IBLProbe::diffuseCubeMap() const
 {
@@ -392,9 +431,14 @@ void
 IBLProbe::updateSamples()
 {
     _samplesRemaining -= _samplesPerFrameProperty->get();
+    _accumulatedSampleWeight += float(_samplesPerFrameProperty->get());
     if (_samplesRemaining > 0)
     {
-        _renderId = _renderId == 0 ? 1 : 0;
+        // Running averages refine the chain they were rendered to.
+        if (accumulationMode() == AccumulatePingPong)
+        {
+            _renderId = _renderId == 0 ? 1 : 0;
+        }
         _sampleOffset += 1;
     }
 
@@ -417,6 +461,7 @@ IBLProbe::uncache()
     _markedComputedProperty->set(false);
     _samplesRemaining = _sampleCountProperty->get();
     _sampleOffset = 0;
+    _accumulatedSampleWeight = 0;
     _renderId = 0;
 }
 
@@ -430,27 +475,35 @@ IBLProbe::isCached ()
 void
 IBLProbe::update()
 {
-    std::ostringstream stream;
-    stream << _specularResolutionProperty->get() << 
-              _diffuseResolutionProperty->get() << 
-              _mipDropProperty->get() << 
-              _sampleCountProperty->get() << 
-              _samplesPerFrameProperty->get() <<
-              _iblHueProperty->get() <<
-              _iblContrastProperty->get() <<
-              _iblSaturationProperty->get() <<
-              _hdrPixelFormatProperty->get() <<
-              _sourceResolutionProperty->get() <<
-              _environmentScaleProperty->get();
-
-    // Compute hash using Murmur
-    Hash hash;
-    hash.build(stream.str());
-
-    // Compare the hash
-    if (_probeHash != hash)
+    // Versions only ever grow, so their sum changes exactly when
+    // any of the inputs was invalidated.
+    const Property* inputs[] = 
+    {
+        _specularResolutionProperty,
+        _diffuseResolutionProperty,
+        _mipDropProperty,
+        _sampleCountProperty,
+        _samplesPerFrameProperty,
+        _iblHueProperty,
+        _iblContrastProperty,
+        _iblSaturationProperty,
+        _hdrPixelFormatProperty,
+        _sourceResolutionProperty,
+        _environmentScaleProperty,
+        _environmentSamplingProperty,
+        _cpuCaptureProperty,
+        _accumulationModeProperty
+    };
+
+    uint64_t version = 0;
+    for (size_t inputId = 0; inputId < sizeof(inputs) / sizeof(inputs[0]); inputId++)
+    {
+        version += inputs[inputId]->version();
+    }
+
+    if (_propertyVersion != version)
     {
-        _probeHash = hash;
+        _propertyVersion = version;
 
         // Setup the probe to render again.
         uncache();
@@ -475,6 +528,36 @@ IBLProbe::environmentCubeMap() const
     return _environmentCubeMap->renderTexture();
 }
 
+EnvironmentDistribution*
+IBLProbe::environmentDistribution() const
+{
+    return _environmentDistribution;
+}
+
+bool
+IBLProbe::environmentSampling() const
+{
+    return _environmentSamplingProperty->get();
+}
+
+BoolProperty*
+IBLProbe::environmentSamplingProperty()
+{
+    return _environmentSamplingProperty;
+}
+
+bool
+IBLProbe::cpuCapture() const
+{
+    return _cpuCaptureProperty->get();
+}
+
+BoolProperty*
+IBLProbe::cpuCaptureProperty()
+{
+    return _cpuCaptureProperty;
+}
+
 
 const Ctr::Vector3f&
 IBLProbe::center() const
@@ -55,10 +55,23 @@ namespace Ctr
 class IDepthSurface;
 class IDevice;
 class Scene;
+class EnvironmentDistribution;
 
 class IBLProbe : public Ctr::TransformNode
 {
   public:
+    // How refinement passes are combined into the specular and diffuse maps.
+    enum AccumulationMode
+    {
+        // Two chains per map. Each pass reads the last chain and
+        // writes the lerped result to the other.
+        AccumulatePingPong = 0,
+        // One chain per map. Each pass is blended into it by the
+        // probe's accumulated sample weight, the map always holds
+        // the running average.
+        AccumulateRunningAverage = 1
+    };
+
     IBLProbe(Ctr::IDevice * device);
     virtual ~IBLProbe();
 
@@ -95,9 +108,28 @@ class IBLProbe : public Ctr::TransformNode
     Ctr::ITexture*             diffuseCubeMapMDR() const;
     Ctr::ITexture*             specularCubeMapMDR() const;
 
+    // Ping-pong mode only, the chains read by the next pass.
     Ctr::ITexture*             lastDiffuseCubeMap() const;
     Ctr::ITexture*             lastSpecularCubeMap() const;
 
+    // Luminance distribution of the environment cubemap, rebuilt whenever
+    // the environment is rendered if environment sampling is enabled.
+    Ctr::EnvironmentDistribution* environmentDistribution() const;
+
+    bool                       environmentSampling() const;
+    BoolProperty*              environmentSamplingProperty();
+
+    // Ray trace the environment on the CPU instead of rendering it.
+    bool                       cpuCapture() const;
+    BoolProperty*              cpuCaptureProperty();
+
+    AccumulationMode           accumulationMode() const;
+    IntProperty*               accumulationModeProperty();
+
+    // Blend weight of the next pass in running average mode,
+    // samples per frame over the samples accumulated including it.
+    float                      accumulationBlendWeight() const;
+
     IntProperty *              sampleCountProperty();
     int32_t                    sampleCount() const;
 
@@ -148,6 +180,7 @@ class IBLProbe : public Ctr::TransformNode
     int32_t                    _renderId;
     int32_t                    _samplesRemaining;
     int32_t                    _sampleOffset;
+    float                      _accumulatedSampleWeight;
 
     // Mip drop for roughness.
     // Diffuse is encoded on export into numMips -_mipDrop as an option.
@@ -162,10 +195,13 @@ class IBLProbe : public Ctr::TransformNode
     FloatProperty*             _iblSaturationProperty;
     FloatProperty*             _iblContrastProperty;
     FloatProperty*             _iblHueProperty;
+    BoolProperty*              _environmentSamplingProperty;
+    BoolProperty*              _cpuCaptureProperty;
+    IntProperty*               _accumulationModeProperty;
     DeviceProperty*            _deviceProperty;
 
-    // 16 byte murmer hash.
-    Hash                       _probeHash;
+    // Sum of the input property versions at the last update.
+    uint64_t                   _propertyVersion;
 
     // This will need a policy at some stage.
     Ctr::Vector3f               _cachedRotation;
@@ -182,10 +218,12 @@ class IBLProbe : public Ctr::TransformNode
     IntProperty*               _dimensionProperty;
     IntProperty*               _sourceResolutionProperty;
 
+    // The second chains are only created in ping-pong mode.
     RenderTextureProperty*     _specularCubeMap[2];
     RenderTextureProperty*     _diffuseCubeMap[2];
 
     RenderTextureProperty*     _environmentCubeMap;
+    EnvironmentDistribution*   _environmentDistribution;
 
     RenderTextureProperty*     _environmentCubeMapMDR;
     RenderTextureProperty*     _diffuseCubeMapMDR;
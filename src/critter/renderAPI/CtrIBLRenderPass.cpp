@@ -45,6 +45,8 @@
 #include <CtrEntity.h>
 #include <CtrCamera.h>
 #include <CtrIBLProbe.h>
+#include <CtrEnvironmentDistribution.h>
+#include <CtrProbeCapture.h>
 #include <CtrScene.h>
 #include <CtrMaterial.h>
 #include <CtrMesh.h>
@@ -57,12 +59,119 @@
 #include <CtrShaderMgr.h>
 #include <CtrIEffect.h>
 #include <CtrMatrixAlgo.h>
+#include <CtrProfiler.h>
+#include <CtrSymbol.h>
 
 namespace Ctr
 {
+namespace
+{
+const SymbolId BasicTechniqueSymbol = Symbol::intern("basic");
+const SymbolId ConvolutionSrcSymbol = Symbol::intern("ConvolutionSrc");
+const SymbolId LastResultSymbol = Symbol::intern("LastResult");
+const SymbolId ConvolutionMipSymbol = Symbol::intern("ConvolutionMip");
+const SymbolId ConvolutionRoughnessSymbol = Symbol::intern("ConvolutionRoughness");
+const SymbolId ConvolutionSamplesOffsetSymbol = Symbol::intern("ConvolutionSamplesOffset");
+const SymbolId ConvolutionSampleCountSymbol = Symbol::intern("ConvolutionSampleCount");
+const SymbolId ConvolutionMaxSamplesSymbol = Symbol::intern("ConvolutionMaxSamples");
+const SymbolId ConvolutionBlendWeightSymbol = Symbol::intern("ConvolutionBlendWeight");
+const SymbolId EnvironmentConditionalSymbol = Symbol::intern("EnvironmentConditional");
+const SymbolId EnvironmentMarginalSymbol = Symbol::intern("EnvironmentMarginal");
+const SymbolId EnvironmentSamplingSymbol = Symbol::intern("EnvironmentSampling");
+
+// Relative rms difference of one level of two cubemaps, over all faces.
+float
+levelError(const Ctr::TextureImage& image, const Ctr::TextureImage& reference, size_t mipId)
+{
+    double difference = 0;
+    double magnitude = 0;
+    const size_t width = std::max(image.getWidth() >> mipId, size_t(1));
+    const size_t height = std::max(image.getHeight() >> mipId, size_t(1));
+    const size_t channelCount = width * height * 4;
+    std::vector<float> imageTexels(channelCount);
+    std::vector<float> referenceTexels(channelCount);
+
+    for (size_t faceId = 0; faceId < 6; faceId++)
+    {
+        PixelUtil::bulkPixelConversion(image.getPixelBox(faceId, mipId), 
+                                       Ctr::PixelBox(width, height, 1, Ctr::PF_FLOAT32_RGBA, &imageTexels[0]));
+        PixelUtil::bulkPixelConversion(reference.getPixelBox(faceId, mipId), 
+                                       Ctr::PixelBox(width, height, 1, Ctr::PF_FLOAT32_RGBA, &referenceTexels[0]));
+
+        // Alpha carries the blend weight, only color is compared.
+        for (size_t channelId = 0; channelId < channelCount; channelId++)
+        {
+            if ((channelId & 3) == 3)
+                continue;
+            double delta = double(imageTexels[channelId]) - double(referenceTexels[channelId]);
+            difference += delta * delta;
+            magnitude += double(referenceTexels[channelId]) * double(referenceTexels[channelId]);
+        }
+    }
+    return magnitude > 0 ? float(sqrt(difference / magnitude)) : float(sqrt(difference));
+}
+}
+
+IBLRenderPass::ConvolutionHandles::ConvolutionHandles() :
+    shader(nullptr),
+    layoutSerial(0),
+    valid(false),
+    technique(nullptr),
+    source(nullptr),
+    lastResult(nullptr),
+    mip(nullptr),
+    roughness(nullptr),
+    samplesOffset(nullptr),
+    sampleCount(nullptr),
+    maxSamples(nullptr),
+    blendWeight(nullptr),
+    environmentConditional(nullptr),
+    environmentMarginal(nullptr),
+    environmentSampling(nullptr)
+{
+}
+
+bool
+IBLRenderPass::ConvolutionHandles::resolve(const Ctr::IShader* importanceSamplingShader)
+{
+    // Only look the handles up again if the brdf changed or its shader was rebuilt.
+    if (importanceSamplingShader->layoutSerial() == layoutSerial)
+    {
+        return valid;
+    }
+
+    shader = importanceSamplingShader;
+    layoutSerial = shader->layoutSerial();
+    valid = shader->getTechnique(BasicTechniqueSymbol, technique) &&
+            shader->getParameter(ConvolutionSrcSymbol, source) &&
+            shader->getParameter(LastResultSymbol, lastResult) &&
+            shader->getParameter(ConvolutionMipSymbol, mip) &&
+            shader->getParameter(ConvolutionRoughnessSymbol, roughness) &&
+            shader->getParameter(ConvolutionSamplesOffsetSymbol, samplesOffset) &&
+            shader->getParameter(ConvolutionSampleCountSymbol, sampleCount) &&
+            shader->getParameter(ConvolutionMaxSamplesSymbol, maxSamples) &&
+            shader->getParameter(ConvolutionBlendWeightSymbol, blendWeight);
+
+    if (!valid)
+    {
+        LOG("ERROR: Importance sampling shader " << shader->name() << " is missing convolution parameters.");
+    }
+
+    if (!shader->getParameter(EnvironmentConditionalSymbol, environmentConditional) ||
+        !shader->getParameter(EnvironmentMarginalSymbol, environmentMarginal) ||
+        !shader->getParameter(EnvironmentSamplingSymbol, environmentSampling))
+    {
+        environmentConditional = nullptr;
+        environmentMarginal = nullptr;
+        environmentSampling = nullptr;
+    }
+    return valid;
+}
+
 IBLRenderPass::IBLRenderPass(Ctr::IDevice* device) :
     Ctr::RenderPass (device),
     _convolve (nullptr),
+    _probeCapture (new ProbeCapture()),
     _cached (false),
     _material(nullptr),
     _colorConversionShader(nullptr),
@@ -107,6 +216,7 @@ IBLRenderPass::~IBLRenderPass()
 {
     safedelete(_sphereEntity);
     safedelete(_material);
+    safedelete(_probeCapture);
 }
 
 bool
@@ -151,10 +261,66 @@ IBLRenderPass::loadMesh()
     return true;
 }
 
+void
+IBLRenderPass::bindEnvironmentDistribution(const ConvolutionHandles& handles,
+                                           const Ctr::IBLProbe* probe)
+{
+    if (!handles.environmentSampling)
+        return;
+
+    const Ctr::EnvironmentDistribution* distribution = probe->environmentDistribution();
+    float environmentSampling = 0.0f;
+    if (probe->environmentSampling() && distribution->isValid())
+    {
+        handles.environmentConditional->setTexture(distribution->conditionalTexture());
+        handles.environmentMarginal->setTexture(distribution->marginalTexture());
+        environmentSampling = 1.0f;
+    }
+    handles.environmentSampling->set(&environmentSampling, sizeof(float));
+}
+
+void
+IBLRenderPass::beginAccumulation(const ConvolutionHandles& handles,
+                                 const Ctr::IBLProbe* probe,
+                                 const Ctr::ITexture* lastResult)
+{
+    float blendWeight = 0.0f;
+    if (probe->accumulationMode() == Ctr::IBLProbe::AccumulateRunningAverage)
+    {
+        // dst = src * w + dst * (1 - w), the shader writes w to alpha.
+        // Alpha is kept at one, w * 1 + 1 * (1 - w).
+        blendWeight = probe->accumulationBlendWeight();
+        _deviceInterface->enableAlphaBlending();
+        _deviceInterface->setBlendProperty(Ctr::OpAdd);
+        _deviceInterface->setSrcFunction(Ctr::SourceAlpha);
+        _deviceInterface->setDestFunction(Ctr::InverseSourceAlpha);
+        _deviceInterface->setAlphaBlendProperty(Ctr::OpAdd);
+        _deviceInterface->setAlphaSrcFunction(Ctr::BlendOne);
+        _deviceInterface->setAlphaDestFunction(Ctr::InverseSourceAlpha);
+
+        // Not read, but the target cannot be bound as a source.
+        lastResult = probe->environmentCubeMap();
+    }
+
+    handles.lastResult->setTexture(lastResult);
+    handles.blendWeight->set(&blendWeight, sizeof(float));
+}
+
+void
+IBLRenderPass::endAccumulation(const Ctr::IBLProbe* probe)
+{
+    if (probe->accumulationMode() == Ctr::IBLProbe::AccumulateRunningAverage)
+    {
+        _deviceInterface->disableAlphaBlending();
+        _deviceInterface->setupBlendPipeline(_deviceInterface->blendPipeline());
+    }
+}
+
 void
 IBLRenderPass::refineDiffuse(Ctr::Scene* scene,
                              const Ctr::IBLProbe* probe)
 {
+    CTR_PROFILE_ZONE("IBLRenderPass::refineDiffuse");
     // TODO: Optimize.
 	Ctr::Camera* camera = scene->camera();
 
@@ -186,6 +352,9 @@ IBLRenderPass::refineDiffuse(Ctr::Scene* scene,
 
     const Ctr::Brdf* brdf = scene->activeBrdf();
     const Ctr::IShader* importanceSamplingShaderDiffuse = brdf->diffuseImportanceSamplingShader();
+    if (!_diffuseHandles.resolve(importanceSamplingShaderDiffuse))
+        return;
+
     // Convolve for diffuse.
     {
         float currentMip = 0;
@@ -196,38 +365,27 @@ IBLRenderPass::refineDiffuse(Ctr::Scene* scene,
         Ctr::Viewport mipViewport (0,0, probe->diffuseResolution(), probe->diffuseResolution(), 0, 1);
         _deviceInterface->bindFrameBuffer(framebuffer);
         _deviceInterface->setViewport(&mipViewport);
-        _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
-
-        const Ctr::GpuTechnique* importanceSamplingDiffuseTechnique = nullptr;
-        const Ctr::GpuVariable*  convolutionSrcDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionMipDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionRoughnessDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionSamplesOffsetDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionViewsDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionSampleCountDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionMaxSamplesDiffuseVariable = nullptr;
-        const Ctr::GpuVariable*  convolutionSrcLastResultDiffuseVariable = nullptr;
-
-        importanceSamplingShaderDiffuse->getTechniqueByName(std::string("basic"), importanceSamplingDiffuseTechnique);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionSrc", convolutionSrcDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("LastResult", convolutionSrcLastResultDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionMip", convolutionMipDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionRoughness", convolutionRoughnessDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionSamplesOffset", convolutionSamplesOffsetDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionSampleCount", convolutionSampleCountDiffuseVariable);
-        importanceSamplingShaderDiffuse->getParameterByName("ConvolutionMaxSamples", convolutionMaxSamplesDiffuseVariable);
+        // A running average blends into what is already there.
+        if (probe->accumulationMode() == Ctr::IBLProbe::AccumulatePingPong ||
+            probe->sampleOffset() == 0)
+        {
+            _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
+        }
 
         // Set parameters
-        convolutionSrcDiffuseVariable->setTexture(sourceTexture);
-        convolutionSrcLastResultDiffuseVariable->setTexture(probe->lastDiffuseCubeMap());
+        _diffuseHandles.source->setTexture(sourceTexture);
+        beginAccumulation(_diffuseHandles, probe, 
+                          probe->accumulationMode() == Ctr::IBLProbe::AccumulatePingPong ? probe->lastDiffuseCubeMap() : nullptr);
         
-        convolutionMipDiffuseVariable->set ((const float*)&currentMip, sizeof (float));
-        convolutionRoughnessDiffuseVariable->set((const float*)&roughness, sizeof (float));
-        convolutionSamplesOffsetDiffuseVariable->set((const float*)&samplesOffset, sizeof (float));        
-        convolutionSampleCountDiffuseVariable->set(&samplesPerFrame , sizeof(float));
-        convolutionMaxSamplesDiffuseVariable->set(&sampleCount, sizeof(float));
-
-        importanceSamplingShaderDiffuse->renderMesh (Ctr::RenderRequest(importanceSamplingDiffuseTechnique, scene, camera, _sphereMesh));
+        _diffuseHandles.mip->set ((const float*)&currentMip, sizeof (float));
+        _diffuseHandles.roughness->set((const float*)&roughness, sizeof (float));
+        _diffuseHandles.samplesOffset->set((const float*)&samplesOffset, sizeof (float));        
+        _diffuseHandles.sampleCount->set(&samplesPerFrame , sizeof(float));
+        _diffuseHandles.maxSamples->set(&sampleCount, sizeof(float));
+        bindEnvironmentDistribution(_diffuseHandles, probe);
+
+        importanceSamplingShaderDiffuse->renderMesh (Ctr::RenderRequest(_diffuseHandles.technique, scene, camera, _sphereMesh));
+        endAccumulation(probe);
     }
 }
 
@@ -235,6 +393,7 @@ void
 IBLRenderPass::refineSpecular(Ctr::Scene* scene,
                               const Ctr::IBLProbe* probe)
 {
+    CTR_PROFILE_ZONE("IBLRenderPass::refineSpecular");
 	Ctr::Camera* camera = scene->camera();
 
     float projNear = camera->zNear();
@@ -263,6 +422,8 @@ IBLRenderPass::refineSpecular(Ctr::Scene* scene,
 
     const Ctr::Brdf* brdf = scene->activeBrdf();
     const Ctr::IShader* importanceSamplingShaderSpecular = brdf->specularImportanceSamplingShader();
+    if (!_specularHandles.resolve(importanceSamplingShaderSpecular))
+        return;
 
     // Convolve specular.
     uint32_t mipSize = probe->specularCubeMap()->resource()->width();
@@ -277,46 +438,91 @@ IBLRenderPass::refineSpecular(Ctr::Scene* scene,
         Ctr::Viewport mipViewport (0.0f,0.0f, (float)(mipSize), (float)(mipSize), 0.0f, 1.0f);
         _deviceInterface->bindFrameBuffer(framebuffer);
         _deviceInterface->setViewport(&mipViewport);
-
-
-        const Ctr::GpuTechnique*     importanceSamplingSpecularTechnique = nullptr;
-        const Ctr::GpuVariable*      convolutionSrcSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionMipSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionRoughnessSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionSamplesOffsetSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionSampleCountSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionMaxSamplesSpecularVariable = nullptr;
-        const Ctr::GpuVariable*      convolutionSrcLastResultSpecularVariable = nullptr;
-
-        importanceSamplingShaderSpecular->getTechniqueByName(std::string("basic"), importanceSamplingSpecularTechnique);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionSrc",     convolutionSrcSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("LastResult",         convolutionSrcLastResultSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionMip",     convolutionMipSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionRoughness", convolutionRoughnessSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionSamplesOffset", convolutionSamplesOffsetSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionSampleCount", convolutionSampleCountSpecularVariable);
-        importanceSamplingShaderSpecular->getParameterByName("ConvolutionMaxSamples", convolutionMaxSamplesSpecularVariable);
+        // A running average blends into what is already there, start
+        // from black. Ping pong passes overwrite every texel.
+        if (probe->accumulationMode() == Ctr::IBLProbe::AccumulateRunningAverage &&
+            probe->sampleOffset() == 0)
+        {
+            _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
+        }
 
         // Set parameters
-        convolutionSrcSpecularVariable->setTexture(sourceTexture);
-        convolutionSrcLastResultSpecularVariable->setTexture(probe->lastSpecularCubeMap());
-        convolutionMipSpecularVariable->set ((const float*)&currentMip, sizeof (float));
-        convolutionRoughnessSpecularVariable->set((const float*)&roughness, sizeof (float));
-        convolutionSamplesOffsetSpecularVariable->set((const float*)&samplesOffset, sizeof (float));
-        convolutionSampleCountSpecularVariable->set(&samplesPerFrame , sizeof(float));
-        convolutionMaxSamplesSpecularVariable->set(&sampleCount, sizeof(float));
+        _specularHandles.source->setTexture(sourceTexture);
+        beginAccumulation(_specularHandles, probe, 
+                          probe->accumulationMode() == Ctr::IBLProbe::AccumulatePingPong ? probe->lastSpecularCubeMap() : nullptr);
+        _specularHandles.mip->set ((const float*)&currentMip, sizeof (float));
+        _specularHandles.roughness->set((const float*)&roughness, sizeof (float));
+        _specularHandles.samplesOffset->set((const float*)&samplesOffset, sizeof (float));
+        _specularHandles.sampleCount->set(&samplesPerFrame , sizeof(float));
+        _specularHandles.maxSamples->set(&sampleCount, sizeof(float));
+        bindEnvironmentDistribution(_specularHandles, probe);
 
         // Render the paraboloid out.
-        importanceSamplingShaderSpecular->renderMesh (Ctr::RenderRequest(importanceSamplingSpecularTechnique, scene, camera, _sphereMesh));
+        importanceSamplingShaderSpecular->renderMesh (Ctr::RenderRequest(_specularHandles.technique, scene, camera, _sphereMesh));
+        endAccumulation(probe);
         roughness += roughnessDelta;
 
         mipSize = mipSize >> 1;
     }
 }
 
+bool
+IBLRenderPass::compareAccumulationModes(Ctr::Scene* scene,
+                                        Ctr::IBLProbe* probe,
+                                        float tolerance)
+{
+    CTR_PROFILE_ZONE("IBLRenderPass::compareAccumulationModes");
+    const Ctr::IBLProbe::AccumulationMode modes[2] = 
+    {
+        Ctr::IBLProbe::AccumulatePingPong,
+        Ctr::IBLProbe::AccumulateRunningAverage
+    };
+    const int32_t originalMode = probe->accumulationModeProperty()->get();
+
+    // Converge the probe in each mode and read back the specular chain.
+    Ctr::TextureImagePtr results[2];
+    for (size_t modeId = 0; modeId < 2; modeId++)
+    {
+        probe->accumulationModeProperty()->set(modes[modeId]);
+        probe->uncache();
+        while (!probe->computed())
+        {
+            render(scene);
+        }
+        results[modeId] = probe->specularCubeMap()->readImage(probe->specularCubeMap()->format());
+    }
+
+    probe->accumulationModeProperty()->set(originalMode);
+    probe->uncache();
+
+    if (!results[0] || !results[1] || 
+        results[0]->getNumFaces() != 6 || 
+        results[0]->getNumLevels() != results[1]->getNumLevels())
+    {
+        LOG("Could not read back the specular cubemap to compare accumulation modes");
+        return false;
+    }
+
+    // Levels past the mip drop are not convolved.
+    size_t mipLevels = probe->specularCubeMap()->resource()->mipLevels() - probe->mipDrop();
+    bool matched = true;
+    for (size_t mipId = 0; mipId < mipLevels; mipId++)
+    {
+        float error = levelError(*results[1], *results[0], mipId);
+        LOG("Accumulation modes, specular mip " << mipId << " relative rms difference " << error);
+        if (!(error <= tolerance))
+        {
+            LOG("Running average differs from ping pong beyond " << tolerance << " at mip " << mipId);
+            matched = false;
+        }
+    }
+    return matched;
+}
+
 void
 IBLRenderPass::render (Ctr::Scene* scene)
 {
+    CTR_PROFILE_ZONE("IBLRenderPass::render");
     Ctr::Camera* camera           = scene->camera();
 
     _deviceInterface->enableDepthWrite();
@@ -397,36 +603,70 @@ IBLRenderPass::render (Ctr::Scene* scene)
                 Ctr::Vector2f mipSize = Ctr::Vector2f(float(probe->environmentCubeMap()->resource()->width()), 
                                                     float(probe->environmentCubeMap()->resource()->height()));
 
-                for (size_t mipId = 0; mipId < mipLevels; mipId++)
+                // The cubemap is rendered in a single pass, so cull against
+                // the sphere enclosing all six faces rather than per face frustums.
+                const std::vector<Ctr::Mesh*>& meshes = 
+                    scene->visibleMeshesForPass(_passName, probe->center(), projFar);
+
+                // Trace the top level on the CPU and filter the mips from it,
+                // falling back to rendering if the texture cannot be written.
+                bool captured = false;
+                if (probe->cpuCapture())
                 {
-                    Ctr::Viewport mipViewport (0.0f, 0.0f, (float)(mipSize.x), (float)(mipSize.y), 0.0f, 1.0f);
+                    Ctr::TextureImage environment;
+                    _probeCapture->build(meshes);
+                    _probeCapture->capture(probe->center(),
+                                           probe->basis(),
+                                           size_t(mipSize.x),
+                                           mipLevels,
+                                           environment,
+                                           probe->environmentCubeMap()->format());
+                    captured = probe->environmentCubeMap()->writeImage(environment);
+                    _probeCapture->clear();
+                }
 
-                    // Render to top level mip for both cubemaps. A better strategy would be to blit after the first render...
-                    Ctr::FrameBuffer framebuffer(probe->environmentCubeMap()->surface(-1, (int32_t)(mipId)), nullptr);
-                    _deviceInterface->bindFrameBuffer(framebuffer);
-                    _deviceInterface->setViewport(&mipViewport);
-                    _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
-    
-                    // Render the scene to cubemap (single pass).
-                    //renderMeshes (_passName, scene);
-                    const std::vector<Ctr::Mesh*>& meshes = scene->meshesForPass(_passName);
-                    for (auto it = meshes.begin(); it != meshes.end(); it++)
+                if (!captured)
+                {
+                    for (size_t mipId = 0; mipId < mipLevels; mipId++)
                     {
-                        const Ctr::Mesh* mesh = (*it);
-                        const Ctr::Material* material = mesh->material();
-                        const Ctr::IShader* shader = material->shader();
-                        const Ctr::GpuTechnique* technique = material->technique();
+                        Ctr::Viewport mipViewport (0.0f, 0.0f, (float)(mipSize.x), (float)(mipSize.y), 0.0f, 1.0f);
+
+                        // Render to top level mip for both cubemaps. A better strategy would be to blit after the first render...
+                        Ctr::FrameBuffer framebuffer(probe->environmentCubeMap()->surface(-1, (int32_t)(mipId)), nullptr);
+                        _deviceInterface->bindFrameBuffer(framebuffer);
+                        _deviceInterface->setViewport(&mipViewport);
+                        _deviceInterface->clearSurfaces (0, Ctr::CLEAR_TARGET, 0, 0, 0, 1);
+    
+                        // Render the scene to cubemap (single pass).
+                        //renderMeshes (_passName, scene);
+                        for (auto it = meshes.begin(); it != meshes.end(); it++)
+                        {
+                            const Ctr::Mesh* mesh = (*it);
+                            const Ctr::Material* material = mesh->material();
+                            const Ctr::IShader* shader = material->shader();
+                            const Ctr::GpuTechnique* technique = material->technique();
     
-                        RenderRequest renderRequest (technique, scene, scene->camera(), mesh);
-                        shader->renderMesh(renderRequest);
+                            RenderRequest renderRequest (technique, scene, scene->camera(), mesh);
+                            shader->renderMesh(renderRequest);
+                        }
+
+                        mipSize.x /= 2.0f;
+                        mipSize.y /= 2.0f;
                     }
 
-                    mipSize.x /= 2.0f;
-                    mipSize.y /= 2.0f;
+                    // Generate mip maps post rendering.
+                    probe->environmentCubeMap()->generateMipMaps();    
                 }
 
-                // Generate mip maps post rendering.
-                probe->environmentCubeMap()->generateMipMaps();    
+                // The environment changed, rebuild its luminance distribution.
+                if (probe->environmentSampling())
+                {
+                    probe->environmentDistribution()->update(probe->environmentCubeMap());
+                }
+                else
+                {
+                    probe->environmentDistribution()->invalidate();
+                }
                 refineSpecular(scene, probe);
                 refineDiffuse(scene, probe);
 
@@ -550,6 +790,7 @@ IBLRenderPass::colorConvert(bool applyMDR,
 void
 IBLRenderPass::colorConvert(Ctr::Scene* scene, Ctr::IBLProbe* probe)
 {
+    CTR_PROFILE_ZONE("IBLRenderPass::colorConvert");
     {
         // Convert specular src to MDR, save. (small memory optimization).
         colorConvert(true, true, scene, probe->environmentCubeMapMDR(), probe->environmentCubeMap(), probe);
@@ -55,6 +55,7 @@ class IShader;
 class GPUTechnique;
 class GPUVariable;
 class IBLConvolutions;
+class ProbeCapture;
 
 // Render pass for volume generation.
 class IBLRenderPass : public Ctr::RenderPass
@@ -76,10 +77,58 @@ class IBLRenderPass : public Ctr::RenderPass
                                             Ctr::ITexture* src,
                                             Ctr::IBLProbe* probe);
 
+    //------------------------------------------------------------
+    // Converges probe with ping pong and running average
+    // accumulation and compares the specular mips. Returns true
+    // if every mip matches within the relative rms tolerance.
+    // The probe is left uncached in its original mode.
+    //------------------------------------------------------------
+    bool                       compareAccumulationModes(Ctr::Scene* scene,
+                                                        Ctr::IBLProbe* probe,
+                                                        float tolerance = 0.01f);
+
   protected:
     bool                       loadMesh();
 
   private:
+    // Importance sampling shader handles, kept across frames and
+    // resolved again only when the shader layout serial changes.
+    struct ConvolutionHandles
+    {
+        ConvolutionHandles();
+        bool                   resolve(const Ctr::IShader* importanceSamplingShader);
+
+        const Ctr::IShader*        shader;
+        uint32_t                   layoutSerial;
+        bool                       valid;
+        const Ctr::GpuTechnique*   technique;
+        const Ctr::GpuVariable*    source;
+        const Ctr::GpuVariable*    lastResult;
+        const Ctr::GpuVariable*    mip;
+        const Ctr::GpuVariable*    roughness;
+        const Ctr::GpuVariable*    samplesOffset;
+        const Ctr::GpuVariable*    sampleCount;
+        const Ctr::GpuVariable*    maxSamples;
+        const Ctr::GpuVariable*    blendWeight;
+
+        // Optional, shaders without environment sampling leave these null.
+        const Ctr::GpuVariable*    environmentConditional;
+        const Ctr::GpuVariable*    environmentMarginal;
+        const Ctr::GpuVariable*    environmentSampling;
+    };
+
+    // Binds the environment distribution of the probe, or disables
+    // environment sampling if the probe has none.
+    void                       bindEnvironmentDistribution(const ConvolutionHandles& handles,
+                                                           const Ctr::IBLProbe* probe);
+
+    // Binds the map of the last pass, or sets up blending of this pass
+    // into the target for probes that keep a running average.
+    void                       beginAccumulation(const ConvolutionHandles& handles,
+                                                 const Ctr::IBLProbe* probe,
+                                                 const Ctr::ITexture* lastResult);
+    void                       endAccumulation(const Ctr::IBLProbe* probe);
+
     // Refine importance sampling for specular cube.
     void                       refineSpecular(Ctr::Scene* scene,
                                               const Ctr::IBLProbe* probe);
@@ -93,6 +142,9 @@ class IBLRenderPass : public Ctr::RenderPass
     Ctr::CameraTransformCachePtr _environmentTransformCache;
     Ctr::IBLConvolutions*        _convolve;
 
+    // CPU ray traced environment capture, for probes with CPU Capture set.
+    Ctr::ProbeCapture*           _probeCapture;
+
     // Procedural Splat Geometry
     Ctr::Entity*                _sphereEntity;
     Ctr::Mesh*                  _sphereMesh; 
@@ -104,6 +156,9 @@ class IBLRenderPass : public Ctr::RenderPass
     Hash                       _specularHash;
     Hash                       _colorHash;
 
+    ConvolutionHandles         _diffuseHandles;
+    ConvolutionHandles         _specularHandles;
+
     // Color Conversion shader to LDR and MDR.
     const Ctr::IShader*        _colorConversionShader;
     const Ctr::GpuTechnique*   _colorConversionTechnique;
@@ -83,6 +83,16 @@ IComputeShader : public IRenderResource
     virtual bool                createConstantBuffer(size_t) = 0;
     virtual bool                updateConstantBuffer(void*, size_t) = 0;
 
+    //------------------------------------------------------
+    // create() split in three, so a reload can compile many
+    // shaders in parallel. loadSource and finishCreate use
+    // the asset and texture managers and must run on the
+    // main thread, compileSource may run on any thread.
+    //------------------------------------------------------
+    virtual bool                loadSource() = 0;
+    virtual bool                compileSource() = 0;
+    virtual bool                finishCreate() = 0;
+
     virtual const std::string&  filePathName() const = 0;
     virtual const std::string&  includePathName() const =0;
 
@@ -161,6 +161,7 @@ TextureParameters::TextureParameters (const std::vector<std::string>& filenames,
     _multiSampleCount (multiSampleCount),
     _multiSampleQuality (multiSampleQuality),
     _mipLevels (mipLevels),
+    _residentMip (0),
     _useUAV (useUAV)
 {
 };
@@ -187,6 +188,7 @@ TextureParameters::TextureParameters(const std::string&     filename,
     _multiSampleCount (multiSampleCount),
     _multiSampleQuality (multiSampleQuality),
     _mipLevels (mipLevels),
+    _residentMip (0),
     _useUAV (useUAV)
 {
     _filenames.push_back(filename);
@@ -235,6 +237,18 @@ TextureParameters::setNumMipLevels(size_t value)
     _mipLevels = value;
 }
 
+uint32_t
+TextureParameters::residentMip() const
+{
+    return _residentMip;
+}
+
+void
+TextureParameters::setResidentMip(uint32_t value)
+{
+    _residentMip = value;
+}
+
 TextureParameters::TextureParameters (const TextureParameters& data)
 {
     _images = data._images;
@@ -248,6 +262,7 @@ TextureParameters::TextureParameters (const TextureParameters& data)
     _multiSampleCount = data._multiSampleCount;
     _multiSampleQuality = data._multiSampleQuality;
     _mipLevels = data._mipLevels;
+    _residentMip = data._residentMip;
     _useUAV = data._useUAV;
 }
 
@@ -401,11 +416,13 @@ DepthSurfaceParameters::setHeight (int height) {
     _height = height;
 }
 
-IndexBufferParameters::IndexBufferParameters(uint32_t sizeInBytesVal, bool isRingBuffered, bool isDynamic) 
+IndexBufferParameters::IndexBufferParameters(uint32_t sizeInBytesVal, bool isRingBuffered, bool isDynamic,
+                                             Ctr::IndexFormat format) 
 {
     _sizeInBytes = sizeInBytesVal;
     _isRingBuffered = isRingBuffered;
     _isDynamic = isDynamic;
+    _format = format;
 };
 
 IndexBufferParameters::IndexBufferParameters (const IndexBufferParameters& in)
@@ -413,6 +430,7 @@ IndexBufferParameters::IndexBufferParameters (const IndexBufferParameters& in)
     _sizeInBytes =     in.sizeInBytes();
     _isDynamic = in.dynamic();
     _isRingBuffered = in.ringBuffered();
+    _format = in.format();
 };
 
 unsigned int                
@@ -433,6 +451,12 @@ IndexBufferParameters::dynamic() const
     return _isDynamic;
 }
 
+Ctr::IndexFormat
+IndexBufferParameters::format() const
+{
+    return _format;
+}
+
 VertexBufferParameters::VertexBufferParameters(uint32_t sizeInBytesVal,
                      bool isRingBuffered, 
                      bool streamOut , 
@@ -161,6 +161,11 @@ class TextureParameters : public RenderResourceParameters
     void                    setDepth(float);
     void                    setNumMipLevels(size_t);
 
+    // Streamed textures are created from their mip tail. The images then
+    // start at this level of a chain described by the bounds and mipLevels.
+    uint32_t                residentMip() const;
+    void                    setResidentMip(uint32_t);
+
     const TextureImageArray& images() const;
 
   private:
@@ -174,6 +179,7 @@ class TextureParameters : public RenderResourceParameters
     TextureType              _type;
     int                      _textureCount;
     size_t                   _mipLevels;
+    uint32_t                 _residentMip;
 
     int                      _multiSampleCount;
     int                      _multiSampleQuality;
@@ -229,18 +235,21 @@ class DepthSurfaceParameters  : public RenderResourceParameters
 class IndexBufferParameters : public RenderResourceParameters
 {    
   public:
-    IndexBufferParameters(uint32_t sizeInBytesVal, bool isRingBuffered = false, bool isDynamic = false);
+    IndexBufferParameters(uint32_t sizeInBytesVal, bool isRingBuffered = false, bool isDynamic = false,
+                          Ctr::IndexFormat format = Ctr::INDEX32);
 
     IndexBufferParameters (const IndexBufferParameters& in);
 
     unsigned int               sizeInBytes() const;
     bool                       ringBuffered() const;
     bool                       dynamic() const;
+    Ctr::IndexFormat           format() const;
 
   private:
     unsigned                   _sizeInBytes;
     bool                       _isRingBuffered;
     bool                       _isDynamic;
+    Ctr::IndexFormat           _format;
 };
 
 class VertexBufferParameters : public RenderResourceParameters
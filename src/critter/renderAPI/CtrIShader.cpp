@@ -39,10 +39,26 @@
 //                                                                                    //
 //------------------------------------------------------------------------------------//
 #include <CtrIShader.h>
+#include <CtrGpuTechnique.h>
+#include <CtrGpuVariable.h>
+#include <atomic>
 
 namespace Ctr
 {
-IShader::IShader (Ctr::IDevice* device) : IRenderResource (device)
+namespace
+{
+// Process wide, so no two layouts (of any shader) share a serial.
+std::atomic<uint32_t> layoutSerialCounter(0);
+
+uint32_t
+nextLayoutSerial()
+{
+    return layoutSerialCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+}
+
+IShader::IShader (Ctr::IDevice* device) : IRenderResource (device),
+    _layoutSerial(nextLayoutSerial())
 {
 }
 
@@ -99,6 +115,53 @@ IShader::setFilename (const char* shaderFileName)
     _fileName = std::string (shaderFileName); 
 }
 
+bool
+IShader::getTechnique(SymbolId name, const GpuTechnique*& technique) const
+{
+    technique = nullptr;
+    return _techniqueSymbols.find(name, technique);
+}
+
+bool
+IShader::getParameter(SymbolId name, const GpuVariable*& coreVariable) const
+{
+    coreVariable = nullptr;
+    return _parameterSymbols.find(name, coreVariable);
+}
+
+uint32_t
+IShader::layoutSerial() const
+{
+    return _layoutSerial;
+}
+
+void
+IShader::clearSymbols()
+{
+    _techniqueSymbols.clear();
+    _parameterSymbols.clear();
+    _layoutSerial = nextLayoutSerial();
+}
+
+void
+IShader::addTechniqueSymbol(const GpuTechnique* technique)
+{
+    // First technique wins, as with the old linear search.
+    const GpuTechnique* existing = nullptr;
+    SymbolId name = Symbol::intern(technique->name());
+    if (!_techniqueSymbols.find(name, existing))
+        _techniqueSymbols.insert(name, technique);
+}
+
+void
+IShader::addParameterSymbol(const GpuVariable* variable)
+{
+    const GpuVariable* existing = nullptr;
+    SymbolId name = Symbol::intern(variable->name());
+    if (!_parameterSymbols.find(name, existing))
+        _parameterSymbols.insert(name, variable);
+}
+
 void
 IShader::setShaderStream (const char* shaderStream) 
 { 
@@ -44,6 +44,7 @@
 #include <CtrIRenderResource.h>
 #include <CtrRenderRequest.h>
 #include <CtrHash.h>
+#include <CtrSymbol.h>
 
 namespace Ctr
 {
@@ -86,6 +87,33 @@ IShader : public IRenderResource
     virtual bool                getParameterByName (const std::string& parameterName,
                                                     const GpuVariable*& coreVariable) const = 0;
 
+    //------------------------------------------------------
+    // Interned lookups. Resolve the symbol once and keep it.
+    //------------------------------------------------------
+    bool                        getTechnique(SymbolId name,
+                                             const GpuTechnique*& technique) const;
+    bool                        getParameter(SymbolId name,
+                                             const GpuVariable*& coreVariable) const;
+
+    //------------------------------------------------------
+    // Unique id of the current techniques and parameters.
+    // Renewed whenever they are rebuilt (for example on
+    // reload) and never shared between shaders, so a cache
+    // keyed on it can't match a new shader allocated at a
+    // recycled address.
+    //------------------------------------------------------
+    uint32_t                    layoutSerial() const;
+
+    //------------------------------------------------------
+    // create() split in three, so a reload can compile many
+    // shaders in parallel. loadSource and finishCreate use
+    // the asset and texture managers and must run on the
+    // main thread, compileSource may run on any thread.
+    //------------------------------------------------------
+    virtual bool                loadSource() = 0;
+    virtual bool                compileSource() = 0;
+    virtual bool                finishCreate() = 0;
+
     //-----------------------------------
     // Gets the specified constant buffer
     //-----------------------------------
@@ -154,12 +182,20 @@ IShader : public IRenderResource
     const Hash&                 hash() const;
 
   protected:
+    void                        clearSymbols();
+    void                        addTechniqueSymbol(const GpuTechnique* technique);
+    void                        addParameterSymbol(const GpuVariable* variable);
+
     Hash                        _hash;
   private:
     std::string                _shaderStream;
     std::string                _fileName;
     std::string                _includeFileName;
     std::string                _name;
+
+    SymbolMap<const GpuTechnique*> _techniqueSymbols;
+    SymbolMap<const GpuVariable*>  _parameterSymbols;
+    uint32_t                   _layoutSerial;
 };
 
 }
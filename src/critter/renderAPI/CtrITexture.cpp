@@ -59,6 +59,7 @@ ITexture::ITexture (Ctr::IDevice* device) :
            _channels (0),
            _pixelChannelPitch (0),
            _activeMipId(-1),
+           _residentMip(0),
            _mipCount(1)
 {
 }
@@ -207,4 +208,34 @@ ITexture::mipCount() const
     return _mipCount;
 }
 
-}
\ No newline at end of file
+TextureImagePtr
+ITexture::readImage(Ctr::PixelFormat, int32_t) const
+{
+    return TextureImagePtr();
+}
+
+bool
+ITexture::writeImage(const Ctr::TextureImage&)
+{
+    return false;
+}
+
+bool
+ITexture::writeLevel(const Ctr::TextureImage&, uint32_t)
+{
+    return false;
+}
+
+void
+ITexture::setResidentMip(uint32_t mipId)
+{
+    _residentMip = mipId;
+}
+
+uint32_t
+ITexture::residentMip() const
+{
+    return _residentMip;
+}
+
+}
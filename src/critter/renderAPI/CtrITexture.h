@@ -106,6 +106,22 @@ ITexture : public IRenderResource
 
     // Read all pixels. Pixels should be preallocated to byteSize().
     virtual Ctr::Vector4f      read (Ctr::byte* pos) const = 0;
+
+    // Read back the texture into an image. mipId -1 reads the whole chain,
+    // otherwise a single level is read. Empty if readback is unsupported.
+    virtual TextureImagePtr    readImage(Ctr::PixelFormat format, int32_t mipId = -1) const;
+
+    // Upload the faces and mips of an image of the same size, converting to
+    // the texture format. False if the texture cannot be written from the CPU.
+    virtual bool               writeImage(const Ctr::TextureImage& image);
+
+    // Upload every face of a single level image to mipId. Streamed
+    // textures receive their levels this way, coarsest first.
+    virtual bool               writeLevel(const Ctr::TextureImage& level, uint32_t mipId);
+
+    // Most detailed level holding valid data, sampling is clamped to it.
+    virtual void               setResidentMip(uint32_t mipId);
+    uint32_t                   residentMip() const;
     
     virtual bool               save(const std::string& filePathName,
                                     bool fixSeams = false,
@@ -159,6 +175,7 @@ ITexture : public IRenderResource
     int                        _multiSampleCount;
     int                        _activeSlice;
     int                        _activeMipId;
+    uint32_t                   _residentMip;
     Ctr::TextureParameters*    _resource;
     bool                       _inUse;
     std::string                _filename;
@@ -0,0 +1,599 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrIrradianceVolume.h>
+#include <CtrProbeCapture.h>
+#include <CtrBorderedCubemap.h>
+#include <CtrTextureImage.h>
+#include <CtrTransformNode.h>
+#include <CtrMesh.h>
+#include <CtrFrustum.h>
+#include <CtrBitwise.h>
+#include <CtrMath.h>
+#include <CtrLog.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+const float MaxHalf = 65504.0f;
+
+// Real spherical harmonics up to band 2.
+inline void
+evaluateBasis(const Ctr::Vector3f& d, float* y)
+{
+    y[0] = 0.282095f;
+    y[1] = 0.488603f * d.y;
+    y[2] = 0.488603f * d.z;
+    y[3] = 0.488603f * d.x;
+    y[4] = 1.092548f * d.x * d.y;
+    y[5] = 1.092548f * d.y * d.z;
+    y[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+    y[7] = 1.092548f * d.x * d.z;
+    y[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+}
+
+// Solid angle of the part of a cube face between (0, 0) and (x, y) in [-1, 1].
+inline float
+areaElement(float x, float y)
+{
+    return std::atan2(x * y, std::sqrt(x * x + y * y + 1.0f));
+}
+
+inline float
+texelSolidAngle(size_t x, size_t y, size_t faceSize)
+{
+    float x0 = 2.0f * x / float(faceSize) - 1.0f;
+    float y0 = 2.0f * y / float(faceSize) - 1.0f;
+    float x1 = 2.0f * (x + 1) / float(faceSize) - 1.0f;
+    float y1 = 2.0f * (y + 1) / float(faceSize) - 1.0f;
+    return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+}
+
+#if CTR_SSE
+inline float
+horizontalSum(__m128 value)
+{
+    __m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(value, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+#endif
+}
+
+IrradianceVolume::IrradianceVolume() :
+    _bounds(emptyBounds()),
+    _resolution(0, 0, 0),
+    _order(OrderL2),
+    _probeCount(0),
+    _dirtyCount(0)
+{
+}
+
+IrradianceVolume::~IrradianceVolume()
+{
+}
+
+void
+IrradianceVolume::create(const Ctr::Region3f& bounds,
+                         const Ctr::Vector3i& resolution,
+                         Order order,
+                         uint32_t captureSize)
+{
+    _bounds = bounds;
+    _resolution = Ctr::Vector3i(maxValue(resolution.x, 1), maxValue(resolution.y, 1), maxValue(resolution.z, 1));
+    _order = order;
+    _probeCount = size_t(_resolution.x) * size_t(_resolution.y) * size_t(_resolution.z);
+
+    _coefficients.assign(3 * coefficientCount() * _probeCount, 0);
+    _meshBounds.clear();
+    invalidateAll();
+
+    // Cube of capture directions in 2x2 texel packets, faces of even size.
+    size_t faceSize = maxValue(size_t(2), size_t(captureSize + 1) & ~size_t(1));
+    _captureTexels.clear();
+    _captureTexels.reserve(BorderedCubemap::FACE_COUNT * faceSize * faceSize);
+    for (size_t faceId = 0; faceId < BorderedCubemap::FACE_COUNT; faceId++)
+    {
+        for (size_t y = 0; y < faceSize; y += 2)
+        {
+            for (size_t x = 0; x < faceSize; x += 2)
+            {
+                for (uint32_t lane = 0; lane < 4; lane++)
+                {
+                    size_t texelX = x + (lane & 1);
+                    size_t texelY = y + (lane >> 1);
+
+                    CaptureTexel texel;
+                    texel.direction = BorderedCubemap::directionFromFace(faceId,
+                                                                         (texelX + 0.5f) / float(faceSize),
+                                                                         (texelY + 0.5f) / float(faceSize));
+                    texel.direction.normalize();
+
+                    float solidAngle = texelSolidAngle(texelX, texelY, faceSize);
+                    evaluateBasis(texel.direction, texel.weights);
+                    for (uint32_t coefficient = 0; coefficient < 9; coefficient++)
+                        texel.weights[coefficient] *= solidAngle;
+                    _captureTexels.push_back(texel);
+                }
+            }
+        }
+    }
+}
+
+void
+IrradianceVolume::clear()
+{
+    _bounds = emptyBounds();
+    _resolution = Ctr::Vector3i(0, 0, 0);
+    _probeCount = 0;
+    _coefficients.clear();
+    _dirty.clear();
+    _dirtyCount = 0;
+    _captureTexels.clear();
+    _meshBounds.clear();
+}
+
+bool
+IrradianceVolume::empty() const
+{
+    return _probeCount == 0;
+}
+
+const Ctr::Region3f&
+IrradianceVolume::bounds() const
+{
+    return _bounds;
+}
+
+const Ctr::Vector3i&
+IrradianceVolume::resolution() const
+{
+    return _resolution;
+}
+
+IrradianceVolume::Order
+IrradianceVolume::order() const
+{
+    return _order;
+}
+
+size_t
+IrradianceVolume::probeCount() const
+{
+    return _probeCount;
+}
+
+uint32_t
+IrradianceVolume::coefficientCount() const
+{
+    return uint32_t(_order) * uint32_t(_order);
+}
+
+Ctr::Vector3f
+IrradianceVolume::probePosition(const Ctr::Vector3i& probe) const
+{
+    Ctr::Vector3f position;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        float t = _resolution[axis] > 1 ? float(probe[axis]) / float(_resolution[axis] - 1) : 0.5f;
+        position[axis] = _bounds.minExtent[axis] + t * (_bounds.maxExtent[axis] - _bounds.minExtent[axis]);
+    }
+    return position;
+}
+
+void
+IrradianceVolume::markCells(const Ctr::Region3f& bounds)
+{
+    if (empty() || !boundsValid(bounds))
+        return;
+
+    int32_t first[3];
+    int32_t last[3];
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        if (bounds.maxExtent[axis] < _bounds.minExtent[axis] ||
+            bounds.minExtent[axis] > _bounds.maxExtent[axis])
+        {
+            return;
+        }
+
+        // Corners of every cell the bounds touch.
+        float cells = float(_resolution[axis] - 1);
+        float extent = _bounds.maxExtent[axis] - _bounds.minExtent[axis];
+        float scale = extent > 0.0f ? cells / extent : 0.0f;
+        float lo = clamped((bounds.minExtent[axis] - _bounds.minExtent[axis]) * scale, 0.0f, cells);
+        float hi = clamped((bounds.maxExtent[axis] - _bounds.minExtent[axis]) * scale, 0.0f, cells);
+        first[axis] = int32_t(std::floor(lo));
+        last[axis] = int32_t(std::ceil(hi));
+    }
+
+    for (int32_t z = first[2]; z <= last[2]; z++)
+    {
+        for (int32_t y = first[1]; y <= last[1]; y++)
+        {
+            for (int32_t x = first[0]; x <= last[0]; x++)
+            {
+                size_t probeIndex = size_t(x) + size_t(_resolution.x) * (size_t(y) + size_t(_resolution.y) * size_t(z));
+                if (!_dirty[probeIndex])
+                {
+                    _dirty[probeIndex] = 1;
+                    _dirtyCount++;
+                }
+            }
+        }
+    }
+}
+
+void
+IrradianceVolume::invalidate(const Ctr::Region3f& bounds)
+{
+    markCells(bounds);
+}
+
+void
+IrradianceVolume::collectBounds(Ctr::TransformNode* node,
+                                std::vector<std::pair<const Ctr::Mesh*, Ctr::Region3f> >& bounds) const
+{
+    if (Ctr::Mesh* mesh = dynamic_cast<Ctr::Mesh*>(node))
+    {
+        mesh->updateWorldBounds();
+        bounds.push_back(std::make_pair(mesh, mesh->worldBounds()));
+    }
+
+    const std::vector<Ctr::TransformNode*>& children = node->children();
+    for (auto it = children.begin(); it != children.end(); it++)
+    {
+        collectBounds(*it, bounds);
+    }
+}
+
+void
+IrradianceVolume::invalidate(Ctr::TransformNode* node)
+{
+    if (!node)
+        return;
+
+    std::vector<std::pair<const Ctr::Mesh*, Ctr::Region3f> > meshes;
+    collectBounds(node, meshes);
+    if (meshes.empty())
+    {
+        Ctr::Vector3f position = node->worldTranslation();
+        markCells(Ctr::Region3f(position, position));
+        return;
+    }
+
+    for (auto it = meshes.begin(); it != meshes.end(); it++)
+    {
+        auto found = _meshBounds.find(it->first);
+        if (found != _meshBounds.end())
+        {
+            markCells(found->second);
+            found->second = it->second;
+        }
+        else
+        {
+            _meshBounds[it->first] = it->second;
+        }
+        markCells(it->second);
+    }
+}
+
+void
+IrradianceVolume::invalidateChanged(const std::vector<Ctr::Mesh*>& meshes)
+{
+    std::set<const Ctr::Mesh*> seen;
+    for (auto it = meshes.begin(); it != meshes.end(); it++)
+    {
+        Ctr::Mesh* mesh = *it;
+        mesh->updateWorldBounds();
+        const Ctr::Region3f& bounds = mesh->worldBounds();
+        seen.insert(mesh);
+
+        auto found = _meshBounds.find(mesh);
+        if (found == _meshBounds.end())
+        {
+            _meshBounds[mesh] = bounds;
+            markCells(bounds);
+        }
+        else if (found->second != bounds)
+        {
+            markCells(found->second);
+            markCells(bounds);
+            found->second = bounds;
+        }
+    }
+
+    // Removed meshes.
+    for (auto it = _meshBounds.begin(); it != _meshBounds.end();)
+    {
+        if (seen.find(it->first) == seen.end())
+        {
+            markCells(it->second);
+            it = _meshBounds.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void
+IrradianceVolume::invalidateAll()
+{
+    _dirty.assign(_probeCount, 1);
+    _dirtyCount = _probeCount;
+}
+
+size_t
+IrradianceVolume::dirtyCount() const
+{
+    return _dirtyCount;
+}
+
+void
+IrradianceVolume::bakeProbe(const Ctr::ProbeCapture& capture, size_t probeIndex)
+{
+    size_t x = probeIndex % size_t(_resolution.x);
+    size_t y = (probeIndex / size_t(_resolution.x)) % size_t(_resolution.y);
+    size_t z = probeIndex / (size_t(_resolution.x) * size_t(_resolution.y));
+    Ctr::Vector3f position = probePosition(Ctr::Vector3i(int32_t(x), int32_t(y), int32_t(z)));
+
+    uint32_t count = coefficientCount();
+    float sums[3][9] = {};
+    Ctr::Vector3f directions[4];
+    Ctr::Vector4f radiance[4];
+    for (size_t texelId = 0; texelId < _captureTexels.size(); texelId += 4)
+    {
+        const CaptureTexel* texels = &_captureTexels[texelId];
+        for (uint32_t lane = 0; lane < 4; lane++)
+            directions[lane] = texels[lane].direction;
+
+        capture.trace4(position, directions, radiance);
+
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            for (uint32_t coefficient = 0; coefficient < count; coefficient++)
+            {
+                float weight = texels[lane].weights[coefficient];
+                sums[0][coefficient] += radiance[lane].x * weight;
+                sums[1][coefficient] += radiance[lane].y * weight;
+                sums[2][coefficient] += radiance[lane].z * weight;
+            }
+        }
+    }
+
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        for (uint32_t coefficient = 0; coefficient < count; coefficient++)
+        {
+            size_t plane = channel * count + coefficient;
+            _coefficients[plane * _probeCount + probeIndex] =
+                Bitwise::floatToHalf(clamped(sums[channel][coefficient], -MaxHalf, MaxHalf));
+        }
+    }
+}
+
+size_t
+IrradianceVolume::bake(const Ctr::ProbeCapture& capture, size_t maxProbes)
+{
+    std::vector<size_t> probes;
+    probes.reserve(minValue(_dirtyCount, maxProbes));
+    for (size_t probeIndex = 0; probeIndex < _dirty.size() && probes.size() < maxProbes; probeIndex++)
+    {
+        if (_dirty[probeIndex])
+            probes.push_back(probeIndex);
+    }
+
+    // Probes write disjoint coefficients.
+    concurrency::parallel_for(size_t(0), probes.size(), [&](size_t id)
+    {
+        bakeProbe(capture, probes[id]);
+    });
+
+    for (auto it = probes.begin(); it != probes.end(); it++)
+        _dirty[*it] = 0;
+    _dirtyCount -= probes.size();
+
+    if (!probes.empty())
+    {
+        LOG("Baked " << probes.size() << " of " << _probeCount << " irradiance volume probes");
+    }
+    return probes.size();
+}
+
+void
+IrradianceVolume::sample(const Ctr::Vector3f& position,
+                         Ctr::Vector3f* rgb) const
+{
+    uint32_t count = coefficientCount();
+    if (empty())
+    {
+        for (uint32_t coefficient = 0; coefficient < count; coefficient++)
+            rgb[coefficient] = Ctr::Vector3f(0, 0, 0);
+        return;
+    }
+
+    // Cell and offset within it along each axis.
+    size_t base = 0;
+    size_t stride[3] = { 1, size_t(_resolution.x), size_t(_resolution.x) * size_t(_resolution.y) };
+    size_t step[3];
+    float t[3];
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        int32_t cells = _resolution[axis] - 1;
+        float extent = _bounds.maxExtent[axis] - _bounds.minExtent[axis];
+        float g = cells > 0 && extent > 0.0f ? 
+            clamped((position[axis] - _bounds.minExtent[axis]) / extent * cells, 0.0f, float(cells)) : 0.0f;
+        int32_t cell = minValue(int32_t(g), maxValue(cells - 1, 0));
+        t[axis] = g - float(cell);
+        base += size_t(cell) * stride[axis];
+        step[axis] = cells > 0 ? stride[axis] : 0;
+    }
+
+    size_t corners[8];
+    float weights[8];
+    for (uint32_t corner = 0; corner < 8; corner++)
+    {
+        uint32_t cx = corner & 1;
+        uint32_t cy = (corner >> 1) & 1;
+        uint32_t cz = corner >> 2;
+        corners[corner] = base + cx * step[0] + cy * step[1] + cz * step[2];
+        weights[corner] = (cx ? t[0] : 1.0f - t[0]) *
+                          (cy ? t[1] : 1.0f - t[1]) *
+                          (cz ? t[2] : 1.0f - t[2]);
+    }
+
+    const uint16_t* planes = &_coefficients[0];
+#if CTR_SSE
+    __m128 weights0 = _mm_loadu_ps(&weights[0]);
+    __m128 weights1 = _mm_loadu_ps(&weights[4]);
+#endif
+    for (uint32_t channel = 0; channel < 3; channel++)
+    {
+        for (uint32_t coefficient = 0; coefficient < count; coefficient++)
+        {
+            const uint16_t* plane = planes + (channel * count + coefficient) * _probeCount;
+#if CTR_SSE
+            __m128i halves = _mm_setr_epi16(plane[corners[0]], plane[corners[1]],
+                                            plane[corners[2]], plane[corners[3]],
+                                            plane[corners[4]], plane[corners[5]],
+                                            plane[corners[6]], plane[corners[7]]);
+            __m128 values0 = Bitwise::halfToFloat4(halves);
+            __m128 values1 = Bitwise::halfToFloat4(_mm_srli_si128(halves, 8));
+            float value = horizontalSum(_mm_add_ps(_mm_mul_ps(values0, weights0),
+                                                   _mm_mul_ps(values1, weights1)));
+#else
+            float value = 0.0f;
+            for (uint32_t corner = 0; corner < 8; corner++)
+                value += Bitwise::halfToFloat(plane[corners[corner]]) * weights[corner];
+#endif
+            rgb[coefficient][channel] = value;
+        }
+    }
+}
+
+Ctr::Vector3f
+IrradianceVolume::irradiance(const Ctr::Vector3f& position,
+                             const Ctr::Vector3f& normal) const
+{
+    // Cosine lobe convolution per band.
+    static const float bandScale[3] = { BB_PI, 2.0f * BB_PI / 3.0f, BB_PI / 4.0f };
+
+    Ctr::Vector3f rgb[9];
+    sample(position, rgb);
+
+    float basis[9];
+    evaluateBasis(normal, basis);
+
+    Ctr::Vector3f result(0, 0, 0);
+    for (uint32_t coefficient = 0; coefficient < coefficientCount(); coefficient++)
+    {
+        uint32_t band = coefficient == 0 ? 0 : (coefficient < 4 ? 1 : 2);
+        float scale = bandScale[band] * basis[coefficient];
+        result.x += rgb[coefficient].x * scale;
+        result.y += rgb[coefficient].y * scale;
+        result.z += rgb[coefficient].z * scale;
+    }
+    return Ctr::Vector3f(maxValue(result.x, 0.0f), maxValue(result.y, 0.0f), maxValue(result.z, 0.0f));
+}
+
+const uint16_t*
+IrradianceVolume::coefficients() const
+{
+    return _coefficients.empty() ? nullptr : &_coefficients[0];
+}
+
+size_t
+IrradianceVolume::coefficientsSizeInBytes() const
+{
+    return _coefficients.size() * sizeof(uint16_t);
+}
+
+void
+IrradianceVolume::projectCubemap(const Ctr::TextureImage& cubemap,
+                                 size_t mipmap,
+                                 Ctr::Vector3f* rgb)
+{
+    float sums[3][9] = {};
+    std::vector<float> texels;
+    for (size_t faceId = 0; faceId < minValue(cubemap.getNumFaces(), size_t(BorderedCubemap::FACE_COUNT)); faceId++)
+    {
+        // Any source format, read as float rgba.
+        Ctr::PixelBox source = cubemap.getPixelBox(faceId, mipmap);
+        size_t faceSize = source.size().x;
+        texels.resize(faceSize * faceSize * 4);
+        Ctr::PixelBox face(faceSize, faceSize, 1, PF_FLOAT32_RGBA, &texels[0]);
+        PixelUtil::bulkPixelConversion(source, face);
+
+        for (size_t y = 0; y < faceSize; y++)
+        {
+            for (size_t x = 0; x < faceSize; x++)
+            {
+                Ctr::Vector3f direction = BorderedCubemap::directionFromFace(faceId,
+                                                                             (x + 0.5f) / float(faceSize),
+                                                                             (y + 0.5f) / float(faceSize));
+                direction.normalize();
+
+                float basis[9];
+                evaluateBasis(direction, basis);
+                float solidAngle = texelSolidAngle(x, y, faceSize);
+                const float* texel = &texels[(y * faceSize + x) * 4];
+                for (uint32_t coefficient = 0; coefficient < 9; coefficient++)
+                {
+                    float weight = basis[coefficient] * solidAngle;
+                    sums[0][coefficient] += texel[0] * weight;
+                    sums[1][coefficient] += texel[1] * weight;
+                    sums[2][coefficient] += texel[2] * weight;
+                }
+            }
+        }
+    }
+
+    for (uint32_t coefficient = 0; coefficient < 9; coefficient++)
+    {
+        rgb[coefficient] = Ctr::Vector3f(sums[0][coefficient], sums[1][coefficient], sums[2][coefficient]);
+    }
+}
+
+}
@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_IRRADIANCE_VOLUME
+#define INCLUDED_CRT_IRRADIANCE_VOLUME
+
+#include <CtrPlatform.h>
+#include <CtrRegion.h>
+#include <CtrVector3.h>
+#include <CtrVector4.h>
+#include <vector>
+#include <map>
+
+namespace Ctr
+{
+class Mesh;
+class TransformNode;
+class ProbeCapture;
+class TextureImage;
+
+// A grid of spherical harmonic radiance probes over a region of the scene,
+// a light weight alternative to IBLProbe for dense diffuse lighting.
+//
+// Probes sit on the corners of resolution - 1 cells per axis and are baked
+// in parallel from a ProbeCapture of the scene, so no device is needed.
+// Each probe projects the radiance of a small cube of rays (captureSize
+// texels per face, weighted by texel solid angle) onto L1 (4) or L2 (9)
+// coefficients per channel.
+//
+// Coefficients are stored as half floats in one contiguous structure of
+// arrays buffer, a plane of probeCount values per channel and coefficient:
+//   plane = channel * coefficientCount + coefficient
+//   value = coefficients()[plane * probeCount + probeIndex]
+// probeIndex = x + resolution.x * (y + resolution.y * z).
+//
+// Probes are rebaked only when invalidated: invalidate a node or region
+// that changed and the next bake recomputes the probes of every cell the
+// bounds (before and after the change) touch.
+class IrradianceVolume
+{
+  public:
+    enum Order
+    {
+        OrderL1 = 2,
+        OrderL2 = 3
+    };
+
+    IrradianceVolume();
+    ~IrradianceVolume();
+
+    // Sizes the grid (at least 1 probe per axis) and marks every probe dirty.
+    void                       create(const Ctr::Region3f& bounds,
+                                      const Ctr::Vector3i& resolution,
+                                      Order order = OrderL2,
+                                      uint32_t captureSize = 8);
+    void                       clear();
+    bool                       empty() const;
+
+    const Ctr::Region3f&       bounds() const;
+    const Ctr::Vector3i&       resolution() const;
+    Order                      order() const;
+    size_t                     probeCount() const;
+    uint32_t                   coefficientCount() const;
+    Ctr::Vector3f              probePosition(const Ctr::Vector3i& probe) const;
+
+    // Marks the probes of every cell that intersects bounds.
+    void                       invalidate(const Ctr::Region3f& bounds);
+    // Marks the cells around the meshes under node, at the bounds they had
+    // when last seen and the bounds they have now.
+    void                       invalidate(Ctr::TransformNode* node);
+    // Invalidates the meshes whose world bounds changed since the last call,
+    // and those that are no longer in the list.
+    void                       invalidateChanged(const std::vector<Ctr::Mesh*>& meshes);
+    void                       invalidateAll();
+    size_t                     dirtyCount() const;
+
+    // Rebakes up to maxProbes of the dirty probes from capture, the rest
+    // stay dirty for the next call. Returns the number baked.
+    size_t                     bake(const Ctr::ProbeCapture& capture,
+                                    size_t maxProbes = SIZE_MAX);
+
+    // Trilinear interpolation of the radiance coefficients at position,
+    // clamped to the volume. rgb holds coefficientCount entries.
+    void                       sample(const Ctr::Vector3f& position,
+                                      Ctr::Vector3f* rgb) const;
+
+    // Irradiance arriving at a surface with the normal at position.
+    Ctr::Vector3f              irradiance(const Ctr::Vector3f& position,
+                                          const Ctr::Vector3f& normal) const;
+
+    const uint16_t*            coefficients() const;
+    size_t                     coefficientsSizeInBytes() const;
+
+    // Projects the radiance of one level of a cube map image onto L2
+    // coefficients in the basis the volume bakes. rgb holds 9 entries.
+    static void                projectCubemap(const Ctr::TextureImage& cubemap,
+                                              size_t mipmap,
+                                              Ctr::Vector3f* rgb);
+
+  private:
+    struct CaptureTexel
+    {
+        Ctr::Vector3f          direction;
+        // Solid angle times each basis function.
+        float                  weights[9];
+    };
+
+    void                       markCells(const Ctr::Region3f& bounds);
+    void                       collectBounds(Ctr::TransformNode* node,
+                                             std::vector<std::pair<const Ctr::Mesh*, Ctr::Region3f> >& bounds) const;
+    void                       bakeProbe(const Ctr::ProbeCapture& capture, size_t probeIndex);
+
+    Ctr::Region3f              _bounds;
+    Ctr::Vector3i              _resolution;
+    Order                      _order;
+    size_t                     _probeCount;
+
+    std::vector<uint16_t>      _coefficients;
+    std::vector<uint8_t>       _dirty;
+    size_t                     _dirtyCount;
+
+    // 2x2 packets of neighbouring texels, consecutive in the array.
+    std::vector<CaptureTexel>  _captureTexels;
+
+    // Mesh bounds as of the last invalidate.
+    std::map<const Ctr::Mesh*, Ctr::Region3f> _meshBounds;
+};
+
+}
+
+#endif
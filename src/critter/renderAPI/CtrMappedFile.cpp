@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrMappedFile.h>
+
+#if !(_WIN32 || _WIN64)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Ctr
+{
+MappedFile::MappedFile() :
+#if _WIN32 || _WIN64
+    _fileHandle(INVALID_HANDLE_VALUE),
+    _mappingHandle(nullptr),
+#else
+    _fileHandle(-1),
+#endif
+    _data(nullptr),
+    _size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#if _WIN32 || _WIN64
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mappingHandle)
+        CloseHandle(_mappingHandle);
+    if (_fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(_fileHandle);
+#else
+    if (_data)
+        munmap((void*)_data, _size);
+    if (_fileHandle >= 0)
+        ::close(_fileHandle);
+#endif
+}
+
+bool
+MappedFile::open(const std::string& pathName)
+{
+#if _WIN32 || _WIN64
+    _fileHandle = CreateFileA(pathName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (_fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        return false;
+    _size = size_t(fileSize.QuadPart);
+
+    _mappingHandle = CreateFileMapping(_fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!_mappingHandle)
+        return false;
+
+    _data = (const uint8_t*)MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+    _fileHandle = ::open(pathName.c_str(), O_RDONLY);
+    if (_fileHandle < 0)
+        return false;
+
+    struct stat fileInfo;
+    if (fstat(_fileHandle, &fileInfo) != 0 || fileInfo.st_size == 0)
+        return false;
+    _size = size_t(fileInfo.st_size);
+
+    void* mapping = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fileHandle, 0);
+    _data = mapping == MAP_FAILED ? nullptr : (const uint8_t*)mapping;
+#endif
+    return _data != nullptr;
+}
+
+const uint8_t*
+MappedFile::data() const
+{
+    return _data;
+}
+
+size_t
+MappedFile::size() const
+{
+    return _size;
+}
+
+}
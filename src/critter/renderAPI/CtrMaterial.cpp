@@ -103,13 +103,7 @@ Material::Material (IDevice* device,
 
 Material::~Material()
 {
-
-// TODO: Check texture against texture manager.
-//    _device->textureMgr()->recycle(_albedoMap);
-//    _device->textureMgr()->recycle(_detailMap);
-//    _device->textureMgr()->recycle(_normalMap);
-//    _device->textureMgr()->recycle(_environmentMap);
-//    _device->textureMgr()->recycle(_specularRMCMap);
+    // The map handles release the textures.
 }
 Ctr::Vector4fProperty*
 Material::textureScaleOffsetProperty()
@@ -407,62 +401,67 @@ Material::passes() const
 void
 Material::setAlbedoMap(Ctr::ITexture* texture)
 {
+    _albedoMapHandle = TextureHandle(_device->textureMgr(), texture);
     _albedoMap->set(texture);
 }
 
 void
 Material::setDetailMap(Ctr::ITexture* texture)
 {
+    _detailMapHandle = TextureHandle(_device->textureMgr(), texture);
     _detailMap->set(texture);
 }
 
 void
 Material::setNormalMap(Ctr::ITexture* texture)
 {
+    _normalMapHandle = TextureHandle(_device->textureMgr(), texture);
     _normalMap->set(texture);
 }
 
 void
 Material::setEnvironmentMap(Ctr::ITexture* texture)
 {
+    _environmentMapHandle = TextureHandle(_device->textureMgr(), texture);
     _environmentMap->set(texture);
 }
 
 void
 Material::setSpecularRMCMap(Ctr::ITexture* texture)
 {
+    _specularRMCMapHandle = TextureHandle(_device->textureMgr(), texture);
     _specularRMCMap->set(texture);
 }
 
 void
 Material::setAlbedoMap(const std::string& filePathName)
 {
-    setAlbedoMap(_device->textureMgr()->loadTexture(filePathName));
+    setAlbedoMap(_device->textureMgr()->loadTextureHandle(filePathName).get());
 }
 
 void
 Material::setDetailMap(const std::string& filePathName)
 {
-    setDetailMap(_device->textureMgr()->loadTexture(filePathName));
+    setDetailMap(_device->textureMgr()->loadTextureHandle(filePathName).get());
 }
 
 void
 Material::setNormalMap(const std::string& filePathName)
 {
     
-    setNormalMap(_device->textureMgr()->loadTexture(filePathName));
+    setNormalMap(_device->textureMgr()->loadTextureHandle(filePathName).get());
 }
 
 void
 Material::setEnvironmentMap(const std::string& filePathName)
 {
-    setEnvironmentMap(_device->textureMgr()->loadTexture(filePathName));
+    setEnvironmentMap(_device->textureMgr()->loadTextureHandle(filePathName).get());
 }
 
 void
 Material::setSpecularRMCMap(const std::string& filePathName)
 {
-    setSpecularRMCMap(_device->textureMgr()->loadTexture(filePathName));
+    setSpecularRMCMap(_device->textureMgr()->loadTextureHandle(filePathName).get());
 }
 
 Ctr::IntProperty*
@@ -44,6 +44,7 @@
 #include <CtrPlatform.h>
 #include <CtrRenderNode.h>
 #include <CtrVector4.h>
+#include <CtrTextureMgr.h>
 
 namespace Ctr
 {
@@ -167,6 +168,13 @@ class Material : public RenderNode
     TextureProperty*            _albedoMap;
     TextureProperty*            _detailMap;
 
+    // References keeping the maps resident.
+    TextureHandle               _specularRMCMapHandle;
+    TextureHandle               _normalMapHandle;
+    TextureHandle               _environmentMapHandle;
+    TextureHandle               _albedoMapHandle;
+    TextureHandle               _detailMapHandle;
+
     // Flags
     Ctr::BoolProperty *         _twoSidedProperty;
     Ctr::FloatProperty *        _textureGammaProperty;
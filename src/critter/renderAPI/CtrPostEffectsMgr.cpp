@@ -47,6 +47,7 @@
 #include <CtrISurface.h>
 #include <CtrHDRPresentationPolicy.h>
 #include <strstream>
+#include <CtrProfiler.h>
 
 namespace Ctr
 {
@@ -232,6 +233,7 @@ PostEffectsMgr::presentationBackBuffer()
 void 
 PostEffectsMgr::render(const Camera* camera) const
 {
+    CTR_PROFILE_ZONE("PostEffectsMgr::render");
     Ctr::DrawMode drawMode = _deviceInterface->getDrawMode ();
     _deviceInterface->setDrawMode (Ctr::Filled);
     uint32_t i = 0;
@@ -0,0 +1,415 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrProbeCapture.h>
+#include <CtrBorderedCubemap.h>
+#include <CtrTextureImage.h>
+#include <CtrITexture.h>
+#include <CtrIRenderResourceParameters.h>
+#include <CtrIndexedMesh.h>
+#include <CtrVertexStream.h>
+#include <CtrMaterial.h>
+#include <CtrMath.h>
+#include <CtrTransformBatch.h>
+#include <CtrLog.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+inline Ctr::Vector3f
+rotate(const Ctr::Matrix44f& transform, const Ctr::Vector3f& origin, const Ctr::Vector3f& direction)
+{
+    return transform.transform(direction) - origin;
+}
+
+inline Ctr::Vector4f
+applyGamma(const Ctr::Vector4f& color, float gamma)
+{
+    return Ctr::Vector4f(std::pow(maxValue(color.x, 0.0f), gamma),
+                         std::pow(maxValue(color.y, 0.0f), gamma),
+                         std::pow(maxValue(color.z, 0.0f), gamma),
+                         color.w);
+}
+
+// texSpherical in IblSinglePassSphericalEnvironment.fx.
+inline Ctr::Vector2f
+sphericalTexCoord(const Ctr::Vector3f& direction)
+{
+    float n = std::sqrt(direction.x * direction.x + direction.z * direction.z);
+    float u = std::acos(clamped(n > 1e-7f ? direction.x / n : 0.0f, -1.0f, 1.0f)) / BB_PI;
+    float v = std::acos(clamped(direction.y, -1.0f, 1.0f)) / BB_PI;
+    u = direction.z > 0.0f ? u * 0.5f : 1.0f - u * 0.5f;
+    return Ctr::Vector2f(1.0f - u, v);
+}
+}
+
+ProbeCapture::ProbeCapture()
+{
+}
+
+ProbeCapture::~ProbeCapture()
+{
+    clear();
+}
+
+void
+ProbeCapture::clear()
+{
+    _bvh.clear();
+    _triangleSurfaces.clear();
+    _texCoords.clear();
+    _mappingDirections.clear();
+    _surfaces.clear();
+    _imageIds.clear();
+
+    for (auto it = _images.begin(); it != _images.end(); it++)
+    {
+        safedelete(*it);
+    }
+    _images.clear();
+
+    for (auto it = _cubemaps.begin(); it != _cubemaps.end(); it++)
+    {
+        safedelete(*it);
+    }
+    _cubemaps.clear();
+}
+
+size_t
+ProbeCapture::triangleCount() const
+{
+    return _bvh.triangleCount();
+}
+
+int32_t
+ProbeCapture::findImage(const Ctr::ITexture* texture, bool cube)
+{
+    if (!texture || !texture->resource())
+        return -1;
+
+    auto found = _imageIds.find(texture);
+    if (found != _imageIds.end())
+        return found->second;
+
+    int32_t imageId = -1;
+    const TextureImageArray& images = texture->resource()->images();
+    if (images.empty() || !images[0] || !images[0]->getData())
+    {
+        LOG("Probe capture has no image data for an albedo map, using the albedo color");
+    }
+    else if (PixelUtil::isCompressed(images[0]->getFormat()))
+    {
+        LOG("Probe capture cannot read compressed albedo maps, using the albedo color");
+    }
+    else if (cube)
+    {
+        const Ctr::TextureImage& source = *images[0];
+        if (source.hasFlag(IF_CUBEMAP) && source.getNumFaces() == BorderedCubemap::FACE_COUNT)
+        {
+            Ctr::TextureImage level;
+            level.create(Ctr::Vector2i((int32_t)source.getWidth(), (int32_t)source.getHeight()),
+                         source.getFormat(), 1, IF_CUBEMAP, false);
+            for (size_t faceId = 0; faceId < BorderedCubemap::FACE_COUNT; faceId++)
+            {
+                PixelUtil::bulkPixelConversion(source.getPixelBox(faceId, 0), level.getPixelBox(faceId, 0));
+            }
+            _cubemaps.push_back(new BorderedCubemap(level));
+            imageId = (int32_t)_cubemaps.size() - 1;
+        }
+    }
+    else
+    {
+        const Ctr::TextureImage& source = *images[0];
+        Image* image = new Image();
+        image->width = source.getWidth();
+        image->height = source.getHeight();
+        image->texels.resize(image->width * image->height);
+        PixelUtil::bulkPixelConversion(source.getPixelBox(0, 0),
+                                       PixelBox(image->width, image->height, 1, PF_FLOAT32_RGBA, &image->texels[0]));
+        _images.push_back(image);
+        imageId = (int32_t)_images.size() - 1;
+    }
+
+    _imageIds[texture] = imageId;
+    return imageId;
+}
+
+void
+ProbeCapture::build(const std::vector<Ctr::Mesh*>& meshes)
+{
+    clear();
+
+    std::vector<Ctr::Vector3f> positions;
+    for (auto it = meshes.begin(); it != meshes.end(); it++)
+    {
+        const Ctr::IndexedMesh* mesh = dynamic_cast<const Ctr::IndexedMesh*>(*it);
+        if (!mesh || !mesh->indices() || !mesh->positionStream())
+            continue;
+
+        const Ctr::VertexStream* positionStream = mesh->positionStream();
+        const Ctr::VertexStream* texCoordStream = mesh->texCoordStream(0);
+        const Ctr::VertexStream* normalStream = mesh->stream(Ctr::NORMAL, 0);
+        const Ctr::Material* material = mesh->material();
+
+        Surface surface;
+        surface.mapping = MappingTexCoord;
+        surface.image = -1;
+        surface.color = Ctr::Vector4f(1, 1, 1, 1);
+        surface.gamma = 1.0f;
+        if (material)
+        {
+            const Ctr::ITexture* albedo = material->albedoMap();
+            if (albedo && albedo->isCubeMap())
+                surface.mapping = MappingCube;
+            else if (material->shaderName().find("Spherical") != std::string::npos)
+                surface.mapping = MappingSpherical;
+
+            surface.color = material->albedoColor();
+            surface.gamma = material->textureGamma();
+            surface.image = findImage(albedo, surface.mapping == MappingCube);
+        }
+
+        uint32_t surfaceId = (uint32_t)_surfaces.size();
+        _surfaces.push_back(surface);
+
+        const Ctr::Matrix44f& world = mesh->worldTransform();
+        Ctr::Vector3f worldOrigin = world.transform(Ctr::Vector3f(0, 0, 0));
+        const uint32_t* indices = mesh->indices();
+        uint32_t vertexCount = positionStream->count();
+
+        // Transform every vertex once rather than once per referencing corner.
+        std::vector<float> worldPositions(vertexCount * 3);
+        for (uint32_t vertexId = 0; vertexId < vertexCount; vertexId++)
+        {
+            const float* position = positionStream->stream() + vertexId * positionStream->stride();
+            worldPositions[vertexId * 3 + 0] = position[0];
+            worldPositions[vertexId * 3 + 1] = position[1];
+            worldPositions[vertexId * 3 + 2] = position[2];
+        }
+        transformPositionStream(world, worldPositions.data(), 3, vertexCount);
+
+        for (uint32_t index = 0; index + 2 < mesh->indexCount(); index += 3)
+        {
+            if (indices[index] >= vertexCount ||
+                indices[index + 1] >= vertexCount ||
+                indices[index + 2] >= vertexCount)
+            {
+                continue;
+            }
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertexId = indices[index + corner];
+                const float* position = positionStream->stream() + vertexId * positionStream->stride();
+                Ctr::Vector3f objectPosition(position[0], position[1], position[2]);
+                const float* worldPosition = &worldPositions[vertexId * 3];
+                positions.push_back(Ctr::Vector3f(worldPosition[0], worldPosition[1], worldPosition[2]));
+
+                Ctr::Vector2f texCoord(0, 0);
+                if (texCoordStream && vertexId < texCoordStream->count())
+                {
+                    const float* source = texCoordStream->stream() + vertexId * texCoordStream->stride();
+                    texCoord = Ctr::Vector2f(source[0], source[1]);
+                }
+                _texCoords.push_back(texCoord);
+
+                // The environment shaders look up by the world space normal (cube)
+                // or the world rotated object position (spherical).
+                Ctr::Vector3f mappingDirection = objectPosition;
+                if (surface.mapping == MappingCube && normalStream && vertexId < normalStream->count())
+                {
+                    const float* normal = normalStream->stream() + vertexId * normalStream->stride();
+                    mappingDirection = Ctr::Vector3f(normal[0], normal[1], normal[2]);
+                }
+                _mappingDirections.push_back(rotate(world, worldOrigin, mappingDirection));
+            }
+            _triangleSurfaces.push_back(surfaceId);
+        }
+    }
+
+    _bvh.build(positions);
+    LOG("Probe capture built " << _bvh.triangleCount() << " triangles from " << _surfaces.size() << " meshes");
+}
+
+Ctr::Vector4f
+ProbeCapture::sampleImage(const Image& image, const Ctr::Vector2f& uv) const
+{
+    // Bilinear with wrap addressing, as the environment samplers.
+    float x = uv.x * image.width - 0.5f;
+    float y = uv.y * image.height - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float tx = x - fx;
+    float ty = y - fy;
+
+    ptrdiff_t width = (ptrdiff_t)image.width;
+    ptrdiff_t height = (ptrdiff_t)image.height;
+    ptrdiff_t x0 = (((ptrdiff_t)fx % width) + width) % width;
+    ptrdiff_t y0 = (((ptrdiff_t)fy % height) + height) % height;
+    ptrdiff_t x1 = (x0 + 1) % width;
+    ptrdiff_t y1 = (y0 + 1) % height;
+
+    const Ctr::Vector4f* texels = &image.texels[0];
+    Ctr::Vector4f top = (1.0f - tx) * texels[y0 * width + x0] + tx * texels[y0 * width + x1];
+    Ctr::Vector4f bottom = (1.0f - tx) * texels[y1 * width + x0] + tx * texels[y1 * width + x1];
+    return (1.0f - ty) * top + ty * bottom;
+}
+
+Ctr::Vector4f
+ProbeCapture::shade(const Ctr::RayHit& hit) const
+{
+    const Surface& surface = _surfaces[_triangleSurfaces[hit.triangle]];
+    if (surface.image < 0)
+        return surface.color;
+
+    float w = 1.0f - hit.u - hit.v;
+    size_t vertexId = hit.triangle * 3;
+    switch (surface.mapping)
+    {
+        case MappingCube:
+        case MappingSpherical:
+        {
+            Ctr::Vector3f direction = w * _mappingDirections[vertexId] +
+                                      hit.u * _mappingDirections[vertexId + 1] +
+                                      hit.v * _mappingDirections[vertexId + 2];
+            direction.normalize();
+            if (surface.mapping == MappingCube)
+                return applyGamma(_cubemaps[surface.image]->sample(direction), surface.gamma);
+            return applyGamma(sampleImage(*_images[surface.image], sphericalTexCoord(direction)), surface.gamma);
+        }
+        default:
+        {
+            Ctr::Vector2f uv(w * _texCoords[vertexId].x + hit.u * _texCoords[vertexId + 1].x + hit.v * _texCoords[vertexId + 2].x,
+                             w * _texCoords[vertexId].y + hit.u * _texCoords[vertexId + 1].y + hit.v * _texCoords[vertexId + 2].y);
+            Ctr::Vector4f albedo = applyGamma(sampleImage(*_images[surface.image], uv), surface.gamma);
+            return Ctr::Vector4f(albedo.x * surface.color.x,
+                                 albedo.y * surface.color.y,
+                                 albedo.z * surface.color.z,
+                                 albedo.w * surface.color.w);
+        }
+    }
+}
+
+Ctr::Vector4f
+ProbeCapture::trace(const Ctr::Vector3f& origin,
+                    const Ctr::Vector3f& direction) const
+{
+    RayHit hit;
+    if (_bvh.intersect(origin, direction, FLT_MAX, hit))
+        return shade(hit);
+    return Ctr::Vector4f(0, 0, 0, 1);
+}
+
+void
+ProbeCapture::trace4(const Ctr::Vector3f& origin,
+                     const Ctr::Vector3f* directions,
+                     Ctr::Vector4f* radiance) const
+{
+    RayHit hits[4];
+    _bvh.intersect4(origin, directions, FLT_MAX, hits);
+    for (uint32_t lane = 0; lane < 4; lane++)
+    {
+        radiance[lane] = hits[lane].valid() ? shade(hits[lane]) : Ctr::Vector4f(0, 0, 0, 1);
+    }
+}
+
+void
+ProbeCapture::capture(const Ctr::Vector3f& center,
+                      const Ctr::Matrix44f& basis,
+                      size_t faceSize,
+                      size_t mipLevels,
+                      Ctr::TextureImage& cubemap,
+                      Ctr::PixelFormat format) const
+{
+    faceSize = maxValue(faceSize, size_t(1));
+    mipLevels = maxValue(mipLevels, size_t(1));
+
+    BorderedCubemap target(faceSize, mipLevels, 1);
+    Ctr::Vector3f basisOrigin = basis.transform(Ctr::Vector3f(0, 0, 0));
+
+    // One job per pair of rows, traced as 2x2 packets of neighbouring texels.
+    size_t rowPairs = (faceSize + 1) / 2;
+    concurrency::parallel_for(size_t(0), size_t(BorderedCubemap::FACE_COUNT) * rowPairs, [&](size_t job)
+    {
+        size_t faceId = job / rowPairs;
+        size_t y = (job % rowPairs) * 2;
+
+        Ctr::Vector3f directions[4];
+        RayHit hits[4];
+        for (size_t x = 0; x < faceSize; x += 2)
+        {
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                size_t texelX = minValue(x + (lane & 1), faceSize - 1);
+                size_t texelY = minValue(y + (lane >> 1), faceSize - 1);
+                Ctr::Vector3f direction = BorderedCubemap::directionFromFace(faceId,
+                                                                             (texelX + 0.5f) / float(faceSize),
+                                                                             (texelY + 0.5f) / float(faceSize));
+                direction = rotate(basis, basisOrigin, direction);
+                direction.normalize();
+                directions[lane] = direction;
+            }
+
+            _bvh.intersect4(center, directions, FLT_MAX, hits);
+
+            for (uint32_t lane = 0; lane < 4; lane++)
+            {
+                size_t texelX = minValue(x + (lane & 1), faceSize - 1);
+                size_t texelY = minValue(y + (lane >> 1), faceSize - 1);
+                Ctr::Vector4f color = hits[lane].valid() ? shade(hits[lane]) : Ctr::Vector4f(0, 0, 0, 1);
+                float* texel = target.texel(faceId, 0, (ptrdiff_t)texelX, (ptrdiff_t)texelY);
+                texel[0] = color.x;
+                texel[1] = color.y;
+                texel[2] = color.z;
+                texel[3] = color.w;
+            }
+        }
+    });
+
+    // Filter the chain from the top level rather than tracing every mip.
+    target.generateMipmaps();
+
+    cubemap.create(Ctr::Vector2i((int32_t)faceSize, (int32_t)faceSize), format, (uint32_t)mipLevels, IF_CUBEMAP, false);
+    target.copyTo(cubemap);
+}
+
+}
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_PROBE_CAPTURE
+#define INCLUDED_CRT_PROBE_CAPTURE
+
+#include <CtrPlatform.h>
+#include <CtrTriangleBvh.h>
+#include <CtrPixelFormat.h>
+#include <CtrVector2.h>
+#include <CtrVector3.h>
+#include <CtrVector4.h>
+#include <CtrMatrix44.h>
+#include <vector>
+#include <map>
+
+namespace Ctr
+{
+class Mesh;
+class ITexture;
+class TextureImage;
+class BorderedCubemap;
+
+// Captures the environment of a probe by ray tracing the scene on the CPU,
+// as an alternative to rendering the cubemap and every one of its mips on
+// the GPU.
+//
+// build collects the triangles of the indexed meshes in the probe pass into
+// a TriangleBvh, along with what is needed to shade them the way the
+// environment shaders do: the albedo map looked up by uv, by a spherical
+// mapping of the object space position (SinglePassSphericalEnvironment) or
+// by the normal for cubemap albedos (SinglePassEnvironment), raised to the
+// texture gamma. Compressed albedo maps fall back to the albedo color.
+//
+// capture traces a ray per texel of each face in packets of 2x2 texels,
+// filters the mips from the top level across the face seams and writes the
+// chain into a cubemap image that can be uploaded with ITexture::writeImage.
+class ProbeCapture
+{
+  public:
+    ProbeCapture();
+    ~ProbeCapture();
+
+    void                       build(const std::vector<Ctr::Mesh*>& meshes);
+    void                       clear();
+
+    size_t                     triangleCount() const;
+
+    // Fills cubemap with a faceSize cube and mipLevels levels.
+    // basis rotates the face directions into world space.
+    void                       capture(const Ctr::Vector3f& center,
+                                       const Ctr::Matrix44f& basis,
+                                       size_t faceSize,
+                                       size_t mipLevels,
+                                       Ctr::TextureImage& cubemap,
+                                       Ctr::PixelFormat format = Ctr::PF_FLOAT32_RGBA) const;
+
+    // Radiance along a ray, black on a miss.
+    Ctr::Vector4f              trace(const Ctr::Vector3f& origin,
+                                     const Ctr::Vector3f& direction) const;
+
+    // Radiance along four rays from a shared origin, traced as a packet.
+    void                       trace4(const Ctr::Vector3f& origin,
+                                      const Ctr::Vector3f* directions,
+                                      Ctr::Vector4f* radiance) const;
+
+  private:
+    enum Mapping
+    {
+        MappingTexCoord,
+        MappingSpherical,
+        MappingCube
+    };
+
+    struct Surface
+    {
+        Mapping                mapping;
+        // Index into _images or _cubemaps, -1 for the albedo color.
+        int32_t                image;
+        Ctr::Vector4f          color;
+        float                  gamma;
+    };
+
+    // Float RGBA copy of the top level of an albedo map.
+    struct Image
+    {
+        size_t                 width;
+        size_t                 height;
+        std::vector<Ctr::Vector4f> texels;
+    };
+
+    int32_t                    findImage(const Ctr::ITexture* texture, bool cube);
+    Ctr::Vector4f              sampleImage(const Image& image, const Ctr::Vector2f& uv) const;
+    Ctr::Vector4f              shade(const Ctr::RayHit& hit) const;
+
+    TriangleBvh                _bvh;
+
+    // Per triangle.
+    std::vector<uint32_t>      _triangleSurfaces;
+    // Per triangle vertex.
+    std::vector<Ctr::Vector2f> _texCoords;
+    std::vector<Ctr::Vector3f> _mappingDirections;
+
+    std::vector<Surface>       _surfaces;
+    std::vector<Image*>        _images;
+    std::vector<BorderedCubemap*> _cubemaps;
+    std::map<const Ctr::ITexture*, int32_t> _imageIds;
+};
+
+}
+
+#endif
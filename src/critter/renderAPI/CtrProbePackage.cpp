@@ -0,0 +1,480 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrProbePackage.h>
+#include <CtrMappedFile.h>
+#include <CtrLog.h>
+#include <CtrMath.h>
+#include <zlib.h>
+#include <ppl.h>
+
+namespace Ctr
+{
+namespace
+{
+// Largest face D3D11 can create, also keeps level sizes from overflowing.
+const uint32_t MaxMapSize = 16384;
+
+inline uint64_t
+alignOffset(uint64_t offset)
+{
+    return (offset + ProbePackage::PackageAlignment - 1) & ~uint64_t(ProbePackage::PackageAlignment - 1);
+}
+
+inline bool
+isAligned(uint64_t offset)
+{
+    return (offset & (ProbePackage::PackageAlignment - 1)) == 0;
+}
+
+// True if count elements of elementSize starting at offset lie inside
+// a file of size bytes. Compared so no term can wrap on a corrupt table.
+inline bool
+fitsInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t size)
+{
+    return offset <= size && count <= (size - offset) / elementSize;
+}
+
+// Bytes of every face of a level.
+inline uint64_t
+levelSize(const ProbePackageMap& map, uint32_t mipmap)
+{
+    size_t width = maxValue(size_t(map.width) >> mipmap, size_t(1));
+    size_t height = maxValue(size_t(map.height) >> mipmap, size_t(1));
+    return uint64_t(PixelUtil::getMemorySize(width, height, 1, (PixelFormat)map.format)) * map.faceCount;
+}
+}
+
+ProbePackage::ProbePackage() :
+    _header(nullptr),
+    _metadata(nullptr),
+    _maps(nullptr),
+    _mips(nullptr)
+{
+}
+
+ProbePackage::~ProbePackage()
+{
+    close();
+}
+
+bool
+ProbePackage::open(const std::string& pathName)
+{
+    close();
+
+    _pathName = pathName;
+    _file.reset(new MappedFile());
+    if (!_file->open(pathName) || _file->size() < sizeof(ProbePackageHeader))
+    {
+        LOG("Failed to map probe package " << pathName);
+        close();
+        return false;
+    }
+
+    const uint8_t* data = _file->data();
+    _header = (const ProbePackageHeader*)data;
+    if (!validate())
+    {
+        LOG("Corrupt or unsupported probe package " << pathName);
+        close();
+        return false;
+    }
+
+    _metadata = (const ProbePackageMetadata*)(data + _header->metadataOffset);
+    _maps = (const ProbePackageMap*)(data + _header->mapTableOffset);
+    _mips = (const ProbePackageMip*)(data + _header->mipTableOffset);
+    _inflated.resize(_header->mipCount);
+    return true;
+}
+
+void
+ProbePackage::close()
+{
+    _inflated.clear();
+    _header = nullptr;
+    _metadata = nullptr;
+    _maps = nullptr;
+    _mips = nullptr;
+    _file.reset();
+}
+
+bool
+ProbePackage::isOpen() const
+{
+    return _header != nullptr;
+}
+
+bool
+ProbePackage::validate() const
+{
+    const uint64_t size = _file->size();
+    const ProbePackageHeader& header = *_header;
+    if (header.magic != Magic ||
+        header.version != Version ||
+        header.alignment != PackageAlignment ||
+        header.fileSize != size)
+        return false;
+
+    if (!isAligned(header.metadataOffset) ||
+        !isAligned(header.mapTableOffset) ||
+        !isAligned(header.mipTableOffset) ||
+        !fitsInFile(header.metadataOffset, 1, sizeof(ProbePackageMetadata), size) ||
+        !fitsInFile(header.mapTableOffset, header.mapCount, sizeof(ProbePackageMap), size) ||
+        !fitsInFile(header.mipTableOffset, header.mipCount, sizeof(ProbePackageMip), size))
+        return false;
+
+    const uint8_t* data = _file->data();
+    const ProbePackageMetadata* metadata = (const ProbePackageMetadata*)(data + header.metadataOffset);
+    if (!memchr(metadata->brdfLut, 0, sizeof(metadata->brdfLut)))
+        return false;
+
+    const ProbePackageMap* maps = (const ProbePackageMap*)(data + header.mapTableOffset);
+    const ProbePackageMip* mips = (const ProbePackageMip*)(data + header.mipTableOffset);
+    for (uint32_t mapId = 0; mapId < header.mapCount; mapId++)
+    {
+        const ProbePackageMap& map = maps[mapId];
+        if (map.type >= ProbeMapTypeCount ||
+            map.range >= ProbeMapRangeCount ||
+            (map.faceCount != 1 && map.faceCount != 6) ||
+            map.width == 0 || map.height == 0 || map.mipCount == 0 ||
+            map.width > MaxMapSize || map.height > MaxMapSize || map.mipCount > 32 ||
+            PixelUtil::getNumElemBytes((PixelFormat)map.format) == 0 ||
+            uint64_t(map.firstMip) + map.mipCount > header.mipCount)
+            return false;
+
+        for (uint32_t mipmap = 0; mipmap < map.mipCount; mipmap++)
+        {
+            const ProbePackageMip& mip = mips[map.firstMip + mipmap];
+            if (!isAligned(mip.offset) ||
+                !fitsInFile(mip.offset, mip.storedSize, 1, size) ||
+                mip.size != levelSize(map, mipmap))
+                return false;
+
+            if ((mip.compression == ProbeMipStored && mip.storedSize != mip.size) ||
+                mip.compression > ProbeMipDeflated)
+                return false;
+        }
+    }
+    return true;
+}
+
+const std::string&
+ProbePackage::pathName() const
+{
+    return _pathName;
+}
+
+const ProbePackageMetadata&
+ProbePackage::metadata() const
+{
+    return *_metadata;
+}
+
+std::string
+ProbePackage::brdfLutPathName() const
+{
+    if (!_metadata || _metadata->brdfLut[0] == 0)
+        return std::string();
+
+    size_t pathEnd = _pathName.find_last_of("/\\");
+    std::string directory = pathEnd == std::string::npos ? std::string() : _pathName.substr(0, pathEnd + 1);
+    return directory + _metadata->brdfLut;
+}
+
+uint32_t
+ProbePackage::mapCount() const
+{
+    return _header ? _header->mapCount : 0;
+}
+
+const ProbePackageMap&
+ProbePackage::map(uint32_t mapId) const
+{
+    return _maps[mapId];
+}
+
+const ProbePackageMap*
+ProbePackage::findMap(ProbeMapType type, ProbeMapRange range) const
+{
+    for (uint32_t mapId = 0; mapId < mapCount(); mapId++)
+    {
+        if (_maps[mapId].type == uint32_t(type) && _maps[mapId].range == uint32_t(range))
+            return &_maps[mapId];
+    }
+    return nullptr;
+}
+
+const ProbePackageMip&
+ProbePackage::mip(const ProbePackageMap& map, uint32_t mipmap) const
+{
+    return _mips[map.firstMip + mipmap];
+}
+
+const uint8_t*
+ProbePackage::mipData(const ProbePackageMap& map,
+                      uint32_t mipmap,
+                      size_t& size) const
+{
+    size = 0;
+    if (!_header || mipmap >= map.mipCount)
+        return nullptr;
+
+    const ProbePackageMip& level = mip(map, mipmap);
+    const uint8_t* stored = _file->data() + level.offset;
+    if (level.compression == ProbeMipStored)
+    {
+        size = size_t(level.size);
+        return stored;
+    }
+
+    std::vector<uint8_t>& inflated = _inflated[map.firstMip + mipmap];
+    if (inflated.empty())
+    {
+        inflated.resize(size_t(level.size));
+        uLongf inflatedSize = uLongf(level.size);
+        if (uncompress(&inflated[0], &inflatedSize, stored, uLong(level.storedSize)) != Z_OK ||
+            inflatedSize != level.size)
+        {
+            LOG("Failed to inflate mip " << mipmap << " of " << _pathName);
+            inflated.clear();
+            return nullptr;
+        }
+    }
+
+    size = inflated.size();
+    return &inflated[0];
+}
+
+bool
+ProbePackage::pixelBox(const ProbePackageMap& map,
+                       uint32_t face,
+                       uint32_t mipmap,
+                       Ctr::PixelBox& box) const
+{
+    if (face >= map.faceCount)
+        return false;
+
+    size_t size = 0;
+    const uint8_t* data = mipData(map, mipmap, size);
+    if (!data)
+        return false;
+
+    size_t faceSize = size / map.faceCount;
+    box = Ctr::PixelBox(maxValue(size_t(map.width) >> mipmap, size_t(1)),
+                        maxValue(size_t(map.height) >> mipmap, size_t(1)),
+                        1,
+                        (PixelFormat)map.format,
+                        (void*)(data + face * faceSize));
+    return true;
+}
+
+ProbePackageWriter::ProbePackageWriter()
+{
+    memset(&_metadata, 0, sizeof(_metadata));
+}
+
+ProbePackageWriter::~ProbePackageWriter()
+{
+}
+
+void
+ProbePackageWriter::setMetadata(const ProbePackageMetadata& metadata)
+{
+    _metadata = metadata;
+}
+
+void
+ProbePackageWriter::addMap(ProbeMapType type,
+                           ProbeMapRange range,
+                           const TextureImagePtr& image)
+{
+    if (!image || image->getWidth() == 0)
+        return;
+
+    MapSource source;
+    source.type = type;
+    source.range = range;
+    source.image = image;
+    _maps.push_back(source);
+}
+
+bool
+ProbePackageWriter::write(const std::string& pathName, bool compress) const
+{
+    struct Section
+    {
+        uint32_t               map;
+        uint32_t               mipmap;
+        size_t                 faceSize;
+        std::vector<uint8_t>   data;
+        ProbePackageMip        mip;
+    };
+
+    ProbePackageHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ProbePackage::Magic;
+    header.version = ProbePackage::Version;
+    header.alignment = ProbePackage::PackageAlignment;
+    header.mapCount = uint32_t(_maps.size());
+
+    std::vector<ProbePackageMap> maps(_maps.size());
+    std::vector<Section> sections;
+    for (uint32_t mapId = 0; mapId < uint32_t(_maps.size()); mapId++)
+    {
+        const TextureImage& image = *_maps[mapId].image;
+        ProbePackageMap& map = maps[mapId];
+        map.type = _maps[mapId].type;
+        map.range = _maps[mapId].range;
+        map.format = image.getFormat();
+        map.width = uint32_t(image.getWidth());
+        map.height = uint32_t(image.getHeight());
+        map.faceCount = uint32_t(image.getNumFaces());
+        map.mipCount = uint32_t(image.getNumLevels());
+        map.firstMip = header.mipCount;
+        header.mipCount += map.mipCount;
+
+        for (uint32_t mipmap = 0; mipmap < map.mipCount; mipmap++)
+        {
+            Section section;
+            section.map = mapId;
+            section.mipmap = mipmap;
+            section.faceSize = image.getPixelBox(0, mipmap).size().x;
+            sections.push_back(section);
+        }
+    }
+
+    // Smallest faces first, so a front to back read streams every map up from
+    // its lowest resolution. Ties keep map order.
+    std::stable_sort(sections.begin(), sections.end(), [](const Section& a, const Section& b)
+    {
+        return a.faceSize < b.faceSize;
+    });
+
+    // Gather the faces of each level and deflate them independently.
+    concurrency::parallel_for(size_t(0), sections.size(), [&](size_t sectionId)
+    {
+        Section& section = sections[sectionId];
+        const ProbePackageMap& map = maps[section.map];
+        const TextureImage& image = *_maps[section.map].image;
+
+        const size_t size = size_t(levelSize(map, section.mipmap));
+        const size_t faceBytes = size / map.faceCount;
+        std::vector<uint8_t> level(size);
+        for (uint32_t face = 0; face < map.faceCount; face++)
+        {
+            PixelBox box = image.getPixelBox(face, section.mipmap);
+            memcpy(&level[face * faceBytes], box.data, faceBytes);
+        }
+
+        memset(&section.mip, 0, sizeof(section.mip));
+        section.mip.size = size;
+        section.mip.compression = ProbeMipStored;
+        if (compress && size <= size_t(UINT_MAX))
+        {
+            uLongf deflatedSize = compressBound(uLong(size));
+            section.data.resize(deflatedSize);
+            if (compress2(&section.data[0], &deflatedSize, &level[0], uLong(size), Z_DEFAULT_COMPRESSION) == Z_OK &&
+                deflatedSize < size - size / 8)
+            {
+                section.data.resize(deflatedSize);
+                section.mip.compression = ProbeMipDeflated;
+            }
+        }
+
+        if (section.mip.compression == ProbeMipStored)
+        {
+            section.data.swap(level);
+        }
+        section.mip.storedSize = section.data.size();
+    });
+
+    header.metadataOffset = alignOffset(sizeof(ProbePackageHeader));
+    header.mapTableOffset = alignOffset(header.metadataOffset + sizeof(ProbePackageMetadata));
+    header.mipTableOffset = alignOffset(header.mapTableOffset + maps.size() * sizeof(ProbePackageMap));
+
+    std::vector<ProbePackageMip> mips(header.mipCount);
+    uint64_t offset = alignOffset(header.mipTableOffset + mips.size() * sizeof(ProbePackageMip));
+    for (auto it = sections.begin(); it != sections.end(); it++)
+    {
+        it->mip.offset = offset;
+        mips[maps[it->map].firstMip + it->mipmap] = it->mip;
+        offset = alignOffset(offset + it->mip.storedSize);
+    }
+    header.fileSize = offset;
+
+    std::ofstream stream(pathName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        LOG("Failed to open " << pathName << " for writing");
+        return false;
+    }
+
+    static const char padding[ProbePackage::PackageAlignment] = {};
+    auto writeAt = [&](uint64_t position, const void* data, size_t size)
+    {
+        uint64_t current = uint64_t(stream.tellp());
+        assert(position >= current && position - current < ProbePackage::PackageAlignment);
+        stream.write(padding, std::streamsize(position - current));
+        stream.write((const char*)data, std::streamsize(size));
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.metadataOffset, &_metadata, sizeof(_metadata));
+    if (!maps.empty())
+        writeAt(header.mapTableOffset, &maps[0], maps.size() * sizeof(ProbePackageMap));
+    if (!mips.empty())
+        writeAt(header.mipTableOffset, &mips[0], mips.size() * sizeof(ProbePackageMip));
+    for (auto it = sections.begin(); it != sections.end(); it++)
+    {
+        writeAt(it->mip.offset, &it->data[0], it->data.size());
+    }
+    writeAt(header.fileSize, nullptr, 0);
+
+    if (!stream)
+    {
+        LOG("Failed to write probe package " << pathName);
+        return false;
+    }
+    return true;
+}
+
+}
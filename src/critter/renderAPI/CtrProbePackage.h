@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_PROBE_PACKAGE
+#define INCLUDED_CRT_PROBE_PACKAGE
+
+#include <CtrPlatform.h>
+#include <CtrPixelFormat.h>
+#include <CtrTextureImage.h>
+
+namespace Ctr
+{
+class MappedFile;
+
+//------------------------------------------------------------
+// Probe package
+//
+// Every map of a baked probe in one file, laid out to be memory
+// mapped at runtime:
+//
+//   ProbePackageHeader
+//   ProbePackageMetadata
+//   ProbePackageMap[mapCount]
+//   ProbePackageMip[mipCount]   mips of map i at map.firstMip + level
+//   mip data
+//
+// Every section and every mip starts on PackageAlignment. Mips
+// hold all faces of a level, one after the other (mip major), and
+// the data is ordered by face size, smallest first, across all
+// maps. Reading the file front to back streams every map from
+// its lowest resolution up. Mips are stored raw or deflated.
+//
+// The file is little endian, as written by the baker.
+//------------------------------------------------------------
+enum ProbeMapType
+{
+    ProbeMapSpecular = 0,
+    ProbeMapDiffuse = 1,
+    ProbeMapEnvironment = 2,
+    ProbeMapTypeCount = 3
+};
+
+enum ProbeMapRange
+{
+    ProbeMapHDR = 0,
+    ProbeMapMDR = 1,
+    ProbeMapRangeCount = 2
+};
+
+enum ProbeMipCompression
+{
+    ProbeMipStored = 0,
+    ProbeMipDeflated = 1
+};
+
+struct ProbePackageHeader
+{
+    uint32_t                   magic;
+    uint32_t                   version;
+    uint32_t                   mapCount;
+    uint32_t                   mipCount;
+    uint64_t                   metadataOffset;
+    uint64_t                   mapTableOffset;
+    uint64_t                   mipTableOffset;
+    uint64_t                   fileSize;
+    uint32_t                   alignment;
+    uint32_t                   reserved[5];
+};
+
+struct ProbePackageMetadata
+{
+    float                      center[3];
+    int32_t                    mipDrop;
+    // Row major, as Matrix44f.
+    float                      basis[16];
+    // L2 radiance of the environment, rgb per coefficient.
+    float                      sh[9][3];
+    // Source statistics.
+    float                      maxPixel[3];
+    float                      environmentScale;
+    int32_t                    sourceResolution;
+    int32_t                    sampleCount;
+    uint32_t                   reserved[2];
+    // Shared BRDF LUT, relative to the package. Null terminated.
+    char                       brdfLut[128];
+};
+
+struct ProbePackageMap
+{
+    uint32_t                   type;
+    uint32_t                   range;
+    uint32_t                   format;
+    uint32_t                   width;
+    uint32_t                   height;
+    uint32_t                   faceCount;
+    uint32_t                   mipCount;
+    uint32_t                   firstMip;
+};
+
+struct ProbePackageMip
+{
+    uint64_t                   offset;
+    uint64_t                   storedSize;
+    uint64_t                   size;
+    uint32_t                   compression;
+    uint32_t                   reserved;
+};
+
+//------------------------------------------------------------
+// ProbePackage
+//
+// Memory maps a package. Faces of stored mips are PixelBox views
+// straight into the mapping. Deflated mips are inflated the first
+// time they are asked for and kept, so views stay valid until the
+// package is closed. Not safe to use from several threads while
+// deflated mips are being inflated.
+//------------------------------------------------------------
+class ProbePackage
+{
+  public:
+    ProbePackage();
+    ~ProbePackage();
+
+    enum
+    {
+        Magic = 0x42525043, // "CPRB"
+        Version = 1,
+        PackageAlignment = 64
+    };
+
+    bool                       open(const std::string& pathName);
+    void                       close();
+    bool                       isOpen() const;
+
+    const std::string&         pathName() const;
+    const ProbePackageMetadata& metadata() const;
+
+    // Shared BRDF LUT resolved against the package directory, empty if none.
+    std::string                brdfLutPathName() const;
+
+    uint32_t                   mapCount() const;
+    const ProbePackageMap&     map(uint32_t mapId) const;
+    const ProbePackageMap*     findMap(ProbeMapType type, ProbeMapRange range) const;
+
+    // Every face of a level, contiguous. Null if the level is corrupt.
+    const uint8_t*             mipData(const ProbePackageMap& map,
+                                       uint32_t mipmap,
+                                       size_t& size) const;
+
+    // One face of a level. False if out of range or corrupt.
+    bool                       pixelBox(const ProbePackageMap& map,
+                                        uint32_t face,
+                                        uint32_t mipmap,
+                                        Ctr::PixelBox& box) const;
+
+  private:
+    bool                       validate() const;
+    const ProbePackageMip&     mip(const ProbePackageMap& map, uint32_t mipmap) const;
+
+    std::string                _pathName;
+    std::unique_ptr<MappedFile> _file;
+    const ProbePackageHeader*  _header;
+    const ProbePackageMetadata* _metadata;
+    const ProbePackageMap*     _maps;
+    const ProbePackageMip*     _mips;
+
+    // Inflated deflated mips, by mip table index.
+    mutable std::vector<std::vector<uint8_t> > _inflated;
+};
+
+//------------------------------------------------------------
+// ProbePackageWriter
+//
+// Collects cube map images and metadata and writes a package.
+// Images are shared, not copied; each is written in its own
+// format with every level it has.
+//------------------------------------------------------------
+class ProbePackageWriter
+{
+  public:
+    ProbePackageWriter();
+    ~ProbePackageWriter();
+
+    void                       setMetadata(const ProbePackageMetadata& metadata);
+    void                       addMap(ProbeMapType type,
+                                      ProbeMapRange range,
+                                      const TextureImagePtr& image);
+
+    // Deflates levels that shrink by at least an eighth when compress is set.
+    bool                       write(const std::string& pathName, bool compress) const;
+
+  private:
+    struct MapSource
+    {
+        ProbeMapType           type;
+        ProbeMapRange          range;
+        TextureImagePtr        image;
+    };
+
+    ProbePackageMetadata       _metadata;
+    std::vector<MapSource>     _maps;
+};
+}
+
+#endif
@@ -245,6 +245,12 @@ enum DeclarationType
     UINT32    = 19
 };
 
+enum IndexFormat
+{
+    INDEX16 = 0,   // 16-bit unsigned indices, for meshes with fewer than 65536 vertices
+    INDEX32 = 1    // 32-bit unsigned indices
+};
+
 enum DeclarationUsage
 {
     POSITION = 0,
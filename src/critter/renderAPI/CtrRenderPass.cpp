@@ -46,6 +46,7 @@
 #include <CtrMesh.h>
 #include <CtrEntity.h>
 #include <CtrScene.h>
+#include <CtrCamera.h>
 #include <CtrMaterial.h>
 
 #include <CtrIDevice.h>
@@ -88,7 +89,8 @@ RenderPass::passName() const
 void 
 RenderPass::renderMeshes(const std::string& passName, const Ctr::Scene* scene)
 {
-    const std::vector<Ctr::Mesh*>& meshes = scene->meshesForPass(passName);
+    const std::vector<Ctr::Mesh*>& meshes = 
+        scene->visibleMeshesForPass(passName, scene->camera()->cameraTransformCache().get());
     for (auto it = meshes.begin(); it != meshes.end(); it++)
     {
         const Ctr::Mesh* mesh = (*it);
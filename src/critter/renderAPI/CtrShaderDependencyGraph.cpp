@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrShaderDependencyGraph.h>
+#include <CtrFileChangeWatcher.h>
+
+namespace Ctr
+{
+namespace
+{
+// Returns the quoted or bracketed path of an #include line, or an empty string.
+std::string
+includePath(const std::string& line)
+{
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        return std::string();
+
+    size_t open = line.find_first_of("\"<", start + 8);
+    if (open == std::string::npos)
+        return std::string();
+
+    size_t close = line.find_first_of(line[open] == '"' ? "\"" : ">", open + 1);
+    if (close == std::string::npos)
+        return std::string();
+
+    return line.substr(open + 1, close - open - 1);
+}
+}
+
+ShaderDependencyGraph::ShaderDependencyGraph()
+{
+}
+
+ShaderDependencyGraph::~ShaderDependencyGraph()
+{
+}
+
+void
+ShaderDependencyGraph::scanIncludes(const std::string& filePathName,
+                                    std::set<std::string>& files)
+{
+    std::string normalized = FileChangeWatcher::normalizePath(filePathName);
+    if (normalized.empty() || !files.insert(normalized).second)
+    {
+        // Already visited, guards against include cycles.
+        return;
+    }
+
+    std::ifstream stream(filePathName.c_str());
+    if (!stream.is_open())
+        return;
+
+    size_t slash = filePathName.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? std::string() : filePathName.substr(0, slash + 1);
+
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::string include = includePath(line);
+        if (include.length() > 0)
+        {
+            // Includes are relative to the including file.
+            scanIncludes(directory + include, files);
+        }
+    }
+}
+
+void
+ShaderDependencyGraph::record(const IRenderResource* resource,
+                              const std::string& filePathName,
+                              const std::string& includeFilePathName)
+{
+    remove(resource);
+
+    std::set<std::string>& files = _dependencies[resource];
+    scanIncludes(filePathName, files);
+    if (includeFilePathName.length() > 0)
+    {
+        scanIncludes(includeFilePathName, files);
+    }
+
+    for (auto it = files.begin(); it != files.end(); it++)
+    {
+        _dependents[*it].insert(resource);
+    }
+}
+
+void
+ShaderDependencyGraph::remove(const IRenderResource* resource)
+{
+    auto dependencyIt = _dependencies.find(resource);
+    if (dependencyIt == _dependencies.end())
+        return;
+
+    for (auto it = dependencyIt->second.begin(); it != dependencyIt->second.end(); it++)
+    {
+        auto dependentIt = _dependents.find(*it);
+        if (dependentIt != _dependents.end())
+        {
+            dependentIt->second.erase(resource);
+            if (dependentIt->second.empty())
+                _dependents.erase(dependentIt);
+        }
+    }
+    _dependencies.erase(dependencyIt);
+}
+
+std::set<const IRenderResource*>
+ShaderDependencyGraph::dependents(const std::set<std::string>& changedFiles) const
+{
+    std::set<const IRenderResource*> resources;
+    for (auto it = changedFiles.begin(); it != changedFiles.end(); it++)
+    {
+        auto dependentIt = _dependents.find(FileChangeWatcher::normalizePath(*it));
+        if (dependentIt != _dependents.end())
+        {
+            resources.insert(dependentIt->second.begin(), dependentIt->second.end());
+        }
+    }
+    return resources;
+}
+
+const std::set<std::string>&
+ShaderDependencyGraph::dependencies(const IRenderResource* resource) const
+{
+    static const std::set<std::string> none;
+    auto it = _dependencies.find(resource);
+    return it != _dependencies.end() ? it->second : none;
+}
+
+}
@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_SHADER_DEPENDENCY_GRAPH
+#define INCLUDED_CRT_SHADER_DEPENDENCY_GRAPH
+
+#include <CtrPlatform.h>
+
+namespace Ctr
+{
+class IRenderResource;
+
+//------------------------------------------------------------
+// ShaderDependencyGraph
+//
+// Records which source files each shader, compute shader and
+// brdf include was built from, so that a file change reloads
+// exactly the resources that depend on it.
+// All paths are stored normalized (FileChangeWatcher::normalizePath).
+//------------------------------------------------------------
+class ShaderDependencyGraph
+{
+  public:
+    ShaderDependencyGraph();
+    ~ShaderDependencyGraph();
+
+    //----------------------------------------------------------
+    // Records the source and include files of a resource, and
+    // every file they #include, replacing what was there before.
+    //----------------------------------------------------------
+    void                       record(const IRenderResource* resource,
+                                      const std::string& filePathName,
+                                      const std::string& includeFilePathName);
+
+    void                       remove(const IRenderResource* resource);
+
+    //----------------------------------------------------------
+    // Resources that depend on any of the changed files.
+    //----------------------------------------------------------
+    std::set<const IRenderResource*> dependents(const std::set<std::string>& changedFiles) const;
+
+    const std::set<std::string>&     dependencies(const IRenderResource* resource) const;
+
+    //----------------------------------------------------------
+    // Adds filePathName and (recursively) its #include files.
+    //----------------------------------------------------------
+    static void                scanIncludes(const std::string& filePathName,
+                                            std::set<std::string>& files);
+
+  private:
+    std::map<std::string, std::set<const IRenderResource*> > _dependents;
+    std::map<const IRenderResource*, std::set<std::string> > _dependencies;
+};
+}
+
+#endif
@@ -48,7 +48,9 @@
 #include <CtrAssetManager.h>
 #include <CtrEntity.h>
 #include <CtrFileChangeWatcher.h>
+#include <CtrShaderDependencyGraph.h>
 #include <direct.h>
+#include <ppl.h>
 
 namespace Ctr
 {
@@ -57,6 +59,7 @@ ShaderMgr::ShaderMgr(Ctr::IDevice* device) :
     _deviceInterface(device)
 {
     _fileChangeWatcher.reset(new FileChangeWatcher());
+    _dependencyGraph.reset(new ShaderDependencyGraph());
 
     // Load the user shader manifest
     std::string filename = "data/ShaderManifest.xml";
@@ -160,6 +163,7 @@ ShaderMgr::addShader(const std::string& filename,
         {
             LOG ("Created shader " << filePathName.c_str() << " and adding to shader mgr");
             _shaderList.insert(std::make_pair(Ctr::Hash(filePathName), shader));
+            trackDependencies(shader);
             return true;
         }
         else
@@ -173,66 +177,83 @@ ShaderMgr::addShader(const std::string& filename,
 void
 ShaderMgr::update()
 {
-    if (_fileChangeWatcher->hasChanges())
+    if (!_fileChangeWatcher->hasChanges())
+        return;
+
+    std::set<std::string> changed = _fileChangeWatcher->changeList();
+    for (auto it = changed.begin(); it != changed.end(); it++)
     {
-        std::set<std::string> changed = _fileChangeWatcher->changeList();
-        for (auto it = changed.begin(); it != changed.end(); it++)
-        {
-            LOG("Detected change: " << *it);
-        }
+        LOG("Detected change: " << *it);
+    }
 
-        for (auto it = _shaderList.begin(); it != _shaderList.end(); it++)
-        {
-            LOG("Have shader " << (*it).second->filePathName());
-            // Shader stores a relative path. We just want to rfind the path
-            // For the moment to detect a modified shader.
-            for (auto cit = changed.begin(); cit != changed.end(); cit++)
-            {
-                // Shader name
-                if ((*cit).rfind((*it).second->filePathName()) != std::string::npos)
-                {
-                    LOG("Reloading " << (*it).second->filePathName());
-                    (*it).second->free();
-                    (*it).second->create();
-                }
-                // Include name
-                else if ((*it).second->includeFilePathName().length() > 0)
-                { 
-                    if ((*cit).rfind((*it).second->includeFilePathName()))
-                    {
-                        (*it).second->free();
-                        (*it).second->create();
-                    }
-                }
-            }
-        }
+    // Only the shaders (and brdf includes) built from a changed file.
+    std::set<const IRenderResource*> dependents = _dependencyGraph->dependents(changed);
+    if (dependents.empty())
+        return;
 
-        for (auto it = _computeShaderList.begin(); it != _computeShaderList.end(); it++)
-        {
-            LOG("Have compute shader " << it->second->filePathName());
-            // ComputeShader stores a relative path. We just want to rfind the path
-            // For the moment to detect a modified shader.
-            for (auto cit = changed.begin(); cit != changed.end(); cit++)
-            {
-                if ((*cit).rfind(it->second->filePathName()) != std::string::npos ||
-                    (*cit).rfind((it)->second->includePathName()) != std::string::npos)
-                {
-                    LOG("Reloading " << it->second->filePathName());
-                    it->second->free();
-                    it->second->create();
-                }
-                else if ((it)->second->includePathName().length() > 0)
-                {
-                    if ((*cit).rfind((it)->second->includePathName()) != std::string::npos)
-                    {
-                        LOG("Reloading " << it->second->filePathName());
-                        it->second->free();
-                        it->second->create();
-                    }
-                }
-            }
-        }
+    std::vector<IShader*> shaders;
+    for (auto it = _shaderList.begin(); it != _shaderList.end(); it++)
+    {
+        if (dependents.find(it->second) != dependents.end())
+            shaders.push_back(it->second);
+    }
 
+    std::vector<IComputeShader*> computeShaders;
+    for (auto it = _computeShaderList.begin(); it != _computeShaderList.end(); it++)
+    {
+        if (dependents.find(it->second) != dependents.end())
+            computeShaders.push_back(it->second);
+    }
+
+    // Compilation dominates, so only it runs on the worker pool. Reading the
+    // source and creating the effect (which loads textures) stay on this thread.
+    // Brdf luts pick up the rebuilt compute shader through its hash.
+    for (auto it = shaders.begin(); it != shaders.end(); it++)
+    {
+        (*it)->free();
+        (*it)->loadSource();
+    }
+    for (auto it = computeShaders.begin(); it != computeShaders.end(); it++)
+    {
+        (*it)->free();
+        (*it)->loadSource();
+    }
+
+    size_t shaderCount = shaders.size();
+    std::vector<uint8_t> compiled(shaderCount + computeShaders.size(), 0);
+    concurrency::parallel_for(size_t(0), compiled.size(), [&](size_t resourceId)
+    {
+        if (resourceId < shaderCount)
+            compiled[resourceId] = shaders[resourceId]->compileSource();
+        else
+            compiled[resourceId] = computeShaders[resourceId - shaderCount]->compileSource();
+    });
+
+    for (size_t shaderId = 0; shaderId < shaderCount; shaderId++)
+    {
+        if (compiled[shaderId])
+            shaders[shaderId]->finishCreate();
+    }
+    for (size_t shaderId = 0; shaderId < computeShaders.size(); shaderId++)
+    {
+        if (compiled[shaderCount + shaderId])
+            computeShaders[shaderId]->finishCreate();
+    }
+
+    // Includes may have changed with the source.
+    for (auto it = shaders.begin(); it != shaders.end(); it++)
+    {
+        LOG("Reloaded " << (*it)->filePathName());
+        trackDependencies(*it);
+    }
+    for (auto it = computeShaders.begin(); it != computeShaders.end(); it++)
+    {
+        LOG("Reloaded " << (*it)->filePathName());
+        trackDependencies(*it);
+    }
+
+    if (shaders.size() > 0)
+    {
         for (auto it = _trackedMeshes.begin(); it != _trackedMeshes.end(); it++)
         {
             resolveShaders(*it);
@@ -240,6 +261,24 @@ ShaderMgr::update()
     }
 }
 
+bool
+ShaderMgr::hasPendingChanges() const
+{
+    return _fileChangeWatcher->hasChanges();
+}
+
+void
+ShaderMgr::trackDependencies(const IShader* shader)
+{
+    _dependencyGraph->record(shader, shader->filePathName(), shader->includeFilePathName());
+}
+
+void
+ShaderMgr::trackDependencies(const IComputeShader* shader)
+{
+    _dependencyGraph->record(shader, shader->filePathName(), shader->includePathName());
+}
+
 bool
 ShaderMgr::addComputeShaderFromFile (const std::string& filename,
                                      const std::string& includeFilename,
@@ -275,6 +314,7 @@ ShaderMgr::addComputeShaderFromFile (const std::string& filename,
             LOG ("Created compute shader " << filePathName.c_str() << " and adding to shader mgr");
             
             _computeShaderList.insert(std::make_pair(stream.str(), shader));            
+            trackDependencies(shader);
             shaderOut = shader;
             return true;
         }
@@ -354,6 +394,7 @@ ShaderMgr::addShader(const std::string& filename,
                 // LOG ("Shader created successfully from " << filePathName);
                 // TODO: fix hash!                
                 _shaderList.insert(std::make_pair(Ctr::Hash(filePathName+includeFileName), tshader));
+                trackDependencies(tshader);
                 shader = tshader;
                 return true;
             }
@@ -386,6 +427,7 @@ ShaderMgr::addShader(const std::string& filename,
                 // LOG ("Shader created successfully from " << filePathName);
                 // TODO: Fix hash!
                 _shaderList.insert(std::make_pair(Ctr::Hash(filePathName), tshader));
+                trackDependencies(tshader);
 
                 shader = tshader;
                 return true;
@@ -434,6 +476,7 @@ ShaderMgr::addShader(const std::string& filename,
                 // TODO: Fix hash!
 
                 _shaderList.insert(std::make_pair(Ctr::Hash(filePathKeyName), tshader));
+                trackDependencies(tshader);
                 shader = tshader;
                 return true;
             }
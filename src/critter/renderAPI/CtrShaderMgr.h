@@ -54,6 +54,7 @@ class IComputeShader;
 class GpuTechnique;
 class IDevice;
 class FileChangeWatcher;
+class ShaderDependencyGraph;
 class Mesh;
 
 class ShaderMgr
@@ -73,6 +74,12 @@ class ShaderMgr
 
     void                        update();
 
+    //-------------------------------------------------
+    // True when watched shader sources changed on disk
+    // and the next update() will reload dependents.
+    //-------------------------------------------------
+    bool                        hasPendingChanges() const;
+
     //--------------------------------
     // Create a shader from a filename
     //--------------------------------
@@ -160,6 +167,13 @@ class ShaderMgr
 
     bool                       addShaderFromManifest(const std::string& shaderName);
 
+    //--------------------------------------------------
+    // Records the files a shader was built from so that
+    // update() can reload exactly its dependents.
+    //--------------------------------------------------
+    void                       trackDependencies(const IShader* shader);
+    void                       trackDependencies(const IComputeShader* shader);
+
   private:
     Ctr::IDevice*              _deviceInterface;
     ComputeShaderList          _computeShaderList;
@@ -167,6 +181,7 @@ class ShaderMgr
 
     std::map<std::string, std::string> _shaderNameManifest;
     std::unique_ptr<FileChangeWatcher> _fileChangeWatcher;
+    std::unique_ptr<ShaderDependencyGraph> _dependencyGraph;
     std::set<Mesh*>                    _trackedMeshes;
 };
 }
@@ -244,7 +244,12 @@ enum ShaderParameter
     UserAlbedo, 
     UserRM,
     IblOccl,
-    TextureScaleOffset
+    TextureScaleOffset,
+
+    // Vertex dequantization.
+    VertexPositionScale,
+    VertexPositionOffset,
+    VertexNormalEncoding
 };
 
 enum ParameterScope
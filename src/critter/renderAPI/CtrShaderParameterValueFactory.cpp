@@ -65,7 +65,8 @@ namespace Ctr
 class IShaderParameterFactory 
 {
   public:
-    virtual bool                  supports (GpuVariable* variable) const = 0;
+    virtual ~IShaderParameterFactory() {}
+    virtual SymbolId              semantic () const = 0;
     virtual ShaderParameterValue* make (GpuVariable* variable,
                                         Ctr::IEffect* effect) = 0;
 };
@@ -98,9 +99,9 @@ class WorldMatrixValue :  public ShaderParameterValue
         _variable->setMatrix((const float*)&world);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "WORLD")==0;
+        return "WORLD";
     }
 };
 
@@ -119,9 +120,9 @@ class MeshGroupIdValue :  public ShaderParameterValue
         _variable->set((const uint32_t*)&groupId, sizeof(uint32_t));
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "MESHGROUPID")==0;
+        return "MESHGROUPID";
     }
 };
 
@@ -136,18 +137,15 @@ class WorldViewProjectionValue :  public ShaderParameterValue
 
     virtual void setParam (const Ctr::RenderRequest& request) const
     {
-        Ctr::Matrix44f world = request.mesh->worldTransform();
+        const Ctr::CameraTransformCachePtr& ctc = request.camera->cameraTransformCache();
+        const Ctr::Matrix44f worldViewProj = request.mesh->worldTransform() * ctc->viewProjMatrix();
 
-        const Ctr::CameraTransformCachePtr ctc = request.camera->cameraTransformCache();
-        const Ctr::Matrix44f& viewProj = ctc->viewProjMatrix();
-        world = world * viewProj;
-
-        _variable->setMatrix((const float*)&world);
+        _variable->setMatrix((const float*)&worldViewProj);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "WORLDVIEWPROJECTION")==0;
+        return "WORLDVIEWPROJECTION";
     }
 };
 
@@ -169,9 +167,9 @@ public:
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "USERALBEDO") == 0;
+        return "USERALBEDO";
     }
 };
 
@@ -193,9 +191,9 @@ public:
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "USERRM") == 0;
+        return "USERRM";
     }
 };
 
@@ -218,9 +216,9 @@ public:
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLOCCL") == 0;
+        return "IBLOCCL";
     }
 };
 
@@ -241,9 +239,9 @@ public:
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "DETAILMAP") == 0;
+        return "DETAILMAP";
     }
 
 };
@@ -265,9 +263,9 @@ class MaterialDiffuseValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "MATERIALDIFFUSE")==0;
+        return "MATERIALDIFFUSE";
     }
 };
 
@@ -289,9 +287,9 @@ class SpecularIntensityValue : public ShaderParameterValue
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "SPECULARINTENSITY") == 0;
+        return "SPECULARINTENSITY";
     }
 };
 
@@ -313,9 +311,9 @@ class RoughnessScaleValue : public ShaderParameterValue
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "ROUGHNESSSCALE") == 0;
+        return "ROUGHNESSSCALE";
     }
 };
 
@@ -364,9 +362,9 @@ class SpecularWorkflowValue : public ShaderParameterValue
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "SPECULARWORKFLOW") == 0;
+        return "SPECULARWORKFLOW";
     }
 };
 
@@ -387,9 +385,9 @@ class ViewProjectionValue :  public ShaderParameterValue
         _variable->setMatrix((const float*)&viewProj);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "VIEWPROJECTION")==0;
+        return "VIEWPROJECTION";
     }
 };
 
@@ -410,9 +408,9 @@ class ProjectionValue :  public ShaderParameterValue
         _variable->setMatrix((const float*)&projection);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "PROJECTION")==0;
+        return "PROJECTION";
     }
 };
 
@@ -441,9 +439,9 @@ class ScreenSizeValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "SCREENSIZE")==0;
+        return "SCREENSIZE";
     }
 };
 
@@ -465,9 +463,9 @@ class ViewValue :  public ShaderParameterValue
         _variable->setMatrix ((const float*)&matrix);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "VIEW")==0;
+        return "VIEW";
     }
 };
 
@@ -492,9 +490,9 @@ class ViewRightValue :  public ShaderParameterValue
         _variable->setVector((const float*)&right4);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "VIEWRIGHT")==0;
+        return "VIEWRIGHT";
     }
 };
 
@@ -521,9 +519,9 @@ class ViewUpValue :  public ShaderParameterValue
         _variable->setVector((const float*)&up4);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "VIEWUP")==0;
+        return "VIEWUP";
     }
 };
 
@@ -544,9 +542,9 @@ class ViewLookAtValue :  public ShaderParameterValue
         _variable->setVector((const float*)&normalized);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "VIEWLOOKAT")==0;
+        return "VIEWLOOKAT";
     }
 };
 
@@ -561,16 +559,13 @@ class WorldViewValue :  public ShaderParameterValue
 
     virtual void setParam (const Ctr::RenderRequest& request) const
     {
-        const Ctr::CameraTransformCachePtr ctc = request.camera->cameraTransformCache();
-        const Ctr::Matrix44f& matView = ctc->viewMatrix();
-
-        Ctr::Matrix44f matrix = request.mesh->worldTransform() * request.camera->viewMatrix();                    
+        const Ctr::Matrix44f matrix = request.mesh->worldTransform() * request.camera->viewMatrix();
         _variable->setMatrix((const float*)&matrix);
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "WORLDVIEW")==0;
+        return "WORLDVIEW";
     }
 };
 
@@ -603,9 +598,9 @@ class SpecularRMCMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "GLOSSMAP")==0;
+        return "GLOSSMAP";
     }
 };
 
@@ -628,9 +623,9 @@ class RenderDebugTermValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "RENDERDEBUGTERM")==0;
+        return "RENDERDEBUGTERM";
     }
 };
 
@@ -657,9 +652,9 @@ class DiffuseMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "DIFFUSEMAP")==0;
+        return "DIFFUSEMAP";
     }
 };
 
@@ -685,9 +680,9 @@ class NormalMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "NORMALMAP")==0;
+        return "NORMALMAP";
     }
 };
 
@@ -709,9 +704,9 @@ class TextureGammaValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TEXTUREGAMMA")==0;
+        return "TEXTUREGAMMA";
     }
 };
 
@@ -741,9 +736,9 @@ class EyeLocationValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "EYELOCATION")==0;
+        return "EYELOCATION";
     }
 };
 
@@ -764,9 +759,9 @@ class CameraZNearValue : public ShaderParameterValue
         _variable->set (&value, sizeof(float));
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "CAMERAZNEAR")==0;
+        return "CAMERAZNEAR";
     }
 };
 
@@ -786,9 +781,9 @@ class CameraZFarValue : public ShaderParameterValue
         _variable->set (&value, sizeof(float));
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "CAMERAZFAR")==0;
+        return "CAMERAZFAR";
     }
 };
 
@@ -809,9 +804,9 @@ class IBLBrdfValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLBRDF")==0;
+        return "IBLBRDF";
     }
 };
 
@@ -835,9 +830,9 @@ class IBLDiffuseProbeMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLDIFFUSEPROBE")==0;
+        return "IBLDIFFUSEPROBE";
     }
 };
 
@@ -888,9 +883,9 @@ public:
 		_variable->setMatrixArray((const float*)&cubeViews[0], 6);
 	}
 
-	static bool supports(GpuVariable* variable)
+	static const char* semantic()
 	{
-		return _strcmpi((char*)variable->semantic().c_str(), "CUBEVIEWS") == 0;
+		return "CUBEVIEWS";
 	}
 
 };
@@ -915,9 +910,9 @@ class IBLSpecularProbeMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLSPECULARPROBE")==0;
+        return "IBLSPECULARPROBE";
     }
 };
 
@@ -940,9 +935,9 @@ class IBLSourceEnvironmentScaleValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLSOURCEENVIRONMENTSCALE")==0;
+        return "IBLSOURCEENVIRONMENTSCALE";
     }
 };
 
@@ -966,9 +961,9 @@ class IBLSpecularMipDeltasValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLSPECULARMIPDELTAS")==0;
+        return "IBLSPECULARMIPDELTAS";
     }
 };
 
@@ -992,9 +987,9 @@ class IBLSourceMipCountValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLSOURCEMIPCOUNT")==0;
+        return "IBLSOURCEMIPCOUNT";
     }
 };
 
@@ -1020,9 +1015,9 @@ class IBLCorrectionValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLCORRECTION")==0;
+        return "IBLCORRECTION";
     }
 };
 
@@ -1045,9 +1040,75 @@ public:
         }
     }
 
-    static bool supports(GpuVariable* variable)
+    static const char* semantic()
+    {
+        return "TEXTURESCALEOFFSET";
+    }
+};
+
+class VertexPositionScaleValue : public ShaderParameterValue
+{
+public:
+    VertexPositionScaleValue(const GpuVariable* variable, Ctr::IEffect*effect) :
+        ShaderParameterValue(variable, effect)
+    {
+        setParameterScope(PerMesh);
+        setParameterType(VertexPositionScale);
+    }
+
+    virtual void setParam(const Ctr::RenderRequest& request) const
+    {
+        const Ctr::Vector4f& scale = request.mesh->positionScale();
+        _variable->setVector((const float*)&scale.x);
+    }
+
+    static const char* semantic()
+    {
+        return "VERTEXPOSITIONSCALE";
+    }
+};
+
+class VertexPositionOffsetValue : public ShaderParameterValue
+{
+public:
+    VertexPositionOffsetValue(const GpuVariable* variable, Ctr::IEffect*effect) :
+        ShaderParameterValue(variable, effect)
+    {
+        setParameterScope(PerMesh);
+        setParameterType(VertexPositionOffset);
+    }
+
+    virtual void setParam(const Ctr::RenderRequest& request) const
+    {
+        const Ctr::Vector4f& offset = request.mesh->positionOffset();
+        _variable->setVector((const float*)&offset.x);
+    }
+
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TEXTURESCALEOFFSET") == 0;
+        return "VERTEXPOSITIONOFFSET";
+    }
+};
+
+class VertexNormalEncodingValue : public ShaderParameterValue
+{
+public:
+    VertexNormalEncodingValue(const GpuVariable* variable, Ctr::IEffect*effect) :
+        ShaderParameterValue(variable, effect)
+    {
+        setParameterScope(PerMesh);
+        setParameterType(VertexNormalEncoding);
+    }
+
+    virtual void setParam(const Ctr::RenderRequest& request) const
+    {
+        float octahedral = request.mesh->octahedralNormals() ? 1.0f : 0.0f;
+        _variable->set(&octahedral, sizeof(float));
+    }
+
+    static const char* semantic()
+    {
+        return "VERTEXNORMALENCODING";
     }
 };
 
@@ -1073,9 +1134,9 @@ class IBLMaxValueValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "IBLMAXVALUE")==0;
+        return "IBLMAXVALUE";
     }
 };
 
@@ -1102,9 +1163,9 @@ class EnvironmentMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "ENVIRONMENTMAP")==0;
+        return "ENVIRONMENTMAP";
     }
 };
 
@@ -1129,9 +1190,9 @@ class TextureFunctionParameterValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TEXTUREFUNCTION")==0;
+        return "TEXTUREFUNCTION";
     }
 };
 
@@ -1155,9 +1216,9 @@ class ExposureParameterValue :  public ShaderParameterValue
         _variable->set (&value, sizeof(float));
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "EXPOSURE")==0;
+        return "EXPOSURE";
     }
 };
 
@@ -1177,9 +1238,9 @@ class GammaParameterValue :  public ShaderParameterValue
         _variable->set (&value, sizeof(float));
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "GAMMA")==0;
+        return "GAMMA";
     }
 };
 
@@ -1203,9 +1264,9 @@ class PostProcessMapValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "POSTPROCESSMAP")==0;
+        return "POSTPROCESSMAP";
     }
 };
 
@@ -1231,14 +1292,9 @@ class TextureInputValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        static std::string textureInputSemantic = "TEXTUREINPUT";
-        if (variable->semantic() == textureInputSemantic)
-        {
-            return true;
-        }
-        return false;
+        return "TEXTUREINPUT";
     }
 };
 
@@ -1264,14 +1320,9 @@ class TextureInputSizeValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        static std::string textureInputSemantic = "TEXTUREINPUTSIZE";
-        if (variable->semantic() == textureInputSemantic)
-        {
-            return true;
-        }
-        return false;
+        return "TEXTUREINPUTSIZE";
     }
 };
 
@@ -1297,14 +1348,9 @@ class TextureInputWidthValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        static std::string textureInputSemantic = "TEXTUREINPUTWIDTH";
-        if (variable->semantic() == textureInputSemantic)
-        {
-            return true;
-        }
-        return false;
+        return "TEXTUREINPUTWIDTH";
     }
 };
 
@@ -1330,14 +1376,9 @@ class TextureInputHeightValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        static std::string textureInputSemantic = "TEXTUREINPUTHEIGHT";
-        if (variable->semantic() == textureInputSemantic)
-        {
-            return true;
-        }
-        return false;
+        return "TEXTUREINPUTHEIGHT";
     }
 };
 
@@ -1371,9 +1412,9 @@ class TargetTextureSizeValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TARGETTEXTURESIZE")==0;
+        return "TARGETTEXTURESIZE";
     }
 };
 
@@ -1405,9 +1446,9 @@ class TargetTextureWidthValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TARGETTEXTUREWIDTH")==0;
+        return "TARGETTEXTUREWIDTH";
     }
 };
 
@@ -1438,9 +1479,9 @@ class TargetTextureHeightValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "TARGETTEXTUREHEIGHT")==0;
+        return "TARGETTEXTUREHEIGHT";
     }
 };
 
@@ -1462,9 +1503,9 @@ class BackBufferWidthValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "BACKBUFFERWIDTH")==0;
+        return "BACKBUFFERWIDTH";
     }
 };
 
@@ -1486,9 +1527,9 @@ class BackBufferHeightValue :  public ShaderParameterValue
         }
     }
 
-    static bool supports (GpuVariable* variable)
+    static const char* semantic()
     {
-        return _strcmpi((char*)variable->semantic().c_str(), "BACKBUFFERHEIGHT")==0;
+        return "BACKBUFFERHEIGHT";
     }
 };
 
@@ -1509,9 +1550,10 @@ ShaderParameterValueFactory::~ShaderParameterValueFactory()
     
     for (auto it = _parameters.begin(); it != _parameters.end(); it++)
     {
-        IShaderParameterFactory* parameter = *it;
+        IShaderParameterFactory* parameter = it->second;
         safedelete (parameter);
     }
+    _parameters.clear();
 
     _managedValues.clear();
 }
@@ -1531,6 +1573,7 @@ ShaderParameterValueFactory::cache()
 bool
 ShaderParameterValueFactory::free()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     for (auto it = _managedValues.begin(); it != _managedValues.end(); it++)
     {
         ShaderParameterValue * shaderValue = *it;
@@ -1544,11 +1587,14 @@ template <class T>
 class ShaderParameterFactory : public IShaderParameterFactory
 {
   public:
-    ShaderParameterFactory() {};
+    ShaderParameterFactory() :
+        _semantic (Symbol::internNoCase(T::semantic()))
+    {
+    };
 
-    virtual bool supports (GpuVariable* variable) const
+    virtual SymbolId semantic () const
     {
-        return T::supports(variable);
+        return _semantic;
     }
 
     virtual ShaderParameterValue * make (GpuVariable* variable,
@@ -1561,11 +1607,28 @@ class ShaderParameterFactory : public IShaderParameterFactory
         }
         return nullptr;
     }
+
+  private:
+    SymbolId _semantic;
 };
 
+void
+ShaderParameterValueFactory::addFactory (IShaderParameterFactory* factory)
+{
+    IShaderParameterFactory* existing = nullptr;
+    if (_parameters.find (factory->semantic(), existing))
+    {
+        LOG ("Duplicate shader parameter factory for semantic " << Symbol::name(factory->semantic()));
+        safedelete (factory);
+        return;
+    }
+    _parameters.insert (factory->semantic(), factory);
+}
+
 void
 ShaderParameterValueFactory::removeShaderParameterValue(const ShaderParameterValue* value)
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     for (auto it = _managedValues.begin(); it != _managedValues.end(); it++)
     {
         if (*it == value)
@@ -1583,79 +1646,81 @@ ShaderParameterValueFactory::createShaderParameterValue (Ctr::IDevice* device,
                                                          GpuVariable* variable, 
                                                          Ctr::IEffect*effect)
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
 
     if (_parameters.size() == 0)
     {
-        _parameters.insert (new ShaderParameterFactory <WorldMatrixValue>);
-        _parameters.insert (new ShaderParameterFactory <WorldViewProjectionValue>);
-        _parameters.insert (new ShaderParameterFactory <ViewProjectionValue>());
-        _parameters.insert (new ShaderParameterFactory <ProjectionValue>);
-        _parameters.insert (new ShaderParameterFactory <WorldViewValue>());
-		_parameters.insert(new ShaderParameterFactory <CubeViewsValue>());
+        addFactory (new ShaderParameterFactory <WorldMatrixValue>);
+        addFactory (new ShaderParameterFactory <WorldViewProjectionValue>);
+        addFactory (new ShaderParameterFactory <ViewProjectionValue>());
+        addFactory (new ShaderParameterFactory <ProjectionValue>);
+        addFactory (new ShaderParameterFactory <WorldViewValue>());
+		addFactory (new ShaderParameterFactory <CubeViewsValue>());
 		
-        _parameters.insert (new ShaderParameterFactory <DiffuseMapValue>());
-        _parameters.insert (new ShaderParameterFactory <RenderDebugTermValue>());
+        addFactory (new ShaderParameterFactory <DiffuseMapValue>());
+        addFactory (new ShaderParameterFactory <RenderDebugTermValue>());
         
-        _parameters.insert (new ShaderParameterFactory <NormalMapValue>());
-        _parameters.insert (new ShaderParameterFactory <SpecularRMCMapValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureGammaValue>());
-        _parameters.insert (new ShaderParameterFactory <EnvironmentMapValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLCorrectionValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLMaxValueValue>());
+        addFactory (new ShaderParameterFactory <NormalMapValue>());
+        addFactory (new ShaderParameterFactory <SpecularRMCMapValue>());
+        addFactory (new ShaderParameterFactory <TextureGammaValue>());
+        addFactory (new ShaderParameterFactory <EnvironmentMapValue>());
+        addFactory (new ShaderParameterFactory <IBLCorrectionValue>());
+        addFactory (new ShaderParameterFactory <IBLMaxValueValue>());
         
-        _parameters.insert (new ShaderParameterFactory <PostProcessMapValue>());
-        _parameters.insert (new ShaderParameterFactory <ViewUpValue>());
-        _parameters.insert (new ShaderParameterFactory <ViewRightValue>());
-        _parameters.insert (new ShaderParameterFactory <ViewLookAtValue>());
-        _parameters.insert (new ShaderParameterFactory <ViewValue>());
-        _parameters.insert (new ShaderParameterFactory <ExposureParameterValue>());
-        _parameters.insert (new ShaderParameterFactory <GammaParameterValue>());
-        _parameters.insert (new ShaderParameterFactory <ScreenSizeValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureFunctionParameterValue>());
-        _parameters.insert (new ShaderParameterFactory <TargetTextureSizeValue>());
-        _parameters.insert (new ShaderParameterFactory <TargetTextureWidthValue>());
-        _parameters.insert (new ShaderParameterFactory <TargetTextureHeightValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureInputValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureInputSizeValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureInputWidthValue>());
-        _parameters.insert (new ShaderParameterFactory <TextureInputHeightValue>());
-        _parameters.insert (new ShaderParameterFactory <CameraZNearValue>());
-        _parameters.insert (new ShaderParameterFactory <CameraZFarValue>());
-        _parameters.insert (new ShaderParameterFactory <MeshGroupIdValue>());
-        _parameters.insert (new ShaderParameterFactory <BackBufferWidthValue>());
-        _parameters.insert (new ShaderParameterFactory <BackBufferHeightValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLDiffuseProbeMapValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLSpecularProbeMapValue>());
-
-        _parameters.insert (new ShaderParameterFactory <IBLSpecularMipDeltasValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLSourceMipCountValue>());
-        _parameters.insert (new ShaderParameterFactory <IBLSourceEnvironmentScaleValue>());
-
-        _parameters.insert (new ShaderParameterFactory <IBLBrdfValue>());
-        _parameters.insert (new ShaderParameterFactory <MaterialDiffuseValue>());
-        _parameters.insert(new ShaderParameterFactory <EyeLocationValue>());
-
-        _parameters.insert(new ShaderParameterFactory <DetailMapValue>());
-
-        _parameters.insert(new ShaderParameterFactory <SpecularIntensityValue>());
-        _parameters.insert(new ShaderParameterFactory <RoughnessScaleValue>());
-        _parameters.insert(new ShaderParameterFactory <SpecularWorkflowValue>());
+        addFactory (new ShaderParameterFactory <PostProcessMapValue>());
+        addFactory (new ShaderParameterFactory <ViewUpValue>());
+        addFactory (new ShaderParameterFactory <ViewRightValue>());
+        addFactory (new ShaderParameterFactory <ViewLookAtValue>());
+        addFactory (new ShaderParameterFactory <ViewValue>());
+        addFactory (new ShaderParameterFactory <ExposureParameterValue>());
+        addFactory (new ShaderParameterFactory <GammaParameterValue>());
+        addFactory (new ShaderParameterFactory <ScreenSizeValue>());
+        addFactory (new ShaderParameterFactory <TextureFunctionParameterValue>());
+        addFactory (new ShaderParameterFactory <TargetTextureSizeValue>());
+        addFactory (new ShaderParameterFactory <TargetTextureWidthValue>());
+        addFactory (new ShaderParameterFactory <TargetTextureHeightValue>());
+        addFactory (new ShaderParameterFactory <TextureInputValue>());
+        addFactory (new ShaderParameterFactory <TextureInputSizeValue>());
+        addFactory (new ShaderParameterFactory <TextureInputWidthValue>());
+        addFactory (new ShaderParameterFactory <TextureInputHeightValue>());
+        addFactory (new ShaderParameterFactory <CameraZNearValue>());
+        addFactory (new ShaderParameterFactory <CameraZFarValue>());
+        addFactory (new ShaderParameterFactory <MeshGroupIdValue>());
+        addFactory (new ShaderParameterFactory <BackBufferWidthValue>());
+        addFactory (new ShaderParameterFactory <BackBufferHeightValue>());
+        addFactory (new ShaderParameterFactory <IBLDiffuseProbeMapValue>());
+        addFactory (new ShaderParameterFactory <IBLSpecularProbeMapValue>());
+
+        addFactory (new ShaderParameterFactory <IBLSpecularMipDeltasValue>());
+        addFactory (new ShaderParameterFactory <IBLSourceMipCountValue>());
+        addFactory (new ShaderParameterFactory <IBLSourceEnvironmentScaleValue>());
+
+        addFactory (new ShaderParameterFactory <IBLBrdfValue>());
+        addFactory (new ShaderParameterFactory <MaterialDiffuseValue>());
+        addFactory (new ShaderParameterFactory <EyeLocationValue>());
+
+        addFactory (new ShaderParameterFactory <DetailMapValue>());
+
+        addFactory (new ShaderParameterFactory <SpecularIntensityValue>());
+        addFactory (new ShaderParameterFactory <RoughnessScaleValue>());
+        addFactory (new ShaderParameterFactory <SpecularWorkflowValue>());
 
         // Christ I hate this code, which is why it is all going to die very soon and be reborn.
-        _parameters.insert(new ShaderParameterFactory <UserAlbedoValue>());
-        _parameters.insert(new ShaderParameterFactory <UserRMValue>());
-        _parameters.insert(new ShaderParameterFactory <IblOcclValue>());
-        _parameters.insert(new ShaderParameterFactory<TextureScaleOffsetValue>());
+        addFactory (new ShaderParameterFactory <UserAlbedoValue>());
+        addFactory (new ShaderParameterFactory <UserRMValue>());
+        addFactory (new ShaderParameterFactory <IblOcclValue>());
+        addFactory (new ShaderParameterFactory<TextureScaleOffsetValue>());
+
+        addFactory (new ShaderParameterFactory<VertexPositionScaleValue>());
+        addFactory (new ShaderParameterFactory<VertexPositionOffsetValue>());
+        addFactory (new ShaderParameterFactory<VertexNormalEncodingValue>());
     }
 
     ShaderParameterValue* value = nullptr;
-    for (auto it = _parameters.begin(); it != _parameters.end(); it++)
+    IShaderParameterFactory* factory = nullptr;
+    if (_parameters.find (variable->semanticSymbol(), factory))
     {
-        if ((*it)->supports (variable))
-        {
-            value = (*it)->make (variable, effect);
-            break;
-        }
+        value = factory->make (variable, effect);
     }
 
     if (value == nullptr)
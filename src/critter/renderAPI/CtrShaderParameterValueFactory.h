@@ -45,6 +45,8 @@
 
 #include <CtrPlatform.h>
 #include <CtrRenderRequest.h>
+#include <CtrSymbol.h>
+#include <mutex>
 
 namespace Ctr
 {
@@ -72,9 +74,14 @@ class ShaderParameterValueFactory
                                                                    IEffect* effect);
     
   protected:
+    void                            addFactory (IShaderParameterFactory* factory);
+
     Ctr::IDevice*                                _deviceInterface;
     std::set <ShaderParameterValue*>            _managedValues;
-    std::set <IShaderParameterFactory*>         _parameters;
+    // Value factories keyed by their interned (upper case) semantic.
+    SymbolMap <IShaderParameterFactory*>        _parameters;
+    // Shaders are reloaded in parallel.
+    std::recursive_mutex                        _lock;
     static ShaderParameterValueFactory*         _shaderParameterFactory;
 };
 }
@@ -46,14 +46,161 @@
 #include <CtrIRenderResourceParameters.h>
 #include <CtrLog.h>
 #include <CtrDDSCodec.h>
+#include <CtrEXRCodec.h>
 #include <CtrFreeImageCodec.h>
+#include <CtrHDRCodec.h>
 #include <CtrTextureImage.h>
+#include <CtrTextureStreamer.h>
+#include <CtrAssetManager.h>
+#include <CtrMappedFile.h>
 #include <CtrApplication.h>
 #include <CtrStringUtilities.h>
+#include <CtrTimer.h>
+#include <CtrMath.h>
 #include <direct.h>
 
 namespace Ctr
 {
+namespace
+{
+const size_t DefaultCpuBudget = size_t(512) << 20;
+const size_t DefaultGpuBudget = size_t(1024) << 20;
+// Levels up to this size are read when a streamed texture is created.
+const uint32_t StreamedTailSize = 128;
+
+const char* ResidencyCategoryNames[ResidencyCategoryCount] = 
+{
+    "Images",
+    "Textures",
+    "CubeMaps",
+    "Volumes",
+    "Staging"
+};
+
+inline double
+secondsSince(uint64_t startTicks)
+{
+    return double(Timer::ticks() - startTicks) / double(Timer::ticksPerSecond());
+}
+
+inline size_t
+textureBytes(const ITexture* texture)
+{
+    return texture->byteSize() * (texture->isCubeMap() ? 6 : 1);
+}
+
+bool
+isStreamable(const std::string& filename)
+{
+    size_t extension = filename.rfind(".");
+    if (extension == std::string::npos)
+        return false;
+
+    std::string type = filename.substr(extension + 1);
+    stringToLower(type);
+    return type == "dds";
+}
+
+// The stream is a view into the mapping, so the file must outlive it.
+// Levels are paged in as they are decoded rather than read up front.
+DataStreamPtr
+openMappedStream(const std::string& filePathName, MappedFile& file)
+{
+    if (!file.open(filePathName))
+    {
+        LOG("Cannot map file: " << filePathName);
+        return DataStreamPtr();
+    }
+    return DataStreamPtr(new MemoryDataStream(filePathName, (void*)file.data(), file.size(), false, true));
+}
+
+bool
+readLevels(DataStreamPtr& stream,
+           uint32_t finestMip,
+           uint32_t coarsestMip,
+           const DDSCodec::LevelCallback& callback)
+{
+    const DDSCodec* codec = dynamic_cast<const DDSCodec*>(Codec::getCodec("dds"));
+    if (!codec || !stream)
+        return false;
+    stream->seek(0);
+    return codec->decodeLevels(stream, finestMip, coarsestMip, callback);
+}
+}
+
+ResidencyStatistics::ResidencyStatistics()
+{
+    memset(bytes, 0, sizeof(bytes));
+    memset(count, 0, sizeof(count));
+    memset(hits, 0, sizeof(hits));
+    memset(misses, 0, sizeof(misses));
+    memset(evictions, 0, sizeof(evictions));
+}
+
+TextureHandle::TextureHandle() :
+    _textureMgr(nullptr),
+    _texture(nullptr)
+{
+}
+
+TextureHandle::TextureHandle(TextureMgr* textureMgr, ITexture* texture) :
+    _textureMgr(textureMgr),
+    _texture(texture)
+{
+    if (_textureMgr && _texture)
+    {
+        _textureMgr->acquire(_texture);
+    }
+}
+
+TextureHandle::TextureHandle(const TextureHandle& handle) :
+    _textureMgr(handle._textureMgr),
+    _texture(handle._texture)
+{
+    if (_textureMgr && _texture)
+    {
+        _textureMgr->acquire(_texture);
+    }
+}
+
+TextureHandle::~TextureHandle()
+{
+    reset();
+}
+
+TextureHandle&
+TextureHandle::operator= (const TextureHandle& handle)
+{
+    if (this != &handle)
+    {
+        // Acquire first, the handles may share the texture.
+        if (handle._textureMgr && handle._texture)
+        {
+            handle._textureMgr->acquire(handle._texture);
+        }
+        reset();
+        _textureMgr = handle._textureMgr;
+        _texture = handle._texture;
+    }
+    return *this;
+}
+
+ITexture*
+TextureHandle::get() const
+{
+    return _texture;
+}
+
+void
+TextureHandle::reset()
+{
+    if (_textureMgr && _texture)
+    {
+        _textureMgr->release(_texture);
+    }
+    _textureMgr = nullptr;
+    _texture = nullptr;
+}
 
 
 TextureImagePtr
@@ -69,15 +216,28 @@ TextureMgr::loadImage(const std::string& filePathName,
     auto it = _images.find(fileHash);
     if (it != _images.end())
     {
+        _statistics.hits[ResidencyImages]++;
+        _imageResidency[fileHash].lastUsedFrame = _frame;
         return it->second;
     }
     else
     {
+        _statistics.misses[ResidencyImages]++;
+        uint64_t startTicks = Timer::ticks();
         image.reset(new Ctr::TextureImage());
         image->load(filePathName.c_str(), std::string(), archiveHash);
         if (image->valid())
         {
             _images.insert(std::make_pair(fileHash, image));
+
+            ImageResidency residency;
+            residency.lastUsedFrame = _frame;
+            residency.bytes = image->getSize();
+            residency.reloadCost = secondsSince(startTicks);
+            _imageResidency[fileHash] = residency;
+
+            _statistics.bytes[ResidencyImages] += residency.bytes;
+            _statistics.count[ResidencyImages]++;
         }
         return image;
     }
@@ -106,17 +266,42 @@ TextureMgr::loadImages(const std::vector<std::string>& filenames)
 
 TextureMgr::TextureMgr(const Ctr::Application* application,
                        Ctr::IDevice* device) :  
-    _deviceInterface(device)
+    _deviceInterface(device),
+    _cpuBudget(DefaultCpuBudget),
+    _gpuBudget(DefaultGpuBudget),
+    _evictionPolicy(EvictCostAware),
+    _frame(0),
+    _streamer(nullptr),
+    _streamingEnabled(true)
 {
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
     FreeImageCodec::startup();
 #endif
     DDSCodec::startup();
-
+    // Native float decoders take over hdr / exr, FreeImage still encodes.
+    HDRCodec::startup();
+    EXRCodec::startup();
+
+    _streamer = new TextureStreamer([](const std::string& filePathName,
+                                       uint32_t finestMip,
+                                       uint32_t coarsestMip,
+                                       const TextureStreamer::LevelSink& sink)
+    {
+        MappedFile file;
+        DataStreamPtr stream(openMappedStream(filePathName, file));
+        return readLevels(stream, finestMip, coarsestMip, 
+                          [&](const ImageCodec::ImageData&, size_t mipId, const TextureImagePtr& level)
+        {
+            return sink(uint32_t(mipId), level);
+        });
+    });
 }
 
 TextureMgr::~TextureMgr()
 {
+    // Joins the worker before the codecs go away.
+    safedelete(_streamer);
+
     for (auto it = _textures.begin();
          it != _textures.end();
          it++)
@@ -134,6 +319,8 @@ TextureMgr::~TextureMgr()
     }
 
 
+    EXRCodec::shutdown();
+    HDRCodec::shutdown();
 #if IBL_USE_ASS_IMP_AND_FREEIMAGE
     FreeImageCodec::shutdown();
 #endif
@@ -145,28 +332,332 @@ TextureMgr::~TextureMgr()
 void
 TextureMgr::update(float delta)
 {
+    _frame++;
+    updateStreaming();
+    trim();
+}
+
+void
+TextureMgr::updateStreaming()
+{
+    // Upload what the worker finished, then queue reads for new requests.
+    std::vector<TextureStreamer::Level> levels = _streamer->completed();
+    for (auto it = levels.begin(); it != levels.end(); it++)
+    {
+        // Streams are removed before their textures are destroyed.
+        ITexture* texture = const_cast<ITexture*>(static_cast<const ITexture*>(it->stream));
+        if (texture->writeLevel(*it->image, it->mipId))
+        {
+            texture->setResidentMip(it->mipId);
+        }
+    }
+    _streamer->update();
+}
+
+void
+TextureMgr::requestSize(const ITexture* texture, uint32_t pixels)
+{
+    _streamer->requestSize(texture, pixels);
+}
+
+bool
+TextureMgr::streaming() const
+{
+    return _streamer->pending();
+}
+
+void
+TextureMgr::setStreamingEnabled(bool enabled)
+{
+    _streamingEnabled = enabled;
+}
+
+bool
+TextureMgr::streamingEnabled() const
+{
+    return _streamingEnabled;
+}
+
+void
+TextureMgr::acquire(const ITexture* texture)
+{
+    auto it = _textureResidency.find(texture);
+    if (it != _textureResidency.end())
+    {
+        it->second.references++;
+        it->second.lastUsedFrame = _frame;
+    }
+}
+
+void
+TextureMgr::release(const ITexture* texture)
+{
+    auto it = _textureResidency.find(texture);
+    if (it != _textureResidency.end())
+    {
+        assert(it->second.references > 0);
+        it->second.references = maxValue(it->second.references - 1, 0);
+        it->second.lastUsedFrame = _frame;
+    }
+}
+
+void
+TextureMgr::setCpuBudget(size_t bytes)
+{
+    _cpuBudget = bytes;
+}
+
+size_t
+TextureMgr::cpuBudget() const
+{
+    return _cpuBudget;
+}
+
+void
+TextureMgr::setGpuBudget(size_t bytes)
+{
+    _gpuBudget = bytes;
+}
+
+size_t
+TextureMgr::gpuBudget() const
+{
+    return _gpuBudget;
+}
+
+void
+TextureMgr::setEvictionPolicy(EvictionPolicy policy)
+{
+    _evictionPolicy = policy;
+}
+
+EvictionPolicy
+TextureMgr::evictionPolicy() const
+{
+    return _evictionPolicy;
+}
+
+const char*
+TextureMgr::categoryName(ResidencyCategory category)
+{
+    return ResidencyCategoryNames[category];
+}
+
+const ResidencyStatistics&
+TextureMgr::statistics() const
+{
+    return _statistics;
+}
+
+void
+TextureMgr::logStatistics() const
+{
+    LOG("Texture residency, cpu budget " << (_cpuBudget >> 20) << "MB, gpu budget " << 
+        (_gpuBudget >> 20) << "MB");
+    for (uint32_t categoryId = 0; categoryId < ResidencyCategoryCount; categoryId++)
+    {
+        LOG("    " << ResidencyCategoryNames[categoryId] << 
+            " count " << _statistics.count[categoryId] <<
+            " size " << (_statistics.bytes[categoryId] >> 10) << "KB" <<
+            " hits " << _statistics.hits[categoryId] <<
+            " misses " << _statistics.misses[categoryId] <<
+            " evictions " << _statistics.evictions[categoryId]);
+    }
+}
+
+void
+TextureMgr::trim()
+{
+    while (gpuBytes() > _gpuBudget && evictTexture());
+    // Evicted textures may leave their images only held by the cache.
+    while (_statistics.bytes[ResidencyImages] > _cpuBudget && evictImage());
+}
+
+size_t
+TextureMgr::gpuBytes() const
+{
+    return _statistics.bytes[ResidencyTextures] + 
+           _statistics.bytes[ResidencyCubeMaps] +
+           _statistics.bytes[ResidencyVolumes] +
+           _statistics.bytes[ResidencyStaging];
+}
+
+double
+TextureMgr::evictionPriority(uint64_t lastUsedFrame,
+                             size_t bytes,
+                             double reloadCost) const
+{
+    double age = double(_frame - minValue(lastUsedFrame, _frame) + 1);
+    if (_evictionPolicy == EvictLeastRecentlyUsed)
+    {
+        return age;
+    }
+    // Prefer large entries that are cheap to decode again.
+    return age * double(bytes) / maxValue(reloadCost, 1e-4);
+}
+
+bool
+TextureMgr::evictTexture()
+{
+    auto candidate = _textureResidency.end();
+    double candidatePriority = 0;
+    for (auto it = _textureResidency.begin(); it != _textureResidency.end(); it++)
+    {
+        const TextureResidency& residency = it->second;
+        if (residency.references > 0 || residency.category == ResidencyStaging)
+        {
+            continue;
+        }
+
+        double priority = evictionPriority(residency.lastUsedFrame, residency.bytes, residency.reloadCost);
+        if (candidate == _textureResidency.end() || priority > candidatePriority)
+        {
+            candidate = it;
+            candidatePriority = priority;
+        }
+    }
+
+    if (candidate == _textureResidency.end())
+    {
+        return false;
+    }
+
+    ITexture* texture = const_cast<ITexture*>(candidate->first);
+    _statistics.evictions[candidate->second.category]++;
+    for (auto it = _textures.begin(); it != _textures.end(); it++)
+    {
+        if (it->second == texture)
+        {
+            LOG("Evicting texture " << it->first);
+            _textures.erase(it);
+            break;
+        }
+    }
+    removeResident(texture);
+    _streamer->removeStream(texture);
+    _deviceInterface->destroyResource(texture);
+    return true;
+}
+
+bool
+TextureMgr::evictImage()
+{
+    auto candidate = _images.end();
+    double candidatePriority = 0;
+    for (auto it = _images.begin(); it != _images.end(); it++)
+    {
+        // Still shared with a texture.
+        if (it->second.use_count() > 1)
+        {
+            continue;
+        }
+
+        const ImageResidency& residency = _imageResidency[it->first];
+        double priority = evictionPriority(residency.lastUsedFrame, residency.bytes, residency.reloadCost);
+        if (candidate == _images.end() || priority > candidatePriority)
+        {
+            candidate = it;
+            candidatePriority = priority;
+        }
+    }
+
+    if (candidate == _images.end())
+    {
+        return false;
+    }
+
+    auto residency = _imageResidency.find(candidate->first);
+    _statistics.bytes[ResidencyImages] -= residency->second.bytes;
+    _statistics.count[ResidencyImages]--;
+    _statistics.evictions[ResidencyImages]++;
+    _imageResidency.erase(residency);
+    _images.erase(candidate);
+    return true;
+}
+
+void
+TextureMgr::addResident(ITexture* texture,
+                        ResidencyCategory category,
+                        double reloadCost)
+{
+    TextureResidency residency;
+    residency.category = category;
+    residency.references = 0;
+    residency.lastUsedFrame = _frame;
+    residency.bytes = textureBytes(texture);
+    residency.reloadCost = reloadCost;
+    _textureResidency[texture] = residency;
+
+    _statistics.bytes[category] += residency.bytes;
+    _statistics.count[category]++;
+    _statistics.misses[category]++;
+}
+
+void
+TextureMgr::removeResident(const ITexture* texture)
+{
+    auto it = _textureResidency.find(texture);
+    if (it != _textureResidency.end())
+    {
+        _statistics.bytes[it->second.category] -= it->second.bytes;
+        _statistics.count[it->second.category]--;
+        _textureResidency.erase(it);
+    }
+}
+
+ITexture*
+TextureMgr::findResident(const std::string& name)
+{
+    if (ITexture* texture = findTexture(name))
+    {
+        auto it = _textureResidency.find(texture);
+        if (it != _textureResidency.end())
+        {
+            _statistics.hits[it->second.category]++;
+            it->second.lastUsedFrame = _frame;
+        }
+        return texture;
+    }
+    return nullptr;
 }
 
 ITexture*
 TextureMgr::loadTexture (const std::string& filename,
                          Ctr::PixelFormat format)
+{
+    // The caller keeps the raw pointer, so the texture is pinned.
+    TextureHandle handle = loadTextureHandle(filename, format);
+    acquire(handle.get());
+    return handle.get();
+}
+
+TextureHandle
+TextureMgr::loadTextureHandle (const std::string& filename,
+                               Ctr::PixelFormat format)
 {
     if (filename.length() == 0)
-        return nullptr;
+        return TextureHandle();
     LOG ("Attempting to load texture " << filename);
 
-    ITexture* texture = findTexture (filename);
+    ITexture* texture = findResident (filename);
     if (!texture)
     {
-        std::vector<std::string>       filenames;
-        filenames.push_back(filename);
-        TextureParameters resource = 
-            TextureParameters(filenames, loadImages(filenames),Ctr::TwoD);
+        uint64_t startTicks = Timer::ticks();
+        if (!(texture = loadStreamedTexture(filename, Ctr::TwoD)))
+        {
+            std::vector<std::string>       filenames;
+            filenames.push_back(filename);
+            TextureParameters resource = 
+                TextureParameters(filenames, loadImages(filenames),Ctr::TwoD);
+            texture = _deviceInterface->createTexture(&resource);
+        }
 
-        if (texture = _deviceInterface->createTexture(&resource))
+        if (texture)
         {
             _textures.insert (std::make_pair(std::string(filename),
                               texture));
+            addResident(texture, texture->isCubeMap() ? ResidencyCubeMaps : ResidencyTextures,
+                        secondsSince(startTicks));
             LOG ("Loaded texture " << filename);
         }
         else
@@ -175,21 +666,26 @@ TextureMgr::loadTexture (const std::string& filename,
 
         }
     }
-    return texture;
+
+    TextureHandle handle(this, texture);
+    trim();
+    return handle;
 }
 
 ITexture*
 TextureMgr::loadTextureSet (const std::string& key, 
                             const std::vector<std::string>      & filenames)
 {
-    ITexture* texture = findTexture (key);
+    ITexture* texture = findResident (key);
     if (!texture)
     {
+        uint64_t startTicks = Timer::ticks();
         TextureParameters resource = TextureParameters(filenames, loadImages(filenames), Ctr::TwoD);
         if (texture = _deviceInterface->createTexture(&resource))
         {
             _textures.insert (std::make_pair(std::string(key),
                               texture));
+            addResident(texture, ResidencyTextures, secondsSince(startTicks));
 
             LOG ("Loaded texture array from: ")
             for (size_t i = 0;i < filenames.size(); i++)
@@ -206,6 +702,8 @@ TextureMgr::loadTextureSet (const std::string& key,
             }
         }
     }
+    acquire(texture);
+    trim();
     return texture;
 }
 
@@ -225,6 +723,7 @@ TextureMgr::loadStagingTexture(const std::string& filename)
     {
         _stagingTextures.insert (std::make_pair(std::string(filename),
                           texture));
+        addResident(texture, ResidencyStaging, 0);
     }
     return texture;
 }
@@ -234,14 +733,25 @@ TextureMgr::recycle(const ITexture* texture)
 {
     if (texture == nullptr)
         return;
-    // Delete the texture. There is no reference counting right now, due to removal of
-    // Kreature's product graph, so, uhhh, pray it is not in use elsewhere.
+
+    auto residency = _textureResidency.find(texture);
+    if (residency != _textureResidency.end())
+    {
+        if (residency->second.references > 1)
+        {
+            release(texture);
+            return;
+        }
+        removeResident(texture);
+    }
+
+    _streamer->removeStream(texture);
     for (auto it = _textures.begin(); it != _textures.end(); it++)
     {
         if (it->second == texture)
         {
-            safedelete (it->second);
             _textures.erase(it);
+            _deviceInterface->destroyResource(const_cast<ITexture*>(texture));
             return;
         }
     }
@@ -254,17 +764,24 @@ TextureMgr::loadCubeTexture (const std::string& filename,
     if (filename.length() == 0)
         return nullptr;
 
-    ITexture* texture = findTexture (filename);
+    ITexture* texture = findResident (filename);
     if (!texture)
     {
+        uint64_t startTicks = Timer::ticks();
         TextureDimension dimension = CubeMap;
-        std::vector<std::string>       filenames;
-        filenames.push_back(filename);
+        if (!(texture = loadStreamedTexture(filename, dimension)))
+        {
+            std::vector<std::string>       filenames;
+            filenames.push_back(filename);
 
-        TextureParameters resource = TextureParameters(filenames, loadImages(filenames), dimension);
-        if (texture = _deviceInterface->createTexture(&resource))
+            TextureParameters resource = TextureParameters(filenames, loadImages(filenames), dimension);
+            texture = _deviceInterface->createTexture(&resource);
+        }
+
+        if (texture)
         {
             _textures.insert (std::make_pair(std::string(filename), texture));        
+            addResident(texture, ResidencyCubeMaps, secondsSince(startTicks));
             LOG ("Loaded cubemap texture " << filename);
         }
         else
@@ -272,6 +789,75 @@ TextureMgr::loadCubeTexture (const std::string& filename,
            LOG ("Failed to load cubemap texture " << filename);
         }
     }
+    acquire(texture);
+    trim();
+    return texture;
+}
+
+ITexture*
+TextureMgr::loadStreamedTexture (const std::string& filename,
+                                 TextureDimension dimension)
+{
+    if (!_streamingEnabled || !isStreamable(filename))
+        return nullptr;
+
+    // One mapping serves both the header and the tail.
+    MappedFile file;
+    DataStreamPtr stream(openMappedStream(filename, file));
+    const DDSCodec* codec = dynamic_cast<const DDSCodec*>(Codec::getCodec("dds"));
+    ImageCodec::ImageData header;
+    if (!codec || !stream || !codec->decodeHeader(stream, header))
+        return nullptr;
+
+    // Small files and volumes are loaded in one go.
+    uint32_t mipCount = uint32_t(header.num_mipmaps) + 1;
+    uint32_t tailMip = TextureStreamer::targetMip(uint32_t(header.width), uint32_t(header.height), 
+                                                  mipCount, StreamedTailSize);
+    if (tailMip == 0 || (header.flags & IF_3D_TEXTURE))
+        return nullptr;
+
+    // The tail is read here so the texture can be drawn straight away.
+    std::vector<TextureImagePtr> levels;
+    if (!readLevels(stream, tailMip, mipCount - 1,
+                    [&](const ImageCodec::ImageData&, size_t, const TextureImagePtr& level)
+                    {
+                        levels.push_back(level);
+                        return true;
+                    }) || levels.empty())
+    {
+        return nullptr;
+    }
+
+    // Levels arrive coarsest first, the image holds them finest first.
+    TextureImagePtr tail(new TextureImage());
+    tail->create(Ctr::Vector2i(int32_t(levels.back()->getWidth()), int32_t(levels.back()->getHeight())),
+                 header.format, uint32_t(levels.size()), header.flags & (IF_CUBEMAP | IF_COMPRESSED), false);
+    for (size_t levelId = 0; levelId < levels.size(); levelId++)
+    {
+        const TextureImagePtr& level = levels[levelId];
+        size_t faceBytes = level->getMipSize(0) / level->getNumFaces();
+        for (size_t face = 0; face < level->getNumFaces(); face++)
+        {
+            memcpy(tail->getPixelBox(face, levels.size() - 1 - levelId).data,
+                   level->getPixelBox(face, 0).data,
+                   faceBytes);
+        }
+    }
+
+    std::vector<std::string> filenames(1, filename);
+    TextureParameters resource(filenames, TextureImageArray(1, tail), dimension);
+    resource.setWidth(float(header.width));
+    resource.setHeight(float(header.height));
+    resource.setNumMipLevels(mipCount);
+    resource.setResidentMip(tailMip);
+
+    ITexture* texture = _deviceInterface->createTexture(&resource);
+    if (texture)
+    {
+        _streamer->addStream(texture, filename, uint32_t(header.width), uint32_t(header.height), 
+                             mipCount, tailMip);
+        LOG("Streaming texture " << filename << " from level " << tailMip << " of " << mipCount);
+    }
     return texture;
 }
 
@@ -279,10 +865,11 @@ const ITexture*
 TextureMgr::loadThreeD (const std::string& filename,
                         Ctr::PixelFormat format)
 {
-    ITexture* texture = findTexture (filename);
+    ITexture* texture = findResident (filename);
     
     if (!texture)
     {
+        uint64_t startTicks = Timer::ticks();
         // Load volume texture
         std::vector<std::string>       filenames;
         filenames.push_back(filename);
@@ -301,6 +888,7 @@ TextureMgr::loadThreeD (const std::string& filename,
         if (texture = _deviceInterface->createTexture(&resource))
         {
             _textures.insert (std::make_pair(std::string(filename), texture));  
+            addResident(texture, ResidencyVolumes, secondsSince(startTicks));
             LOG ("Loaded volume texture " << filename);
         }
         else
@@ -309,6 +897,8 @@ TextureMgr::loadThreeD (const std::string& filename,
         }
     }
 
+    acquire(texture);
+    trim();
     return texture;
 }
 
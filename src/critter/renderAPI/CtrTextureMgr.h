@@ -53,6 +53,62 @@ class Application;
 class IDevice;
 class Texture2DProperty;
 class ITexture;
+class TextureMgr;
+class TextureStreamer;
+
+enum ResidencyCategory
+{
+    ResidencyImages,         // Decoded images cached on the CPU.
+    ResidencyTextures,       // 2D textures and texture sets.
+    ResidencyCubeMaps,
+    ResidencyVolumes,
+    ResidencyStaging,
+    ResidencyCategoryCount
+};
+
+enum EvictionPolicy
+{
+    EvictLeastRecentlyUsed,  // Oldest first.
+    EvictCostAware           // Age times bytes reclaimed per second of re-decode.
+};
+
+struct ResidencyStatistics
+{
+    ResidencyStatistics();
+
+    size_t                     bytes[ResidencyCategoryCount];
+    uint32_t                   count[ResidencyCategoryCount];
+    uint32_t                   hits[ResidencyCategoryCount];
+    uint32_t                   misses[ResidencyCategoryCount];
+    uint32_t                   evictions[ResidencyCategoryCount];
+};
+
+//--------------------------------------------------------------------
+//
+// TextureHandle
+//
+// Counted reference to a texture owned by the TextureMgr. A texture
+// is only evicted once no handle or acquire holds it. Textures the
+// manager does not own (render targets) are carried without counting.
+//
+//--------------------------------------------------------------------
+class TextureHandle
+{
+  public:
+    TextureHandle();
+    TextureHandle(TextureMgr* textureMgr, ITexture* texture);
+    TextureHandle(const TextureHandle& handle);
+    ~TextureHandle();
+
+    TextureHandle&             operator= (const TextureHandle& handle);
+
+    ITexture*                  get() const;
+    void                       reset();
+
+  private:
+    TextureMgr*                _textureMgr;
+    ITexture*                  _texture;
+};
 
 class TextureMgr
 {
@@ -61,10 +117,15 @@ class TextureMgr
                Ctr::IDevice* device);
     virtual ~TextureMgr();
 
-    // Simple load texture
+    // Simple load texture. The texture stays resident for the lifetime 
+    // of the manager, use loadTextureHandle for textures that may be evicted.
     ITexture*                    loadTexture (const std::string& filename,
                                               Ctr::PixelFormat format = Ctr::PF_A8R8G8B8);
 
+    // Load texture, referenced only by the returned handle.
+    TextureHandle                loadTextureHandle (const std::string& filename,
+                                                    Ctr::PixelFormat format = Ctr::PF_A8R8G8B8);
+
     // Load texture from an array of images.
     ITexture*                    loadTextureSet (const std::string& key, 
                                                  const std::vector<std::string> & filenames);
@@ -88,10 +149,41 @@ class TextureMgr
     const ITexture*               loadThreeD (const std::string& name,
                                                   Ctr::PixelFormat format = Ctr::PF_A8R8G8B8);
 
+    // Release a reference, destroying the texture if it was the last.
     void                          recycle(const ITexture* texture);
 
     void                          update (float delta);
 
+    // Reference counting of managed textures, see TextureHandle.
+    void                          acquire(const ITexture* texture);
+    void                          release(const ITexture* texture);
+
+    // Budgets in bytes. Unreferenced textures and images only held by
+    // the cache are evicted, by policy, until within budget. They are
+    // decoded again on the next load.
+    void                          setCpuBudget(size_t bytes);
+    size_t                        cpuBudget() const;
+    void                          setGpuBudget(size_t bytes);
+    size_t                        gpuBudget() const;
+    void                          setEvictionPolicy(EvictionPolicy policy);
+    EvictionPolicy                evictionPolicy() const;
+
+    void                          trim();
+
+    // Large dds files are created from their mip tail and the finer
+    // levels are read on a worker, then uploaded in update(). Streams
+    // target full resolution unless a draw size is requested, in which
+    // case only the levels covering the largest request are read.
+    void                          requestSize(const ITexture* texture, uint32_t pixels);
+    // True while streamed levels are being read or waiting for upload.
+    bool                          streaming() const;
+    void                          setStreamingEnabled(bool enabled);
+    bool                          streamingEnabled() const;
+
+    const ResidencyStatistics&    statistics() const;
+    void                          logStatistics() const;
+    static const char*            categoryName(ResidencyCategory category);
+
     TextureImagePtr               loadImage(const std::string& filePathName,
                                             const Ctr::Hash& archiveHash);
     std::vector<TextureImagePtr>  loadImages(const std::vector<std::string>& filenames);
@@ -99,13 +191,57 @@ class TextureMgr
   protected:
     ITexture*                    findTexture (const std::string& name);
 
+    ITexture*                    findResident (const std::string& name);
+    void                         addResident (ITexture* texture,
+                                              ResidencyCategory category,
+                                              double reloadCost);
+    void                         removeResident (const ITexture* texture);
+    double                       evictionPriority (uint64_t lastUsedFrame,
+                                                   size_t bytes,
+                                                   double reloadCost) const;
+    size_t                       gpuBytes() const;
+    bool                         evictTexture();
+    bool                         evictImage();
+
+    ITexture*                    loadStreamedTexture (const std::string& filename,
+                                                      TextureDimension dimension);
+    void                         updateStreaming();
+
   private:
+    struct TextureResidency
+    {
+        ResidencyCategory        category;
+        int32_t                  references;
+        uint64_t                 lastUsedFrame;
+        size_t                   bytes;
+        double                   reloadCost;
+    };
+
+    struct ImageResidency
+    {
+        uint64_t                 lastUsedFrame;
+        size_t                   bytes;
+        double                   reloadCost;
+    };
+
     typedef std::map<std::string, ITexture*> TextureMap;
     typedef std::map<Ctr::Hash, TextureImagePtr> ImageMap;
+    typedef std::map<const ITexture*, TextureResidency> TextureResidencyMap;
+    typedef std::map<Ctr::Hash, ImageResidency> ImageResidencyMap;
     TextureMap                   _textures;
     TextureMap                   _stagingTextures;
     ImageMap                     _images;
+    TextureResidencyMap          _textureResidency;
+    ImageResidencyMap            _imageResidency;
     Ctr::IDevice*                _deviceInterface;
+
+    size_t                       _cpuBudget;
+    size_t                       _gpuBudget;
+    EvictionPolicy               _evictionPolicy;
+    uint64_t                     _frame;
+    ResidencyStatistics          _statistics;
+    TextureStreamer*             _streamer;
+    bool                         _streamingEnabled;
 };
 }
 
@@ -0,0 +1,320 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#include <CtrTextureStreamer.h>
+#include <CtrLog.h>
+#include <CtrMath.h>
+
+namespace Ctr
+{
+TextureStreamer::TextureStreamer(const LevelReader& reader, bool threaded) :
+    _reader(reader),
+    _serial(0),
+    _running(0),
+    _shutdown(false)
+{
+    if (threaded)
+    {
+        _worker = std::thread(&TextureStreamer::run, this);
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _shutdown = true;
+    }
+    _readAvailable.notify_all();
+    if (_worker.joinable())
+    {
+        _worker.join();
+    }
+}
+
+void
+TextureStreamer::addStream(const void* stream,
+                           const std::string& filePathName,
+                           uint32_t width,
+                           uint32_t height,
+                           uint32_t mipCount,
+                           uint32_t residentMip)
+{
+    Stream entry;
+    entry.filePathName = filePathName;
+    entry.width = width;
+    entry.height = height;
+    entry.mipCount = maxValue(mipCount, 1u);
+    entry.residentMip = minValue(residentMip, entry.mipCount - 1);
+    entry.requestedMip = entry.residentMip;
+    entry.targetMip = 0;
+    entry.requestedPixels = 0;
+    entry.requested = false;
+    entry.failed = false;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    entry.serial = ++_serial;
+    _streams[stream] = entry;
+}
+
+void
+TextureStreamer::removeStream(const void* stream)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _streams.erase(stream);
+
+    // A running read notices through the serial and stops at its next level.
+    for (auto it = _reads.begin(); it != _reads.end(); )
+    {
+        it = it->stream == stream ? _reads.erase(it) : it + 1;
+    }
+    for (auto it = _completed.begin(); it != _completed.end(); )
+    {
+        it = it->stream == stream ? _completed.erase(it) : it + 1;
+    }
+}
+
+bool
+TextureStreamer::hasStream(const void* stream) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _streams.find(stream) != _streams.end();
+}
+
+void
+TextureStreamer::requestSize(const void* stream, uint32_t pixels)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _streams.find(stream);
+    if (it != _streams.end())
+    {
+        it->second.requestedPixels = maxValue(it->second.requestedPixels, pixels);
+        it->second.requested = true;
+    }
+}
+
+void
+TextureStreamer::update()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto it = _streams.begin(); it != _streams.end(); it++)
+        {
+            Stream& stream = it->second;
+            if (stream.requestedPixels > 0)
+            {
+                stream.targetMip = targetMip(stream.width, stream.height, stream.mipCount, stream.requestedPixels);
+                stream.requestedPixels = 0;
+            }
+            else if (!stream.requested)
+            {
+                stream.targetMip = 0;
+            }
+
+            // Levels are never dropped, only the missing finer ones are read.
+            if (!stream.failed && stream.targetMip < stream.requestedMip)
+            {
+                Read read;
+                read.stream = it->first;
+                read.serial = stream.serial;
+                read.filePathName = stream.filePathName;
+                read.finestMip = stream.targetMip;
+                read.coarsestMip = stream.requestedMip - 1;
+                _reads.push_back(read);
+                stream.requestedMip = stream.targetMip;
+            }
+        }
+    }
+
+    if (_worker.joinable())
+    {
+        _readAvailable.notify_all();
+        return;
+    }
+
+    for (;;)
+    {
+        Read next;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_reads.empty())
+                break;
+            next = _reads.front();
+            _reads.pop_front();
+            _running++;
+        }
+        read(next);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running--;
+        }
+    }
+}
+
+std::vector<TextureStreamer::Level>
+TextureStreamer::completed()
+{
+    std::vector<Level> levels;
+    std::lock_guard<std::mutex> lock(_mutex);
+    levels.swap(_completed);
+    for (auto it = levels.begin(); it != levels.end(); it++)
+    {
+        auto stream = _streams.find(it->stream);
+        if (stream != _streams.end())
+        {
+            stream->second.residentMip = minValue(stream->second.residentMip, it->mipId);
+        }
+    }
+    return levels;
+}
+
+bool
+TextureStreamer::pending() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_reads.empty() || _running > 0 || !_completed.empty())
+        return true;
+
+    for (auto it = _streams.begin(); it != _streams.end(); it++)
+    {
+        if (!it->second.failed && it->second.requestedMip < it->second.residentMip)
+            return true;
+    }
+    return false;
+}
+
+void
+TextureStreamer::wait() const
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [&] { return _reads.empty() && _running == 0; });
+}
+
+uint32_t
+TextureStreamer::residentMip(const void* stream) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _streams.find(stream);
+    return it != _streams.end() ? it->second.residentMip : 0;
+}
+
+uint32_t
+TextureStreamer::targetMip(const void* stream) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _streams.find(stream);
+    return it != _streams.end() ? it->second.targetMip : 0;
+}
+
+uint32_t
+TextureStreamer::targetMip(uint32_t width,
+                           uint32_t height,
+                           uint32_t mipCount,
+                           uint32_t pixels)
+{
+    uint32_t largest = maxValue(width, height);
+    uint32_t mipId = 0;
+    while (mipId + 1 < mipCount && (largest >> (mipId + 1)) >= pixels)
+    {
+        mipId++;
+    }
+    return mipId;
+}
+
+void
+TextureStreamer::run()
+{
+    for (;;)
+    {
+        Read next;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _readAvailable.wait(lock, [&] { return _shutdown || !_reads.empty(); });
+            if (_shutdown)
+                return;
+            next = _reads.front();
+            _reads.pop_front();
+            _running++;
+        }
+
+        read(next);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running--;
+        }
+        _idle.notify_all();
+    }
+}
+
+void
+TextureStreamer::read(const Read& read)
+{
+    auto sink = [&](uint32_t mipId, const TextureImagePtr& image) -> bool
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _streams.find(read.stream);
+        if (_shutdown || it == _streams.end() || it->second.serial != read.serial)
+            return false;
+
+        Level level;
+        level.stream = read.stream;
+        level.mipId = mipId;
+        level.image = image;
+        _completed.push_back(level);
+        return true;
+    };
+
+    if (!_reader(read.filePathName, read.finestMip, read.coarsestMip, sink))
+    {
+        LOG("Failed to stream levels " << read.coarsestMip << " to " << read.finestMip << 
+            " of " << read.filePathName);
+
+        // Keep what is resident, and do not retry every frame.
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _streams.find(read.stream);
+        if (it != _streams.end() && it->second.serial == read.serial)
+        {
+            it->second.failed = true;
+        }
+    }
+}
+}
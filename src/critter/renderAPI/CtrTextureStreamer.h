@@ -0,0 +1,171 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_TEXTURE_STREAMER
+#define INCLUDED_CRT_TEXTURE_STREAMER
+
+#include <CtrPlatform.h>
+#include <CtrTextureImage.h>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <map>
+
+namespace Ctr
+{
+//------------------------------------------------------------
+// TextureStreamer
+//
+// Decides which level of each streamed texture should be
+// resident and reads the missing levels on a background
+// worker, coarsest first. Streams are keyed by an opaque
+// pointer and levels come from a reader callback, so the
+// controller has no device dependency and runs headless.
+// Without a worker, reads run inline in update().
+//------------------------------------------------------------
+class TextureStreamer
+{
+  public:
+    // Receives every face of one level. Returning false cancels the read.
+    typedef std::function<bool (uint32_t mipId, const TextureImagePtr& level)> LevelSink;
+
+    // Reads levels coarsestMip down to finestMip of a file, coarsest first.
+    typedef std::function<bool (const std::string& filePathName,
+                                uint32_t finestMip,
+                                uint32_t coarsestMip,
+                                const LevelSink& sink)> LevelReader;
+
+    struct Level
+    {
+        const void*              stream;
+        uint32_t                 mipId;
+        TextureImagePtr          image;
+    };
+
+    TextureStreamer(const LevelReader& reader, bool threaded = true);
+    virtual ~TextureStreamer();
+
+    // Tracks a chain of mipCount levels whose levels from residentMip
+    // down to the smallest are already resident.
+    void                         addStream(const void* stream,
+                                           const std::string& filePathName,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           uint32_t mipCount,
+                                           uint32_t residentMip);
+    // Cancels outstanding reads, levels not yet collected are dropped.
+    void                         removeStream(const void* stream);
+    bool                         hasStream(const void* stream) const;
+
+    // The stream is drawn pixels wide this frame. The largest request
+    // since the last update wins, streams that were never requested
+    // target their full resolution.
+    void                         requestSize(const void* stream, uint32_t pixels);
+
+    // Retargets the streams and queues reads for missing levels.
+    void                         update();
+
+    // Levels read since the last call, coarsest first for each stream.
+    // The caller uploads them, the resident mip follows.
+    std::vector<Level>           completed();
+
+    // True while reads are queued, running or not yet collected.
+    bool                         pending() const;
+    // Blocks until the worker has nothing left to read.
+    void                         wait() const;
+
+    uint32_t                     residentMip(const void* stream) const;
+    uint32_t                     targetMip(const void* stream) const;
+
+    // Coarsest level whose largest side still covers pixels.
+    static uint32_t              targetMip(uint32_t width,
+                                           uint32_t height,
+                                           uint32_t mipCount,
+                                           uint32_t pixels);
+
+  private:
+    struct Stream
+    {
+        std::string              filePathName;
+        uint32_t                 width;
+        uint32_t                 height;
+        uint32_t                 mipCount;
+        // Finest level uploaded or handed out by completed().
+        uint32_t                 residentMip;
+        // Finest level read or queued.
+        uint32_t                 requestedMip;
+        uint32_t                 targetMip;
+        uint32_t                 requestedPixels;
+        uint64_t                 serial;
+        bool                     requested;
+        bool                     failed;
+    };
+
+    struct Read
+    {
+        const void*              stream;
+        uint64_t                 serial;
+        std::string              filePathName;
+        uint32_t                 finestMip;
+        uint32_t                 coarsestMip;
+    };
+
+    void                         run();
+    void                         read(const Read& read);
+
+    LevelReader                  _reader;
+    std::map<const void*, Stream> _streams;
+    std::deque<Read>             _reads;
+    std::vector<Level>           _completed;
+    uint64_t                     _serial;
+    uint32_t                     _running;
+    bool                         _shutdown;
+
+    mutable std::mutex           _mutex;
+    std::condition_variable      _readAvailable;
+    mutable std::condition_variable _idle;
+    std::thread                  _worker;
+};
+}
+
+#endif
@@ -0,0 +1,359 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrVertexQuantizer.h>
+#include <CtrVertexStream.h>
+#include <CtrBitwise.h>
+#include <CtrMath.h>
+#include <CtrLog.h>
+#include <vector>
+#include <cmath>
+
+namespace Ctr
+{
+namespace
+{
+inline float
+signNotZero(float value)
+{
+    return value < 0.0f ? -1.0f : 1.0f;
+}
+
+inline int16_t
+snorm16(float value)
+{
+    return (int16_t)(std::floor(clamped(value, -1.0f, 1.0f) * 32767.0f + 0.5f));
+}
+
+// Angle between unit vectors from the chord, acos of the dot product
+// has no precision left at the small angles being measured.
+inline float
+angleBetween(const Vector3f& a, const Vector3f& b)
+{
+    float chord = (a - b).length();
+    return 2.0f * std::asin(clamped(chord * 0.5f, 0.0f, 1.0f));
+}
+}
+
+VertexQuantizer::VertexQuantizer(const Ctr::Region3f& bounds,
+                                 float texCoordTolerance) :
+    _octahedralNormals(false),
+    _texCoordTolerance(texCoordTolerance)
+{
+    Vector3f extent = bounds.maxExtent - bounds.minExtent;
+    _positionScale = Vector4f(maxValue(extent.x, 0.0f),
+                              maxValue(extent.y, 0.0f),
+                              maxValue(extent.z, 0.0f), 1.0f);
+    _positionOffset = Vector4f(bounds.minExtent.x, 
+                               bounds.minExtent.y,
+                               bounds.minExtent.z, 0.0f);
+}
+
+const Ctr::Vector4f&
+VertexQuantizer::positionScale() const
+{
+    return _positionScale;
+}
+
+const Ctr::Vector4f&
+VertexQuantizer::positionOffset() const
+{
+    return _positionOffset;
+}
+
+bool
+VertexQuantizer::octahedralNormals() const
+{
+    return _octahedralNormals;
+}
+
+const VertexQuantizationError&
+VertexQuantizer::error() const
+{
+    return _error;
+}
+
+float
+VertexQuantizer::positionErrorBound() const
+{
+    // Half a step of 65535 along each axis, before float rounding of the decode.
+    Vector3f step = (0.5f / 65535.0f) * Vector3f(_positionScale.x, _positionScale.y, _positionScale.z);
+    return step.length();
+}
+
+bool
+VertexQuantizer::quantize(VertexStream* stream)
+{
+    if (!stream || !stream->stream() || stream->count() == 0)
+    {
+        return false;
+    }
+
+    switch (stream->usage())
+    {
+        case Ctr::POSITION:
+            return quantizePositions(stream);
+        case Ctr::NORMAL:
+        case Ctr::TANGENT:
+        case Ctr::BINORMAL:
+            return quantizeDirections(stream);
+        case Ctr::TEXCOORD:
+            return quantizeTexCoords(stream);
+        default:
+            break;
+    }
+    return false;
+}
+
+bool
+VertexQuantizer::quantizePositions(VertexStream* stream)
+{
+    if (stream->stride() != 3)
+    {
+        return false;
+    }
+
+    uint32_t count = stream->count();
+    const float* source = stream->stream();
+    std::vector<uint16_t> packed(count * 4);
+
+    float maxError = 0;
+    for (uint32_t vertexId = 0; vertexId < count; vertexId++)
+    {
+        Vector3f position(source[vertexId * 3], source[vertexId * 3 + 1], source[vertexId * 3 + 2]);
+        uint16_t* element = &packed[vertexId * 4];
+        encodePosition(position, _positionScale, _positionOffset, element);
+
+        Vector3f decoded = decodePosition(element, _positionScale, _positionOffset);
+        maxError = maxValue(maxError, (decoded - position).length());
+    }
+
+    stream->setPacked(Ctr::USHORT4N, &packed[0]);
+    _error.position = maxValue(_error.position, maxError);
+    return true;
+}
+
+bool
+VertexQuantizer::quantizeDirections(VertexStream* stream)
+{
+    if (stream->stride() != 3)
+    {
+        return false;
+    }
+
+    uint32_t count = stream->count();
+    const float* source = stream->stream();
+    std::vector<int16_t> packed(count * 2);
+
+    float maxError = 0;
+    for (uint32_t vertexId = 0; vertexId < count; vertexId++)
+    {
+        Vector3f direction(source[vertexId * 3], source[vertexId * 3 + 1], source[vertexId * 3 + 2]);
+        int16_t* element = &packed[vertexId * 2];
+        encodeOctahedral(direction, element);
+
+        // Missing normals are zero filled by the importers.
+        if (direction.lengthSquared() > 0)
+        {
+            direction.normalize();
+            maxError = maxValue(maxError, angleBetween(decodeOctahedral(element), direction));
+        }
+    }
+
+    stream->setPacked(Ctr::SHORT2N, &packed[0]);
+    _error.normal = maxValue(_error.normal, maxError);
+    if (stream->usage() == Ctr::NORMAL)
+    {
+        _octahedralNormals = true;
+    }
+    return true;
+}
+
+bool
+VertexQuantizer::quantizeTexCoords(VertexStream* stream)
+{
+    if (stream->stride() != 2)
+    {
+        return false;
+    }
+
+    uint32_t count = stream->count();
+    const float* source = stream->stream();
+    std::vector<uint16_t> packed(count * 2);
+
+    float maxError = 0;
+    for (uint32_t vertexId = 0; vertexId < count; vertexId++)
+    {
+        Vector2f texCoord(source[vertexId * 2], source[vertexId * 2 + 1]);
+        uint16_t* element = &packed[vertexId * 2];
+        encodeTexCoord(texCoord, element);
+
+        Vector2f decoded = decodeTexCoord(element);
+        maxError = maxValue(maxError, maxValue(std::fabs(decoded.x - texCoord.x),
+                                               std::fabs(decoded.y - texCoord.y)));
+    }
+
+    // Catches nans and infinities as well as tiled uvs beyond half precision.
+    if (!(maxError <= _texCoordTolerance))
+    {
+        LOG("Keeping float texture coordinates, half error " << maxError);
+        return false;
+    }
+
+    stream->setPacked(Ctr::FLOAT16_2, &packed[0]);
+    _error.texCoord = maxValue(_error.texCoord, maxError);
+    return true;
+}
+
+void
+VertexQuantizer::encodePosition(const Ctr::Vector3f& position,
+                                const Ctr::Vector4f& scale,
+                                const Ctr::Vector4f& offset,
+                                uint16_t* packed)
+{
+    const float* scaleValues = &scale.x;
+    const float* offsetValues = &offset.x;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        float unit = scaleValues[axis] > 0 ? 
+            (position[axis] - offsetValues[axis]) / scaleValues[axis] : 0.0f;
+        packed[axis] = (uint16_t)(std::floor(clamped(unit, 0.0f, 1.0f) * 65535.0f + 0.5f));
+    }
+    packed[3] = 65535;
+}
+
+Ctr::Vector3f
+VertexQuantizer::decodePosition(const uint16_t* packed,
+                                const Ctr::Vector4f& scale,
+                                const Ctr::Vector4f& offset)
+{
+    return Vector3f((packed[0] / 65535.0f) * scale.x + offset.x,
+                    (packed[1] / 65535.0f) * scale.y + offset.y,
+                    (packed[2] / 65535.0f) * scale.z + offset.z);
+}
+
+void
+VertexQuantizer::encodeOctahedral(const Ctr::Vector3f& direction,
+                                  int16_t* packed)
+{
+    float l1 = std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z);
+    if (!(l1 > 0))
+    {
+        packed[0] = packed[1] = 0;
+        return;
+    }
+
+    // Project onto the octahedron and fold the lower hemisphere.
+    float u = direction.x / l1;
+    float v = direction.y / l1;
+    if (direction.z < 0)
+    {
+        float foldedU = (1.0f - std::fabs(v)) * signNotZero(u);
+        float foldedV = (1.0f - std::fabs(u)) * signNotZero(v);
+        u = foldedU;
+        v = foldedV;
+    }
+
+    // Pick the floor / ceil combination that decodes closest to the input,
+    // which rounding to nearest does not guarantee.
+    Vector3f unit = direction.normalized();
+    float baseU = std::floor(clamped(u, -1.0f, 1.0f) * 32767.0f);
+    float baseV = std::floor(clamped(v, -1.0f, 1.0f) * 32767.0f);
+    float bestCosine = -2.0f;
+    for (uint32_t candidate = 0; candidate < 4; candidate++)
+    {
+        int16_t trial[2] = 
+        { 
+            snorm16((baseU + (candidate & 1)) / 32767.0f),
+            snorm16((baseV + (candidate >> 1)) / 32767.0f)
+        };
+        float cosine = decodeOctahedral(trial).dot(unit);
+        if (cosine > bestCosine)
+        {
+            bestCosine = cosine;
+            packed[0] = trial[0];
+            packed[1] = trial[1];
+        }
+    }
+}
+
+Ctr::Vector3f
+VertexQuantizer::decodeOctahedral(const int16_t* packed)
+{
+    // Matches the SNORM conversion of the input assembler.
+    float u = maxValue(packed[0] / 32767.0f, -1.0f);
+    float v = maxValue(packed[1] / 32767.0f, -1.0f);
+
+    Vector3f direction(u, v, 1.0f - std::fabs(u) - std::fabs(v));
+    if (direction.z < 0)
+    {
+        direction.x = (1.0f - std::fabs(v)) * signNotZero(u);
+        direction.y = (1.0f - std::fabs(u)) * signNotZero(v);
+    }
+    direction.normalize();
+    return direction;
+}
+
+void
+VertexQuantizer::encodeTexCoord(const Ctr::Vector2f& texCoord,
+                                uint16_t* packed)
+{
+    const float* values = &texCoord.x;
+    for (uint32_t component = 0; component < 2; component++)
+    {
+        union { float f; uint32_t i; } bits;
+        bits.f = values[component];
+        // Round the mantissa to nearest even before truncating to 10 bits.
+        if ((bits.i & 0x7f800000) != 0x7f800000)
+        {
+            bits.i += 0x00000fff + ((bits.i >> 13) & 1);
+        }
+        packed[component] = Bitwise::floatToHalfI(bits.i);
+    }
+}
+
+Ctr::Vector2f
+VertexQuantizer::decodeTexCoord(const uint16_t* packed)
+{
+    return Vector2f(Bitwise::halfToFloat(packed[0]),
+                    Bitwise::halfToFloat(packed[1]));
+}
+
+}
@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#ifndef INCLUDED_CRT_VERTEX_QUANTIZER
+#define INCLUDED_CRT_VERTEX_QUANTIZER
+
+#include <CtrPlatform.h>
+#include <CtrRenderEnums.h>
+#include <CtrVector2.h>
+#include <CtrVector3.h>
+#include <CtrVector4.h>
+#include <CtrRegion.h>
+
+namespace Ctr
+{
+class VertexStream;
+
+// Largest error introduced by quantization, measured by decoding every
+// element on the CPU. Position is an object space distance, normal the
+// angle in radians and texCoord the largest absolute uv difference.
+struct VertexQuantizationError
+{
+    VertexQuantizationError() : position(0), normal(0), texCoord(0) {}
+
+    float                      position;
+    float                      normal;
+    float                      texCoord;
+};
+
+// Packs the float vertex streams of an imported mesh into compact GPU
+// encodings with VertexStream::setPacked:
+//  - POSITION (stride 3) to USHORT4N relative to the mesh bounds. The
+//    shader restores it with position * positionScale + positionOffset.
+//  - NORMAL, TANGENT and BINORMAL (stride 3) to SHORT2N octahedral,
+//    choosing the rounding of each component that decodes closest.
+//  - TEXCOORD (stride 2) to FLOAT16_2, rounded to nearest. Streams
+//    whose error exceeds texCoordTolerance (tiled or large uvs) stay float.
+// The float streams are untouched and remain the CPU copy.
+class VertexQuantizer
+{
+  public:
+    VertexQuantizer(const Ctr::Region3f& bounds,
+                    float texCoordTolerance = 1.0f / 1024.0f);
+
+    // Returns false if the stream is left as float.
+    bool                       quantize(VertexStream* stream);
+
+    // xyz scale and offset restoring quantized positions to object space.
+    const Ctr::Vector4f&       positionScale() const;
+    const Ctr::Vector4f&       positionOffset() const;
+    bool                       octahedralNormals() const;
+
+    const VertexQuantizationError& error() const;
+
+    // Worst case position error of the bounds relative encoding.
+    float                      positionErrorBound() const;
+
+    // Element codecs, shared by the packing and the CPU decode path.
+    static void                encodePosition(const Ctr::Vector3f& position,
+                                              const Ctr::Vector4f& scale,
+                                              const Ctr::Vector4f& offset,
+                                              uint16_t* packed);
+    static Ctr::Vector3f       decodePosition(const uint16_t* packed,
+                                              const Ctr::Vector4f& scale,
+                                              const Ctr::Vector4f& offset);
+
+    static void                encodeOctahedral(const Ctr::Vector3f& direction,
+                                                int16_t* packed);
+    static Ctr::Vector3f       decodeOctahedral(const int16_t* packed);
+
+    static void                encodeTexCoord(const Ctr::Vector2f& texCoord,
+                                              uint16_t* packed);
+    static Ctr::Vector2f       decodeTexCoord(const uint16_t* packed);
+
+  private:
+    bool                       quantizePositions(VertexStream* stream);
+    bool                       quantizeDirections(VertexStream* stream);
+    bool                       quantizeTexCoords(VertexStream* stream);
+
+    Ctr::Vector4f              _positionScale;
+    Ctr::Vector4f              _positionOffset;
+    bool                       _octahedralNormals;
+    float                      _texCoordTolerance;
+    VertexQuantizationError    _error;
+};
+}
+
+#endif
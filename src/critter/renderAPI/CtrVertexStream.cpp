@@ -40,6 +40,7 @@
 //------------------------------------------------------------------------------------//
 
 #include <CtrVertexStream.h>
+#include <CtrIVertexDeclaration.h>
 #include <CtrLog.h>
 
 namespace Ctr
@@ -52,6 +53,8 @@ VertexStream::VertexStream (Ctr::DeclarationUsage usage,
     _usage (usage),
     _usageIndex (usageIndex),
     _stream (nullptr),
+    _packed (nullptr),
+    _type (Ctr::UNUSED),
     _count (countArg),
     _stride (strideArg)
 {
@@ -66,6 +69,10 @@ VertexStream::~VertexStream()
     {
         free(_stream);
     }
+    if (_packed)
+    {
+        free(_packed);
+    }
 }
 
 void
@@ -125,6 +132,50 @@ VertexStream::setStream(uint32_t strideArg,
     }
 }
 
+void
+VertexStream::setPacked(Ctr::DeclarationType type, const void* packedSrc)
+{
+    if (_packed)
+    {
+        free(_packed);
+        _packed = nullptr;
+    }
+    _type = Ctr::UNUSED;
+
+    if (packedSrc && _count > 0)
+    {
+        size_t sizeInBytes = IVertexDeclaration::elementToSize(type) * _count;
+        if (_packed = (uint8_t*)malloc(sizeInBytes))
+        {
+            memcpy(_packed, packedSrc, sizeInBytes);
+            _type = type;
+        }
+    }
+}
+
+const void*
+VertexStream::packed() const
+{
+    return _packed;
+}
+
+Ctr::DeclarationType
+VertexStream::type() const
+{
+    if (_packed)
+    {
+        return _type;
+    }
+    // FLOAT1 through FLOAT4 follow the stride.
+    return (Ctr::DeclarationType)(Ctr::FLOAT1 + _stride - 1);
+}
+
+uint32_t
+VertexStream::elementSizeInBytes() const
+{
+    return IVertexDeclaration::elementToSize(type());
+}
+
 void
 VertexStream::setStream(const float* streamSrc)
 {
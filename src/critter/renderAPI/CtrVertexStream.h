@@ -72,6 +72,15 @@ class VertexStream
     void                       setStream (uint32_t stride,
                                           uint32_t count, const float*);
 
+    // Packed GPU encoding of the stream (count elements of type).
+    // The float stream is kept as the CPU copy for bounds, tracing
+    // and picking. Until set, the stream is uploaded as FLOAT1-4.
+    void                       setPacked (Ctr::DeclarationType type,
+                                          const void* packed);
+    const void*                packed() const;
+    Ctr::DeclarationType       type() const;
+    uint32_t                   elementSizeInBytes() const;
+
     static uint32_t            id (const VertexStream&); 
     static uint32_t            id (const VertexElement& element);
 
@@ -84,6 +93,8 @@ protected:
     uint32_t                  _stride;
     uint32_t                  _count;
     float*                    _stream;
+    uint8_t*                  _packed;
+    Ctr::DeclarationType      _type;
     Ctr::DeclarationUsage      _usage;
     uint32_t                  _usageIndex;
 };
@@ -87,6 +87,7 @@ ID3D10Blob* compileShaderFromStream(const char* stream,
 ComputeShaderD3D11::ComputeShaderD3D11 (Ctr::IDevice* device) :
     Ctr::IComputeShader(device),
     _computeShader(nullptr),
+    _compiledShader(nullptr),
     _constantBuffer(nullptr),
     _direct3d(nullptr),
     _immediateCtx(nullptr)
@@ -128,11 +129,12 @@ ComputeShaderD3D11::~ComputeShaderD3D11()
 bool
 ComputeShaderD3D11::create() 
 { 
-    D3D10_SHADER_MACRO* definesPtr = nullptr;
-    if (_defines.size() > 0)
-        &_defines[0];
-
+    return loadSource() && compileSource() && finishCreate();
+}
 
+bool
+ComputeShaderD3D11::loadSource()
+{
     std::string includeStream;
     if (_includeFilePathName.length() > 0)
     {
@@ -167,23 +169,39 @@ ComputeShaderD3D11::create()
     }
 
     _stream = includeStream + "\n" + shaderStream;
+    return true;
+}
+
+bool
+ComputeShaderD3D11::compileSource()
+{
+    D3D10_SHADER_MACRO* definesPtr = nullptr;
+    if (_defines.size() > 0)
+        &_defines[0];
 
     _hash.build(_stream);
-    if (ID3DBlob* compiledShader = compileShaderFromStream(_stream.c_str(), _functionName.c_str(), "cs_5_0", definesPtr))
-    {
-        if (SUCCEEDED(_direct3d->CreateComputeShader(compiledShader->GetBufferPointer(),
-            compiledShader->GetBufferSize(), nullptr, &_computeShader)))
-        {
-            return true;
-        }
-    }
-    return false;
+    saferelease (_compiledShader);
+    _compiledShader = compileShaderFromStream(_stream.c_str(), _functionName.c_str(), "cs_5_0", definesPtr);
+    return _compiledShader != nullptr;
+}
+
+bool
+ComputeShaderD3D11::finishCreate()
+{
+    if (!_compiledShader)
+        return false;
+
+    bool created = SUCCEEDED(_direct3d->CreateComputeShader(_compiledShader->GetBufferPointer(),
+                                                            _compiledShader->GetBufferSize(), nullptr, &_computeShader));
+    saferelease (_compiledShader);
+    return created;
 }
 
 bool
 ComputeShaderD3D11::free() 
 { 
     saferelease (_computeShader);
+    saferelease (_compiledShader);
     return true;
 }
 
@@ -78,6 +78,10 @@ class ComputeShaderD3D11 : public Ctr::IComputeShader
     virtual bool                free();
     virtual bool                cache();
 
+    virtual bool                loadSource();
+    virtual bool                compileSource();
+    virtual bool                finishCreate();
+
     virtual const std::string&  filePathName() const;
     virtual const std::string&  includePathName() const;
 
@@ -86,6 +90,7 @@ class ComputeShaderD3D11 : public Ctr::IComputeShader
 
   protected:
     ID3D11ComputeShader*        _computeShader;
+    ID3DBlob*                   _compiledShader;
     ID3D11SamplerState*         _pointSampler;
     Ctr::IGpuBuffer*             _constantBuffer;
     std::vector<D3D10_SHADER_MACRO> _defines;
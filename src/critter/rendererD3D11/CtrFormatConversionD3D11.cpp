@@ -63,6 +63,8 @@ PixelFormat findFormat(DXGI_FORMAT format)
             return PF_FLOAT16_RGBA;
         case DXGI_FORMAT_R32_FLOAT:
             return PF_FLOAT32_R;
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return PF_FLOAT32_GR;
         case DXGI_FORMAT_R32G32B32_FLOAT:
             return PF_FLOAT32_RGB;
         case DXGI_FORMAT_R32G32B32A32_FLOAT:
@@ -130,6 +132,8 @@ DXGI_FORMAT findFormat(PixelFormat format)
             return DXGI_FORMAT_R16G16B16A16_FLOAT;
         case PF_FLOAT32_R:
             return DXGI_FORMAT_R32_FLOAT;
+        case PF_FLOAT32_GR:
+            return DXGI_FORMAT_R32G32_FLOAT;
         case PF_FLOAT32_RGB:
             return DXGI_FORMAT_R32G32B32_FLOAT;
         case PF_FLOAT32_RGBA:
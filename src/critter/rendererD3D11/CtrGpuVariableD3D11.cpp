@@ -150,6 +150,7 @@ GpuVariableD3D11::initialize (Ctr::IEffect* effectInterface, const int& index)
         }
     
         _semantic = semantic;
+        _semanticSymbol = Symbol::internNoCase(_semantic);
     }
 
     for (uint32_t i = 0; i < _parameterDescription.Annotations; i++)
@@ -86,7 +86,8 @@ bool IndexBufferD3D11::initialize(const Ctr::IndexBufferParameters* data)
 
 bool IndexBufferD3D11::bind(uint32_t offset) const
 {
-    _immediateCtx->IASetIndexBuffer(_indexBuffer, DXGI_FORMAT_R32_UINT, (uint32_t)(_bufferCursor + offset));
+    DXGI_FORMAT format = _resource.format() == Ctr::INDEX16 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    _immediateCtx->IASetIndexBuffer(_indexBuffer, format, (uint32_t)(_bufferCursor + offset));
     return true;
 }
 
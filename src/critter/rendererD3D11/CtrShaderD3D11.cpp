@@ -149,6 +149,7 @@ ShaderD3D11::free()
     _parameters.clear();
     _techniques.clear();
     _constantBuffers.clear();
+    clearSymbols();
 
     safedelete (_effect);
     safedeletearray(_compiledBuffer);
@@ -196,8 +197,12 @@ bool
 ShaderD3D11::create()
 {
     free();
+    return loadSource() && compileSource() && finishCreate();
+}
 
-
+bool
+ShaderD3D11::loadSource()
+{
     std::string includeStream;
     if (IShader::includeFilePathName().length() > 0)
     if (std::unique_ptr<typename DataStream> fileStream =
@@ -224,12 +229,18 @@ ShaderD3D11::create()
     }
 
     setShaderStream((includeStream+shaderStream).c_str());
+    return true;
+}
 
+bool
+ShaderD3D11::finishCreate()
+{
     if (createEffect ())
     {
         D3DX11_EFFECT_DESC desc;
         if (SUCCEEDED (_effect->effect()->GetDesc (&desc)))
         {
+            clearSymbols();
             enumerateTechniques (desc, _verbose);
             enumerateVariables (desc, _verbose);
             passVariables();
@@ -275,7 +286,7 @@ ShaderD3D11::getParameterType(Ctr::GpuVariable* variable)
 }
 
 bool 
-ShaderD3D11::createEffect ()
+ShaderD3D11::compileSource()
 {
     try
     {        
@@ -352,26 +363,33 @@ ShaderD3D11::createEffect ()
         _compiledBufferSize = shaderCode->GetBufferSize();
         _compiledBuffer = new char[_compiledBufferSize];
         memcpy (_compiledBuffer, shaderCode->GetBufferPointer(), _compiledBufferSize * sizeof(char));
-     
-        // Create effect 
-        ID3DX11Effect* effect = 0;
-        if(FAILED(D3DX11CreateEffectFromMemory(_compiledBuffer, _compiledBufferSize, 0, _direct3d, &effect))) 
-        { 
-            LOG ("FAILED to create effect from memory ... \n");
-        } 
-        else
-        {
-            _effect = new EffectD3D11 (effect);
-            return true;
-        }
+        saferelease (shaderCode);
+        return true;
     }
     catch(...)
     {
-        LOG ("Something bad and unknown happened while creating the shader");
+        LOG ("Something bad and unknown happened while compiling the shader");
     }
     return false;
 }
 
+bool 
+ShaderD3D11::createEffect ()
+{
+    if (!_compiledBuffer)
+        return false;
+
+    ID3DX11Effect* effect = 0;
+    if(FAILED(D3DX11CreateEffectFromMemory(_compiledBuffer, _compiledBufferSize, 0, _direct3d, &effect))) 
+    { 
+        LOG ("FAILED to create effect from memory ... \n");
+        return false;
+    } 
+
+    _effect = new EffectD3D11 (effect);
+    return true;
+}
+
 
 bool 
 ShaderD3D11::enumerateVariables(const D3DX11_EFFECT_DESC& desc, bool verbose)
@@ -383,6 +401,7 @@ ShaderD3D11::enumerateVariables(const D3DX11_EFFECT_DESC& desc, bool verbose)
         GpuVariableD3D11 * variable = new GpuVariableD3D11(_deviceInterface);
         variable->initialize (_effect, i);
         _parameters.push_back(variable);
+        addParameterSymbol(variable);
         
         if (variable->semantic() == "SHADERNAME")
         {
@@ -412,6 +431,7 @@ ShaderD3D11::enumerateTechniques(const D3DX11_EFFECT_DESC& desc, bool verbose)
             if (technique->initialize (_effect, techniquehandle))
             {
                 _techniques.push_back (technique);
+                addTechniqueSymbol(technique);
             }
         }
     }
@@ -452,16 +472,10 @@ bool
 ShaderD3D11::getTechniqueByName(const std::string& name, 
                            const Ctr::GpuTechnique*& technique) const
 {
-    for (auto techniqueIt = _techniques.begin();
-        techniqueIt != _techniques.end(); 
-        techniqueIt++)
+    // Every technique name was interned at create time, an unknown symbol cannot match.
+    if (getTechnique(Symbol::find(name), technique))
     {
-        const std::string& techniqueName = (*techniqueIt)->name();
-        if (techniqueName == name)
-        {
-            technique = (*techniqueIt);
-            return true;
-        }
+        return true;
     }
 
     LOG ("Failed to find technique by name = " << name << " for shader " << this->name()  << "\n");
@@ -493,17 +507,9 @@ bool
 ShaderD3D11::getParameterByName (const std::string& parameterName, 
                             const Ctr::GpuVariable*& coreVariable) const
 {
-    coreVariable = nullptr;
-
-    for (auto it = _parameters.begin();
-         it != _parameters.end();
-         it++)
+    if (getParameter(Symbol::find(parameterName), coreVariable))
     {
-        if ((*it)->name() == parameterName)
-        {
-            coreVariable = (*it);
-            return true;
-        }
+        return true;
     }
     // LOG ("Failed to find parameter by name = " << parameterName << " for shader " << name()  << "\n");
     return false;
@@ -86,6 +86,10 @@ class ShaderD3D11: public Ctr::IShader
     virtual bool                create();
     virtual bool                cache();
 
+    virtual bool                loadSource();
+    virtual bool                compileSource();
+    virtual bool                finishCreate();
+
     //----------------------------------
     // Creates a shader in the shadermgr
     //----------------------------------
@@ -137,6 +137,7 @@ Texture2DD3D11::create()
 
     bool isCubeMap = false;
     bool isTextureArray = false;
+    uint32_t residentMip = _resource->residentMip();
     const std::vector<std::string>      & filenames = ITexture::_resource->filenames();
     const std::vector<Ctr::TextureImagePtr> & images = ITexture::_resource->images();
 
@@ -177,6 +178,7 @@ Texture2DD3D11::create()
         size_t mipMapCount = images[0]->getNumMipmaps();
         if (mipMapCount == 0)
             mipMapCount = 1;
+        size_t imageMipCount = mipMapCount;
 
 
         // Force mip maps.
@@ -193,6 +195,13 @@ Texture2DD3D11::create()
 
         desc.Width = static_cast<UINT>(images[0]->getWidth());
         desc.Height = static_cast<UINT>(images[0]->getHeight());
+        if (residentMip > 0)
+        {
+            // Streamed, the images only hold the mip tail of the full chain.
+            desc.Width = _resource->width();
+            desc.Height = _resource->height();
+            mipMapCount = _resource->mipLevels();
+        }
         desc.MipLevels = static_cast<UINT>( mipMapCount );
         desc.ArraySize = static_cast<UINT>( images[0]->getNumFaces() * images.size());
         desc.Format = findFormat(flipped); 
@@ -211,34 +220,38 @@ Texture2DD3D11::create()
         _resource->setHeight((float)(desc.Height));
         _resource->setNumMipLevels(desc.MipLevels);
 
-        initData = new D3D11_SUBRESOURCE_DATA[ images.size() * images[0]->getNumFaces() * mipMapCount ];
-
-        // Load initialization data for subresource information.
-        size_t offset = 0;
-        for (size_t imageId = 0; imageId < images.size(); imageId++)
+        // Streamed levels are written once the texture exists.
+        if (residentMip == 0)
         {
-            const Ctr::TextureImagePtr& image = images[imageId];
-            for (size_t face = 0; face < image->getNumFaces(); face++)
+            initData = new D3D11_SUBRESOURCE_DATA[ images.size() * images[0]->getNumFaces() * mipMapCount ];
+
+            // Load initialization data for subresource information.
+            size_t offset = 0;
+            for (size_t imageId = 0; imageId < images.size(); imageId++)
             {
-                for (size_t m = 0; m < mipMapCount; m++)
+                const Ctr::TextureImagePtr& image = images[imageId];
+                for (size_t face = 0; face < image->getNumFaces(); face++)
                 {
-                    size_t outNumBytes = 0;
-                    size_t outNumRows = 0;
-                    size_t outRowBytes = 0;
-                    Ctr::PixelBox box = image->getPixelBox(face, m);
-
-                    GetSurfaceInfo( box.size().x,
-                                    box.size().y,
-                                    desc.Format,
-                                    &outNumBytes,
-                                    &outRowBytes,
-                                    &outNumRows);
+                    for (size_t m = 0; m < mipMapCount; m++)
+                    {
+                        size_t outNumBytes = 0;
+                        size_t outNumRows = 0;
+                        size_t outRowBytes = 0;
+                        Ctr::PixelBox box = image->getPixelBox(face, m);
+
+                        GetSurfaceInfo( box.size().x,
+                                        box.size().y,
+                                        desc.Format,
+                                        &outNumBytes,
+                                        &outRowBytes,
+                                        &outNumRows);
     
-                    initData[offset].pSysMem = box.data;
-                    initData[offset].SysMemPitch = unsigned int(outRowBytes);
-                    initData[offset].SysMemSlicePitch = unsigned int(outNumBytes);
+                        initData[offset].pSysMem = box.data;
+                        initData[offset].SysMemPitch = unsigned int(outRowBytes);
+                        initData[offset].SysMemSlicePitch = unsigned int(outNumBytes);
 
-                    offset++;
+                        offset++;
+                    }
                 }
             }
         }
@@ -305,6 +318,20 @@ Texture2DD3D11::create()
                 setTexture (map);
                 setFormat (_desc.Format);
                 safedeletearray(initData);
+                if (residentMip > 0)
+                {
+                    // Upload the mip tail and clamp sampling to it.
+                    const Ctr::TextureImagePtr& image = ITexture::_resource->images()[0];
+                    for (size_t m = 0; m < imageMipCount; m++)
+                    {
+                        for (size_t face = 0; face < image->getNumFaces(); face++)
+                        {
+                            writeSubresource(image->getPixelBox(face, m),
+                                             D3D11CalcSubresource(UINT(residentMip + m), UINT(face), _desc.MipLevels));
+                        }
+                    }
+                    setResidentMip(residentMip);
+                }
                 return true;
             }
         }
@@ -42,10 +42,28 @@
 #include <CtrTextureD3D11.h>
 #include <CtrLog.h>
 #include <CtrFormatConversionD3D11.h>
-#include <CtrFilterCubemap.h>
+#include <CtrCubemapSeamFixup.h>
+#include <CtrImageAllocator.h>
 #include <strstream>
 namespace Ctr
 {
+namespace
+{
+// Staging images for readback and export are recycled between calls.
+ImageAllocator*
+readbackImageAllocator()
+{
+    static ImageAllocator* allocator = ImageAllocator::allocator("Readback");
+    return allocator;
+}
+
+ImageAllocator*
+exportImageAllocator()
+{
+    static ImageAllocator* allocator = ImageAllocator::allocator("Export");
+    return allocator;
+}
+}
 
 template <typename T>
 void
@@ -101,10 +119,7 @@ copyMip (TextureImagePtr& dst, const TextureImagePtr& src, int32_t mipLevel)
         PixelBox dstBox = dst->getPixelBox(faceId);
         PixelBox srcBox = src->getPixelBox(faceId, mipLevel);
         // Copy A to B
-        uint8_t * dstPixels = (uint8_t*)dstBox.data;
-        uint8_t * srcPixels = (uint8_t*)srcBox.data;
-        size_t byteSize = dstBox.size().y * dstBox.rowPitch * dstBox.getNumChannels();
-        memcpy (dstPixels, srcPixels, byteSize);
+        PixelUtil::bulkPixelConversion(srcBox, dstBox);
     }
 }
 
@@ -204,6 +219,61 @@ void GetSurfaceInfo(size_t width,
     }
 }
 
+//--------------------------------------------------------------------------------------
+// Copy a mapped subresource into a pixel box. Uncompressed data is read through a
+// view of the mapped rows, so the driver row pitch and the optional red / blue swap
+// are resolved in the same pass as the copy.
+//--------------------------------------------------------------------------------------
+void
+copyMappedSubresource(const D3D11_MAPPED_SUBRESOURCE& mapped,
+                      const Ctr::PixelBox& dst,
+                      DXGI_FORMAT dxgiFormat,
+                      bool reverse)
+{
+    if (PixelUtil::isCompressed(dst.format))
+    {
+        size_t outNumBytes = 0;
+        size_t outNumRows = 0;
+        size_t outRowBytes = 0;
+        GetSurfaceInfo(dst.size().x, dst.size().y, dxgiFormat, &outNumBytes, &outRowBytes, &outNumRows);
+
+        const uint8_t* srcData = (const uint8_t*)mapped.pData;
+        uint8_t* dstData = (uint8_t*)dst.data;
+        for (size_t y = 0; y < outNumRows; y++)
+        {
+            memcpy(dstData, srcData, outRowBytes);
+            srcData += mapped.RowPitch;
+            dstData += outRowBytes;
+        }
+        return;
+    }
+
+    const size_t bytesPerPixel = PixelUtil::getNumElemBytes(dst.format);
+    Ctr::PixelBox src(dst.size().x, dst.size().y, 1, dst.format, mapped.pData);
+    if (reverse)
+    {
+        src = src.swizzled(Ctr::PixelSwizzle::redBlueSwap());
+    }
+
+    if (mapped.RowPitch % bytesPerPixel == 0)
+    {
+        src.rowPitch = ptrdiff_t(mapped.RowPitch / bytesPerPixel);
+        src.slicePitch = src.rowPitch * ptrdiff_t(dst.size().y);
+        PixelUtil::bulkPixelConversion(src, dst);
+    }
+    else
+    {
+        // Row pitch is not a whole number of texels (eg 12 byte formats).
+        for (size_t y = 0; y < dst.size().y; y++)
+        {
+            Ctr::PixelBox srcRow(src.size().x, 1, 1, src.format, (uint8_t*)mapped.pData + y * mapped.RowPitch);
+            Ctr::PixelBox dstRow(dst.size().x, 1, 1, dst.format, dst.rowData(y));
+            srcRow.swizzle = src.swizzle;
+            PixelUtil::bulkPixelConversion(srcRow, dstRow);
+        }
+    }
+}
+
 TextureD3D11::TextureD3D11(Ctr::DeviceD3D11* device) :
         Ctr::ITexture (device),
         _dxFormat (DXGI_FORMAT_UNKNOWN),
@@ -239,60 +309,27 @@ TextureD3D11::maxValue() const
 {
     if (!_maxValueCached)
     {
-        Ctr::TextureImagePtr textureImage(new Ctr::TextureImage());
+        Ctr::TextureImagePtr textureImage(new Ctr::TextureImage(readbackImageAllocator()));
 
+        // Every face and mip is copied from the mapped resource, skip the clear.
         const Ctr::TextureParameters* parameters = resource();
         textureImage->create(Ctr::Vector2i(parameters->width(), parameters->height()), 
                              parameters->format(),
                              (uint32_t)parameters->mipLevels(),
-                             parameters->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0);
+                             parameters->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0,
+                             false);
 
         Ctr::Vector4f maxValue;
 
         if (mapForRead())
         {
-            size_t dstOffset = 0;
-            size_t srcOffset = 0;
-
-            uint8_t * dstData = (uint8_t*)textureImage->getData();
-            uint32_t bytesPerPixel = (uint32_t)(bitsPerPixel(findFormat(this->format())) / 8);
-
-            for(size_t face = 0; face < textureImage->getNumFaces(); face++)
+            // Visit surfaces in image memory order.
+            textureImage->forEachPixelBox([&](size_t face, size_t m, const Ctr::PixelBox& box)
             {
-                for (size_t m = 0; m < parameters->mipLevels(); m++)
-                {
-                    map((uint32_t)face, (uint32_t)m);
-                    uint8_t * srcData = (uint8_t*)_mappedResource.pData;
-
-                    size_t outNumBytes = 0;
-                    size_t outNumRows = 0;
-                    size_t outRowBytes = 0;
-                    Ctr::PixelBox box = textureImage->getPixelBox(face, m);
-
-                    size_t dstRowPitch = box.size().x * bytesPerPixel;
-
-                    GetSurfaceInfo( box.size().x,
-                                    box.size().y,
-                                    findFormat(this->format()),
-                                    &outNumBytes,
-                                    &outRowBytes,
-                                    &outNumRows);
-
-                    // Take into account row skip alignment.
-                    for (size_t y = 0; y < outNumRows; y++)
-                    {
-                        // Copy each row for each mipmap
-                        memcpy(dstData, srcData, dstRowPitch);
-
-                        // If row stride == row bytestride.
-                        // 16 is for d3d11 cards, if d3d10 support is ever added, this must be altered to 
-                        // 4 for cards that support it.
-                        srcData += _mappedResource.RowPitch;
-                        dstData += dstRowPitch;
-                    }
-                    unmap();
-                }
-             }
+                map((uint32_t)face, (uint32_t)m);
+                copyMappedSubresource(_mappedResource, box, findFormat(this->format()), false);
+                unmap();
+            });
             unmapFromRead();
         }
 
@@ -383,74 +420,130 @@ TextureD3D11::maxValue() const
 Ctr::TextureImagePtr 
 TextureD3D11::readImage(Ctr::PixelFormat format, int32_t mipId) const
 {
-    Ctr::TextureImagePtr textureImage(new Ctr::TextureImage());
-    textureImage->create(Ctr::Vector2i(resource()->width(), resource()->height()), 
+    Ctr::TextureImagePtr textureImage(new Ctr::TextureImage(readbackImageAllocator()));
+
+    // A single level is read if mipId is set.
+    uint32_t firstMip = mipId < 0 ? 0 : std::min((uint32_t)mipId, (uint32_t)resource()->mipLevels() - 1);
+    textureImage->create(Ctr::Vector2i(std::max(resource()->width() >> firstMip, 1u), 
+                                       std::max(resource()->height() >> firstMip, 1u)), 
                          resource()->format(),
-                         (uint32_t)resource()->mipLevels(),
+                         mipId < 0 ? (uint32_t)resource()->mipLevels() : 1,
                          resource()->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0);
     bool reverse = false;
 
     if (mapForRead())
     {
-        size_t dstOffset = 0; 
-        size_t srcOffset = 0;
-
-        uint8_t * dstData = (uint8_t*)textureImage->getData();
-        uint32_t bytesPerPixel = (uint32_t)(bitsPerPixel(findFormat(this->format())) / 8);
-
-        for(size_t face = 0; face < textureImage->getNumFaces(); face++)
+        // Visit surfaces in image memory order.
+        textureImage->forEachPixelBox([&](size_t face, size_t m, const Ctr::PixelBox& box)
         {
-            for (size_t m = 0; m < resource()->mipLevels(); m++)
-            {
-                map((uint32_t)face, (uint32_t)m);
-                uint8_t * srcData = (uint8_t*)_mappedResource.pData;
-
-                size_t outNumBytes = 0;
-                size_t outNumRows = 0;
-                size_t outRowBytes = 0;
-                Ctr::PixelBox box = textureImage->getPixelBox(face, m);
+            map((uint32_t)face, (uint32_t)(m + firstMip));
+            copyMappedSubresource(_mappedResource, box, findFormat(this->format()), reverse);
+            unmap();
+        });
+        unmapFromRead();
+    }
+    return textureImage;
+}
 
-                size_t dstRowPitch = box.size().x * bytesPerPixel;
+bool
+TextureD3D11::writeImage(const Ctr::TextureImage& image)
+{
+    const Ctr::TextureParameters* parameters = resource();
+    size_t faceCount = parameters->dimension() == Ctr::CubeMap ? 6 : 1;
+    if (image.getWidth() != parameters->width() ||
+        image.getHeight() != parameters->height() ||
+        image.getNumFaces() != faceCount ||
+        PixelUtil::isCompressed(parameters->format()))
+    {
+        LOG("Cannot write image of a different size or to a compressed texture");
+        return false;
+    }
 
-                GetSurfaceInfo( box.size().x,
-                                box.size().y,
-                                findFormat(this->format()),
-                                &outNumBytes,
-                                &outRowBytes,
-                                &outNumRows);
+    // Render targets are default usage, so they are updated rather than mapped.
+    uint32_t mipLevels = (uint32_t)parameters->mipLevels();
+    uint32_t levelCount = std::min((uint32_t)image.getNumLevels(), mipLevels);
+    for (uint32_t faceId = 0; faceId < faceCount; faceId++)
+    {
+        for (uint32_t mipId = 0; mipId < levelCount; mipId++)
+        {
+            writeSubresource(image.getPixelBox(faceId, mipId),
+                             D3D11CalcSubresource(mipId, faceId, mipLevels));
+        }
+    }
+    return true;
+}
 
-                // Take into account row skip alignment.
-                for (size_t y = 0; y < outNumRows; y++)
-                {
-                    // Copy each row for each mipmap
-                    memcpy(dstData, srcData, dstRowPitch);
+bool
+TextureD3D11::writeLevel(const Ctr::TextureImage& level, uint32_t mipId)
+{
+    const Ctr::TextureParameters* parameters = resource();
+    uint32_t mipLevels = (uint32_t)parameters->mipLevels();
+    if (mipId >= mipLevels ||
+        level.getWidth() != std::max(parameters->width() >> mipId, 1u) ||
+        level.getHeight() != std::max(parameters->height() >> mipId, 1u) ||
+        level.getNumFaces() != (isCubeMap() ? 6 : 1))
+    {
+        LOG("Cannot write level " << mipId << " of a different size");
+        return false;
+    }
 
-                    // If row stride == row bytestride.
-                    // 16 is for d3d11 cards, if d3d10 support is ever added, this must be altered to 
-                    // 4 for cards that support it.
-                    srcData += _mappedResource.RowPitch;
+    for (uint32_t faceId = 0; faceId < level.getNumFaces(); faceId++)
+    {
+        if (!writeSubresource(level.getPixelBox(faceId, 0),
+                              D3D11CalcSubresource(mipId, faceId, mipLevels)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-                    if (reverse)
-                    {
-                        for (size_t x = 0; x < box.size().x; x++)
-                        {
-                            // RGBA8 only.
-                            char b = dstData[(x*4)];
-                            char g = dstData[(x*4)+1];
-                            char r = dstData[(x*4)+2];
-                            dstData[(x*4)] = r;
-                            dstData[(x*4)+1] = g;
-                            dstData[(x*4)+2] = b;
-                        }
-                    }
-                    dstData += dstRowPitch;
-                }
-                unmap();
-            }
-         }
-        unmapFromRead();
+void
+TextureD3D11::setResidentMip(uint32_t mipId)
+{
+    ITexture::setResidentMip(mipId);
+    if (_texture)
+    {
+        // Clamps every view of the resource, levels above it may hold garbage.
+        _immediateCtx->SetResourceMinLOD(_texture, float(mipId));
     }
-    return textureImage;
+}
+
+bool
+TextureD3D11::writeSubresource(const Ctr::PixelBox& source, uint32_t subresource)
+{
+    PixelFormat format = resource()->format();
+    const void* data = source.rowData(0);
+    size_t rowPitch = source.size().x * PixelUtil::getNumElemBytes(source.format);
+    std::vector<uint8_t> staging;
+    if (PixelUtil::isCompressed(format))
+    {
+        if (source.format != format)
+        {
+            LOG("Cannot convert to a compressed format");
+            return false;
+        }
+        // Compressed rows are rows of blocks.
+        GetSurfaceInfo(source.size().x, source.size().y, dxFormat(), nullptr, &rowPitch, nullptr);
+    }
+    else if (source.format != format || !source.isConsecutive())
+    {
+        // Flipped, swizzled and sub volume views are packed on the way.
+        size_t elementSize = PixelUtil::getNumElemBytes(format);
+        staging.resize(source.size().x * source.size().y * elementSize);
+        Ctr::PixelBox converted(source.size().x, source.size().y, 1, format, &staging[0]);
+        PixelUtil::bulkPixelConversion(source, converted);
+        data = &staging[0];
+        rowPitch = source.size().x * elementSize;
+    }
+
+    _immediateCtx->UpdateSubresource(texture(),
+                                     subresource,
+                                     nullptr,
+                                     data,
+                                     (UINT)rowPitch,
+                                     0);
+    return true;
 }
 
 bool
@@ -461,7 +554,7 @@ TextureD3D11::save(const std::string& filePathName,
                    int32_t mipLevel,
                    const Ctr::ITexture* mergeMap) const
 {
-    Ctr::TextureImagePtr textureImage(new Ctr::TextureImage());
+    Ctr::TextureImagePtr textureImage(new Ctr::TextureImage(exportImageAllocator()));
     Ctr::TextureImagePtr textureImageRGB;
     Ctr::TextureImagePtr textureImageMMM;
     Ctr::TextureImagePtr mipImage;
@@ -502,12 +595,12 @@ TextureD3D11::save(const std::string& filePathName,
         if (threeChannelFormat != PF_UNKNOWN)
         {
             const Ctr::TextureParameters* parameters = resource();
-            textureImageRGB.reset(new Ctr::TextureImage());
+            textureImageRGB.reset(new Ctr::TextureImage(exportImageAllocator()));
             textureImageRGB->create(Ctr::Vector2i(parameters->width(), parameters->height()), 
                                     threeChannelFormat,
                                     (uint32_t)parameters->mipLevels(),
                                     parameters->dimension() == Ctr::CubeMap ? IF_CUBEMAP : 0);
-            textureImageMMM.reset(new Ctr::TextureImage());
+            textureImageMMM.reset(new Ctr::TextureImage(exportImageAllocator()));
             textureImageMMM->create(Ctr::Vector2i(parameters->width(), parameters->height()), 
                                     threeChannelFormat,
                                     (uint32_t)parameters->mipLevels(),
@@ -529,7 +622,7 @@ TextureD3D11::save(const std::string& filePathName,
             format = threeChannelFormat;
         }
 
-        mipImage = TextureImagePtr(new Ctr::TextureImage());
+        mipImage = TextureImagePtr(new Ctr::TextureImage(exportImageAllocator()));
         mipImage->create(Ctr::Vector2i((int32_t)sourceBox.size().x, 
                                        (int32_t)sourceBox.size().y),
                          format, 1, 
@@ -539,63 +632,13 @@ TextureD3D11::save(const std::string& filePathName,
 
     if (mapForRead())
     {
-        size_t dstOffset = 0;
-        size_t srcOffset = 0;
-
-        uint8_t * dstData = (uint8_t*)textureImage->getData();
-        size_t bytesPerPixel = bitsPerPixel(findFormat(this->format())) / 8;
-
-        for(size_t face = 0; face < textureImage->getNumFaces(); face++)
+        // Visit surfaces in image memory order.
+        textureImage->forEachPixelBox([&](size_t face, size_t m, const Ctr::PixelBox& box)
         {
-            for (size_t m = 0; m < parameters->mipLevels(); m++)
-            {
-                map((uint32_t)face, (uint32_t)(m));
-                uint8_t * srcData = (uint8_t*)_mappedResource.pData;
-
-                size_t outNumBytes = 0;
-                size_t outNumRows = 0;
-                size_t outRowBytes = 0;
-                Ctr::PixelBox box = textureImage->getPixelBox(face, m);
-
-                size_t dstRowPitch = box.size().x * bytesPerPixel;
-
-                GetSurfaceInfo( box.size().x,
-                                box.size().y,
-                                findFormat(this->format()),
-                                &outNumBytes,
-                                &outRowBytes,
-                                &outNumRows);
-
-                // Take into account row skip alignment.
-                for (size_t y = 0; y < outNumRows; y++)
-                {
-                    // Copy each row for each mipmap
-                    memcpy(dstData, srcData, dstRowPitch);
-
-                    // If row stride == row bytestride.
-                    // 16 is for d3d11 cards, if d3d10 support is ever added, this must be altered to 
-                    // 4 for cards that support it.
-                    srcData += _mappedResource.RowPitch;
-
-                    if (reverse)
-                    {
-                        for (size_t x = 0; x < box.size().x; x++)
-                        {
-                            // RGBA8 only.
-                            char b = dstData[(x*4)];
-                            char g = dstData[(x*4)+1];
-                            char r = dstData[(x*4)+2];
-                            dstData[(x*4)] = r;
-                            dstData[(x*4)+1] = g;
-                            dstData[(x*4)+2] = b;
-                        }
-                    }
-
-                    dstData += dstRowPitch;
-                }
-                unmap();
-            }
-         }
+            map((uint32_t)face, (uint32_t)m);
+            copyMappedSubresource(_mappedResource, box, findFormat(this->format()), reverse);
+            unmap();
+        });
         unmapFromRead();
 
         // Merge the merge map into texture Image.
@@ -644,31 +687,7 @@ TextureD3D11::save(const std::string& filePathName,
             }
         }
 
-        if (this->isCubeMap())
-        {
-            if (parameters->format() == Ctr::PF_A8R8G8B8)
-            {
-                for (uint32_t mipId = 0; mipId < textureImage->getNumMipmaps(); mipId++)
-                {
-                    PixelBox mip = textureImage->getPixelBox();
-                    fixupCubeEdges <uint8_t> (textureImage, 
-                                              mipId,
-                                              CP_FIXUP_AVERAGE_HERMITE, 
-                                              Ctr::maxValue(mip.size().x * 0.015f, 1.0f));
-                }
-            }
-            else if (parameters->format() == PixelFormat::PF_FLOAT32_RGBA)
-            {
-                for (uint32_t mipId = 0; mipId < textureImage->getNumMipmaps(); mipId++)
-                {
-                    PixelBox mip = textureImage->getPixelBox();
-                    fixupCubeEdges <float> (textureImage, 
-                                            mipId,
-                                            CP_FIXUP_AVERAGE_HERMITE, 
-                                            Ctr::maxValue(mip.size().x * 0.015f, 1.0f));
-                }
-            }
-        }
+        CubemapSeamFixup::fixupForExport(textureImage);
 
         // TODO: Filter for cubemap.
         if (splitChannels || rgbOnly)
@@ -103,6 +103,10 @@ protected:
 
     virtual Ctr::TextureImagePtr readImage(Ctr::PixelFormat format, int32_t mipId = -1) const;
 
+    virtual bool               writeImage(const Ctr::TextureImage& image);
+    virtual bool               writeLevel(const Ctr::TextureImage& level, uint32_t mipId);
+    virtual void               setResidentMip(uint32_t mipId);
+
     DXGI_FORMAT                dxFormat() const;
 
     // Write a pixel
@@ -133,6 +137,10 @@ protected:
 
   protected:
     virtual void                 setFormat (DXGI_FORMAT format);
+    // Update a default usage subresource from a pixel box, converting
+    // uncompressed data to the texture format.
+    bool                         writeSubresource(const Ctr::PixelBox& source,
+                                                  uint32_t subresource);
 
     ID3D11Resource *             _texture;
     ID3D11ShaderResourceView *   _resourceView;
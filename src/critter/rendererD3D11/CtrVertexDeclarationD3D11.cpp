@@ -143,6 +143,24 @@ typeToFormat (Ctr::DeclarationType type)
             return DXGI_FORMAT_R32_FLOAT;
         case Ctr::UBYTE4:
             return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case Ctr::UBYTE4N:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case Ctr::SHORT2:
+            return DXGI_FORMAT_R16G16_SINT;
+        case Ctr::SHORT4:
+            return DXGI_FORMAT_R16G16B16A16_SINT;
+        case Ctr::SHORT2N:
+            return DXGI_FORMAT_R16G16_SNORM;
+        case Ctr::SHORT4N:
+            return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case Ctr::USHORT2N:
+            return DXGI_FORMAT_R16G16_UNORM;
+        case Ctr::USHORT4N:
+            return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case Ctr::FLOAT16_2:
+            return DXGI_FORMAT_R16G16_FLOAT;
+        case Ctr::FLOAT16_4:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
         case Ctr::UINT8:
             return DXGI_FORMAT_R8_UINT;
         case Ctr::UINT32:
@@ -47,6 +47,7 @@
 #include <CtrTypedProperty.h>
 #include <CtrIDevice.h>
 #include <CtrBitwise.h>
+#include <CtrProfiler.h>
 #include <ppl.h>
 
 namespace Ctr
@@ -276,28 +277,33 @@ namespace Ctr
 
     struct ConvertImage
     {
+        // Rows are converted in at most this many bands, one profile zone
+        // each, so large images do not flood the worker event rings.
+        enum
+        {
+            MaxBands = 64
+        };
+
+        // Rows are addressed through pitches (in components, and possibly negative),
+        // so flipped views and sub rectangles convert without an intermediate copy.
         template <typename T, typename S>
-        void convert(size_t rowId,
-                    T* dst,
-                    S* src,
+        void convert(T* dst,
+                    const S* src,
                     size_t width,
-                    size_t height,
                     size_t dstChannels,
                     size_t srcChannels,
-                    uint32_t * channelMapping,
+                    const uint32_t * channelMapping,
                     float   dstGamma,
                     float   srcGamma)
         {
             ConvertPixel convertPixel;
-            size_t dstOffset = (width * rowId) * dstChannels;
-            size_t srcOffset = (width * rowId) * srcChannels;
 
             if (Ctr::Limits<float>::isEqual(dstGamma, srcGamma))
             {
                 for (uint32_t i = 0; i < width; i++)
                 {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
+                    size_t dstPixelId = i * dstChannels;
+                    size_t srcPixelId = i * srcChannels;
                     for (uint32_t c = 0; c < dstChannels; c++)
                     {
                         uint32_t srcChannel = channelMapping[c];
@@ -310,8 +316,8 @@ namespace Ctr
                 float power = srcGamma/dstGamma;
                 for (uint32_t i = 0; i < width; i++)
                 {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
+                    size_t dstPixelId = i * dstChannels;
+                    size_t srcPixelId = i * srcChannels;
                     for (uint32_t c = 0; c < dstChannels; c++)
                     {
                         uint32_t srcChannel = channelMapping[c];
@@ -322,11 +328,9 @@ namespace Ctr
         }
 
         template <typename T, typename S>
-        void convert(size_t rowId,
-            T* dst,
-            S* src,
+        void convert(T* dst,
+            const S* src,
             size_t width,
-            size_t height,
             size_t dstChannels,
             size_t srcChannels,
             float   dstGamma,
@@ -336,12 +340,10 @@ namespace Ctr
 
             if (Ctr::Limits<float>::isEqual(dstGamma, srcGamma))
             {
-                size_t dstOffset = (width * rowId) * dstChannels;
-                size_t srcOffset = (width * rowId) * srcChannels;
                 for (uint32_t i = 0; i < width; i++)
                 {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
+                    size_t dstPixelId = i * dstChannels;
+                    size_t srcPixelId = i * srcChannels;
                     for (uint32_t c = 0; c < dstChannels; c++)
                         convertPixel(dst[dstPixelId+c], src[srcPixelId + c]);
                 }
@@ -349,12 +351,10 @@ namespace Ctr
             else
             {
                 float power = srcGamma / dstGamma;
-                size_t dstOffset = (width * rowId) * dstChannels;
-                size_t srcOffset = (width * rowId) * srcChannels;
                 for (uint32_t i = 0; i < width; i++)
                 {
-                    size_t dstPixelId = dstOffset + (i * dstChannels);
-                    size_t srcPixelId = srcOffset + (i * srcChannels);
+                    size_t dstPixelId = i * dstChannels;
+                    size_t srcPixelId = i * srcChannels;
                     for (uint32_t c = 0; c < dstChannels; c++)
                         convertPixel(dst[dstPixelId + c], src[srcPixelId + c], power);
                 }
@@ -363,29 +363,38 @@ namespace Ctr
 
         template <typename T, typename S>
         void convert(T* dst, 
-                     S* src,
+                     const S* src,
                      size_t width,
                      size_t height,
+                     ptrdiff_t dstRowPitch,
+                     ptrdiff_t srcRowPitch,
                      size_t dstChannels,
                      size_t srcChannels,
-                     uint32_t * channelMapping,
+                     const uint32_t * channelMapping,
                      float   dstGamma,
                      float   srcGamma)
         {
-            if (channelMapping)
-            {
-                concurrency::parallel_for(size_t(0), size_t(height), [&](size_t rowId)
-                {
-                    convert(rowId, dst, src, width, height, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
-                });
-            }
-            else
+            CTR_PROFILE_ZONE("ImageConversion::convert");
+            size_t bandRows = (height + MaxBands - 1) / MaxBands;
+            size_t bandCount = bandRows > 0 ? (height + bandRows - 1) / bandRows : 0;
+            concurrency::parallel_for(size_t(0), bandCount, [&](size_t bandId)
             {
-                concurrency::parallel_for(size_t(0), size_t(height), [&](size_t rowId)
+                CTR_PROFILE_ZONE("ImageConversion::band");
+                size_t lastRowId = minValue((bandId + 1) * bandRows, height);
+                for (size_t rowId = bandId * bandRows; rowId < lastRowId; rowId++)
                 {
-                    convert(rowId, dst, src, width, height, dstChannels, srcChannels, dstGamma, srcGamma);
-                });
-            }
+                    if (channelMapping)
+                    {
+                        convert(dst + ptrdiff_t(rowId) * dstRowPitch, src + ptrdiff_t(rowId) * srcRowPitch,
+                                width, dstChannels, srcChannels, channelMapping, dstGamma, srcGamma);
+                    }
+                    else
+                    {
+                        convert(dst + ptrdiff_t(rowId) * dstRowPitch, src + ptrdiff_t(rowId) * srcRowPitch,
+                                width, dstChannels, srcChannels, dstGamma, srcGamma);
+                    }
+                }
+            });
         }
 
         uint32_t* defaultChannelMapping(size_t dstComponents, size_t srcComponents)
@@ -475,11 +484,20 @@ namespace Ctr
                      Ctr::TextureImagePtr& srcImage, float srcGamma,
                      uint32_t* channelMapping = nullptr)
         {
-            Ctr::PixelFormat dstFormat = dstImage->getFormat();
-            Ctr::PixelFormat srcFormat = srcImage->getFormat();
+            convert(dstImage->getPixelBox(0, 0), dstGamma, 
+                    srcImage->getPixelBox(0, 0), srcGamma, 
+                    channelMapping);
+        }
 
-            Ctr::PixelBox dstPixelBox = dstImage->getPixelBox(0, 0);
-            Ctr::PixelBox srcPixelBox = srcImage->getPixelBox(0, 0);
+        // Converts the top slice of srcPixelBox into dstPixelBox. Either box may be a
+        // view (negative row pitch, sub rectangle, swizzle); swizzles are folded into
+        // the channel mapping so no pixels are moved twice.
+        void convert(const Ctr::PixelBox& dstPixelBox, float dstGamma, 
+                     const Ctr::PixelBox& srcPixelBox, float srcGamma,
+                     const uint32_t* channelMapping = nullptr)
+        {
+            Ctr::PixelFormat dstFormat = dstPixelBox.format;
+            Ctr::PixelFormat srcFormat = srcPixelBox.format;
 
             Ctr::PixelComponentType dstType = PixelUtil::getComponentType(dstFormat);
             Ctr::PixelComponentType srcType = PixelUtil::getComponentType(srcFormat);
@@ -487,120 +505,140 @@ namespace Ctr
             size_t dstComponents = PixelUtil::getComponentCount(dstFormat);
             size_t srcComponents = PixelUtil::getComponentCount(srcFormat);
 
-            size_t width = dstImage->getWidth();
-            size_t height = dstImage->getHeight();
+            size_t width = dstPixelBox.size().x;
+            size_t height = dstPixelBox.size().y;
 
             if (channelMapping == nullptr && srcComponents != dstComponents)
             {
                 channelMapping = defaultChannelMapping(dstComponents, srcComponents);
             }
 
+            uint32_t swizzledMapping[4];
+            if (!dstPixelBox.swizzle.isIdentity() || !srcPixelBox.swizzle.isIdentity())
+            {
+                // Physical dst component c holds logical component l, which reads
+                // logical src component mapping[l], stored at swizzle[mapping[l]].
+                Ctr::PixelSwizzle dstInverse = dstPixelBox.swizzle.inverse();
+                for (uint32_t c = 0; c < dstComponents; c++)
+                {
+                    uint32_t logical = dstInverse.channel[c];
+                    uint32_t source = channelMapping ? channelMapping[logical] : logical;
+                    swizzledMapping[c] = srcPixelBox.swizzle.channel[source];
+                }
+                channelMapping = swizzledMapping;
+            }
+
+            void* dstData = dstPixelBox.rowData(0);
+            const void* srcData = srcPixelBox.rowData(0);
+            ptrdiff_t dstPitch = dstPixelBox.rowPitch * ptrdiff_t(dstComponents);
+            ptrdiff_t srcPitch = srcPixelBox.rowPitch * ptrdiff_t(srcComponents);
+
             switch (dstType)
             {
                 case PCT_BYTE:
                 {
-                    uint8_t* dst = (uint8_t*)(dstPixelBox.data);
+                    uint8_t* dst = (uint8_t*)(dstData);
                     switch (srcType)
                     {
                         case PCT_BYTE:
                         {
-                            return convert(dst, (uint8_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint8_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_SHORT:
                         {
-                            return convert(dst, (uint16_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint16_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT16:
                         {
-                            return convert(dst, (half*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const half*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT32:
                         {
-                            return convert(dst, (float*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const float*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                     }
                 }
                 case PCT_SHORT:
                 {
-                    uint16_t* dst = (uint16_t*)(dstPixelBox.data);
+                    uint16_t* dst = (uint16_t*)(dstData);
                     switch (srcType)
                     {
                        case PCT_BYTE:
                         {
-                            return convert(dst, (uint8_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint8_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_SHORT:
                         {
-                            return convert(dst, (uint16_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint16_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT16:
                         {
-                            return convert(dst, (half*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const half*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT32:
                         {
-                            return convert(dst, (float*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const float*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                     }
                 }
                 case PCT_FLOAT16:
                 {
-                    uint16_t* dst = (uint16_t*)(dstPixelBox.data);
+                    uint16_t* dst = (uint16_t*)(dstData);
                     switch (srcType)
                     {
                         case PCT_BYTE:
                         {
-                            return convert(dst, (uint8_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint8_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_SHORT:
                         {
-                            return convert(dst, (uint16_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint16_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT16:
                         {
-                            return convert(dst, (half*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const half*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT32:
                         {
-                            return convert(dst, (float*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const float*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                     }
                 }
                 case PCT_FLOAT32:
                 {
-                    float* dst = (float*)(dstPixelBox.data);
+                    float* dst = (float*)(dstData);
                     switch (srcType)
                     {
                         case PCT_BYTE:
                         {
-                            return convert(dst, (uint8_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint8_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_SHORT:
                         {
-                            return convert(dst, (uint16_t*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const uint16_t*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT16:
                         {
-                            return convert(dst, (half*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const half*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                         case PCT_FLOAT32:
                         {
-                            return convert(dst, (float*)(srcPixelBox.data), width, height, dstComponents, srcComponents,
+                            return convert(dst, (const float*)(srcData), width, height, dstPitch, srcPitch, dstComponents, srcComponents,
                                            channelMapping, dstGamma, srcGamma);
                         }
                     }
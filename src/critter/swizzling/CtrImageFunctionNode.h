@@ -48,6 +48,8 @@
 #include <CtrImageConversion.h>
 #include <CtrITexture.h>
 #include <CtrTextureMgr.h>
+#include <CtrImageAllocator.h>
+#include <CtrProfiler.h>
 #include <ppl.h>
 #include <CtrVector3.h>
 
@@ -56,6 +58,13 @@ namespace Ctr
 class ImageNode;
 class TextureImageNode;
 
+// Transient images produced while evaluating the swizzling graph.
+inline ImageAllocator*
+swizzlingImageAllocator()
+{
+    static ImageAllocator* allocator = ImageAllocator::allocator("Swizzling");
+    return allocator;
+}
 
 // Later:
 // Bump amount.
@@ -105,6 +114,28 @@ public:
     {
     }
 
+    // Per pixel functions can be evaluated one span at a time,
+    // straight from their sources (see ImageKernelFusion).
+    virtual bool               fusable() const
+    {
+        return false;
+    }
+
+    // Cache options for the sources, return the result dimensions.
+    virtual void               prepareStage(const std::vector<Ctr::PixelBox>& sources,
+                                            size_t& width,
+                                            size_t& height,
+                                            size_t& components) const
+    {
+    }
+
+    // Process one span of pixels. Sources and destination start at the span.
+    virtual void               processSpan(size_t width,
+                                           const std::vector<Ctr::PixelBox>& sources,
+                                           Ctr::PixelBox& destination) const
+    {
+    }
+
     const TextureImageProperty*     imageResultProperty() const
     {
         return _imageResultProperty;
@@ -152,11 +183,12 @@ public:
         Ctr::TextureImagePtr sourceImage = _imageResultProperty->get();
         if (PixelUtil::getComponentCount(sourceImage->getFormat()) != 4)
         {
-            Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage());
+            Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage(swizzlingImageAllocator()));
             convertedImage->create(Ctr::Vector2i(int32_t(sourceImage->getWidth()), int32_t(sourceImage->getHeight())),
                 PF_FLOAT32_RGBA,
                 (uint32_t)(0) /* no mips*/,
-                IF_DEFAULT);
+                IF_DEFAULT,
+                false);
             ConvertImage converter;
             // Implicit channel remapping to debug output.
             converter.convert(convertedImage, 1.0f, sourceImage, 1.0f);
@@ -172,11 +204,12 @@ public:
     {
         Ctr::TextureImagePtr sourceImage = _convertedRGBAImageProperty->get();
 
-        Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage());
+        Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage(swizzlingImageAllocator()));
         convertedImage->create(Ctr::Vector2i(int32_t(sourceImage->getWidth()), int32_t(sourceImage->getHeight())),
             PF_A8R8G8B8,
             (uint32_t)(0),
-            IF_DEFAULT);
+            IF_DEFAULT,
+            false);
 
         FloatProperty* gammaDisplayProperty =
             dynamic_cast<FloatProperty*>(_node->property("gammaDisplay"));
@@ -206,12 +239,13 @@ public:
         }
         else
         {
-            Ctr::TextureImagePtr mipChainImage(new Ctr::TextureImage());
+            Ctr::TextureImagePtr mipChainImage(new Ctr::TextureImage(swizzlingImageAllocator()));
             mipChainImage->create(
                 Ctr::Vector2i(int32_t(sourceImage->getWidth()), int32_t(sourceImage->getHeight())),
                 PF_A8R8G8B8,
                 mipLevels,
-                IF_DEFAULT);
+                IF_DEFAULT,
+                false);
             int32_t mipWidth = int32_t(convertedImage->getWidth());
             int32_t mipHeight = int32_t(convertedImage->getHeight());
 
@@ -229,11 +263,12 @@ public:
                     if (resampleLevel0)
                     {
                         // Create temporary, copy and resize.
-                        Ctr::TextureImagePtr resizedConvertedImage(new Ctr::TextureImage());
+                        Ctr::TextureImagePtr resizedConvertedImage(new Ctr::TextureImage(swizzlingImageAllocator()));
                         resizedConvertedImage->create(Ctr::Vector2i(int32_t(convertedImage->getWidth()), int32_t(convertedImage->getHeight())),
                             PF_A8R8G8B8,
                             (uint32_t)(0),
-                            IF_DEFAULT);
+                            IF_DEFAULT,
+                            false);
 
                         // Resize to mip size.
                         {
@@ -370,11 +405,12 @@ class ImageFileSourceFunction : public ImageFunction
             sourceImage->resize(commonSize.x, commonSize.y);
         }
 
-        Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage());
+        Ctr::TextureImagePtr convertedImage(new Ctr::TextureImage(swizzlingImageAllocator()));
         convertedImage->create(Ctr::Vector2i(int32_t(sourceImage->getWidth()), int32_t(sourceImage->getHeight())),
             PF_FLOAT32_RGBA,
             (uint32_t)(0) /* no mips*/,
-            IF_DEFAULT);
+            IF_DEFAULT,
+            false);
 
         FloatProperty* gammaInProperty = 
             dynamic_cast<FloatProperty*>(_node->property("gammaIn"));
@@ -397,6 +433,215 @@ class ImageFileSourceFunction : public ImageFunction
     }
 };
 
+inline PixelFormat
+floatFormatForComponents(size_t componentCount)
+{
+    switch (componentCount)
+    {
+        case 1:
+            return PF_FLOAT32_R;
+        case 2:
+            return PF_FLOAT32_GR;
+        case 3:
+            return PF_FLOAT32_RGB;
+        case 4:
+            return PF_FLOAT32_RGBA;
+        default:
+            IBLASSERT(0, "Unknown channel count");
+    }
+    return PF_UNKNOWN;
+}
+
+//------------------------------------------------------------
+// ImageKernelFusion
+//
+// Compiles the graph of per pixel processors above a root
+// into a single kernel. An upstream processor is folded in
+// when its result is not cached and the root graph is its only
+// consumer, every other input is materialized as before.
+// The kernel walks the image one row span at a time, and
+// intermediate results live in a small scratch buffer sized
+// to stay in L1, so only the final image is written.
+//------------------------------------------------------------
+class ImageKernelFusion
+{
+  public:
+    enum
+    {
+        MaxSources = 5,
+        ScratchBytes = 32 * 1024,
+        MinimumSpan = 64,
+        BandRows = 16
+    };
+
+    ImageKernelFusion() :
+        _fuse(true)
+    {
+    }
+
+    void                       compile(const ImageFunction* root)
+    {
+        _stages.clear();
+        _images.clear();
+        addStage(root);
+
+        // Fused stages index each other by the root's dimensions.
+        for (auto it = _stages.begin(); it != _stages.end(); it++)
+        {
+            if (it->width != imageWidth() || it->height != imageHeight())
+            {
+                if (_fuse)
+                {
+                    _fuse = false;
+                    compile(root);
+                }
+                return;
+            }
+        }
+    }
+
+    size_t                     imageWidth() const { return _stages.back().width; }
+    size_t                     imageHeight() const { return _stages.back().height; }
+    PixelFormat                format() const { return _stages.back().format; }
+    size_t                     stageCount() const { return _stages.size(); }
+
+    void                       run(Ctr::PixelBox& destination) const
+    {
+        size_t width = imageWidth();
+        size_t height = imageHeight();
+
+        // Span length that keeps every intermediate in L1.
+        size_t scratchComponents = 0;
+        for (size_t stageId = 0; stageId + 1 < _stages.size(); stageId++)
+            scratchComponents += _stages[stageId].components;
+
+        size_t span = width;
+        if (scratchComponents > 0)
+        {
+            span = ScratchBytes / (scratchComponents * sizeof(float));
+            span = minValue(maxValue(span, size_t(MinimumSpan)), width);
+        }
+
+        // Rows are processed in bands so scratch is allocated once per band, not per row.
+        size_t bandCount = (height + BandRows - 1) / BandRows;
+        concurrency::parallel_for(size_t(0), bandCount, [&](size_t bandId)
+        {
+            CTR_PROFILE_ZONE("ImageKernelFusion::band");
+            std::vector<float> scratch(span * scratchComponents);
+            std::vector<Ctr::PixelBox> stageOutputs(_stages.size());
+            std::vector<Ctr::PixelBox> sources(MaxSources);
+
+            size_t lastRowId = minValue((bandId + 1) * size_t(BandRows), height);
+            for (size_t rowId = bandId * BandRows; rowId < lastRowId; rowId++)
+            {
+                for (size_t columnId = 0; columnId < width; columnId += span)
+                {
+                    size_t spanWidth = minValue(span, width - columnId);
+                    float* scratchPtr = scratch.empty() ? nullptr : &scratch[0];
+                    for (size_t stageId = 0; stageId < _stages.size(); stageId++)
+                    {
+                        const Stage& stage = _stages[stageId];
+                        for (size_t sourceId = 0; sourceId < MaxSources; sourceId++)
+                        {
+                            if (stage.inputs[sourceId] >= 0)
+                                sources[sourceId] = stageOutputs[stage.inputs[sourceId]];
+                            else if (stage.images[sourceId].data)
+                                sources[sourceId] = rebase(stage.images[sourceId], rowId, columnId, spanWidth, width);
+                            else
+                                sources[sourceId] = stage.images[sourceId];
+                        }
+
+                        if (stageId + 1 == _stages.size())
+                        {
+                            stageOutputs[stageId] = rebase(destination, rowId, columnId, spanWidth, width);
+                        }
+                        else
+                        {
+                            stageOutputs[stageId] = Ctr::PixelBox(spanWidth, 1, 1, stage.format, scratchPtr);
+                            scratchPtr += spanWidth * stage.components;
+                        }
+                        stage.function->processSpan(spanWidth, sources, stageOutputs[stageId]);
+                    }
+                }
+            }
+        });
+    }
+
+  private:
+    struct Stage
+    {
+        const ImageFunction*   function;
+        int32_t                inputs[MaxSources];
+        Ctr::PixelBox          images[MaxSources];
+        size_t                 width;
+        size_t                 height;
+        size_t                 components;
+        PixelFormat            format;
+    };
+
+    static Ctr::PixelBox       rebase(const Ctr::PixelBox& image,
+                                      size_t rowId,
+                                      size_t columnId,
+                                      size_t spanWidth,
+                                      size_t imageWidth)
+    {
+        size_t components = PixelUtil::getComponentCount(image.format);
+        float* data = (float*)image.data + (rowId * imageWidth + columnId) * components;
+        return Ctr::PixelBox(spanWidth, 1, 1, image.format, data);
+    }
+
+    int32_t                    addStage(const ImageFunction* function)
+    {
+        for (size_t stageId = 0; stageId < _stages.size(); stageId++)
+        {
+            if (_stages[stageId].function == function)
+                return int32_t(stageId);
+        }
+
+        Stage stage;
+        stage.function = function;
+        std::vector<Ctr::PixelBox> sources;
+        for (uint32_t sourceId = 0; sourceId < MaxSources; sourceId++)
+        {
+            stage.inputs[sourceId] = -1;
+            stage.images[sourceId] = Ctr::PixelBox(0, 0, 0, PF_UNKNOWN, nullptr);
+
+            const TextureImageProperty* sourceProperty = function->imageDependency(sourceId);
+            if (sourceProperty)
+            {
+                const ImageFunction* producer = dynamic_cast<const ImageFunction*>(sourceProperty->node());
+                if (_fuse && producer && producer->fusable() &&
+                    !sourceProperty->cached() && sourceProperty->referenceCount() == 1)
+                {
+                    int32_t producerId = addStage(producer);
+                    const Stage& producerStage = _stages[producerId];
+                    stage.inputs[sourceId] = producerId;
+                    stage.images[sourceId] = Ctr::PixelBox(producerStage.width, producerStage.height, 1,
+                                                           producerStage.format, nullptr);
+                }
+                else
+                {
+                    Ctr::TextureImagePtr sourceImage = sourceProperty->get();
+                    _images.push_back(sourceImage);
+                    // Image functions produce a single face, single mip image, only the top level is read.
+                    stage.images[sourceId] = sourceImage->getPixelBox(0, 0);
+                }
+            }
+            sources.push_back(stage.images[sourceId]);
+        }
+
+        function->prepareStage(sources, stage.width, stage.height, stage.components);
+        stage.format = floatFormatForComponents(stage.components);
+        _stages.push_back(stage);
+        return int32_t(_stages.size() - 1);
+    }
+
+    bool                       _fuse;
+    std::vector<Stage>         _stages;
+    // Keeps materialized inputs alive while the kernel runs.
+    std::vector<Ctr::TextureImagePtr> _images;
+};
+
 enum ImageProcessorMips
 {
     MatchMips,
@@ -1193,70 +1438,46 @@ class ImageProcessorFunction : public ImageFunctionT
 
     void computeImage(const Property* property) const
     {
+        CTR_PROFILE_ZONE("ImageProcessorFunction::computeImage");
 
-        std::vector<Ctr::TextureImagePtr> sourceImages;
-        std::vector<Ctr::PixelBox> sources;
-        // Processor nodes are always assumed to be float.
-        std::vector<const float*> sourcePtrs;
-        for (uint32_t sourceId = 0; sourceId < 5; sourceId++)
-        {
-            const TextureImageProperty* sourceProperty = 
-                imageDependency(sourceId);
+        // Fold exclusively owned upstream processors into one kernel.
+        ImageKernelFusion fusion;
+        fusion.compile(this);
 
-            if (!sourceProperty)
-            {
-                // IBLASSERT(0, "Invalid source for input image " << sourceId);
-                // Todo ... make less shit.
-                sources.push_back(Ctr::PixelBox());
-            }
-            else
-            {
-                Ctr::TextureImagePtr sourceImage = sourceProperty->get();
-                // TODO: Mips and faces later.
-                size_t faceId = 0;
-                size_t mipId = 0;
-                Ctr::PixelBox sourcePixelBox = sourceImage->getPixelBox(faceId, mipId);
-                sources.push_back(sourcePixelBox);
-            }
-        }
-
-        cacheProcessingOptions(sources);
-        size_t _imageWidth = imageWidth();
-        size_t _imageHeight = imageHeight();
+        Ctr::TextureImagePtr destinationImage(new Ctr::TextureImage(swizzlingImageAllocator()));
+        destinationImage->create(Ctr::Vector2i(int32_t(fusion.imageWidth()), int32_t(fusion.imageHeight())),
+                                 fusion.format(),
+                                 (uint32_t)(0) /* no mips*/,
+                                 IF_DEFAULT,
+                                 false);
+        Ctr::PixelBox destinationPixelBox = destinationImage->getPixelBox(0,0);
+        fusion.run(destinationPixelBox);
 
-        PixelFormat format;
-        switch (componentCount())
-        {
-            case 1:
-                format = PF_FLOAT32_R;
-                break;
-            case 2:
-                format = PF_FLOAT32_GR;
-                break;
-            case 3:
-                format = PF_FLOAT32_RGB;
-                break;
-            case 4:
-                format = PF_FLOAT32_RGBA;
-                break;
-            default:
-                IBLASSERT(0, "Unknown channel count");
-        }
+        _imageResultProperty->set(destinationImage);
+    }
 
-        // Create the result image.
-        Ctr::TextureImagePtr destinationImage(new Ctr::TextureImage());
-        destinationImage->create(Ctr::Vector2i(int32_t(_imageWidth), int32_t(_imageHeight)),
-                             format,
-                             (uint32_t)(0) /* no mips*/,
-                             IF_DEFAULT);
-        Ctr::PixelBox destinationPixelBox = destinationImage->getPixelBox(0,0);
+    virtual bool               fusable() const
+    {
+        return true;
+    }
 
-        concurrency::parallel_for(size_t(0), size_t(_imageHeight), [&](size_t rowId)
-        {
-            (*this)(rowId, _imageWidth, _imageHeight, sources, destinationPixelBox);
-        });
+    virtual void               prepareStage(const std::vector<Ctr::PixelBox>& sources,
+                                            size_t& width,
+                                            size_t& height,
+                                            size_t& components) const
+    {
+        cacheProcessingOptions(sources);
+        width = imageWidth();
+        height = imageHeight();
+        components = componentCount();
+    }
 
-        _imageResultProperty->set(destinationImage);
+    virtual void               processSpan(size_t width,
+                                           const std::vector<Ctr::PixelBox>& sources,
+                                           Ctr::PixelBox& destination) const
+    {
+        // Spans are rebased so that they always start at row 0.
+        (*this)(0, width, 1, sources, destination);
     }
 
   protected:
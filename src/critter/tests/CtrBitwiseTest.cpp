@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrBitwise.h>
+
+namespace
+{
+#if CTR_SSE
+void
+testHalfToFloat4()
+{
+    // Every half, including denormals, infinities and NaNs.
+    uint32_t mismatches = 0;
+    for (uint32_t first = 0; first < 0x10000; first += 4)
+    {
+        uint16_t halves[4] = { uint16_t(first), uint16_t(first + 1), uint16_t(first + 2), uint16_t(first + 3) };
+        uint32_t floats[4];
+        _mm_storeu_ps((float*)floats, Ctr::Bitwise::halfToFloat4(_mm_loadl_epi64((const __m128i*)halves)));
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            if (floats[lane] != Ctr::Bitwise::halfToFloatI(halves[lane]))
+                mismatches++;
+        }
+    }
+    CTR_TEST_CHECK(mismatches == 0);
+}
+
+void
+testFloatToHalf4()
+{
+    // Every float bit pattern with a stride, offset per lane so all low bits are hit.
+    uint32_t mismatches = 0;
+    for (uint64_t first = 0; first < 0x100000000ull; first += 4 * 509)
+    {
+        uint32_t floats[4];
+        for (uint32_t lane = 0; lane < 4; lane++)
+            floats[lane] = uint32_t(first + lane * 127);
+
+        uint16_t halves[4];
+        _mm_storel_epi64((__m128i*)halves, Ctr::Bitwise::floatToHalf4(_mm_loadu_ps((const float*)floats)));
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            if (halves[lane] != Ctr::Bitwise::floatToHalfI(floats[lane]))
+                mismatches++;
+        }
+    }
+    CTR_TEST_CHECK(mismatches == 0);
+
+    // Boundaries of the denormal, overflow and NaN ranges.
+    const uint32_t edges[] = { 0x00000000, 0x80000000, 0x33000000, 0x32ffffff, 0x387fffff, 0x38800000,
+                               0x477fe000, 0x477fffff, 0x47800000, 0xc7800000, 0x7f800000, 0xff800000,
+                               0x7f800001, 0x7fc00000, 0xffffffff, 0x3f800000, 0xbf800000, 0x00000001 };
+    for (uint32_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i += 2)
+    {
+        uint32_t floats[4] = { edges[i], edges[i + 1], edges[i], edges[i + 1] };
+        uint16_t halves[4];
+        _mm_storel_epi64((__m128i*)halves, Ctr::Bitwise::floatToHalf4(_mm_loadu_ps((const float*)floats)));
+        CTR_TEST_CHECK(halves[0] == Ctr::Bitwise::floatToHalfI(edges[i]));
+        CTR_TEST_CHECK(halves[1] == Ctr::Bitwise::floatToHalfI(edges[i + 1]));
+    }
+}
+#endif
+}
+
+int
+main()
+{
+#if CTR_SSE
+    testHalfToFloat4();
+    testFloatToHalf4();
+#endif
+    return Ctr::Test::result("CtrBitwiseTest");
+}
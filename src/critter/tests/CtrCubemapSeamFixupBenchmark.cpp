@@ -0,0 +1,67 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrCubemapSeamFixup.h>
+
+// Times CubemapSeamFixup against fixupCubeEdges, results go to the log. Every
+// format must match the float fixup of the same input to within its precision.
+int
+main()
+{
+    const size_t faceSizes[] = { 128, 512, 1024 };
+    const Ctr::PixelFormat formats[] = { Ctr::PF_A8R8G8B8, Ctr::PF_FLOAT16_RGBA, Ctr::PF_FLOAT32_RGBA };
+    // Truncation costs under one 8 bit step, or one half ulp at the top of the
+    // [0, 4] noise range. Half a step more for slack.
+    const double tolerances[] = { 1.5 / 255.0, 1.5 / 256.0, 1e-4 };
+
+    for (size_t sizeId = 0; sizeId < sizeof(faceSizes) / sizeof(faceSizes[0]); sizeId++)
+    {
+        for (size_t formatId = 0; formatId < sizeof(formats) / sizeof(formats[0]); formatId++)
+        {
+            double difference = 0.0;
+            double speedup = Ctr::CubemapSeamFixup::benchmark(faceSizes[sizeId], formats[formatId], 4, &difference);
+            std::cout << "Cubemap seam fixup " << faceSizes[sizeId] << " format " << formats[formatId]
+                      << ": speedup " << speedup << ", max difference from float " << difference << "\n";
+            CTR_TEST_CHECK(difference <= tolerances[formatId]);
+        }
+    }
+    return Ctr::Test::result("CtrCubemapSeamFixupBenchmark");
+}
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrHDREncoder.h>
+#include <cmath>
+
+namespace
+{
+// Width is not a multiple of four, so the partial blocks are covered.
+const size_t TestWidth = 61;
+const size_t TestHeight = 29;
+
+// Deterministic on every standard library.
+float
+nextRandom(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return float(state >> 8) / float(1 << 24);
+}
+
+// Colors spanning 2^-8 to 2^8, with black and negative texels.
+std::vector<float>
+testColors()
+{
+    std::vector<float> colors(TestWidth * TestHeight * 4);
+    uint32_t state = 7;
+    for (size_t texelId = 0; texelId < TestWidth * TestHeight; texelId++)
+    {
+        float* color = &colors[texelId * 4];
+        float luminance = std::exp2(nextRandom(state) * 16.0f - 8.0f);
+        for (size_t channel = 0; channel < 3; channel++)
+            color[channel] = luminance * (0.05f + 0.95f * nextRandom(state));
+        color[3] = 1.0f;
+        if (texelId % 19 == 0)
+            color[0] = color[1] = color[2] = 0.0f;
+        if (texelId % 23 == 0)
+            color[1] = -1.0f;
+    }
+    return colors;
+}
+
+// Same measure as HDREncoder::measure: the largest channel difference
+// relative to the largest (non negative) source channel.
+double
+maxRelativeError(const std::vector<float>& original, const std::vector<float>& decoded)
+{
+    double maxRelative = 0.0;
+    for (size_t texelId = 0; texelId < original.size() / 4; texelId++)
+    {
+        float largest = 0.0f;
+        float difference = 0.0f;
+        for (size_t channel = 0; channel < 3; channel++)
+        {
+            float source = std::max(original[texelId * 4 + channel], 0.0f);
+            largest = std::max(largest, source);
+            difference = std::max(difference, std::fabs(decoded[texelId * 4 + channel] - source));
+        }
+        maxRelative = std::max(maxRelative, double(difference) / std::max(largest, 1e-4f));
+    }
+    return maxRelative;
+}
+
+void
+testRoundTrip(Ctr::HDREncoding encoding, double bound)
+{
+    std::vector<float> original = testColors();
+    std::vector<uint32_t> encoded(TestWidth * TestHeight);
+    std::vector<float> decoded(original.size());
+    Ctr::PixelBox originalBox(TestWidth, TestHeight, 1, Ctr::PF_FLOAT32_RGBA, &original[0]);
+    Ctr::PixelBox encodedBox(TestWidth, TestHeight, 1, Ctr::PF_BYTE_RGBA, &encoded[0]);
+    Ctr::PixelBox decodedBox(TestWidth, TestHeight, 1, Ctr::PF_FLOAT32_RGBA, &decoded[0]);
+
+    Ctr::HDREncoder encoder(encoding);
+    Ctr::HDREncodingRange range = encoder.fitRange(encoder.analyze(&originalBox, 1));
+    encoder.encode(originalBox, encodedBox, range);
+    encoder.decode(encodedBox, decodedBox, range);
+
+    double maxRelative = maxRelativeError(original, decoded);
+    Ctr::HDREncodingError error = encoder.measure(originalBox, encodedBox, range);
+    std::cout << Ctr::HDREncoder::encodingName(encoding) << ": max relative " << maxRelative 
+              << ", reported " << error.maxRelative << ", rms " << error.rmsRelative << "\n";
+
+    CTR_TEST_CHECK(error.texelCount == TestWidth * TestHeight);
+    CTR_TEST_CHECK(error.clippedFraction == 0.0);
+    CTR_TEST_CHECK(std::fabs(maxRelative - error.maxRelative) <= 1e-3 * error.maxRelative + 1e-6);
+    CTR_TEST_CHECK(error.rmsRelative <= error.maxRelative);
+    CTR_TEST_CHECK(maxRelative <= bound);
+
+    // Black stays black.
+    CTR_TEST_CHECK(decoded[0] == 0.0f && decoded[1] == 0.0f && decoded[2] == 0.0f);
+}
+
+void
+testRGBDRangeDoesNotClip()
+{
+    // One brightness only, on a histogram bin center once gamma corrected,
+    // so the fit pushes it to the top of the divisor range.
+    std::vector<float> original(TestWidth * TestHeight * 4, std::exp2(0.125f * 2.2f));
+    std::vector<uint32_t> encoded(TestWidth * TestHeight);
+    Ctr::PixelBox originalBox(TestWidth, TestHeight, 1, Ctr::PF_FLOAT32_RGBA, &original[0]);
+    Ctr::PixelBox encodedBox(TestWidth, TestHeight, 1, Ctr::PF_BYTE_RGBA, &encoded[0]);
+
+    Ctr::HDREncoder encoder(Ctr::HDR_ENCODING_RGBD);
+    Ctr::HDREncodingRange range = encoder.fitRange(encoder.analyze(&originalBox, 1));
+    encoder.encode(originalBox, encodedBox, range);
+    Ctr::HDREncodingError error = encoder.measure(originalBox, encodedBox, range);
+    CTR_TEST_CHECK(error.clippedFraction == 0.0);
+    CTR_TEST_CHECK(error.maxRelative < 0.01);
+}
+}
+
+int
+main()
+{
+    // RGB9E5 is bound by half a step of a 9 bit mantissa, LogLuv by its
+    // 8 bit chroma. RGBM and RGBD lose precision below the fitted scale.
+    testRoundTrip(Ctr::HDR_ENCODING_RGBM, 0.02);
+    testRoundTrip(Ctr::HDR_ENCODING_RGBD, 0.02);
+    testRoundTrip(Ctr::HDR_ENCODING_LOGLUV, 0.04);
+    testRoundTrip(Ctr::HDR_ENCODING_RGB9E5, 1.0 / 512.0 + 1e-5);
+    testRGBDRangeDoesNotClip();
+    return Ctr::Test::result("CtrHDREncoderTest");
+}
@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrProbePackage.h>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+
+namespace
+{
+const char* TestPackage = "CtrProbePackageTest.cprb";
+
+// Noise does not deflate, so its levels are stored. Flat levels deflate.
+Ctr::TextureImagePtr
+testImage(size_t size, Ctr::PixelFormat format, uint32_t mipCount, bool noise)
+{
+    Ctr::TextureImagePtr image(new Ctr::TextureImage());
+    image->create(Ctr::Vector2i(int32_t(size), int32_t(size)), format, mipCount, Ctr::IF_CUBEMAP);
+
+    uint32_t state = 11;
+    image->forEachPixelBox([&](size_t face, size_t mipmap, const Ctr::PixelBox& box)
+    {
+        uint8_t* data = (uint8_t*)box.data;
+        size_t size = Ctr::PixelUtil::getMemorySize(box.size().x, box.size().y, 1, box.format);
+        for (size_t byteId = 0; byteId < size; byteId++)
+        {
+            state = state * 1664525u + 1013904223u;
+            data[byteId] = noise ? uint8_t(state >> 24) : uint8_t(face * 16 + mipmap);
+        }
+    });
+    return image;
+}
+
+std::vector<uint8_t>
+readFile(const char* pathName)
+{
+    std::vector<uint8_t> data;
+    std::ifstream stream(pathName, std::ios::in | std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return data;
+}
+
+bool
+openPatched(const std::vector<uint8_t>& data)
+{
+    {
+        std::ofstream stream(TestPackage, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream.write((const char*)&data[0], std::streamsize(data.size()));
+    }
+    Ctr::ProbePackage package;
+    return package.open(TestPackage);
+}
+
+bool
+sameLevels(const Ctr::ProbePackage& package, const Ctr::ProbePackageMap& map, const Ctr::TextureImage& image)
+{
+    if (map.width != image.getWidth() || map.faceCount != image.getNumFaces() || 
+        map.mipCount != image.getNumLevels() || map.format != uint32_t(image.getFormat()))
+        return false;
+
+    for (uint32_t mipmap = 0; mipmap < map.mipCount; mipmap++)
+    {
+        for (uint32_t face = 0; face < map.faceCount; face++)
+        {
+            Ctr::PixelBox box;
+            Ctr::PixelBox source = image.getPixelBox(face, mipmap);
+            size_t size = Ctr::PixelUtil::getMemorySize(source.size().x, source.size().y, 1, source.format);
+            if (!package.pixelBox(map, face, mipmap, box) || box.size() != source.size() ||
+                memcmp(box.data, source.data, size) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+void
+testRoundTrip()
+{
+    Ctr::TextureImagePtr specular = testImage(32, Ctr::PF_FLOAT16_RGBA, 6, true);
+    Ctr::TextureImagePtr diffuse = testImage(16, Ctr::PF_BYTE_RGBA, 5, false);
+
+    Ctr::ProbePackageMetadata metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.center[1] = 2.0f;
+    metadata.sampleCount = 512;
+    strcpy(metadata.brdfLut, "brdf.dds");
+
+    Ctr::ProbePackageWriter writer;
+    writer.setMetadata(metadata);
+    writer.addMap(Ctr::ProbeMapSpecular, Ctr::ProbeMapHDR, specular);
+    writer.addMap(Ctr::ProbeMapDiffuse, Ctr::ProbeMapHDR, diffuse);
+    CTR_TEST_CHECK(writer.write(TestPackage, true));
+
+    {
+        Ctr::ProbePackage package;
+        CTR_TEST_CHECK(package.open(TestPackage));
+        CTR_TEST_CHECK(package.mapCount() == 2);
+        CTR_TEST_CHECK(package.metadata().center[1] == 2.0f && package.metadata().sampleCount == 512);
+        CTR_TEST_CHECK(package.brdfLutPathName() == "brdf.dds");
+        CTR_TEST_CHECK(package.findMap(Ctr::ProbeMapEnvironment, Ctr::ProbeMapHDR) == nullptr);
+
+        const Ctr::ProbePackageMap* specularMap = package.findMap(Ctr::ProbeMapSpecular, Ctr::ProbeMapHDR);
+        const Ctr::ProbePackageMap* diffuseMap = package.findMap(Ctr::ProbeMapDiffuse, Ctr::ProbeMapHDR);
+        CTR_TEST_CHECK(specularMap && sameLevels(package, *specularMap, *specular));
+        CTR_TEST_CHECK(diffuseMap && sameLevels(package, *diffuseMap, *diffuse));
+    }
+
+    // Both storage modes were exercised.
+    std::vector<uint8_t> data = readFile(TestPackage);
+    Ctr::ProbePackageHeader header;
+    memcpy(&header, &data[0], sizeof(header));
+    uint32_t deflated = 0;
+    for (uint32_t mipId = 0; mipId < header.mipCount; mipId++)
+    {
+        Ctr::ProbePackageMip mip;
+        memcpy(&mip, &data[size_t(header.mipTableOffset) + mipId * sizeof(mip)], sizeof(mip));
+        deflated += mip.compression == Ctr::ProbeMipDeflated ? 1 : 0;
+    }
+    CTR_TEST_CHECK(header.mipCount == 11);
+    CTR_TEST_CHECK(deflated > 0 && deflated < header.mipCount);
+}
+
+void
+testCorruptTables()
+{
+    std::vector<uint8_t> original = readFile(TestPackage);
+    Ctr::ProbePackageHeader header;
+    memcpy(&header, &original[0], sizeof(header));
+    const uint64_t wrappingOffset = ~uint64_t(Ctr::ProbePackage::PackageAlignment - 1);
+
+    // offset + storedSize wraps back inside the file.
+    std::vector<uint8_t> data = original;
+    Ctr::ProbePackageMip mip;
+    memcpy(&mip, &data[size_t(header.mipTableOffset)], sizeof(mip));
+    mip.offset = wrappingOffset;
+    mip.storedSize = 2 * Ctr::ProbePackage::PackageAlignment;
+    memcpy(&data[size_t(header.mipTableOffset)], &mip, sizeof(mip));
+    CTR_TEST_CHECK(!openPatched(data));
+
+    // So does the end of the mip table.
+    data = original;
+    Ctr::ProbePackageHeader patched = header;
+    patched.mipTableOffset = wrappingOffset;
+    memcpy(&data[0], &patched, sizeof(patched));
+    CTR_TEST_CHECK(!openPatched(data));
+
+    // And a map table whose count is large enough to wrap.
+    data = original;
+    patched = header;
+    patched.mapCount = 0xffffffff;
+    memcpy(&data[0], &patched, sizeof(patched));
+    CTR_TEST_CHECK(!openPatched(data));
+
+    CTR_TEST_CHECK(openPatched(original));
+}
+}
+
+int
+main()
+{
+    testRoundTrip();
+    testCorruptTables();
+    remove(TestPackage);
+    return Ctr::Test::result("CtrProbePackageTest");
+}
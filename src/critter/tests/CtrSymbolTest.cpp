@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrSymbol.h>
+
+namespace
+{
+void
+testIntern()
+{
+    size_t count = Ctr::Symbol::count();
+    Ctr::SymbolId source = Ctr::Symbol::intern("ConvolutionSrc");
+    Ctr::SymbolId mip = Ctr::Symbol::intern("ConvolutionMip");
+
+    CTR_TEST_CHECK(source != Ctr::Symbol::Invalid);
+    CTR_TEST_CHECK(mip != Ctr::Symbol::Invalid);
+    CTR_TEST_CHECK(source != mip);
+    CTR_TEST_CHECK(Ctr::Symbol::intern("ConvolutionSrc") == source);
+    CTR_TEST_CHECK(Ctr::Symbol::count() == count + 2);
+    CTR_TEST_CHECK(Ctr::Symbol::name(source) == "ConvolutionSrc");
+    CTR_TEST_CHECK(Ctr::Symbol::name(Ctr::Symbol::Invalid).empty());
+}
+
+void
+testFind()
+{
+    Ctr::SymbolId roughness = Ctr::Symbol::intern("ConvolutionRoughness");
+    CTR_TEST_CHECK(Ctr::Symbol::find("ConvolutionRoughness") == roughness);
+    // Lookups never create symbols.
+    size_t count = Ctr::Symbol::count();
+    CTR_TEST_CHECK(Ctr::Symbol::find("NeverInterned") == Ctr::Symbol::Invalid);
+    CTR_TEST_CHECK(Ctr::Symbol::count() == count);
+}
+
+void
+testNoCase()
+{
+    Ctr::SymbolId semantic = Ctr::Symbol::internNoCase("WorldViewProjection");
+    CTR_TEST_CHECK(Ctr::Symbol::internNoCase("WORLDVIEWPROJECTION") == semantic);
+    CTR_TEST_CHECK(Ctr::Symbol::internNoCase("worldviewprojection") == semantic);
+    CTR_TEST_CHECK(Ctr::Symbol::intern("WorldViewProjection") != semantic);
+}
+
+void
+testSymbolMap()
+{
+    Ctr::SymbolId ids[] = { Ctr::Symbol::intern("LastResult"),
+                            Ctr::Symbol::intern("ConvolutionSampleCount"),
+                            Ctr::Symbol::intern("ConvolutionBlendWeight"),
+                            Ctr::Symbol::intern("basic") };
+    const uint32_t idCount = sizeof(ids) / sizeof(ids[0]);
+
+    Ctr::SymbolMap<int> map;
+    for (uint32_t i = 0; i < idCount; i++)
+        CTR_TEST_CHECK(map.insert(ids[i], int(i)));
+    CTR_TEST_CHECK(map.size() == idCount);
+
+    // Entries stay sorted for the binary search.
+    for (auto it = map.begin(); it + 1 < map.end(); it++)
+        CTR_TEST_CHECK(it->first < (it + 1)->first);
+
+    for (uint32_t i = 0; i < idCount; i++)
+    {
+        int value = -1;
+        CTR_TEST_CHECK(map.find(ids[i], value) && value == int(i));
+    }
+
+    // Replacing keeps one entry per id.
+    CTR_TEST_CHECK(!map.insert(ids[1], 42));
+    int value = -1;
+    CTR_TEST_CHECK(map.find(ids[1], value) && value == 42);
+    CTR_TEST_CHECK(map.size() == idCount);
+
+    CTR_TEST_CHECK(!map.find(Ctr::Symbol::intern("ConvolutionMaxSamples"), value));
+    CTR_TEST_CHECK(!map.find(Ctr::Symbol::Invalid, value));
+
+    map.clear();
+    CTR_TEST_CHECK(map.empty());
+    CTR_TEST_CHECK(!map.find(ids[0], value));
+}
+}
+
+int
+main()
+{
+    testIntern();
+    testFind();
+    testNoCase();
+    testSymbolMap();
+    return Ctr::Test::result("CtrSymbolTest");
+}
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+
+#ifndef INCLUDED_CRT_TEST
+#define INCLUDED_CRT_TEST
+
+#include <CtrPlatform.h>
+#include <algorithm>
+#include <chrono>
+
+//------------------------------------------------------------
+// Minimal headless test support. Each test is a console
+// executable registered with ctest; main returns
+// Ctr::Test::result(), non zero when any check failed.
+//------------------------------------------------------------
+#define CTR_TEST_CHECK(condition) \
+    Ctr::Test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace Ctr
+{
+namespace Test
+{
+inline uint32_t&
+failures()
+{
+    static uint32_t failureCount = 0;
+    return failureCount;
+}
+
+inline bool
+check(bool condition, const char* expression, const char* file, int line)
+{
+    if (!condition)
+    {
+        std::cerr << file << "(" << line << "): check failed: " << expression << "\n";
+        failures()++;
+    }
+    return condition;
+}
+
+inline int
+result(const char* testName)
+{
+    if (failures() > 0)
+    {
+        std::cerr << testName << ": " << failures() << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << testName << ": passed\n";
+    return 0;
+}
+
+// Best of repeatCount runs of function, in milliseconds.
+template <typename Function>
+double
+benchmark(const char* name, uint32_t repeatCount, const Function& function)
+{
+    double best = 1e30;
+    for (uint32_t repeatId = 0; repeatId < repeatCount; repeatId++)
+    {
+        auto begin = std::chrono::high_resolution_clock::now();
+        function();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+    std::cout << name << ": " << best << " ms\n";
+    return best;
+}
+}
+}
+
+#endif
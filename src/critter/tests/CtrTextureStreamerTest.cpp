@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrTextureStreamer.h>
+
+namespace
+{
+// Records every read and hands out empty levels coarsest first.
+// A read fails after failAfter levels, and removes the stream
+// being read after removeAfter levels.
+struct FakeReader
+{
+    struct Call
+    {
+        uint32_t                     finestMip;
+        uint32_t                     coarsestMip;
+    };
+
+    FakeReader() :
+        streamer(nullptr),
+        removeStream(nullptr),
+        removeAfter(UINT32_MAX),
+        failAfter(UINT32_MAX)
+    {
+    }
+
+    bool
+    operator()(const std::string&, uint32_t finestMip, uint32_t coarsestMip,
+               const Ctr::TextureStreamer::LevelSink& sink)
+    {
+        Call call = { finestMip, coarsestMip };
+        calls.push_back(call);
+
+        uint32_t levelCount = 0;
+        for (uint32_t mipId = coarsestMip + 1; mipId-- > finestMip; levelCount++)
+        {
+            if (levelCount == failAfter)
+                return false;
+            if (levelCount == removeAfter)
+                streamer->removeStream(removeStream);
+            if (!sink(mipId, Ctr::TextureImagePtr()))
+            {
+                rejected.push_back(mipId);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Ctr::TextureStreamer*            streamer;
+    const void*                      removeStream;
+    uint32_t                         removeAfter;
+    uint32_t                         failAfter;
+    std::vector<Call>                calls;
+    std::vector<uint32_t>            rejected;
+};
+
+Ctr::TextureStreamer::LevelReader
+bind(FakeReader& reader)
+{
+    return [&reader](const std::string& filePathName, uint32_t finestMip, uint32_t coarsestMip,
+                     const Ctr::TextureStreamer::LevelSink& sink)
+    {
+        return reader(filePathName, finestMip, coarsestMip, sink);
+    };
+}
+
+bool
+levelsAre(const std::vector<Ctr::TextureStreamer::Level>& levels, const void* stream,
+          uint32_t coarsestMip, uint32_t finestMip)
+{
+    if (levels.size() != coarsestMip - finestMip + 1)
+        return false;
+    for (size_t levelId = 0; levelId < levels.size(); levelId++)
+    {
+        if (levels[levelId].stream != stream || levels[levelId].mipId != coarsestMip - levelId)
+            return false;
+    }
+    return true;
+}
+
+void
+testTargetMip()
+{
+    CTR_TEST_CHECK(Ctr::TextureStreamer::targetMip(2048, 2048, 12, 256) == 3);
+    CTR_TEST_CHECK(Ctr::TextureStreamer::targetMip(2048, 512, 12, 300) == 2);
+    CTR_TEST_CHECK(Ctr::TextureStreamer::targetMip(2048, 2048, 12, 4096) == 0);
+    // Never past the last level.
+    CTR_TEST_CHECK(Ctr::TextureStreamer::targetMip(2048, 2048, 4, 1) == 3);
+}
+
+void
+testRetarget()
+{
+    FakeReader reader;
+    Ctr::TextureStreamer streamer(bind(reader), false);
+    int texture = 0;
+    int unrequested = 0;
+
+    streamer.addStream(&texture, "texture.dds", 2048, 2048, 12, 6);
+    CTR_TEST_CHECK(streamer.hasStream(&texture));
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 6);
+
+    streamer.requestSize(&texture, 200);
+    streamer.requestSize(&texture, 256);
+    streamer.update();
+    CTR_TEST_CHECK(streamer.targetMip(&texture) == 3);
+    CTR_TEST_CHECK(reader.calls.size() == 1);
+    CTR_TEST_CHECK(reader.calls[0].finestMip == 3 && reader.calls[0].coarsestMip == 5);
+    CTR_TEST_CHECK(streamer.pending());
+
+    // Resident follows collection, not the read.
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 6);
+    CTR_TEST_CHECK(levelsAre(streamer.completed(), &texture, 5, 3));
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 3);
+    CTR_TEST_CHECK(!streamer.pending());
+
+    // Without a new request the target is held.
+    streamer.update();
+    CTR_TEST_CHECK(streamer.targetMip(&texture) == 3);
+    CTR_TEST_CHECK(reader.calls.size() == 1);
+
+    // A smaller request keeps what is resident.
+    streamer.requestSize(&texture, 16);
+    streamer.update();
+    CTR_TEST_CHECK(streamer.targetMip(&texture) == 7);
+    CTR_TEST_CHECK(reader.calls.size() == 1);
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 3);
+
+    // A larger one reads only the missing finer levels.
+    streamer.requestSize(&texture, 2048);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 2);
+    CTR_TEST_CHECK(reader.calls[1].finestMip == 0 && reader.calls[1].coarsestMip == 2);
+    CTR_TEST_CHECK(levelsAre(streamer.completed(), &texture, 2, 0));
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 0);
+
+    // Streams that were never requested target their full resolution.
+    streamer.addStream(&unrequested, "unrequested.dds", 256, 256, 9, 4);
+    streamer.update();
+    CTR_TEST_CHECK(streamer.targetMip(&unrequested) == 0);
+    CTR_TEST_CHECK(reader.calls.size() == 3);
+    CTR_TEST_CHECK(levelsAre(streamer.completed(), &unrequested, 3, 0));
+    CTR_TEST_CHECK(!streamer.pending());
+}
+
+void
+testCancel()
+{
+    FakeReader reader;
+    Ctr::TextureStreamer streamer(bind(reader), false);
+    reader.streamer = &streamer;
+    int texture = 0;
+
+    // Levels read but not yet collected are dropped.
+    streamer.addStream(&texture, "texture.dds", 2048, 2048, 12, 6);
+    streamer.requestSize(&texture, 256);
+    streamer.update();
+    CTR_TEST_CHECK(streamer.pending());
+    streamer.removeStream(&texture);
+    CTR_TEST_CHECK(!streamer.hasStream(&texture));
+    CTR_TEST_CHECK(streamer.completed().empty());
+    CTR_TEST_CHECK(!streamer.pending());
+
+    // A read in flight stops at its next level.
+    streamer.addStream(&texture, "texture.dds", 2048, 2048, 12, 6);
+    reader.removeStream = &texture;
+    reader.removeAfter = 1;
+    streamer.requestSize(&texture, 256);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 2);
+    CTR_TEST_CHECK(reader.rejected.size() == 1 && reader.rejected[0] == 4);
+    CTR_TEST_CHECK(streamer.completed().empty());
+    CTR_TEST_CHECK(!streamer.pending());
+
+    // The same key added again is a new stream, not a failed one.
+    reader.removeAfter = UINT32_MAX;
+    streamer.addStream(&texture, "texture.dds", 2048, 2048, 12, 6);
+    streamer.requestSize(&texture, 256);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 3);
+    CTR_TEST_CHECK(levelsAre(streamer.completed(), &texture, 5, 3));
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 3);
+}
+
+void
+testFailure()
+{
+    FakeReader reader;
+    Ctr::TextureStreamer streamer(bind(reader), false);
+    int texture = 0;
+    int partial = 0;
+
+    // Nothing read, the resident levels are kept.
+    reader.failAfter = 0;
+    streamer.addStream(&texture, "missing.dds", 2048, 2048, 12, 6);
+    streamer.requestSize(&texture, 256);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 1);
+    CTR_TEST_CHECK(streamer.completed().empty());
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 6);
+    CTR_TEST_CHECK(!streamer.pending());
+
+    // And the read is not retried.
+    reader.failAfter = UINT32_MAX;
+    streamer.requestSize(&texture, 2048);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 1);
+    CTR_TEST_CHECK(streamer.residentMip(&texture) == 6);
+    CTR_TEST_CHECK(!streamer.pending());
+
+    // Levels read before a failure are still handed out.
+    reader.failAfter = 1;
+    streamer.addStream(&partial, "truncated.dds", 2048, 2048, 12, 6);
+    streamer.requestSize(&partial, 256);
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 2);
+    CTR_TEST_CHECK(levelsAre(streamer.completed(), &partial, 5, 5));
+    CTR_TEST_CHECK(streamer.residentMip(&partial) == 5);
+    CTR_TEST_CHECK(!streamer.pending());
+
+    streamer.update();
+    CTR_TEST_CHECK(reader.calls.size() == 2);
+}
+}
+
+int
+main()
+{
+    testTargetMip();
+    testRetarget();
+    testCancel();
+    testFailure();
+    return Ctr::Test::result("CtrTextureStreamerTest");
+}
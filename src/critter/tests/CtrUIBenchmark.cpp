@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrUIBatcher.h>
+#include <CtrUITessellator.h>
+
+namespace
+{
+const uint32_t WidgetCount = 256;
+const uint32_t FrameCount = 100;
+
+struct Vertex
+{
+    float                      x;
+    float                      y;
+    uint32_t                   abgr;
+};
+
+Ctr::UIFont
+benchmarkFont()
+{
+    Ctr::UIFont font;
+    for (uint32_t glyphId = 0; glyphId < Ctr::UIFont::GlyphCount; glyphId++)
+    {
+        Ctr::UIGlyph& glyph = font.glyphs[glyphId];
+        glyph.x0 = uint16_t((glyphId % 16) * 10);
+        glyph.y0 = uint16_t((glyphId / 16) * 12);
+        glyph.x1 = uint16_t(glyph.x0 + 7);
+        glyph.y1 = uint16_t(glyph.y0 + 11);
+        glyph.xoff = 0.5f;
+        glyph.yoff = -9.0f;
+        glyph.xadvance = 7.5f;
+    }
+    font.invTextureWidth = 1.0f / 512.0f;
+    font.invTextureHeight = 1.0f / 512.0f;
+    font.id = 1;
+    font.size = 14;
+    return font;
+}
+
+//------------------------------------------------------------
+// One hud frame: a rounded panel, a rect and a label per
+// widget, appended to the batcher the way imgui does. A fresh
+// tessellator per frame measures the uncached cost.
+//------------------------------------------------------------
+void
+drawFrame(Ctr::UITessellator& tessellator,
+          Ctr::UIBatcher& batcher,
+          const Ctr::UIFont& font,
+          const std::vector<std::string>& labels)
+{
+    Ctr::UIDrawState colorState(reinterpret_cast<Ctr::IVertexDeclaration*>(1), nullptr, nullptr);
+    Ctr::UIDrawState textState(reinterpret_cast<Ctr::IVertexDeclaration*>(2), nullptr,
+                               reinterpret_cast<const Ctr::ITexture*>(1));
+
+    batcher.clear();
+    for (uint32_t widgetId = 0; widgetId < WidgetCount; widgetId++)
+    {
+        const float y = float(widgetId % 32) * 20.0f + 0.5f;
+        const Ctr::UIShape& panel = tessellator.rectShape(200, 18, 4, 1);
+        const Ctr::UIShape& rect = tessellator.rectShape(float(widgetId % 8) * 16 + 16, 12, 0, 1);
+        const Ctr::UIShape* shapes[2] = { &panel, &rect };
+        for (uint32_t shapeId = 0; shapeId < 2; shapeId++)
+        {
+            const Ctr::UIShape& shape = *shapes[shapeId];
+            Vertex* vertex = (Vertex*)batcher.append(colorState, sizeof(Vertex), shape.vertexCount);
+            if (!vertex)
+                return;
+            for (uint32_t vertexId = 0; vertexId < shape.vertexCount; vertexId++, vertex++)
+            {
+                vertex->x = shape.xy[vertexId * 2 + 0];
+                vertex->y = shape.xy[vertexId * 2 + 1] + y;
+                vertex->abgr = 0xff808080;
+            }
+        }
+
+        const std::string& label = labels[widgetId];
+        Ctr::UITextRun& run = tessellator.textRun(font, label.c_str());
+        const Ctr::UITextRunLayout& layout = tessellator.textRunLayout(font, run, label.c_str(), 0.0f, 0.5f);
+        Vertex* vertex = (Vertex*)batcher.append(textState, sizeof(Vertex), run.vertexCount);
+        if (!vertex)
+            return;
+        for (auto it = layout.quads.begin(); it != layout.quads.end(); it++)
+        {
+            const float xs[6] = { it->x0, it->x1, it->x1, it->x0, it->x0, it->x1 };
+            const float ys[6] = { it->y0, it->y1, it->y0, it->y0, it->y1, it->y1 };
+            for (uint32_t corner = 0; corner < 6; corner++, vertex++)
+            {
+                vertex->x = xs[corner];
+                vertex->y = ys[corner] + y;
+                vertex->abgr = 0xffffffff;
+            }
+        }
+    }
+    tessellator.endFrame();
+}
+}
+
+// Times hud tessellation with and without the geometry caches.
+int
+main()
+{
+    const Ctr::UIFont font = benchmarkFont();
+    std::vector<std::string> labels;
+    for (uint32_t widgetId = 0; widgetId < WidgetCount; widgetId++)
+    {
+        std::ostringstream label;
+        label << "Widget " << widgetId << "\tvalue " << (widgetId * 37) % 1000;
+        labels.push_back(label.str());
+    }
+
+    Ctr::UIBatcher batcher(1 << 20);
+    double uncached = Ctr::Test::benchmark("UI frames, uncached", 5, [&]()
+    {
+        for (uint32_t frameId = 0; frameId < FrameCount; frameId++)
+        {
+            Ctr::UITessellator tessellator;
+            drawFrame(tessellator, batcher, font, labels);
+        }
+    });
+
+    Ctr::UITessellator tessellator;
+    double cached = Ctr::Test::benchmark("UI frames, cached", 5, [&]()
+    {
+        for (uint32_t frameId = 0; frameId < FrameCount; frameId++)
+            drawFrame(tessellator, batcher, font, labels);
+    });
+
+    std::cout << "UI tessellation: " << WidgetCount << " widgets, " << batcher.draws() << " draws in "
+              << batcher.batches().size() << " batches, cache speedup " << uncached / cached << "\n";
+    return 0;
+}
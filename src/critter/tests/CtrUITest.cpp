@@ -0,0 +1,313 @@
+//------------------------------------------------------------------------------------//
+//                                                                                    //
+//               _________        .__  __    __                                       //
+//               \_   ___ \_______|__|/  |__/  |_  ___________                        //
+//               /    \  \/\_  __ \  \   __\   __\/ __ \_  __ \                       //
+//               \     \____|  | \/  ||  |  |  | \  ___/|  | \/                       //
+//                \______  /|__|  |__||__|  |__|  \___  >__|                          //
+//                       \/                           \/                              //
+//                                                                                    //
+//    Critter is provided under the MIT License(MIT)                                  //
+//    Critter uses portions of other open source software.                            //
+//    Please review the LICENSE file for further details.                             //
+//                                                                                    //
+//    Copyright(c) 2015 Matt Davidson                                                 //
+//                                                                                    //
+//    Permission is hereby granted, free of charge, to any person obtaining a copy    //
+//    of this software and associated documentation files(the "Software"), to deal    //
+//    in the Software without restriction, including without limitation the rights    //
+//    to use, copy, modify, merge, publish, distribute, sublicense, and / or sell     //
+//    copies of the Software, and to permit persons to whom the Software is           //
+//    furnished to do so, subject to the following conditions :                       //
+//                                                                                    //
+//    1. Redistributions of source code must retain the above copyright notice,       //
+//    this list of conditions and the following disclaimer.                           //
+//    2. Redistributions in binary form must reproduce the above copyright notice,    //
+//    this list of conditions and the following disclaimer in the                     //
+//    documentation and / or other materials provided with the distribution.          //
+//    3. Neither the name of the copyright holder nor the names of its                //
+//    contributors may be used to endorse or promote products derived                 //
+//    from this software without specific prior written permission.                   //
+//                                                                                    //
+//    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR      //
+//    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,        //
+//    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE      //
+//    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER          //
+//    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,   //
+//    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN       //
+//    THE SOFTWARE.                                                                   //
+//                                                                                    //
+//------------------------------------------------------------------------------------//
+#include <CtrTest.h>
+#include <CtrUIBatcher.h>
+#include <CtrUITessellator.h>
+
+namespace
+{
+// Only compared, never dereferenced.
+Ctr::IVertexDeclaration*
+fakeDeclaration(uintptr_t id)
+{
+    return reinterpret_cast<Ctr::IVertexDeclaration*>(id);
+}
+
+const Ctr::ITexture*
+fakeTexture(uintptr_t id)
+{
+    return reinterpret_cast<const Ctr::ITexture*>(id);
+}
+
+// Appends vertexCount vertices of one uint32_t holding marker.
+bool
+appendMarked(Ctr::UIBatcher& batcher, const Ctr::UIDrawState& state, uint32_t vertexCount, uint32_t marker)
+{
+    uint32_t* vertices = (uint32_t*)batcher.append(state, sizeof(uint32_t), vertexCount);
+    if (!vertices)
+        return false;
+    for (uint32_t vertexId = 0; vertexId < vertexCount; vertexId++)
+        vertices[vertexId] = marker;
+    return true;
+}
+
+void
+testBatcherMerge()
+{
+    Ctr::UIBatcher batcher(1024);
+    Ctr::UIDrawState state(fakeDeclaration(1), nullptr, fakeTexture(1));
+
+    CTR_TEST_CHECK(batcher.empty());
+    CTR_TEST_CHECK(appendMarked(batcher, state, 6, 1));
+    CTR_TEST_CHECK(appendMarked(batcher, state, 3, 2));
+    CTR_TEST_CHECK(appendMarked(batcher, state, 9, 3));
+
+    // Equal consecutive state shares one batch.
+    CTR_TEST_CHECK(batcher.draws() == 3);
+    CTR_TEST_CHECK(batcher.batches().size() == 1);
+    CTR_TEST_CHECK(batcher.batches()[0].firstVertex == 0);
+    CTR_TEST_CHECK(batcher.batches()[0].vertexCount == 18);
+
+    // A scissor change splits the batch.
+    Ctr::UIDrawState scissored = state;
+    scissored.setScissor(true, 0, 0, 16, 16);
+    CTR_TEST_CHECK(appendMarked(batcher, scissored, 6, 4));
+    CTR_TEST_CHECK(batcher.batches().size() == 2);
+    CTR_TEST_CHECK(batcher.batches()[1].firstVertex == 18);
+    CTR_TEST_CHECK(batcher.streams().size() == 1);
+}
+
+void
+testBatcherOrder()
+{
+    Ctr::UIBatcher batcher(1024);
+    Ctr::UIDrawState colorState(fakeDeclaration(1), nullptr, nullptr);
+    Ctr::UIDrawState textState(fakeDeclaration(2), nullptr, fakeTexture(1));
+
+    // A, B, A must not merge the two A draws across B.
+    CTR_TEST_CHECK(appendMarked(batcher, colorState, 6, 1));
+    CTR_TEST_CHECK(appendMarked(batcher, textState, 12, 2));
+    CTR_TEST_CHECK(appendMarked(batcher, colorState, 3, 3));
+
+    const std::vector<Ctr::UIBatch>& batches = batcher.batches();
+    const std::vector<Ctr::UIVertexStream>& streams = batcher.streams();
+    CTR_TEST_CHECK(batches.size() == 3);
+    CTR_TEST_CHECK(streams.size() == 2);
+    if (batches.size() != 3 || streams.size() != 2)
+        return;
+
+    CTR_TEST_CHECK(batches[0].state == colorState);
+    CTR_TEST_CHECK(batches[1].state == textState);
+    CTR_TEST_CHECK(batches[2].state == colorState);
+
+    // Each batch is a contiguous range of its stream holding its own vertices.
+    const uint32_t markers[3] = { 1, 2, 3 };
+    for (size_t batchId = 0; batchId < batches.size(); batchId++)
+    {
+        const Ctr::UIBatch& batch = batches[batchId];
+        const Ctr::UIVertexStream& stream = streams[batch.stream];
+        CTR_TEST_CHECK(stream.declaration == batch.state.declaration);
+        CTR_TEST_CHECK(batch.firstVertex + batch.vertexCount <= stream.vertexCount);
+
+        const uint32_t* vertices = (const uint32_t*)&stream.data[0];
+        for (uint32_t vertexId = 0; vertexId < batch.vertexCount; vertexId++)
+            CTR_TEST_CHECK(vertices[batch.firstVertex + vertexId] == markers[batchId]);
+    }
+    CTR_TEST_CHECK(batches[2].firstVertex == 6);
+
+    // Full streams refuse the append, clear keeps the streams.
+    CTR_TEST_CHECK(!appendMarked(batcher, textState, 1024, 4));
+    batcher.clear();
+    CTR_TEST_CHECK(batcher.empty());
+    CTR_TEST_CHECK(batcher.draws() == 0);
+    CTR_TEST_CHECK(batcher.streams().size() == 2);
+    CTR_TEST_CHECK(batcher.streams()[0].vertexCount == 0);
+    CTR_TEST_CHECK(appendMarked(batcher, textState, 1024, 4));
+}
+
+void
+testGeometryCache()
+{
+    Ctr::UIGeometryCache<int> cache(8);
+    const Ctr::Hash used(1, 0);
+    const Ctr::Hash stale(2, 0);
+
+    CTR_TEST_CHECK(cache.find(used) == nullptr);
+    cache.insert(used) = 1;
+    cache.insert(stale) = 2;
+    CTR_TEST_CHECK(cache.size() == 2);
+
+    int* found = cache.find(used);
+    CTR_TEST_CHECK(found && *found == 1);
+    CTR_TEST_CHECK(cache.hits() == 1);
+    CTR_TEST_CHECK(cache.misses() == 1);
+
+    // Entries untouched for longer than maxAge go at the next sweep.
+    for (uint32_t frameId = 0; frameId < 64; frameId++)
+    {
+        cache.find(used);
+        cache.endFrame();
+    }
+    CTR_TEST_CHECK(cache.size() == 1);
+    CTR_TEST_CHECK(cache.find(stale) == nullptr);
+    CTR_TEST_CHECK(cache.find(used) != nullptr);
+}
+
+void
+testPolygon()
+{
+    Ctr::UITessellator tessellator;
+    const float square[4 * 2] = { 0, 0, 10, 0, 10, 10, 0, 10 };
+    std::vector<float> xy(Ctr::UITessellator::polygonVertexCount(4) * 2);
+
+    const uint32_t vertexCount = tessellator.tessellatePolygon(square, 4, 1.0f, &xy[0]);
+    CTR_TEST_CHECK(vertexCount == 4 * 6 + 2 * 3);
+    CTR_TEST_CHECK(vertexCount * 2 == xy.size());
+
+    // Outline runs start on the polygon, the fringe lies outside it.
+    for (uint32_t coordId = 0; coordId < 4; coordId++)
+    {
+        const float* run = &xy[coordId * 6 * 2];
+        CTR_TEST_CHECK(run[0] == square[coordId * 2 + 0] && run[1] == square[coordId * 2 + 1]);
+        for (uint32_t corner = 2; corner <= 4; corner++)
+        {
+            const float x = run[corner * 2 + 0];
+            const float y = run[corner * 2 + 1];
+            CTR_TEST_CHECK(x < 0 || x > 10 || y < 0 || y > 10);
+        }
+    }
+
+    // The fan covers the polygon from its first vertex.
+    const float* fan = &xy[4 * 6 * 2];
+    CTR_TEST_CHECK(fan[0] == 0 && fan[1] == 0);
+    CTR_TEST_CHECK(fan[6] == 0 && fan[7] == 0);
+}
+
+void
+testShapeCache()
+{
+    Ctr::UITessellator tessellator(8);
+
+    const Ctr::UIShape& rect = tessellator.rectShape(32, 16, 0, 1);
+    CTR_TEST_CHECK(rect.coordCount == 4);
+    CTR_TEST_CHECK(rect.vertexCount == Ctr::UITessellator::polygonVertexCount(4));
+    CTR_TEST_CHECK(tessellator.shapes().misses() == 1);
+
+    // Same key, same tessellation.
+    CTR_TEST_CHECK(&tessellator.rectShape(32, 16, 0, 1) == &rect);
+    CTR_TEST_CHECK(tessellator.shapes().hits() == 1);
+
+    const Ctr::UIShape& rounded = tessellator.rectShape(32, 16, 4, 1);
+    CTR_TEST_CHECK(&rounded != &rect);
+    CTR_TEST_CHECK(rounded.coordCount == (Ctr::UITessellator::CircleVertexCount / 4 + 1) * 4);
+    CTR_TEST_CHECK(rounded.xy.size() == rounded.vertexCount * 2);
+    CTR_TEST_CHECK(tessellator.shapes().size() == 2);
+
+    // Only the shape drawn every frame survives ageing.
+    for (uint32_t frameId = 0; frameId < 64; frameId++)
+    {
+        tessellator.rectShape(32, 16, 0, 1);
+        tessellator.endFrame();
+    }
+    CTR_TEST_CHECK(tessellator.shapes().size() == 1);
+}
+
+// Glyphs 6 pixels wide on an 8 pixel advance, laid out in a row.
+Ctr::UIFont
+testFont()
+{
+    Ctr::UIFont font;
+    for (uint32_t glyphId = 0; glyphId < Ctr::UIFont::GlyphCount; glyphId++)
+    {
+        Ctr::UIGlyph& glyph = font.glyphs[glyphId];
+        glyph.x0 = uint16_t(glyphId * 8);
+        glyph.y0 = 0;
+        glyph.x1 = uint16_t(glyphId * 8 + 6);
+        glyph.y1 = 10;
+        glyph.xoff = 0;
+        glyph.yoff = -8;
+        glyph.xadvance = 8;
+    }
+    font.invTextureWidth = 1.0f / 1024.0f;
+    font.invTextureHeight = 1.0f / 16.0f;
+    font.id = 1;
+    font.size = 10;
+    return font;
+}
+
+void
+testTextRuns()
+{
+    Ctr::UITessellator tessellator(8);
+    const Ctr::UIFont font = testFont();
+
+    uint32_t vertexCount = 0;
+    const float width = Ctr::UITessellator::textWidth(font, "abc", vertexCount);
+    CTR_TEST_CHECK(vertexCount == 18);
+    CTR_TEST_CHECK(width == 16 + 6 + 0.5f);
+
+    Ctr::UITextRun& run = tessellator.textRun(font, "abc");
+    CTR_TEST_CHECK(run.width == width);
+    CTR_TEST_CHECK(run.vertexCount == vertexCount);
+    CTR_TEST_CHECK(&tessellator.textRun(font, "abc") == &run);
+    CTR_TEST_CHECK(tessellator.textRuns().hits() == 1);
+
+    // Another font is another run.
+    Ctr::UIFont larger = font;
+    larger.size = 20;
+    CTR_TEST_CHECK(&tessellator.textRun(larger, "abc") != &run);
+
+    // One layout per sub pixel origin, quads snapped to whole pixels.
+    const Ctr::UITextRunLayout& layout = tessellator.textRunLayout(font, run, "abc", 0.25f, 0.5f);
+    CTR_TEST_CHECK(layout.quads.size() == 3);
+    CTR_TEST_CHECK(&tessellator.textRunLayout(font, run, "abc", 0.25f, 0.5f) == &layout);
+    CTR_TEST_CHECK(run.layouts.size() == 1);
+    if (layout.quads.size() == 3)
+    {
+        CTR_TEST_CHECK(layout.quads[0].x0 == 0 && layout.quads[0].y0 == -8);
+        CTR_TEST_CHECK(layout.quads[1].x0 == 8 && layout.quads[1].x1 == 14);
+        CTR_TEST_CHECK(layout.quads[2].s0 == float('c' - ' ') * 8 / 1024.0f);
+    }
+
+    tessellator.textRunLayout(font, run, "abc", 0.75f, 0.5f);
+    CTR_TEST_CHECK(run.layouts.size() == 2);
+
+    // Tabs advance to the next stop.
+    CTR_TEST_CHECK(Ctr::UITessellator::textWidth(font, "\ta", vertexCount) == 150 + 6 + 0.5f);
+    CTR_TEST_CHECK(vertexCount == 6);
+
+    for (uint32_t frameId = 0; frameId < 64; frameId++)
+        tessellator.endFrame();
+    CTR_TEST_CHECK(tessellator.textRuns().size() == 0);
+}
+}
+
+int
+main()
+{
+    testBatcherMerge();
+    testBatcherOrder();
+    testGeometryCache();
+    testPolygon();
+    testShapeCache();
+    testTextRuns();
+    return Ctr::Test::result("CtrUITest");
+}